@@ -0,0 +1,104 @@
+# Copyright (c) 2023, PostgreSQL Global Development Group
+
+# Verify btree indexes with prefix compressed leaf pages, as built, after
+# page splits and page deletions, and as replayed on a standby
+use strict;
+use warnings;
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $primary = PostgreSQL::Test::Cluster->new('primary');
+$primary->init(allows_streaming => 1);
+$primary->append_conf('postgresql.conf', 'autovacuum = off');
+$primary->start;
+$primary->backup('my_backup');
+
+my $standby = PostgreSQL::Test::Cluster->new('standby');
+$standby->init_from_backup($primary, 'my_backup', has_streaming => 1);
+$standby->start;
+
+# Keys share long prefixes within runs of a few hundred values, so that
+# most leaf pages get a key prefix.  prefix_build is built by sorting,
+# prefix_insert only by inserts, and prefix_multi has a second key column.
+$primary->safe_psql(
+	'postgres', q{
+CREATE EXTENSION amcheck;
+CREATE TABLE prefix_test (t text COLLATE "C", b bytea, i int);
+INSERT INTO prefix_test
+  SELECT 'customer/' || repeat(chr(97 + g / 500 % 26), 40) || '/' ||
+		 lpad(g::text, 8, '0'),
+		 convert_to('object/' || lpad((g / 300)::text, 30, '0') || '/' || g, 'UTF8'),
+		 g % 7
+  FROM generate_series(1, 20000) g;
+CREATE INDEX prefix_build ON prefix_test (t) WITH (prefix_compression = on);
+CREATE TABLE prefix_test2 (b bytea);
+CREATE INDEX prefix_insert ON prefix_test2 (b) WITH (prefix_compression = on);
+INSERT INTO prefix_test2 SELECT b FROM prefix_test ORDER BY random();
+CREATE INDEX prefix_multi ON prefix_test (t text_pattern_ops, i)
+  WITH (prefix_compression = on, deduplicate_items = on);
+});
+
+# Inserts into the built index, duplicates, and deletions emptying whole
+# leaf pages, followed by VACUUM to delete them
+$primary->safe_psql(
+	'postgres', q{
+INSERT INTO prefix_test
+  SELECT 'customer/' || repeat(chr(97 + g / 500 % 26), 40) || '/' ||
+		 lpad(g::text, 8, '0') || 'x',
+		 convert_to('object/' || g, 'UTF8'), g % 3
+  FROM generate_series(1, 20000, 3) g;
+INSERT INTO prefix_test SELECT * FROM prefix_test WHERE i = 0;
+DELETE FROM prefix_test WHERE t LIKE 'customer/ccc%' OR t LIKE 'customer/q%';
+DELETE FROM prefix_test2 WHERE b < convert_to('object/' || lpad('30', 30, '0'), 'UTF8');
+VACUUM prefix_test, prefix_test2;
+});
+
+my $check = q{
+SELECT bt_index_parent_check('prefix_build', true, true),
+	   bt_index_parent_check('prefix_insert', true, true),
+	   bt_index_parent_check('prefix_multi', true, true);
+};
+my $count = q{
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SELECT count(*) FROM prefix_test WHERE t >= 'customer/b' AND t < 'customer/t';
+SELECT count(*) FROM prefix_test2 WHERE b >= convert_to('object/' || lpad('40', 30, '0'), 'UTF8');
+SELECT count(*) FROM prefix_test WHERE t LIKE 'customer/fff%' AND i = 2;
+};
+my $seqcount = q{
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+SET enable_indexonlyscan = off;
+SELECT count(*) FROM prefix_test WHERE t >= 'customer/b' AND t < 'customer/t';
+SELECT count(*) FROM prefix_test2 WHERE b >= convert_to('object/' || lpad('40', 30, '0'), 'UTF8');
+SELECT count(*) FROM prefix_test WHERE t LIKE 'customer/fff%' AND i = 2;
+};
+
+is($primary->safe_psql('postgres', $check),
+	'||', 'bt_index_parent_check passes on primary');
+my $expected = $primary->safe_psql('postgres', $seqcount);
+is($primary->safe_psql('postgres', $count),
+	$expected, 'index scans agree with heap on primary');
+
+$primary->wait_for_catchup($standby);
+is($standby->safe_psql('postgres', q{
+SELECT bt_index_check('prefix_build', true),
+	   bt_index_check('prefix_insert', true),
+	   bt_index_check('prefix_multi', true);
+}), '||', 'bt_index_check passes on standby');
+is($standby->safe_psql('postgres', $count),
+	$expected, 'index scans agree with heap on standby');
+
+# An index whose first column doesn't sort byte-wise never gets a prefix
+$primary->safe_psql(
+	'postgres', q{
+CREATE TABLE prefix_int (a int);
+INSERT INTO prefix_int SELECT generate_series(1, 10000);
+CREATE INDEX prefix_int_idx ON prefix_int (a) WITH (prefix_compression = on);
+});
+is($primary->safe_psql('postgres',
+	"SELECT bt_index_parent_check('prefix_int_idx', true, true)"),
+	'', 'ineligible index is unaffected');
+
+done_testing();
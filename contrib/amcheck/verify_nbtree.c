@@ -155,6 +155,7 @@ static void bt_recheck_sibling_links(BtreeCheckState *state,
 									 BlockNumber btpo_prev_from_target,
 									 BlockNumber leftcurrent);
 static void bt_target_page_check(BtreeCheckState *state);
+static void bt_prefix_bounds_check(BtreeCheckState *state);
 static BTScanInsert bt_right_page_check_scankey(BtreeCheckState *state);
 static void bt_child_check(BtreeCheckState *state, BTScanInsert targetkey,
 						   OffsetNumber downlinkoffnum);
@@ -171,6 +172,10 @@ static IndexTuple bt_normalize_tuple(BtreeCheckState *state,
 									 IndexTuple itup);
 static inline IndexTuple bt_posting_plain_tuple(IndexTuple itup, int n);
 static bool bt_rootdescend(BtreeCheckState *state, IndexTuple itup);
+static IndexTuple bt_prefix_expand_careful(BtreeCheckState *state,
+										   BlockNumber block, Page page,
+										   OffsetNumber offset,
+										   IndexTuple itup);
 static inline bool offset_is_negative_infinity(BTPageOpaque opaque,
 											   OffsetNumber offset);
 static inline bool invariant_l_offset(BtreeCheckState *state, BTScanInsert key,
@@ -1196,6 +1201,10 @@ bt_target_page_check(BtreeCheckState *state)
 		}
 	}
 
+	/* Check the key prefix against the page's bounds, if there is one */
+	if (P_HAS_PREFIX(topaque))
+		bt_prefix_bounds_check(state);
+
 	/*
 	 * Loop over page items, starting from first non-highkey item, not high
 	 * key (if any).  Most tests are not performed for the "negative infinity"
@@ -1207,6 +1216,7 @@ bt_target_page_check(BtreeCheckState *state)
 	{
 		ItemId		itemid;
 		IndexTuple	itup;
+		IndexTuple	wholeitup;
 		size_t		tupsize;
 		BTScanInsert skey;
 		bool		lowersizelimit;
@@ -1283,6 +1293,15 @@ bt_target_page_check(BtreeCheckState *state)
 			continue;
 		}
 
+		/*
+		 * Tuples on a leaf page with a key prefix are stored with the prefix
+		 * stripped.  Checks that work with the key itself need it whole.
+		 */
+		wholeitup = itup;
+		if (P_ISLEAF(topaque))
+			wholeitup = bt_prefix_expand_careful(state, state->targetblock,
+												 state->target, offset, itup);
+
 		/*
 		 * Readonly callers may optionally verify that non-pivot tuples can
 		 * each be found by an independent search that starts from the root.
@@ -1290,7 +1309,7 @@ bt_target_page_check(BtreeCheckState *state)
 		 * TID, since the posting list itself is validated by other checks.
 		 */
 		if (state->rootdescend && P_ISLEAF(topaque) &&
-			!bt_rootdescend(state, itup))
+			!bt_rootdescend(state, wholeitup))
 		{
 			ItemPointer tid = BTreeTupleGetPointsToTID(itup);
 			char	   *itid,
@@ -1343,7 +1362,7 @@ bt_target_page_check(BtreeCheckState *state)
 		}
 
 		/* Build insertion scankey for current page offset */
-		skey = bt_mkscankey_pivotsearch(state->rel, itup);
+		skey = bt_mkscankey_pivotsearch(state->rel, wholeitup);
 
 		/*
 		 * Make sure tuple size does not exceed the relevant BTREE_VERSION
@@ -1406,7 +1425,7 @@ bt_target_page_check(BtreeCheckState *state)
 				{
 					IndexTuple	logtuple;
 
-					logtuple = bt_posting_plain_tuple(itup, i);
+					logtuple = bt_posting_plain_tuple(wholeitup, i);
 					norm = bt_normalize_tuple(state, logtuple);
 					bloom_add_element(state->filter, (unsigned char *) norm,
 									  IndexTupleSize(norm));
@@ -1418,11 +1437,11 @@ bt_target_page_check(BtreeCheckState *state)
 			}
 			else
 			{
-				norm = bt_normalize_tuple(state, itup);
+				norm = bt_normalize_tuple(state, wholeitup);
 				bloom_add_element(state->filter, (unsigned char *) norm,
 								  IndexTupleSize(norm));
 				/* Be tidy */
-				if (norm != itup)
+				if (norm != wholeitup)
 					pfree(norm);
 			}
 		}
@@ -1638,6 +1657,73 @@ bt_target_page_check(BtreeCheckState *state)
 	}
 }
 
+
+/*
+ * Check that the high key of the target, a leaf page with a key prefix,
+ * begins with the prefix.
+ *
+ * Every key on the page must begin with the prefix, and so must the keys
+ * that bound the page's key space: its high key, and the high key of its
+ * left sibling.  The left sibling's high key is only checked by readonly
+ * callers, since the left sibling could otherwise be split concurrently.
+ */
+static void
+bt_prefix_bounds_check(BtreeCheckState *state)
+{
+	BTPageOpaque topaque = BTPageGetOpaque(state->target);
+	BTPagePrefix prefix = BTPageGetPrefix(state->target);
+	BlockNumber leftcurrent = topaque->btpo_prev;
+	Page		leftpage;
+	BTPageOpaque lopaque;
+	ItemId		itemid;
+	IndexTuple	bound;
+
+	/* palloc_btree_page() made sure that the page has a high key */
+	itemid = PageGetItemIdCareful(state, state->targetblock, state->target,
+								  P_HIKEY);
+	bound = (IndexTuple) PageGetItem(state->target, itemid);
+	if (_bt_prefix_match(state->rel, bound, prefix->bpp_data,
+						 prefix->bpp_len) != prefix->bpp_len)
+		ereport(ERROR,
+				(errcode(ERRCODE_INDEX_CORRUPTED),
+				 errmsg("high key does not begin with the key prefix of its page in index \"%s\"",
+						RelationGetRelationName(state->rel)),
+				 errdetail_internal("Index block=%u page lsn=%X/%X.",
+									state->targetblock,
+									LSN_FORMAT_ARGS(state->targetlsn))));
+
+	if (!state->readonly)
+		return;
+
+	/*
+	 * Sibling links that don't agree are reported elsewhere, so just skip
+	 * the check then
+	 */
+	leftpage = palloc_btree_page(state, leftcurrent);
+	lopaque = BTPageGetOpaque(leftpage);
+	if (P_ISDELETED(lopaque) || P_RIGHTMOST(lopaque) ||
+		lopaque->btpo_next != state->targetblock)
+	{
+		pfree(leftpage);
+		return;
+	}
+
+	itemid = PageGetItemIdCareful(state, leftcurrent, leftpage, P_HIKEY);
+	bound = (IndexTuple) PageGetItem(leftpage, itemid);
+	if (_bt_prefix_match(state->rel, bound, prefix->bpp_data,
+						 prefix->bpp_len) != prefix->bpp_len)
+		ereport(ERROR,
+				(errcode(ERRCODE_INDEX_CORRUPTED),
+				 errmsg("left sibling's high key does not begin with the key prefix of block %u in index \"%s\"",
+						state->targetblock,
+						RelationGetRelationName(state->rel)),
+				 errdetail_internal("Left sibling block=%u page lsn=%X/%X.",
+									leftcurrent,
+									LSN_FORMAT_ARGS(state->targetlsn))));
+
+	pfree(leftpage);
+}
+
 /*
  * Return a scankey for an item on page to right of current target (or the
  * first non-ignorable page), sufficient to check ordering invariant on last
@@ -1853,6 +1939,10 @@ bt_right_page_check_scankey(BtreeCheckState *state)
 	 * memory remaining allocated.
 	 */
 	firstitup = (IndexTuple) PageGetItem(rightpage, rightitem);
+	if (P_ISLEAF(opaque))
+		firstitup = bt_prefix_expand_careful(state, targetnext, rightpage,
+											 P_FIRSTDATAKEY(opaque),
+											 firstitup);
 	return bt_mkscankey_pivotsearch(state->rel, firstitup);
 }
 
@@ -2813,6 +2903,48 @@ bt_rootdescend(BtreeCheckState *state, IndexTuple itup)
 	return exists;
 }
 
+
+/*
+ * Return non-pivot tuple itup, from offset on leaf page "page", with its
+ * first attribute whole.
+ *
+ * On a page with a key prefix, the tuple's key is the prefix followed by
+ * what's stored, unless its first attribute is compressed, in which case it
+ * is stored whole and must begin with the prefix.  Either way, a tuple that
+ * doesn't fit the page's key prefix is reported as corruption.
+ */
+static IndexTuple
+bt_prefix_expand_careful(BtreeCheckState *state, BlockNumber block, Page page,
+						 OffsetNumber offset, IndexTuple itup)
+{
+	BTPagePrefix prefix;
+	IndexTuple	whole;
+	bool		isnull;
+
+	if (!P_HAS_PREFIX(BTPageGetOpaque(page)))
+		return itup;
+
+	prefix = BTPageGetPrefix(page);
+	(void) index_getattr(itup, 1, RelationGetDescr(state->rel), &isnull);
+	if (isnull)
+		ereport(ERROR,
+				(errcode(ERRCODE_INDEX_CORRUPTED),
+				 errmsg("index tuple with NULL key is on a page with a key prefix in index \"%s\"",
+						RelationGetRelationName(state->rel)),
+				 errdetail_internal("Index tid=(%u,%u).", block, offset)));
+
+	whole = _bt_prefix_expand(state->rel, page, itup);
+	if (_bt_prefix_match(state->rel, whole, prefix->bpp_data,
+						 prefix->bpp_len) != prefix->bpp_len)
+		ereport(ERROR,
+				(errcode(ERRCODE_INDEX_CORRUPTED),
+				 errmsg("index tuple does not begin with the key prefix of its page in index \"%s\"",
+						RelationGetRelationName(state->rel)),
+				 errdetail_internal("Index tid=(%u,%u).", block, offset)));
+
+	return whole;
+}
+
 /*
  * Is particular offset within page (whose special state is passed by caller)
  * the page negative-infinity item?
@@ -3201,6 +3333,20 @@ palloc_btree_page(BtreeCheckState *state, BlockNumber blocknum)
 				 errmsg_internal("deleted page block %u in index \"%s\" is half-dead",
 								 blocknum, RelationGetRelationName(state->rel))));
 
+	/*
+	 * Only live leaf pages that are neither leftmost nor rightmost can have a
+	 * key prefix, and only in an index whose first key column allows it.
+	 * _bt_checkpage() already made sure that the special space is the right
+	 * size for the prefix.
+	 */
+	if (P_HAS_PREFIX(opaque) &&
+		(!P_ISLEAF(opaque) || P_IGNORE(opaque) || P_LEFTMOST(opaque) ||
+		 P_RIGHTMOST(opaque) || !_bt_prefix_eligible(state->rel)))
+		ereport(ERROR,
+				(errcode(ERRCODE_INDEX_CORRUPTED),
+				 errmsg_internal("unexpected key prefix in block %u of index \"%s\"",
+								 blocknum, RelationGetRelationName(state->rel))));
+
 	return page;
 }
 
@@ -3249,7 +3395,7 @@ PageGetItemIdCareful(BtreeCheckState *state, BlockNumber block, Page page,
 	ItemId		itemid = PageGetItemId(page, offset);
 
 	if (ItemIdGetOffset(itemid) + ItemIdGetLength(itemid) >
-		BLCKSZ - MAXALIGN(sizeof(BTPageOpaqueData)))
+		BLCKSZ - PageGetSpecialSize(page))
 		ereport(ERROR,
 				(errcode(ERRCODE_INDEX_CORRUPTED),
 				 errmsg("line pointer points past end of tuple space in index \"%s\"",
@@ -765,14 +765,23 @@ bt_page_items_bytea(PG_FUNCTION_ARGS)
 
 		uargs->offset = FirstOffsetNumber;
 
-		/* verify the special space has the expected size */
-		if (PageGetSpecialSize(uargs->page) != MAXALIGN(sizeof(BTPageOpaqueData)))
+		/*
+		 * verify the special space has the expected size, which is larger for
+		 * leaf pages with a key prefix
+		 */
+		if (PageGetSpecialSize(uargs->page) < MAXALIGN(sizeof(BTPageOpaqueData)))
 			ereport(ERROR,
 					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 					 errmsg("input page is not a valid %s page", "btree"),
 					 errdetail("Expected special size %d, got %d.",
 							   (int) MAXALIGN(sizeof(BTPageOpaqueData)),
 							   (int) PageGetSpecialSize(uargs->page))));
+		if (!BTPageSpecialSizeIsValid(uargs->page))
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("input page is not a valid %s page", "btree"),
+					 errdetail("Special size %d does not match the key prefix flag.",
+							   (int) PageGetSpecialSize(uargs->page))));
 
 		opaque = BTPageGetOpaque(uargs->page);
 
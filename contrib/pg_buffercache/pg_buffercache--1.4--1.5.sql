@@ -0,0 +1,20 @@
+/* contrib/pg_buffercache/pg_buffercache--1.4--1.5.sql */
+
+-- complain if script is sourced in psql, rather than via ALTER EXTENSION
+\echo Use "ALTER EXTENSION pg_buffercache UPDATE TO '1.5'" to load this file. \quit
+
+CREATE FUNCTION pg_buffercache_partitions(
+    OUT partition int4,
+    OUT first_buffer int4,
+    OUT num_buffers int4,
+    OUT next_victim_buffer int4,
+    OUT complete_passes int8,
+    OUT num_allocs int8,
+    OUT num_remote_allocs int8)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'pg_buffercache_partitions'
+LANGUAGE C PARALLEL SAFE;
+
+-- Don't want these to be available to public.
+REVOKE ALL ON FUNCTION pg_buffercache_partitions() FROM PUBLIC;
+GRANT EXECUTE ON FUNCTION pg_buffercache_partitions() TO pg_monitor;
@@ -19,6 +19,7 @@
 #define NUM_BUFFERCACHE_PAGES_ELEM	9
 #define NUM_BUFFERCACHE_SUMMARY_ELEM 5
 #define NUM_BUFFERCACHE_USAGE_COUNTS_ELEM 4
+#define NUM_BUFFERCACHE_PARTITIONS_ELEM 7
 
 PG_MODULE_MAGIC;
 
@@ -63,6 +64,7 @@ typedef struct
 PG_FUNCTION_INFO_V1(pg_buffercache_pages);
 PG_FUNCTION_INFO_V1(pg_buffercache_summary);
 PG_FUNCTION_INFO_V1(pg_buffercache_usage_counts);
+PG_FUNCTION_INFO_V1(pg_buffercache_partitions);
 
 Datum
 pg_buffercache_pages(PG_FUNCTION_ARGS)
@@ -347,3 +349,39 @@ pg_buffercache_usage_counts(PG_FUNCTION_ARGS)
 
 	return (Datum) 0;
 }
+
+/*
+ * Report the state of each clock sweep partition of the buffer replacement
+ * strategy, see clock_sweep_partitions.
+ */
+Datum
+pg_buffercache_partitions(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	int			nparts;
+	Datum		values[NUM_BUFFERCACHE_PARTITIONS_ELEM];
+	bool		nulls[NUM_BUFFERCACHE_PARTITIONS_ELEM] = {0};
+
+	InitMaterializedSRF(fcinfo, 0);
+
+	nparts = StrategyNumPartitions();
+
+	for (int i = 0; i < nparts; i++)
+	{
+		ClockSweepPartitionStats stats;
+
+		StrategyGetPartitionStats(i, &stats);
+
+		values[0] = Int32GetDatum(i);
+		values[1] = Int32GetDatum(stats.first_buffer);
+		values[2] = Int32GetDatum(stats.num_buffers);
+		values[3] = Int32GetDatum(stats.next_victim_buffer);
+		values[4] = Int64GetDatum((int64) stats.complete_passes);
+		values[5] = Int64GetDatum((int64) stats.num_allocs);
+		values[6] = Int64GetDatum((int64) stats.num_remote_allocs);
+
+		tuplestore_putvalues(rsinfo->setResult, rsinfo->setDesc, values, nulls);
+	}
+
+	return (Datum) 0;
+}
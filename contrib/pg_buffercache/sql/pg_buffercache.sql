@@ -12,6 +12,15 @@ from pg_buffercache_summary();
 
 SELECT count(*) > 0 FROM pg_buffercache_usage_counts() WHERE buffers >= 0;
 
+-- the partitions must cover all of shared buffers, without gaps
+SELECT sum(num_buffers) = (SELECT setting::bigint
+                           FROM pg_settings
+                           WHERE name = 'shared_buffers'),
+       bool_and(next_victim_buffer >= first_buffer AND
+                next_victim_buffer < first_buffer + num_buffers),
+       bool_and(num_remote_allocs <= num_allocs)
+FROM pg_buffercache_partitions();
+
 -- Check that the functions / views can't be accessed by default. To avoid
 -- having to create a dedicated user, use the pg_database_owner pseudo-role.
 SET ROLE pg_database_owner;
@@ -19,6 +28,7 @@ SELECT * FROM pg_buffercache;
 SELECT * FROM pg_buffercache_pages() AS p (wrong int);
 SELECT * FROM pg_buffercache_summary();
 SELECT * FROM pg_buffercache_usage_counts();
+SELECT * FROM pg_buffercache_partitions();
 RESET role;
 
 -- Check that pg_monitor is allowed to query view / function
@@ -26,3 +36,4 @@ SET ROLE pg_monitor;
 SELECT count(*) > 0 FROM pg_buffercache;
 SELECT buffers_used + buffers_unused > 0 FROM pg_buffercache_summary();
 SELECT count(*) > 0 FROM pg_buffercache_usage_counts();
+SELECT count(*) > 0 FROM pg_buffercache_partitions();
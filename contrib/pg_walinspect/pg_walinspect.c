@@ -316,6 +316,8 @@ GetWALBlockInfo(FunctionCallInfo fcinfo, XLogReaderState *record,
 				flags[cnt++] = CStringGetTextDatum("COMPRESS_LZ4");
 			if ((blk->bimg_info & BKPIMAGE_COMPRESS_ZSTD) != 0)
 				flags[cnt++] = CStringGetTextDatum("COMPRESS_ZSTD");
+			if ((blk->bimg_info & BKPIMAGE_COMPRESS_ZSTD_DICT) != 0)
+				flags[cnt++] = CStringGetTextDatum("COMPRESS_ZSTD_DICT");
 
 			Assert(cnt <= bitcnt);
 			block_fpi_info = construct_array_builtin(flags, cnt, TEXTOID);
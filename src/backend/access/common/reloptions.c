@@ -168,6 +168,16 @@ static relopt_bool boolRelOpts[] =
 		},
 		true
 	},
+	{
+		{
+			"prefix_compression",
+			"Enables prefix compression of leaf pages for this btree index",
+			RELOPT_KIND_BTREE,
+			ShareUpdateExclusiveLock	/* since it applies only to later
+										 * page splits */
+		},
+		false
+	},
 	/* list terminator */
 	{{NULL}}
 };
@@ -489,6 +499,15 @@ static relopt_enum_elt_def StdRdOptIndexCleanupValues[] =
 	{(const char *) NULL}		/* list terminator */
 };
 
+/* values from StdRdOptIncrementalMaintenance */
+static relopt_enum_elt_def StdRdOptIncrementalMaintenanceValues[] =
+{
+	{"off", STDRD_OPTION_INCREMENTAL_MAINTENANCE_OFF},
+	{"immediate", STDRD_OPTION_INCREMENTAL_MAINTENANCE_IMMEDIATE},
+	{"deferred", STDRD_OPTION_INCREMENTAL_MAINTENANCE_DEFERRED},
+	{(const char *) NULL}		/* list terminator */
+};
+
 /* values from GistOptBufferingMode */
 static relopt_enum_elt_def gistBufferingOptValues[] =
 {
@@ -520,6 +539,17 @@ static relopt_enum enumRelOpts[] =
 		STDRD_OPTION_VACUUM_INDEX_CLEANUP_AUTO,
 		gettext_noop("Valid values are \"on\", \"off\", and \"auto\".")
 	},
+	{
+		{
+			"incremental_maintenance",
+			"Keeps a materialized view up to date as its base tables change",
+			RELOPT_KIND_HEAP,
+			AccessExclusiveLock
+		},
+		StdRdOptIncrementalMaintenanceValues,
+		STDRD_OPTION_INCREMENTAL_MAINTENANCE_OFF,
+		gettext_noop("Valid values are \"off\", \"immediate\", and \"deferred\".")
+	},
 	{
 		{
 			"buffering",
@@ -1882,7 +1912,9 @@ default_reloptions(Datum reloptions, bool validate, relopt_kind kind)
 		{"vacuum_index_cleanup", RELOPT_TYPE_ENUM,
 		offsetof(StdRdOptions, vacuum_index_cleanup)},
 		{"vacuum_truncate", RELOPT_TYPE_BOOL,
-		offsetof(StdRdOptions, vacuum_truncate)}
+		offsetof(StdRdOptions, vacuum_truncate)},
+		{"incremental_maintenance", RELOPT_TYPE_ENUM,
+		offsetof(StdRdOptions, incremental_maintenance)}
 	};
 
 	return (bytea *) build_reloptions(reloptions, validate, kind,
@@ -2037,7 +2069,20 @@ heap_reloptions(char relkind, Datum reloptions, bool validate)
 			return (bytea *) rdopts;
 		case RELKIND_RELATION:
 		case RELKIND_MATVIEW:
-			return default_reloptions(reloptions, validate, RELOPT_KIND_HEAP);
+			rdopts = (StdRdOptions *)
+				default_reloptions(reloptions, validate, RELOPT_KIND_HEAP);
+
+			/*
+			 * Tables share the heap option kind with materialized views, but
+			 * there is nothing to maintain incrementally for them.
+			 */
+			if (validate && rdopts != NULL && relkind == RELKIND_RELATION &&
+				rdopts->incremental_maintenance != STDRD_OPTION_INCREMENTAL_MAINTENANCE_OFF)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("parameter \"%s\" can only be set for materialized views",
+								"incremental_maintenance")));
+			return (bytea *) rdopts;
 		default:
 			/* other relkinds are not supported */
 			return NULL;
@@ -3,7 +3,8 @@
  * ginfast.c
  *	  Fast insert routines for the Postgres inverted index access method.
  *	  Pending entries are stored in linear list of pages.  Later on
- *	  (typically during VACUUM), ginInsertCleanup() will be invoked to
+ *	  (typically during VACUUM, or in an autovacuum worker once the list
+ *	  exceeds gin_pending_list_limit), ginInsertCleanup() will be invoked to
  *	  transfer pending entries into the regular index structure.  This
  *	  wins because bulk insertion is much more efficient than retail.
  *
@@ -20,11 +21,15 @@
 
 #include "access/gin_private.h"
 #include "access/ginxlog.h"
+#include "access/htup_details.h"
+#include "access/relation.h"
 #include "access/xlog.h"
 #include "access/xloginsert.h"
 #include "catalog/pg_am.h"
 #include "commands/vacuum.h"
+#include "funcapi.h"
 #include "miscadmin.h"
+#include "pgstat.h"
 #include "port/pg_bitutils.h"
 #include "postmaster/autovacuum.h"
 #include "storage/indexfsm.h"
@@ -32,6 +37,7 @@
 #include "storage/predicate.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/guc.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
 
@@ -41,6 +47,14 @@ int			gin_pending_list_limit = 0;
 #define GIN_PAGE_FREESIZE \
 	( BLCKSZ - MAXALIGN(SizeOfPageHeaderData) - MAXALIGN(sizeof(GinPageOpaqueData)) )
 
+/*
+ * Once the pending list exceeds the cleanup size, inserting backends ask
+ * autovacuum to clean it.  Only when it grows past this many times the
+ * cleanup size do they clean it themselves, so that a slow or disabled
+ * autovacuum can't let the list grow without bound.
+ */
+#define GIN_PENDING_LIST_HARD_LIMIT_FACTOR	4
+
 typedef struct KeyArray
 {
 	Datum	   *keys;			/* expansible array */
@@ -49,6 +63,8 @@ typedef struct KeyArray
 	int32		maxvalues;		/* allocated size of arrays */
 } KeyArray;
 
+static bool ginRequestPendingListCleanup(GinState *ginstate);
+
 
 /*
  * Build a pending-list page from the given array of tuples, and write it out.
@@ -227,6 +243,7 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 	ginxlogUpdateMeta data;
 	bool		separateList = false;
 	bool		needCleanup = false;
+	bool		needInlineCleanup = false;
 	int			cleanupSize;
 	bool		needWal;
 
@@ -452,11 +469,18 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 	 * while pending list is still small enough to fit into
 	 * gin_pending_list_limit.
 	 *
+	 * Doing that here stalls the insert, so normally the work is handed to
+	 * autovacuum instead; see ginRequestPendingListCleanup().  We clean the
+	 * list ourselves only once it's far beyond the limit.
+	 *
 	 * ginInsertCleanup() should not be called inside our CRIT_SECTION.
 	 */
 	cleanupSize = GinGetPendingListCleanupSize(index);
 	if (metadata->nPendingPages * GIN_PAGE_FREESIZE > cleanupSize * 1024L)
 		needCleanup = true;
+	if (metadata->nPendingPages * GIN_PAGE_FREESIZE >
+		cleanupSize * 1024L * GIN_PENDING_LIST_HARD_LIMIT_FACTOR)
+		needInlineCleanup = true;
 
 	UnlockReleaseBuffer(metabuffer);
 
@@ -466,8 +490,43 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 	 * Since it could contend with concurrent cleanup process we cleanup
 	 * pending list not forcibly.
 	 */
-	if (needCleanup)
+	if (needCleanup &&
+		(needInlineCleanup || !ginRequestPendingListCleanup(ginstate)))
 		ginInsertCleanup(ginstate, false, true, false, NULL);
+
+	/* Once the list is back under the limit, a new request may be needed */
+	if (!needCleanup)
+		ginstate->cleanupRequested = false;
+}
+
+/*
+ * Ask autovacuum to clean the pending list of ginstate's index.
+ *
+ * Returns false if the request can't be made, in which case the caller must
+ * clean the list itself.  Each GinState makes at most one request, and
+ * AutoVacuumRequestWork() merges it with a pending one for the same index,
+ * so a burst of inserts into an over-full list costs little.
+ */
+static bool
+ginRequestPendingListCleanup(GinState *ginstate)
+{
+	Relation	index = ginstate->index;
+
+	if (ginstate->cleanupRequested)
+		return true;
+
+	/* Autovacuum can't help with temp tables, nor when it's disabled */
+	if (!AutoVacuumingActive() ||
+		index->rd_rel->relpersistence == RELPERSISTENCE_TEMP)
+		return false;
+
+	if (!AutoVacuumRequestWork(AVW_GINCleanPendingList,
+							   RelationGetRelid(index),
+							   InvalidBlockNumber))
+		return false;
+
+	ginstate->cleanupRequested = true;
+	return true;
 }
 
 /*
@@ -795,6 +854,9 @@ ginInsertCleanup(GinState *ginstate, bool full_clean,
 	bool		cleanupFinish = false;
 	bool		fsm_vac = false;
 	Size		workMemory;
+	int64		npages = 0;
+	instr_time	starttime,
+				elapsed;
 
 	/*
 	 * We would like to prevent concurrent cleanup process. For that we will
@@ -839,6 +901,8 @@ ginInsertCleanup(GinState *ginstate, bool full_clean,
 		return;
 	}
 
+	INSTR_TIME_SET_CURRENT(starttime);
+
 	/*
 	 * Remember a tail page to prevent infinite cleanup if other backends add
 	 * new tuples faster than we can cleanup.
@@ -890,6 +954,7 @@ ginInsertCleanup(GinState *ginstate, bool full_clean,
 		 * read page's datums into accum
 		 */
 		processPendingPage(&accum, &datums, page, FirstOffsetNumber);
+		npages++;
 
 		vacuum_delay_point();
 
@@ -1021,6 +1086,62 @@ ginInsertCleanup(GinState *ginstate, bool full_clean,
 	/* Clean up temporary space */
 	MemoryContextSwitchTo(oldCtx);
 	MemoryContextDelete(opCtx);
+
+	/* Only regular inserts call us without forceCleanup */
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, starttime);
+	pgstat_count_gin_pending_merge(index, !forceCleanup, npages, elapsed);
+}
+
+/*
+ * Clean the pending list of a GIN index, as requested from autovacuum by
+ * ginHeapTupleFastInsert().
+ *
+ * Like brin_summarize_range(), we run the index support functions as the
+ * index owner, in a security-restricted operation.
+ */
+void
+ginAutoCleanPendingList(Oid indexoid)
+{
+	Relation	indexRel;
+	GinState	ginstate;
+	Oid			save_userid;
+	int			save_sec_context;
+	int			save_nestlevel;
+
+	/* The index may have been dropped since the request was made */
+	indexRel = try_relation_open(indexoid, RowExclusiveLock);
+	if (indexRel == NULL)
+		return;
+
+	/* ... and its OID reused; also, see gin_clean_pending_list() */
+	if (indexRel->rd_rel->relkind != RELKIND_INDEX ||
+		indexRel->rd_rel->relam != GIN_AM_OID ||
+		!indexRel->rd_index->indisvalid)
+	{
+		relation_close(indexRel, RowExclusiveLock);
+		return;
+	}
+
+	GetUserIdAndSecContext(&save_userid, &save_sec_context);
+	SetUserIdAndSecContext(indexRel->rd_rel->relowner,
+						   save_sec_context | SECURITY_RESTRICTED_OPERATION);
+	save_nestlevel = NewGUCNestLevel();
+
+	/*
+	 * Clean up to the tail as it is now.  Inserts that arrive meanwhile will
+	 * ask again if the list is still too long.
+	 */
+	initGinState(&ginstate, indexRel);
+	ginInsertCleanup(&ginstate, false, true, true, NULL);
+
+	/* Roll back any GUC changes executed by index functions */
+	AtEOXact_GUC(false, save_nestlevel);
+
+	/* Restore userid and security context */
+	SetUserIdAndSecContext(save_userid, save_sec_context);
+
+	relation_close(indexRel, RowExclusiveLock);
 }
 
 /*
@@ -1088,3 +1209,53 @@ gin_clean_pending_list(PG_FUNCTION_ARGS)
 
 	PG_RETURN_INT64((int64) stats.pages_deleted);
 }
+
+/*
+ * SQL-callable function to report the size of the insert pending list
+ *
+ * This is meant for monitoring, so rather than wait for a conflicting lock
+ * on the index, we return NULLs.  Likewise for indexes we can't read.
+ */
+Datum
+gin_pending_list_size(PG_FUNCTION_ARGS)
+{
+	Oid			indexoid = PG_GETARG_OID(0);
+	Relation	indexRel;
+	TupleDesc	tupdesc;
+	Datum		values[2];
+	bool		nulls[2] = {true, true};
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	if (ConditionalLockRelationOid(indexoid, AccessShareLock))
+	{
+		indexRel = try_relation_open(indexoid, NoLock);
+
+		if (indexRel != NULL &&
+			indexRel->rd_rel->relkind == RELKIND_INDEX &&
+			indexRel->rd_rel->relam == GIN_AM_OID &&
+			!RELATION_IS_OTHER_TEMP(indexRel) &&
+			RelationGetNumberOfBlocks(indexRel) > GIN_METAPAGE_BLKNO)
+		{
+			Buffer		metabuffer;
+			GinMetaPageData *metadata;
+
+			metabuffer = ReadBuffer(indexRel, GIN_METAPAGE_BLKNO);
+			LockBuffer(metabuffer, GIN_SHARE);
+			metadata = GinPageGetMeta(BufferGetPage(metabuffer));
+
+			values[0] = Int64GetDatum((int64) metadata->nPendingPages);
+			values[1] = Int64GetDatum(metadata->nPendingHeapTuples);
+			nulls[0] = nulls[1] = false;
+
+			UnlockReleaseBuffer(metabuffer);
+		}
+
+		if (indexRel != NULL)
+			relation_close(indexRel, NoLock);
+		UnlockRelationOid(indexoid, AccessShareLock);
+	}
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
@@ -65,6 +65,7 @@
 #include "storage/smgr.h"
 #include "storage/spin.h"
 #include "storage/standby.h"
+#include "storage/streaming_read.h"
 #include "utils/datum.h"
 #include "utils/inval.h"
 #include "utils/lsyscache.h"
@@ -367,17 +368,16 @@ heap_setscanlimits(TableScanDesc sscan, BlockNumber startBlk, BlockNumber numBlk
 }
 
 /*
- * heapgetpage - subroutine for heapgettup()
+ * heap_prepare_pagescan - determine which tuples on the current page are
+ * visible, for page-at-a-time mode
  *
- * This routine reads and pins the specified page of the relation.
- * In page-at-a-time mode it performs additional work, namely determining
- * which tuples on the page are visible.
+ * The page is the one in scan->rs_cbuf, which the caller must have pinned.
  */
-void
-heapgetpage(TableScanDesc sscan, BlockNumber block)
+static void
+heap_prepare_pagescan(HeapScanDesc scan)
 {
-	HeapScanDesc scan = (HeapScanDesc) sscan;
-	Buffer		buffer;
+	Buffer		buffer = scan->rs_cbuf;
+	BlockNumber block = scan->rs_cblock;
 	Snapshot	snapshot;
 	Page		page;
 	int			lines;
@@ -385,31 +385,8 @@ heapgetpage(TableScanDesc sscan, BlockNumber block)
 	OffsetNumber lineoff;
 	bool		all_visible;
 
-	Assert(block < scan->rs_nblocks);
-
-	/* release previous scan buffer, if any */
-	if (BufferIsValid(scan->rs_cbuf))
-	{
-		ReleaseBuffer(scan->rs_cbuf);
-		scan->rs_cbuf = InvalidBuffer;
-	}
-
-	/*
-	 * Be sure to check for interrupts at least once per page.  Checks at
-	 * higher code levels won't be able to stop a seqscan that encounters many
-	 * pages' worth of consecutive dead tuples.
-	 */
-	CHECK_FOR_INTERRUPTS();
+	Assert(BufferGetBlockNumber(buffer) == block);
 
-	/* read page using selected strategy */
-	scan->rs_cbuf = ReadBufferExtended(scan->rs_base.rs_rd, MAIN_FORKNUM, block,
-									   RBM_NORMAL, scan->rs_strategy);
-	scan->rs_cblock = block;
-
-	if (!(scan->rs_base.rs_flags & SO_ALLOW_PAGEMODE))
-		return;
-
-	buffer = scan->rs_cbuf;
 	snapshot = scan->rs_base.rs_snapshot;
 
 	/*
@@ -483,6 +460,43 @@ heapgetpage(TableScanDesc sscan, BlockNumber block)
 	scan->rs_ntuples = ntup;
 }
 
+/*
+ * heapgetpage - subroutine for heapgettup()
+ *
+ * This routine reads and pins the specified page of the relation.
+ * In page-at-a-time mode it performs additional work, namely determining
+ * which tuples on the page are visible.
+ */
+void
+heapgetpage(TableScanDesc sscan, BlockNumber block)
+{
+	HeapScanDesc scan = (HeapScanDesc) sscan;
+
+	Assert(block < scan->rs_nblocks);
+
+	/* release previous scan buffer, if any */
+	if (BufferIsValid(scan->rs_cbuf))
+	{
+		ReleaseBuffer(scan->rs_cbuf);
+		scan->rs_cbuf = InvalidBuffer;
+	}
+
+	/*
+	 * Be sure to check for interrupts at least once per page.  Checks at
+	 * higher code levels won't be able to stop a seqscan that encounters many
+	 * pages' worth of consecutive dead tuples.
+	 */
+	CHECK_FOR_INTERRUPTS();
+
+	/* read page using selected strategy */
+	scan->rs_cbuf = ReadBufferExtended(scan->rs_base.rs_rd, MAIN_FORKNUM, block,
+									   RBM_NORMAL, scan->rs_strategy);
+	scan->rs_cblock = block;
+
+	if (scan->rs_base.rs_flags & SO_ALLOW_PAGEMODE)
+		heap_prepare_pagescan(scan);
+}
+
 /*
  * heapgettup_initial_block - return the first BlockNumber to scan
  *
@@ -705,6 +719,109 @@ heapgettup_advance_block(HeapScanDesc scan, BlockNumber block, ScanDirection dir
 	}
 }
 
+/*
+ * heap_scan_stream_read_next - streaming read callback for sequential scans
+ *
+ * Hands out the same sequence of blocks that heapgettup_initial_block() and
+ * heapgettup_advance_block() would produce for a forward scan, just ahead of
+ * the time the scan gets to them.
+ */
+static BlockNumber
+heap_scan_stream_read_next(StreamingRead *stream, void *callback_private_data)
+{
+	HeapScanDesc scan = (HeapScanDesc) callback_private_data;
+
+	if (unlikely(!scan->rs_inited))
+	{
+		scan->rs_prefetch_block = heapgettup_initial_block(scan, ForwardScanDirection);
+		scan->rs_inited = true;
+	}
+	else if (scan->rs_prefetch_block == InvalidBlockNumber)
+	{
+		/* the stream was reset mid-scan; continue after the current page */
+		scan->rs_prefetch_block = heapgettup_advance_block(scan,
+														   scan->rs_cblock,
+														   ForwardScanDirection);
+	}
+	else
+		scan->rs_prefetch_block = heapgettup_advance_block(scan,
+														   scan->rs_prefetch_block,
+														   ForwardScanDirection);
+
+	return scan->rs_prefetch_block;
+}
+
+/*
+ * heap_fetch_next_buffer - read and pin the next block of the scan
+ *
+ * Releases the previous scan buffer, if any, and sets scan->rs_cbuf and
+ * scan->rs_cblock to the next block to scan in direction "dir".  At the end
+ * of the scan, rs_cbuf is set to InvalidBuffer.
+ *
+ * Forward scans read their pages through the scan's streaming read, if it
+ * has one.  Backward scans (only possible with cursors) read page by page;
+ * any look-ahead the stream had done is thrown away first.
+ */
+static inline void
+heap_fetch_next_buffer(HeapScanDesc scan, ScanDirection dir)
+{
+	/* release previous scan buffer, if any */
+	if (BufferIsValid(scan->rs_cbuf))
+	{
+		ReleaseBuffer(scan->rs_cbuf);
+		scan->rs_cbuf = InvalidBuffer;
+	}
+
+	/*
+	 * Be sure to check for interrupts at least once per page.  Checks at
+	 * higher code levels won't be able to stop a seqscan that encounters many
+	 * pages' worth of consecutive dead tuples.
+	 */
+	CHECK_FOR_INTERRUPTS();
+
+	if (scan->rs_read_stream != NULL && ScanDirectionIsForward(dir))
+	{
+		scan->rs_cbuf = streaming_read_next_buffer(scan->rs_read_stream);
+		if (BufferIsValid(scan->rs_cbuf))
+			scan->rs_cblock = BufferGetBlockNumber(scan->rs_cbuf);
+		else
+		{
+			/* get ready for a possible restart of the scan */
+			streaming_read_reset(scan->rs_read_stream);
+			scan->rs_prefetch_block = InvalidBlockNumber;
+		}
+	}
+	else
+	{
+		BlockNumber block;
+
+		if (scan->rs_read_stream != NULL)
+		{
+			streaming_read_reset(scan->rs_read_stream);
+			scan->rs_prefetch_block = InvalidBlockNumber;
+		}
+
+		if (unlikely(!scan->rs_inited))
+		{
+			block = heapgettup_initial_block(scan, dir);
+			scan->rs_inited = true;
+		}
+		else
+			block = heapgettup_advance_block(scan, scan->rs_cblock, dir);
+
+		if (block == InvalidBlockNumber)
+			return;
+
+		Assert(block < scan->rs_nblocks);
+
+		/* read page using selected strategy */
+		scan->rs_cbuf = ReadBufferExtended(scan->rs_base.rs_rd, MAIN_FORKNUM,
+										   block, RBM_NORMAL,
+										   scan->rs_strategy);
+		scan->rs_cblock = block;
+	}
+}
+
 /* ----------------
  *		heapgettup - fetch next heap tuple
  *
@@ -732,23 +849,13 @@ heapgettup(HeapScanDesc scan,
 		   ScanKey key)
 {
 	HeapTuple	tuple = &(scan->rs_ctup);
-	BlockNumber block;
 	Page		page;
 	OffsetNumber lineoff;
 	int			linesleft;
 
-	if (unlikely(!scan->rs_inited))
-	{
-		block = heapgettup_initial_block(scan, dir);
-		/* ensure rs_cbuf is invalid when we get InvalidBlockNumber */
-		Assert(block != InvalidBlockNumber || !BufferIsValid(scan->rs_cbuf));
-		scan->rs_inited = true;
-	}
-	else
+	if (likely(scan->rs_inited))
 	{
 		/* continue from previously returned page/tuple */
-		block = scan->rs_cblock;
-
 		LockBuffer(scan->rs_cbuf, BUFFER_LOCK_SHARE);
 		page = heapgettup_continue_page(scan, dir, &linesleft, &lineoff);
 		goto continue_page;
@@ -758,9 +865,14 @@ heapgettup(HeapScanDesc scan,
 	 * advance the scan until we find a qualifying tuple or run out of stuff
 	 * to scan
 	 */
-	while (block != InvalidBlockNumber)
+	while (true)
 	{
-		heapgetpage((TableScanDesc) scan, block);
+		heap_fetch_next_buffer(scan, dir);
+
+		/* did we run out of blocks to scan? */
+		if (!BufferIsValid(scan->rs_cbuf))
+			break;
+
 		LockBuffer(scan->rs_cbuf, BUFFER_LOCK_SHARE);
 		page = heapgettup_start_page(scan, dir, &linesleft, &lineoff);
 continue_page:
@@ -782,7 +894,7 @@ continue_page:
 
 			tuple->t_data = (HeapTupleHeader) PageGetItem(page, lpp);
 			tuple->t_len = ItemIdGetLength(lpp);
-			ItemPointerSet(&(tuple->t_self), block, lineoff);
+			ItemPointerSet(&(tuple->t_self), scan->rs_cblock, lineoff);
 
 			visible = HeapTupleSatisfiesVisibility(tuple,
 												   scan->rs_base.rs_snapshot,
@@ -812,16 +924,9 @@ continue_page:
 		 * it's time to move to the next.
 		 */
 		LockBuffer(scan->rs_cbuf, BUFFER_LOCK_UNLOCK);
-
-		/* get the BlockNumber to scan next */
-		block = heapgettup_advance_block(scan, block, dir);
 	}
 
 	/* end of scan */
-	if (BufferIsValid(scan->rs_cbuf))
-		ReleaseBuffer(scan->rs_cbuf);
-
-	scan->rs_cbuf = InvalidBuffer;
 	scan->rs_cblock = InvalidBlockNumber;
 	tuple->t_data = NULL;
 	scan->rs_inited = false;
@@ -847,22 +952,13 @@ heapgettup_pagemode(HeapScanDesc scan,
 					ScanKey key)
 {
 	HeapTuple	tuple = &(scan->rs_ctup);
-	BlockNumber block;
 	Page		page;
 	int			lineindex;
 	int			linesleft;
 
-	if (unlikely(!scan->rs_inited))
-	{
-		block = heapgettup_initial_block(scan, dir);
-		/* ensure rs_cbuf is invalid when we get InvalidBlockNumber */
-		Assert(block != InvalidBlockNumber || !BufferIsValid(scan->rs_cbuf));
-		scan->rs_inited = true;
-	}
-	else
+	if (likely(scan->rs_inited))
 	{
 		/* continue from previously returned page/tuple */
-		block = scan->rs_cblock;	/* current page */
 		page = BufferGetPage(scan->rs_cbuf);
 		TestForOldSnapshot(scan->rs_base.rs_snapshot, scan->rs_base.rs_rd, page);
 
@@ -880,9 +976,15 @@ heapgettup_pagemode(HeapScanDesc scan,
 	 * advance the scan until we find a qualifying tuple or run out of stuff
 	 * to scan
 	 */
-	while (block != InvalidBlockNumber)
+	while (true)
 	{
-		heapgetpage((TableScanDesc) scan, block);
+		heap_fetch_next_buffer(scan, dir);
+
+		/* did we run out of blocks to scan? */
+		if (!BufferIsValid(scan->rs_cbuf))
+			break;
+
+		heap_prepare_pagescan(scan);
 		page = BufferGetPage(scan->rs_cbuf);
 		TestForOldSnapshot(scan->rs_base.rs_snapshot, scan->rs_base.rs_rd, page);
 		linesleft = scan->rs_ntuples;
@@ -902,7 +1004,7 @@ continue_page:
 
 			tuple->t_data = (HeapTupleHeader) PageGetItem(page, lpp);
 			tuple->t_len = ItemIdGetLength(lpp);
-			ItemPointerSet(&(tuple->t_self), block, lineoff);
+			ItemPointerSet(&(tuple->t_self), scan->rs_cblock, lineoff);
 
 			/* skip any tuples that don't match the scan key */
 			if (key != NULL &&
@@ -913,15 +1015,9 @@ continue_page:
 			scan->rs_cindex = lineindex;
 			return;
 		}
-
-		/* get the BlockNumber to scan next */
-		block = heapgettup_advance_block(scan, block, dir);
 	}
 
 	/* end of scan */
-	if (BufferIsValid(scan->rs_cbuf))
-		ReleaseBuffer(scan->rs_cbuf);
-	scan->rs_cbuf = InvalidBuffer;
 	scan->rs_cblock = InvalidBlockNumber;
 	tuple->t_data = NULL;
 	scan->rs_inited = false;
@@ -1016,6 +1112,18 @@ heap_beginscan(Relation relation, Snapshot snapshot,
 
 	initscan(scan, key, false);
 
+	/*
+	 * Sequential scans read their pages through a streaming read, so that
+	 * consecutive blocks can be read with vectored I/O.
+	 */
+	scan->rs_read_stream = NULL;
+	scan->rs_prefetch_block = InvalidBlockNumber;
+	if (scan->rs_base.rs_flags & SO_TYPE_SEQSCAN)
+		scan->rs_read_stream = streaming_read_begin(relation, MAIN_FORKNUM,
+													scan->rs_strategy,
+													heap_scan_stream_read_next,
+													scan);
+
 	return (TableScanDesc) scan;
 }
 
@@ -1050,10 +1158,28 @@ heap_rescan(TableScanDesc sscan, ScanKey key, bool set_params,
 	if (BufferIsValid(scan->rs_cbuf))
 		ReleaseBuffer(scan->rs_cbuf);
 
+	/*
+	 * The stream refers to the access strategy, which initscan() may replace,
+	 * so it's simplest to start over with a new one.
+	 */
+	if (scan->rs_read_stream != NULL)
+	{
+		streaming_read_end(scan->rs_read_stream);
+		scan->rs_read_stream = NULL;
+	}
+
 	/*
 	 * reinitialize scan descriptor
 	 */
 	initscan(scan, key, true);
+
+	scan->rs_prefetch_block = InvalidBlockNumber;
+	if (scan->rs_base.rs_flags & SO_TYPE_SEQSCAN)
+		scan->rs_read_stream = streaming_read_begin(scan->rs_base.rs_rd,
+													MAIN_FORKNUM,
+													scan->rs_strategy,
+													heap_scan_stream_read_next,
+													scan);
 }
 
 void
@@ -1069,6 +1195,9 @@ heap_endscan(TableScanDesc sscan)
 	if (BufferIsValid(scan->rs_cbuf))
 		ReleaseBuffer(scan->rs_cbuf);
 
+	if (scan->rs_read_stream != NULL)
+		streaming_read_end(scan->rs_read_stream);
+
 	/*
 	 * decrement relation reference count and free scan descriptor storage
 	 */
@@ -1168,6 +1297,51 @@ heap_getnextslot(TableScanDesc sscan, ScanDirection direction, TupleTableSlot *s
 	return true;
 }
 
+/*
+ * heap_prefetch_next - start reading the next page of a forward scan
+ *
+ * Returns true if the next heap_getnextslot() call can be served from the
+ * current page or from a buffer that is already valid, false if a read had
+ * to be initiated for the next page.  Only scans with a streaming read look
+ * ahead; anything else is reported as ready.
+ */
+bool
+heap_prefetch_next(TableScanDesc sscan)
+{
+	HeapScanDesc scan = (HeapScanDesc) sscan;
+
+	if (scan->rs_read_stream == NULL)
+		return true;
+
+	if (scan->rs_inited)
+	{
+		/* tuples left on the current page? */
+		if (BufferIsValid(scan->rs_cbuf) &&
+			(!(sscan->rs_flags & SO_ALLOW_PAGEMODE) ||
+			 scan->rs_cindex + 1 < scan->rs_ntuples))
+			return true;
+
+		return streaming_read_prefetch_next(scan->rs_read_stream);
+	}
+
+	/*
+	 * The scan hasn't read its first page yet.  heapgettup_pagemode() and
+	 * heapgettup() expect rs_inited to be set only together with rs_cbuf, so
+	 * we can't let the stream's callback run yet.  Serial scans know their
+	 * first block without side effects, so just hint that one; a parallel
+	 * scan would have to claim it from the shared state first.
+	 */
+	if (sscan->rs_parallel == NULL)
+	{
+		BlockNumber block = heapgettup_initial_block(scan, ForwardScanDirection);
+
+		if (block != InvalidBlockNumber)
+			return !PrefetchBuffer(sscan->rs_rd, MAIN_FORKNUM, block).initiated_io;
+	}
+
+	return true;
+}
+
 void
 heap_set_tidrange(TableScanDesc sscan, ItemPointer mintid,
 				  ItemPointer maxtid)
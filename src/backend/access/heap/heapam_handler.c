@@ -2551,6 +2551,7 @@ static const TableAmRoutine heapam_methods = { /// 就是一捆回调函数的
 	.scan_end = heap_endscan,
 	.scan_rescan = heap_rescan,
 	.scan_getnextslot = heap_getnextslot,
+	.scan_prefetch_next = heap_prefetch_next,
 
 	.scan_set_tidrange = heap_set_tidrange,
 	.scan_getnextslot_tidrange = heap_getnextslot_tidrange,
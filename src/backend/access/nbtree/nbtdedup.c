@@ -67,6 +67,7 @@ _bt_dedup_pass(Relation rel, Buffer buf, IndexTuple newitem, Size newitemsz,
 	BTDedupState state;
 	Size		pagesaving PG_USED_FOR_ASSERTS_ONLY = 0;
 	bool		singlevalstrat = false;
+	bool		prefixed = P_HAS_PREFIX(opaque);
 	int			nkeyatts = IndexRelationGetNumberOfKeyAttributes(rel);
 
 	/* Passed-in newitemsz is MAXALIGNED but does not include line pointer */
@@ -149,11 +150,16 @@ _bt_dedup_pass(Relation rel, Buffer buf, IndexTuple newitem, Size newitemsz,
 		}
 		else if (state->deduplicate &&
 				 _bt_keep_natts_fast(rel, state->base, itup) > nkeyatts &&
+				 (!prefixed || _bt_prefix_alike(rel, state->base, itup)) &&
 				 _bt_dedup_save_htid(state, itup))
 		{
 			/*
 			 * Tuple is equal to base tuple of pending posting list.  Heap
 			 * TID(s) for itup have been saved in state.
+			 *
+			 * On a page with a key prefix, a stripped value can have the same
+			 * image as another tuple's value that is stored whole, so the
+			 * tuples must also be stored the same way to be equal.
 			 */
 		}
 		else
@@ -785,20 +791,35 @@ _bt_do_singleval(Relation rel, Page page, BTDedupState state,
 	int			nkeyatts = IndexRelationGetNumberOfKeyAttributes(rel);
 	ItemId		itemid;
 	IndexTuple	itup;
+	IndexTuple	stripped;
+	bool		singleval = false;
+
+	/* Compare newitem the way it would be stored on page */
+	stripped = newitem;
+	if (P_HAS_PREFIX(BTPageGetOpaque(page)))
+	{
+		BTPagePrefix prefix = BTPageGetPrefix(page);
+
+		stripped = _bt_prefix_convert(rel, newitem, prefix->bpp_data, 0,
+									  prefix->bpp_len);
+	}
 
 	itemid = PageGetItemId(page, minoff);
 	itup = (IndexTuple) PageGetItem(page, itemid);
 
-	if (_bt_keep_natts_fast(rel, newitem, itup) > nkeyatts)
+	if (_bt_keep_natts_fast(rel, stripped, itup) > nkeyatts)
 	{
 		itemid = PageGetItemId(page, PageGetMaxOffsetNumber(page));
 		itup = (IndexTuple) PageGetItem(page, itemid);
 
-		if (_bt_keep_natts_fast(rel, newitem, itup) > nkeyatts)
-			return true;
+		if (_bt_keep_natts_fast(rel, stripped, itup) > nkeyatts)
+			singleval = true;
 	}
 
-	return false;
+	if (stripped != newitem)
+		pfree(stripped);
+
+	return singleval;
 }
 
 /*
@@ -826,7 +847,9 @@ _bt_singleval_fillfactor(Page page, BTDedupState state, Size newitemsz)
 
 	/* This calculation needs to match nbtsplitloc.c */
 	leftfree = PageGetPageSize(page) - SizeOfPageHeaderData -
-		MAXALIGN(sizeof(BTPageOpaqueData));
+		PageGetSpecialSize(page);
+	if (P_HAS_PREFIX(BTPageGetOpaque(page)))
+		leftfree -= BTPrefixMaxGrowth(BTPageGetPrefix(page)->bpp_len);
 	/* Subtract size of new high key (includes pivot heap TID space) */
 	leftfree -= newitemsz + MAXALIGN(sizeof(ItemPointerData));
 
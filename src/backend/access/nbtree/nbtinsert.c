@@ -57,6 +57,13 @@ static Buffer _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key,
 						Buffer buf, Buffer cbuf, OffsetNumber newitemoff,
 						Size newitemsz, IndexTuple newitem, IndexTuple orignewitem,
 						IndexTuple nposting, uint16 postingoff);
+static IndexTuple _bt_split_lowkey(Relation rel, BTPageOpaque oopaque,
+								   BlockNumber origpagenumber);
+static int	_bt_split_prefix(Relation rel, Page origpage, IndexTuple lowkey,
+							 IndexTuple highkey, OffsetNumber minoff,
+							 OffsetNumber maxoff, OffsetNumber postingoff,
+							 IndexTuple nposting, IndexTuple newitem,
+							 char *prefix);
 static void _bt_insert_parent(Relation rel, Relation heaprel, Buffer buf,
 							  Buffer rbuf, BTStack stack, bool isroot, bool isonly);
 static Buffer _bt_newlevel(Relation rel, Relation heaprel, Buffer lbuf, Buffer rbuf);
@@ -826,8 +833,13 @@ _bt_findinsertloc(Relation rel,
 
 	opaque = BTPageGetOpaque(page);
 
-	/* Check 1/3 of a page restriction */
-	if (unlikely(insertstate->itemsz > BTMaxItemSize(page)))
+	/*
+	 * Check 1/3 of a page restriction.  The item will be smaller once it's
+	 * stored on a page with a key prefix, so _bt_insertonpg() checks it
+	 * there instead.
+	 */
+	if (unlikely(insertstate->itemsz > BTMaxItemSize(page)) &&
+		!P_HAS_PREFIX(opaque))
 		_bt_check_third_page(rel, heapRel, itup_key->heapkeyspace, page,
 							 insertstate->itup);
 
@@ -1120,6 +1132,7 @@ _bt_insertonpg(Relation rel,
 				isroot,
 				isrightmost,
 				isonly;
+	IndexTuple	stripped = NULL;
 	IndexTuple	oposting = NULL;
 	IndexTuple	origitup = NULL;
 	IndexTuple	nposting = NULL;
@@ -1153,6 +1166,29 @@ _bt_insertonpg(Relation rel,
 	 */
 	Assert(isleaf || newitemoff > P_FIRSTDATAKEY(opaque));
 
+	/*
+	 * Leaf tuples on a page with a key prefix are stored without it.  Every
+	 * insertion and page split on such a page works with the stripped tuple,
+	 * including WAL records, so that redo never needs to know the prefix.
+	 */
+	if (isleaf && P_HAS_PREFIX(opaque))
+	{
+		BTPagePrefix prefix = BTPageGetPrefix(page);
+
+		stripped = _bt_prefix_convert(rel, itup, prefix->bpp_data, 0,
+									  prefix->bpp_len);
+		if (stripped == itup)
+			stripped = NULL;	/* compressed, so stored whole */
+		else
+			itup = stripped;
+		itemsz = MAXALIGN(IndexTupleSize(itup));
+
+		/* Check 1/3 of a page restriction, put off by _bt_findinsertloc() */
+		if (unlikely(itemsz > BTMaxItemSize(page)))
+			_bt_check_third_page(rel, heaprel, itup_key->heapkeyspace, page,
+								 itup);
+	}
+
 	/*
 	 * Do we need to split an existing posting list item?
 	 */
@@ -1434,6 +1470,8 @@ _bt_insertonpg(Relation rel,
 		pfree(nposting);
 		pfree(itup);
 	}
+	if (stripped)
+		pfree(stripped);
 }
 
 /*
@@ -1484,6 +1522,8 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 	ItemId		itemid;
 	IndexTuple	firstright,
 				lefthighkey;
+	IndexTuple	pagenewitem;
+	Size		pagenewitemsz;
 	OffsetNumber firstrightoff;
 	OffsetNumber afterleftoff,
 				afterrightoff,
@@ -1494,6 +1534,11 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 	bool		newitemonleft,
 				isleaf,
 				isrightmost;
+	int			oprefixlen = 0,
+				lprefixlen = 0,
+				rprefixlen = 0;
+	char		lprefix[BT_MAX_PREFIX_LEN],
+				rprefix[BT_MAX_PREFIX_LEN];
 
 	/*
 	 * origpage is the original page to be split.  leftpage is a temporary
@@ -1514,6 +1559,8 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 	isrightmost = P_RIGHTMOST(oopaque);
 	maxoff = PageGetMaxOffsetNumber(origpage);
 	origpagenumber = BufferGetBlockNumber(buf);
+	if (P_HAS_PREFIX(oopaque))
+		oprefixlen = BTPageGetPrefix(origpage)->bpp_len;
 
 	/*
 	 * Choose a point to split origpage at.
@@ -1542,31 +1589,6 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 	firstrightoff = _bt_findsplitloc(rel, origpage, newitemoff, newitemsz,
 									 newitem, &newitemonleft);
 
-	/* Allocate temp buffer for leftpage */
-	leftpage = PageGetTempPage(origpage);
-	_bt_pageinit(leftpage, BufferGetPageSize(buf));
-	lopaque = BTPageGetOpaque(leftpage);
-
-	/*
-	 * leftpage won't be the root when we're done.  Also, clear the SPLIT_END
-	 * and HAS_GARBAGE flags.
-	 */
-	lopaque->btpo_flags = oopaque->btpo_flags;
-	lopaque->btpo_flags &= ~(BTP_ROOT | BTP_SPLIT_END | BTP_HAS_GARBAGE);
-	/* set flag in leftpage indicating that rightpage has no downlink yet */
-	lopaque->btpo_flags |= BTP_INCOMPLETE_SPLIT;
-	lopaque->btpo_prev = oopaque->btpo_prev;
-	/* handle btpo_next after rightpage buffer acquired */
-	lopaque->btpo_level = oopaque->btpo_level;
-	/* handle btpo_cycleid after rightpage buffer acquired */
-
-	/*
-	 * Copy the original page's LSN into leftpage, which will become the
-	 * updated version of the page.  We need this because XLogInsert will
-	 * examine the LSN and possibly dump it in a page image.
-	 */
-	PageSetLSN(leftpage, PageGetLSN(origpage));
-
 	/*
 	 * Determine page offset number of existing overlapped-with-orignewitem
 	 * posting list when it is necessary to perform a posting list split in
@@ -1654,7 +1676,24 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 				lastleft = nposting;
 		}
 
-		lefthighkey = _bt_truncate(rel, lastleft, firstright, itup_key);
+		/*
+		 * Suffix truncation works with whole tuples, and the new high key is
+		 * stored whole like any other high key
+		 */
+		if (oprefixlen > 0)
+		{
+			IndexTuple	wlastleft = _bt_prefix_expand(rel, origpage, lastleft);
+			IndexTuple	wfirstright = _bt_prefix_expand(rel, origpage,
+														firstright);
+
+			lefthighkey = _bt_truncate(rel, wlastleft, wfirstright, itup_key);
+			if (wlastleft != lastleft)
+				pfree(wlastleft);
+			if (wfirstright != firstright)
+				pfree(wfirstright);
+		}
+		else
+			lefthighkey = _bt_truncate(rel, lastleft, firstright, itup_key);
 		itemsz = IndexTupleSize(lefthighkey);
 	}
 	else
@@ -1688,6 +1727,80 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 		lefthighkey = firstright;
 	}
 
+	/*
+	 * Choose the key prefixes of the new leaf pages.  Each keeps origpage's
+	 * prefix, unless its low key and high key have a longer one in common and
+	 * its tuples still fit once more of their key is stripped.  The left
+	 * page's low key is the high key of origpage's left sibling.  See "Notes
+	 * about prefix compression" in the README.
+	 */
+	if (isleaf)
+	{
+		lprefixlen = rprefixlen = oprefixlen;
+		if (oprefixlen > 0)
+		{
+			memcpy(lprefix, BTPageGetPrefix(origpage)->bpp_data, oprefixlen);
+			memcpy(rprefix, BTPageGetPrefix(origpage)->bpp_data, oprefixlen);
+		}
+
+		if (itup_key->heapkeyspace && _bt_prefix_enabled(rel))
+		{
+			IndexTuple	lowkey = _bt_split_lowkey(rel, oopaque,
+												  origpagenumber);
+			IndexTuple	righthighkey = NULL;
+
+			if (!isrightmost)
+				righthighkey = (IndexTuple)
+					PageGetItem(origpage, PageGetItemId(origpage, P_HIKEY));
+
+			lprefixlen = _bt_split_prefix(rel, origpage, lowkey, lefthighkey,
+										  P_FIRSTDATAKEY(oopaque),
+										  OffsetNumberPrev(firstrightoff),
+										  origpagepostingoff, nposting,
+										  newitemonleft ? newitem : NULL,
+										  lprefix);
+			rprefixlen = _bt_split_prefix(rel, origpage, lefthighkey,
+										  righthighkey, firstrightoff, maxoff,
+										  origpagepostingoff, nposting,
+										  newitemonleft ? NULL : newitem,
+										  rprefix);
+			if (lowkey)
+				pfree(lowkey);
+		}
+	}
+
+	/* Allocate temp buffer for leftpage */
+	leftpage = PageGetTempPage(origpage);
+	if (isleaf)
+		_bt_pageinit_prefix(leftpage, BufferGetPageSize(buf), lprefix,
+							lprefixlen);
+	else
+		_bt_pageinit(leftpage, BufferGetPageSize(buf));
+	lopaque = BTPageGetOpaque(leftpage);
+
+	/*
+	 * leftpage won't be the root when we're done.  Also, clear the SPLIT_END
+	 * and HAS_GARBAGE flags, and set BTP_PREFIX to match leftpage's prefix.
+	 */
+	lopaque->btpo_flags = oopaque->btpo_flags;
+	lopaque->btpo_flags &= ~(BTP_ROOT | BTP_SPLIT_END | BTP_HAS_GARBAGE |
+							 BTP_PREFIX);
+	if (lprefixlen > 0)
+		lopaque->btpo_flags |= BTP_PREFIX;
+	/* set flag in leftpage indicating that rightpage has no downlink yet */
+	lopaque->btpo_flags |= BTP_INCOMPLETE_SPLIT;
+	lopaque->btpo_prev = oopaque->btpo_prev;
+	/* handle btpo_next after rightpage buffer acquired */
+	lopaque->btpo_level = oopaque->btpo_level;
+	/* handle btpo_cycleid after rightpage buffer acquired */
+
+	/*
+	 * Copy the original page's LSN into leftpage, which will become the
+	 * updated version of the page.  We need this because XLogInsert will
+	 * examine the LSN and possibly dump it in a page image.
+	 */
+	PageSetLSN(leftpage, PageGetLSN(origpage));
+
 	/*
 	 * Add new high key to leftpage
 	 */
@@ -1720,7 +1833,10 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 	rbuf = _bt_allocbuf(rel, heaprel);
 	rightpage = BufferGetPage(rbuf);
 	rightpagenumber = BufferGetBlockNumber(rbuf);
-	/* rightpage was initialized by _bt_getbuf */
+	/* rightpage was initialized by _bt_getbuf, unless it has a prefix */
+	if (rprefixlen > 0)
+		_bt_pageinit_prefix(rightpage, BufferGetPageSize(rbuf), rprefix,
+							rprefixlen);
 	ropaque = BTPageGetOpaque(rightpage);
 
 	/*
@@ -1736,10 +1852,13 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 
 	/*
 	 * rightpage won't be the root when we're done.  Also, clear the SPLIT_END
-	 * and HAS_GARBAGE flags.
+	 * and HAS_GARBAGE flags, and set BTP_PREFIX to match rightpage's prefix.
 	 */
 	ropaque->btpo_flags = oopaque->btpo_flags;
-	ropaque->btpo_flags &= ~(BTP_ROOT | BTP_SPLIT_END | BTP_HAS_GARBAGE);
+	ropaque->btpo_flags &= ~(BTP_ROOT | BTP_SPLIT_END | BTP_HAS_GARBAGE |
+							 BTP_PREFIX);
+	if (rprefixlen > 0)
+		ropaque->btpo_flags |= BTP_PREFIX;
 	ropaque->btpo_prev = origpagenumber;
 	ropaque->btpo_next = oopaque->btpo_next;
 	ropaque->btpo_level = oopaque->btpo_level;
@@ -1783,6 +1902,24 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 	if (!isleaf)
 		minusinfoff = afterrightoff;
 
+	/*
+	 * A new leaf page with a longer key prefix than origpage stores its
+	 * tuples with more of their key stripped.  _bt_split_prefix() made sure
+	 * that they fit.
+	 */
+	pagenewitem = newitem;
+	pagenewitemsz = newitemsz;
+	if (isleaf)
+	{
+		if (newitemonleft)
+			pagenewitem = _bt_prefix_convert(rel, newitem, lprefix, oprefixlen,
+											 lprefixlen);
+		else
+			pagenewitem = _bt_prefix_convert(rel, newitem, rprefix, oprefixlen,
+											 rprefixlen);
+		pagenewitemsz = MAXALIGN(IndexTupleSize(pagenewitem));
+	}
+
 	/*
 	 * Now transfer all the data items (non-pivot tuples in isleaf case, or
 	 * additional pivot tuples in !isleaf case) to the appropriate page.
@@ -1792,7 +1929,8 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 	 */
 	for (i = P_FIRSTDATAKEY(oopaque); i <= maxoff; i = OffsetNumberNext(i))
 	{
-		IndexTuple	dataitem;
+		IndexTuple	dataitem,
+					pageitem;
 
 		itemid = PageGetItemId(origpage, i);
 		itemsz = ItemIdGetLength(itemid);
@@ -1812,8 +1950,8 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 			if (newitemonleft)
 			{
 				Assert(newitemoff <= firstrightoff);
-				if (!_bt_pgaddtup(leftpage, newitemsz, newitem, afterleftoff,
-								  false))
+				if (!_bt_pgaddtup(leftpage, pagenewitemsz, pagenewitem,
+								  afterleftoff, false))
 				{
 					memset(rightpage, 0, BufferGetPageSize(rbuf));
 					elog(ERROR, "failed to add new item to the left sibling"
@@ -1825,8 +1963,8 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 			else
 			{
 				Assert(newitemoff >= firstrightoff);
-				if (!_bt_pgaddtup(rightpage, newitemsz, newitem, afterrightoff,
-								  afterrightoff == minusinfoff))
+				if (!_bt_pgaddtup(rightpage, pagenewitemsz, pagenewitem,
+								  afterrightoff, afterrightoff == minusinfoff))
 				{
 					memset(rightpage, 0, BufferGetPageSize(rbuf));
 					elog(ERROR, "failed to add new item to the right sibling"
@@ -1837,10 +1975,24 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 			}
 		}
 
+		/* strip more of its key if its new page has a longer prefix */
+		pageitem = dataitem;
+		if (isleaf)
+		{
+			if (i < firstrightoff)
+				pageitem = _bt_prefix_convert(rel, dataitem, lprefix,
+											  oprefixlen, lprefixlen);
+			else
+				pageitem = _bt_prefix_convert(rel, dataitem, rprefix,
+											  oprefixlen, rprefixlen);
+			if (pageitem != dataitem)
+				itemsz = MAXALIGN(IndexTupleSize(pageitem));
+		}
+
 		/* decide which page to put it on */
 		if (i < firstrightoff)
 		{
-			if (!_bt_pgaddtup(leftpage, itemsz, dataitem, afterleftoff, false))
+			if (!_bt_pgaddtup(leftpage, itemsz, pageitem, afterleftoff, false))
 			{
 				memset(rightpage, 0, BufferGetPageSize(rbuf));
 				elog(ERROR, "failed to add old item to the left sibling"
@@ -1851,7 +2003,7 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 		}
 		else
 		{
-			if (!_bt_pgaddtup(rightpage, itemsz, dataitem, afterrightoff,
+			if (!_bt_pgaddtup(rightpage, itemsz, pageitem, afterrightoff,
 							  afterrightoff == minusinfoff))
 			{
 				memset(rightpage, 0, BufferGetPageSize(rbuf));
@@ -1861,6 +2013,9 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 			}
 			afterrightoff = OffsetNumberNext(afterrightoff);
 		}
+
+		if (pageitem != dataitem)
+			pfree(pageitem);
 	}
 
 	/* Handle case where newitem goes at the end of rightpage */
@@ -1872,8 +2027,8 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 		 * not be splitting the page).
 		 */
 		Assert(!newitemonleft && newitemoff == maxoff + 1);
-		if (!_bt_pgaddtup(rightpage, newitemsz, newitem, afterrightoff,
-						  afterrightoff == minusinfoff))
+		if (!_bt_pgaddtup(rightpage, pagenewitemsz, pagenewitem,
+						  afterrightoff, afterrightoff == minusinfoff))
 		{
 			memset(rightpage, 0, BufferGetPageSize(rbuf));
 			elog(ERROR, "failed to add new item to the right sibling"
@@ -1977,11 +2132,20 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 		xlrec.postingoff = 0;
 		if (postingoff != 0 && origpagepostingoff < firstrightoff)
 			xlrec.postingoff = postingoff;
+		xlrec.rightprefixlen = rprefixlen;
 
 		XLogBeginInsert();
 		XLogRegisterData((char *) &xlrec, SizeOfBtreeSplit);
 
-		XLogRegisterBuffer(0, buf, REGBUF_STANDARD);
+		/*
+		 * REDO can't strip more of the key from the left page's tuples, so
+		 * log a full-page image of it when its prefix is longer than
+		 * origpage's was
+		 */
+		if (lprefixlen != oprefixlen)
+			XLogRegisterBuffer(0, buf, REGBUF_STANDARD | REGBUF_FORCE_IMAGE);
+		else
+			XLogRegisterBuffer(0, buf, REGBUF_STANDARD);
 		XLogRegisterBuffer(1, rbuf, REGBUF_WILL_INIT);
 		/* Log original right sibling, since we've changed its prev-pointer */
 		if (!isrightmost)
@@ -2044,8 +2208,10 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 		 * some new func in page API.  Note we only store the tuples
 		 * themselves, knowing that they were inserted in item-number order
 		 * and so the line pointers can be reconstructed.  See comments for
-		 * _bt_restore_page().
+		 * _bt_restore_page().  The right page's key prefix goes first.
 		 */
+		if (rprefixlen > 0)
+			XLogRegisterBufData(1, rprefix, rprefixlen);
 		XLogRegisterBufData(1,
 							(char *) rightpage + ((PageHeader) rightpage)->pd_upper,
 							((PageHeader) rightpage)->pd_special - ((PageHeader) rightpage)->pd_upper);
@@ -2074,11 +2240,145 @@ _bt_split(Relation rel, Relation heaprel, BTScanInsert itup_key, Buffer buf,
 	/* be tidy */
 	if (isleaf)
 		pfree(lefthighkey);
+	if (pagenewitem != newitem)
+		pfree(pagenewitem);
 
 	/* split's done */
 	return rbuf;
 }
 
+/*
+ * _bt_split_lowkey() -- Get low key of a leaf page being split.
+ *
+ * The low key of origpage is the high key of its left sibling.  Returns a
+ * palloc'd copy of it, or NULL when origpage is leftmost or the left sibling
+ * can't be examined right away.
+ *
+ * We already hold a write lock on origpage, and the usual locking order is
+ * left to right, so we mustn't wait for a lock on the left sibling.  The
+ * page we lock must still be origpage's left sibling, and must not be
+ * half-dead: the key space of a page being deleted is about to become part
+ * of origpage's.  See _bt_mark_page_halfdead().
+ */
+static IndexTuple
+_bt_split_lowkey(Relation rel, BTPageOpaque oopaque,
+				 BlockNumber origpagenumber)
+{
+	Buffer		lbuf;
+	Page		lpage;
+	BTPageOpaque lopaque;
+	IndexTuple	lowkey = NULL;
+
+	if (P_LEFTMOST(oopaque))
+		return NULL;
+
+	lbuf = ReadBuffer(rel, oopaque->btpo_prev);
+	if (!_bt_conditionallockbuf(rel, lbuf))
+	{
+		ReleaseBuffer(lbuf);
+		return NULL;
+	}
+	_bt_checkpage(rel, lbuf);
+	lpage = BufferGetPage(lbuf);
+	lopaque = BTPageGetOpaque(lpage);
+
+	if (P_ISLEAF(lopaque) && !P_IGNORE(lopaque) && !P_RIGHTMOST(lopaque) &&
+		lopaque->btpo_next == origpagenumber)
+		lowkey = CopyIndexTuple((IndexTuple)
+								PageGetItem(lpage,
+											PageGetItemId(lpage, P_HIKEY)));
+
+	_bt_relbuf(rel, lbuf);
+
+	return lowkey;
+}
+
+/*
+ * _bt_split_prefix() -- Choose key prefix of a new leaf page.
+ *
+ * The new page's key space lies between lowkey and highkey, either of which
+ * may be NULL when it's unknown or the page is leftmost or rightmost.  Its
+ * tuples are the ones at offsets minoff through maxoff of origpage, with
+ * nposting in place of the one at postingoff, plus newitem unless it's NULL.
+ * They are stored with origpage's key prefix, if any.
+ *
+ * Stores the prefix in *prefix, which must have room for BT_MAX_PREFIX_LEN
+ * bytes, and returns its length.  This is the prefix that lowkey and highkey
+ * have in common if that's longer than origpage's and the page's tuples
+ * still fit with it, or else origpage's own.  With a longer prefix, tuples
+ * are smaller, but the special space is larger and the tuples that are
+ * stored whole (see _bt_prefix_convert) stay the same size, so we check.
+ */
+static int
+_bt_split_prefix(Relation rel, Page origpage, IndexTuple lowkey,
+				 IndexTuple highkey, OffsetNumber minoff, OffsetNumber maxoff,
+				 OffsetNumber postingoff, IndexTuple nposting,
+				 IndexTuple newitem, char *prefix)
+{
+	BTPagePrefix oprefix = NULL;
+	int			oldlen = 0;
+	int			newlen;
+
+	if (P_HAS_PREFIX(BTPageGetOpaque(origpage)))
+	{
+		oprefix = BTPageGetPrefix(origpage);
+		oldlen = oprefix->bpp_len;
+	}
+
+	newlen = _bt_prefix_common(rel, lowkey, highkey, prefix);
+	if (newlen > oldlen)
+	{
+		Size		freespace;
+		Size		maxitemsz;
+
+		freespace = PageGetPageSize(origpage) - SizeOfPageHeaderData -
+			BTPrefixSpecialSize(newlen) -
+			(MAXALIGN(IndexTupleSize(highkey)) + sizeof(ItemIdData));
+		maxitemsz = BTMaxItemSizeReserved(origpage,
+										  BTPrefixReservedSpace(newlen));
+
+		for (OffsetNumber off = minoff; off <= maxoff + 1; off++)
+		{
+			IndexTuple	itup;
+			IndexTuple	stripped;
+			Size		itemsz;
+
+			if (off > maxoff)
+			{
+				if (newitem == NULL)
+					break;
+				itup = newitem;
+			}
+			else if (off == postingoff)
+				itup = nposting;
+			else
+				itup = (IndexTuple) PageGetItem(origpage,
+												PageGetItemId(origpage, off));
+
+			stripped = _bt_prefix_convert(rel, itup, prefix, oldlen, newlen);
+			itemsz = MAXALIGN(IndexTupleSize(stripped));
+			if (stripped != itup)
+				pfree(stripped);
+
+			if (itemsz > maxitemsz || itemsz + sizeof(ItemIdData) > freespace)
+			{
+				newlen = oldlen;
+				break;
+			}
+			freespace -= itemsz + sizeof(ItemIdData);
+		}
+	}
+
+	if (newlen <= oldlen)
+	{
+		newlen = oldlen;
+		if (oldlen > 0)
+			memcpy(prefix, oprefix->bpp_data, oldlen);
+	}
+
+	return newlen;
+}
+
 /*
  * _bt_insert_parent() -- Insert downlink into parent, completing split.
  *
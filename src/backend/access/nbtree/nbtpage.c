@@ -813,9 +813,11 @@ _bt_checkpage(Relation rel, Buffer buf)
 				 errhint("Please REINDEX it.")));
 
 	/*
-	 * Additionally check that the special area looks sane.
+	 * Additionally check that the special area looks sane.  Leaf pages with
+	 * a key prefix have a larger one.
 	 */
-	if (PageGetSpecialSize(page) != MAXALIGN(sizeof(BTPageOpaqueData)))
+	if (PageGetSpecialSize(page) < MAXALIGN(sizeof(BTPageOpaqueData)) ||
+		!BTPageSpecialSizeIsValid(page))
 		ereport(ERROR,
 				(errcode(ERRCODE_INDEX_CORRUPTED),
 				 errmsg("index \"%s\" contains corrupted page at block %u",
@@ -1131,6 +1133,37 @@ _bt_pageinit(Page page, Size size)
 	PageInit(page, size, sizeof(BTPageOpaqueData));
 }
 
+/*
+ *	_bt_pageinit_prefix() -- Initialize a new leaf page with a key prefix.
+ *
+ * Like _bt_pageinit(), but makes room in the special space for prefix, and
+ * sets BTP_PREFIX in addition to BTP_LEAF.  A prefixlen of 0 gives a leaf
+ * page without a prefix.  Caller sets the other special space fields.
+ */
+void
+_bt_pageinit_prefix(Page page, Size size, const char *prefix, int prefixlen)
+{
+	BTPageOpaque opaque;
+	BTPagePrefix pageprefix;
+
+	Assert(prefixlen == 0 ||
+		   (prefixlen >= BT_MIN_PREFIX_LEN && prefixlen <= BT_MAX_PREFIX_LEN));
+
+	if (prefixlen == 0)
+	{
+		_bt_pageinit(page, size);
+		BTPageGetOpaque(page)->btpo_flags = BTP_LEAF;
+		return;
+	}
+
+	PageInit(page, size, BTPrefixSpecialSize(prefixlen));
+	opaque = BTPageGetOpaque(page);
+	opaque->btpo_flags = BTP_LEAF | BTP_PREFIX;
+	pageprefix = BTPageGetPrefix(page);
+	pageprefix->bpp_len = prefixlen;
+	memcpy(pageprefix->bpp_data, prefix, prefixlen);
+}
+
 /*
  * Delete item(s) from a btree leaf page during VACUUM.
  *
@@ -1774,6 +1807,56 @@ _bt_rightsib_halfdeadflag(Relation rel, BlockNumber leafrightsib)
 	return result;
 }
 
+/*
+ * Check that the key prefix of leafrightsib (the btpo_next of target leaf
+ * page leafpage), if any, is also a prefix of leafpage's key prefix.  Used
+ * during page deletion.
+ *
+ * Deleting the target page moves its key space right, to leafrightsib.  All
+ * keys in the target's key space are known to begin with leafrightsib's
+ * prefix only when this holds; see "Notes about prefix compression" in the
+ * README.  Returning false means that page deletion cannot go ahead.
+ *
+ * The answer can't change while caller holds the lock on the target page.
+ * Only a split of leafrightsib can change its prefix, and it can only make
+ * it longer by examining the target page's high key, which it won't wait to
+ * lock (see _bt_split_lowkey()).  Once the target page is half-dead, splits
+ * ignore it.
+ */
+static bool
+_bt_rightsib_prefix_ok(Relation rel, Page leafpage, BlockNumber leafrightsib)
+{
+	Buffer		buf;
+	Page		page;
+	BTPageOpaque opaque;
+	bool		result = true;
+
+	Assert(leafrightsib != P_NONE);
+
+	buf = _bt_getbuf(rel, leafrightsib, BT_READ);
+	page = BufferGetPage(buf);
+	opaque = BTPageGetOpaque(page);
+
+	if (P_HAS_PREFIX(opaque))
+	{
+		BTPagePrefix prefix = BTPageGetPrefix(page);
+
+		if (!P_HAS_PREFIX(BTPageGetOpaque(leafpage)))
+			result = false;
+		else
+		{
+			BTPagePrefix leafprefix = BTPageGetPrefix(leafpage);
+
+			result = prefix->bpp_len <= leafprefix->bpp_len &&
+				memcmp(prefix->bpp_data, leafprefix->bpp_data,
+					   prefix->bpp_len) == 0;
+		}
+	}
+	_bt_relbuf(rel, buf);
+
+	return result;
+}
+
 /*
  * _bt_pagedel() -- Delete a leaf page from the b-tree, if legal to do so.
  *
@@ -2096,6 +2179,7 @@ _bt_mark_page_halfdead(Relation rel, Relation heaprel, Buffer leafbuf,
 	OffsetNumber nextoffset;
 	IndexTuple	itup;
 	IndexTupleData trunctuple;
+	Page		newleafpage = NULL;
 
 	page = BufferGetPage(leafbuf);
 	opaque = BTPageGetOpaque(page);
@@ -2125,6 +2209,17 @@ _bt_mark_page_halfdead(Relation rel, Relation heaprel, Buffer leafbuf,
 		return false;
 	}
 
+	/*
+	 * Likewise check that the right sibling's key prefix, if any, will still
+	 * be valid once it takes over the leaf page's key space
+	 */
+	if (!_bt_rightsib_prefix_ok(rel, page, leafrightsib))
+	{
+		elog(DEBUG1, "could not delete page %u because the key prefix of its right sibling %u is longer",
+			 leafblkno, leafrightsib);
+		return false;
+	}
+
 	/*
 	 * We cannot delete a page that is the rightmost child of its immediate
 	 * parent, unless it is the only child --- in which case the parent has to
@@ -2187,6 +2282,31 @@ _bt_mark_page_halfdead(Relation rel, Relation heaprel, Buffer leafbuf,
 		return false;
 	}
 
+	/*
+	 * The leaf page loses its key prefix along with its key space.  Prepare
+	 * a copy of it without the prefix, which replaces it below; REDO
+	 * reinitializes the page in the same way.
+	 */
+	page = BufferGetPage(leafbuf);
+	opaque = BTPageGetOpaque(page);
+	if (P_HAS_PREFIX(opaque))
+	{
+		BTPageOpaque newopaque;
+
+		newleafpage = PageGetTempPage(page);
+		_bt_pageinit(newleafpage, BufferGetPageSize(leafbuf));
+		PageSetLSN(newleafpage, PageGetLSN(page));
+		newopaque = BTPageGetOpaque(newleafpage);
+		memcpy(newopaque, opaque, sizeof(BTPageOpaqueData));
+		newopaque->btpo_flags &= ~BTP_PREFIX;
+
+		itemid = PageGetItemId(page, P_HIKEY);
+		if (PageAddItem(newleafpage, PageGetItem(page, itemid),
+						ItemIdGetLength(itemid), P_HIKEY,
+						false, false) == InvalidOffsetNumber)
+			elog(ERROR, "could not add high key to half-dead page");
+	}
+
 	/*
 	 * Any insert which would have gone on the leaf block will now go to its
 	 * right sibling.  In other words, the key space moves right.
@@ -2224,6 +2344,8 @@ _bt_mark_page_halfdead(Relation rel, Relation heaprel, Buffer leafbuf,
 	 * is set to InvalidBlockNumber.
 	 */
 	page = BufferGetPage(leafbuf);
+	if (newleafpage)
+		PageRestoreTempPage(newleafpage, page);
 	opaque = BTPageGetOpaque(page);
 	opaque->btpo_flags |= BTP_HALF_DEAD;
 
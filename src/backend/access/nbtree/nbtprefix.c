@@ -0,0 +1,398 @@
+/*-------------------------------------------------------------------------
+ *
+ * nbtprefix.c
+ *	  Key prefix compression of Postgres btree leaf pages.
+ *
+ * Portions Copyright (c) 1996-2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/nbtree/nbtprefix.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "access/nbtree.h"
+#include "catalog/pg_opfamily.h"
+#include "utils/pg_locale.h"
+#include "utils/rel.h"
+#include "varatt.h"
+
+static IndexTuple _bt_prefix_form(Relation rel, IndexTuple itup,
+								  struct varlena *attr1);
+
+/*
+ * Can leaf pages of rel have a key prefix?
+ *
+ * The first key attribute must be a varlena whose btree ordering compares
+ * the bytes of the values, with a shorter value sorting before any longer
+ * value that begins with it: bytea, text_pattern_ops, and text in the "C"
+ * collation.  With that ordering, every value between two others begins
+ * with the bytes those two have in common, which is what lets a page's key
+ * space have a prefix.  See "Notes about prefix compression" in the README.
+ */
+bool
+_bt_prefix_eligible(Relation rel)
+{
+	Form_pg_attribute att = TupleDescAttr(RelationGetDescr(rel), 0);
+
+	if (att->attlen != -1)
+		return false;
+
+	switch (rel->rd_opfamily[0])
+	{
+		case BYTEA_BTREE_FAM_OID:
+		case TEXT_PATTERN_BTREE_FAM_OID:
+			return true;
+		case TEXT_BTREE_FAM_OID:
+			return lc_collate_is_c(rel->rd_indcollation[0]);
+		default:
+			return false;
+	}
+}
+
+/*
+ * Should page splits and index builds give rel's leaf pages a key prefix?
+ *
+ * Pages that already have one keep it regardless, so everything that reads
+ * leaf pages must cope with prefixes whenever _bt_prefix_eligible() is true.
+ */
+bool
+_bt_prefix_enabled(Relation rel)
+{
+	return BTGetPrefixCompression(rel) && _bt_prefix_eligible(rel);
+}
+
+/*
+ * Return the number of leading bytes that the first attribute of itup has in
+ * common with prefix, which is prefixlen bytes long.
+ *
+ * itup must have its first attribute whole: it's a pivot tuple, or a
+ * non-pivot tuple that isn't stored on a page with a prefix.  Pivot tuples
+ * truncated to zero attributes, and NULLs, have nothing in common with any
+ * prefix.
+ */
+int
+_bt_prefix_match(Relation rel, IndexTuple itup, const char *prefix,
+				 int prefixlen)
+{
+	struct varlena *attr1;
+	Datum		datum;
+	bool		isnull;
+	char	   *data;
+	int			len;
+	int			n;
+
+	if (BTreeTupleGetNAtts(itup, rel) < 1)
+		return 0;
+	datum = index_getattr(itup, 1, RelationGetDescr(rel), &isnull);
+	if (isnull)
+		return 0;
+
+	/* Values that index_form_tuple() compressed must be decompressed */
+	attr1 = PG_DETOAST_DATUM_PACKED(datum);
+	data = VARDATA_ANY(attr1);
+	len = VARSIZE_ANY_EXHDR(attr1);
+
+	for (n = 0; n < prefixlen && n < len; n++)
+	{
+		if (data[n] != prefix[n])
+			break;
+	}
+
+	if ((Pointer) attr1 != DatumGetPointer(datum))
+		pfree(attr1);
+
+	return n;
+}
+
+/*
+ * Compute the prefix of a leaf page whose key space lies between lowkey
+ * (exclusive) and highkey (inclusive), and store it in *prefix, which must
+ * have room for BT_MAX_PREFIX_LEN bytes.  Returns the length of the prefix,
+ * which is 0 if there shouldn't be one.
+ *
+ * lowkey is NULL when the page's low key is unknown.  It's also unknown for
+ * a leftmost page, and there is no high key for a rightmost page, so they
+ * never have a prefix.
+ */
+int
+_bt_prefix_common(Relation rel, IndexTuple lowkey, IndexTuple highkey,
+				  char *prefix)
+{
+	struct varlena *attr1;
+	Datum		datum;
+	bool		isnull;
+	int			len;
+
+	if (lowkey == NULL || highkey == NULL ||
+		BTreeTupleGetNAtts(lowkey, rel) < 1)
+		return 0;
+	datum = index_getattr(lowkey, 1, RelationGetDescr(rel), &isnull);
+	if (isnull)
+		return 0;
+
+	attr1 = PG_DETOAST_DATUM_PACKED(datum);
+	len = Min(VARSIZE_ANY_EXHDR(attr1), BT_MAX_PREFIX_LEN);
+	memcpy(prefix, VARDATA_ANY(attr1), len);
+	if ((Pointer) attr1 != DatumGetPointer(datum))
+		pfree(attr1);
+
+	len = _bt_prefix_match(rel, highkey, prefix, len);
+	if (len < BT_MIN_PREFIX_LEN)
+		return 0;
+
+	return len;
+}
+
+/*
+ * Convert non-pivot tuple itup, stored with the first oldlen bytes of its
+ * first attribute stripped, to one with the first newlen bytes stripped.
+ * prefix holds the longer of the two prefixes, which must begin with the
+ * shorter one.  Use oldlen 0 to strip a prefix from a whole tuple, and
+ * newlen 0 to put it back.
+ *
+ * Returns a palloc'd tuple, or itup itself when it doesn't need to change.
+ * Values that index_form_tuple() compressed are always stored whole, since
+ * stripping them would mean storing them uncompressed.  They are easy to
+ * tell apart from stripped values, which never are compressed.
+ *
+ * Raises an error if the tuple doesn't begin with the new prefix, as that
+ * means that the tuple is outside of the page's key space.
+ */
+IndexTuple
+_bt_prefix_convert(Relation rel, IndexTuple itup, const char *prefix,
+				   int oldlen, int newlen)
+{
+	struct varlena *attr1;
+	struct varlena *newattr1;
+	IndexTuple	result;
+	Datum		datum;
+	bool		isnull;
+	char	   *data;
+	int			len;
+
+	Assert(!BTreeTupleIsPivot(itup));
+	Assert(oldlen >= 0 && oldlen <= BT_MAX_PREFIX_LEN);
+	Assert(newlen >= 0 && newlen <= BT_MAX_PREFIX_LEN);
+
+	if (oldlen == newlen)
+		return itup;
+
+	datum = index_getattr(itup, 1, RelationGetDescr(rel), &isnull);
+	if (isnull)
+		elog(ERROR, "NULL key in index \"%s\" is on a page with a key prefix",
+			 RelationGetRelationName(rel));
+	attr1 = (struct varlena *) DatumGetPointer(datum);
+	if (VARATT_IS_COMPRESSED(attr1))
+		return itup;
+
+	data = VARDATA_ANY(attr1);
+	len = VARSIZE_ANY_EXHDR(attr1);
+	if (newlen > oldlen)
+	{
+		int			strip = newlen - oldlen;
+
+		if (len < strip || memcmp(data, prefix + oldlen, strip) != 0)
+			elog(ERROR, "key in index \"%s\" does not begin with the page's key prefix",
+				 RelationGetRelationName(rel));
+
+		newattr1 = (struct varlena *) palloc(VARHDRSZ + len - strip);
+		SET_VARSIZE(newattr1, VARHDRSZ + len - strip);
+		memcpy(VARDATA(newattr1), data + strip, len - strip);
+	}
+	else
+	{
+		int			add = oldlen - newlen;
+
+		newattr1 = (struct varlena *) palloc(VARHDRSZ + add + len);
+		SET_VARSIZE(newattr1, VARHDRSZ + add + len);
+		memcpy(VARDATA(newattr1), prefix + newlen, add);
+		memcpy(VARDATA(newattr1) + add, data, len);
+	}
+
+	result = _bt_prefix_form(rel, itup, newattr1);
+	pfree(newattr1);
+
+	return result;
+}
+
+/*
+ * Return non-pivot tuple itup from page with its first attribute whole.
+ *
+ * Returns a palloc'd tuple, or itup itself if it is already whole.
+ */
+IndexTuple
+_bt_prefix_expand(Relation rel, Page page, IndexTuple itup)
+{
+	BTPagePrefix prefix;
+
+	if (!P_HAS_PREFIX(BTPageGetOpaque(page)))
+		return itup;
+
+	prefix = BTPageGetPrefix(page);
+	return _bt_prefix_convert(rel, itup, prefix->bpp_data,
+							  prefix->bpp_len, 0);
+}
+
+/*
+ * Are the first attributes of non-pivot tuples a and b, from the same page
+ * with a prefix, either both stripped or both stored whole?
+ *
+ * Tuples whose images are equal can only have equal keys if so.
+ */
+bool
+_bt_prefix_alike(Relation rel, IndexTuple a, IndexTuple b)
+{
+	TupleDesc	itupdesc = RelationGetDescr(rel);
+	Datum		datuma,
+				datumb;
+	bool		isnulla,
+				isnullb;
+
+	datuma = index_getattr(a, 1, itupdesc, &isnulla);
+	datumb = index_getattr(b, 1, itupdesc, &isnullb);
+	if (isnulla || isnullb)
+		return isnulla == isnullb;
+
+	return VARATT_IS_COMPRESSED(DatumGetPointer(datuma)) ==
+		VARATT_IS_COMPRESSED(DatumGetPointer(datumb));
+}
+
+/*
+ * Compare the first attribute of a non-pivot tuple on a page with a prefix
+ * to scankey's argument, returning what scankey's comparison function would
+ * with the whole value as its left argument.
+ *
+ * datum is the attribute as stored.  When the comparison function is the
+ * opfamily's own, the ordering is that of the bytes (see
+ * _bt_prefix_eligible), so we compare the argument to the page's prefix and
+ * then to the rest of the value without putting the value back together.
+ */
+int32
+_bt_prefix_cmp(Relation rel, Page page, Datum datum, ScanKey scankey)
+{
+	BTPagePrefix prefix = BTPageGetPrefix(page);
+	struct varlena *rest = (struct varlena *) DatumGetPointer(datum);
+	struct varlena *arg = (struct varlena *) DatumGetPointer(scankey->sk_argument);
+	struct varlena *whole;
+	int32		result;
+
+	Assert(P_HAS_PREFIX(BTPageGetOpaque(page)));
+
+	/* Stored whole */
+	if (VARATT_IS_COMPRESSED(rest))
+		return DatumGetInt32(FunctionCall2Coll(&scankey->sk_func,
+											   scankey->sk_collation,
+											   datum,
+											   scankey->sk_argument));
+
+	if ((scankey->sk_subtype == InvalidOid ||
+		 scankey->sk_subtype == rel->rd_opcintype[0]) &&
+		!VARATT_IS_EXTERNAL(arg) && !VARATT_IS_COMPRESSED(arg))
+	{
+		char	   *argdata = VARDATA_ANY(arg);
+		int			arglen = VARSIZE_ANY_EXHDR(arg);
+		char	   *restdata = VARDATA_ANY(rest);
+		int			restlen = VARSIZE_ANY_EXHDR(rest);
+		int			plen = prefix->bpp_len;
+
+		result = memcmp(prefix->bpp_data, argdata, Min(plen, arglen));
+		if (result != 0)
+			return result;
+		if (arglen <= plen)
+			return 1;			/* the value is longer than the argument */
+
+		argdata += plen;
+		arglen -= plen;
+		result = memcmp(restdata, argdata, Min(restlen, arglen));
+		if (result == 0 && restlen != arglen)
+			result = (restlen < arglen) ? -1 : 1;
+
+		return result;
+	}
+
+	/* Cross-type comparison, or toasted argument; build the whole value */
+	whole = (struct varlena *) palloc(VARHDRSZ + prefix->bpp_len +
+									  VARSIZE_ANY_EXHDR(rest));
+	SET_VARSIZE(whole, VARHDRSZ + prefix->bpp_len + VARSIZE_ANY_EXHDR(rest));
+	memcpy(VARDATA(whole), prefix->bpp_data, prefix->bpp_len);
+	memcpy(VARDATA(whole) + prefix->bpp_len, VARDATA_ANY(rest),
+		   VARSIZE_ANY_EXHDR(rest));
+	result = DatumGetInt32(FunctionCall2Coll(&scankey->sk_func,
+											 scankey->sk_collation,
+											 PointerGetDatum(whole),
+											 scankey->sk_argument));
+	pfree(whole);
+
+	return result;
+}
+
+/*
+ * Form a copy of non-pivot tuple itup with attr1 as its first attribute.
+ *
+ * This is like index_form_tuple(), except that attr1 is never compressed,
+ * and posting lists are kept.
+ */
+static IndexTuple
+_bt_prefix_form(Relation rel, IndexTuple itup, struct varlena *attr1)
+{
+	TupleDesc	itupdesc = RelationGetDescr(rel);
+	Datum		values[INDEX_MAX_KEYS];
+	bool		isnull[INDEX_MAX_KEYS];
+	unsigned short infomask = 0;
+	uint16		tupmask = 0;
+	bool		hasnull = false;
+	Size		hoff,
+				data_size,
+				keysize,
+				newsize;
+	IndexTuple	result;
+
+	index_deform_tuple(itup, itupdesc, values, isnull);
+	values[0] = PointerGetDatum(attr1);
+
+	for (int i = 0; i < itupdesc->natts; i++)
+	{
+		if (isnull[i])
+		{
+			hasnull = true;
+			break;
+		}
+	}
+	if (hasnull)
+		infomask |= INDEX_NULL_MASK;
+
+	hoff = IndexInfoFindDataOffset(infomask);
+	data_size = heap_compute_data_size(itupdesc, values, isnull);
+	keysize = MAXALIGN(hoff + data_size);
+	newsize = keysize;
+	if (BTreeTupleIsPosting(itup))
+		newsize = MAXALIGN(keysize +
+						   BTreeTupleGetNPosting(itup) * sizeof(ItemPointerData));
+	if (newsize > INDEX_SIZE_MASK)
+		elog(ERROR, "index row requires %zu bytes, maximum size is %zu",
+			 newsize, (Size) INDEX_SIZE_MASK);
+
+	result = (IndexTuple) palloc0(newsize);
+	heap_fill_tuple(itupdesc, values, isnull, (char *) result + hoff,
+					data_size, &tupmask,
+					(hasnull ? (bits8 *) result + sizeof(IndexTupleData) : NULL));
+	if (tupmask & HEAP_HASVARWIDTH)
+		infomask |= INDEX_VAR_MASK;
+	result->t_info = newsize | infomask;
+
+	if (BTreeTupleIsPosting(itup))
+	{
+		BTreeTupleSetPosting(result, BTreeTupleGetNPosting(itup), keysize);
+		memcpy(BTreeTupleGetPosting(result), BTreeTupleGetPosting(itup),
+			   BTreeTupleGetNPosting(itup) * sizeof(ItemPointerData));
+	}
+	else
+		result->t_tid = itup->t_tid;
+
+	return result;
+}
@@ -112,6 +112,7 @@ bthandler(PG_FUNCTION_ARGS)
 	amroutine->amclusterable = true;
 	amroutine->ampredlocks = true;
 	amroutine->amcanparallel = true;
+	amroutine->amcanbuildparallel = true;
 	amroutine->amcaninclude = true;
 	amroutine->amusemaintenanceworkmem = false;
 	amroutine->amsummarizing = false;
@@ -220,17 +221,18 @@ btgettuple(IndexScanDesc scan, ScanDirection dir)
 	scan->xs_recheck = false;
 
 	/*
-	 * If we have any array keys, initialize them during first call for a
-	 * scan.  We can't do this in btrescan because we don't know the scan
-	 * direction at that time.
+	 * If we have any array keys, or are doing a skip scan, initialize them
+	 * during first call for a scan.  We can't do this in btrescan because we
+	 * don't know the scan direction at that time.
 	 */
-	if (so->numArrayKeys && !BTScanPosIsValid(so->currPos))
+	if ((so->numArrayKeys || so->skipScan) && !BTScanPosIsValid(so->currPos))
 	{
 		/* punt if we have any unsatisfiable array keys */
 		if (so->numArrayKeys < 0)
 			return false;
 
-		_bt_start_array_keys(scan, dir);
+		if (!_bt_start_array_keys(scan, dir))
+			return false;
 	}
 
 	/* This loop handles advancing to the next array elements, if any */
@@ -276,7 +278,8 @@ btgettuple(IndexScanDesc scan, ScanDirection dir)
 		if (res)
 			break;
 		/* ... otherwise see if we have more array keys to deal with */
-	} while (so->numArrayKeys && _bt_advance_array_keys(scan, dir));
+	} while ((so->numArrayKeys || so->skipScan) &&
+			 _bt_advance_array_keys(scan, dir));
 
 	return res;
 }
@@ -292,15 +295,16 @@ btgetbitmap(IndexScanDesc scan, TIDBitmap *tbm)
 	ItemPointer heapTid;
 
 	/*
-	 * If we have any array keys, initialize them.
+	 * If we have any array keys, or are doing a skip scan, initialize them.
 	 */
-	if (so->numArrayKeys)
+	if (so->numArrayKeys || so->skipScan)
 	{
 		/* punt if we have any unsatisfiable array keys */
 		if (so->numArrayKeys < 0)
 			return ntids;
 
-		_bt_start_array_keys(scan, ForwardScanDirection);
+		if (!_bt_start_array_keys(scan, ForwardScanDirection))
+			return ntids;
 	}
 
 	/* This loop handles advancing to the next array elements, if any */
@@ -334,7 +338,8 @@ btgetbitmap(IndexScanDesc scan, TIDBitmap *tbm)
 			}
 		}
 		/* Now see if we have more array keys to deal with */
-	} while (so->numArrayKeys && _bt_advance_array_keys(scan, ForwardScanDirection));
+	} while ((so->numArrayKeys || so->skipScan) &&
+			 _bt_advance_array_keys(scan, ForwardScanDirection));
 
 	return ntids;
 }
@@ -358,8 +363,9 @@ btbeginscan(Relation rel, int nkeys, int norderbys)
 	so = (BTScanOpaque) palloc(sizeof(BTScanOpaqueData));
 	BTScanPosInvalidate(so->currPos);
 	BTScanPosInvalidate(so->markPos);
+	/* leave room for a skip scan's extra key, see _bt_preprocess_array_keys */
 	if (scan->numberOfKeys > 0)
-		so->keyData = (ScanKey) palloc(scan->numberOfKeys * sizeof(ScanKeyData));
+		so->keyData = (ScanKey) palloc((scan->numberOfKeys + 1) * sizeof(ScanKeyData));
 	else
 		so->keyData = NULL;
 
@@ -369,6 +375,14 @@ btbeginscan(Relation rel, int nkeys, int norderbys)
 	so->arrayKeys = NULL;
 	so->arrayContext = NULL;
 
+	so->skipScan = false;		/* until _bt_preprocess_array_keys */
+	so->skipStarted = false;
+	so->skipMarkStarted = false;
+	so->skipStrategy = BTEqualStrategyNumber;
+	so->skipFutile = 0;
+	so->lastLeafPage = InvalidBlockNumber;
+	so->lastLeafMisses = 0;
+
 	so->killedItems = NULL;		/* until needed */
 	so->numKilled = 0;
 
@@ -428,8 +442,10 @@ btrescan(IndexScanDesc scan, ScanKey scankey, int nscankeys,
 	 */
 	if (scan->xs_want_itup && so->currTuples == NULL)
 	{
-		so->currTuples = (char *) palloc(BLCKSZ * 2);
-		so->markTuples = so->currTuples + BLCKSZ;
+		Size		tuplessz = BTScanTuplesSize(scan->indexRelation);
+
+		so->currTuples = (char *) palloc(tuplessz * 2);
+		so->markTuples = so->currTuples + tuplessz;
 	}
 
 	/*
@@ -507,7 +523,7 @@ btmarkpos(IndexScanDesc scan)
 	}
 
 	/* Also record the current positions of any array keys */
-	if (so->numArrayKeys)
+	if (so->numArrayKeys || so->skipScan)
 		_bt_mark_array_keys(scan);
 }
 
@@ -520,7 +536,7 @@ btrestrpos(IndexScanDesc scan)
 	BTScanOpaque so = (BTScanOpaque) scan->opaque;
 
 	/* Restore the marked positions of any array keys */
-	if (so->numArrayKeys)
+	if (so->numArrayKeys || so->skipScan)
 		_bt_restore_array_keys(scan);
 
 	if (so->markItemIndex >= 0)
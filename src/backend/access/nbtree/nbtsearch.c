@@ -21,14 +21,26 @@
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "storage/predicate.h"
+#include "utils/datum.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
+#include "utils/snapmgr.h"
+
+/*
+ * Limits for _bt_search_lastleaf: how many pages it may step right before
+ * giving up, and how many consecutive failures turn it off for the scan.
+ */
+#define BT_LASTLEAF_MAX_STEPS	3
+#define BT_LASTLEAF_MAX_MISSES	8
 
 
 static void _bt_drop_lock_and_maybe_pin(IndexScanDesc scan, BTScanPos sp);
 static OffsetNumber _bt_binsrch(Relation rel, BTScanInsert key, Buffer buf);
 static int	_bt_binsrch_posting(BTScanInsert key, Page page,
 								OffsetNumber offnum);
+static inline int32 _bt_compare_prefix(Relation rel, BTScanInsert key,
+									   Page page, OffsetNumber offnum,
+									   int *prefixatts);
 static bool _bt_readpage(IndexScanDesc scan, ScanDirection dir,
 						 OffsetNumber offnum);
 static void _bt_saveitem(BTScanOpaque so, int itemIndex,
@@ -45,6 +57,7 @@ static bool _bt_parallel_readpage(IndexScanDesc scan, BlockNumber blkno,
 								  ScanDirection dir);
 static Buffer _bt_walk_left(Relation rel, Buffer buf, Snapshot snapshot);
 static bool _bt_endpoint(IndexScanDesc scan, ScanDirection dir);
+static Buffer _bt_search_lastleaf(IndexScanDesc scan, BTScanInsert key);
 static inline void _bt_initialize_more_data(BTScanOpaque so, ScanDirection dir);
 
 
@@ -344,6 +357,12 @@ _bt_moveright(Relation rel,
  * This procedure is not responsible for walking right, it just examines
  * the given page.  _bt_binsrch() has no lock or refcount side effects
  * on the buffer.
+ *
+ * As the search narrows, we keep track of how many leading key attributes
+ * the items at either bound are known to share with the scan key.  Every
+ * item between the bounds must share the shorter of those two prefixes, so
+ * _bt_compare_prefix can skip comparing those attributes.  This matters
+ * for composite keys with long runs of equal leading attributes.
  */
 static OffsetNumber
 _bt_binsrch(Relation rel,
@@ -356,6 +375,8 @@ _bt_binsrch(Relation rel,
 				high;
 	int32		result,
 				cmpval;
+	int			lowatts,
+				highatts;
 
 	page = BufferGetPage(buf);
 	opaque = BTPageGetOpaque(page);
@@ -394,18 +415,28 @@ _bt_binsrch(Relation rel,
 
 	cmpval = key->nextkey ? 0 : 1;	/* select comparison value */
 
+	/* Nothing is known about the items around the page's bounds */
+	lowatts = highatts = 0;
+
 	while (high > low)
 	{
 		OffsetNumber mid = low + ((high - low) / 2);
+		int			prefixatts = Min(lowatts, highatts);
 
 		/* We have low <= mid < high, so mid points at a real slot */
 
-		result = _bt_compare(rel, key, page, mid);
+		result = _bt_compare_prefix(rel, key, page, mid, &prefixatts);
 
 		if (result >= cmpval)
+		{
 			low = mid + 1;
+			lowatts = prefixatts;
+		}
 		else
+		{
 			high = mid;
+			highatts = prefixatts;
+		}
 	}
 
 	/*
@@ -460,6 +491,8 @@ _bt_binsrch_insert(Relation rel, BTInsertState insertstate)
 				stricthigh;
 	int32		result,
 				cmpval;
+	int			lowatts,
+				highatts;
 
 	page = BufferGetPage(insertstate->buf);
 	opaque = BTPageGetOpaque(page);
@@ -507,19 +540,27 @@ _bt_binsrch_insert(Relation rel, BTInsertState insertstate)
 
 	cmpval = 1;					/* !nextkey comparison value */
 
+	/* Skip known-equal leading attributes, as in _bt_binsrch */
+	lowatts = highatts = 0;
+
 	while (high > low)
 	{
 		OffsetNumber mid = low + ((high - low) / 2);
+		int			prefixatts = Min(lowatts, highatts);
 
 		/* We have low <= mid < high, so mid points at a real slot */
 
-		result = _bt_compare(rel, key, page, mid);
+		result = _bt_compare_prefix(rel, key, page, mid, &prefixatts);
 
 		if (result >= cmpval)
+		{
 			low = mid + 1;
+			lowatts = prefixatts;
+		}
 		else
 		{
 			high = mid;
+			highatts = prefixatts;
 			if (result != 0)
 				stricthigh = high;
 		}
@@ -668,6 +709,30 @@ _bt_compare(Relation rel,
 			BTScanInsert key,
 			Page page,
 			OffsetNumber offnum)
+{
+	int			prefixatts = 0;
+
+	return _bt_compare_prefix(rel, key, page, offnum, &prefixatts);
+}
+
+/*
+ *	_bt_compare_prefix() -- _bt_compare(), skipping known-equal attributes.
+ *
+ * On entry, *prefixatts is the number of leading key attributes that the
+ * caller already knows to be equal between the scankey and the tuple, which
+ * aren't compared again.  On exit, it's the number of leading key
+ * attributes found to be equal, not counting the heap TID.
+ *
+ * The attribute prefix only saves comparisons.  It has nothing to do with
+ * the key prefix of leaf pages that use prefix compression, which
+ * _bt_prefix_cmp() deals with.
+ */
+static inline int32
+_bt_compare_prefix(Relation rel,
+				   BTScanInsert key,
+				   Page page,
+				   OffsetNumber offnum,
+				   int *prefixatts)
 {
 	TupleDesc	itupdesc = RelationGetDescr(rel);
 	BTPageOpaque opaque = BTPageGetOpaque(page);
@@ -676,6 +741,7 @@ _bt_compare(Relation rel,
 	ScanKey		scankey;
 	int			ncmpkey;
 	int			ntupatts;
+	bool		stripped;
 	int32		result;
 
 	Assert(_bt_check_natts(rel, key->heapkeyspace, page, offnum));
@@ -687,10 +753,14 @@ _bt_compare(Relation rel,
 	 * --- see NOTE above.
 	 */
 	if (!P_ISLEAF(opaque) && offnum == P_FIRSTDATAKEY(opaque))
+	{
+		*prefixatts = 0;
 		return 1;
+	}
 
 	itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, offnum));
 	ntupatts = BTreeTupleGetNAtts(itup, rel);
+	stripped = P_HAS_PREFIX(opaque) && offnum >= P_FIRSTDATAKEY(opaque);
 
 	/*
 	 * The scan key is set up with the attribute number associated with each
@@ -707,8 +777,9 @@ _bt_compare(Relation rel,
 	ncmpkey = Min(ntupatts, key->keysz);
 	Assert(key->heapkeyspace || ncmpkey == key->keysz);
 	Assert(!BTreeTupleIsPosting(itup) || key->allequalimage);
-	scankey = key->scankeys;
-	for (int i = 1; i <= ncmpkey; i++)
+	Assert(*prefixatts >= 0 && *prefixatts <= ncmpkey);
+	scankey = key->scankeys + *prefixatts;
+	for (int i = *prefixatts + 1; i <= ncmpkey; i++)
 	{
 		Datum		datum;
 		bool		isNull;
@@ -740,11 +811,16 @@ _bt_compare(Relation rel,
 			 * _bt_compare as comparing the scankey to the index item, we have
 			 * to flip the sign of the comparison result.  (Unless it's a DESC
 			 * column, in which case we *don't* flip the sign.)
+			 *
+			 * Leaf tuples on a page with a key prefix are stored without it.
 			 */
-			result = DatumGetInt32(FunctionCall2Coll(&scankey->sk_func,
-													 scankey->sk_collation,
-													 datum,
-													 scankey->sk_argument));
+			if (i == 1 && stripped)
+				result = _bt_prefix_cmp(rel, page, datum, scankey);
+			else
+				result = DatumGetInt32(FunctionCall2Coll(&scankey->sk_func,
+														 scankey->sk_collation,
+														 datum,
+														 scankey->sk_argument));
 
 			if (!(scankey->sk_flags & SK_BT_DESC))
 				INVERT_COMPARE_RESULT(result);
@@ -752,10 +828,14 @@ _bt_compare(Relation rel,
 
 		/* if the keys are unequal, return the difference */
 		if (result != 0)
+		{
+			*prefixatts = i - 1;
 			return result;
+		}
 
 		scankey++;
 	}
+	*prefixatts = ncmpkey;
 
 	/*
 	 * All non-truncated attributes (other than heap TID) were found to be
@@ -1372,12 +1452,19 @@ _bt_first(IndexScanDesc scan, ScanDirection dir)
 
 	/*
 	 * Use the manufactured insertion scan key to descend the tree and
-	 * position ourselves on the target leaf page.
+	 * position ourselves on the target leaf page.  Successive primitive
+	 * scans often start at or near the leaf page the last one read, so try
+	 * that first.
 	 */
-	stack = _bt_search(rel, NULL, &inskey, &buf, BT_READ, scan->xs_snapshot);
+	buf = _bt_search_lastleaf(scan, &inskey);
+	if (!BufferIsValid(buf))
+	{
+		stack = _bt_search(rel, NULL, &inskey, &buf, BT_READ,
+						   scan->xs_snapshot);
 
-	/* don't need to keep the stack around... */
-	_bt_freestack(stack);
+		/* don't need to keep the stack around... */
+		_bt_freestack(stack);
+	}
 
 	if (!BufferIsValid(buf))
 	{
@@ -1550,6 +1637,7 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 	OffsetNumber maxoff;
 	int			itemIndex;
 	bool		continuescan;
+	bool		prefixed;
 	int			indnatts;
 
 	/*
@@ -1575,12 +1663,22 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 	minoff = P_FIRSTDATAKEY(opaque);
 	maxoff = PageGetMaxOffsetNumber(page);
 
+	/*
+	 * Tuples on a page with a key prefix are checked and saved with the
+	 * prefix put back, so that _bt_checkkeys and index-only scans see whole
+	 * tuples.
+	 */
+	prefixed = P_HAS_PREFIX(opaque);
+
 	/*
 	 * We note the buffer's block number so that we can release the pin later.
 	 * This allows us to re-read the buffer if it is needed again for hinting.
 	 */
 	so->currPos.currPage = BufferGetBlockNumber(so->currPos.buf);
 
+	/* The next primitive scan may well start here; see _bt_search_lastleaf */
+	so->lastLeafPage = so->currPos.currPage;
+
 	/*
 	 * We save the LSN of the page as we read it, so that we know whether it
 	 * safe to apply LP_DEAD hints to the page later.  This allows us to drop
@@ -1627,6 +1725,8 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 			}
 
 			itup = (IndexTuple) PageGetItem(page, iid);
+			if (prefixed)
+				itup = _bt_prefix_expand(scan->indexRelation, page, itup);
 
 			if (_bt_checkkeys(scan, itup, indnatts, dir, &continuescan))
 			{
@@ -1660,6 +1760,8 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 					}
 				}
 			}
+			if (itup != (IndexTuple) PageGetItem(page, iid))
+				pfree(itup);
 			/* When !continuescan, there can't be any more matches, so stop */
 			if (!continuescan)
 				break;
@@ -1735,6 +1837,8 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 				tuple_alive = true;
 
 			itup = (IndexTuple) PageGetItem(page, iid);
+			if (prefixed)
+				itup = _bt_prefix_expand(scan->indexRelation, page, itup);
 
 			passes_quals = _bt_checkkeys(scan, itup, indnatts, dir,
 										 &continuescan);
@@ -1776,6 +1880,8 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 					}
 				}
 			}
+			if (itup != (IndexTuple) PageGetItem(page, iid))
+				pfree(itup);
 			if (!continuescan)
 			{
 				/* there can't be any more matches, so stop */
@@ -2496,6 +2602,256 @@ _bt_endpoint(IndexScanDesc scan, ScanDirection dir)
 	return true;
 }
 
+/*
+ *	_bt_skip_probe() -- Find the next value of the first index column for a
+ * skip scan.
+ *
+ * Finds the first index entry, in the scan direction, whose first column is
+ * past the scan's current value (so->skipValue and so->skipIsNull), or the
+ * first entry in the index if the scan has no current value yet, and makes
+ * that entry's first column value the current one.  NULL counts as a value
+ * of its own, placed wherever the index puts nulls.  Returns false if there
+ * are no more values.
+ *
+ * This only looks at the first column of index entries, so it may well find
+ * a value with no matching entries, or only dead ones.  The primitive scan
+ * for that value will then just come up empty.
+ */
+bool
+_bt_skip_probe(IndexScanDesc scan, ScanDirection dir)
+{
+	Relation	rel = scan->indexRelation;
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Form_pg_attribute att = TupleDescAttr(RelationGetDescr(rel), 0);
+	Buffer		buf = InvalidBuffer;
+	Page		page;
+	BTPageOpaque opaque;
+	OffsetNumber offnum;
+	IndexTuple	itup;
+	Datum		value;
+	bool		isnull;
+	MemoryContext oldcxt;
+
+	Assert(so->skipScan);
+
+	if (!so->skipStarted)
+	{
+		/* Start at whichever end of the index the scan starts at */
+		buf = _bt_get_endpoint(rel, 0, ScanDirectionIsBackward(dir),
+							   scan->xs_snapshot);
+		if (!BufferIsValid(buf))
+		{
+			/* Empty index, see _bt_endpoint */
+			PredicateLockRelation(rel, scan->xs_snapshot);
+			return false;
+		}
+		page = BufferGetPage(buf);
+		opaque = BTPageGetOpaque(page);
+		if (ScanDirectionIsForward(dir))
+			offnum = P_FIRSTDATAKEY(opaque);
+		else
+			offnum = PageGetMaxOffsetNumber(page);
+	}
+	else
+	{
+		BTScanInsertData inskey;
+		ScanKey		skey = &inskey.scankeys[0];
+		int			flags;
+
+		/*
+		 * Build an insertion scankey on the current value.  A forward scan
+		 * wants the first entry > value.  A backward scan wants the last
+		 * entry < value, which is the one before the first entry >= value.
+		 */
+		flags = rel->rd_indoption[0] << SK_BT_INDOPTION_SHIFT;
+		if (so->skipIsNull)
+			ScanKeyEntryInitialize(skey, flags | SK_ISNULL, 1,
+								   InvalidStrategy, InvalidOid, InvalidOid,
+								   InvalidOid, (Datum) 0);
+		else
+			ScanKeyEntryInitializeWithInfo(skey, flags, 1, InvalidStrategy,
+										   InvalidOid,
+										   rel->rd_indcollation[0],
+										   index_getprocinfo(rel, 1, BTORDER_PROC),
+										   so->skipValue);
+
+		_bt_metaversion(rel, &inskey.heapkeyspace, &inskey.allequalimage);
+		inskey.anynullkeys = false; /* unused */
+		inskey.nextkey = ScanDirectionIsForward(dir);
+		inskey.pivotsearch = false;
+		inskey.scantid = NULL;
+		inskey.keysz = 1;
+
+		buf = _bt_search_lastleaf(scan, &inskey);
+		if (!BufferIsValid(buf))
+		{
+			BTStack		stack;
+
+			stack = _bt_search(rel, NULL, &inskey, &buf, BT_READ,
+							   scan->xs_snapshot);
+			_bt_freestack(stack);
+			if (!BufferIsValid(buf))
+			{
+				/* Index has been emptied out meanwhile */
+				PredicateLockRelation(rel, scan->xs_snapshot);
+				return false;
+			}
+		}
+
+		offnum = _bt_binsrch(rel, &inskey, buf);
+		if (ScanDirectionIsBackward(dir))
+			offnum = OffsetNumberPrev(offnum);
+	}
+
+	/*
+	 * If we're positioned off the end of the page, or the page is dead, move
+	 * on to the next page in the scan direction.
+	 */
+	for (;;)
+	{
+		page = BufferGetPage(buf);
+		opaque = BTPageGetOpaque(page);
+
+		if (ScanDirectionIsForward(dir))
+		{
+			if (!P_IGNORE(opaque) && offnum <= PageGetMaxOffsetNumber(page))
+				break;
+			if (P_RIGHTMOST(opaque))
+			{
+				PredicateLockPage(rel, BufferGetBlockNumber(buf),
+								  scan->xs_snapshot);
+				_bt_relbuf(rel, buf);
+				return false;
+			}
+			buf = _bt_relandgetbuf(rel, buf, opaque->btpo_next, BT_READ);
+			page = BufferGetPage(buf);
+			TestForOldSnapshot(scan->xs_snapshot, rel, page);
+			offnum = P_FIRSTDATAKEY(BTPageGetOpaque(page));
+		}
+		else
+		{
+			if (!P_IGNORE(opaque) && offnum >= P_FIRSTDATAKEY(opaque))
+				break;
+			if (P_LEFTMOST(opaque))
+				PredicateLockPage(rel, BufferGetBlockNumber(buf),
+								  scan->xs_snapshot);
+			buf = _bt_walk_left(rel, buf, scan->xs_snapshot);
+			if (!BufferIsValid(buf))
+				return false;
+			offnum = PageGetMaxOffsetNumber(BufferGetPage(buf));
+		}
+	}
+
+	/*
+	 * The primitive scan for this value will read this page again, but lock
+	 * it now anyway, since we're relying on the absence of values between
+	 * the old one and this one.
+	 */
+	PredicateLockPage(rel, BufferGetBlockNumber(buf), scan->xs_snapshot);
+
+	itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, offnum));
+	itup = _bt_prefix_expand(rel, page, itup);
+	value = index_getattr(itup, 1, RelationGetDescr(rel), &isnull);
+
+	/* Save a copy of the new value, replacing the old one */
+	oldcxt = MemoryContextSwitchTo(so->arrayContext);
+	if (so->skipStarted && !so->skipIsNull && !att->attbyval)
+		pfree(DatumGetPointer(so->skipValue));
+	so->skipIsNull = isnull;
+	so->skipValue = isnull ? (Datum) 0 :
+		datumCopy(value, att->attbyval, att->attlen);
+	so->skipStarted = true;
+	MemoryContextSwitchTo(oldcxt);
+	if (itup != (IndexTuple) PageGetItem(page, PageGetItemId(page, offnum)))
+		pfree(itup);
+
+	so->lastLeafPage = BufferGetBlockNumber(buf);
+	_bt_relbuf(rel, buf);
+
+	return true;
+}
+
+/*
+ *	_bt_search_lastleaf() -- Try to find the leaf page for an insertion scan
+ * key without descending the tree.
+ *
+ * The primitive scans of a scan with array keys, or of a skip scan, visit
+ * the index in key order, as do the rescans of a nestloop's inner index
+ * scan when the outer side is sorted on the join key.  Each of them usually
+ * starts on the leaf page the previous one read, or a page or two to its
+ * right.  So rather than descending from the root, look at that leaf page:
+ * if its first item is before the key and its high key isn't, it's the page
+ * _bt_search would have landed on.  If the key is past the high key, walk
+ * right a few pages the same way _bt_moveright does.  Return the target
+ * page pinned and read-locked, or InvalidBuffer if it wasn't found, in which
+ * case the caller descends from the root as usual.
+ *
+ * After BT_LASTLEAF_MAX_MISSES failures in a row, we conclude that the keys
+ * arrive in no useful order and stop trying.
+ *
+ * This is only done for non-parallel MVCC scans.  An MVCC snapshot ensures
+ * that the page can't have been recycled since we read it.
+ */
+static Buffer
+_bt_search_lastleaf(IndexScanDesc scan, BTScanInsert key)
+{
+	Relation	rel = scan->indexRelation;
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	int			cmpval = key->nextkey ? 0 : 1;
+	Buffer		buf;
+	Page		page;
+	BTPageOpaque opaque;
+	int			steps;
+
+	if (!BlockNumberIsValid(so->lastLeafPage) ||
+		so->lastLeafMisses >= BT_LASTLEAF_MAX_MISSES ||
+		scan->parallel_scan != NULL ||
+		!IsMVCCSnapshot(scan->xs_snapshot))
+		return InvalidBuffer;
+
+	buf = _bt_getbuf(rel, so->lastLeafPage, BT_READ);
+	page = BufferGetPage(buf);
+	TestForOldSnapshot(scan->xs_snapshot, rel, page);
+	opaque = BTPageGetOpaque(page);
+
+	/*
+	 * The key must be after the page's first item, as otherwise the target
+	 * could be on an earlier page.  Just give up if the page is empty.
+	 */
+	if (!P_ISLEAF(opaque) || P_IGNORE(opaque) ||
+		(!P_LEFTMOST(opaque) &&
+		 (P_FIRSTDATAKEY(opaque) > PageGetMaxOffsetNumber(page) ||
+		  _bt_compare(rel, key, page, P_FIRSTDATAKEY(opaque)) < cmpval)))
+	{
+		_bt_relbuf(rel, buf);
+		so->lastLeafMisses++;
+		return InvalidBuffer;
+	}
+
+	/* Move right while the key is past the high key, as _bt_moveright does */
+	for (steps = 0;; steps++)
+	{
+		if (!P_IGNORE(opaque) &&
+			(P_RIGHTMOST(opaque) ||
+			 _bt_compare(rel, key, page, P_HIKEY) < cmpval))
+		{
+			so->lastLeafMisses = 0;
+			return buf;
+		}
+		if (P_RIGHTMOST(opaque) || steps >= BT_LASTLEAF_MAX_STEPS)
+			break;
+
+		buf = _bt_relandgetbuf(rel, buf, opaque->btpo_next, BT_READ);
+		page = BufferGetPage(buf);
+		TestForOldSnapshot(scan->xs_snapshot, rel, page);
+		opaque = BTPageGetOpaque(page);
+	}
+
+	_bt_relbuf(rel, buf);
+	so->lastLeafMisses++;
+	return InvalidBuffer;
+}
+
 /*
  * _bt_initialize_more_data() -- initialize moreLeft/moreRight appropriately
  * for scan direction
@@ -241,6 +241,8 @@ typedef struct BTPageState
 	Size		btps_lastextra; /* last item's extra posting list space */
 	uint32		btps_level;		/* tree level (0 = leaf) */
 	Size		btps_full;		/* "full" if less than this much free space */
+	int			btps_prefixlen; /* length of leaf page's key prefix, or 0 */
+	char		btps_prefix[BT_MAX_PREFIX_LEN]; /* leaf page's key prefix */
 	struct BTPageState *btps_next;	/* link to parent level, if any */
 } BTPageState;
 
@@ -253,6 +255,7 @@ typedef struct BTWriteState
 	Relation	index;
 	BTScanInsert inskey;		/* generic insertion scankey */
 	bool		btws_use_wal;	/* dump pages to WAL? */
+	bool		btws_prefix;	/* give leaf pages key prefixes? */
 	BlockNumber btws_pages_alloced; /* # pages allocated */
 	BlockNumber btws_pages_written; /* # pages written out */
 	Page		btws_zeropage;	/* workspace for filling zeroes */
@@ -267,12 +270,17 @@ static void _bt_spool(BTSpool *btspool, ItemPointer self,
 static void _bt_leafbuild(BTSpool *btspool, BTSpool *btspool2);
 static void _bt_build_callback(Relation index, ItemPointer tid, Datum *values,
 							   bool *isnull, bool tupleIsAlive, void *state);
-static Page _bt_blnewpage(uint32 level);
+static Page _bt_blnewpage(uint32 level, const char *prefix, int prefixlen);
 static BTPageState *_bt_pagestate(BTWriteState *wstate, uint32 level);
 static void _bt_slideleft(Page rightmostpage);
 static void _bt_sortaddtup(Page page, Size itemsize,
 						   IndexTuple itup, OffsetNumber itup_off,
 						   bool newfirstdataitem);
+static bool _bt_sort_reprefix(BTWriteState *wstate, BTPageState *state,
+							  int newlen);
+static IndexTuple _bt_sort_prefix(BTWriteState *wstate, BTPageState *state,
+								  IndexTuple itup);
+static void _bt_buildfinish(BTWriteState *wstate, BTPageState *state);
 static void _bt_buildadd(BTWriteState *wstate, BTPageState *state,
 						 IndexTuple itup, Size truncextra);
 static void _bt_sort_dedup_finish_pending(BTWriteState *wstate,
@@ -570,6 +578,8 @@ _bt_leafbuild(BTSpool *btspool, BTSpool *btspool2)
 	/* _bt_mkscankey() won't set allequalimage without metapage */
 	wstate.inskey->allequalimage = _bt_allequalimage(wstate.index, true);
 	wstate.btws_use_wal = RelationNeedsWAL(wstate.index);
+	wstate.btws_prefix = wstate.inskey->heapkeyspace &&
+		_bt_prefix_enabled(wstate.index);
 
 	/* reserve the metapage */
 	wstate.btws_pages_alloced = BTREE_METAPAGE + 1;
@@ -612,23 +622,32 @@ _bt_build_callback(Relation index,
 
 /*
  * allocate workspace for a new, clean btree page, not linked to any siblings.
+ *
+ * A leaf page gets a key prefix of prefixlen bytes, if prefixlen isn't 0.
  */
 static Page
-_bt_blnewpage(uint32 level)
+_bt_blnewpage(uint32 level, const char *prefix, int prefixlen)
 {
 	Page		page;
 	BTPageOpaque opaque;
 
+	Assert(level == 0 || prefixlen == 0);
+
 	page = (Page) palloc_aligned(BLCKSZ, PG_IO_ALIGN_SIZE, 0);
 
 	/* Zero the page and set up standard page header info */
-	_bt_pageinit(page, BLCKSZ);
+	if (level > 0)
+		_bt_pageinit(page, BLCKSZ);
+	else
+		_bt_pageinit_prefix(page, BLCKSZ, prefix, prefixlen);
 
 	/* Initialize BT opaque state */
 	opaque = BTPageGetOpaque(page);
 	opaque->btpo_prev = opaque->btpo_next = P_NONE;
 	opaque->btpo_level = level;
 	opaque->btpo_flags = (level > 0) ? 0 : BTP_LEAF;
+	if (prefixlen > 0)
+		opaque->btpo_flags |= BTP_PREFIX;
 	opaque->btpo_cycleid = 0;
 
 	/* Make the P_HIKEY line pointer appear allocated */
@@ -703,7 +722,7 @@ _bt_pagestate(BTWriteState *wstate, uint32 level)
 	BTPageState *state = (BTPageState *) palloc0(sizeof(BTPageState));
 
 	/* create initial page for level */
-	state->btps_page = _bt_blnewpage(level);
+	state->btps_page = _bt_blnewpage(level, NULL, 0);
 
 	/* and assign it a page position */
 	state->btps_blkno = wstate->btws_pages_alloced++;
@@ -719,6 +738,9 @@ _bt_pagestate(BTWriteState *wstate, uint32 level)
 	else
 		state->btps_full = BTGetTargetPageFreeSpace(wstate->index);
 
+	/* the first page of a level is leftmost, and has no key prefix */
+	state->btps_prefixlen = 0;
+
 	/* no parent level, yet */
 	state->btps_next = NULL;
 
@@ -788,6 +810,318 @@ _bt_sortaddtup(Page page,
 		elog(ERROR, "failed to add item to the index page");
 }
 
+/*
+ * Rebuild the leaf page that state is building with a key prefix of newlen
+ * bytes (0 for none), putting back or stripping the bytes that the old and
+ * new prefixes don't have in common.  state->btps_prefix holds the longer of
+ * the two prefixes.
+ *
+ * Returns false, leaving the page alone, when its tuples don't fit on the
+ * page with the new prefix along with the space needed to finish it off.
+ */
+static bool
+_bt_sort_reprefix(BTWriteState *wstate, BTPageState *state, int newlen)
+{
+	Page		opage = state->btps_page;
+	Page		npage;
+	BTPageOpaque oopaque = BTPageGetOpaque(opage);
+	BTPageOpaque nopaque;
+	Size		reserved = BTPrefixReservedSpace(newlen);
+	OffsetNumber off;
+
+	Assert(state->btps_level == 0 && state->btps_lastoff >= P_FIRSTKEY);
+
+	npage = _bt_blnewpage(0, state->btps_prefix, newlen);
+	nopaque = BTPageGetOpaque(npage);
+	nopaque->btpo_prev = oopaque->btpo_prev;
+	nopaque->btpo_next = oopaque->btpo_next;
+
+	for (off = P_FIRSTKEY; off <= state->btps_lastoff; off = OffsetNumberNext(off))
+	{
+		IndexTuple	itup = (IndexTuple) PageGetItem(opage,
+												   PageGetItemId(opage, off));
+		IndexTuple	newitup;
+		Size		itemsz;
+		bool		fits;
+
+		newitup = _bt_prefix_convert(wstate->index, itup, state->btps_prefix,
+									 state->btps_prefixlen, newlen);
+		itemsz = MAXALIGN(IndexTupleSize(newitup));
+		fits = itemsz <= BTMaxItemSizeReserved(npage, reserved) &&
+			PageAddItem(npage, (Item) newitup, itemsz, off,
+						false, false) != InvalidOffsetNumber;
+		if (newitup != itup)
+			pfree(newitup);
+		if (!fits)
+		{
+			pfree(npage);
+			return false;
+		}
+	}
+
+	/* Leave room for the high key, as _bt_buildadd does */
+	if (PageGetFreeSpace(npage) < MAXALIGN(sizeof(ItemPointerData)) +
+		(newlen > 0 ? BTPrefixMaxGrowth(newlen) : 0))
+	{
+		pfree(npage);
+		return false;
+	}
+
+	pfree(opage);
+	state->btps_page = npage;
+	state->btps_prefixlen = newlen;
+
+	return true;
+}
+
+/*
+ * Return leaf tuple itup as it is to be stored on the page that state is
+ * building: with the page's key prefix stripped.
+ *
+ * Every key on a page with a prefix must begin with it.  The page's prefix
+ * starts out as what its low key and its first tuple have in common (see
+ * _bt_buildfinish), and since the input is sorted, each new tuple that
+ * doesn't begin with the whole prefix makes it shorter for good.  The page
+ * is rebuilt with the shorter prefix then; if its tuples no longer fit, we
+ * finish it off with the prefix it has, and move on to the next page.  The
+ * page's high key begins with its prefix either way, because the high key
+ * has the first attribute of the page's last tuple.
+ *
+ * Tuples too large for a page without a prefix go on one without a prefix,
+ * so that _bt_buildadd() rejects them just like it would without prefix
+ * compression.
+ */
+static IndexTuple
+_bt_sort_prefix(BTWriteState *wstate, BTPageState *state, IndexTuple itup)
+{
+	Relation	rel = wstate->index;
+	IndexTuple	pageitup = itup;
+
+	while (state->btps_prefixlen > 0)
+	{
+		Page		page = state->btps_page;
+		int			newlen;
+
+		newlen = _bt_prefix_match(rel, itup, state->btps_prefix,
+								  state->btps_prefixlen);
+		if (newlen < BT_MIN_PREFIX_LEN)
+			newlen = 0;
+		else
+		{
+			pageitup = _bt_prefix_convert(rel, itup, state->btps_prefix,
+										  0, newlen);
+			if (MAXALIGN(IndexTupleSize(itup)) >
+				BTMaxItemSizeReserved(page, BTPrefixReservedSpace(0)) ||
+				MAXALIGN(IndexTupleSize(pageitup)) >
+				BTMaxItemSizeReserved(page, BTPrefixReservedSpace(newlen)))
+				newlen = 0;
+		}
+
+		if (newlen > 0 && (newlen == state->btps_prefixlen ||
+						   _bt_sort_reprefix(wstate, state, newlen)))
+			break;
+
+		if (pageitup != itup)
+			pfree(pageitup);
+		pageitup = itup;
+
+		if (newlen == 0 && _bt_sort_reprefix(wstate, state, 0))
+			break;
+
+		/*
+		 * The page's tuples don't fit with the shorter prefix.  A page with
+		 * a single tuple always has room for it without a prefix, though.
+		 */
+		if (state->btps_lastoff == P_FIRSTKEY)
+		{
+			if (!_bt_sort_reprefix(wstate, state, 0))
+				elog(ERROR, "failed to add item to the index page");
+			break;
+		}
+		_bt_buildfinish(wstate, state);
+	}
+
+	return pageitup;
+}
+
+/*
+ * Finish off the page that state is building and write it out, and start a
+ * new page of the same level, holding the old page's last item.
+ */
+static void
+_bt_buildfinish(BTWriteState *wstate, BTPageState *state)
+{
+	Page		opage = state->btps_page;
+	BlockNumber oblkno = state->btps_blkno;
+	OffsetNumber last_off = state->btps_lastoff;
+	bool		isleaf = (state->btps_level == 0);
+	Page		npage;
+	BlockNumber nblkno;
+	ItemId		ii;
+	ItemId		hii;
+	IndexTuple	oitup;
+	IndexTuple	firstright;
+	Size		itemsz;
+
+	/* Create new page of same level */
+	npage = _bt_blnewpage(state->btps_level, NULL, 0);
+
+	/* and assign it a page position */
+	nblkno = wstate->btws_pages_alloced++;
+
+	/*
+	 * We copy the last item on the page into the new page, and then
+	 * rearrange the old page so that the 'last item' becomes its high key
+	 * rather than a true data item.  There had better be at least two items
+	 * on the page already, else the page would be empty of useful data.
+	 *
+	 * The new page has no key prefix yet, so a tuple from a leaf page with
+	 * one goes there with the prefix put back.  _bt_truncate() gets whole
+	 * tuples too, since high keys are stored whole.
+	 */
+	Assert(last_off > P_FIRSTKEY);
+	ii = PageGetItemId(opage, last_off);
+	oitup = (IndexTuple) PageGetItem(opage, ii);
+	firstright = oitup;
+	itemsz = ItemIdGetLength(ii);
+	if (state->btps_prefixlen > 0)
+	{
+		firstright = _bt_prefix_convert(wstate->index, oitup,
+										state->btps_prefix,
+										state->btps_prefixlen, 0);
+		itemsz = MAXALIGN(IndexTupleSize(firstright));
+	}
+	_bt_sortaddtup(npage, itemsz, firstright, P_FIRSTKEY, !isleaf);
+
+	/*
+	 * Move 'last' into the high key position on opage.  _bt_blnewpage()
+	 * allocated empty space for a line pointer when opage was first created,
+	 * so this is a matter of rearranging already-allocated space on page,
+	 * and initializing high key line pointer. (Actually, leaf pages must
+	 * also swap oitup with a truncated version of oitup, which is sometimes
+	 * larger than oitup, though never by more than the space needed to
+	 * append a heap TID, plus the key prefix when the page has one.)
+	 */
+	hii = PageGetItemId(opage, P_HIKEY);
+	*hii = *ii;
+	ItemIdSetUnused(ii);		/* redundant */
+	((PageHeader) opage)->pd_lower -= sizeof(ItemIdData);
+
+	if (isleaf)
+	{
+		IndexTuple	pagelastleft;
+		IndexTuple	lastleft;
+		IndexTuple	truncated;
+
+		/*
+		 * Truncate away any unneeded attributes from high key on leaf level.
+		 * This is only done at the leaf level because downlinks in internal
+		 * pages are either negative infinity items, or get their contents
+		 * from copying from one level down.  See also: _bt_split().
+		 *
+		 * We don't try to bias our choice of split point to make it more
+		 * likely that _bt_truncate() can truncate away more attributes,
+		 * whereas the split point used within _bt_split() is chosen much more
+		 * delicately.  Even still, the lastleft and firstright tuples passed
+		 * to _bt_truncate() here are at least not fully equal to each other
+		 * when deduplication is used, unless there is a large group of
+		 * duplicates (also, unique index builds usually have few or no spool2
+		 * duplicates).  When the split point is between two unequal tuples,
+		 * _bt_truncate() will avoid including a heap TID in the new high key,
+		 * which is the most important benefit of suffix truncation.
+		 *
+		 * Overwrite the old item with new truncated high key directly.  oitup
+		 * is already located at the physical beginning of tuple space, so
+		 * this should directly reuse the existing tuple space.
+		 */
+		ii = PageGetItemId(opage, OffsetNumberPrev(last_off));
+		pagelastleft = (IndexTuple) PageGetItem(opage, ii);
+		lastleft = pagelastleft;
+		if (state->btps_prefixlen > 0)
+			lastleft = _bt_prefix_convert(wstate->index, pagelastleft,
+										  state->btps_prefix,
+										  state->btps_prefixlen, 0);
+
+		Assert(IndexTupleSize(firstright) > state->btps_lastextra);
+		truncated = _bt_truncate(wstate->index, lastleft, firstright,
+								 wstate->inskey);
+		if (!PageIndexTupleOverwrite(opage, P_HIKEY, (Item) truncated,
+									 IndexTupleSize(truncated)))
+			elog(ERROR, "failed to add high key to the index page");
+		pfree(truncated);
+		if (lastleft != pagelastleft)
+			pfree(lastleft);
+		if (firstright != oitup)
+			pfree(firstright);
+
+		/* oitup should continue to point to the page's high key */
+		hii = PageGetItemId(opage, P_HIKEY);
+		oitup = (IndexTuple) PageGetItem(opage, hii);
+	}
+
+	/*
+	 * Link the old page into its parent, using its low key.  If we don't
+	 * have a parent, we have to create one; this adds a new btree level.
+	 */
+	if (state->btps_next == NULL)
+		state->btps_next = _bt_pagestate(wstate, state->btps_level + 1);
+
+	Assert((BTreeTupleGetNAtts(state->btps_lowkey, wstate->index) <=
+			IndexRelationGetNumberOfKeyAttributes(wstate->index) &&
+			BTreeTupleGetNAtts(state->btps_lowkey, wstate->index) > 0) ||
+		   P_LEFTMOST(BTPageGetOpaque(opage)));
+	Assert(BTreeTupleGetNAtts(state->btps_lowkey, wstate->index) == 0 ||
+		   !P_LEFTMOST(BTPageGetOpaque(opage)));
+	BTreeTupleSetDownLink(state->btps_lowkey, oblkno);
+	_bt_buildadd(wstate, state->btps_next, state->btps_lowkey, 0);
+	pfree(state->btps_lowkey);
+
+	/*
+	 * Save a copy of the high key from the old page.  It is also the low
+	 * key for the new page.
+	 */
+	state->btps_lowkey = CopyIndexTuple(oitup);
+
+	/*
+	 * Set the sibling links for both pages.
+	 */
+	{
+		BTPageOpaque oopaque = BTPageGetOpaque(opage);
+		BTPageOpaque nopaque = BTPageGetOpaque(npage);
+
+		oopaque->btpo_next = nblkno;
+		nopaque->btpo_prev = oblkno;
+		nopaque->btpo_next = P_NONE;	/* redundant */
+	}
+
+	/*
+	 * Write out the old page.  We never need to touch it again, so we can
+	 * free the opage workspace too.
+	 */
+	_bt_blwritepage(wstate, opage, oblkno);
+
+	state->btps_page = npage;
+	state->btps_blkno = nblkno;
+	state->btps_lastoff = P_FIRSTKEY;
+
+	/*
+	 * Give a new leaf page the key prefix that its low key has in common
+	 * with its first tuple, if it's long enough to be worth having.
+	 */
+	state->btps_prefixlen = 0;
+	if (isleaf && wstate->btws_prefix)
+	{
+		int			newlen;
+
+		ii = PageGetItemId(npage, P_FIRSTKEY);
+		newlen = _bt_prefix_common(wstate->index, state->btps_lowkey,
+								   (IndexTuple) PageGetItem(npage, ii),
+								   state->btps_prefix);
+		if (newlen > 0)
+			(void) _bt_sort_reprefix(wstate, state, newlen);
+	}
+}
+
 /*----------
  * Add an item to a disk page from the sort output (or add a posting list
  * item formed from the sort output).
@@ -839,6 +1173,7 @@ static void
 _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup,
 			 Size truncextra)
 {
+	IndexTuple	pageitup;
 	Page		npage;
 	BlockNumber nblkno;
 	OffsetNumber last_off;
@@ -853,14 +1188,22 @@ _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup,
 	 */
 	CHECK_FOR_INTERRUPTS();
 
+	/*
+	 * On a leaf page with a key prefix, the new item is stored with the
+	 * prefix stripped.  That may first take making the page's prefix
+	 * shorter, or even finishing off the page.
+	 */
+	pageitup = itup;
+	if (state->btps_prefixlen > 0)
+		pageitup = _bt_sort_prefix(wstate, state, itup);
+
 	npage = state->btps_page;
 	nblkno = state->btps_blkno;
 	last_off = state->btps_lastoff;
 	last_truncextra = state->btps_lastextra;
-	state->btps_lastextra = truncextra;
 
 	pgspc = PageGetFreeSpace(npage);
-	itupsz = IndexTupleSize(itup);
+	itupsz = IndexTupleSize(pageitup);
 	itupsz = MAXALIGN(itupsz);
 	/* Leaf case has slightly different rules due to suffix truncation */
 	isleaf = (state->btps_level == 0);
@@ -882,11 +1225,13 @@ _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup,
 	 */
 	if (unlikely(itupsz > BTMaxItemSize(npage)))
 		_bt_check_third_page(wstate->index, wstate->heap, isleaf, npage,
-							 itup);
+							 pageitup);
 
 	/*
 	 * Check to see if current page will fit new item, with space left over to
 	 * append a heap TID during suffix truncation when page is a leaf page.
+	 * When the leaf page has a key prefix, the new high key is made from
+	 * tuples with the prefix put back, so leave room for that too.
 	 *
 	 * It is guaranteed that we can fit at least 2 non-pivot tuples plus a
 	 * high key with heap TID when finishing off a leaf page, since we rely on
@@ -903,140 +1248,26 @@ _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup,
 	 * when applying soft limit, except when last tuple has a posting list.)
 	 */
 	Assert(last_truncextra == 0 || isleaf);
-	if (pgspc < itupsz + (isleaf ? MAXALIGN(sizeof(ItemPointerData)) : 0) ||
+	if (pgspc < itupsz + (isleaf ? MAXALIGN(sizeof(ItemPointerData)) : 0) +
+		(state->btps_prefixlen > 0 ? BTPrefixMaxGrowth(state->btps_prefixlen) : 0) ||
 		(pgspc + last_truncextra < state->btps_full && last_off > P_FIRSTKEY))
 	{
 		/*
 		 * Finish off the page and write it out.
 		 */
-		Page		opage = npage;
-		BlockNumber oblkno = nblkno;
-		ItemId		ii;
-		ItemId		hii;
-		IndexTuple	oitup;
-
-		/* Create new page of same level */
-		npage = _bt_blnewpage(state->btps_level);
-
-		/* and assign it a page position */
-		nblkno = wstate->btws_pages_alloced++;
-
-		/*
-		 * We copy the last item on the page into the new page, and then
-		 * rearrange the old page so that the 'last item' becomes its high key
-		 * rather than a true data item.  There had better be at least two
-		 * items on the page already, else the page would be empty of useful
-		 * data.
-		 */
-		Assert(last_off > P_FIRSTKEY);
-		ii = PageGetItemId(opage, last_off);
-		oitup = (IndexTuple) PageGetItem(opage, ii);
-		_bt_sortaddtup(npage, ItemIdGetLength(ii), oitup, P_FIRSTKEY,
-					   !isleaf);
-
-		/*
-		 * Move 'last' into the high key position on opage.  _bt_blnewpage()
-		 * allocated empty space for a line pointer when opage was first
-		 * created, so this is a matter of rearranging already-allocated space
-		 * on page, and initializing high key line pointer. (Actually, leaf
-		 * pages must also swap oitup with a truncated version of oitup, which
-		 * is sometimes larger than oitup, though never by more than the space
-		 * needed to append a heap TID.)
-		 */
-		hii = PageGetItemId(opage, P_HIKEY);
-		*hii = *ii;
-		ItemIdSetUnused(ii);	/* redundant */
-		((PageHeader) opage)->pd_lower -= sizeof(ItemIdData);
-
-		if (isleaf)
-		{
-			IndexTuple	lastleft;
-			IndexTuple	truncated;
-
-			/*
-			 * Truncate away any unneeded attributes from high key on leaf
-			 * level.  This is only done at the leaf level because downlinks
-			 * in internal pages are either negative infinity items, or get
-			 * their contents from copying from one level down.  See also:
-			 * _bt_split().
-			 *
-			 * We don't try to bias our choice of split point to make it more
-			 * likely that _bt_truncate() can truncate away more attributes,
-			 * whereas the split point used within _bt_split() is chosen much
-			 * more delicately.  Even still, the lastleft and firstright
-			 * tuples passed to _bt_truncate() here are at least not fully
-			 * equal to each other when deduplication is used, unless there is
-			 * a large group of duplicates (also, unique index builds usually
-			 * have few or no spool2 duplicates).  When the split point is
-			 * between two unequal tuples, _bt_truncate() will avoid including
-			 * a heap TID in the new high key, which is the most important
-			 * benefit of suffix truncation.
-			 *
-			 * Overwrite the old item with new truncated high key directly.
-			 * oitup is already located at the physical beginning of tuple
-			 * space, so this should directly reuse the existing tuple space.
-			 */
-			ii = PageGetItemId(opage, OffsetNumberPrev(last_off));
-			lastleft = (IndexTuple) PageGetItem(opage, ii);
-
-			Assert(IndexTupleSize(oitup) > last_truncextra);
-			truncated = _bt_truncate(wstate->index, lastleft, oitup,
-									 wstate->inskey);
-			if (!PageIndexTupleOverwrite(opage, P_HIKEY, (Item) truncated,
-										 IndexTupleSize(truncated)))
-				elog(ERROR, "failed to add high key to the index page");
-			pfree(truncated);
-
-			/* oitup should continue to point to the page's high key */
-			hii = PageGetItemId(opage, P_HIKEY);
-			oitup = (IndexTuple) PageGetItem(opage, hii);
-		}
-
-		/*
-		 * Link the old page into its parent, using its low key.  If we don't
-		 * have a parent, we have to create one; this adds a new btree level.
-		 */
-		if (state->btps_next == NULL)
-			state->btps_next = _bt_pagestate(wstate, state->btps_level + 1);
-
-		Assert((BTreeTupleGetNAtts(state->btps_lowkey, wstate->index) <=
-				IndexRelationGetNumberOfKeyAttributes(wstate->index) &&
-				BTreeTupleGetNAtts(state->btps_lowkey, wstate->index) > 0) ||
-			   P_LEFTMOST(BTPageGetOpaque(opage)));
-		Assert(BTreeTupleGetNAtts(state->btps_lowkey, wstate->index) == 0 ||
-			   !P_LEFTMOST(BTPageGetOpaque(opage)));
-		BTreeTupleSetDownLink(state->btps_lowkey, oblkno);
-		_bt_buildadd(wstate, state->btps_next, state->btps_lowkey, 0);
-		pfree(state->btps_lowkey);
-
-		/*
-		 * Save a copy of the high key from the old page.  It is also the low
-		 * key for the new page.
-		 */
-		state->btps_lowkey = CopyIndexTuple(oitup);
-
-		/*
-		 * Set the sibling links for both pages.
-		 */
-		{
-			BTPageOpaque oopaque = BTPageGetOpaque(opage);
-			BTPageOpaque nopaque = BTPageGetOpaque(npage);
-
-			oopaque->btpo_next = nblkno;
-			nopaque->btpo_prev = oblkno;
-			nopaque->btpo_next = P_NONE;	/* redundant */
-		}
-
-		/*
-		 * Write out the old page.  We never need to touch it again, so we can
-		 * free the opage workspace too.
-		 */
-		_bt_blwritepage(wstate, opage, oblkno);
-
-		/*
-		 * Reset last_off to point to new page
-		 */
-		last_off = P_FIRSTKEY;
+		_bt_buildfinish(wstate, state);
+
+		/* The new page may have a key prefix of its own */
+		if (pageitup != itup)
+			pfree(pageitup);
+		pageitup = itup;
+		if (state->btps_prefixlen > 0)
+			pageitup = _bt_sort_prefix(wstate, state, itup);
+
+		npage = state->btps_page;
+		nblkno = state->btps_blkno;
+		last_off = state->btps_lastoff;
+		itupsz = MAXALIGN(IndexTupleSize(pageitup));
 	}
 
 	/*
@@ -1061,12 +1292,15 @@ _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup,
 	 * Add the new item into the current page.
 	 */
 	last_off = OffsetNumberNext(last_off);
-	_bt_sortaddtup(npage, itupsz, itup, last_off,
+	_bt_sortaddtup(npage, itupsz, pageitup, last_off,
 				   !isleaf && last_off == P_FIRSTKEY);
+	if (pageitup != itup)
+		pfree(pageitup);
 
 	state->btps_page = npage;
 	state->btps_blkno = nblkno;
 	state->btps_lastoff = last_off;
+	state->btps_lastextra = truncextra;
 }
 
 /*
@@ -1126,6 +1360,19 @@ _bt_uppershutdown(BTWriteState *wstate, BTPageState *state)
 		BlockNumber blkno;
 		BTPageOpaque opaque;
 
+		/*
+		 * The rightmost leaf page can't have a key prefix, since there is no
+		 * high key to bound its key space.  Put the prefix back into its
+		 * tuples, finishing the page off first if they don't fit without it.
+		 * That leaves a single tuple on the last page, which always fits.
+		 */
+		if (s->btps_prefixlen > 0 && !_bt_sort_reprefix(wstate, s, 0))
+		{
+			_bt_buildfinish(wstate, s);
+			if (s->btps_prefixlen > 0 && !_bt_sort_reprefix(wstate, s, 0))
+				elog(ERROR, "failed to add item to the index page");
+		}
+
 		blkno = s->btps_blkno;
 		opaque = BTPageGetOpaque(s->btps_page);
 
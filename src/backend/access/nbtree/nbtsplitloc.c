@@ -154,10 +154,22 @@ _bt_findsplitloc(Relation rel,
 	opaque = BTPageGetOpaque(origpage);
 	maxoff = PageGetMaxOffsetNumber(origpage);
 
-	/* Total free space available on a btree page, after fixed overhead */
+	/*
+	 * Total free space available on a btree page, after fixed overhead.  The
+	 * special space is larger on a leaf page with a key prefix, and both new
+	 * pages can keep it.
+	 */
 	leftspace = rightspace =
 		PageGetPageSize(origpage) - SizeOfPageHeaderData -
-		MAXALIGN(sizeof(BTPageOpaqueData));
+		PageGetSpecialSize(origpage);
+
+	/*
+	 * The new high key of the left page is built from tuples with the key
+	 * prefix put back, so it can be larger than the firstright tuple that
+	 * _bt_recsplitloc() accounts for
+	 */
+	if (P_HAS_PREFIX(opaque))
+		leftspace -= (int) BTPrefixMaxGrowth(BTPageGetPrefix(origpage)->bpp_len);
 
 	/* The right page will have the same high key as the old page */
 	if (!P_RIGHTMOST(opaque))
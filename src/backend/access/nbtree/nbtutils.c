@@ -31,6 +31,13 @@
 #include "utils/rel.h"
 
 
+/*
+ * A skip scan gives up skipping after finding this many values in a row on
+ * the leaf page where the previous primitive scan ended; see
+ * _bt_skip_advance.
+ */
+#define BT_SKIP_MAX_FUTILE	8
+
 typedef struct BTSortArrayContext
 {
 	FmgrInfo	flinfo;
@@ -45,6 +52,9 @@ static int	_bt_sort_array_elements(IndexScanDesc scan, ScanKey skey,
 									bool reverse,
 									Datum *elems, int nelems);
 static int	_bt_compare_array_elements(const void *a, const void *b, void *arg);
+static bool _bt_skip_applicable(IndexScanDesc scan, Oid *eqop);
+static bool _bt_skip_advance(IndexScanDesc scan, ScanDirection dir);
+static void _bt_skip_set_key(IndexScanDesc scan);
 static bool _bt_compare_scankey_args(IndexScanDesc scan, ScanKey op,
 									 ScanKey leftarg, ScanKey rightarg,
 									 bool *result);
@@ -202,6 +212,16 @@ _bt_freestack(BTStack stack)
  * array keys, it's sufficient to find the extreme element value and replace
  * the whole array with that scalar value.
  *
+ * This is also where we decide whether to do a skip scan.  If the scan has
+ * no keys on the first index column but has some on the second, it can be
+ * run as a series of primitive index scans, one for each distinct value of
+ * the first column, each of which can position itself using the keys on the
+ * later columns.  For that, arrayKeyData gets an extra equality key on the
+ * first column in front of the caller's keys; its argument is set to each
+ * value in turn as it is found by _bt_skip_probe.  The first column acts as
+ * an array whose elements are not known in advance, and which is advanced
+ * after all the real arrays have wrapped around.
+ *
  * Note: the reason we need so->arrayKeyData, rather than just scribbling
  * on scan->keyData, is that callers are permitted to call btrescan without
  * supplying a new set of scankey data.
@@ -213,10 +233,19 @@ _bt_preprocess_array_keys(IndexScanDesc scan)
 	int			numberOfKeys = scan->numberOfKeys;
 	int16	   *indoption = scan->indexRelation->rd_indoption;
 	int			numArrayKeys;
+	int			numSkipKeys;
+	Oid			skipeqop;
 	ScanKey		cur;
 	int			i;
 	MemoryContext oldContext;
 
+	so->skipScan = false;
+	so->skipStarted = false;
+	so->skipMarkStarted = false;
+	so->skipStrategy = BTEqualStrategyNumber;
+	so->skipProcStrategy = BTEqualStrategyNumber;
+	so->skipFutile = 0;
+
 	/* Quick check to see if there are any array keys */
 	numArrayKeys = 0;
 	for (i = 0; i < numberOfKeys; i++)
@@ -236,8 +265,10 @@ _bt_preprocess_array_keys(IndexScanDesc scan)
 		}
 	}
 
+	numSkipKeys = _bt_skip_applicable(scan, &skipeqop) ? 1 : 0;
+
 	/* Quit if nothing to do. */
-	if (numArrayKeys == 0)
+	if (numArrayKeys == 0 && numSkipKeys == 0)
 	{
 		so->numArrayKeys = 0;
 		so->arrayKeyData = NULL;
@@ -257,11 +288,31 @@ _bt_preprocess_array_keys(IndexScanDesc scan)
 
 	oldContext = MemoryContextSwitchTo(so->arrayContext);
 
-	/* Create modifiable copy of scan->keyData in the workspace context */
-	so->arrayKeyData = (ScanKey) palloc(scan->numberOfKeys * sizeof(ScanKeyData));
-	memcpy(so->arrayKeyData,
+	/*
+	 * Create modifiable copy of scan->keyData in the workspace context,
+	 * leaving room in front for the skip key if we need one.
+	 */
+	so->arrayKeyData = (ScanKey) palloc((numberOfKeys + numSkipKeys) *
+										sizeof(ScanKeyData));
+	memcpy(so->arrayKeyData + numSkipKeys,
 		   scan->keyData,
-		   scan->numberOfKeys * sizeof(ScanKeyData));
+		   numberOfKeys * sizeof(ScanKeyData));
+
+	if (numSkipKeys > 0)
+	{
+		Relation	rel = scan->indexRelation;
+
+		/* _bt_skip_set_key fills in the argument before each use */
+		ScanKeyEntryInitialize(&so->arrayKeyData[0],
+							   0,
+							   1,
+							   BTEqualStrategyNumber,
+							   rel->rd_opcintype[0],
+							   rel->rd_indcollation[0],
+							   get_opcode(skipeqop),
+							   (Datum) 0);
+		so->skipScan = true;
+	}
 
 	/* Allocate space for per-array data in the workspace context */
 	so->arrayKeys = (BTArrayKeyInfo *) palloc0(numArrayKeys * sizeof(BTArrayKeyInfo));
@@ -280,7 +331,7 @@ _bt_preprocess_array_keys(IndexScanDesc scan)
 		int			num_nonnulls;
 		int			j;
 
-		cur = &so->arrayKeyData[i];
+		cur = &so->arrayKeyData[i + numSkipKeys];
 		if (!(cur->sk_flags & SK_SEARCHARRAY))
 			continue;
 
@@ -360,7 +411,7 @@ _bt_preprocess_array_keys(IndexScanDesc scan)
 		/*
 		 * And set up the BTArrayKeyInfo data.
 		 */
-		so->arrayKeys[numArrayKeys].scan_key = i;
+		so->arrayKeys[numArrayKeys].scan_key = i + numSkipKeys;
 		so->arrayKeys[numArrayKeys].num_elems = num_elems;
 		so->arrayKeys[numArrayKeys].elem_values = elem_values;
 		numArrayKeys++;
@@ -520,8 +571,11 @@ _bt_compare_array_elements(const void *a, const void *b, void *arg)
  *
  * Set up the cur_elem counters and fill in the first sk_argument value for
  * each array scankey.  We can't do this until we know the scan direction.
+ * For a skip scan, this also finds the first value of the first column.
+ *
+ * Returns false if a skip scan found the index to be empty.
  */
-void
+bool
 _bt_start_array_keys(IndexScanDesc scan, ScanDirection dir)
 {
 	BTScanOpaque so = (BTScanOpaque) scan->opaque;
@@ -541,6 +595,21 @@ _bt_start_array_keys(IndexScanDesc scan, ScanDirection dir)
 	}
 
 	so->arraysStarted = true;
+
+	if (so->skipScan)
+	{
+		so->skipStarted = false;
+		so->skipStrategy = BTEqualStrategyNumber;
+		so->skipFutile = 0;
+		if (!_bt_skip_probe(scan, dir))
+		{
+			so->arraysStarted = false;
+			return false;
+		}
+		_bt_skip_set_key(scan);
+	}
+
+	return true;
 }
 
 /*
@@ -596,6 +665,16 @@ _bt_advance_array_keys(IndexScanDesc scan, ScanDirection dir)
 			break;
 	}
 
+	/*
+	 * Once all the arrays have wrapped around, a skip scan moves on to the
+	 * next value of the first column.  There's no point in that if the keys
+	 * on the other columns have been found to be contradictory, as that
+	 * can't depend on the first column unless there are arrays.
+	 */
+	if (!found && so->skipScan &&
+		(so->numArrayKeys > 0 || so->qual_ok))
+		found = _bt_skip_advance(scan, dir);
+
 	/* advance parallel scan */
 	if (scan->parallel_scan != NULL)
 		_bt_parallel_advance_array_keys(scan);
@@ -628,6 +707,22 @@ _bt_mark_array_keys(IndexScanDesc scan)
 
 		curArrayKey->mark_elem = curArrayKey->cur_elem;
 	}
+
+	if (so->skipScan)
+	{
+		Form_pg_attribute att = TupleDescAttr(RelationGetDescr(scan->indexRelation), 0);
+		MemoryContext oldContext = MemoryContextSwitchTo(so->arrayContext);
+
+		if (so->skipMarkStarted && !so->skipMarkIsNull && !att->attbyval)
+			pfree(DatumGetPointer(so->skipMarkValue));
+		so->skipMarkStarted = so->skipStarted;
+		so->skipMarkIsNull = so->skipIsNull;
+		so->skipMarkStrategy = so->skipStrategy;
+		if (so->skipStarted && !so->skipIsNull)
+			so->skipMarkValue = datumCopy(so->skipValue, att->attbyval,
+										  att->attlen);
+		MemoryContextSwitchTo(oldContext);
+	}
 }
 
 /*
@@ -657,6 +752,27 @@ _bt_restore_array_keys(IndexScanDesc scan)
 		}
 	}
 
+	/* Likewise for the first column's value in a skip scan */
+	if (so->skipScan && so->skipMarkStarted)
+	{
+		Form_pg_attribute att = TupleDescAttr(RelationGetDescr(scan->indexRelation), 0);
+		MemoryContext oldContext = MemoryContextSwitchTo(so->arrayContext);
+
+		if (so->skipStarted && !so->skipIsNull && !att->attbyval)
+			pfree(DatumGetPointer(so->skipValue));
+		so->skipStarted = true;
+		so->skipIsNull = so->skipMarkIsNull;
+		if (!so->skipIsNull)
+			so->skipValue = datumCopy(so->skipMarkValue, att->attbyval,
+									  att->attlen);
+		so->skipStrategy = so->skipMarkStrategy;
+		so->skipFutile = 0;
+		MemoryContextSwitchTo(oldContext);
+
+		_bt_skip_set_key(scan);
+		changed = true;
+	}
+
 	/*
 	 * If we changed any keys, we must redo _bt_preprocess_keys.  That might
 	 * sound like overkill, but in cases with multiple keys per index column
@@ -676,6 +792,165 @@ _bt_restore_array_keys(IndexScanDesc scan)
 }
 
 
+/*
+ * _bt_skip_applicable() -- Can this scan be done as a skip scan?
+ *
+ * That's the case when there are no keys on the index's first column, and
+ * some on the second, which each primitive scan can position itself with.
+ * We also need the equality operator of the first column's opclass, which
+ * is returned in *eqop.  Parallel scans aren't supported, since the
+ * participants would have to agree on the first column's current value.
+ */
+static bool
+_bt_skip_applicable(IndexScanDesc scan, Oid *eqop)
+{
+	Relation	rel = scan->indexRelation;
+	bool		secondcol = false;
+	int			i;
+
+	if (IndexRelationGetNumberOfKeyAttributes(rel) < 2 ||
+		scan->parallel_scan != NULL)
+		return false;
+
+	for (i = 0; i < scan->numberOfKeys; i++)
+	{
+		ScanKey		cur = &scan->keyData[i];
+
+		if (cur->sk_attno == 1)
+			return false;
+		if (cur->sk_attno == 2)
+			secondcol = true;
+	}
+	if (!secondcol)
+		return false;
+
+	*eqop = get_opfamily_member(rel->rd_opfamily[0],
+								rel->rd_opcintype[0],
+								rel->rd_opcintype[0],
+								BTEqualStrategyNumber);
+	return OidIsValid(*eqop);
+}
+
+/*
+ * _bt_skip_advance() -- Move a skip scan on to the next value of the first
+ * column.
+ *
+ * Skipping only pays off if the values are far enough apart that the probes
+ * pass over leaf pages.  When one value after another turns up on the leaf
+ * page the previous primitive scan ended on, the first column has too many
+ * distinct values for that, and the probes are pure overhead.  We then give
+ * up skipping, and read the rest of the index in one primitive scan, by
+ * turning the first column's key into a range starting at the value just
+ * found.  Rows whose first column is NULL don't satisfy the range, so if
+ * NULLs come later in the scan direction, they get a primitive scan of
+ * their own at the end.  Scans with real array keys keep skipping, as their
+ * primitive scans must visit each value of the first column in turn.
+ *
+ * Returns false if there are no more values.
+ */
+static bool
+_bt_skip_advance(IndexScanDesc scan, ScanDirection dir)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+	int16		indoption = rel->rd_indoption[0];
+	BlockNumber prevpage = so->lastLeafPage;
+
+	if (so->skipStrategy != BTEqualStrategyNumber)
+	{
+		Form_pg_attribute att = TupleDescAttr(RelationGetDescr(rel), 0);
+		bool		nullsahead;
+
+		/* The range scan is done; see if the NULLs are still to come */
+		if (ScanDirectionIsForward(dir))
+			nullsahead = (indoption & INDOPTION_NULLS_FIRST) == 0;
+		else
+			nullsahead = (indoption & INDOPTION_NULLS_FIRST) != 0;
+		if (so->skipIsNull || !nullsahead)
+			return false;
+
+		if (!att->attbyval)
+			pfree(DatumGetPointer(so->skipValue));
+		so->skipIsNull = true;
+		so->skipValue = (Datum) 0;
+		_bt_skip_set_key(scan);
+		return true;
+	}
+
+	if (!_bt_skip_probe(scan, dir))
+		return false;
+
+	if (BlockNumberIsValid(prevpage) && so->lastLeafPage == prevpage)
+		so->skipFutile++;
+	else
+		so->skipFutile = 0;
+
+	if (so->skipFutile >= BT_SKIP_MAX_FUTILE &&
+		so->numArrayKeys == 0 && !so->skipIsNull)
+	{
+		/* Cover this value and all the later ones in the scan direction */
+		if (ScanDirectionIsForward(dir) == ((indoption & INDOPTION_DESC) == 0))
+			so->skipStrategy = BTGreaterEqualStrategyNumber;
+		else
+			so->skipStrategy = BTLessEqualStrategyNumber;
+	}
+
+	_bt_skip_set_key(scan);
+	return true;
+}
+
+/*
+ * _bt_skip_set_key() -- Point a skip scan's first-column key at the value
+ * most recently found by _bt_skip_probe.
+ *
+ * A NULL value is searched for with an IS NULL key.  _bt_preprocess_keys
+ * will have added the index's flags to the key, so reset it fully.  Once the
+ * scan has given up skipping, the key is a range rather than an equality;
+ * look up the operator's function when that changes.
+ */
+static void
+_bt_skip_set_key(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+	ScanKey		skey = &so->arrayKeyData[0];
+
+	Assert(so->skipScan && so->skipStarted);
+
+	if (so->skipIsNull)
+	{
+		skey->sk_flags = SK_ISNULL | SK_SEARCHNULL;
+		skey->sk_strategy = InvalidStrategy;
+		skey->sk_subtype = InvalidOid;
+		skey->sk_collation = InvalidOid;
+		skey->sk_argument = (Datum) 0;
+	}
+	else
+	{
+		if (so->skipProcStrategy != so->skipStrategy)
+		{
+			Oid			opno;
+
+			opno = get_opfamily_member(rel->rd_opfamily[0],
+									   rel->rd_opcintype[0],
+									   rel->rd_opcintype[0],
+									   so->skipStrategy);
+			if (!OidIsValid(opno))
+				elog(ERROR, "missing operator %d(%u,%u) in opfamily %u",
+					 so->skipStrategy, rel->rd_opcintype[0],
+					 rel->rd_opcintype[0], rel->rd_opfamily[0]);
+			fmgr_info_cxt(get_opcode(opno), &skey->sk_func, so->arrayContext);
+			so->skipProcStrategy = so->skipStrategy;
+		}
+		skey->sk_flags = 0;
+		skey->sk_strategy = so->skipStrategy;
+		skey->sk_subtype = rel->rd_opcintype[0];
+		skey->sk_collation = rel->rd_indcollation[0];
+		skey->sk_argument = so->skipValue;
+	}
+}
+
+
 /*
  *	_bt_preprocess_keys() -- Preprocess scan keys
  *
@@ -764,7 +1039,7 @@ void
 _bt_preprocess_keys(IndexScanDesc scan)
 {
 	BTScanOpaque so = (BTScanOpaque) scan->opaque;
-	int			numberOfKeys = scan->numberOfKeys;
+	int			numberOfKeys = scan->numberOfKeys + (so->skipScan ? 1 : 0);
 	int16	   *indoption = scan->indexRelation->rd_indoption;
 	int			new_numberOfKeys;
 	int			numberOfEqualCols;
@@ -2130,7 +2405,9 @@ btoptions(Datum reloptions, bool validate)
 		{"vacuum_cleanup_index_scale_factor", RELOPT_TYPE_REAL,
 		offsetof(BTOptions, vacuum_cleanup_index_scale_factor)},
 		{"deduplicate_items", RELOPT_TYPE_BOOL,
-		offsetof(BTOptions, deduplicate_items)}
+		offsetof(BTOptions, deduplicate_items)},
+		{"prefix_compression", RELOPT_TYPE_BOOL,
+		offsetof(BTOptions, prefix_compression)}
 	};
 
 	return (bytea *) build_reloptions(reloptions, validate,
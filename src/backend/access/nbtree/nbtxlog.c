@@ -291,13 +291,25 @@ btree_xlog_split(bool newitemonleft, XLogReaderState *record)
 	datapos = XLogRecGetBlockData(record, 1, &datalen);
 	rpage = (Page) BufferGetPage(rbuf);
 
-	_bt_pageinit(rpage, BufferGetPageSize(rbuf));
+	if (xlrec->rightprefixlen > 0)
+	{
+		/* key prefix of right page comes first */
+		Assert(isleaf);
+		_bt_pageinit_prefix(rpage, BufferGetPageSize(rbuf), datapos,
+							xlrec->rightprefixlen);
+		datapos += xlrec->rightprefixlen;
+		datalen -= xlrec->rightprefixlen;
+	}
+	else
+		_bt_pageinit(rpage, BufferGetPageSize(rbuf));
 	ropaque = BTPageGetOpaque(rpage);
 
 	ropaque->btpo_prev = origpagenumber;
 	ropaque->btpo_next = spagenumber;
 	ropaque->btpo_level = xlrec->level;
 	ropaque->btpo_flags = isleaf ? BTP_LEAF : 0;
+	if (xlrec->rightprefixlen > 0)
+		ropaque->btpo_flags |= BTP_PREFIX;
 	ropaque->btpo_cycleid = 0;
 
 	_bt_restore_page(rpage, datapos, datalen);
@@ -423,8 +435,12 @@ btree_xlog_split(bool newitemonleft, XLogReaderState *record)
 
 		PageRestoreTempPage(leftpage, origpage);
 
-		/* Fix opaque fields */
-		oopaque->btpo_flags = BTP_INCOMPLETE_SPLIT;
+		/*
+		 * Fix opaque fields.  The left page kept its key prefix, or else it
+		 * would have been restored from a full-page image.
+		 */
+		oopaque->btpo_flags = BTP_INCOMPLETE_SPLIT |
+			(oopaque->btpo_flags & BTP_PREFIX);
 		if (isleaf)
 			oopaque->btpo_flags |= BTP_LEAF;
 		oopaque->btpo_next = rightpagenumber;
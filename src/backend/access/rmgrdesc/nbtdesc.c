@@ -43,9 +43,10 @@ btree_desc(StringInfo buf, XLogReaderState *record)
 			{
 				xl_btree_split *xlrec = (xl_btree_split *) rec;
 
-				appendStringInfo(buf, "level: %u, firstrightoff: %d, newitemoff: %d, postingoff: %d",
+				appendStringInfo(buf, "level: %u, firstrightoff: %d, newitemoff: %d, postingoff: %d, rightprefixlen: %u",
 								 xlrec->level, xlrec->firstrightoff,
-								 xlrec->newitemoff, xlrec->postingoff);
+								 xlrec->newitemoff, xlrec->postingoff,
+								 xlrec->rightprefixlen);
 				break;
 			}
 		case XLOG_BTREE_DEDUP:
@@ -148,6 +148,14 @@ xlog_desc(StringInfo buf, XLogReaderState *record)
 						 LSN_FORMAT_ARGS(xlrec.overwritten_lsn),
 						 timestamptz_to_str(xlrec.overwrite_time));
 	}
+	else if (info == XLOG_WAL_DICTIONARY)
+	{
+		xl_wal_dictionary xlrec;
+
+		memcpy(&xlrec, rec, sizeof(xl_wal_dictionary));
+		appendStringInfo(buf, "id %08X; size %u",
+						 xlrec.dict_id, xlrec.dict_size);
+	}
 }
 
 const char *
@@ -190,6 +198,9 @@ xlog_identify(uint8 info)
 		case XLOG_OVERWRITE_CONTRECORD:
 			id = "OVERWRITE_CONTRECORD";
 			break;
+		case XLOG_WAL_DICTIONARY:
+			id = "WAL_DICTIONARY";
+			break;
 		case XLOG_FPI:
 			id = "FPI";
 			break;
@@ -261,6 +272,8 @@ XLogRecGetBlockRefInfo(XLogReaderState *record, bool pretty,
 						method = "lz4";
 					else if ((bimg_info & BKPIMAGE_COMPRESS_ZSTD) != 0)
 						method = "zstd";
+					else if ((bimg_info & BKPIMAGE_COMPRESS_ZSTD_DICT) != 0)
+						method = "zstd_dict";
 					else
 						method = "unknown";
 
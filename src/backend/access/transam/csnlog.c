@@ -0,0 +1,656 @@
+/*-------------------------------------------------------------------------
+ *
+ * csnlog.c
+ *		Commit-sequence-number log manager
+ *
+ * The pg_csn manager is a pg_xact-like manager that stores the commit
+ * sequence number (CSN) of each transaction.  It is used by csn_snapshots:
+ * a CSN snapshot is just the next CSN to be assigned at the time it was
+ * taken, and a transaction is visible to it if it committed with a smaller
+ * CSN.  That makes taking a snapshot O(1) and lets it avoid ProcArrayLock
+ * altogether, at the price of a CSN log lookup in XidInMVCCSnapshot().
+ *
+ * Like pg_subtrans, we only need to remember CSNs for transactions that
+ * some snapshot might still ask about, and CSNs are meaningless across a
+ * restart.  There are no XLOG interactions: during startup we zero the
+ * currently-active pages, mark every transaction that completed before
+ * startup as committed-before-everything (or aborted), and start assigning
+ * CSNs from scratch.
+ *
+ * A zeroed entry means the transaction is still in progress.  Committing
+ * transactions get their CSN from a shared atomic counter; see
+ * CSNLogSetCommitted() for how that is made atomic with respect to
+ * snapshots.  We also track the oldest transaction that might still be in
+ * progress, which CSN snapshots use as their xmin, by advancing it past
+ * completed transactions whenever one completes.
+ *
+ * Portions Copyright (c) 1996-2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/backend/access/transam/csnlog.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/csnlog.h"
+#include "access/slru.h"
+#include "access/transam.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/procarray.h"
+#include "storage/s_lock.h"
+#include "storage/shmem.h"
+
+
+/*
+ * Defines for CSN log page sizes.  A page is the same BLCKSZ as is used
+ * everywhere else in Postgres.
+ *
+ * Note: because TransactionIds are 32 bits and wrap around at 0xFFFFFFFF,
+ * CSN log page numbering also wraps around at
+ * 0xFFFFFFFF/CSNLOG_XACTS_PER_PAGE, and segment numbering at
+ * 0xFFFFFFFF/CSNLOG_XACTS_PER_PAGE/SLRU_PAGES_PER_SEGMENT.  We need take no
+ * explicit notice of that fact in this module, except when comparing segment
+ * and page numbers in TruncateCSNLog (see CSNLogPagePrecedes) and zeroing
+ * them in StartupCSNLog.
+ */
+
+/* We need eight bytes per xact */
+#define CSNLOG_XACTS_PER_PAGE (BLCKSZ / sizeof(CommitSeqNo))
+
+#define TransactionIdToPage(xid) ((xid) / (TransactionId) CSNLOG_XACTS_PER_PAGE)
+#define TransactionIdToPgIndex(xid) ((xid) % (TransactionId) CSNLOG_XACTS_PER_PAGE)
+
+/*
+ * Shared state besides the SLRU buffers.  Everything here is read without
+ * any lock by snapshots.
+ */
+typedef struct CSNLogSharedData
+{
+	/* next commit sequence number to assign */
+	pg_atomic_uint64 nextCommitSeqNo;
+
+	/* copy of ShmemVariableCache->nextXid, readable without XidGenLock */
+	pg_atomic_uint64 nextFullXid;
+
+	/* every XID before this one has committed or aborted */
+	pg_atomic_uint32 oldestActiveXid;
+
+	/* entries before this XID have been truncated away */
+	pg_atomic_uint32 oldestXid;
+} CSNLogSharedData;
+
+static CSNLogSharedData *CSNLogShared;
+
+/*
+ * Link to shared-memory data structures for CSN log control
+ */
+static SlruCtlData CSNLogCtlData;
+
+#define CSNLogCtl  (&CSNLogCtlData)
+
+/* GUC variable */
+bool		csn_snapshots = false;
+
+/*
+ * Single-item cache for results of CSNLogGetCommitSeqNo.  Only final values
+ * (committed or aborted) are cached, so it never needs to be invalidated.
+ */
+static TransactionId cachedFetchXid = InvalidTransactionId;
+static CommitSeqNo cachedFetchCSN;
+
+
+static int	ZeroCSNLogPage(int pageno);
+static bool CSNLogPagePrecedes(int page1, int page2);
+static void CSNLogSetEntry(TransactionId xid, CommitSeqNo csn);
+static void CSNLogSetTree(TransactionId xid, int nsubxids,
+						  TransactionId *subxids, CommitSeqNo csn);
+static void CSNLogAdvanceOldestActiveXid(void);
+
+
+/*
+ * Record the commit of a transaction and its subtransactions, making it
+ * visible to CSN snapshots taken from now on.
+ *
+ * This must be called after the commit has been recorded in pg_xact, and
+ * before the transaction is removed from the procarray and releases its
+ * locks.
+ */
+void
+CSNLogSetCommitted(TransactionId xid, int nsubxids, TransactionId *subxids)
+{
+	int			pageno = TransactionIdToPage(xid);
+	bool		onepage = true;
+	CommitSeqNo csn;
+	int			i;
+
+	if (!csn_snapshots || !TransactionIdIsNormal(xid))
+		return;
+
+	for (i = 0; i < nsubxids; i++)
+	{
+		if (TransactionIdToPage(subxids[i]) != pageno)
+		{
+			onepage = false;
+			break;
+		}
+	}
+
+	/* Failing halfway through would leave snapshots waiting forever */
+	START_CRIT_SECTION();
+
+	if (onepage)
+	{
+		int			slotno;
+		CommitSeqNo *ptr;
+
+		/*
+		 * All the entries are on the same page, so we can draw the CSN and
+		 * set them while holding the control lock, and nobody can look at
+		 * them in between.  A snapshot that read the counter before we
+		 * advanced it may see the transaction as running, which is correct;
+		 * one that read it after will wait for the lock and see our CSN.
+		 */
+		LWLockAcquire(CSNLogSLRULock, LW_EXCLUSIVE);
+
+		slotno = SimpleLruReadPage(CSNLogCtl, pageno, true, xid);
+		ptr = (CommitSeqNo *) CSNLogCtl->shared->page_buffer[slotno];
+
+		csn = pg_atomic_fetch_add_u64(&CSNLogShared->nextCommitSeqNo, 1);
+		for (i = 0; i < nsubxids; i++)
+			ptr[TransactionIdToPgIndex(subxids[i])] = csn;
+		ptr[TransactionIdToPgIndex(xid)] = csn;
+		CSNLogCtl->shared->page_dirty[slotno] = true;
+
+		LWLockRelease(CSNLogSLRULock);
+	}
+	else
+	{
+		/*
+		 * Reading another page might release the control lock, so first mark
+		 * all the entries as committing.  Snapshots that run into one of them
+		 * wait until we have set the real CSN.
+		 */
+		CSNLogSetTree(xid, nsubxids, subxids, CommittingCommitSeqNo);
+		csn = pg_atomic_fetch_add_u64(&CSNLogShared->nextCommitSeqNo, 1);
+		CSNLogSetTree(xid, nsubxids, subxids, csn);
+	}
+
+	CSNLogAdvanceOldestActiveXid();
+
+	END_CRIT_SECTION();
+}
+
+/*
+ * Record the abort of a transaction and its subtransactions.
+ *
+ * Aborted transactions are invisible to everyone just like running ones, so
+ * this only matters for advancing the oldest active XID.
+ */
+void
+CSNLogSetAborted(TransactionId xid, int nsubxids, TransactionId *subxids)
+{
+	if (!csn_snapshots || !TransactionIdIsNormal(xid))
+		return;
+
+	CSNLogSetTree(xid, nsubxids, subxids, AbortedCommitSeqNo);
+	CSNLogAdvanceOldestActiveXid();
+}
+
+/*
+ * Mark a prepared transaction recovered at startup as in progress again.
+ *
+ * StartupCSNLog() cannot tell prepared transactions from ones that crashed
+ * and marks them all as aborted; RecoverPreparedTransactions() corrects that
+ * before anyone can take a snapshot.
+ */
+void
+CSNLogSetInProgress(TransactionId xid, int nsubxids, TransactionId *subxids)
+{
+	if (!csn_snapshots)
+		return;
+
+	CSNLogSetTree(xid, nsubxids, subxids, InvalidCommitSeqNo);
+}
+
+/*
+ * Set the CSN log entry of a single XID.
+ *
+ * Control lock must be held in exclusive mode at entry, and will be held at
+ * exit.
+ */
+static void
+CSNLogSetEntry(TransactionId xid, CommitSeqNo csn)
+{
+	int			slotno;
+	CommitSeqNo *ptr;
+
+	slotno = SimpleLruReadPage(CSNLogCtl, TransactionIdToPage(xid), true, xid);
+	ptr = (CommitSeqNo *) CSNLogCtl->shared->page_buffer[slotno];
+	ptr[TransactionIdToPgIndex(xid)] = csn;
+	CSNLogCtl->shared->page_dirty[slotno] = true;
+}
+
+/*
+ * Set the CSN log entries of a transaction and its subtransactions.
+ */
+static void
+CSNLogSetTree(TransactionId xid, int nsubxids, TransactionId *subxids,
+			  CommitSeqNo csn)
+{
+	int			i;
+
+	LWLockAcquire(CSNLogSLRULock, LW_EXCLUSIVE);
+
+	for (i = 0; i < nsubxids; i++)
+		CSNLogSetEntry(subxids[i], csn);
+	CSNLogSetEntry(xid, csn);
+
+	LWLockRelease(CSNLogSLRULock);
+}
+
+/*
+ * Interrogate the CSN of a transaction in the CSN log.
+ *
+ * Returns InvalidCommitSeqNo if the transaction is still in progress.
+ */
+CommitSeqNo
+CSNLogGetCommitSeqNo(TransactionId xid)
+{
+	int			pageno = TransactionIdToPage(xid);
+	int			entryno = TransactionIdToPgIndex(xid);
+	int			slotno;
+	CommitSeqNo csn;
+	SpinDelayStatus delay;
+
+	/* Bootstrap and frozen XIDs are committed for everyone */
+	if (!TransactionIdIsNormal(xid))
+		return TransactionIdIsValid(xid) ? FrozenCommitSeqNo : AbortedCommitSeqNo;
+
+	if (TransactionIdEquals(xid, cachedFetchXid))
+		return cachedFetchCSN;
+
+	/*
+	 * The entries of transactions before the truncation point are gone, but
+	 * they all completed before any snapshot that can still ask about them;
+	 * see TruncateCSNLog().
+	 */
+	if (TransactionIdPrecedes(xid, pg_atomic_read_u32(&CSNLogShared->oldestXid)))
+		return TransactionIdDidCommit(xid) ? FrozenCommitSeqNo : AbortedCommitSeqNo;
+
+	init_local_spin_delay(&delay);
+	for (;;)
+	{
+		/* lock is acquired by SimpleLruReadPage_ReadOnly */
+		slotno = SimpleLruReadPage_ReadOnly(CSNLogCtl, pageno, xid);
+		csn = ((CommitSeqNo *) CSNLogCtl->shared->page_buffer[slotno])[entryno];
+		LWLockRelease(CSNLogSLRULock);
+
+		if (csn != CommittingCommitSeqNo)
+			break;
+
+		/* the committer is about to set the final value, see above */
+		perform_spin_delay(&delay);
+	}
+	finish_spin_delay(&delay);
+
+	if (csn != InvalidCommitSeqNo)
+	{
+		cachedFetchXid = xid;
+		cachedFetchCSN = csn;
+	}
+
+	return csn;
+}
+
+/*
+ * Advance the oldest active XID past transactions that have completed.
+ *
+ * Every transaction calls this after recording its completion, so whoever
+ * completes last sees everything up to the next still-running transaction.
+ * If several backends race, the compare-and-exchange makes sure the value
+ * never moves backwards, and the loser retries from the winner's value.
+ */
+static void
+CSNLogAdvanceOldestActiveXid(void)
+{
+	TransactionId oldest;
+	TransactionId nextXid;
+
+	oldest = pg_atomic_read_u32(&CSNLogShared->oldestActiveXid);
+	nextXid = XidFromFullTransactionId(CSNLogGetNextFullXid());
+
+	for (;;)
+	{
+		TransactionId xid = oldest;
+		int			pageno = -1;
+		int			slotno = -1;
+
+		while (TransactionIdPrecedes(xid, nextXid))
+		{
+			CommitSeqNo csn;
+
+			if (TransactionIdToPage(xid) != pageno)
+			{
+				if (pageno != -1)
+					LWLockRelease(CSNLogSLRULock);
+				pageno = TransactionIdToPage(xid);
+				slotno = SimpleLruReadPage_ReadOnly(CSNLogCtl, pageno, xid);
+			}
+
+			csn = ((CommitSeqNo *) CSNLogCtl->shared->page_buffer[slotno])
+				[TransactionIdToPgIndex(xid)];
+			if (csn == InvalidCommitSeqNo || csn == CommittingCommitSeqNo)
+				break;
+
+			TransactionIdAdvance(xid);
+		}
+		if (pageno != -1)
+			LWLockRelease(CSNLogSLRULock);
+
+		if (TransactionIdEquals(xid, oldest) ||
+			pg_atomic_compare_exchange_u32(&CSNLogShared->oldestActiveXid,
+										   &oldest, xid))
+			break;
+
+		/* someone else moved it; oldest now holds their value */
+	}
+}
+
+/*
+ * Get the CSN that the next committing transaction will get.  Transactions
+ * with a smaller CSN are visible to a snapshot taken now.
+ */
+CommitSeqNo
+CSNLogGetNextCommitSeqNo(void)
+{
+	return pg_atomic_read_u64(&CSNLogShared->nextCommitSeqNo);
+}
+
+/*
+ * Get the oldest XID that might still be in progress.
+ */
+TransactionId
+CSNLogGetOldestActiveXid(void)
+{
+	return pg_atomic_read_u32(&CSNLogShared->oldestActiveXid);
+}
+
+/*
+ * Get ShmemVariableCache->nextXid without acquiring XidGenLock.
+ */
+FullTransactionId
+CSNLogGetNextFullXid(void)
+{
+	return FullTransactionIdFromU64(pg_atomic_read_u64(&CSNLogShared->nextFullXid));
+}
+
+/*
+ * Publish a new value of ShmemVariableCache->nextXid.  Called with
+ * XidGenLock held, after advancing it.
+ */
+void
+CSNLogSetNextFullXid(FullTransactionId nextXid)
+{
+	pg_atomic_write_u64(&CSNLogShared->nextFullXid,
+						U64FromFullTransactionId(nextXid));
+}
+
+
+/*
+ * Initialization of shared memory for the CSN log
+ */
+Size
+CSNLogShmemSize(void)
+{
+	return add_size(SimpleLruShmemSize(NUM_CSNLOG_BUFFERS, 0),
+					sizeof(CSNLogSharedData));
+}
+
+void
+CSNLogShmemInit(void)
+{
+	bool		found;
+
+	CSNLogCtl->PagePrecedes = CSNLogPagePrecedes;
+	SimpleLruInit(CSNLogCtl, "CSNLog", NUM_CSNLOG_BUFFERS, 0,
+				  CSNLogSLRULock, "pg_csn",
+				  LWTRANCHE_CSNLOG_BUFFER, SYNC_HANDLER_NONE);
+	SlruPagePrecedesUnitTests(CSNLogCtl, CSNLOG_XACTS_PER_PAGE);
+
+	CSNLogShared = ShmemInitStruct("CSNLog shared",
+								   sizeof(CSNLogSharedData),
+								   &found);
+
+	if (!IsUnderPostmaster)
+	{
+		Assert(!found);
+
+		pg_atomic_init_u64(&CSNLogShared->nextCommitSeqNo,
+						   FirstNormalCommitSeqNo);
+		pg_atomic_init_u64(&CSNLogShared->nextFullXid, 0);
+		pg_atomic_init_u32(&CSNLogShared->oldestActiveXid,
+						   InvalidTransactionId);
+		pg_atomic_init_u32(&CSNLogShared->oldestXid, InvalidTransactionId);
+	}
+	else
+		Assert(found);
+}
+
+/*
+ * This func must be called ONCE on system install.  It creates
+ * the initial CSN log segment.  (The pg_csn directory is assumed to
+ * have been created by initdb, and CSNLogShmemInit must have been called
+ * already.)
+ */
+void
+BootStrapCSNLog(void)
+{
+	int			slotno;
+
+	LWLockAcquire(CSNLogSLRULock, LW_EXCLUSIVE);
+
+	/* Create and zero the first page of the CSN log */
+	slotno = ZeroCSNLogPage(0);
+
+	/* Make sure it's written out */
+	SimpleLruWritePage(CSNLogCtl, slotno);
+	Assert(!CSNLogCtl->shared->page_dirty[slotno]);
+
+	LWLockRelease(CSNLogSLRULock);
+}
+
+/*
+ * Initialize (or reinitialize) a page of the CSN log to zeroes.
+ *
+ * The page is not actually written, just set up in shared memory.
+ * The slot number of the new page is returned.
+ *
+ * Control lock must be held at entry, and will be held at exit.
+ */
+static int
+ZeroCSNLogPage(int pageno)
+{
+	return SimpleLruZeroPage(CSNLogCtl, pageno);
+}
+
+/*
+ * This must be called ONCE at the end of startup, after pg_xact has been
+ * trimmed and before prepared transactions are recovered.
+ *
+ * oldestActiveXID is the oldest XID of any prepared transaction, or nextXid
+ * if there are none.
+ */
+void
+StartupCSNLog(TransactionId oldestActiveXID)
+{
+	FullTransactionId nextXid;
+	TransactionId xid;
+	int			startPage;
+	int			endPage;
+
+	if (!csn_snapshots)
+		return;
+
+	/*
+	 * Since we don't expect pg_csn to be valid across crashes, we initialize
+	 * the currently-active page(s) to zeroes during startup.  Whenever we
+	 * advance into a new page, ExtendCSNLog will likewise zero the new page
+	 * without regard to whatever was previously on disk.
+	 */
+	LWLockAcquire(CSNLogSLRULock, LW_EXCLUSIVE);
+
+	startPage = TransactionIdToPage(oldestActiveXID);
+	nextXid = ShmemVariableCache->nextXid;
+	endPage = TransactionIdToPage(XidFromFullTransactionId(nextXid));
+
+	while (startPage != endPage)
+	{
+		(void) ZeroCSNLogPage(startPage);
+		startPage++;
+		/* must account for wraparound */
+		if (startPage > TransactionIdToPage(MaxTransactionId))
+			startPage = 0;
+	}
+	(void) ZeroCSNLogPage(startPage);
+
+	LWLockRelease(CSNLogSLRULock);
+
+	/*
+	 * Everything that committed before startup is visible to all snapshots.
+	 * Transactions that pg_xact still shows as in progress crashed, unless
+	 * they are prepared; see CSNLogSetInProgress().
+	 */
+	xid = oldestActiveXID;
+	while (TransactionIdPrecedes(xid, XidFromFullTransactionId(nextXid)))
+	{
+		CSNLogSetTree(xid, 0, NULL,
+					  TransactionIdDidCommit(xid) ?
+					  FrozenCommitSeqNo : AbortedCommitSeqNo);
+		TransactionIdAdvance(xid);
+	}
+
+	CSNLogSetNextFullXid(nextXid);
+	pg_atomic_write_u32(&CSNLogShared->oldestActiveXid, oldestActiveXID);
+	pg_atomic_write_u32(&CSNLogShared->oldestXid, oldestActiveXID);
+}
+
+/*
+ * Perform a checkpoint --- either during shutdown, or on-the-fly
+ */
+void
+CheckPointCSNLog(void)
+{
+	/*
+	 * Write dirty CSN log pages to disk
+	 *
+	 * This is not actually necessary from a correctness point of view. We do
+	 * it merely to improve the odds that writing of dirty pages is done by
+	 * the checkpoint process and not by backends.
+	 */
+	SimpleLruWriteAll(CSNLogCtl, true);
+}
+
+
+/*
+ * Make sure that the CSN log has room for a newly-allocated XID.
+ *
+ * NB: this is called while holding XidGenLock.  We want it to be very fast
+ * most of the time; even when it's not so fast, no actual I/O need happen
+ * unless we're forced to write out a dirty CSN log page to make room
+ * in shared memory.
+ */
+void
+ExtendCSNLog(TransactionId newestXact)
+{
+	int			pageno;
+
+	if (!csn_snapshots)
+		return;
+
+	/*
+	 * No work except at first XID of a page.  But beware: just after
+	 * wraparound, the first XID of page zero is FirstNormalTransactionId.
+	 */
+	if (TransactionIdToPgIndex(newestXact) != 0 &&
+		!TransactionIdEquals(newestXact, FirstNormalTransactionId))
+		return;
+
+	pageno = TransactionIdToPage(newestXact);
+
+	LWLockAcquire(CSNLogSLRULock, LW_EXCLUSIVE);
+
+	/* Zero the page */
+	ZeroCSNLogPage(pageno);
+
+	LWLockRelease(CSNLogSLRULock);
+}
+
+
+/*
+ * Remove all CSN log segments that no snapshot can ask about anymore.
+ *
+ * This is called only during checkpoint.
+ */
+void
+TruncateCSNLog(void)
+{
+	TransactionId oldestXact;
+	TransactionId oldestXmin;
+	int			cutoffPage;
+
+	if (!csn_snapshots)
+		return;
+
+	/*
+	 * Snapshots advertise their xmin, the oldest active XID, without any
+	 * lock, so the horizon computed below can miss one that is being taken
+	 * concurrently.  Reading the oldest active XID first makes that
+	 * harmless: such a snapshot reads its CSN after we read it, so every
+	 * transaction before our cutoff completed before the snapshot was
+	 * taken, and CSNLogGetCommitSeqNo() answers for them from pg_xact.
+	 */
+	oldestXact = pg_atomic_read_u32(&CSNLogShared->oldestActiveXid);
+	pg_memory_barrier();
+	oldestXmin = GetOldestNonRemovableTransactionId(NULL);
+	if (TransactionIdPrecedes(oldestXmin, oldestXact))
+		oldestXact = oldestXmin;
+
+	/* The horizon can move backwards, but truncated data can't come back */
+	if (!TransactionIdFollows(oldestXact,
+							  pg_atomic_read_u32(&CSNLogShared->oldestXid)))
+		return;
+
+	pg_atomic_write_u32(&CSNLogShared->oldestXid, oldestXact);
+	pg_memory_barrier();
+
+	/*
+	 * The cutoff point is the start of the segment containing oldestXact.
+	 * Step back one transaction like TruncateSUBTRANS() does.
+	 */
+	TransactionIdRetreat(oldestXact);
+	cutoffPage = TransactionIdToPage(oldestXact);
+
+	SimpleLruTruncate(CSNLogCtl, cutoffPage);
+}
+
+
+/*
+ * Decide whether a CSN log page number is "older" for truncation purposes.
+ * Analogous to CLOGPagePrecedes().
+ */
+static bool
+CSNLogPagePrecedes(int page1, int page2)
+{
+	TransactionId xid1;
+	TransactionId xid2;
+
+	xid1 = ((TransactionId) page1) * CSNLOG_XACTS_PER_PAGE;
+	xid1 += FirstNormalTransactionId + 1;
+	xid2 = ((TransactionId) page2) * CSNLOG_XACTS_PER_PAGE;
+	xid2 += FirstNormalTransactionId + 1;
+
+	return (TransactionIdPrecedes(xid1, xid2) &&
+			TransactionIdPrecedes(xid1, xid2 + CSNLOG_XACTS_PER_PAGE - 1));
+}
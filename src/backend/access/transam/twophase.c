@@ -77,6 +77,7 @@
 #include <unistd.h>
 
 #include "access/commit_ts.h"
+#include "access/csnlog.h"
 #include "access/htup_details.h"
 #include "access/subtrans.h"
 #include "access/transam.h"
@@ -452,6 +453,8 @@ MarkAsPreparingGuts(GlobalTransaction gxact, TransactionId xid, const char *gid,
 					TimestampTz prepared_at, Oid owner, Oid databaseid)
 {
 	PGPROC	   *proc;
+	uint64	   *fpLockBits;
+	Oid		   *fpRelId;
 	int			i;
 
 	Assert(LWLockHeldByMeInMode(TwoPhaseStateLock, LW_EXCLUSIVE));
@@ -459,8 +462,12 @@ MarkAsPreparingGuts(GlobalTransaction gxact, TransactionId xid, const char *gid,
 	Assert(gxact != NULL);
 	proc = &ProcGlobal->allProcs[gxact->pgprocno];
 
-	/* Initialize the PGPROC entry */
+	/* Initialize the PGPROC entry, keeping its fast-path lock arrays */
+	fpLockBits = proc->fpLockBits;
+	fpRelId = proc->fpRelId;
 	MemSet(proc, 0, sizeof(PGPROC));
+	proc->fpLockBits = fpLockBits;
+	proc->fpRelId = fpRelId;
 	proc->pgprocno = gxact->pgprocno;
 	dlist_node_init(&proc->links);
 	proc->waitStatus = PROC_WAIT_STATUS_OK;
@@ -1565,6 +1572,10 @@ FinishPreparedTransaction(const char *gid, bool isCommit)
 									   abortstats,
 									   gid);
 
+	/* make the commit visible to csn_snapshots, see CommitTransaction() */
+	if (isCommit)
+		CSNLogSetCommitted(xid, hdr->nsubxacts, children);
+
 	ProcArrayRemove(proc, latestXid);
 
 	/*
@@ -2119,6 +2130,9 @@ RecoverPreparedTransactions(void)
 		GXactLoadSubxactData(gxact, hdr->nsubxacts, subxids);
 		MarkAsPrepared(gxact, true);
 
+		/* StartupCSNLog() took it for a crashed transaction */
+		CSNLogSetInProgress(xid, hdr->nsubxacts, subxids);
+
 		LWLockRelease(TwoPhaseStateLock);
 
 		/*
@@ -2350,7 +2364,7 @@ RecordTransactionCommitPrepared(TransactionId xid,
 	 */
 
 	/* Flush XLOG to disk */
-	XLogFlush(recptr);
+	XLogFlushCommit(recptr);
 
 	/* Mark the transaction committed in pg_xact */
 	TransactionIdCommitTree(xid, nchildren, children);
@@ -2432,6 +2446,7 @@ RecordTransactionAbortPrepared(TransactionId xid,
 	 * but we may as well do it while we are here.
 	 */
 	TransactionIdAbortTree(xid, nchildren, children);
+	CSNLogSetAborted(xid, nchildren, children);
 
 	END_CRIT_SECTION();
 
@@ -15,6 +15,7 @@
 
 #include "access/clog.h"
 #include "access/commit_ts.h"
+#include "access/csnlog.h"
 #include "access/subtrans.h"
 #include "access/transam.h"
 #include "access/xact.h"
@@ -172,11 +173,12 @@ GetNewTransactionId(bool isSubXact) /// 获得一个事务号。输入参数表
 	 * XID before we zero the page.  Fortunately, a page of the commit log
 	 * holds 32K or more transactions, so we don't have to do this very often.
 	 *
-	 * Extend pg_subtrans and pg_commit_ts too.
+	 * Extend pg_subtrans, pg_commit_ts and pg_csn too.
 	 */
 	ExtendCLOG(xid);
 	ExtendCommitTs(xid);
 	ExtendSUBTRANS(xid);
+	ExtendCSNLog(xid);
 
 	/*
 	 * Now advance the nextXid counter.  This must not happen until after we
@@ -186,6 +188,9 @@ GetNewTransactionId(bool isSubXact) /// 获得一个事务号。输入参数表
 	 */
 	FullTransactionIdAdvance(&ShmemVariableCache->nextXid); /// 把nextXid的值加一，变成下一个事务号
 
+	/* CSN snapshots read the new value without acquiring XidGenLock */
+	CSNLogSetNextFullXid(ShmemVariableCache->nextXid);
+
 	/*
 	 * We must store the new XID into the shared ProcArray before releasing
 	 * XidGenLock.  This ensures that every active XID older than
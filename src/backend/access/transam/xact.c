@@ -21,6 +21,7 @@
 #include <unistd.h>
 
 #include "access/commit_ts.h"
+#include "access/csnlog.h"
 #include "access/multixact.h"
 #include "access/parallel.h"
 #include "access/subtrans.h"
@@ -36,6 +37,7 @@
 #include "catalog/pg_enum.h"
 #include "catalog/storage.h"
 #include "commands/async.h"
+#include "commands/matview.h"
 #include "commands/tablecmds.h"
 #include "commands/trigger.h"
 #include "common/pg_prng.h"
@@ -1457,7 +1459,7 @@ RecordTransactionCommit(void)
 		 synchronous_commit > SYNCHRONOUS_COMMIT_OFF) ||
 		forceSyncCommit || nrels > 0)
 	{
-		XLogFlush(XactLastRecEnd);
+		XLogFlushCommit(XactLastRecEnd);
 
 		/*
 		 * Now we may update the CLOG, if we wrote a COMMIT record above
@@ -1797,6 +1799,7 @@ RecordTransactionAbort(bool isSubXact)
 	 * we'd be assumed to have aborted anyway.
 	 */
 	TransactionIdAbortTree(xid, nchildren, children);
+	CSNLogSetAborted(xid, nchildren, children);
 
 	END_CRIT_SECTION();
 
@@ -2194,6 +2197,9 @@ CommitTransaction(void)
 			break;
 	}
 
+	/* Apply deferred maintenance of materialized views */
+	PreCommit_MatViewMaintenance();
+
 	/*
 	 * The remaining actions cannot call any user-defined code, so it's safe
 	 * to start shutting down within-transaction services.  But note that most
@@ -2283,6 +2289,20 @@ CommitTransaction(void)
 
 	TRACE_POSTGRESQL_TRANSACTION_COMMIT(MyProc->lxid);
 
+	/*
+	 * With csn_snapshots, assigning our commit sequence number is what makes
+	 * us visible to new snapshots, so the same ordering rules as for
+	 * ProcArrayEndTransaction apply.
+	 */
+	if (TransactionIdIsValid(latestXid))
+	{
+		TransactionId *children;
+		int			nchildren;
+
+		nchildren = xactGetCommittedChildren(&children);
+		CSNLogSetCommitted(GetTopTransactionId(), nchildren, children);
+	}
+
 	/*
 	 * Let others know about no transaction in progress by me. Note that this
 	 * must be done _before_ releasing locks we hold and _after_
@@ -2363,6 +2383,7 @@ CommitTransaction(void)
 	AtEOXact_SPI(true);
 	AtEOXact_Enum();
 	AtEOXact_on_commit_actions(true);
+	AtEOXact_MatViewMaintenance(true);
 	AtEOXact_Namespace(true, is_parallel_worker);
 	AtEOXact_SMgr();
 	AtEOXact_Files(true);
@@ -2450,6 +2471,9 @@ PrepareTransaction(void)
 			break;
 	}
 
+	/* Apply deferred maintenance of materialized views */
+	PreCommit_MatViewMaintenance();
+
 	CallXactCallbacks(XACT_EVENT_PRE_PREPARE);
 
 	/*
@@ -2649,6 +2673,7 @@ PrepareTransaction(void)
 	AtEOXact_SPI(true);
 	AtEOXact_Enum();
 	AtEOXact_on_commit_actions(true);
+	AtEOXact_MatViewMaintenance(true);
 	AtEOXact_Namespace(true, false);
 	AtEOXact_SMgr();
 	AtEOXact_Files(true);
@@ -2864,6 +2889,7 @@ AbortTransaction(void)
 		AtEOXact_SPI(false);
 		AtEOXact_Enum();
 		AtEOXact_on_commit_actions(false);
+		AtEOXact_MatViewMaintenance(false);
 		AtEOXact_Namespace(false, is_parallel_worker);
 		AtEOXact_SMgr();
 		AtEOXact_Files(false);
@@ -5024,6 +5050,8 @@ CommitSubTransaction(void)
 	AtEOSubXact_SPI(true, s->subTransactionId);
 	AtEOSubXact_on_commit_actions(true, s->subTransactionId,
 								  s->parent->subTransactionId);
+	AtEOSubXact_MatViewMaintenance(true, s->subTransactionId,
+								   s->parent->subTransactionId);
 	AtEOSubXact_Namespace(true, s->subTransactionId,
 						  s->parent->subTransactionId);
 	AtEOSubXact_Files(true, s->subTransactionId,
@@ -5187,6 +5215,8 @@ AbortSubTransaction(void)
 		AtEOSubXact_SPI(false, s->subTransactionId);
 		AtEOSubXact_on_commit_actions(false, s->subTransactionId,
 									  s->parent->subTransactionId);
+		AtEOSubXact_MatViewMaintenance(false, s->subTransactionId,
+									   s->parent->subTransactionId);
 		AtEOSubXact_Namespace(false, s->subTransactionId,
 							  s->parent->subTransactionId);
 		AtEOSubXact_Files(false, s->subTransactionId,
@@ -48,6 +48,7 @@
 
 #include "access/clog.h"
 #include "access/commit_ts.h"
+#include "access/csnlog.h"
 #include "access/heaptoast.h"
 #include "access/multixact.h"
 #include "access/rewriteheap.h"
@@ -58,10 +59,12 @@
 #include "access/xact.h"
 #include "access/xlog_internal.h"
 #include "access/xlogarchive.h"
+#include "access/xlogdict.h"
 #include "access/xloginsert.h"
 #include "access/xlogprefetcher.h"
 #include "access/xlogreader.h"
 #include "access/xlogrecovery.h"
+#include "access/xlogredoworker.h"
 #include "access/xlogutils.h"
 #include "backup/basebackup.h"
 #include "catalog/catversion.h"
@@ -74,6 +77,7 @@
 #include "pg_trace.h"
 #include "pgstat.h"
 #include "port/atomics.h"
+#include "port/pg_bitutils.h"
 #include "port/pg_iovec.h"
 #include "postmaster/bgwriter.h"
 #include "postmaster/startup.h"
@@ -134,6 +138,7 @@ int			sync_method = DEFAULT_SYNC_METHOD;
 int			wal_level = WAL_LEVEL_REPLICA;
 int			CommitDelay = 0;	/* precommit delay in microseconds */
 int			CommitSiblings = 5; /* # concurrent xacts needed to sleep */
+bool		wal_group_commit = false;
 int			wal_retrieve_retry_interval = 5000;
 int			max_slot_wal_keep_size_mb = -1;
 int			wal_decode_buffer_size = 512 * 1024;
@@ -146,11 +151,29 @@ bool		XLOG_DEBUG = false;
 int			wal_segment_size = DEFAULT_XLOG_SEG_SIZE;
 
 /*
- * Number of WAL insertion locks to use. A higher value allows more insertions
- * to happen concurrently, but adds some CPU overhead to flushing the WAL,
- * which needs to iterate all the locks.
+ * Number of WAL insertion locks to use (GUC wal_insert_locks). A higher value
+ * allows more insertions to happen concurrently, but adds some CPU overhead
+ * to flushing the WAL, which needs to iterate all the locks.  -1 means choose
+ * based on max_connections, see XLOGChooseNumInsertLocks().
  */
-#define NUM_XLOGINSERT_LOCKS  8
+int			wal_insert_locks = -1;
+
+/*
+ * Size of the table used to hand the start of each reserved record to the
+ * next one, see ReserveXLogInsertLocation().  Must be a power of two.
+ */
+#define WAL_PREV_LINK_BITS		10
+#define WAL_PREV_LINK_SLOTS		(1 << WAL_PREV_LINK_BITS)
+#define WAL_PREV_LINK_PROBES	8
+
+/*
+ * Group flush tuning, see XLogGroupFlushDelay().  The average group size is
+ * kept as a fixed-point number with GROUP_FLUSH_SIZE_SCALE as the unit, and
+ * the leader never waits longer than GROUP_FLUSH_MAX_DELAY microseconds for
+ * followers to join.
+ */
+#define GROUP_FLUSH_SIZE_SCALE	16
+#define GROUP_FLUSH_MAX_DELAY	10000
 
 /*
  * Max distance from last checkpoint, before triggering a new xlog-based
@@ -402,26 +425,33 @@ static SessionBackupState sessionBackupState = SESSION_BACKUP_NONE;
 /*
  * Shared state data for WAL insertion.
  */
-typedef struct XLogCtlInsert
+/*
+ * An entry in XLogCtlInsert->prevLinks: the record reserved up to endpos
+ * started at startpos.  endpos is 0 when the slot is free, and PG_UINT64_MAX
+ * while it is being filled in.
+ */
+typedef struct WALPrevLink
 {
-	slock_t		insertpos_lck;	/* protects CurrBytePos and PrevBytePos */
+	pg_atomic_uint64 endpos;
+	uint64		startpos;
+} WALPrevLink;
 
+typedef struct XLogCtlInsert
+{
 	/*
 	 * CurrBytePos is the end of reserved WAL. The next record will be
-	 * inserted at that position. PrevBytePos is the start position of the
-	 * previously inserted (or rather, reserved) record - it is copied to the
-	 * prev-link of the next record. These are stored as "usable byte
-	 * positions" rather than XLogRecPtrs (see XLogBytePosToRecPtr()).
+	 * inserted at that position. It is stored as a "usable byte position"
+	 * rather than an XLogRecPtr (see XLogBytePosToRecPtr()), and advanced
+	 * with an atomic fetch-add, while holding an insertion lock.
 	 */
-	uint64		CurrBytePos;
-	uint64		PrevBytePos;
+	pg_atomic_uint64 CurrBytePos;
 
 	/*
-	 * Make sure the above heavily-contended spinlock and byte positions are
-	 * on their own cache line. In particular, the RedoRecPtr and full page
-	 * write variables below should be on a different cache line. They are
-	 * read on every WAL insertion, but updated rarely, and we don't want
-	 * those reads to steal the cache line containing Curr/PrevBytePos.
+	 * Make sure the above heavily-contended byte position is on its own cache
+	 * line. In particular, the RedoRecPtr and full page write variables below
+	 * should be on a different cache line. They are read on every WAL
+	 * insertion, but updated rarely, and we don't want those reads to steal
+	 * the cache line containing CurrBytePos.
 	 */
 	char		pad[PG_CACHE_LINE_SIZE];
 
@@ -451,6 +481,15 @@ typedef struct XLogCtlInsert
 	 * WAL insertion locks.
 	 */
 	WALInsertLockPadded *WALInsertLocks;
+
+	/*
+	 * Each record's xl_prev must point to the start of the record reserved
+	 * just before it.  Rather than keep that in a variable that would have to
+	 * be updated together with CurrBytePos, every inserter leaves the start
+	 * of its own record here, keyed by its end, for the next inserter to pick
+	 * up.  See ReserveXLogInsertLocation().
+	 */
+	WALPrevLink prevLinks[WAL_PREV_LINK_SLOTS];
 } XLogCtlInsert;
 
 /*
@@ -538,6 +577,18 @@ typedef struct XLogCtlData // XLOG在共享内存中的数据结构
 	 */
 	bool		WalWriterSleeping;
 
+	/*
+	 * Group flush state, see XLogFlushGroup().  groupFlushFirst is the first
+	 * backend waiting for a group flush.  groupFlushLatency is a moving
+	 * average of the time the leader spends writing and flushing the WAL, in
+	 * microseconds, and groupFlushSize a moving average of the number of
+	 * backends served by each flush (scaled by GROUP_FLUSH_SIZE_SCALE).  The
+	 * averages are only updated while holding WALWriteLock.
+	 */
+	pg_atomic_uint32 groupFlushFirst;
+	pg_atomic_uint32 groupFlushLatency;
+	pg_atomic_uint32 groupFlushSize;
+
 	/*
 	 * During recovery, we keep a copy of the latest checkpoint record here.
 	 * lastCheckPointRecPtr points to start of checkpoint record and
@@ -655,6 +706,9 @@ static XLogRecPtr XLogGetReplicationSlotMinimumLSN(void);
 static void AdvanceXLInsertBuffer(XLogRecPtr upto, TimeLineID tli,
 								  bool opportunistic);
 static void XLogWrite(XLogwrtRqst WriteRqst, TimeLineID tli, bool flexible);
+static void XLogFlushInternal(XLogRecPtr record, bool isCommit);
+static void XLogFlushGroup(XLogRecPtr record, TimeLineID insertTLI);
+static uint32 XLogGroupFlushDelay(void);
 static bool InstallXLogFileSegment(XLogSegNo *segno, char *tmppath,
 								   bool find_free, XLogSegNo max_segno,
 								   TimeLineID tli);
@@ -766,8 +820,8 @@ XLogInsertRecord(XLogRecData *rdata,
 	 * record to the shared WAL buffer cache is a two-step process:
 	 *
 	 * 1. Reserve the right amount of space from the WAL. The current head of
-	 *	  reserved space is kept in Insert->CurrBytePos, and is protected by
-	 *	  insertpos_lck.
+	 *	  reserved space is kept in Insert->CurrBytePos, and is advanced
+	 *	  atomically.
 	 *
 	 * 2. Copy the record to the reserved WAL space. This involves finding the
 	 *	  correct WAL buffer containing the reserved space, and copying the
@@ -777,7 +831,7 @@ XLogInsertRecord(XLogRecData *rdata,
 	 * inserter acquires an insertion lock. In addition to just indicating that
 	 * an insertion is in progress, the lock tells others how far the inserter
 	 * has progressed. There is a small fixed number of insertion locks,
-	 * determined by NUM_XLOGINSERT_LOCKS. When an inserter crosses a page
+	 * determined by wal_insert_locks. When an inserter crosses a page
 	 * boundary, it updates the value stored in the lock to the how far it has
 	 * inserted, to allow the previous buffer to be flushed.
 	 *
@@ -1026,6 +1080,115 @@ XLogInsertRecord(XLogRecData *rdata,
 	return EndPos;
 }
 
+/*
+ * Hash a record's end position to its home slot in Insert->prevLinks.
+ */
+static inline int
+WALPrevLinkSlot(uint64 endbytepos)
+{
+	uint64		h = (endbytepos / MAXIMUM_ALIGNOF) * UINT64CONST(0x9E3779B97F4A7C15);
+
+	return (int) (h >> (64 - WAL_PREV_LINK_BITS));
+}
+
+/*
+ * Try to publish the fact that the record reserved up to endbytepos starts at
+ * startbytepos.  Returns false if all the slots near the home slot are in
+ * use.
+ */
+static bool
+WALPrevLinkTryPublish(uint64 startbytepos, uint64 endbytepos)
+{
+	XLogCtlInsert *Insert = &XLogCtl->Insert;
+	int			home = WALPrevLinkSlot(endbytepos);
+
+	Assert(endbytepos != 0 && endbytepos != PG_UINT64_MAX);
+
+	for (int i = 0; i < WAL_PREV_LINK_PROBES; i++)
+	{
+		WALPrevLink *link = &Insert->prevLinks[(home + i) & (WAL_PREV_LINK_SLOTS - 1)];
+		uint64		expected = 0;
+
+		if (pg_atomic_read_u64(&link->endpos) != 0)
+			continue;
+
+		/* claim the slot, fill it in, then make it visible */
+		if (pg_atomic_compare_exchange_u64(&link->endpos, &expected,
+										   PG_UINT64_MAX))
+		{
+			link->startpos = startbytepos;
+			pg_write_barrier();
+			pg_atomic_write_u64(&link->endpos, endbytepos);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Like WALPrevLinkTryPublish(), but wait for a slot to become free.
+ */
+static void
+WALPrevLinkPublish(uint64 startbytepos, uint64 endbytepos)
+{
+	SpinDelayStatus delay;
+
+	if (WALPrevLinkTryPublish(startbytepos, endbytepos))
+		return;
+
+	init_local_spin_delay(&delay);
+	while (!WALPrevLinkTryPublish(startbytepos, endbytepos))
+		perform_spin_delay(&delay);
+	finish_spin_delay(&delay);
+}
+
+/*
+ * Find the start of the record that was reserved up to endbytepos, and free
+ * its slot.  Waits for the inserter that reserved it to publish it, which it
+ * does right after reserving.
+ */
+static uint64
+WALPrevLinkConsume(uint64 endbytepos)
+{
+	XLogCtlInsert *Insert = &XLogCtl->Insert;
+	int			home = WALPrevLinkSlot(endbytepos);
+	SpinDelayStatus delay;
+	bool		delayed = false;
+
+	for (;;)
+	{
+		/*
+		 * Slots are freed in any order, so an empty slot doesn't end the
+		 * search; look at all the slots the link could have been put in.
+		 */
+		for (int i = 0; i < WAL_PREV_LINK_PROBES; i++)
+		{
+			WALPrevLink *link = &Insert->prevLinks[(home + i) & (WAL_PREV_LINK_SLOTS - 1)];
+			uint64		startbytepos;
+
+			if (pg_atomic_read_u64(&link->endpos) != endbytepos)
+				continue;
+
+			pg_read_barrier();
+			startbytepos = link->startpos;
+			pg_memory_barrier();
+			pg_atomic_write_u64(&link->endpos, 0);
+
+			if (delayed)
+				finish_spin_delay(&delay);
+			return startbytepos;
+		}
+
+		if (!delayed)
+		{
+			init_local_spin_delay(&delay);
+			delayed = true;
+		}
+		perform_spin_delay(&delay);
+	}
+}
+
 /*
  * Reserves the right amount of space for a record of given size from the WAL.
  * *StartPos is set to the beginning of the reserved section, *EndPos to
@@ -1033,9 +1196,13 @@ XLogInsertRecord(XLogRecData *rdata,
  * used to set the xl_prev of this record.
  *
  * This is the performance critical part of XLogInsert that must be serialized
- * across backends. The rest can happen mostly in parallel. Try to keep this
- * section as short as possible, insertpos_lck can be heavily contended on a
- * busy system.
+ * across backends. The rest can happen mostly in parallel. The reservation
+ * itself is a single atomic fetch-add on CurrBytePos, so inserters never wait
+ * for each other here, except that we need the start of the previous
+ * record: each inserter publishes the start of its own record in prevLinks,
+ * keyed by its end, and picks up the start of the previous one from there.
+ *
+ * The caller must hold an insertion lock.
  *
  * NB: The space calculation here must match the code in CopyXLogRecordToWAL,
  * where we actually copy the record to the reserved space.
@@ -1055,24 +1222,30 @@ ReserveXLogInsertLocation(int size, XLogRecPtr *StartPos, XLogRecPtr *EndPos,
 	Assert(size > SizeOfXLogRecord);
 
 	/*
-	 * The duration the spinlock needs to be held is minimized by minimizing
-	 * the calculations that have to be done while holding the lock. The
-	 * current tip of reserved WAL is kept in CurrBytePos, as a byte position
-	 * that only counts "usable" bytes in WAL, that is, it excludes all WAL
-	 * page headers. The mapping between "usable" byte positions and physical
-	 * positions (XLogRecPtrs) can be done outside the locked region, and
-	 * because the usable byte position doesn't include any headers, reserving
-	 * X bytes from WAL is almost as simple as "CurrBytePos += X".
+	 * The current tip of reserved WAL is kept in CurrBytePos, as a byte
+	 * position that only counts "usable" bytes in WAL, that is, it excludes
+	 * all WAL page headers. The mapping between "usable" byte positions and
+	 * physical positions (XLogRecPtrs) can be done afterwards, and because
+	 * the usable byte position doesn't include any headers, reserving X bytes
+	 * from WAL is just "CurrBytePos += X".
 	 */
-	SpinLockAcquire(&Insert->insertpos_lck);
-
-	startbytepos = Insert->CurrBytePos;
+	startbytepos = pg_atomic_fetch_add_u64(&Insert->CurrBytePos, size);
 	endbytepos = startbytepos + size;
-	prevbytepos = Insert->PrevBytePos;
-	Insert->CurrBytePos = endbytepos;
-	Insert->PrevBytePos = startbytepos;
 
-	SpinLockRelease(&Insert->insertpos_lck);
+	/*
+	 * Publish our own link before waiting for the previous one, so that the
+	 * next inserter doesn't have to wait for us.  If there's no free slot,
+	 * first consume the previous link, which may free one up: a slot can
+	 * only be held up by a record reserved before ours, whose successor has
+	 * been reserved too, so waiting in this order can't deadlock.
+	 */
+	if (WALPrevLinkTryPublish(startbytepos, endbytepos))
+		prevbytepos = WALPrevLinkConsume(startbytepos);
+	else
+	{
+		prevbytepos = WALPrevLinkConsume(startbytepos);
+		WALPrevLinkPublish(startbytepos, endbytepos);
+	}
 
 	*StartPos = XLogBytePosToRecPtr(startbytepos);
 	*EndPos = XLogBytePosToEndRecPtr(endbytepos);
@@ -1108,25 +1281,22 @@ ReserveXLogSwitch(XLogRecPtr *StartPos, XLogRecPtr *EndPos, XLogRecPtr *PrevPtr)
 	uint32		segleft;
 
 	/*
-	 * These calculations are a bit heavy-weight to be done while holding a
-	 * spinlock, but since we're holding all the WAL insertion locks, there
-	 * are no other inserters competing for it. GetXLogInsertRecPtr() does
-	 * compete for it, but that's not called very frequently.
+	 * Since we're holding all the WAL insertion locks, there are no other
+	 * inserters competing for CurrBytePos, and we can read and then set it.
+	 * GetXLogInsertRecPtr() does read it, but that's harmless.
 	 */
-	SpinLockAcquire(&Insert->insertpos_lck);
+	Assert(holdingAllLocks);
 
-	startbytepos = Insert->CurrBytePos;
+	startbytepos = pg_atomic_read_u64(&Insert->CurrBytePos);
 
 	ptr = XLogBytePosToEndRecPtr(startbytepos);
 	if (XLogSegmentOffset(ptr, wal_segment_size) == 0)
 	{
-		SpinLockRelease(&Insert->insertpos_lck);
 		*EndPos = *StartPos = ptr;
 		return false;
 	}
 
 	endbytepos = startbytepos + size;
-	prevbytepos = Insert->PrevBytePos;
 
 	*StartPos = XLogBytePosToRecPtr(startbytepos);
 	*EndPos = XLogBytePosToEndRecPtr(endbytepos);
@@ -1138,10 +1308,10 @@ ReserveXLogSwitch(XLogRecPtr *StartPos, XLogRecPtr *EndPos, XLogRecPtr *PrevPtr)
 		*EndPos += segleft;
 		endbytepos = XLogRecPtrToBytePos(*EndPos);
 	}
-	Insert->CurrBytePos = endbytepos;
-	Insert->PrevBytePos = startbytepos;
+	pg_atomic_write_u64(&Insert->CurrBytePos, endbytepos);
 
-	SpinLockRelease(&Insert->insertpos_lck);
+	prevbytepos = WALPrevLinkConsume(startbytepos);
+	WALPrevLinkPublish(startbytepos, endbytepos);
 
 	*PrevPtr = XLogBytePosToRecPtr(prevbytepos);
 
@@ -1320,7 +1490,7 @@ WALInsertLockAcquire(void)
 	static int	lockToTry = -1;
 
 	if (lockToTry == -1)
-		lockToTry = MyProc->pgprocno % NUM_XLOGINSERT_LOCKS;
+		lockToTry = MyProc->pgprocno % wal_insert_locks;
 	MyLockNo = lockToTry;
 
 	/*
@@ -1338,7 +1508,7 @@ WALInsertLockAcquire(void)
 		 * than locks, it still helps to distribute the inserters evenly
 		 * across the locks.
 		 */
-		lockToTry = (lockToTry + 1) % NUM_XLOGINSERT_LOCKS;
+		lockToTry = (lockToTry + 1) % wal_insert_locks;
 	}
 }
 
@@ -1356,7 +1526,7 @@ WALInsertLockAcquireExclusive(void)
 	 * indicator is set to 0xFFFFFFFFFFFFFFFF, which is higher than any real
 	 * XLogRecPtr value, to make sure that no-one blocks waiting on those.
 	 */
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS - 1; i++)
+	for (i = 0; i < wal_insert_locks - 1; i++)
 	{
 		LWLockAcquire(&WALInsertLocks[i].l.lock, LW_EXCLUSIVE);
 		LWLockUpdateVar(&WALInsertLocks[i].l.lock,
@@ -1382,7 +1552,7 @@ WALInsertLockRelease(void)
 	{
 		int			i;
 
-		for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+		for (i = 0; i < wal_insert_locks; i++)
 			LWLockReleaseClearVar(&WALInsertLocks[i].l.lock,
 								  &WALInsertLocks[i].l.insertingAt,
 								  0);
@@ -1410,8 +1580,8 @@ WALInsertLockUpdateInsertingAt(XLogRecPtr insertingAt)
 		 * We use the last lock to mark our actual position, see comments in
 		 * WALInsertLockAcquireExclusive.
 		 */
-		LWLockUpdateVar(&WALInsertLocks[NUM_XLOGINSERT_LOCKS - 1].l.lock,
-						&WALInsertLocks[NUM_XLOGINSERT_LOCKS - 1].l.insertingAt,
+		LWLockUpdateVar(&WALInsertLocks[wal_insert_locks - 1].l.lock,
+						&WALInsertLocks[wal_insert_locks - 1].l.insertingAt,
 						insertingAt);
 	}
 	else
@@ -1446,10 +1616,13 @@ WaitXLogInsertionsToFinish(XLogRecPtr upto)
 	if (MyProc == NULL)
 		elog(PANIC, "cannot wait without a PGPROC structure");
 
-	/* Read the current insert position */
-	SpinLockAcquire(&Insert->insertpos_lck);
-	bytepos = Insert->CurrBytePos;
-	SpinLockRelease(&Insert->insertpos_lck);
+	/*
+	 * Read the current insert position.  Space is only reserved while holding
+	 * an insertion lock, so the barrier ensures that we see the lock of any
+	 * insertion into the space we see reserved.
+	 */
+	bytepos = pg_atomic_read_u64(&Insert->CurrBytePos);
+	pg_read_barrier();
 	reservedUpto = XLogBytePosToEndRecPtr(bytepos);
 
 	/*
@@ -1478,7 +1651,7 @@ WaitXLogInsertionsToFinish(XLogRecPtr upto)
 	 * out for any insertion that's still in progress.
 	 */
 	finishedUpto = reservedUpto;
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+	for (i = 0; i < wal_insert_locks; i++)
 	{
 		XLogRecPtr	insertingat = InvalidXLogRecPtr;
 
@@ -2445,9 +2618,12 @@ UpdateMinRecoveryPoint(XLogRecPtr lsn, bool force)
 	 * process as it should not update its own reference of minRecoveryPoint
 	 * until it has finished crash recovery to make sure that all WAL
 	 * available is replayed in this case.  This also saves from extra locks
-	 * taken on the control file from the startup process.
+	 * taken on the control file from the startup process.  Parallel redo
+	 * workers set InRecovery too, but they only run once recovery is
+	 * consistent, and must update minRecoveryPoint like any other process.
 	 */
-	if (XLogRecPtrIsInvalid(LocalMinRecoveryPoint) && InRecovery)
+	if (XLogRecPtrIsInvalid(LocalMinRecoveryPoint) && InRecovery &&
+		!IsParallelRedoWorker)
 	{
 		updateMinRecoveryPoint = false;
 		return;
@@ -2503,6 +2679,202 @@ UpdateMinRecoveryPoint(XLogRecPtr lsn, bool force)
 	LWLockRelease(ControlFileLock);
 }
 
+/*
+ * Decide how long a group flush leader should wait for followers to join
+ * before flushing, in microseconds.
+ *
+ * If recent flushes have each served a single backend, there's nobody to
+ * wait for, and any delay would just add to commit latency.  Otherwise we
+ * wait for a fraction of the time a flush takes, growing towards half of it
+ * as groups get larger: while we wait, backends that would otherwise have to
+ * wait for the next flush can still join ours.
+ */
+static uint32
+XLogGroupFlushDelay(void)
+{
+	uint32		size = pg_atomic_read_u32(&XLogCtl->groupFlushSize);
+	uint32		latency = pg_atomic_read_u32(&XLogCtl->groupFlushLatency);
+	uint64		delay;
+
+	if (size <= GROUP_FLUSH_SIZE_SCALE)
+		return 0;
+
+	delay = (uint64) latency * (size - GROUP_FLUSH_SIZE_SCALE) / (2 * size);
+
+	return (uint32) Min(delay, GROUP_FLUSH_MAX_DELAY);
+}
+
+/*
+ * Flush WAL up to 'record' as part of a group of backends.
+ *
+ * Every backend adds itself to a lock-free list of backends needing a flush,
+ * in the same way as ProcArrayGroupClearXid().  The first one to find the
+ * list empty becomes the leader.  It waits a little for others to join (see
+ * XLogGroupFlushDelay()), then detaches the list and flushes WAL far enough
+ * to satisfy every member with a single XLogWrite() call, and finally wakes
+ * up the followers.  Backends arriving while the leader is busy form the
+ * next group.
+ *
+ * On return, the caller's request has normally been satisfied, but the
+ * caller must check that.
+ */
+static void
+XLogFlushGroup(XLogRecPtr record, TimeLineID insertTLI)
+{
+	PGPROC	   *proc = MyProc;
+	uint32		nextidx;
+	uint32		wakeidx;
+	uint32		delay;
+	int			nmembers = 0;
+	XLogRecPtr	maxRecord = record;
+	XLogRecPtr	WriteRqstPtr;
+
+	/* Add ourselves to the list of processes needing a group flush. */
+	proc->walFlushGroupMember = true;
+	proc->walFlushGroupMemberLsn = record;
+	nextidx = pg_atomic_read_u32(&XLogCtl->groupFlushFirst);
+	while (true)
+	{
+		pg_atomic_write_u32(&proc->walFlushGroupNext, nextidx);
+
+		if (pg_atomic_compare_exchange_u32(&XLogCtl->groupFlushFirst,
+										   &nextidx,
+										   (uint32) proc->pgprocno))
+			break;
+	}
+
+	/*
+	 * If the list was not empty, the leader will flush the WAL for us.  It is
+	 * impossible to have followers without a leader because the first process
+	 * that has added itself to the list will always have nextidx as
+	 * INVALID_PGPROCNO.
+	 */
+	if (nextidx != INVALID_PGPROCNO)
+	{
+		int			extraWaits = 0;
+
+		/* Sleep until the leader has flushed our WAL. */
+		pgstat_report_wait_start(WAIT_EVENT_WAL_GROUP_FLUSH);
+		for (;;)
+		{
+			/* acts as a read barrier */
+			PGSemaphoreLock(proc->sem);
+			if (!proc->walFlushGroupMember)
+				break;
+			extraWaits++;
+		}
+		pgstat_report_wait_end();
+
+		Assert(pg_atomic_read_u32(&proc->walFlushGroupNext) == INVALID_PGPROCNO);
+
+		/* Fix semaphore count for any absorbed wakeups */
+		while (extraWaits-- > 0)
+			PGSemaphoreUnlock(proc->sem);
+		return;
+	}
+
+	/* We are the leader.  Give others a chance to join the group. */
+	delay = XLogGroupFlushDelay();
+	if (delay > 0)
+		pg_usleep(delay);
+
+	/*
+	 * Detach the list of processes waiting for a group flush.  Trying to pop
+	 * elements one at a time could lead to an ABA problem.
+	 */
+	nextidx = pg_atomic_exchange_u32(&XLogCtl->groupFlushFirst,
+									 INVALID_PGPROCNO);
+	wakeidx = nextidx;
+
+	while (nextidx != INVALID_PGPROCNO)
+	{
+		PGPROC	   *nextproc = GetPGProcByNumber(nextidx);
+
+		if (maxRecord < nextproc->walFlushGroupMemberLsn)
+			maxRecord = nextproc->walFlushGroupMemberLsn;
+		nmembers++;
+
+		nextidx = pg_atomic_read_u32(&nextproc->walFlushGroupNext);
+	}
+
+	/* Like XLogFlush(), piggyback any WAL that has been requested since */
+	WriteRqstPtr = maxRecord;
+	SpinLockAcquire(&XLogCtl->info_lck);
+	if (WriteRqstPtr < XLogCtl->LogwrtRqst.Write)
+		WriteRqstPtr = XLogCtl->LogwrtRqst.Write;
+	LogwrtResult = XLogCtl->LogwrtResult;
+	SpinLockRelease(&XLogCtl->info_lck);
+
+	if (LogwrtResult.Flush < maxRecord)
+	{
+		XLogRecPtr	insertpos;
+
+		/*
+		 * Wait for in-flight insertions before taking WALWriteLock, as in
+		 * XLogFlush().  None of the group members is inserting, so this
+		 * can't wait for any of them.
+		 */
+		insertpos = WaitXLogInsertionsToFinish(WriteRqstPtr);
+
+		LWLockAcquire(WALWriteLock, LW_EXCLUSIVE);
+
+		/* Recheck, someone else may have flushed it for us meanwhile */
+		LogwrtResult = XLogCtl->LogwrtResult;
+		if (LogwrtResult.Flush < maxRecord)
+		{
+			XLogwrtRqst WriteRqst;
+			instr_time	start;
+			instr_time	duration;
+			int64		latency;
+			int32		oldval;
+
+			WriteRqst.Write = insertpos;
+			WriteRqst.Flush = insertpos;
+
+			INSTR_TIME_SET_CURRENT(start);
+			XLogWrite(WriteRqst, insertTLI, false);
+			INSTR_TIME_SET_CURRENT(duration);
+			INSTR_TIME_SUBTRACT(duration, start);
+
+			/* Update the moving averages, with a weight of 1/8 per flush */
+			latency = Min(INSTR_TIME_GET_MICROSEC(duration), PG_INT32_MAX);
+			oldval = (int32) pg_atomic_read_u32(&XLogCtl->groupFlushLatency);
+			pg_atomic_write_u32(&XLogCtl->groupFlushLatency,
+								(uint32) (oldval + ((int32) latency - oldval) / 8));
+			oldval = (int32) pg_atomic_read_u32(&XLogCtl->groupFlushSize);
+			pg_atomic_write_u32(&XLogCtl->groupFlushSize,
+								(uint32) (oldval +
+										  (nmembers * GROUP_FLUSH_SIZE_SCALE - oldval) / 8));
+
+			PendingWalStats.wal_group_flushes++;
+			PendingWalStats.wal_group_flush_members += nmembers;
+		}
+
+		LWLockRelease(WALWriteLock);
+	}
+
+	/*
+	 * Now that we've released the lock, go back and wake everybody up.  The
+	 * followers read LogwrtResult from shared memory themselves, so all they
+	 * need to know is that we're done.
+	 */
+	while (wakeidx != INVALID_PGPROCNO)
+	{
+		PGPROC	   *nextproc = GetPGProcByNumber(wakeidx);
+
+		wakeidx = pg_atomic_read_u32(&nextproc->walFlushGroupNext);
+		pg_atomic_write_u32(&nextproc->walFlushGroupNext, INVALID_PGPROCNO);
+
+		/* ensure all previous writes are visible before follower continues. */
+		pg_write_barrier();
+
+		nextproc->walFlushGroupMember = false;
+
+		if (nextproc != MyProc)
+			PGSemaphoreUnlock(nextproc->sem);
+	}
+}
+
 /*
  * Ensure that all XLOG data through the given position is flushed to disk.
  *
@@ -2511,6 +2883,25 @@ UpdateMinRecoveryPoint(XLogRecPtr lsn, bool force)
  */
 void
 XLogFlush(XLogRecPtr record) // 确保截止到这个LSN的所有WAL记录已经被刷新到磁盘上了
+{
+	XLogFlushInternal(record, false);
+}
+
+/*
+ * Like XLogFlush(), for flushing a transaction's commit record.
+ *
+ * Only these flushes take part in wal_group_commit: the group leader may
+ * sleep before flushing, which is fine for a committing backend but not for
+ * callers such as FlushBuffer() that may hold buffer content locks.
+ */
+void
+XLogFlushCommit(XLogRecPtr record)
+{
+	XLogFlushInternal(record, true);
+}
+
+static void
+XLogFlushInternal(XLogRecPtr record, bool isCommit)
 {
 	XLogRecPtr	WriteRqstPtr;
 	XLogwrtRqst WriteRqst;
@@ -2543,6 +2934,15 @@ XLogFlush(XLogRecPtr record) // 确保截止到这个LSN的所有WAL记录已经
 
 	START_CRIT_SECTION();
 
+	/*
+	 * With wal_group_commit, a commit joins a group of backends that are
+	 * flushed together by a single leader.  That normally satisfies our
+	 * request, and the loop below just notices that; if it doesn't (a request
+	 * past the end of WAL), fall back to flushing on our own.
+	 */
+	if (isCommit && wal_group_commit && enableFsync && MyProc != NULL)
+		XLogFlushGroup(record, insertTLI);
+
 	/*
 	 * Since fsync is usually a horribly expensive operation, we try to
 	 * piggyback as much data as we can on each fsync: if we see any more data
@@ -2612,8 +3012,9 @@ XLogFlush(XLogRecPtr record) // 确保截止到这个LSN的所有WAL记录已经
 		 *
 		 * We do not sleep if enableFsync is not turned on, nor if there are
 		 * fewer than CommitSiblings other backends with active transactions.
+		 * wal_group_commit replaces this with its own adaptive delay.
 		 */
-		if (CommitDelay > 0 && enableFsync &&
+		if (CommitDelay > 0 && enableFsync && !wal_group_commit &&
 			MinimumActiveBackends(CommitSiblings))
 		{
 			pg_usleep(CommitDelay);
@@ -2855,8 +3256,10 @@ XLogNeedsFlush(XLogRecPtr record) /// 该LSN是否需要被flush，true表示需
 		 * here too.  This triggers a quick exit path for the startup process,
 		 * which cannot update its local copy of minRecoveryPoint as long as
 		 * it has not replayed all WAL available when doing crash recovery.
+		 * As above, parallel redo workers don't count.
 		 */
-		if (XLogRecPtrIsInvalid(LocalMinRecoveryPoint) && InRecovery)
+		if (XLogRecPtrIsInvalid(LocalMinRecoveryPoint) && InRecovery &&
+			!IsParallelRedoWorker)
 			updateMinRecoveryPoint = false;
 
 		/* Quick exit if already known to be updated or cannot be updated */
@@ -4249,6 +4652,29 @@ XLOGChooseNumBuffers(void)
 	return xbuffers;
 }
 
+/*
+ * Auto-tune the number of WAL insertion locks.
+ *
+ * With many backends inserting concurrently, the insertion locks become the
+ * bottleneck.  Use one lock per 16 backends, rounded up to a power of two,
+ * but no fewer than the 8 that used to be hard-wired, and no more than 128,
+ * as every lock adds overhead to flushing WAL.
+ *
+ * This should not be called until MaxBackends has received its final value.
+ */
+static int
+XLOGChooseNumInsertLocks(void)
+{
+	int			nlocks;
+
+	nlocks = pg_nextpower2_32(Max(MaxBackends / 16, 1));
+	if (nlocks < 8)
+		nlocks = 8;
+	if (nlocks > 128)
+		nlocks = 128;
+	return nlocks;
+}
+
 /*
  * GUC check_hook for wal_buffers
  */
@@ -4284,6 +4710,24 @@ check_wal_buffers(int *newval, void **extra, GucSource source)
 	return true;
 }
 
+/*
+ * GUC check_hook for wal_insert_locks
+ *
+ * -1 requests auto-tuning, which XLOGShmemSize resolves; 0 is not a usable
+ * number of locks.
+ */
+bool
+check_wal_insert_locks(int *newval, void **extra, GucSource source)
+{
+	if (*newval == 0)
+	{
+		GUC_check_errdetail("\"wal_insert_locks\" must be -1 or at least 1.");
+		return false;
+	}
+
+	return true;
+}
+
 /*
  * GUC check_hook for wal_consistency_checking
  */
@@ -4512,11 +4956,25 @@ XLOGShmemSize(void)
 	}
 	Assert(XLOGbuffers > 0);
 
+	/* Likewise for wal_insert_locks, which depends on MaxBackends */
+	if (wal_insert_locks == -1)
+	{
+		char		buf[32];
+
+		snprintf(buf, sizeof(buf), "%d", XLOGChooseNumInsertLocks());
+		SetConfigOption("wal_insert_locks", buf, PGC_POSTMASTER,
+						PGC_S_DYNAMIC_DEFAULT);
+		if (wal_insert_locks == -1) /* failed to apply it? */
+			SetConfigOption("wal_insert_locks", buf, PGC_POSTMASTER,
+							PGC_S_OVERRIDE);
+	}
+	Assert(wal_insert_locks > 0);
+
 	/* XLogCtl */
 	size = sizeof(XLogCtlData);
 
 	/* WAL insertion locks, plus alignment */
-	size = add_size(size, mul_size(sizeof(WALInsertLockPadded), NUM_XLOGINSERT_LOCKS + 1));
+	size = add_size(size, mul_size(sizeof(WALInsertLockPadded), wal_insert_locks + 1));
 	/* xlblocks array */
 	size = add_size(size, mul_size(sizeof(XLogRecPtr), XLOGbuffers));
 	/* extra alignment padding for XLOG I/O buffers */
@@ -4606,9 +5064,9 @@ XLOGShmemInit(void)
 		((uintptr_t) allocptr) % sizeof(WALInsertLockPadded);
 	WALInsertLocks = XLogCtl->Insert.WALInsertLocks =
 		(WALInsertLockPadded *) allocptr;
-	allocptr += sizeof(WALInsertLockPadded) * NUM_XLOGINSERT_LOCKS;
+	allocptr += sizeof(WALInsertLockPadded) * wal_insert_locks;
 
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+	for (i = 0; i < wal_insert_locks; i++)
 	{
 		LWLockInitialize(&WALInsertLocks[i].l.lock, LWTRANCHE_WAL_INSERT);
 		WALInsertLocks[i].l.insertingAt = InvalidXLogRecPtr;
@@ -4633,8 +5091,13 @@ XLOGShmemInit(void)
 	XLogCtl->InstallXLogFileSegmentActive = false;
 	XLogCtl->WalWriterSleeping = false;
 
-	SpinLockInit(&XLogCtl->Insert.insertpos_lck);
+	pg_atomic_init_u64(&XLogCtl->Insert.CurrBytePos, 0);
+	for (i = 0; i < WAL_PREV_LINK_SLOTS; i++)
+		pg_atomic_init_u64(&XLogCtl->Insert.prevLinks[i].endpos, 0);
 	SpinLockInit(&XLogCtl->info_lck);
+	pg_atomic_init_u32(&XLogCtl->groupFlushFirst, INVALID_PGPROCNO);
+	pg_atomic_init_u32(&XLogCtl->groupFlushLatency, 0);
+	pg_atomic_init_u32(&XLogCtl->groupFlushSize, GROUP_FLUSH_SIZE_SCALE);
 	SpinLockInit(&XLogCtl->ulsn_lck);
 }
 
@@ -4796,6 +5259,7 @@ BootStrapXLOG(void)
 	BootStrapCLOG();
 	BootStrapCommitTs();
 	BootStrapSUBTRANS();
+	BootStrapCSNLog();
 	BootStrapMultiXact();
 
 	pfree(buffer);
@@ -5209,6 +5673,12 @@ StartupXLOG(void) // 这个函数只在startup进程中调用一次
 	 */
 	StartupReorderBuffer(); // 这个是关于逻辑复制的
 
+	/*
+	 * Load the newest WAL compression dictionary, so that it's in use once
+	 * we accept connections.  Replay may install newer ones.
+	 */
+	StartupXLogDict();
+
 	/*
 	 * Startup CLOG. This must be done after ShmemVariableCache->nextXid has
 	 * been initialized and before we accept connections or begin WAL replay.
@@ -5614,8 +6084,9 @@ StartupXLOG(void) // 这个函数只在startup进程中调用一次
 	 * previous incarnation.
 	 */
 	Insert = &XLogCtl->Insert;
-	Insert->PrevBytePos = XLogRecPtrToBytePos(endOfRecoveryInfo->lastRec);
-	Insert->CurrBytePos = XLogRecPtrToBytePos(EndOfLog);
+	pg_atomic_write_u64(&Insert->CurrBytePos, XLogRecPtrToBytePos(EndOfLog));
+	WALPrevLinkPublish(XLogRecPtrToBytePos(endOfRecoveryInfo->lastRec),
+					   XLogRecPtrToBytePos(EndOfLog));
 
 	/*
 	 * Tricky point here: lastPage contains the *last* block that the LastRec
@@ -5690,6 +6161,13 @@ StartupXLOG(void) // 这个函数只在startup进程中调用一次
 	TrimCLOG();
 	TrimMultiXact();
 
+	/*
+	 * Start up the CSN log, if csn_snapshots is enabled.  This needs pg_xact
+	 * to be trimmed, and must happen before prepared transactions are
+	 * reloaded, see CSNLogSetInProgress().
+	 */
+	StartupCSNLog(oldestActiveXID);
+
 	/*
 	 * Reload shared-memory state for prepared transactions.  This needs to
 	 * happen before renaming the last partial segment of the old timeline as
@@ -6133,7 +6611,7 @@ GetLastImportantRecPtr(void)
 	XLogRecPtr	res = InvalidXLogRecPtr;
 	int			i;
 
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+	for (i = 0; i < wal_insert_locks; i++)
 	{
 		XLogRecPtr	last_important;
 
@@ -6536,7 +7014,7 @@ CreateCheckPoint(int flags) // 传入的参数只有flags标志位一个
 	 * determine the checkpoint REDO pointer.
 	 */
 	WALInsertLockAcquireExclusive(); // 阻止任何别的子进程插入WAL记录，目的是保证重做点的位置正确
-	curInsert = XLogBytePosToRecPtr(Insert->CurrBytePos);
+	curInsert = XLogBytePosToRecPtr(pg_atomic_read_u64(&Insert->CurrBytePos));
 
 	/*
 	 * If this isn't a shutdown or forced checkpoint, and if there has been no
@@ -6853,10 +7331,14 @@ CreateCheckPoint(int flags) // 传入的参数只有flags标志位一个
 	 * the oldest XMIN of any running transaction.  No future transaction will
 	 * attempt to reference any pg_subtrans entry older than that (see Asserts
 	 * in subtrans.c).  During recovery, though, we mustn't do this because
-	 * StartupSUBTRANS hasn't been called yet.
+	 * StartupSUBTRANS hasn't been called yet.  The same goes for the CSN
+	 * log, which works out its own horizon.
 	 */
 	if (!RecoveryInProgress())
+	{
 		TruncateSUBTRANS(GetOldestTransactionIdConsideredRunning());
+		TruncateCSNLog();
+	}
 
 	/* Real work is done; log and update stats. */
 	LogCheckpointEnd(false);
@@ -7028,6 +7510,7 @@ CheckPointGuts(XLogRecPtr checkPointRedo, int flags) /// 把共享内存中所
 	CheckPointCLOG();
 	CheckPointCommitTs();
 	CheckPointSUBTRANS();
+	CheckPointCSNLog();
 	CheckPointMultiXact();
 	CheckPointPredicate();
 	CheckPointBuffers(flags);
@@ -7907,6 +8390,10 @@ xlog_redo(XLogReaderState *record)
 	{
 		/* nothing to do here, handled in xlogrecovery_redo() */
 	}
+	else if (info == XLOG_WAL_DICTIONARY)
+	{
+		XLogDictRedo(record);
+	}
 	else if (info == XLOG_END_OF_RECOVERY)
 	{
 		xl_end_of_recovery xlrec;
@@ -8905,9 +9392,7 @@ GetXLogInsertRecPtr(void)
 	XLogCtlInsert *Insert = &XLogCtl->Insert;
 	uint64		current_bytepos;
 
-	SpinLockAcquire(&Insert->insertpos_lck);
-	current_bytepos = Insert->CurrBytePos;
-	SpinLockRelease(&Insert->insertpos_lck);
+	current_bytepos = pg_atomic_read_u64(&Insert->CurrBytePos);
 
 	return XLogBytePosToRecPtr(current_bytepos);
 }
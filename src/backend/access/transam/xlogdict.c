@@ -0,0 +1,599 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogdict.c
+ *		Dictionaries for compressing full-page images in WAL.
+ *
+ * Full-page images are compressed one page at a time, which leaves little
+ * for a general-purpose compressor to work with: 8kB of heap or index page
+ * is mostly headers, line pointers and tuple headers that look alike across
+ * pages but not within one.  With wal_compression = zstd_dict, images are
+ * instead compressed with a zstd dictionary trained on pages of the cluster
+ * itself (see pg_train_wal_dictionary()), which captures exactly that
+ * shared structure.
+ *
+ * Dictionaries are kept in XLOG_DICT_DIR, named after their ID, and never
+ * removed, because replay of old WAL (archive recovery, standbys catching up,
+ * pg_waldump) may need any of them.  The ID is stored in every zstd frame, so
+ * a compressed image identifies the dictionary needed to decompress it.  The
+ * newest dictionary is the one used for compression; its contents are kept
+ * in shared memory, from which each backend builds its own digested copy.
+ *
+ * Installing a dictionary is WAL-logged with the full dictionary, like
+ * relation map updates, so standbys and archive recovery recreate the file
+ * before replaying any image compressed with it.
+ *
+ * Portions Copyright (c) 2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *		src/backend/access/transam/xlogdict.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef USE_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
+
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "access/relation.h"
+#include "access/table.h"
+#include "access/tableam.h"
+#include "access/xlog.h"
+#include "access/xlog_internal.h"
+#include "access/xlogdict.h"
+#include "access/xloginsert.h"
+#include "catalog/pg_class.h"
+#include "catalog/pg_control.h"
+#include "common/pg_prng.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "port/atomics.h"
+#include "storage/bufmgr.h"
+#include "storage/bufpage.h"
+#include "storage/fd.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/builtins.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+
+/*
+ * Shared copy of the newest dictionary.  dict_id is 0 if there is none.
+ * dict_size and dict are protected by WALDictionaryLock; dict_id can be read
+ * without it, to check whether a backend's copy is still current.
+ */
+typedef struct XLogDictCtlData
+{
+	pg_atomic_uint32 dict_id;
+	uint32		dict_size;
+	char		dict[XLOG_DICT_MAX_SIZE];
+} XLogDictCtlData;
+
+static XLogDictCtlData *XLogDictCtl = NULL;
+
+#ifdef USE_ZSTD
+/* This backend's digested copy of the shared dictionary */
+static ZSTD_CDict *XLogDictCDict = NULL;
+static uint32 XLogDictCDictId = 0;
+static ZSTD_CCtx *XLogDictCCtx = NULL;
+#endif
+
+static void XLogDictWriteFile(uint32 dict_id, const char *dict,
+							  uint32 dict_size, bool write_wal);
+static void XLogDictPublish(uint32 dict_id, const char *dict,
+							uint32 dict_size);
+
+/*
+ * Report shared-memory space needed by XLogDictShmemInit.
+ */
+Size
+XLogDictShmemSize(void)
+{
+	return sizeof(XLogDictCtlData);
+}
+
+/*
+ * Allocate and initialize shared memory for WAL compression dictionaries.
+ */
+void
+XLogDictShmemInit(void)
+{
+	bool		found;
+
+	XLogDictCtl = (XLogDictCtlData *)
+		ShmemInitStruct("WAL Dictionary Ctl", XLogDictShmemSize(), &found);
+
+	if (!found)
+	{
+		pg_atomic_init_u32(&XLogDictCtl->dict_id, 0);
+		XLogDictCtl->dict_size = 0;
+	}
+}
+
+/*
+ * Load the newest dictionary from disk into shared memory.  Called once
+ * during startup, before WAL replay; replay may install newer ones.
+ */
+void
+StartupXLogDict(void)
+{
+	DIR		   *dir;
+	struct dirent *de;
+	uint32		newest = 0;
+	char		path[MAXPGPATH];
+	char	   *dict;
+	struct stat st;
+	int			fd;
+	int			r;
+
+	dir = AllocateDir(XLOG_DICT_DIR);
+	if (dir == NULL && errno == ENOENT)
+		return;					/* no dictionary was ever installed */
+
+	while ((de = ReadDir(dir, XLOG_DICT_DIR)) != NULL)
+	{
+		uint32		dict_id;
+
+		if (!IsXLogDictFileName(de->d_name))
+			continue;
+
+		sscanf(de->d_name, "%08X", &dict_id);
+		if (dict_id > newest)
+			newest = dict_id;
+	}
+	FreeDir(dir);
+
+	if (newest == 0)
+		return;
+
+	XLogDictFilePath(path, XLOG_DICT_DIR, newest);
+
+	fd = OpenTransientFile(path, O_RDONLY | PG_BINARY);
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", path)));
+	if (fstat(fd, &st) < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not stat file \"%s\": %m", path)));
+	if (st.st_size < XLOG_DICT_MIN_SIZE || st.st_size > XLOG_DICT_MAX_SIZE)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("WAL compression dictionary file \"%s\" has invalid size %lld",
+						path, (long long) st.st_size)));
+
+	dict = palloc(st.st_size);
+
+	pgstat_report_wait_start(WAIT_EVENT_WAL_DICTIONARY_READ);
+	r = read(fd, dict, st.st_size);
+	if (r != st.st_size)
+	{
+		if (r < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read file \"%s\": %m", path)));
+		else
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("could not read file \"%s\": read %d of %lld",
+							path, r, (long long) st.st_size)));
+	}
+	pgstat_report_wait_end();
+
+	if (CloseTransientFile(fd) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not close file \"%s\": %m", path)));
+
+	LWLockAcquire(WALDictionaryLock, LW_EXCLUSIVE);
+	XLogDictPublish(newest, dict, st.st_size);
+	LWLockRelease(WALDictionaryLock);
+	pfree(dict);
+}
+
+/*
+ * Make a dictionary the one used for compression.  The caller must hold
+ * WALDictionaryLock exclusively.
+ */
+static void
+XLogDictPublish(uint32 dict_id, const char *dict, uint32 dict_size)
+{
+	Assert(LWLockHeldByMeInMode(WALDictionaryLock, LW_EXCLUSIVE));
+	Assert(dict_size <= XLOG_DICT_MAX_SIZE);
+
+	memcpy(XLogDictCtl->dict, dict, dict_size);
+	XLogDictCtl->dict_size = dict_size;
+	pg_atomic_write_u32(&XLogDictCtl->dict_id, dict_id);
+}
+
+/*
+ * Write a dictionary to its file in XLOG_DICT_DIR, WAL-logging it first if
+ * write_wal is true.  The caller must hold WALDictionaryLock exclusively.
+ */
+static void
+XLogDictWriteFile(uint32 dict_id, const char *dict, uint32 dict_size,
+				  bool write_wal)
+{
+	char		path[MAXPGPATH];
+	char		tmppath[MAXPGPATH];
+	int			fd;
+
+	if (MakePGDirectory(XLOG_DICT_DIR) < 0 && errno != EEXIST)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not create directory \"%s\": %m",
+						XLOG_DICT_DIR)));
+
+	XLogDictFilePath(path, XLOG_DICT_DIR, dict_id);
+	snprintf(tmppath, sizeof(tmppath), "%s.tmp", path);
+
+	/*
+	 * A temporary file left over from a crash can be overwritten.
+	 */
+	fd = OpenTransientFile(tmppath, O_WRONLY | O_CREAT | O_TRUNC | PG_BINARY);
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", tmppath)));
+
+	pgstat_report_wait_start(WAIT_EVENT_WAL_DICTIONARY_WRITE);
+	if (write(fd, dict, dict_size) != dict_size)
+	{
+		/* if write didn't set errno, assume problem is no disk space */
+		if (errno == 0)
+			errno = ENOSPC;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write file \"%s\": %m", tmppath)));
+	}
+	pgstat_report_wait_end();
+
+	if (CloseTransientFile(fd) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not close file \"%s\": %m", tmppath)));
+
+	if (write_wal)
+	{
+		xl_wal_dictionary xlrec;
+		XLogRecPtr	lsn;
+
+		xlrec.dict_id = dict_id;
+		xlrec.dict_size = dict_size;
+
+		XLogBeginInsert();
+		XLogRegisterData((char *) &xlrec, sizeof(xl_wal_dictionary));
+		XLogRegisterData(unconstify(char *, dict), dict_size);
+
+		lsn = XLogInsert(RM_XLOG_ID, XLOG_WAL_DICTIONARY);
+
+		/*
+		 * The file must not become visible before the record is durable;
+		 * otherwise a restart could start compressing with a dictionary that
+		 * standbys never receive.
+		 */
+		XLogFlush(lsn);
+	}
+
+	durable_rename(tmppath, path, ERROR);
+}
+
+/*
+ * Install a new dictionary, and make it the one used for compression.
+ * The dictionary must be in zstd's dictionary format; its ID is overwritten
+ * with the next free one, which is returned.
+ */
+uint32
+XLogDictInstall(char *dict, uint32 dict_size)
+{
+	uint32		dict_id;
+
+	if (dict_size < XLOG_DICT_MIN_SIZE || dict_size > XLOG_DICT_MAX_SIZE)
+		elog(ERROR, "invalid WAL compression dictionary size %u", dict_size);
+
+	/* Held until the new dictionary is published, to serialize installs */
+	LWLockAcquire(WALDictionaryLock, LW_EXCLUSIVE);
+
+	dict_id = pg_atomic_read_u32(&XLogDictCtl->dict_id);
+	dict_id = (dict_id == 0) ? XLOG_DICT_FIRST_ID : dict_id + 1;
+
+	/*
+	 * A zstd dictionary starts with a 4-byte magic number followed by the
+	 * 4-byte little-endian dictionary ID, which is copied into every frame
+	 * compressed with it.
+	 */
+	dict[4] = dict_id & 0xFF;
+	dict[5] = (dict_id >> 8) & 0xFF;
+	dict[6] = (dict_id >> 16) & 0xFF;
+	dict[7] = (dict_id >> 24) & 0xFF;
+
+	XLogDictWriteFile(dict_id, dict, dict_size, true);
+	XLogDictPublish(dict_id, dict, dict_size);
+
+	LWLockRelease(WALDictionaryLock);
+
+	return dict_id;
+}
+
+/*
+ * Replay of XLOG_WAL_DICTIONARY.
+ */
+void
+XLogDictRedo(XLogReaderState *record)
+{
+	xl_wal_dictionary xlrec;
+	char	   *dict;
+
+	if (XLogRecGetDataLen(record) < sizeof(xl_wal_dictionary))
+		elog(PANIC, "invalid WAL compression dictionary record");
+
+	memcpy(&xlrec, XLogRecGetData(record), sizeof(xl_wal_dictionary));
+	dict = XLogRecGetData(record) + sizeof(xl_wal_dictionary);
+
+	if (XLogRecGetDataLen(record) != sizeof(xl_wal_dictionary) + xlrec.dict_size ||
+		xlrec.dict_size > XLOG_DICT_MAX_SIZE)
+		elog(PANIC, "invalid WAL compression dictionary record");
+
+	LWLockAcquire(WALDictionaryLock, LW_EXCLUSIVE);
+
+	XLogDictWriteFile(xlrec.dict_id, dict, xlrec.dict_size, false);
+
+	/* So that it's used once we're promoted */
+	if (xlrec.dict_id > pg_atomic_read_u32(&XLogDictCtl->dict_id))
+		XLogDictPublish(xlrec.dict_id, dict, xlrec.dict_size);
+
+	LWLockRelease(WALDictionaryLock);
+}
+
+/*
+ * Compress a page image with the current dictionary.  Returns the compressed
+ * length, or -1 if there is no dictionary or the data couldn't be compressed
+ * into the space available.
+ *
+ * This is called while assembling a WAL record, usually in a critical
+ * section, so it mustn't throw errors.  zstd allocates with malloc(), and
+ * failures are reported as -1 like any other.
+ */
+int32
+XLogDictCompress(const char *source, int32 slen, char *dest, int32 capacity)
+{
+#ifdef USE_ZSTD
+	uint32		dict_id = pg_atomic_read_u32(&XLogDictCtl->dict_id);
+	size_t		len;
+
+	if (dict_id == 0)
+		return -1;
+
+	if (dict_id != XLogDictCDictId)
+	{
+		if (XLogDictCDict != NULL)
+			ZSTD_freeCDict(XLogDictCDict);
+		XLogDictCDictId = 0;
+
+		LWLockAcquire(WALDictionaryLock, LW_SHARED);
+		XLogDictCDict = ZSTD_createCDict(XLogDictCtl->dict,
+										 XLogDictCtl->dict_size,
+										 ZSTD_CLEVEL_DEFAULT);
+		dict_id = pg_atomic_read_u32(&XLogDictCtl->dict_id);
+		LWLockRelease(WALDictionaryLock);
+
+		if (XLogDictCDict == NULL)
+			return -1;
+		XLogDictCDictId = dict_id;
+	}
+
+	if (XLogDictCCtx == NULL)
+	{
+		XLogDictCCtx = ZSTD_createCCtx();
+		if (XLogDictCCtx == NULL)
+			return -1;
+	}
+
+	len = ZSTD_compress_usingCDict(XLogDictCCtx, dest, capacity,
+								   source, slen, XLogDictCDict);
+	if (ZSTD_isError(len))
+		return -1;
+
+	return (int32) len;
+#else
+	return -1;
+#endif
+}
+
+/*
+ * SQL-callable function to train a dictionary on pages of the current
+ * database and install it.  Returns the ID of the new dictionary.
+ *
+ * Pages are sampled uniformly from all permanent relations the current user
+ * can open, and stored without their hole, like full-page images are.
+ */
+Datum
+pg_train_wal_dictionary(PG_FUNCTION_ARGS)
+{
+#ifdef USE_ZSTD
+	int32		dict_size = PG_GETARG_INT32(0);
+	int32		sample_pages = PG_GETARG_INT32(1);
+	Relation	pg_class;
+	TableScanDesc scan;
+	HeapTuple	tuple;
+	List	   *relids = NIL;
+	BlockNumber *relblocks;
+	uint64		total_blocks = 0;
+	BufferAccessStrategy strategy;
+	char	   *samples;
+	size_t	   *sample_sizes;
+	int			nsamples = 0;
+	Size		samples_len = 0;
+	char	   *dict;
+	size_t		len;
+	ListCell   *lc;
+	int			i;
+
+	if (RecoveryInProgress())
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("recovery is in progress"),
+				 errhint("WAL control functions cannot be executed during recovery.")));
+
+	if (dict_size < XLOG_DICT_MIN_SIZE || dict_size > XLOG_DICT_MAX_SIZE)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("dictionary size must be between %d and %d",
+						XLOG_DICT_MIN_SIZE, XLOG_DICT_MAX_SIZE)));
+
+	if (sample_pages < 1 || sample_pages > MaxAllocHugeSize / BLCKSZ)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of sample pages must be positive")));
+
+	/* Find the relations to sample */
+	pg_class = table_open(RelationRelationId, AccessShareLock);
+	scan = table_beginscan_catalog(pg_class, 0, NULL);
+	while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		Form_pg_class classForm = (Form_pg_class) GETSTRUCT(tuple);
+
+		if (classForm->relpersistence != RELPERSISTENCE_PERMANENT)
+			continue;
+		if (classForm->relkind != RELKIND_RELATION &&
+			classForm->relkind != RELKIND_INDEX &&
+			classForm->relkind != RELKIND_MATVIEW &&
+			classForm->relkind != RELKIND_TOASTVALUE)
+			continue;
+
+		relids = lappend_oid(relids, classForm->oid);
+	}
+	table_endscan(scan);
+	table_close(pg_class, AccessShareLock);
+
+	relblocks = palloc0(sizeof(BlockNumber) * Max(list_length(relids), 1));
+	i = 0;
+	foreach(lc, relids)
+	{
+		Relation	rel = try_relation_open(lfirst_oid(lc), AccessShareLock);
+
+		if (rel != NULL)
+		{
+			relblocks[i] = RelationGetNumberOfBlocks(rel);
+			total_blocks += relblocks[i];
+			relation_close(rel, AccessShareLock);
+		}
+		i++;
+	}
+
+	samples = palloc_extended((Size) sample_pages * BLCKSZ, MCXT_ALLOC_HUGE);
+	sample_sizes = palloc(sizeof(size_t) * sample_pages);
+	strategy = GetAccessStrategy(BAS_BULKREAD);
+
+	/* Sample each relation in proportion to its size */
+	i = 0;
+	foreach(lc, relids)
+	{
+		BlockNumber nblocks = relblocks[i++];
+		Relation	rel;
+		int			nsample;
+
+		if (nblocks == 0 || nsamples >= sample_pages)
+			continue;
+
+		nsample = Max((uint64) sample_pages * nblocks / total_blocks, 1);
+		nsample = Min(nsample, sample_pages - nsamples);
+
+		rel = try_relation_open(lfirst_oid(lc), AccessShareLock);
+		if (rel == NULL)
+			continue;
+
+		/* The relation may have been truncated meanwhile */
+		nblocks = Min(nblocks, RelationGetNumberOfBlocks(rel));
+
+		while (nblocks > 0 && nsample-- > 0)
+		{
+			BlockNumber blkno;
+			Buffer		buf;
+			Page		page;
+			char	   *dest = samples + samples_len;
+			uint16		lower;
+			uint16		upper;
+
+			CHECK_FOR_INTERRUPTS();
+
+			blkno = (BlockNumber) pg_prng_uint64_range(&pg_global_prng_state,
+													   0, nblocks - 1);
+			buf = ReadBufferExtended(rel, MAIN_FORKNUM, blkno, RBM_NORMAL,
+									 strategy);
+			LockBuffer(buf, BUFFER_LOCK_SHARE);
+			page = BufferGetPage(buf);
+
+			if (PageIsNew(page))
+			{
+				UnlockReleaseBuffer(buf);
+				continue;
+			}
+
+			/* Leave out the hole, as XLogRecordAssemble() does */
+			lower = ((PageHeader) page)->pd_lower;
+			upper = ((PageHeader) page)->pd_upper;
+			if (lower >= SizeOfPageHeaderData && upper > lower &&
+				upper <= BLCKSZ)
+			{
+				memcpy(dest, page, lower);
+				memcpy(dest + lower, page + upper, BLCKSZ - upper);
+				sample_sizes[nsamples] = BLCKSZ - (upper - lower);
+			}
+			else
+			{
+				memcpy(dest, page, BLCKSZ);
+				sample_sizes[nsamples] = BLCKSZ;
+			}
+			UnlockReleaseBuffer(buf);
+
+			samples_len += sample_sizes[nsamples];
+			nsamples++;
+		}
+
+		relation_close(rel, AccessShareLock);
+	}
+
+	FreeAccessStrategy(strategy);
+
+	if (nsamples < 8)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("not enough data to train a WAL compression dictionary"),
+				 errdetail("Only %d non-empty pages were found in the current database.",
+						   nsamples)));
+
+	dict = palloc(dict_size);
+	len = ZDICT_trainFromBuffer(dict, dict_size, samples, sample_sizes,
+								nsamples);
+	if (ZDICT_isError(len))
+		ereport(ERROR,
+				(errmsg("could not train WAL compression dictionary: %s",
+						ZDICT_getErrorName(len))));
+	if (len < XLOG_DICT_MIN_SIZE)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("not enough data to train a WAL compression dictionary"),
+				 errdetail("The trained dictionary has only %zu bytes.", len)));
+
+	pfree(samples);
+	pfree(sample_sizes);
+
+	PG_RETURN_INT32((int32) XLogDictInstall(dict, len));
+#else
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("compression method %s not supported", "zstd"),
+			 errdetail("This functionality requires the server to be built with zstd support.")));
+	PG_RETURN_NULL();
+#endif
+}
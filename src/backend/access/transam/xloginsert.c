@@ -30,6 +30,7 @@
 #include "access/xact.h"
 #include "access/xlog.h"
 #include "access/xlog_internal.h"
+#include "access/xlogdict.h"
 #include "access/xloginsert.h"
 #include "catalog/pg_control.h"
 #include "common/pg_lzcompress.h"
@@ -140,7 +141,8 @@ static XLogRecData *XLogRecordAssemble(RmgrId rmid, uint8 info,
 									   XLogRecPtr *fpw_lsn, int *num_fpi,
 									   bool *topxid_included);
 static bool XLogCompressBackupBlock(char *page, uint16 hole_offset,
-									uint16 hole_length, char *dest, uint16 *dlen);
+									uint16 hole_length, char *dest,
+									uint16 *dlen, uint8 *method);
 
 /*
  * Begin constructing a WAL record. This must be called before the
@@ -637,6 +639,7 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 		{
 			Page		page = regbuf->page;
 			uint16		compressed_len = 0;
+			uint8		compress_method = 0;
 
 			/*
 			 * The page needs to be backed up, so calculate its hole length
@@ -678,7 +681,8 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 					XLogCompressBackupBlock(page, bimg.hole_offset,
 											cbimg.hole_length,
 											regbuf->compressed_page,
-											&compressed_len);
+											&compressed_len,
+											&compress_method);
 			}
 
 			/*
@@ -713,33 +717,7 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
 				bimg.length = compressed_len;
 
 				/* Set the compression method used for this block */
-				switch ((WalCompression) wal_compression)
-				{
-					case WAL_COMPRESSION_PGLZ:
-						bimg.bimg_info |= BKPIMAGE_COMPRESS_PGLZ;
-						break;
-
-					case WAL_COMPRESSION_LZ4:
-#ifdef USE_LZ4
-						bimg.bimg_info |= BKPIMAGE_COMPRESS_LZ4;
-#else
-						elog(ERROR, "LZ4 is not supported by this build");
-#endif
-						break;
-
-					case WAL_COMPRESSION_ZSTD:
-#ifdef USE_ZSTD
-						bimg.bimg_info |= BKPIMAGE_COMPRESS_ZSTD;
-#else
-						elog(ERROR, "zstd is not supported by this build");
-#endif
-						break;
-
-					case WAL_COMPRESSION_NONE:
-						Assert(false);	/* cannot happen */
-						break;
-						/* no default case, so that compiler will warn */
-				}
+				bimg.bimg_info |= compress_method;
 
 				rdt_datas_last->data = regbuf->compressed_page;
 				rdt_datas_last->len = compressed_len;
@@ -926,11 +904,12 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
  *
  * Returns false if compression fails (i.e., compressed result is actually
  * bigger than original). Otherwise, returns true and sets 'dlen' to
- * the length of compressed block image.
+ * the length of compressed block image, and 'method' to the
+ * BKPIMAGE_COMPRESS_* flag for the method used.
  */
 static bool
 XLogCompressBackupBlock(char *page, uint16 hole_offset, uint16 hole_length,
-						char *dest, uint16 *dlen)
+						char *dest, uint16 *dlen, uint8 *method)
 {
 	int32		orig_len = BLCKSZ - hole_length;
 	int32		len = -1;
@@ -960,6 +939,7 @@ XLogCompressBackupBlock(char *page, uint16 hole_offset, uint16 hole_length,
 	{
 		case WAL_COMPRESSION_PGLZ:
 			len = pglz_compress(source, orig_len, dest, PGLZ_strategy_default);
+			*method = BKPIMAGE_COMPRESS_PGLZ;
 			break;
 
 		case WAL_COMPRESSION_LZ4:
@@ -968,17 +948,33 @@ XLogCompressBackupBlock(char *page, uint16 hole_offset, uint16 hole_length,
 									   COMPRESS_BUFSIZE);
 			if (len <= 0)
 				len = -1;		/* failure */
+			*method = BKPIMAGE_COMPRESS_LZ4;
 #else
 			elog(ERROR, "LZ4 is not supported by this build");
 #endif
 			break;
 
+		case WAL_COMPRESSION_ZSTD_DICT:
+#ifdef USE_ZSTD
+			len = XLogDictCompress(source, orig_len, dest, COMPRESS_BUFSIZE);
+			if (len >= 0)
+			{
+				*method = BKPIMAGE_COMPRESS_ZSTD_DICT;
+				break;
+			}
+			/* no dictionary installed yet, or it failed; try plain zstd */
+#else
+			elog(ERROR, "zstd is not supported by this build");
+#endif
+			/* FALLTHROUGH */
+
 		case WAL_COMPRESSION_ZSTD:
 #ifdef USE_ZSTD
 			len = ZSTD_compress(dest, COMPRESS_BUFSIZE, source, orig_len,
 								ZSTD_CLEVEL_DEFAULT);
 			if (ZSTD_isError(len))
 				len = -1;		/* failure */
+			*method = BKPIMAGE_COMPRESS_ZSTD;
 #else
 			elog(ERROR, "zstd is not supported by this build");
 #endif
@@ -17,7 +17,9 @@
  */
 #include "postgres.h"
 
+#include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
 #ifdef USE_LZ4
 #include <lz4.h>
 #endif
@@ -36,6 +38,7 @@
 #ifndef FRONTEND
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "storage/fd.h"
 #include "utils/memutils.h"
 #else
 #include "common/logging.h"
@@ -55,6 +58,9 @@ static bool ValidXLogRecord(XLogReaderState *state, XLogRecord *record,
 static void ResetDecoder(XLogReaderState *state);
 static void WALOpenSegmentInit(WALOpenSegment *seg, WALSegmentContext *segcxt,
 							   int segsize, const char *waldir);
+#ifdef USE_ZSTD
+static bool XLogReaderLoadDict(XLogReaderState *state, uint32 dict_id);
+#endif
 
 /* size of the buffer allocated for error message. */
 #define MAX_ERRORMSG_LEN 1000
@@ -172,6 +178,12 @@ XLogReaderFree(XLogReaderState *state)
 	if (state->readRecordBuf)
 		pfree(state->readRecordBuf);
 	pfree(state->readBuf);
+#ifdef USE_ZSTD
+	if (state->zstd_ddict)
+		ZSTD_freeDDict(state->zstd_ddict);
+	if (state->zstd_dctx)
+		ZSTD_freeDCtx(state->zstd_dctx);
+#endif
 	pfree(state);
 }
 
@@ -2096,6 +2108,37 @@ RestoreBlockImage(XLogReaderState *record, uint8 block_id, char *page)
 								  "zstd",
 								  block_id);
 			return false;
+#endif
+		}
+		else if ((bkpb->bimg_info & BKPIMAGE_COMPRESS_ZSTD_DICT) != 0)
+		{
+#ifdef USE_ZSTD
+			uint32		dict_id = ZSTD_getDictID_fromFrame(ptr, bkpb->bimg_len);
+			size_t		decomp_result;
+
+			if (dict_id != record->zstd_dict_id &&
+				!XLogReaderLoadDict(record, dict_id))
+				return false;
+
+			if (record->zstd_dctx == NULL &&
+				(record->zstd_dctx = ZSTD_createDCtx()) == NULL)
+				decomp_success = false;
+			else
+			{
+				decomp_result = ZSTD_decompress_usingDDict(record->zstd_dctx,
+														   tmp.data,
+														   BLCKSZ - bkpb->hole_length,
+														   ptr, bkpb->bimg_len,
+														   record->zstd_ddict);
+				if (ZSTD_isError(decomp_result))
+					decomp_success = false;
+			}
+#else
+			report_invalid_record(record, "could not restore image at %X/%X compressed with %s not supported by build, block %d",
+								  LSN_FORMAT_ARGS(record->ReadRecPtr),
+								  "zstd",
+								  block_id);
+			return false;
 #endif
 		}
 		else
@@ -2135,6 +2178,96 @@ RestoreBlockImage(XLogReaderState *record, uint8 block_id, char *page)
 	return true;
 }
 
+#ifdef USE_ZSTD
+/*
+ * Load the dictionary needed to decompress a BKPIMAGE_COMPRESS_ZSTD_DICT
+ * image, replacing the one loaded previously.
+ *
+ * Returns true if successful.  On failure, the error is reported with
+ * report_invalid_record(), and false is returned.
+ */
+static bool
+XLogReaderLoadDict(XLogReaderState *state, uint32 dict_id)
+{
+	char		path[MAXPGPATH];
+	struct stat st;
+	char	   *dict;
+	int			fd;
+	int			r;
+
+	if (state->zstd_ddict)
+		ZSTD_freeDDict(state->zstd_ddict);
+	state->zstd_ddict = NULL;
+	state->zstd_dict_id = 0;
+
+	if (dict_id == 0)
+	{
+		report_invalid_record(state, "compressed image at %X/%X has no dictionary ID",
+							  LSN_FORMAT_ARGS(state->ReadRecPtr));
+		return false;
+	}
+
+	XLogDictFilePath(path, state->dict_dir ? state->dict_dir : XLOG_DICT_DIR,
+					 dict_id);
+
+#ifndef FRONTEND
+	fd = OpenTransientFile(path, O_RDONLY | PG_BINARY);
+#else
+	fd = open(path, O_RDONLY | PG_BINARY, 0);
+#endif
+	if (fd < 0)
+	{
+		report_invalid_record(state, "could not open WAL compression dictionary \"%s\": %m",
+							  path);
+		return false;
+	}
+
+	if (fstat(fd, &st) == 0)
+	{
+		dict = palloc(st.st_size);
+#ifndef FRONTEND
+		pgstat_report_wait_start(WAIT_EVENT_WAL_DICTIONARY_READ);
+#endif
+		r = read(fd, dict, st.st_size);
+#ifndef FRONTEND
+		pgstat_report_wait_end();
+#endif
+	}
+	else
+	{
+		dict = NULL;
+		r = -1;
+	}
+
+#ifndef FRONTEND
+	CloseTransientFile(fd);
+#else
+	close(fd);
+#endif
+
+	if (dict == NULL || r != st.st_size)
+	{
+		report_invalid_record(state, "could not read WAL compression dictionary \"%s\"",
+							  path);
+		if (dict)
+			pfree(dict);
+		return false;
+	}
+
+	state->zstd_ddict = ZSTD_createDDict(dict, st.st_size);
+	pfree(dict);
+	if (state->zstd_ddict == NULL)
+	{
+		report_invalid_record(state, "could not load WAL compression dictionary \"%s\"",
+							  path);
+		return false;
+	}
+	state->zstd_dict_id = dict_id;
+
+	return true;
+}
+#endif
+
 #ifndef FRONTEND
 
 /*
@@ -39,6 +39,7 @@
 #include "access/xlogprefetcher.h"
 #include "access/xlogreader.h"
 #include "access/xlogrecovery.h"
+#include "access/xlogredoworker.h"
 #include "access/xlogutils.h"
 #include "backup/basebackup.h"
 #include "catalog/pg_control.h"
@@ -184,6 +185,15 @@ static bool LocalPromoteIsTriggered = false;
 /* Has the recovery code requested a walreceiver wakeup? */
 static bool doRequestWalReceiverReply;
 
+/*
+ * Last record replayed while parallel redo workers were still busy with
+ * earlier records.  It's published as lastReplayed* once they're done.
+ */
+static bool parallelRedoPending = false;
+static XLogRecPtr pendingReplayedReadRecPtr;
+static XLogRecPtr pendingReplayedEndRecPtr;
+static TimeLineID pendingReplayedTLI;
+
 /* XLogReader object used to parse the WAL records */
 static XLogReaderState *xlogreader = NULL;
 
@@ -396,6 +406,7 @@ static bool read_tablespace_map(List **tablespaces);
 static void xlogrecovery_redo(XLogReaderState *record, TimeLineID replayTLI);
 static void CheckRecoveryConsistency(void);
 static void rm_redo_error_callback(void *arg);
+static void WaitForParallelRedo(void);
 #ifdef WAL_DEBUG
 static void xlog_outrec(StringInfo buf, XLogReaderState *record);
 #endif
@@ -1764,6 +1775,10 @@ PerformWalRecovery(void) // 执行恢复工作
 		 * end of main redo apply loop
 		 */
 
+		/* Wait for parallel redo workers to finish, and make them exit */
+		WaitForParallelRedo();
+		ParallelRedoShutdown();
+
 		if (reachedRecoveryTarget)
 		{
 			if (!reachedConsistency)
@@ -1915,29 +1930,48 @@ ApplyWalRecord(XLogReaderState *xlogreader, XLogRecord *record, TimeLineID *repl
 	if (record->xl_rmid == RM_XLOG_ID)
 		xlogrecovery_redo(xlogreader, *replayTLI);
 
-	/* Now apply the WAL record itself */
-	GetRmgr(record->xl_rmid).rm_redo(xlogreader); // 调用不同的指针函数去redo
-
 	/*
-	 * After redo, check whether the backup pages associated with the WAL
-	 * record are consistent with the existing pages. This check is done only
-	 * if consistency check is enabled for this record.
+	 * Now apply the WAL record itself, unless a parallel redo worker will.
+	 * If it won't, ParallelRedoDispatch() has waited for any workers whose
+	 * pending work could conflict with it.
 	 */
-	if ((record->xl_info & XLR_CHECK_CONSISTENCY) != 0)
-		verifyBackupPageConsistency(xlogreader);
+	if (!ParallelRedoDispatch(xlogreader))
+	{
+		GetRmgr(record->xl_rmid).rm_redo(xlogreader); // 调用不同的指针函数去redo
+
+		/*
+		 * After redo, check whether the backup pages associated with the WAL
+		 * record are consistent with the existing pages. This check is done
+		 * only if consistency check is enabled for this record.
+		 */
+		if ((record->xl_info & XLR_CHECK_CONSISTENCY) != 0)
+			verifyBackupPageConsistency(xlogreader);
+	}
 
 	/* Pop the error context stack */
 	error_context_stack = errcallback.previous;
 
 	/*
 	 * Update lastReplayedEndRecPtr after this record has been successfully
-	 * replayed.
+	 * replayed.  If parallel redo workers still have records before it to
+	 * replay, remember it and publish it once they're done.
 	 */
-	SpinLockAcquire(&XLogRecoveryCtl->info_lck);
-	XLogRecoveryCtl->lastReplayedReadRecPtr = xlogreader->ReadRecPtr;
-	XLogRecoveryCtl->lastReplayedEndRecPtr = xlogreader->EndRecPtr;
-	XLogRecoveryCtl->lastReplayedTLI = *replayTLI;
-	SpinLockRelease(&XLogRecoveryCtl->info_lck);
+	if (ParallelRedoIdle())
+	{
+		SpinLockAcquire(&XLogRecoveryCtl->info_lck);
+		XLogRecoveryCtl->lastReplayedReadRecPtr = xlogreader->ReadRecPtr;
+		XLogRecoveryCtl->lastReplayedEndRecPtr = xlogreader->EndRecPtr;
+		XLogRecoveryCtl->lastReplayedTLI = *replayTLI;
+		SpinLockRelease(&XLogRecoveryCtl->info_lck);
+		parallelRedoPending = false;
+	}
+	else
+	{
+		pendingReplayedReadRecPtr = xlogreader->ReadRecPtr;
+		pendingReplayedEndRecPtr = xlogreader->EndRecPtr;
+		pendingReplayedTLI = *replayTLI;
+		parallelRedoPending = true;
+	}
 
 	/* ------
 	 * Wakeup walsenders:
@@ -2188,6 +2222,28 @@ CheckRecoveryConsistency(void) // 检查数据库的一致性状态
 	}
 }
 
+/*
+ * Wait for parallel redo workers to replay everything handed to them, and
+ * advertise the last record replayed.  Called before anything that expects
+ * replay to have caught up with the last record read, such as waiting for
+ * more WAL or pausing.
+ */
+static void
+WaitForParallelRedo(void)
+{
+	ParallelRedoWaitAll();
+
+	if (parallelRedoPending)
+	{
+		SpinLockAcquire(&XLogRecoveryCtl->info_lck);
+		XLogRecoveryCtl->lastReplayedReadRecPtr = pendingReplayedReadRecPtr;
+		XLogRecoveryCtl->lastReplayedEndRecPtr = pendingReplayedEndRecPtr;
+		XLogRecoveryCtl->lastReplayedTLI = pendingReplayedTLI;
+		SpinLockRelease(&XLogRecoveryCtl->info_lck);
+		parallelRedoPending = false;
+	}
+}
+
 /*
  * Error context callback for errors occurring during rm_redo().
  */
@@ -2852,6 +2908,9 @@ recoveryPausesHere(bool endOfRecovery)
 	if (LocalPromoteIsTriggered)
 		return;
 
+	/* Make sure everything read so far has been replayed */
+	WaitForParallelRedo();
+
 	if (endOfRecovery)
 		ereport(LOG,
 				(errmsg("pausing at the end of recovery"),
@@ -3493,6 +3552,13 @@ WaitForWALToBecomeAvailable(XLogRecPtr RecPtr, bool randAccess,
 	 * the end of recovery.
 	 *-------
 	 */
+	/*
+	 * We might have to wait for a while, so let parallel redo workers catch
+	 * up first; otherwise lastReplayed* lags behind until more WAL arrives.
+	 */
+	if (!nonblocking)
+		WaitForParallelRedo();
+
 	if (!InArchiveRecovery) // 这个条件表明是在崩溃恢复模式
 		currentSource = XLOG_FROM_PG_WAL;
 	else if (currentSource == XLOG_FROM_ANY ||
@@ -4572,6 +4638,20 @@ GetXLogReceiptTime(TimestampTz *rtime, bool *fromStream)
 	*fromStream = (XLogReceiptSource == XLOG_FROM_STREAM);
 }
 
+/*
+ * Set the time of receipt of the XLOG data being replayed.  Used by parallel
+ * redo workers, which replay records on behalf of the startup process and
+ * need its notion of the receipt time to resolve recovery conflicts.
+ */
+void
+SetXLogReceiptTime(TimestampTz rtime, bool fromStream)
+{
+	Assert(IsParallelRedoWorker);
+
+	XLogReceiptTime = rtime;
+	XLogReceiptSource = fromStream ? XLOG_FROM_STREAM : XLOG_FROM_ARCHIVE;
+}
+
 /*
  * Note that text field supplied is a parameter name and does not require
  * translation
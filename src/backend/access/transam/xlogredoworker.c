@@ -0,0 +1,779 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogredoworker.c
+ *		Parallel WAL replay.
+ *
+ * Portions Copyright (c) 2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *		src/backend/access/transam/xlogredoworker.c
+ *
+ * With recovery_parallel_workers > 0, the startup process hands WAL records
+ * that only modify data pages off to a pool of background workers, and keeps
+ * replaying everything else itself.  Records are assigned to workers by the
+ * relation they modify, so all changes to one relation, including its
+ * visibility map and free space map forks, are replayed by the same worker
+ * in WAL order.  Since no other process touches the relation in the
+ * meantime, a worker can extend and read it exactly like the startup process
+ * would.
+ *
+ * Records that modify more than one relation, or any state other than data
+ * pages (transaction status, locks, the relation map, timeline and
+ * checkpoint records and so on), are replayed by the startup process after
+ * waiting for the workers to catch up: for records that modify pages of
+ * several relations, the workers owning those relations; for everything
+ * else, all of them.  Commit and abort records are in the latter group, so
+ * by the time a transaction becomes visible to hot standby queries, all of
+ * its changes, and everything else before its commit record, has been
+ * replayed.  Changes that are still in flight belong to transactions that
+ * are not yet visible.
+ *
+ * Workers are only used once recovery has reached a consistent state.
+ * Before that, replay may legitimately reference pages that don't exist,
+ * and the bookkeeping for that (see log_invalid_page()) is local to the
+ * startup process.  In practice this means parallel replay is used by hot
+ * and warm standbys and for the tail of archive recovery, not for crash
+ * recovery.
+ *
+ * Each worker has a ring buffer in shared memory that the startup process
+ * copies decoded records into; the worker replays them in place.  When the
+ * startup process has to replay a record itself, it first discards any
+ * cached relation sizes it has, since workers may have extended the
+ * relations it is about to touch.  Conversely, after the startup process
+ * replays a record that may change relation sizes, it bumps a generation
+ * number that tells the workers to discard theirs.
+ *
+ * Known limitation: only one process can advertise the buffer it's waiting
+ * to get a cleanup lock on (see SetStartupBufferPinWaitBufId()), so when
+ * several workers wait for buffer pins at the same time, deadlocks with hot
+ * standby queries are only resolved by max_standby_*_delay.
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/xact.h"
+#include "access/xlog_internal.h"
+#include "access/xlogrecovery.h"
+#include "access/xlogredoworker.h"
+#include "access/xlogutils.h"
+#include "catalog/pg_control.h"
+#include "common/hashfn.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "port/atomics.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/interrupt.h"
+#include "postmaster/startup.h"
+#include "storage/condition_variable.h"
+#include "storage/ipc.h"
+#include "storage/shmem.h"
+#include "storage/smgr.h"
+#include "storage/standby.h"
+#include "tcop/tcopprot.h"
+#include "utils/memutils.h"
+#include "utils/timeout.h"
+
+/* GUC */
+int			recovery_parallel_workers = 0;
+
+bool		IsParallelRedoWorker = false;
+
+/*
+ * Size of each worker's queue.  Records that take up more than half of it
+ * are replayed by the startup process instead.
+ */
+#define PARALLEL_REDO_QUEUE_SIZE	(2 * 1024 * 1024)
+
+/*
+ * How often the startup process checks for interrupts while waiting for a
+ * worker, in milliseconds.
+ */
+#define PARALLEL_REDO_POLL_MS		100
+
+/*
+ * Single-producer, single-consumer queue of records for one worker.  Positions
+ * are byte offsets that only ever grow; the position in the buffer is the
+ * offset modulo PARALLEL_REDO_QUEUE_SIZE.
+ */
+typedef struct ParallelRedoQueue
+{
+	pg_atomic_uint64 write_pos; /* advanced by the startup process */
+	pg_atomic_uint64 read_pos;	/* advanced by the worker, after replay */
+	pg_atomic_uint32 exited;	/* has the worker exited? */
+	ConditionVariable cv;		/* signaled whenever a position advances */
+} ParallelRedoQueue;
+
+typedef struct ParallelRedoCtlData
+{
+	pg_atomic_uint32 shutdown;	/* workers should exit once idle */
+	ParallelRedoQueue queues[FLEXIBLE_ARRAY_MEMBER];
+} ParallelRedoCtlData;
+
+/*
+ * An entry in a worker's queue.  The decoded record follows the header, with
+ * its internal pointers adjusted to point into the queue.  A size of 0 means
+ * that the rest of the buffer is unused, and the next entry is at the start.
+ */
+typedef struct ParallelRedoEntry
+{
+	uint32		size;			/* total size of the entry */
+	HotStandbyState standbyState;	/* startup process's standbyState */
+	uint64		generation;		/* see ParallelRedoGeneration */
+	XLogRecPtr	ReadRecPtr;
+	XLogRecPtr	EndRecPtr;
+	TimestampTz receiptTime;	/* see GetXLogReceiptTime() */
+	bool		receiptFromStream;
+} ParallelRedoEntry;
+
+#define PARALLEL_REDO_ENTRY_HDRSZ	MAXALIGN(sizeof(ParallelRedoEntry))
+
+#define ParallelRedoQueueData(i) \
+	((char *) ParallelRedoCtl + \
+	 MAXALIGN(offsetof(ParallelRedoCtlData, queues) + \
+			  sizeof(ParallelRedoQueue) * recovery_parallel_workers) + \
+	 (Size) (i) * PARALLEL_REDO_QUEUE_SIZE)
+
+/* matches the size of the error buffer in xlogreader.c */
+#define PARALLEL_REDO_ERRORMSG_LEN	1000
+
+static ParallelRedoCtlData *ParallelRedoCtl = NULL;
+
+/* State of the startup process */
+static int	ParallelRedoNumWorkers = 0;
+static bool ParallelRedoLaunched = false;
+static BackgroundWorkerHandle *ParallelRedoHandles[MAX_PARALLEL_REDO_WORKERS];
+
+/*
+ * Bumped by the startup process whenever it has replayed a record that may
+ * have changed the size of relations, so that workers know to forget their
+ * cached sizes.
+ */
+static uint64 ParallelRedoGeneration = 0;
+
+static void ParallelRedoLaunchWorkers(void);
+static void ParallelRedoStartupExit(int code, Datum arg);
+static int	ParallelRedoChooseWorker(XLogReaderState *record, bool *blocklocal);
+static bool ParallelRedoChangesRelationSizes(XLogReaderState *record);
+static void ParallelRedoEnqueue(int worker, XLogReaderState *record);
+static void ParallelRedoWait(int worker);
+static void ParallelRedoCheckWorker(int worker);
+static void ParallelRedoWorkerExit(int code, Datum arg);
+static void parallel_redo_error_callback(void *arg);
+
+/*
+ * Report shared-memory space needed by ParallelRedoShmemInit.
+ */
+Size
+ParallelRedoShmemSize(void)
+{
+	Size		size;
+
+	if (recovery_parallel_workers == 0)
+		return 0;
+
+	size = MAXALIGN(add_size(offsetof(ParallelRedoCtlData, queues),
+							 mul_size(sizeof(ParallelRedoQueue),
+									  recovery_parallel_workers)));
+	size = add_size(size, mul_size(PARALLEL_REDO_QUEUE_SIZE,
+								   recovery_parallel_workers));
+
+	return size;
+}
+
+/*
+ * Allocate and initialize parallel redo shared memory.
+ */
+void
+ParallelRedoShmemInit(void)
+{
+	bool		found;
+
+	if (recovery_parallel_workers == 0)
+		return;
+
+	ParallelRedoCtl = (ParallelRedoCtlData *)
+		ShmemInitStruct("Parallel Redo Ctl", ParallelRedoShmemSize(), &found);
+
+	if (!found)
+	{
+		pg_atomic_init_u32(&ParallelRedoCtl->shutdown, 0);
+		for (int i = 0; i < recovery_parallel_workers; i++)
+		{
+			ParallelRedoQueue *queue = &ParallelRedoCtl->queues[i];
+
+			pg_atomic_init_u64(&queue->write_pos, 0);
+			pg_atomic_init_u64(&queue->read_pos, 0);
+			pg_atomic_init_u32(&queue->exited, 0);
+			ConditionVariableInit(&queue->cv);
+		}
+	}
+}
+
+/*
+ * Start the workers.  This is attempted only once; if no worker can be
+ * started, replay carries on in the startup process alone.
+ */
+static void
+ParallelRedoLaunchWorkers(void)
+{
+	ParallelRedoLaunched = true;
+
+	pg_atomic_write_u32(&ParallelRedoCtl->shutdown, 0);
+
+	for (int i = 0; i < recovery_parallel_workers; i++)
+	{
+		ParallelRedoQueue *queue = &ParallelRedoCtl->queues[i];
+		BackgroundWorker worker;
+		pid_t		pid;
+
+		pg_atomic_write_u64(&queue->write_pos, 0);
+		pg_atomic_write_u64(&queue->read_pos, 0);
+		pg_atomic_write_u32(&queue->exited, 0);
+
+		memset(&worker, 0, sizeof(worker));
+		worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+		worker.bgw_start_time = BgWorkerStart_PostmasterStart;
+		worker.bgw_restart_time = BGW_NEVER_RESTART;
+		snprintf(worker.bgw_library_name, BGW_MAXLEN, "postgres");
+		snprintf(worker.bgw_function_name, BGW_MAXLEN, "ParallelRedoWorkerMain");
+		snprintf(worker.bgw_name, BGW_MAXLEN, "parallel redo worker %d", i);
+		snprintf(worker.bgw_type, BGW_MAXLEN, "parallel redo worker");
+		worker.bgw_main_arg = Int32GetDatum(i);
+		worker.bgw_notify_pid = MyProcPid;
+
+		if (!RegisterDynamicBackgroundWorker(&worker, &ParallelRedoHandles[i]))
+			break;
+		if (WaitForBackgroundWorkerStartup(ParallelRedoHandles[i], &pid) != BGWH_STARTED)
+			break;
+
+		ParallelRedoNumWorkers++;
+	}
+
+	if (ParallelRedoNumWorkers < recovery_parallel_workers)
+		ereport(LOG,
+				(errmsg("could only start %d of %d parallel redo workers",
+						ParallelRedoNumWorkers, recovery_parallel_workers),
+				 errhint("You might need to increase max_worker_processes.")));
+	else
+		ereport(LOG,
+				(errmsg("started %d parallel redo workers",
+						ParallelRedoNumWorkers)));
+
+	if (ParallelRedoNumWorkers > 0)
+		before_shmem_exit(ParallelRedoStartupExit, 0);
+}
+
+/*
+ * If the startup process exits while workers are running, tell them to exit
+ * too.
+ */
+static void
+ParallelRedoStartupExit(int code, Datum arg)
+{
+	pg_atomic_write_u32(&ParallelRedoCtl->shutdown, 1);
+	for (int i = 0; i < ParallelRedoNumWorkers; i++)
+		ConditionVariableBroadcast(&ParallelRedoCtl->queues[i].cv);
+}
+
+/*
+ * Decide which worker should replay a record.  Returns -1 if the record
+ * must be replayed by the startup process.  In that case, *blocklocal is set
+ * if the record only modifies data pages, so that the startup process only
+ * needs to wait for the workers owning those pages.
+ */
+static int
+ParallelRedoChooseWorker(XLogReaderState *record, bool *blocklocal)
+{
+	uint8		info = XLogRecGetInfo(record) & ~XLR_INFO_MASK;
+	int			worker = -1;
+	bool		multiple = false;
+
+	*blocklocal = false;
+
+	if (!XLogRecHasAnyBlockRefs(record))
+		return -1;
+
+	switch (XLogRecGetRmid(record))
+	{
+		case RM_XLOG_ID:
+			if (info != XLOG_FPI && info != XLOG_FPI_FOR_HINT)
+				return -1;
+			break;
+		case RM_HEAP_ID:
+		case RM_HEAP2_ID:
+		case RM_BTREE_ID:
+		case RM_HASH_ID:
+		case RM_GIN_ID:
+		case RM_GIST_ID:
+		case RM_SEQ_ID:
+		case RM_SPGIST_ID:
+		case RM_BRIN_ID:
+		case RM_GENERIC_ID:
+			break;
+		default:
+			return -1;
+	}
+
+	*blocklocal = true;
+
+	for (int block_id = 0; block_id <= XLogRecMaxBlockId(record); block_id++)
+	{
+		RelFileLocator rlocator;
+		int			this_worker;
+
+		if (!XLogRecGetBlockTagExtended(record, block_id, &rlocator,
+										NULL, NULL, NULL))
+			continue;
+
+		this_worker = hash_bytes((const unsigned char *) &rlocator,
+								 sizeof(RelFileLocator)) % ParallelRedoNumWorkers;
+		if (worker == -1)
+			worker = this_worker;
+		else if (this_worker != worker)
+			multiple = true;
+	}
+
+	/* The consistency check needs the startup process's replay of it */
+	if (multiple || (XLogRecGetInfo(record) & XLR_CHECK_CONSISTENCY) != 0)
+		return -1;
+
+	/* Leave room in the queue for other records */
+	if (PARALLEL_REDO_ENTRY_HDRSZ + record->record->size >
+		PARALLEL_REDO_QUEUE_SIZE / 2)
+		return -1;
+
+	return worker;
+}
+
+/*
+ * Can replaying this record in the startup process change the size of
+ * relations that workers might have cached?
+ */
+static bool
+ParallelRedoChangesRelationSizes(XLogReaderState *record)
+{
+	uint8		info = XLogRecGetInfo(record);
+
+	if (XLogRecHasAnyBlockRefs(record))
+		return true;
+
+	switch (XLogRecGetRmid(record))
+	{
+		case RM_SMGR_ID:
+		case RM_DBASE_ID:
+		case RM_TBLSPC_ID:
+			return true;
+
+		case RM_XACT_ID:
+			switch (info & XLOG_XACT_OPMASK)
+			{
+				case XLOG_XACT_COMMIT:
+				case XLOG_XACT_COMMIT_PREPARED:
+					{
+						xl_xact_parsed_commit parsed;
+
+						ParseCommitRecord(info,
+										  (xl_xact_commit *) XLogRecGetData(record),
+										  &parsed);
+						return parsed.nrels > 0;
+					}
+				case XLOG_XACT_ABORT:
+				case XLOG_XACT_ABORT_PREPARED:
+					{
+						xl_xact_parsed_abort parsed;
+
+						ParseAbortRecord(info,
+										 (xl_xact_abort *) XLogRecGetData(record),
+										 &parsed);
+						return parsed.nrels > 0;
+					}
+			}
+			return false;
+
+		default:
+			return false;
+	}
+}
+
+/*
+ * Hand a record to a worker for replay, if possible.
+ *
+ * Returns true if a worker will replay the record.  Otherwise, returns false
+ * after waiting for the workers whose replay might conflict with it, and the
+ * caller must replay the record itself.
+ */
+bool
+ParallelRedoDispatch(XLogReaderState *record)
+{
+	bool		blocklocal;
+	int			worker;
+
+	if (ParallelRedoNumWorkers == 0)
+	{
+		if (ParallelRedoLaunched || recovery_parallel_workers == 0 ||
+			!reachedConsistency || !IsUnderPostmaster)
+			return false;
+
+		ParallelRedoLaunchWorkers();
+		if (ParallelRedoNumWorkers == 0)
+			return false;
+	}
+
+	worker = ParallelRedoChooseWorker(record, &blocklocal);
+	if (worker >= 0)
+	{
+		ParallelRedoEnqueue(worker, record);
+		return true;
+	}
+
+	if (blocklocal)
+	{
+		/* Only need to wait for the workers owning the modified pages */
+		for (int block_id = 0; block_id <= XLogRecMaxBlockId(record); block_id++)
+		{
+			RelFileLocator rlocator;
+
+			if (!XLogRecGetBlockTagExtended(record, block_id, &rlocator,
+											NULL, NULL, NULL))
+				continue;
+
+			ParallelRedoWait(hash_bytes((const unsigned char *) &rlocator,
+										sizeof(RelFileLocator)) % ParallelRedoNumWorkers);
+		}
+	}
+	else
+		ParallelRedoWaitAll();
+
+	if (ParallelRedoChangesRelationSizes(record))
+	{
+		/* Our cached sizes may be stale, and the workers' will be */
+		smgrreleaseall();
+		ParallelRedoGeneration++;
+	}
+
+	return false;
+}
+
+/*
+ * Copy a record into a worker's queue, waiting for room if necessary.
+ */
+static void
+ParallelRedoEnqueue(int worker, XLogReaderState *record)
+{
+	ParallelRedoQueue *queue = &ParallelRedoCtl->queues[worker];
+	char	   *data = ParallelRedoQueueData(worker);
+	DecodedXLogRecord *src = record->record;
+	DecodedXLogRecord *dst;
+	ParallelRedoEntry *entry;
+	Size		size = PARALLEL_REDO_ENTRY_HDRSZ + src->size;
+	uint64		write_pos = pg_atomic_read_u64(&queue->write_pos);
+	Size		offset = write_pos % PARALLEL_REDO_QUEUE_SIZE;
+	Size		skip = 0;
+
+	/* Entries don't wrap around; skip to the start if it doesn't fit */
+	if (offset + size > PARALLEL_REDO_QUEUE_SIZE)
+		skip = PARALLEL_REDO_QUEUE_SIZE - offset;
+
+	for (;;)
+	{
+		uint64		read_pos = pg_atomic_read_u64(&queue->read_pos);
+
+		if (write_pos + skip + size - read_pos <= PARALLEL_REDO_QUEUE_SIZE)
+			break;
+
+		HandleStartupProcInterrupts();
+		ParallelRedoCheckWorker(worker);
+		ConditionVariableTimedSleep(&queue->cv, PARALLEL_REDO_POLL_MS,
+									WAIT_EVENT_PARALLEL_REDO_DISPATCH);
+	}
+	ConditionVariableCancelSleep();
+
+	/* Don't overwrite anything before the worker is done reading it */
+	pg_memory_barrier();
+
+	if (skip > 0)
+	{
+		*((uint32 *) (data + offset)) = 0;
+		write_pos += skip;
+		offset = 0;
+	}
+
+	entry = (ParallelRedoEntry *) (data + offset);
+	entry->size = size;
+	entry->standbyState = standbyState;
+	entry->generation = ParallelRedoGeneration;
+	entry->ReadRecPtr = record->ReadRecPtr;
+	entry->EndRecPtr = record->EndRecPtr;
+	GetXLogReceiptTime(&entry->receiptTime, &entry->receiptFromStream);
+
+	/*
+	 * Copy the decoded record, and point its block images and data at the
+	 * copy.  Shared memory is mapped at the same address in every process, so
+	 * the worker can use the pointers as they are.
+	 */
+	dst = (DecodedXLogRecord *) ((char *) entry + PARALLEL_REDO_ENTRY_HDRSZ);
+	memcpy(dst, src, src->size);
+	dst->next = NULL;
+	dst->oversized = false;
+	if (src->main_data != NULL)
+		dst->main_data = (char *) dst + (src->main_data - (char *) src);
+	for (int block_id = 0; block_id <= src->max_block_id; block_id++)
+	{
+		DecodedBkpBlock *blk = &dst->blocks[block_id];
+
+		if (!blk->in_use)
+			continue;
+		blk->bkp_image = blk->has_image ?
+			(char *) dst + (src->blocks[block_id].bkp_image - (char *) src) : NULL;
+		blk->data = blk->has_data ?
+			(char *) dst + (src->blocks[block_id].data - (char *) src) : NULL;
+	}
+
+	/* Make the entry visible to the worker */
+	pg_write_barrier();
+	pg_atomic_write_u64(&queue->write_pos, write_pos + size);
+	ConditionVariableBroadcast(&queue->cv);
+}
+
+/*
+ * Fail if a worker has exited.  Workers only exit on their own when they run
+ * into an error, which has already been reported.
+ */
+static void
+ParallelRedoCheckWorker(int worker)
+{
+	if (pg_atomic_read_u32(&ParallelRedoCtl->queues[worker].exited) != 0)
+		ereport(FATAL,
+				(errmsg("parallel redo worker %d exited unexpectedly", worker)));
+}
+
+/*
+ * Wait for a worker to replay everything in its queue.
+ */
+static void
+ParallelRedoWait(int worker)
+{
+	ParallelRedoQueue *queue = &ParallelRedoCtl->queues[worker];
+
+	if (pg_atomic_read_u64(&queue->read_pos) ==
+		pg_atomic_read_u64(&queue->write_pos))
+		return;
+
+	for (;;)
+	{
+		if (pg_atomic_read_u64(&queue->read_pos) ==
+			pg_atomic_read_u64(&queue->write_pos))
+			break;
+
+		HandleStartupProcInterrupts();
+		ParallelRedoCheckWorker(worker);
+		ConditionVariableTimedSleep(&queue->cv, PARALLEL_REDO_POLL_MS,
+									WAIT_EVENT_PARALLEL_REDO_SYNC);
+	}
+	ConditionVariableCancelSleep();
+
+	/* Make the worker's changes visible to us */
+	pg_read_barrier();
+}
+
+/*
+ * Wait for all workers to replay everything handed to them so far.
+ */
+void
+ParallelRedoWaitAll(void)
+{
+	for (int i = 0; i < ParallelRedoNumWorkers; i++)
+		ParallelRedoWait(i);
+}
+
+/*
+ * Have all the workers replayed everything handed to them so far?
+ */
+bool
+ParallelRedoIdle(void)
+{
+	for (int i = 0; i < ParallelRedoNumWorkers; i++)
+	{
+		ParallelRedoQueue *queue = &ParallelRedoCtl->queues[i];
+
+		if (pg_atomic_read_u64(&queue->read_pos) !=
+			pg_atomic_read_u64(&queue->write_pos))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Wait for the workers to finish, and make them exit.  Called at the end of
+ * recovery.
+ */
+void
+ParallelRedoShutdown(void)
+{
+	if (ParallelRedoNumWorkers == 0)
+		return;
+
+	ParallelRedoWaitAll();
+
+	pg_atomic_write_u32(&ParallelRedoCtl->shutdown, 1);
+	for (int i = 0; i < ParallelRedoNumWorkers; i++)
+		ConditionVariableBroadcast(&ParallelRedoCtl->queues[i].cv);
+	for (int i = 0; i < ParallelRedoNumWorkers; i++)
+		(void) WaitForBackgroundWorkerShutdown(ParallelRedoHandles[i]);
+
+	cancel_before_shmem_exit(ParallelRedoStartupExit, 0);
+	ParallelRedoNumWorkers = 0;
+	smgrreleaseall();
+}
+
+/*
+ * Let the startup process know if we exit.
+ */
+static void
+ParallelRedoWorkerExit(int code, Datum arg)
+{
+	ParallelRedoQueue *queue = &ParallelRedoCtl->queues[DatumGetInt32(arg)];
+
+	pg_atomic_write_u32(&queue->exited, 1);
+	ConditionVariableBroadcast(&queue->cv);
+}
+
+/*
+ * Error context callback for errors during replay in a worker.
+ */
+static void
+parallel_redo_error_callback(void *arg)
+{
+	XLogReaderState *record = (XLogReaderState *) arg;
+	RmgrData	rmgr = GetRmgr(XLogRecGetRmid(record));
+	const char *id = rmgr.rm_identify(XLogRecGetInfo(record));
+
+	errcontext("WAL redo at %X/%X for %s/%s",
+			   LSN_FORMAT_ARGS(record->ReadRecPtr),
+			   rmgr.rm_name, id ? id : "UNKNOWN");
+}
+
+/*
+ * Main entry point for a parallel redo worker.
+ */
+void
+ParallelRedoWorkerMain(Datum main_arg)
+{
+	int			worker = DatumGetInt32(main_arg);
+	ParallelRedoQueue *queue = &ParallelRedoCtl->queues[worker];
+	char	   *data = ParallelRedoQueueData(worker);
+	XLogReaderState *reader;
+	MemoryContext redo_context;
+	uint64		generation = 0;
+
+	pqsignal(SIGHUP, SignalHandlerForConfigReload);
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	before_shmem_exit(ParallelRedoWorkerExit, Int32GetDatum(worker));
+
+	/*
+	 * Look like the startup process to the redo routines.  We're only started
+	 * once recovery is consistent.
+	 */
+	IsParallelRedoWorker = true;
+	InRecovery = true;
+	reachedConsistency = true;
+
+	RegisterTimeout(STANDBY_DEADLOCK_TIMEOUT, StandbyDeadLockHandler);
+	RegisterTimeout(STANDBY_TIMEOUT, StandbyTimeoutHandler);
+	RegisterTimeout(STANDBY_LOCK_TIMEOUT, StandbyLockTimeoutHandler);
+
+	reader = palloc0(sizeof(XLogReaderState));
+	reader->errormsg_buf = palloc0(PARALLEL_REDO_ERRORMSG_LEN + 1);
+
+	redo_context = AllocSetContextCreate(TopMemoryContext,
+										 "Parallel redo",
+										 ALLOCSET_DEFAULT_SIZES);
+
+	RmgrStartup();
+
+	for (;;)
+	{
+		ParallelRedoEntry *entry;
+		ErrorContextCallback errcallback;
+		MemoryContext oldcontext;
+		uint64		read_pos = pg_atomic_read_u64(&queue->read_pos);
+		Size		offset = read_pos % PARALLEL_REDO_QUEUE_SIZE;
+		uint32		size;
+
+		/* Wait for work */
+		while (pg_atomic_read_u64(&queue->write_pos) == read_pos)
+		{
+			if (ConfigReloadPending)
+			{
+				ConfigReloadPending = false;
+				ProcessConfigFile(PGC_SIGHUP);
+			}
+
+			if (pg_atomic_read_u32(&ParallelRedoCtl->shutdown) != 0)
+				break;
+
+			ConditionVariableSleep(&queue->cv,
+								   WAIT_EVENT_PARALLEL_REDO_WORKER_MAIN);
+		}
+		ConditionVariableCancelSleep();
+
+		if (pg_atomic_read_u64(&queue->write_pos) == read_pos)
+			break;				/* shutdown requested, and nothing to do */
+
+		/* Make sure we see the entry the startup process wrote */
+		pg_read_barrier();
+
+		entry = (ParallelRedoEntry *) (data + offset);
+		size = entry->size;
+
+		if (size != 0)
+		{
+			if (entry->generation != generation)
+			{
+				smgrreleaseall();
+				generation = entry->generation;
+			}
+
+			standbyState = entry->standbyState;
+			SetXLogReceiptTime(entry->receiptTime, entry->receiptFromStream);
+
+			reader->ReadRecPtr = entry->ReadRecPtr;
+			reader->EndRecPtr = entry->EndRecPtr;
+			reader->record = (DecodedXLogRecord *)
+				((char *) entry + PARALLEL_REDO_ENTRY_HDRSZ);
+
+			errcallback.callback = parallel_redo_error_callback;
+			errcallback.arg = (void *) reader;
+			errcallback.previous = error_context_stack;
+			error_context_stack = &errcallback;
+
+			oldcontext = MemoryContextSwitchTo(redo_context);
+			GetRmgr(XLogRecGetRmid(reader)).rm_redo(reader);
+			MemoryContextSwitchTo(oldcontext);
+			MemoryContextReset(redo_context);
+
+			error_context_stack = errcallback.previous;
+			reader->record = NULL;
+		}
+		else
+			size = PARALLEL_REDO_QUEUE_SIZE - offset;
+
+		/* Make our changes visible before releasing the entry */
+		pg_memory_barrier();
+		pg_atomic_write_u64(&queue->read_pos, read_pos + size);
+		ConditionVariableBroadcast(&queue->cv);
+	}
+
+	RmgrCleanup();
+
+	/* Not an unexpected exit */
+	cancel_before_shmem_exit(ParallelRedoWorkerExit, Int32GetDatum(worker));
+
+	proc_exit(0);
+}
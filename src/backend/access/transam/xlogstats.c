@@ -93,4 +93,32 @@ XLogRecStoreStats(XLogStats *stats, XLogReaderState *record)
 	stats->record_stats[rmid][recid].count++;
 	stats->record_stats[rmid][recid].rec_len += rec_len;
 	stats->record_stats[rmid][recid].fpi_len += fpi_len;
+
+	/* Update full-page image statistics */
+	for (int block_id = 0; block_id <= XLogRecMaxBlockId(record); block_id++)
+	{
+		DecodedBkpBlock *blk;
+		XLogFPICompression method;
+
+		if (!XLogRecHasBlockRef(record, block_id) ||
+			!XLogRecHasBlockImage(record, block_id))
+			continue;
+
+		blk = XLogRecGetBlock(record, block_id);
+
+		if ((blk->bimg_info & BKPIMAGE_COMPRESS_PGLZ) != 0)
+			method = XLOG_FPI_PGLZ;
+		else if ((blk->bimg_info & BKPIMAGE_COMPRESS_LZ4) != 0)
+			method = XLOG_FPI_LZ4;
+		else if ((blk->bimg_info & BKPIMAGE_COMPRESS_ZSTD) != 0)
+			method = XLOG_FPI_ZSTD;
+		else if ((blk->bimg_info & BKPIMAGE_COMPRESS_ZSTD_DICT) != 0)
+			method = XLOG_FPI_ZSTD_DICT;
+		else
+			method = XLOG_FPI_UNCOMPRESSED;
+
+		stats->fpi_stats[method].count++;
+		stats->fpi_stats[method].raw_len += BLCKSZ - blk->hole_length;
+		stats->fpi_stats[method].fpi_len += blk->bimg_len;
+	}
 }
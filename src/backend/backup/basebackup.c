@@ -145,6 +145,9 @@ static const char *const excludeDirContents[] =
 	/* Contents removed on startup, see dsm_cleanup_for_mmap(). */
 	PG_DYNSHMEM_DIR,
 
+	/* Contents zeroed on startup, see StartupCSNLog(). */
+	"pg_csn",
+
 	/* Contents removed on startup, see AsyncShmemInit(). */
 	"pg_notify",
 
@@ -394,6 +394,12 @@ CREATE OR REPLACE FUNCTION pg_backup_stop (
   RETURNS record STRICT VOLATILE LANGUAGE internal as 'pg_backup_stop'
   PARALLEL RESTRICTED;
 
+CREATE OR REPLACE FUNCTION
+  pg_train_wal_dictionary(dict_size integer DEFAULT 65536,
+                          sample_pages integer DEFAULT 10000)
+  RETURNS integer STRICT VOLATILE LANGUAGE internal AS 'pg_train_wal_dictionary'
+  PARALLEL UNSAFE;
+
 CREATE OR REPLACE FUNCTION
   pg_promote(wait boolean DEFAULT true, wait_seconds integer DEFAULT 60)
   RETURNS boolean STRICT VOLATILE LANGUAGE INTERNAL AS 'pg_promote'
@@ -618,6 +624,8 @@ REVOKE EXECUTE ON FUNCTION pg_create_restore_point(text) FROM public;
 
 REVOKE EXECUTE ON FUNCTION pg_switch_wal() FROM public;
 
+REVOKE EXECUTE ON FUNCTION pg_train_wal_dictionary(integer, integer) FROM public;
+
 REVOKE EXECUTE ON FUNCTION pg_log_standby_snapshot() FROM public;
 
 REVOKE EXECUTE ON FUNCTION pg_wal_replay_pause() FROM public;
@@ -725,6 +725,23 @@ CREATE VIEW pg_stat_xact_user_tables AS
     WHERE schemaname NOT IN ('pg_catalog', 'information_schema') AND
           schemaname !~ '^pg_toast';
 
+CREATE VIEW pg_stat_matview_maintenance AS
+    SELECT
+            C.oid AS relid,
+            N.nspname AS schemaname,
+            C.relname AS matviewname,
+            coalesce((SELECT option_value
+                      FROM pg_options_to_table(C.reloptions)
+                      WHERE option_name = 'incremental_maintenance'),
+                     'off') AS maintenance_mode,
+            pg_stat_get_maintenance_count(C.oid) AS maintenance_count,
+            pg_stat_get_maintenance_full_count(C.oid) AS full_recompute_count,
+            pg_stat_get_maintenance_rows(C.oid) AS rows_changed,
+            pg_stat_get_maintenance_time(C.oid) AS total_time
+    FROM pg_class C
+         LEFT JOIN pg_namespace N ON (N.oid = C.relnamespace)
+    WHERE C.relkind = 'm';
+
 CREATE VIEW pg_statio_all_tables AS
     SELECT
             C.oid AS relid,
@@ -796,6 +813,27 @@ CREATE VIEW pg_stat_user_indexes AS
     WHERE schemaname NOT IN ('pg_catalog', 'information_schema') AND
           schemaname !~ '^pg_toast';
 
+CREATE VIEW pg_stat_gin_pending_list AS
+    SELECT
+            C.oid AS relid,
+            I.oid AS indexrelid,
+            N.nspname AS schemaname,
+            C.relname AS relname,
+            I.relname AS indexrelname,
+            P.pending_pages,
+            P.pending_tuples,
+            pg_stat_get_gin_pending_merges(I.oid) AS merges,
+            pg_stat_get_gin_pending_inline_merges(I.oid) AS inline_merges,
+            pg_stat_get_gin_pending_merged_pages(I.oid) AS merged_pages,
+            pg_stat_get_gin_pending_merge_time(I.oid) AS total_merge_time
+    FROM pg_class C JOIN
+            pg_index X ON C.oid = X.indrelid JOIN
+            pg_class I ON I.oid = X.indexrelid JOIN
+            pg_am A ON A.oid = I.relam
+            LEFT JOIN pg_namespace N ON (N.oid = C.relnamespace)
+            LEFT JOIN LATERAL gin_pending_list_size(I.oid) P ON true
+    WHERE C.relkind IN ('r', 't', 'm') AND A.amname = 'gin';
+
 CREATE VIEW pg_statio_all_indexes AS
     SELECT
             C.oid AS relid,
@@ -872,6 +910,15 @@ CREATE VIEW pg_stat_activity AS
         LEFT JOIN pg_database AS D ON (S.datid = D.oid)
         LEFT JOIN pg_authid AS U ON (S.usesysid = U.oid);
 
+CREATE VIEW pg_stat_fastpath_locks AS
+    SELECT
+            pg_stat_get_backend_pid(S.backendid) AS pid,
+            pg_stat_get_backend_wait_event_type(S.backendid) AS wait_event_type,
+            pg_stat_get_backend_wait_event(S.backendid) AS wait_event,
+            pg_stat_get_backend_fastpath_slot_misses(S.backendid) AS slot_misses,
+            pg_stat_get_backend_fastpath_conflict_misses(S.backendid) AS conflict_misses
+    FROM (SELECT pg_stat_get_backend_idset() AS backendid) AS S;
+
 CREATE VIEW pg_stat_replication AS
     SELECT
             S.pid,
@@ -1115,6 +1162,7 @@ CREATE VIEW pg_stat_bgwriter AS
         pg_stat_get_checkpoint_write_time() AS checkpoint_write_time,
         pg_stat_get_checkpoint_sync_time() AS checkpoint_sync_time,
         pg_stat_get_bgwriter_buf_written_checkpoints() AS buffers_checkpoint,
+        pg_stat_get_bgwriter_write_requests_checkpoints() AS checkpoint_write_requests,
         pg_stat_get_bgwriter_buf_written_clean() AS buffers_clean,
         pg_stat_get_bgwriter_maxwritten_clean() AS maxwritten_clean,
         pg_stat_get_buf_written_backend() AS buffers_backend,
@@ -1131,6 +1179,7 @@ SELECT
        b.read_time,
        b.writes,
        b.write_time,
+       b.write_requests,
        b.writebacks,
        b.writeback_time,
        b.extends,
@@ -1154,6 +1203,8 @@ CREATE VIEW pg_stat_wal AS
         w.wal_sync,
         w.wal_write_time,
         w.wal_sync_time,
+        w.wal_group_flushes,
+        w.wal_group_flush_members,
         w.stats_reset
     FROM pg_stat_get_wal() w;
 
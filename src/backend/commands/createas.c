@@ -142,6 +142,18 @@ create_ctas_internal(List *attrList, IntoClause *into)
 
 		StoreViewQuery(intoRelationAddr.objectId, query, false);
 		CommandCounterIncrement();
+
+		/* Set up incremental maintenance, if requested */
+		if (create->options != NIL)
+		{
+			Relation	matviewRel = table_open(intoRelationAddr.objectId,
+												NoLock);
+
+			if (RelationGetIncrementalMaintenance(matviewRel) !=
+				STDRD_OPTION_INCREMENTAL_MAINTENANCE_OFF)
+				SetMatViewIncrementalMaintenance(matviewRel, true);
+			table_close(matviewRel, NoLock);
+		}
 	}
 
 	return intoRelationAddr;
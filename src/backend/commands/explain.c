@@ -1827,6 +1827,14 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			/* fall through to print additional fields the same as SeqScan */
 			/* FALLTHROUGH */
 		case T_SeqScan:
+			show_scan_qual(plan->qual, "Filter", planstate, ancestors, es);
+			if (plan->qual)
+				show_instrumentation_count("Rows Removed by Filter", 1,
+										   planstate, es);
+			if (((SeqScanState *) planstate)->bloom_filters != NIL)
+				show_instrumentation_count("Rows Removed by Bloom Filter", 2,
+										   planstate, es);
+			break;
 		case T_ValuesScan:
 		case T_CteScan:
 		case T_NamedTuplestoreScan:
@@ -2020,6 +2028,8 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			show_agg_keys(castNode(AggState, planstate), ancestors, es);
 			show_upper_qual(plan->qual, "Filter", planstate, ancestors, es);
 			show_hashagg_info((AggState *) planstate, es);
+			if (((AggState *) planstate)->batch != NULL)
+				ExplainPropertyBool("Batch Mode", true, es);
 			if (plan->qual)
 				show_instrumentation_count("Rows Removed by Filter", 1,
 										   planstate, es);
@@ -3096,6 +3106,7 @@ show_hash_info(HashState *hashstate, ExplainState *es)
 											  worker_hi->nbatch_original);
 			hinstrument.space_peak = Max(hinstrument.space_peak,
 										 worker_hi->space_peak);
+			hinstrument.radix_index |= worker_hi->radix_index;
 		}
 	}
 
@@ -3136,6 +3147,9 @@ show_hash_info(HashState *hashstate, ExplainState *es)
 							 hinstrument.nbuckets, hinstrument.nbatch,
 							 spacePeakKb);
 		}
+
+		if (hinstrument.radix_index)
+			ExplainPropertyText("Bucket Layout", "radix", es);
 	}
 }
 
@@ -3230,6 +3244,49 @@ show_memoize_info(MemoizeState *mstate, List *ancestors, ExplainState *es)
 	if (mstate->shared_info == NULL)
 		return;
 
+	/*
+	 * When the participants shared the cache, also show the totals, which
+	 * describe how well the cache worked as a whole.
+	 */
+	if (mstate->shared_cache)
+	{
+		MemoizeInstrumentation total;
+
+		memcpy(&total, &mstate->stats, sizeof(MemoizeInstrumentation));
+		for (int n = 0; n < mstate->shared_info->num_workers; n++)
+		{
+			MemoizeInstrumentation *si;
+
+			si = &mstate->shared_info->sinstrument[n];
+			total.cache_hits += si->cache_hits;
+			total.cache_misses += si->cache_misses;
+			total.cache_evictions += si->cache_evictions;
+			total.cache_overflows += si->cache_overflows;
+		}
+
+		memPeakKb = (mstate->shared_mem_peak + 1023) / 1024;
+
+		if (es->format != EXPLAIN_FORMAT_TEXT)
+		{
+			ExplainPropertyInteger("Shared Cache Hits", NULL, total.cache_hits, es);
+			ExplainPropertyInteger("Shared Cache Misses", NULL, total.cache_misses, es);
+			ExplainPropertyInteger("Shared Cache Evictions", NULL, total.cache_evictions, es);
+			ExplainPropertyInteger("Shared Cache Overflows", NULL, total.cache_overflows, es);
+			ExplainPropertyInteger("Shared Cache Peak Memory Usage", "kB", memPeakKb, es);
+		}
+		else
+		{
+			ExplainIndentText(es);
+			appendStringInfo(es->str,
+							 "Shared Cache: Hits: " UINT64_FORMAT "  Misses: " UINT64_FORMAT "  Evictions: " UINT64_FORMAT "  Overflows: " UINT64_FORMAT "  Memory Usage: " INT64_FORMAT "kB\n",
+							 total.cache_hits,
+							 total.cache_misses,
+							 total.cache_evictions,
+							 total.cache_overflows,
+							 memPeakKb);
+		}
+	}
+
 	/* Show details from parallel workers */
 	for (int n = 0; n < mstate->shared_info->num_workers; n++)
 	{
@@ -3314,6 +3371,9 @@ show_hashagg_info(AggState *aggstate, ExplainState *es)
 			ExplainPropertyInteger("Peak Memory Usage", "kB", memPeakKb, es);
 			ExplainPropertyInteger("Disk Usage", "kB",
 								   aggstate->hash_disk_used, es);
+			if (aggstate->hash_shared != NULL)
+				ExplainPropertyInteger("Shared Batches", NULL,
+									   aggstate->hash_shared_batches, es);
 		}
 	}
 	else
@@ -3350,6 +3410,11 @@ show_hashagg_info(AggState *aggstate, ExplainState *es)
 				appendStringInfo(es->str, "  Disk Usage: " UINT64_FORMAT "kB",
 								 aggstate->hash_disk_used);
 			}
+
+			/* Only display shared batches if we re-aggregated any */
+			if (aggstate->hash_shared_batches > 0)
+				appendStringInfo(es->str, "  Shared Batches: %d",
+								 aggstate->hash_shared_batches);
 		}
 
 		if (gotone)
@@ -3364,6 +3429,7 @@ show_hashagg_info(AggState *aggstate, ExplainState *es)
 			AggregateInstrumentation *sinstrument;
 			uint64		hash_disk_used;
 			int			hash_batches_used;
+			int			hash_shared_batches;
 
 			sinstrument = &aggstate->shared_info->sinstrument[n];
 			/* Skip workers that didn't do anything */
@@ -3371,6 +3437,7 @@ show_hashagg_info(AggState *aggstate, ExplainState *es)
 				continue;
 			hash_disk_used = sinstrument->hash_disk_used;
 			hash_batches_used = sinstrument->hash_batches_used;
+			hash_shared_batches = sinstrument->hash_shared_batches;
 			memPeakKb = (sinstrument->hash_mem_peak + 1023) / 1024;
 
 			if (es->workers_state)
@@ -3387,6 +3454,9 @@ show_hashagg_info(AggState *aggstate, ExplainState *es)
 				if (hash_batches_used > 1)
 					appendStringInfo(es->str, "  Disk Usage: " UINT64_FORMAT "kB",
 									 hash_disk_used);
+				if (hash_shared_batches > 0)
+					appendStringInfo(es->str, "  Shared Batches: %d",
+									 hash_shared_batches);
 				appendStringInfoChar(es->str, '\n');
 			}
 			else
@@ -3396,6 +3466,9 @@ show_hashagg_info(AggState *aggstate, ExplainState *es)
 				ExplainPropertyInteger("Peak Memory Usage", "kB", memPeakKb,
 									   es);
 				ExplainPropertyInteger("Disk Usage", "kB", hash_disk_used, es);
+				if (aggstate->hash_shared != NULL)
+					ExplainPropertyInteger("Shared Batches", NULL,
+										   hash_shared_batches, es);
 			}
 
 			if (es->workers_state)
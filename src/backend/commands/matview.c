@@ -18,34 +18,54 @@
 #include "access/heapam.h"
 #include "access/htup_details.h"
 #include "access/multixact.h"
+#include "access/table.h"
 #include "access/tableam.h"
 #include "access/xact.h"
 #include "access/xlog.h"
 #include "catalog/catalog.h"
+#include "catalog/dependency.h"
 #include "catalog/indexing.h"
 #include "catalog/namespace.h"
+#include "catalog/pg_aggregate.h"
 #include "catalog/pg_am.h"
+#include "catalog/pg_depend.h"
+#include "catalog/pg_inherits.h"
 #include "catalog/pg_opclass.h"
 #include "catalog/pg_operator.h"
+#include "catalog/pg_trigger.h"
 #include "commands/cluster.h"
 #include "commands/matview.h"
 #include "commands/tablecmds.h"
 #include "commands/tablespace.h"
+#include "commands/trigger.h"
 #include "executor/executor.h"
 #include "executor/spi.h"
+#include "executor/tstoreReceiver.h"
 #include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/optimizer.h"
+#include "optimizer/tlist.h"
 #include "parser/parse_relation.h"
+#include "parser/parser.h"
+#include "parser/parsetree.h"
 #include "pgstat.h"
 #include "rewrite/rewriteHandler.h"
 #include "storage/lmgr.h"
 #include "storage/smgr.h"
 #include "tcop/tcopprot.h"
+#include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/guc.h"
 #include "utils/lsyscache.h"
+#include "utils/queryenvironment.h"
 #include "utils/rel.h"
+#include "utils/resowner.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
-
+#include "utils/tuplestore.h"
+#include "utils/typcache.h"
 
 typedef struct
 {
@@ -64,6 +84,7 @@ static void transientrel_startup(DestReceiver *self, int operation, TupleDesc ty
 static bool transientrel_receive(TupleTableSlot *slot, DestReceiver *self);
 static void transientrel_shutdown(DestReceiver *self);
 static void transientrel_destroy(DestReceiver *self);
+static Query *get_matview_query(Relation matviewRel);
 static uint64 refresh_matview_datafill(DestReceiver *dest, Query *query,
 									   const char *queryString);
 static char *make_temptable_name_n(char *tempname, int n);
@@ -140,8 +161,6 @@ ExecRefreshMatView(RefreshMatViewStmt *stmt, const char *queryString,
 {
 	Oid			matviewOid;
 	Relation	matviewRel;
-	RewriteRule *rule;
-	List	   *actions;
 	Query	   *dataQuery;
 	Oid			tableSpace;
 	Oid			relowner;
@@ -199,32 +218,8 @@ ExecRefreshMatView(RefreshMatViewStmt *stmt, const char *queryString,
 				 errmsg("%s and %s options cannot be used together",
 						"CONCURRENTLY", "WITH NO DATA")));
 
-	/*
-	 * Check that everything is correct for a refresh. Problems at this point
-	 * are internal errors, so elog is sufficient.
-	 */
-	if (matviewRel->rd_rel->relhasrules == false ||
-		matviewRel->rd_rules->numLocks < 1)
-		elog(ERROR,
-			 "materialized view \"%s\" is missing rewrite information",
-			 RelationGetRelationName(matviewRel));
-
-	if (matviewRel->rd_rules->numLocks > 1)
-		elog(ERROR,
-			 "materialized view \"%s\" has too many rules",
-			 RelationGetRelationName(matviewRel));
-
-	rule = matviewRel->rd_rules->rules[0];
-	if (rule->event != CMD_SELECT || !(rule->isInstead))
-		elog(ERROR,
-			 "the rule for materialized view \"%s\" is not a SELECT INSTEAD OF rule",
-			 RelationGetRelationName(matviewRel));
-
-	actions = rule->actions;
-	if (list_length(actions) != 1)
-		elog(ERROR,
-			 "the rule for materialized view \"%s\" is not a single action",
-			 RelationGetRelationName(matviewRel));
+	/* Fetch the view's query, checking that it is fit for a refresh. */
+	dataQuery = get_matview_query(matviewRel);
 
 	/*
 	 * Check that there is a unique index with no WHERE clause on one or more
@@ -259,12 +254,6 @@ ExecRefreshMatView(RefreshMatViewStmt *stmt, const char *queryString,
 					 errhint("Create a unique index with no WHERE clause on one or more columns of the materialized view.")));
 	}
 
-	/*
-	 * The stored query was rewritten at the time of the MV definition, but
-	 * has not been scribbled on by the planner.
-	 */
-	dataQuery = linitial_node(Query, actions);
-
 	/*
 	 * Check for active uses of the relation in the current transaction, such
 	 * as open scans.
@@ -280,6 +269,9 @@ ExecRefreshMatView(RefreshMatViewStmt *stmt, const char *queryString,
 	 */
 	SetMatViewPopulatedState(matviewRel, !stmt->skipData);
 
+	/* Incremental maintenance queued so far is superseded by the refresh */
+	MatViewResetPendingMaintenance(matviewOid);
+
 	/* Concurrent refresh builds new data in temp tablespace, and does diff. */
 	if (concurrent)
 	{
@@ -364,6 +356,50 @@ ExecRefreshMatView(RefreshMatViewStmt *stmt, const char *queryString,
 	return address;
 }
 
+/*
+ * get_matview_query
+ *		Return the stored query of a materialized view.
+ *
+ * The stored query was rewritten at the time of the MV definition, but has
+ * not been scribbled on by the planner.  Callers must copy it before doing
+ * anything that might modify it.
+ */
+static Query *
+get_matview_query(Relation matviewRel)
+{
+	RewriteRule *rule;
+	List	   *actions;
+
+	/*
+	 * Check that everything is correct for a refresh. Problems at this point
+	 * are internal errors, so elog is sufficient.
+	 */
+	if (matviewRel->rd_rel->relhasrules == false ||
+		matviewRel->rd_rules->numLocks < 1)
+		elog(ERROR,
+			 "materialized view \"%s\" is missing rewrite information",
+			 RelationGetRelationName(matviewRel));
+
+	if (matviewRel->rd_rules->numLocks > 1)
+		elog(ERROR,
+			 "materialized view \"%s\" has too many rules",
+			 RelationGetRelationName(matviewRel));
+
+	rule = matviewRel->rd_rules->rules[0];
+	if (rule->event != CMD_SELECT || !(rule->isInstead))
+		elog(ERROR,
+			 "the rule for materialized view \"%s\" is not a SELECT INSTEAD OF rule",
+			 RelationGetRelationName(matviewRel));
+
+	actions = rule->actions;
+	if (list_length(actions) != 1)
+		elog(ERROR,
+			 "the rule for materialized view \"%s\" is not a single action",
+			 RelationGetRelationName(matviewRel));
+
+	return linitial_node(Query, actions);
+}
+
 /*
  * refresh_matview_datafill
  *
@@ -931,3 +967,1869 @@ CloseMatViewIncrementalMaintenance(void)
 	matview_maintenance_depth--;
 	Assert(matview_maintenance_depth >= 0);
 }
+
+
+/*
+ * Incremental maintenance
+ *
+ * A materialized view with the incremental_maintenance option set is kept
+ * up to date by AFTER STATEMENT triggers on each of its base tables, which
+ * receive the changed rows as transition tables.  The view's query is re-run
+ * with the changed table replaced by its transition table, yielding the
+ * corresponding change to the view:
+ *
+ * - Views without aggregation ("SPJ" views) are maintained as bags: the
+ *	 view rows derived from the old transition table are deleted, one matview
+ *	 row per delta row, and those derived from the new transition table are
+ *	 inserted.  This is exact because each base table appears only once and
+ *	 all joins are inner joins.
+ *
+ * - For grouped views, we compute the GROUP BY keys touched by the change,
+ *	 delete those groups from the view and recompute them from the base
+ *	 tables.  The recomputation joins the touched keys to the view's query,
+ *	 so its cost depends on the size of those groups rather than of the
+ *	 tables; an index on the grouping columns of the base tables helps.  When
+ *	 a statement only inserted rows and every aggregate's state is its
+ *	 result (count, sum of integers, min, max, ...), the new rows' partial
+ *	 aggregates are merged into the existing groups instead.
+ *
+ * TRUNCATE, and statements that changed more than one of the view's base
+ * tables at once, fall back to recomputing the whole view.
+ *
+ * In "immediate" mode the view is updated before the statement completes.
+ * In "deferred" mode the statement only records what has to be done, and
+ * the work for each view is done once at commit, which pays off for
+ * transactions running many small statements.  Maintenance of a view is
+ * serialized by an ExclusiveLock on it, and every maintaining transaction
+ * also updates the view's pg_class row, so that a transaction using
+ * snapshot isolation can tell whether the view was maintained by a
+ * transaction it cannot see (see ivm_lock_matview).
+ */
+
+/* What the view's query looks like, as far as maintenance goes */
+typedef struct IvmViewInfo
+{
+	Query	   *query;			/* the view's stored query */
+	List	   *relids;			/* OIDs of its base tables */
+	bool		grouped;		/* has aggregates or GROUP BY? */
+	int			nkeys;			/* number of GROUP BY columns */
+	AttrNumber *keyattnos;		/* matview columns holding them */
+	SortGroupClause **keyclauses;	/* their GROUP BY clauses */
+	Expr	  **keyexprs;		/* their expressions in the query */
+	bool	   *keynullable;	/* can they be NULL? */
+	bool		combinable;		/* can insertions be merged into groups? */
+	Oid		   *combinefns;		/* per matview column, if so */
+	int			nmatch;			/* number of columns to find rows by */
+	AttrNumber *matchattnos;	/* their matview columns */
+	Oid		   *matcheqops;		/* their equality operators */
+} IvmViewInfo;
+
+/* The changes a statement made to one base table */
+typedef struct IvmDelta
+{
+	Oid			relid;			/* the changed table */
+	TupleDesc	tupdesc;		/* its descriptor */
+	Tuplestorestate *oldrows;	/* rows deleted from it, or NULL */
+	Tuplestorestate *newrows;	/* rows inserted into it, or NULL */
+} IvmDelta;
+
+/* A change to be applied to a view */
+typedef enum IvmWorkKind
+{
+	IVM_WORK_DELETE,			/* delete these view rows */
+	IVM_WORK_INSERT,			/* insert these view rows */
+	IVM_WORK_MERGE,				/* merge these partial groups */
+	IVM_WORK_GROUPS,			/* recompute the groups with these keys */
+	IVM_WORK_FULL,				/* recompute the whole view */
+	IVM_WORK_RESET				/* view refreshed, forget earlier work */
+} IvmWorkKind;
+
+typedef struct IvmWorkItem
+{
+	Oid			matviewOid;		/* view to be changed */
+	SubTransactionId subid;		/* subtransaction that queued the item */
+	IvmWorkKind kind;
+	Tuplestorestate *rows;		/* view rows or group keys, if any */
+} IvmWorkItem;
+
+/*
+ * Work queued by deferred-mode views, in TopTransactionContext.  Its
+ * tuplestores belong to the top-level transaction's resource owner, so that
+ * they survive the end of the subtransaction that filled them.
+ */
+static List *ivm_pending = NIL;
+
+#define IVM_QUERY_STRING "incremental maintenance of materialized view"
+
+static IvmViewInfo *ivm_analyze_view(Relation matviewRel);
+static bool ivm_var_is_nullable(Query *query, Var *var);
+static Oid	ivm_combine_function(Expr *expr);
+static List *ivm_get_triggers(Oid matviewOid);
+static void ivm_create_triggers(Relation matviewRel, IvmViewInfo *info);
+static void ivm_lock_matview(Relation matviewRel);
+static Tuplestorestate *ivm_begin_store(bool deferred);
+static void ivm_collect_rows(Tuplestorestate *dst, Tuplestorestate *src,
+							 TupleTableSlot *slot);
+static void ivm_run_query(Query *query, QueryEnvironment *queryEnv,
+						  Tuplestorestate *store);
+static EphemeralNamedRelation ivm_make_enr(const char *name, Oid relid,
+										   TupleDesc tupdesc,
+										   Tuplestorestate *store);
+static void ivm_init_enr_rte(RangeTblEntry *rte, const char *name,
+							 TupleDesc tupdesc, double ntuples);
+static Query *ivm_substitute_rel(Query *query, IvmDelta *delta,
+								 const char *enrname, Tuplestorestate *store);
+static Query *ivm_group_key_query(IvmViewInfo *info);
+static Query *ivm_restrict_to_groups(IvmViewInfo *info, TupleDesc keydesc,
+									 double nkeys);
+static TupleDesc ivm_key_tupdesc(Relation matviewRel, IvmViewInfo *info);
+static List *ivm_compute(Relation matviewRel, IvmViewInfo *info,
+						 IvmDelta *delta, bool deferred);
+static uint64 ivm_apply(Relation matviewRel, IvmViewInfo *info, List *items,
+						bool *full);
+static uint64 ivm_apply_items(Relation matviewRel, IvmViewInfo *info,
+							  List *items);
+static uint64 ivm_apply_rows(Relation matviewRel, IvmViewInfo *info,
+							 IvmWorkKind kind, Tuplestorestate *rows);
+static uint64 ivm_apply_groups(Relation matviewRel, IvmViewInfo *info,
+							   Tuplestorestate *keys);
+static uint64 ivm_apply_full(Relation matviewRel, IvmViewInfo *info);
+static void ivm_append_group_match(StringInfo buf, Relation matviewRel,
+								   IvmViewInfo *info, const char *left,
+								   const char *right);
+static void ivm_free_work(List *items);
+static void ivm_maintain(Oid matviewOid, IvmDelta *delta);
+static void ivm_run_pending(Oid matviewOid, List *items);
+static void ivm_queue_work(IvmWorkItem *item);
+
+/*
+ * SetMatViewIncrementalMaintenance
+ *		Start or stop maintaining a materialized view incrementally.
+ *
+ * This is called when the incremental_maintenance option is given to
+ * CREATE MATERIALIZED VIEW or changed by ALTER MATERIALIZED VIEW.  Enabling
+ * maintenance checks that the view's query is supported and creates the
+ * triggers on its base tables; since the view could have gone stale while
+ * it was not maintained, a populated view is also brought up to date.
+ * Switching between immediate and deferred mode needs no work here, as the
+ * triggers look up the mode each time they fire.
+ */
+void
+SetMatViewIncrementalMaintenance(Relation matviewRel, bool enable)
+{
+	List	   *triggers = ivm_get_triggers(RelationGetRelid(matviewRel));
+
+	Assert(matviewRel->rd_rel->relkind == RELKIND_MATVIEW);
+
+	if (!enable)
+	{
+		ObjectAddresses *objects = new_object_addresses();
+		ListCell   *lc;
+
+		foreach(lc, triggers)
+		{
+			ObjectAddress object;
+
+			ObjectAddressSet(object, TriggerRelationId, lfirst_oid(lc));
+			add_exact_object_address(&object, objects);
+		}
+		performMultipleDeletions(objects, DROP_RESTRICT,
+								 PERFORM_DELETION_INTERNAL);
+		free_object_addresses(objects);
+		CommandCounterIncrement();
+		return;
+	}
+
+	/* Nothing to do if the view is maintained already */
+	if (triggers != NIL)
+		return;
+
+	ivm_create_triggers(matviewRel, ivm_analyze_view(matviewRel));
+
+	if (RelationIsPopulated(matviewRel))
+	{
+		MatViewResetPendingMaintenance(RelationGetRelid(matviewRel));
+		ivm_maintain(RelationGetRelid(matviewRel), NULL);
+	}
+}
+
+/*
+ * matview_maintenance_trigger
+ *		AFTER STATEMENT trigger on the base tables of incrementally
+ *		maintained materialized views.  Its argument is the view's OID.
+ */
+Datum
+matview_maintenance_trigger(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+	Trigger    *trigger;
+	IvmDelta	delta;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "matview_maintenance_trigger: not fired by trigger manager");
+	if (!TRIGGER_FIRED_AFTER(trigdata->tg_event) ||
+		!TRIGGER_FIRED_FOR_STATEMENT(trigdata->tg_event))
+		elog(ERROR, "matview_maintenance_trigger: must be fired after statement");
+
+	trigger = trigdata->tg_trigger;
+	if (trigger->tgnargs != 1)
+		elog(ERROR, "matview_maintenance_trigger: wrong number of arguments");
+
+	if (TRIGGER_FIRED_BY_TRUNCATE(trigdata->tg_event))
+		ivm_maintain(atooid(trigger->tgargs[0]), NULL);
+	else
+	{
+		delta.relid = RelationGetRelid(trigdata->tg_relation);
+		delta.tupdesc = RelationGetDescr(trigdata->tg_relation);
+		delta.oldrows = trigdata->tg_oldtable;
+		delta.newrows = trigdata->tg_newtable;
+
+		/* Skip statements that changed nothing */
+		if ((delta.oldrows != NULL && tuplestore_tuple_count(delta.oldrows) > 0) ||
+			(delta.newrows != NULL && tuplestore_tuple_count(delta.newrows) > 0))
+			ivm_maintain(atooid(trigger->tgargs[0]), &delta);
+	}
+
+	return PointerGetDatum(NULL);
+}
+
+/*
+ * ivm_maintain
+ *		Propagate one statement's changes to a base table into a view, or
+ *		recompute the view if "delta" is NULL.
+ *
+ * In deferred mode, the work is only computed and queued for commit.
+ */
+static void
+ivm_maintain(Oid matviewOid, IvmDelta *delta)
+{
+	Relation	matviewRel;
+	IvmViewInfo *info;
+	StdRdOptIncrementalMaintenance mode;
+	bool		deferred;
+	bool		full = false;
+	List	   *items;
+	Oid			save_userid;
+	int			save_sec_context;
+	int			save_nestlevel;
+	MemoryContext cxt;
+	MemoryContext oldcxt;
+	instr_time	start;
+	instr_time	elapsed;
+
+	INSTR_TIME_SET_CURRENT(start);
+
+	matviewRel = table_open(matviewOid, AccessShareLock);
+	mode = RelationGetIncrementalMaintenance(matviewRel);
+
+	/*
+	 * There is nothing to maintain in a view that has not been populated; the
+	 * REFRESH that populates it will compute its contents from scratch.
+	 */
+	if (mode == STDRD_OPTION_INCREMENTAL_MAINTENANCE_OFF ||
+		!RelationIsPopulated(matviewRel))
+	{
+		table_close(matviewRel, AccessShareLock);
+		return;
+	}
+	deferred = (mode == STDRD_OPTION_INCREMENTAL_MAINTENANCE_DEFERRED);
+
+	cxt = AllocSetContextCreate(CurrentMemoryContext,
+								"incremental maintenance",
+								ALLOCSET_DEFAULT_SIZES);
+	oldcxt = MemoryContextSwitchTo(cxt);
+
+	/* Run the view's query as its owner, as REFRESH does. */
+	GetUserIdAndSecContext(&save_userid, &save_sec_context);
+	SetUserIdAndSecContext(matviewRel->rd_rel->relowner,
+						   save_sec_context | SECURITY_RESTRICTED_OPERATION);
+	save_nestlevel = NewGUCNestLevel();
+
+	info = ivm_analyze_view(matviewRel);
+
+	if (delta != NULL)
+	{
+		ListCell   *lc;
+
+		/*
+		 * Our delta joins the changed rows with the current contents of the
+		 * other base tables.  If the same statement changed some of those
+		 * too, their changed rows would be joined twice, so recompute the
+		 * view instead.  The trigger for each changed table sees the same
+		 * set of tables; leave the work to the one with the lowest OID.
+		 */
+		foreach(lc, info->relids)
+		{
+			Oid			relid = lfirst_oid(lc);
+
+			if (relid != delta->relid && AfterTriggerQueryModifiesRel(relid))
+			{
+				if (relid < delta->relid)
+					goto done;
+				delta = NULL;
+				break;
+			}
+		}
+	}
+
+	/*
+	 * A deferred join view must be locked before its delta is computed, or
+	 * two transactions changing different base tables would each miss the
+	 * other's rows.  The delta of a single-table view depends on the changed
+	 * rows alone, so its lock can wait until commit.
+	 */
+	if (!deferred || list_length(info->relids) > 1)
+		ivm_lock_matview(matviewRel);
+
+	items = ivm_compute(matviewRel, info, delta, deferred);
+
+	if (deferred)
+	{
+		ListCell   *lc;
+
+		foreach(lc, items)
+			ivm_queue_work((IvmWorkItem *) lfirst(lc));
+	}
+	else
+	{
+		uint64		rows;
+
+		rows = ivm_apply(matviewRel, info, items, &full);
+		ivm_free_work(items);
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, start);
+		pgstat_count_matview_maintenance(matviewRel, full, rows, elapsed);
+	}
+
+done:
+	/* Roll back any GUC changes */
+	AtEOXact_GUC(false, save_nestlevel);
+
+	/* Restore userid and security context */
+	SetUserIdAndSecContext(save_userid, save_sec_context);
+
+	MemoryContextSwitchTo(oldcxt);
+	MemoryContextDelete(cxt);
+
+	table_close(matviewRel, NoLock);
+}
+
+/*
+ * ivm_lock_matview
+ *		Lock a view against concurrent maintenance.
+ *
+ * Once we hold the lock, a READ COMMITTED transaction sees the effects of
+ * any maintenance that went before, since the queries we run take fresh
+ * snapshots.  Snapshot isolation cannot, so there we fail rather than wait
+ * and then compute a change from stale data.
+ *
+ * Not holding the lock up to now isn't enough for snapshot isolation
+ * either: a transaction that maintained the view and committed after our
+ * snapshot was taken changed base tables we would read without its
+ * changes.  To detect that, each transaction maintaining the view updates
+ * its pg_class row once, while holding the lock, and we fail if the row's
+ * current version is one our snapshot cannot see.  REFRESH updates that row
+ * too, so it counts as maintenance.
+ */
+static void
+ivm_lock_matview(Relation matviewRel)
+{
+	Oid			matviewOid = RelationGetRelid(matviewRel);
+	Relation	pgrel;
+	HeapTuple	tuple;
+	TransactionId xmin;
+
+	if (!IsolationUsesXactSnapshot())
+		LockRelationOid(matviewOid, ExclusiveLock);
+	else if (!ConditionalLockRelationOid(matviewOid, ExclusiveLock))
+		ereport(ERROR,
+				(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
+				 errmsg("could not serialize access due to concurrent maintenance of materialized view \"%s\"",
+						RelationGetRelationName(matviewRel))));
+
+	pgrel = table_open(RelationRelationId, RowExclusiveLock);
+	tuple = SearchSysCacheCopy1(RELOID, ObjectIdGetDatum(matviewOid));
+	if (!HeapTupleIsValid(tuple))
+		elog(ERROR, "cache lookup failed for relation %u", matviewOid);
+
+	/* Nothing to do if we have been here before in this transaction */
+	xmin = HeapTupleHeaderGetXmin(tuple->t_data);
+	if (!TransactionIdIsCurrentTransactionId(xmin))
+	{
+		if (IsolationUsesXactSnapshot() &&
+			XidInMVCCSnapshot(xmin, GetTransactionSnapshot()))
+			ereport(ERROR,
+					(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
+					 errmsg("could not serialize access due to concurrent maintenance of materialized view \"%s\"",
+							RelationGetRelationName(matviewRel))));
+
+		CatalogTupleUpdate(pgrel, &tuple->t_self, tuple);
+
+		/* Make the new row version visible, so that we don't update it again */
+		CommandCounterIncrement();
+	}
+
+	heap_freetuple(tuple);
+	table_close(pgrel, RowExclusiveLock);
+}
+
+/*
+ * ivm_analyze_view
+ *		Check that a view can be maintained incrementally, and work out how.
+ */
+static IvmViewInfo *
+ivm_analyze_view(Relation matviewRel)
+{
+	IvmViewInfo *info = (IvmViewInfo *) palloc0(sizeof(IvmViewInfo));
+	Query	   *query = copyObject(get_matview_query(matviewRel));
+	const char *detail = NULL;
+	ListCell   *lc;
+
+	info->query = query;
+
+	if (query->hasSubLinks)
+		detail = _("Subqueries are not supported.");
+	else if (query->cteList != NIL)
+		detail = _("WITH queries are not supported.");
+	else if (query->setOperations != NULL)
+		detail = _("UNION, INTERSECT, and EXCEPT are not supported.");
+	else if (query->distinctClause != NIL)
+		detail = _("DISTINCT is not supported.");
+	else if (query->hasWindowFuncs)
+		detail = _("Window functions are not supported.");
+	else if (query->hasTargetSRFs)
+		detail = _("Set-returning functions in the select list are not supported.");
+	else if (query->limitCount != NULL || query->limitOffset != NULL)
+		detail = _("LIMIT and OFFSET are not supported.");
+	else if (query->groupingSets != NIL)
+		detail = _("GROUPING SETS, ROLLUP, and CUBE are not supported.");
+	else if (contain_mutable_functions((Node *) query))
+		detail = _("Only immutable functions are supported.");
+
+	foreach(lc, query->rtable)
+	{
+		RangeTblEntry *rte = lfirst_node(RangeTblEntry, lc);
+
+		if (detail != NULL)
+			break;
+
+		if (rte->rtekind == RTE_JOIN)
+		{
+			if (rte->jointype != JOIN_INNER)
+				detail = _("Outer joins are not supported.");
+			continue;
+		}
+
+		if (rte->rtekind != RTE_RELATION || rte->relkind != RELKIND_RELATION)
+			detail = _("Only plain tables are supported in FROM.");
+		else if (has_subclass(rte->relid) || has_superclass(rte->relid))
+			detail = _("Tables with inheritance parents or children are not supported.");
+		else if (list_member_oid(info->relids, rte->relid))
+			detail = _("A table cannot be referenced more than once.");
+		else
+			info->relids = lappend_oid(info->relids, rte->relid);
+	}
+
+	if (detail == NULL && info->relids == NIL)
+		detail = _("The query must read at least one table.");
+
+	info->grouped = query->hasAggs || query->groupClause != NIL;
+	if (detail == NULL && info->grouped)
+	{
+		int			ngroup = list_length(query->groupClause);
+		AttrNumber	attno = 0;
+
+		info->keyattnos = palloc(ngroup * sizeof(AttrNumber));
+		info->keyclauses = palloc(ngroup * sizeof(SortGroupClause *));
+		info->keyexprs = palloc(ngroup * sizeof(Expr *));
+		info->keynullable = palloc(ngroup * sizeof(bool));
+		info->combinefns = palloc0(RelationGetNumberOfAttributes(matviewRel) *
+								   sizeof(Oid));
+
+		/*
+		 * Merging partial aggregates into a group is only possible if every
+		 * group is present in the view, which HAVING would defeat.
+		 */
+		info->combinable = (query->havingQual == NULL);
+
+		foreach(lc, query->targetList)
+		{
+			TargetEntry *tle = lfirst_node(TargetEntry, lc);
+			SortGroupClause *sgc = NULL;
+
+			if (tle->ressortgroupref != 0)
+				sgc = get_sortgroupref_clause_noerr(tle->ressortgroupref,
+													query->groupClause);
+
+			if (tle->resjunk)
+			{
+				if (sgc != NULL)
+				{
+					detail = _("All GROUP BY columns must appear in the select list.");
+					break;
+				}
+				continue;
+			}
+			attno++;
+
+			if (sgc != NULL)
+			{
+				if (!IsA(tle->expr, Var))
+				{
+					detail = _("GROUP BY is only supported on plain columns.");
+					break;
+				}
+				info->keyattnos[info->nkeys] = attno;
+				info->keyclauses[info->nkeys] = sgc;
+				info->keyexprs[info->nkeys] = tle->expr;
+				info->keynullable[info->nkeys] =
+					ivm_var_is_nullable(query, (Var *) tle->expr);
+				info->nkeys++;
+			}
+			else if (info->combinable)
+			{
+				info->combinefns[attno - 1] = ivm_combine_function(tle->expr);
+				if (!OidIsValid(info->combinefns[attno - 1]))
+					info->combinable = false;
+			}
+		}
+
+		if (detail == NULL && info->nkeys != ngroup)
+			detail = _("All GROUP BY columns must appear in the select list.");
+	}
+	else if (detail == NULL)
+	{
+		AttrNumber	attno = 0;
+
+		/*
+		 * Rows of a view without aggregation have no key, but its columns
+		 * that cannot be NULL and have an equality operator narrow down the
+		 * view rows that a deleted row could be; see ivm_apply_rows.
+		 */
+		info->matchattnos = palloc(list_length(query->targetList) *
+								   sizeof(AttrNumber));
+		info->matcheqops = palloc(list_length(query->targetList) *
+								  sizeof(Oid));
+
+		foreach(lc, query->targetList)
+		{
+			TargetEntry *tle = lfirst_node(TargetEntry, lc);
+			TypeCacheEntry *typentry;
+
+			if (tle->resjunk)
+				continue;
+			attno++;
+
+			if (!IsA(tle->expr, Var) ||
+				ivm_var_is_nullable(query, (Var *) tle->expr))
+				continue;
+
+			typentry = lookup_type_cache(exprType((Node *) tle->expr),
+										 TYPECACHE_EQ_OPR);
+			if (!OidIsValid(typentry->eq_opr))
+				continue;
+
+			info->matchattnos[info->nmatch] = attno;
+			info->matcheqops[info->nmatch] = typentry->eq_opr;
+			info->nmatch++;
+		}
+	}
+
+	if (detail != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialized view \"%s\" cannot be maintained incrementally",
+						RelationGetRelationName(matviewRel)),
+				 errdetail_internal("%s", detail)));
+
+	return info;
+}
+
+/*
+ * ivm_var_is_nullable
+ *		Can this column of the view's query be NULL?
+ *
+ * The view only has inner joins, so a column of a base table that is marked
+ * NOT NULL stays non-null in the query's result.
+ */
+static bool
+ivm_var_is_nullable(Query *query, Var *var)
+{
+	RangeTblEntry *rte;
+	HeapTuple	tp;
+	bool		result = true;
+
+	if (var->varlevelsup != 0 || var->varattno <= 0)
+		return true;
+
+	rte = rt_fetch(var->varno, query->rtable);
+	if (rte->rtekind == RTE_JOIN)
+	{
+		Node	   *aliasvar = list_nth(rte->joinaliasvars, var->varattno - 1);
+
+		if (aliasvar != NULL && IsA(aliasvar, Var))
+			return ivm_var_is_nullable(query, (Var *) aliasvar);
+		return true;
+	}
+	if (rte->rtekind != RTE_RELATION)
+		return true;
+
+	tp = SearchSysCache2(ATTNUM,
+						 ObjectIdGetDatum(rte->relid),
+						 Int16GetDatum(var->varattno));
+	if (HeapTupleIsValid(tp))
+	{
+		result = !((Form_pg_attribute) GETSTRUCT(tp))->attnotnull;
+		ReleaseSysCache(tp);
+	}
+	return result;
+}
+
+/*
+ * ivm_combine_function
+ *		If expr is an aggregate whose transition state is its result, return
+ *		the function that combines two such states; else InvalidOid.
+ */
+static Oid
+ivm_combine_function(Expr *expr)
+{
+	Aggref	   *aggref;
+	HeapTuple	tp;
+	Form_pg_aggregate aggform;
+	Oid			result = InvalidOid;
+
+	if (!IsA(expr, Aggref))
+		return InvalidOid;
+	aggref = (Aggref *) expr;
+
+	/* DISTINCT and ordered-set aggregates can't be combined this way */
+	if (aggref->aggdistinct != NIL || aggref->aggorder != NIL ||
+		aggref->aggkind != AGGKIND_NORMAL)
+		return InvalidOid;
+
+	tp = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(aggref->aggfnoid));
+	if (!HeapTupleIsValid(tp))
+		elog(ERROR, "cache lookup failed for aggregate %u", aggref->aggfnoid);
+	aggform = (Form_pg_aggregate) GETSTRUCT(tp);
+
+	/*
+	 * A strict combine function lets us treat a NULL on either side the way
+	 * nodeAgg.c does, by taking the other value.
+	 */
+	if (!OidIsValid(aggform->aggfinalfn) &&
+		OidIsValid(aggform->aggcombinefn) &&
+		aggform->aggtranstype == aggref->aggtype &&
+		func_strict(aggform->aggcombinefn))
+		result = aggform->aggcombinefn;
+
+	ReleaseSysCache(tp);
+
+	return result;
+}
+
+/*
+ * ivm_get_triggers
+ *		Return the OIDs of the triggers maintaining a view.
+ *
+ * They are the only triggers depending on the view.
+ */
+static List *
+ivm_get_triggers(Oid matviewOid)
+{
+	Relation	depRel;
+	ScanKeyData key[2];
+	SysScanDesc scan;
+	HeapTuple	tup;
+	List	   *result = NIL;
+
+	depRel = table_open(DependRelationId, AccessShareLock);
+
+	ScanKeyInit(&key[0],
+				Anum_pg_depend_refclassid,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(RelationRelationId));
+	ScanKeyInit(&key[1],
+				Anum_pg_depend_refobjid,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(matviewOid));
+
+	scan = systable_beginscan(depRel, DependReferenceIndexId, true,
+							  NULL, 2, key);
+
+	while (HeapTupleIsValid(tup = systable_getnext(scan)))
+	{
+		Form_pg_depend depform = (Form_pg_depend) GETSTRUCT(tup);
+
+		if (depform->classid == TriggerRelationId &&
+			depform->deptype == DEPENDENCY_AUTO)
+			result = lappend_oid(result, depform->objid);
+	}
+
+	systable_endscan(scan);
+	table_close(depRel, AccessShareLock);
+
+	return result;
+}
+
+/*
+ * ivm_create_triggers
+ *		Create the maintenance triggers on each of a view's base tables.
+ *
+ * Transition tables can only be attached to single-event triggers, so each
+ * table gets one trigger per kind of change.
+ */
+static void
+ivm_create_triggers(Relation matviewRel, IvmViewInfo *info)
+{
+	static const struct
+	{
+		char	   *name;
+		int16		event;
+		bool		oldtable;
+		bool		newtable;
+	}			triggers[] =
+	{
+		{"IVM_Trigger_ins", TRIGGER_TYPE_INSERT, false, true},
+		{"IVM_Trigger_del", TRIGGER_TYPE_DELETE, true, false},
+		{"IVM_Trigger_upd", TRIGGER_TYPE_UPDATE, true, true},
+		{"IVM_Trigger_truncate", TRIGGER_TYPE_TRUNCATE, false, false}
+	};
+	ObjectAddress matviewAddr;
+	ListCell   *lc;
+
+	ObjectAddressSet(matviewAddr, RelationRelationId,
+					 RelationGetRelid(matviewRel));
+
+	foreach(lc, info->relids)
+	{
+		Oid			relid = lfirst_oid(lc);
+		AclResult	aclresult;
+
+		/*
+		 * The triggers run on every change to the table, so creating them
+		 * needs the same privilege as CREATE TRIGGER.
+		 */
+		aclresult = pg_class_aclcheck(relid, GetUserId(), ACL_TRIGGER);
+		if (aclresult != ACLCHECK_OK)
+			aclcheck_error(aclresult, OBJECT_TABLE, get_rel_name(relid));
+
+		for (int i = 0; i < lengthof(triggers); i++)
+		{
+			CreateTrigStmt *stmt = makeNode(CreateTrigStmt);
+			ObjectAddress trigAddr;
+
+			stmt->replace = false;
+			stmt->isconstraint = false;
+			stmt->trigname = triggers[i].name;
+			stmt->relation = NULL;
+			stmt->funcname = SystemFuncName("matview_maintenance_trigger");
+			stmt->args = list_make1(makeString(psprintf("%u",
+														RelationGetRelid(matviewRel))));
+			stmt->row = false;
+			stmt->timing = TRIGGER_TYPE_AFTER;
+			stmt->events = triggers[i].event;
+			stmt->columns = NIL;
+			stmt->whenClause = NULL;
+			stmt->transitionRels = NIL;
+			if (triggers[i].oldtable)
+			{
+				TriggerTransition *tt = makeNode(TriggerTransition);
+
+				tt->name = "__ivm_oldtable";
+				tt->isNew = false;
+				tt->isTable = true;
+				stmt->transitionRels = lappend(stmt->transitionRels, tt);
+			}
+			if (triggers[i].newtable)
+			{
+				TriggerTransition *tt = makeNode(TriggerTransition);
+
+				tt->name = "__ivm_newtable";
+				tt->isNew = true;
+				tt->isTable = true;
+				stmt->transitionRels = lappend(stmt->transitionRels, tt);
+			}
+			stmt->deferrable = false;
+			stmt->initdeferred = false;
+			stmt->constrrel = NULL;
+
+			trigAddr = CreateTrigger(stmt, NULL, relid, InvalidOid,
+									 InvalidOid, InvalidOid,
+									 F_MATVIEW_MAINTENANCE_TRIGGER,
+									 InvalidOid, NULL, true, false);
+
+			/* The trigger goes away with the view, too. */
+			recordDependencyOn(&trigAddr, &matviewAddr, DEPENDENCY_AUTO);
+		}
+	}
+
+	/* Make changes-so-far visible */
+	CommandCounterIncrement();
+}
+
+/*
+ * ivm_compute
+ *		Work out the changes to make to a view, as a list of IvmWorkItems.
+ *
+ * "delta" is NULL if the whole view must be recomputed.  In deferred mode,
+ * the items are allocated to outlive the current statement.
+ */
+static List *
+ivm_compute(Relation matviewRel, IvmViewInfo *info, IvmDelta *delta,
+			bool deferred)
+{
+	Oid			matviewOid = RelationGetRelid(matviewRel);
+	List	   *items = NIL;
+	bool		hasold;
+	bool		hasnew;
+	QueryEnvironment *queryEnv;
+	IvmWorkItem *item;
+
+	if (delta == NULL)
+	{
+		item = palloc0(sizeof(IvmWorkItem));
+		item->matviewOid = matviewOid;
+		item->kind = IVM_WORK_FULL;
+		return list_make1(item);
+	}
+
+	hasold = delta->oldrows != NULL && tuplestore_tuple_count(delta->oldrows) > 0;
+	hasnew = delta->newrows != NULL && tuplestore_tuple_count(delta->newrows) > 0;
+
+	queryEnv = create_queryEnv();
+	if (hasold)
+		register_ENR(queryEnv, ivm_make_enr("__ivm_oldtable", delta->relid,
+											NULL, delta->oldrows));
+	if (hasnew)
+		register_ENR(queryEnv, ivm_make_enr("__ivm_newtable", delta->relid,
+											NULL, delta->newrows));
+
+	if (!info->grouped || (info->combinable && !hasold && !deferred))
+	{
+		/*
+		 * Run the view's query over each transition table.  For a grouped
+		 * view this gives the partial aggregates of the inserted rows.
+		 */
+		if (hasold)
+		{
+			item = palloc0(sizeof(IvmWorkItem));
+			item->matviewOid = matviewOid;
+			item->kind = IVM_WORK_DELETE;
+			item->rows = ivm_begin_store(deferred);
+			ivm_run_query(ivm_substitute_rel(info->query, delta,
+											 "__ivm_oldtable", delta->oldrows),
+						  queryEnv, item->rows);
+			items = lappend(items, item);
+		}
+		if (hasnew)
+		{
+			item = palloc0(sizeof(IvmWorkItem));
+			item->matviewOid = matviewOid;
+			item->kind = info->grouped ? IVM_WORK_MERGE : IVM_WORK_INSERT;
+			item->rows = ivm_begin_store(deferred);
+			ivm_run_query(ivm_substitute_rel(info->query, delta,
+											 "__ivm_newtable", delta->newrows),
+						  queryEnv, item->rows);
+			items = lappend(items, item);
+		}
+	}
+	else if (info->nkeys == 0)
+	{
+		/* A single-group aggregate can only be recomputed. */
+		item = palloc0(sizeof(IvmWorkItem));
+		item->matviewOid = matviewOid;
+		item->kind = IVM_WORK_FULL;
+		items = lappend(items, item);
+	}
+	else
+	{
+		Tuplestorestate *changed;
+		Query	   *keyquery;
+
+		/*
+		 * Find the groups the changed rows belong to, by running the view's
+		 * query reduced to its GROUP BY columns over both transition tables
+		 * at once.
+		 */
+		if (hasold && hasnew)
+		{
+			TupleTableSlot *slot = MakeSingleTupleTableSlot(delta->tupdesc,
+															&TTSOpsMinimalTuple);
+
+			changed = tuplestore_begin_heap(false, false, work_mem);
+			ivm_collect_rows(changed, delta->oldrows, slot);
+			ivm_collect_rows(changed, delta->newrows, slot);
+			ExecDropSingleTupleTableSlot(slot);
+
+			queryEnv = create_queryEnv();
+			register_ENR(queryEnv, ivm_make_enr("__ivm_changed", delta->relid,
+												NULL, changed));
+			keyquery = ivm_substitute_rel(ivm_group_key_query(info), delta,
+										  "__ivm_changed", changed);
+		}
+		else
+		{
+			changed = NULL;
+			if (hasold)
+				keyquery = ivm_substitute_rel(ivm_group_key_query(info), delta,
+											  "__ivm_oldtable", delta->oldrows);
+			else
+				keyquery = ivm_substitute_rel(ivm_group_key_query(info), delta,
+											  "__ivm_newtable", delta->newrows);
+		}
+
+		item = palloc0(sizeof(IvmWorkItem));
+		item->matviewOid = matviewOid;
+		item->kind = IVM_WORK_GROUPS;
+		item->rows = ivm_begin_store(deferred);
+		ivm_run_query(keyquery, queryEnv, item->rows);
+		items = lappend(items, item);
+
+		if (changed != NULL)
+			tuplestore_end(changed);
+	}
+
+	return items;
+}
+
+/*
+ * ivm_apply
+ *		Apply a list of work items to a view.
+ *
+ * The caller has locked the view and switched to its owner.  Sets *full if
+ * the whole view had to be recomputed, and returns the number of view rows
+ * deleted and inserted.
+ */
+static uint64
+ivm_apply(Relation matviewRel, IvmViewInfo *info, List *items, bool *full)
+{
+	uint64		rows = 0;
+	ListCell   *lc;
+	int			old_depth = matview_maintenance_depth;
+
+	*full = false;
+	foreach(lc, items)
+	{
+		IvmWorkItem *item = (IvmWorkItem *) lfirst(lc);
+
+		if (item->kind == IVM_WORK_FULL)
+			*full = true;
+	}
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	OpenMatViewIncrementalMaintenance();
+	PG_TRY();
+	{
+		/* A recomputed view reflects every other item too */
+		if (*full)
+			rows = ivm_apply_full(matviewRel, info);
+		else
+			rows = ivm_apply_items(matviewRel, info, items);
+	}
+	PG_CATCH();
+	{
+		matview_maintenance_depth = old_depth;
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	CloseMatViewIncrementalMaintenance();
+	Assert(matview_maintenance_depth == old_depth);
+
+	if (SPI_finish() != SPI_OK_FINISH)
+		elog(ERROR, "SPI_finish failed");
+
+	return rows;
+}
+
+/*
+ * ivm_apply_items
+ *		Guts of ivm_apply, when the view need not be recomputed.
+ */
+static uint64
+ivm_apply_items(Relation matviewRel, IvmViewInfo *info, List *items)
+{
+	Tuplestorestate *keys = NULL;
+	TupleTableSlot *slot = NULL;
+	uint64		rows = 0;
+	ListCell   *lc;
+
+	foreach(lc, items)
+	{
+		IvmWorkItem *item = (IvmWorkItem *) lfirst(lc);
+
+		if (item->kind != IVM_WORK_GROUPS)
+		{
+			rows += ivm_apply_rows(matviewRel, info, item->kind, item->rows);
+			continue;
+		}
+
+		/* Recompute all the touched groups in one go */
+		if (keys == NULL)
+		{
+			keys = item->rows;
+			continue;
+		}
+		if (slot == NULL)
+		{
+			Tuplestorestate *first = keys;
+
+			slot = MakeSingleTupleTableSlot(ivm_key_tupdesc(matviewRel, info),
+											&TTSOpsMinimalTuple);
+			keys = tuplestore_begin_heap(false, false, work_mem);
+			ivm_collect_rows(keys, first, slot);
+		}
+		ivm_collect_rows(keys, item->rows, slot);
+	}
+
+	if (keys != NULL)
+		rows += ivm_apply_groups(matviewRel, info, keys);
+
+	if (slot != NULL)
+	{
+		ExecDropSingleTupleTableSlot(slot);
+		tuplestore_end(keys);
+	}
+
+	return rows;
+}
+
+/*
+ * ivm_apply_rows
+ *		Delete, insert or merge a set of rows of the view's row type.
+ */
+static uint64
+ivm_apply_rows(Relation matviewRel, IvmViewInfo *info, IvmWorkKind kind,
+			   Tuplestorestate *rows)
+{
+	TupleDesc	tupdesc = RelationGetDescr(matviewRel);
+	char	   *matviewname;
+	StringInfoData querybuf;
+	uint64		processed = 0;
+
+	if (tuplestore_tuple_count(rows) == 0)
+		return 0;
+
+	matviewname = quote_qualified_identifier(get_namespace_name(RelationGetNamespace(matviewRel)),
+											 RelationGetRelationName(matviewRel));
+
+	if (SPI_register_relation(ivm_make_enr("__ivm_rows", InvalidOid, tupdesc,
+										   rows)) != SPI_OK_REL_REGISTER)
+		elog(ERROR, "SPI_register_relation failed");
+
+	initStringInfo(&querybuf);
+	switch (kind)
+	{
+		case IVM_WORK_DELETE:
+
+			/*
+			 * Delete as many copies of each row as the delta holds.  Rows
+			 * are identified by their text image, since the view's columns
+			 * need not have equality operators; compare
+			 * refresh_by_match_merge.  The distinct delta rows are joined to
+			 * the view on the columns collected by ivm_analyze_view, so that
+			 * an index on the view can be used, and only the view rows found
+			 * that way are compared by their text image.  The OFFSET keeps
+			 * the planner from making that comparison a join clause.
+			 */
+			appendStringInfo(&querybuf,
+							 "DELETE FROM %s mv WHERE ctid OPERATOR(pg_catalog.=) ANY "
+							 "(SELECT v.tid FROM "
+							 "(SELECT c.tid, c.cnt, pg_catalog.row_number() OVER "
+							 "(PARTITION BY c.img) AS rn FROM "
+							 "(SELECT mv2.ctid AS tid, mv2.*::pg_catalog.text AS mvimg, "
+							 "dc.__ivm_img AS img, dc.__ivm_cnt AS cnt "
+							 "FROM %s mv2 JOIN "
+							 "(SELECT DISTINCT ON (d.__ivm_img) d.* FROM "
+							 "(SELECT d.*, d.*::pg_catalog.text AS __ivm_img, "
+							 "pg_catalog.count(*) OVER "
+							 "(PARTITION BY d.*::pg_catalog.text) AS __ivm_cnt "
+							 "FROM __ivm_rows d) d) dc ON ",
+							 matviewname, matviewname);
+			if (info->nmatch == 0)
+				appendStringInfoString(&querybuf,
+									   "mv2.*::pg_catalog.text "
+									   "OPERATOR(pg_catalog.=) dc.__ivm_img");
+			for (int i = 0; i < info->nmatch; i++)
+			{
+				Form_pg_attribute attr = TupleDescAttr(tupdesc,
+													   info->matchattnos[i] - 1);
+
+				if (i > 0)
+					appendStringInfoString(&querybuf, " AND ");
+				generate_operator_clause(&querybuf,
+										 quote_qualified_identifier("mv2", NameStr(attr->attname)),
+										 attr->atttypid,
+										 info->matcheqops[i],
+										 quote_qualified_identifier("dc", NameStr(attr->attname)),
+										 attr->atttypid);
+			}
+			appendStringInfoString(&querybuf,
+								   " OFFSET 0) c "
+								   "WHERE c.mvimg OPERATOR(pg_catalog.=) c.img) v "
+								   "WHERE v.rn OPERATOR(pg_catalog.<=) v.cnt)");
+			if (SPI_exec(querybuf.data, 0) != SPI_OK_DELETE)
+				elog(ERROR, "SPI_exec failed: %s", querybuf.data);
+			processed = SPI_processed;
+			break;
+
+		case IVM_WORK_INSERT:
+			appendStringInfo(&querybuf,
+							 "INSERT INTO %s SELECT * FROM __ivm_rows",
+							 matviewname);
+			if (SPI_exec(querybuf.data, 0) != SPI_OK_INSERT)
+				elog(ERROR, "SPI_exec failed: %s", querybuf.data);
+			processed = SPI_processed;
+			break;
+
+		case IVM_WORK_MERGE:
+			{
+				bool		first = true;
+
+				/* Fold the partial aggregates into the existing groups... */
+				appendStringInfo(&querybuf, "UPDATE %s mv SET ", matviewname);
+				for (int i = 0; i < tupdesc->natts; i++)
+				{
+					Oid			fn = info->combinefns[i];
+					char	   *colname;
+					char	   *mvcol;
+					char	   *dcol;
+
+					if (!OidIsValid(fn))
+						continue;
+
+					colname = NameStr(TupleDescAttr(tupdesc, i)->attname);
+					mvcol = quote_qualified_identifier("mv", colname);
+					dcol = quote_qualified_identifier("d", colname);
+					appendStringInfo(&querybuf,
+									 "%s%s = CASE WHEN %s IS NULL THEN %s "
+									 "WHEN %s IS NULL THEN %s ELSE %s(%s, %s) END",
+									 first ? "" : ", ",
+									 quote_identifier(colname),
+									 mvcol, dcol, dcol, mvcol,
+									 quote_qualified_identifier(get_namespace_name(get_func_namespace(fn)),
+																get_func_name(fn)),
+									 mvcol, dcol);
+					first = false;
+				}
+				if (!first)
+				{
+					appendStringInfoString(&querybuf, " FROM __ivm_rows d WHERE ");
+					ivm_append_group_match(&querybuf, matviewRel, info, "mv", "d");
+					if (SPI_exec(querybuf.data, 0) != SPI_OK_UPDATE)
+						elog(ERROR, "SPI_exec failed: %s", querybuf.data);
+					processed = SPI_processed;
+				}
+
+				/* ... and add the groups that are new */
+				resetStringInfo(&querybuf);
+				appendStringInfo(&querybuf,
+								 "INSERT INTO %s SELECT d.* FROM __ivm_rows d "
+								 "WHERE NOT EXISTS (SELECT 1 FROM %s mv WHERE ",
+								 matviewname, matviewname);
+				ivm_append_group_match(&querybuf, matviewRel, info, "mv", "d");
+				appendStringInfoChar(&querybuf, ')');
+				if (SPI_exec(querybuf.data, 0) != SPI_OK_INSERT)
+					elog(ERROR, "SPI_exec failed: %s", querybuf.data);
+				processed += SPI_processed;
+			}
+			break;
+
+		default:
+			elog(ERROR, "unexpected incremental maintenance work kind: %d",
+				 (int) kind);
+	}
+
+	if (SPI_unregister_relation("__ivm_rows") != SPI_OK_REL_UNREGISTER)
+		elog(ERROR, "SPI_unregister_relation failed");
+
+	return processed;
+}
+
+/*
+ * ivm_apply_groups
+ *		Recompute the groups of a grouped view with the given keys.
+ */
+static uint64
+ivm_apply_groups(Relation matviewRel, IvmViewInfo *info, Tuplestorestate *keys)
+{
+	TupleDesc	keydesc = ivm_key_tupdesc(matviewRel, info);
+	QueryEnvironment *queryEnv;
+	Tuplestorestate *rows;
+	StringInfoData querybuf;
+	uint64		processed;
+
+	if (tuplestore_tuple_count(keys) == 0)
+		return 0;
+
+	/* Compute the groups' new contents before touching the view */
+	queryEnv = create_queryEnv();
+	register_ENR(queryEnv, ivm_make_enr("__ivm_groups", InvalidOid, keydesc,
+										keys));
+	rows = tuplestore_begin_heap(false, false, work_mem);
+	ivm_run_query(ivm_restrict_to_groups(info, keydesc,
+										 tuplestore_tuple_count(keys)),
+				  queryEnv, rows);
+
+	/* Remove the groups' old rows */
+	if (SPI_register_relation(ivm_make_enr("__ivm_groups", InvalidOid, keydesc,
+										   keys)) != SPI_OK_REL_REGISTER)
+		elog(ERROR, "SPI_register_relation failed");
+
+	initStringInfo(&querybuf);
+	appendStringInfo(&querybuf, "DELETE FROM %s mv USING __ivm_groups k WHERE ",
+					 quote_qualified_identifier(get_namespace_name(RelationGetNamespace(matviewRel)),
+												RelationGetRelationName(matviewRel)));
+	ivm_append_group_match(&querybuf, matviewRel, info, "mv", "k");
+	if (SPI_exec(querybuf.data, 0) != SPI_OK_DELETE)
+		elog(ERROR, "SPI_exec failed: %s", querybuf.data);
+	processed = SPI_processed;
+
+	if (SPI_unregister_relation("__ivm_groups") != SPI_OK_REL_UNREGISTER)
+		elog(ERROR, "SPI_unregister_relation failed");
+
+	/* And put in the new ones */
+	processed += ivm_apply_rows(matviewRel, info, IVM_WORK_INSERT, rows);
+	tuplestore_end(rows);
+
+	return processed;
+}
+
+/*
+ * ivm_apply_full
+ *		Recompute the whole view.
+ *
+ * Unlike REFRESH this keeps the view's storage, so that it can run under the
+ * ExclusiveLock of ordinary maintenance.
+ */
+static uint64
+ivm_apply_full(Relation matviewRel, IvmViewInfo *info)
+{
+	Tuplestorestate *rows;
+	StringInfoData querybuf;
+	uint64		processed;
+
+	rows = tuplestore_begin_heap(false, false, work_mem);
+	ivm_run_query(copyObject(info->query), NULL, rows);
+
+	initStringInfo(&querybuf);
+	appendStringInfo(&querybuf, "DELETE FROM %s",
+					 quote_qualified_identifier(get_namespace_name(RelationGetNamespace(matviewRel)),
+												RelationGetRelationName(matviewRel)));
+	if (SPI_exec(querybuf.data, 0) != SPI_OK_DELETE)
+		elog(ERROR, "SPI_exec failed: %s", querybuf.data);
+	processed = SPI_processed;
+
+	processed += ivm_apply_rows(matviewRel, info, IVM_WORK_INSERT, rows);
+	tuplestore_end(rows);
+
+	return processed;
+}
+
+/*
+ * ivm_append_group_match
+ *		Append a condition matching the GROUP BY columns of two relations of
+ *		the view's row type (or of its key type).
+ *
+ * This uses the grouping's own equality operators, and makes NULL keys
+ * match each other as GROUP BY does.
+ */
+static void
+ivm_append_group_match(StringInfo buf, Relation matviewRel, IvmViewInfo *info,
+					   const char *left, const char *right)
+{
+	TupleDesc	tupdesc = RelationGetDescr(matviewRel);
+
+	if (info->nkeys == 0)
+	{
+		appendStringInfoString(buf, "true");
+		return;
+	}
+
+	for (int i = 0; i < info->nkeys; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, info->keyattnos[i] - 1);
+		const char *leftop = quote_qualified_identifier(left,
+														NameStr(attr->attname));
+		const char *rightop = quote_qualified_identifier(right,
+														 NameStr(attr->attname));
+
+		if (i > 0)
+			appendStringInfoString(buf, " AND ");
+		if (info->keynullable[i])
+			appendStringInfoChar(buf, '(');
+		generate_operator_clause(buf,
+								 leftop, attr->atttypid,
+								 info->keyclauses[i]->eqop,
+								 rightop, attr->atttypid);
+		if (info->keynullable[i])
+			appendStringInfo(buf, " OR (%s IS NULL AND %s IS NULL))",
+							 leftop, rightop);
+	}
+}
+
+/*
+ * ivm_run_query
+ *		Plan and run a query built from the view's query, adding its result
+ *		rows to "store".  "queryEnv" supplies any ephemeral relations it
+ *		reads.  The query is scribbled on.
+ */
+static void
+ivm_run_query(Query *query, QueryEnvironment *queryEnv, Tuplestorestate *store)
+{
+	List	   *rewritten;
+	PlannedStmt *plan;
+	QueryDesc  *queryDesc;
+	DestReceiver *dest;
+
+	AcquireRewriteLocks(query, true, false);
+	rewritten = QueryRewrite(query);
+
+	/* SELECT should never rewrite to more or less than one SELECT query */
+	if (list_length(rewritten) != 1)
+		elog(ERROR, "unexpected rewrite result for incremental maintenance");
+	query = (Query *) linitial(rewritten);
+
+	/* Check for user-requested abort. */
+	CHECK_FOR_INTERRUPTS();
+
+	plan = pg_plan_query(query, IVM_QUERY_STRING, CURSOR_OPT_PARALLEL_OK, NULL);
+
+	/*
+	 * Make the changes of the statement that fired us visible, and in READ
+	 * COMMITTED mode also those of transactions that committed while we
+	 * waited for the view's lock.
+	 */
+	CommandCounterIncrement();
+	PushActiveSnapshot(GetTransactionSnapshot());
+	UpdateActiveSnapshotCommandId();
+
+	dest = CreateTuplestoreDestReceiver();
+	SetTuplestoreDestReceiverParams(dest, store, CurrentMemoryContext, true,
+									NULL, NULL);
+
+	queryDesc = CreateQueryDesc(plan, IVM_QUERY_STRING,
+								GetActiveSnapshot(), InvalidSnapshot,
+								dest, NULL, queryEnv, 0);
+
+	ExecutorStart(queryDesc, 0);
+	ExecutorRun(queryDesc, ForwardScanDirection, 0, true);
+	ExecutorFinish(queryDesc);
+	ExecutorEnd(queryDesc);
+
+	FreeQueryDesc(queryDesc);
+	dest->rDestroy(dest);
+
+	PopActiveSnapshot();
+}
+
+/*
+ * ivm_begin_store
+ *		Create a tuplestore for a work item.
+ */
+static Tuplestorestate *
+ivm_begin_store(bool deferred)
+{
+	Tuplestorestate *store;
+	MemoryContext oldcxt;
+	ResourceOwner saveResourceOwner;
+
+	if (!deferred)
+		return tuplestore_begin_heap(false, false, work_mem);
+
+	oldcxt = MemoryContextSwitchTo(TopTransactionContext);
+	saveResourceOwner = CurrentResourceOwner;
+	CurrentResourceOwner = TopTransactionResourceOwner;
+	store = tuplestore_begin_heap(false, false, work_mem);
+	CurrentResourceOwner = saveResourceOwner;
+	MemoryContextSwitchTo(oldcxt);
+
+	return store;
+}
+
+/*
+ * ivm_collect_rows
+ *		Append the rows of one tuplestore to another.
+ */
+static void
+ivm_collect_rows(Tuplestorestate *dst, Tuplestorestate *src,
+				 TupleTableSlot *slot)
+{
+	tuplestore_select_read_pointer(src, 0);
+	tuplestore_rescan(src);
+	while (tuplestore_gettupleslot(src, true, false, slot))
+		tuplestore_puttupleslot(dst, slot);
+	ExecClearTuple(slot);
+}
+
+/*
+ * ivm_make_enr
+ *		Describe a tuplestore as an ephemeral named relation, having either
+ *		the row type of relation "relid" or the given descriptor.
+ */
+static EphemeralNamedRelation
+ivm_make_enr(const char *name, Oid relid, TupleDesc tupdesc,
+			 Tuplestorestate *store)
+{
+	EphemeralNamedRelation enr = palloc(sizeof(EphemeralNamedRelationData));
+
+	enr->md.name = pstrdup(name);
+	enr->md.reliddesc = relid;
+	enr->md.tupdesc = OidIsValid(relid) ? NULL : tupdesc;
+	enr->md.enrtype = ENR_NAMED_TUPLESTORE;
+	enr->md.enrtuples = tuplestore_tuple_count(store);
+	enr->reldata = store;
+
+	return enr;
+}
+
+/*
+ * ivm_init_enr_rte
+ *		Turn "rte" into a reference to an ephemeral named relation, as
+ *		addRangeTableEntryForENR would.  The caller sets up eref.
+ */
+static void
+ivm_init_enr_rte(RangeTblEntry *rte, const char *name, TupleDesc tupdesc,
+				 double ntuples)
+{
+	rte->rtekind = RTE_NAMEDTUPLESTORE;
+	rte->relkind = 0;
+	rte->rellockmode = NoLock;
+	rte->tablesample = NULL;
+	rte->perminfoindex = 0;
+	rte->inh = false;
+	rte->lateral = false;
+	rte->inFromCl = true;
+	rte->enrname = pstrdup(name);
+	rte->enrtuples = ntuples;
+	rte->coltypes = NIL;
+	rte->coltypmods = NIL;
+	rte->colcollations = NIL;
+	for (int i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute att = TupleDescAttr(tupdesc, i);
+
+		if (att->attisdropped)
+		{
+			/* Record zeroes for a dropped column */
+			rte->coltypes = lappend_oid(rte->coltypes, InvalidOid);
+			rte->coltypmods = lappend_int(rte->coltypmods, 0);
+			rte->colcollations = lappend_oid(rte->colcollations, InvalidOid);
+		}
+		else
+		{
+			rte->coltypes = lappend_oid(rte->coltypes, att->atttypid);
+			rte->coltypmods = lappend_int(rte->coltypmods, att->atttypmod);
+			rte->colcollations = lappend_oid(rte->colcollations,
+											 att->attcollation);
+		}
+	}
+}
+
+/*
+ * ivm_substitute_rel
+ *		Return a copy of "query" that reads the named ephemeral relation,
+ *		holding rows of the changed table, in place of that table.
+ *
+ * The rows have the table's row type, so the query's Vars and column
+ * aliases stay valid.  As for a transition table referenced by name in a
+ * trigger function, the RTE keeps the table's OID as its relid.
+ */
+static Query *
+ivm_substitute_rel(Query *query, IvmDelta *delta, const char *enrname,
+				   Tuplestorestate *store)
+{
+	Query	   *result = copyObject(query);
+	ListCell   *lc;
+
+	foreach(lc, result->rtable)
+	{
+		RangeTblEntry *rte = lfirst_node(RangeTblEntry, lc);
+
+		if (rte->rtekind == RTE_RELATION && rte->relid == delta->relid)
+		{
+			ivm_init_enr_rte(rte, enrname, delta->tupdesc,
+							 tuplestore_tuple_count(store));
+			return result;
+		}
+	}
+
+	elog(ERROR, "relation %u is not used by materialized view query",
+		 delta->relid);
+	return NULL;				/* keep compiler quiet */
+}
+
+/*
+ * ivm_group_key_query
+ *		Return a copy of a grouped view's query computing only its groups'
+ *		keys.
+ */
+static Query *
+ivm_group_key_query(IvmViewInfo *info)
+{
+	Query	   *query = copyObject(info->query);
+	List	   *tlist = NIL;
+	ListCell   *lc;
+
+	foreach(lc, query->targetList)
+	{
+		TargetEntry *tle = lfirst_node(TargetEntry, lc);
+
+		if (!tle->resjunk && tle->ressortgroupref != 0 &&
+			get_sortgroupref_clause_noerr(tle->ressortgroupref,
+										  query->groupClause) != NULL)
+		{
+			tle->resno = list_length(tlist) + 1;
+			tlist = lappend(tlist, tle);
+		}
+	}
+
+	query->targetList = tlist;
+	query->hasAggs = false;
+	query->havingQual = NULL;
+	query->sortClause = NIL;
+
+	return query;
+}
+
+/*
+ * ivm_restrict_to_groups
+ *		Return a copy of a grouped view's query computing only the groups
+ *		whose keys are in the "__ivm_groups" relation.
+ *
+ * The keys may have duplicates, so they are joined in through a subquery
+ * grouping them the way the view does.
+ */
+static Query *
+ivm_restrict_to_groups(IvmViewInfo *info, TupleDesc keydesc, double nkeys)
+{
+	Query	   *query = copyObject(info->query);
+	Query	   *subquery = makeNode(Query);
+	RangeTblEntry *enrrte = makeNode(RangeTblEntry);
+	RangeTblEntry *subrte = makeNode(RangeTblEntry);
+	RangeTblRef *rtr;
+	List	   *colnames = NIL;
+	List	   *quals = NIL;
+	Index		subrtindex;
+
+	for (int i = 0; i < info->nkeys; i++)
+		colnames = lappend(colnames,
+						   makeString(pstrdup(NameStr(TupleDescAttr(keydesc, i)->attname))));
+
+	/* SELECT k1, ..., kn FROM __ivm_groups GROUP BY k1, ..., kn */
+	ivm_init_enr_rte(enrrte, "__ivm_groups", keydesc, nkeys);
+	enrrte->eref = makeAlias("__ivm_groups", colnames);
+
+	subquery->commandType = CMD_SELECT;
+	subquery->querySource = QSRC_ORIGINAL;
+	subquery->rtable = list_make1(enrrte);
+	rtr = makeNode(RangeTblRef);
+	rtr->rtindex = 1;
+	subquery->jointree = makeFromExpr(list_make1(rtr), NULL);
+
+	for (int i = 0; i < info->nkeys; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(keydesc, i);
+		TargetEntry *tle;
+		SortGroupClause *sgc;
+
+		tle = makeTargetEntry((Expr *) makeVar(1, i + 1, attr->atttypid,
+											   attr->atttypmod,
+											   attr->attcollation, 0),
+							  i + 1, pstrdup(NameStr(attr->attname)), false);
+		tle->ressortgroupref = i + 1;
+		subquery->targetList = lappend(subquery->targetList, tle);
+
+		sgc = copyObject(info->keyclauses[i]);
+		sgc->tleSortGroupRef = i + 1;
+		subquery->groupClause = lappend(subquery->groupClause, sgc);
+	}
+
+	subrte->rtekind = RTE_SUBQUERY;
+	subrte->subquery = subquery;
+	subrte->eref = makeAlias("__ivm_groups", colnames);
+	subrte->lateral = false;
+	subrte->inh = false;
+	subrte->inFromCl = true;
+	query->rtable = lappend(query->rtable, subrte);
+	subrtindex = list_length(query->rtable);
+
+	rtr = makeNode(RangeTblRef);
+	rtr->rtindex = subrtindex;
+	query->jointree->fromlist = lappend(query->jointree->fromlist, rtr);
+
+	/* ... WHERE <group key> = __ivm_groups.<key> for each key */
+	for (int i = 0; i < info->nkeys; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(keydesc, i);
+		Expr	   *keyexpr = copyObject(info->keyexprs[i]);
+		Expr	   *keyvar;
+		Expr	   *qual;
+
+		keyvar = (Expr *) makeVar(subrtindex, i + 1, attr->atttypid,
+								  attr->atttypmod, attr->attcollation, 0);
+		qual = make_opclause(info->keyclauses[i]->eqop, BOOLOID, false,
+							 keyexpr, keyvar,
+							 InvalidOid, exprCollation((Node *) keyexpr));
+
+		if (info->keynullable[i])
+		{
+			NullTest   *ntest1 = makeNode(NullTest);
+			NullTest   *ntest2 = makeNode(NullTest);
+
+			ntest1->arg = copyObject(keyexpr);
+			ntest1->nulltesttype = IS_NULL;
+			ntest1->argisrow = false;
+			ntest1->location = -1;
+			ntest2->arg = copyObject(keyvar);
+			ntest2->nulltesttype = IS_NULL;
+			ntest2->argisrow = false;
+			ntest2->location = -1;
+			qual = make_orclause(list_make2(qual,
+											make_andclause(list_make2(ntest1,
+																	  ntest2))));
+		}
+		quals = lappend(quals, qual);
+	}
+
+	query->jointree->quals = make_and_qual(query->jointree->quals,
+										   (Node *) make_ands_explicit(quals));
+
+	return query;
+}
+
+/*
+ * ivm_key_tupdesc
+ *		Build the descriptor of a grouped view's group keys.
+ */
+static TupleDesc
+ivm_key_tupdesc(Relation matviewRel, IvmViewInfo *info)
+{
+	TupleDesc	matviewDesc = RelationGetDescr(matviewRel);
+	TupleDesc	keydesc = CreateTemplateTupleDesc(info->nkeys);
+
+	for (int i = 0; i < info->nkeys; i++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(matviewDesc,
+											   info->keyattnos[i] - 1);
+
+		TupleDescInitEntry(keydesc, i + 1, NameStr(attr->attname),
+						   attr->atttypid, attr->atttypmod, 0);
+		TupleDescInitEntryCollation(keydesc, i + 1, attr->attcollation);
+	}
+
+	return keydesc;
+}
+
+/*
+ * ivm_free_work
+ *		Release the tuplestores of a list of work items.
+ */
+static void
+ivm_free_work(List *items)
+{
+	ListCell   *lc;
+
+	foreach(lc, items)
+	{
+		IvmWorkItem *item = (IvmWorkItem *) lfirst(lc);
+
+		if (item->rows != NULL)
+			tuplestore_end(item->rows);
+		item->rows = NULL;
+	}
+}
+
+/*
+ * ivm_queue_work
+ *		Queue a work item of a deferred-mode view for commit.
+ */
+static void
+ivm_queue_work(IvmWorkItem *item)
+{
+	MemoryContext oldcxt = MemoryContextSwitchTo(TopTransactionContext);
+	IvmWorkItem *copy = palloc(sizeof(IvmWorkItem));
+
+	*copy = *item;
+	copy->subid = GetCurrentSubTransactionId();
+	ivm_pending = lappend(ivm_pending, copy);
+
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * MatViewResetPendingMaintenance
+ *		Note that a view has been refreshed, so any work queued for it so
+ *		far in this transaction is moot.
+ *
+ * The queued items can't simply be discarded, since the refresh might yet
+ * be rolled back along with a subtransaction.
+ */
+void
+MatViewResetPendingMaintenance(Oid matviewOid)
+{
+	ListCell   *lc;
+
+	foreach(lc, ivm_pending)
+	{
+		IvmWorkItem *item = (IvmWorkItem *) lfirst(lc);
+
+		if (item->matviewOid == matviewOid)
+		{
+			IvmWorkItem reset = {0};
+
+			reset.matviewOid = matviewOid;
+			reset.kind = IVM_WORK_RESET;
+			ivm_queue_work(&reset);
+			break;
+		}
+	}
+}
+
+/*
+ * PreCommit_MatViewMaintenance
+ *		Apply the work queued by deferred-mode views.
+ */
+void
+PreCommit_MatViewMaintenance(void)
+{
+	while (ivm_pending != NIL)
+	{
+		Oid			matviewOid = ((IvmWorkItem *) linitial(ivm_pending))->matviewOid;
+		List	   *items = NIL;
+		List	   *rest = NIL;
+		ListCell   *lc;
+		MemoryContext oldcxt;
+
+		/*
+		 * Pick out this view's items, dropping those that precede a refresh.
+		 * ivm_pending and its cells live in TopTransactionContext.
+		 */
+		oldcxt = MemoryContextSwitchTo(TopTransactionContext);
+		foreach(lc, ivm_pending)
+		{
+			IvmWorkItem *item = (IvmWorkItem *) lfirst(lc);
+
+			if (item->matviewOid != matviewOid)
+				rest = lappend(rest, item);
+			else if (item->kind == IVM_WORK_RESET)
+			{
+				ivm_free_work(items);
+				list_free(items);
+				items = NIL;
+			}
+			else
+				items = lappend(items, item);
+		}
+		list_free(ivm_pending);
+		ivm_pending = rest;
+		MemoryContextSwitchTo(oldcxt);
+
+		if (items != NIL)
+			ivm_run_pending(matviewOid, items);
+		ivm_free_work(items);
+	}
+}
+
+/*
+ * ivm_run_pending
+ *		Apply the work queued for one deferred-mode view.
+ */
+static void
+ivm_run_pending(Oid matviewOid, List *items)
+{
+	Relation	matviewRel;
+	IvmViewInfo *info;
+	bool		full;
+	uint64		rows;
+	Oid			save_userid;
+	int			save_sec_context;
+	int			save_nestlevel;
+	instr_time	start;
+	instr_time	elapsed;
+
+	INSTR_TIME_SET_CURRENT(start);
+
+	/*
+	 * The view may have been dropped, emptied by REFRESH ... WITH NO DATA, or
+	 * had its maintenance switched off since the work was queued.
+	 */
+	matviewRel = try_table_open(matviewOid, AccessShareLock);
+	if (matviewRel == NULL)
+		return;
+	if (!RelationIsPopulated(matviewRel) ||
+		RelationGetIncrementalMaintenance(matviewRel) ==
+		STDRD_OPTION_INCREMENTAL_MAINTENANCE_OFF)
+	{
+		table_close(matviewRel, AccessShareLock);
+		return;
+	}
+
+	GetUserIdAndSecContext(&save_userid, &save_sec_context);
+	SetUserIdAndSecContext(matviewRel->rd_rel->relowner,
+						   save_sec_context | SECURITY_RESTRICTED_OPERATION);
+	save_nestlevel = NewGUCNestLevel();
+
+	ivm_lock_matview(matviewRel);
+	info = ivm_analyze_view(matviewRel);
+	rows = ivm_apply(matviewRel, info, items, &full);
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, start);
+	pgstat_count_matview_maintenance(matviewRel, full, rows, elapsed);
+
+	/* Roll back any GUC changes */
+	AtEOXact_GUC(false, save_nestlevel);
+
+	/* Restore userid and security context */
+	SetUserIdAndSecContext(save_userid, save_sec_context);
+
+	table_close(matviewRel, NoLock);
+}
+
+/*
+ * AtEOXact_MatViewMaintenance
+ *		Forget queued work at transaction end.
+ *
+ * Everything was applied by PreCommit_MatViewMaintenance if we are
+ * committing; on abort, the memory goes away with TopTransactionContext and
+ * the tuplestores' files with the resource owner.
+ */
+void
+AtEOXact_MatViewMaintenance(bool isCommit)
+{
+	Assert(!isCommit || ivm_pending == NIL);
+	ivm_pending = NIL;
+}
+
+/*
+ * AtEOSubXact_MatViewMaintenance
+ *		Hand queued work over to the parent at subtransaction commit, or
+ *		discard it at subtransaction abort.
+ */
+void
+AtEOSubXact_MatViewMaintenance(bool isCommit, SubTransactionId mySubid,
+							   SubTransactionId parentSubid)
+{
+	ListCell   *lc;
+
+	foreach(lc, ivm_pending)
+	{
+		IvmWorkItem *item = (IvmWorkItem *) lfirst(lc);
+
+		if (item->subid != mySubid)
+			continue;
+
+		if (isCommit)
+			item->subid = parentSubid;
+		else
+		{
+			if (item->rows != NULL)
+				tuplestore_end(item->rows);
+			ivm_pending = foreach_delete_current(ivm_pending, lc);
+			pfree(item);
+		}
+	}
+}
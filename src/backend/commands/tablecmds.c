@@ -54,6 +54,7 @@
 #include "commands/comment.h"
 #include "commands/defrem.h"
 #include "commands/event_trigger.h"
+#include "commands/matview.h"
 #include "commands/policy.h"
 #include "commands/sequence.h"
 #include "commands/tablecmds.h"
@@ -14419,6 +14420,23 @@ ATExecSetRelOptions(Relation rel, List *defList, AlterTableType operation,
 
 	ReleaseSysCache(tuple);
 
+	/* Start or stop incremental maintenance of a materialized view */
+	if (rel->rd_rel->relkind == RELKIND_MATVIEW)
+	{
+		StdRdOptions *opts;
+		bool		maintain;
+
+		opts = (StdRdOptions *) heap_reloptions(RELKIND_MATVIEW, newOptions,
+												false);
+		maintain = (opts != NULL &&
+					opts->incremental_maintenance !=
+					STDRD_OPTION_INCREMENTAL_MAINTENANCE_OFF);
+
+		/* Make the new options visible to the maintenance code */
+		CommandCounterIncrement();
+		SetMatViewIncrementalMaintenance(rel, maintain);
+	}
+
 	/* repeat the whole exercise for the toast table, if there's one */
 	if (OidIsValid(rel->rd_rel->reltoastrelid))
 	{
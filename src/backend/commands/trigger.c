@@ -6004,6 +6004,40 @@ AfterTriggerPendingOnRel(Oid relid)
 	return false;
 }
 
+/* ----------
+ * AfterTriggerQueryModifiesRel()
+ *		Test whether the query whose AFTER triggers are being fired is
+ *		capturing transition tuples for rel.
+ *
+ * Every relation targeted by the query that has triggers with transition
+ * tables gets an AfterTriggersTableData entry at the current query level, so
+ * this tells a statement-level trigger which other such relations were
+ * modified by the same statement (through writable CTEs, say).  Changes made
+ * by nested queries, such as those run by other triggers, are not seen.
+ * ----------
+ */
+bool
+AfterTriggerQueryModifiesRel(Oid relid)
+{
+	AfterTriggersQueryData *qs;
+	ListCell   *lc;
+
+	if (afterTriggers.query_depth < 0 ||
+		afterTriggers.query_depth >= afterTriggers.maxquerydepth)
+		return false;
+
+	qs = &afterTriggers.query_stack[afterTriggers.query_depth];
+	foreach(lc, qs->tables)
+	{
+		AfterTriggersTableData *table = (AfterTriggersTableData *) lfirst(lc);
+
+		if (table->relid == relid)
+			return true;
+	}
+
+	return false;
+}
+
 /* ----------
  * AfterTriggerSaveEvent()
  *
@@ -17,7 +17,10 @@
 #include "executor/execAsync.h"
 #include "executor/executor.h"
 #include "executor/nodeAppend.h"
+#include "executor/nodeBitmapHeapscan.h"
 #include "executor/nodeForeignscan.h"
+#include "executor/nodeGather.h"
+#include "executor/nodeSeqscan.h"
 
 /*
  * Asynchronously request a tuple from a designed async-capable node.
@@ -37,6 +40,15 @@ ExecAsyncRequest(AsyncRequest *areq)
 		case T_ForeignScanState:
 			ExecAsyncForeignScanRequest(areq);
 			break;
+		case T_SeqScanState:
+			ExecAsyncSeqScanRequest(areq);
+			break;
+		case T_BitmapHeapScanState:
+			ExecAsyncBitmapHeapScanRequest(areq);
+			break;
+		case T_GatherState:
+			ExecAsyncGatherRequest(areq);
+			break;
 		default:
 			/* If the node doesn't support async, caller messed up. */
 			elog(ERROR, "unrecognized node type: %d",
@@ -57,6 +69,12 @@ ExecAsyncRequest(AsyncRequest *areq)
  * make a single call of the following form:
  *
  * AddWaitEventToSet(set, WL_SOCKET_READABLE, fd, NULL, areq);
+ *
+ * Nodes that have no file descriptor to wait on can instead set
+ * areq->wait_latch, to be notified once the process latch is set (this is
+ * how a Gather waits for its workers), or configure nothing at all, to be
+ * notified as soon as the requestor has polled for the other events (this
+ * is how a local scan waits for the read of its next page it has started).
  */
 void
 ExecAsyncConfigureWait(AsyncRequest *areq)
@@ -70,6 +88,15 @@ ExecAsyncConfigureWait(AsyncRequest *areq)
 		case T_ForeignScanState:
 			ExecAsyncForeignScanConfigureWait(areq);
 			break;
+		case T_SeqScanState:
+			ExecAsyncSeqScanConfigureWait(areq);
+			break;
+		case T_BitmapHeapScanState:
+			ExecAsyncBitmapHeapScanConfigureWait(areq);
+			break;
+		case T_GatherState:
+			ExecAsyncGatherConfigureWait(areq);
+			break;
 		default:
 			/* If the node doesn't support async, caller messed up. */
 			elog(ERROR, "unrecognized node type: %d",
@@ -96,6 +123,15 @@ ExecAsyncNotify(AsyncRequest *areq)
 		case T_ForeignScanState:
 			ExecAsyncForeignScanNotify(areq);
 			break;
+		case T_SeqScanState:
+			ExecAsyncSeqScanNotify(areq);
+			break;
+		case T_BitmapHeapScanState:
+			ExecAsyncBitmapHeapScanNotify(areq);
+			break;
+		case T_GatherState:
+			ExecAsyncGatherNotify(areq);
+			break;
 		default:
 			/* If the node doesn't support async, caller messed up. */
 			elog(ERROR, "unrecognized node type: %d",
@@ -0,0 +1,707 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatch.c
+ *	  Support routines for batch (vectorized) execution
+ *
+ * A BatchExpr tree is compiled from a plan expression once, at executor
+ * startup, and then evaluated bottom-up for a whole TupleBatch at a time:
+ * each node runs one tight loop over the rows in the selection vector,
+ * reading its arguments' result arrays and filling its own.  Compared to
+ * ExecInterpExpr(), this pays the per-step dispatch once per batch rather
+ * than once per row, and lets the compiler keep the loops for the common
+ * comparisons and arithmetic operators free of function calls.
+ *
+ * Compilation fails, and the caller falls back to row-at-a-time execution,
+ * for any construct not handled here.  Notably, only pass-by-value types
+ * and immutable functions are accepted: the former means batch columns can
+ * simply be copied out of the scan slot, the latter that evaluating an
+ * expression for all rows of a batch before the next one gives the same
+ * results as the row-at-a-time order.  Qual clauses are still applied one
+ * after another, each only to the rows that passed the previous ones, so a
+ * clause is never evaluated for a row that row-at-a-time execution would
+ * have filtered out first.
+ *
+ * Note that the plan expressions handled here are also compiled into
+ * regular ExprStates by the owning nodes, which takes care of permission
+ * checks and function-execute hooks.
+ *
+ * Portions Copyright (c) 1996-2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/execBatch.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "catalog/pg_proc.h"
+#include "common/int.h"
+#include "executor/execBatch.h"
+#include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
+#include "utils/float.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+
+/* GUC parameter */
+bool		enable_batch_execution = false;
+
+static BatchExpr *make_batch_expr(BatchExprOp op, bool alloc_result);
+static BatchExpr *init_batch_func(Expr *node, Oid funcid, List *args,
+								  Oid inputcollid, Oid resulttype,
+								  Index varno, Bitmapset **attnos);
+static BatchExprOp batch_func_op(Oid funcid);
+static Datum batch_call_function(BatchExpr *expr, int row, bool *isnull);
+static void batch_eval_funcexpr(BatchExpr *expr, const int *sel, int nsel);
+
+
+/*
+ * Create an empty batch with room for natts columns.  Columns are only
+ * allocated by ExecTupleBatchAddColumn().
+ */
+TupleBatch *
+ExecMakeTupleBatch(int natts)
+{
+	TupleBatch *batch = palloc0(sizeof(TupleBatch));
+
+	batch->natts = natts;
+	batch->sel = palloc(sizeof(int) * EXEC_BATCH_SIZE);
+	batch->values = palloc0(sizeof(Datum *) * Max(natts, 1));
+	batch->isnull = palloc0(sizeof(bool *) * Max(natts, 1));
+
+	return batch;
+}
+
+/*
+ * Allocate the arrays for column attno of the batch, if not done yet.
+ */
+void
+ExecTupleBatchAddColumn(TupleBatch *batch, AttrNumber attno)
+{
+	Assert(attno > 0 && attno <= batch->natts);
+
+	if (batch->values[attno - 1] == NULL)
+	{
+		batch->values[attno - 1] = palloc(sizeof(Datum) * EXEC_BATCH_SIZE);
+		batch->isnull[attno - 1] = palloc(sizeof(bool) * EXEC_BATCH_SIZE);
+	}
+}
+
+static BatchExpr *
+make_batch_expr(BatchExprOp op, bool alloc_result)
+{
+	BatchExpr  *expr = palloc0(sizeof(BatchExpr));
+
+	expr->op = op;
+	if (alloc_result)
+	{
+		expr->values = palloc(sizeof(Datum) * EXEC_BATCH_SIZE);
+		expr->isnull = palloc(sizeof(bool) * EXEC_BATCH_SIZE);
+	}
+
+	return expr;
+}
+
+/*
+ * Compile an expression for batch evaluation.
+ *
+ * Vars must belong to range table entry varno, and refer to the batch
+ * column of the same attribute number; the attribute numbers used are
+ * added to *attnos so that the caller knows which columns to fill.
+ *
+ * Returns NULL if the expression can't be evaluated in batch mode.
+ */
+BatchExpr *
+ExecInitBatchExpr(Expr *node, Index varno, Bitmapset **attnos)
+{
+	BatchExpr  *expr;
+
+	/* Guard against stack overflow due to overly complex expressions */
+	check_stack_depth();
+
+	if (node == NULL)
+		return NULL;
+
+	switch (nodeTag(node))
+	{
+		case T_Var:
+			{
+				Var		   *var = (Var *) node;
+
+				if (var->varno != varno || var->varlevelsup != 0 ||
+					var->varattno <= 0 || !get_typbyval(var->vartype))
+					return NULL;
+
+				expr = make_batch_expr(BEEOP_VAR, false);
+				expr->column = var->varattno - 1;
+				*attnos = bms_add_member(*attnos, var->varattno);
+				return expr;
+			}
+
+		case T_Const:
+			{
+				Const	   *con = (Const *) node;
+				int			i;
+
+				if (!con->constisnull && !con->constbyval)
+					return NULL;
+
+				expr = make_batch_expr(BEEOP_CONST, true);
+				for (i = 0; i < EXEC_BATCH_SIZE; i++)
+				{
+					expr->values[i] = con->constvalue;
+					expr->isnull[i] = con->constisnull;
+				}
+				return expr;
+			}
+
+		case T_RelabelType:
+			{
+				RelabelType *relabel = (RelabelType *) node;
+
+				if (!get_typbyval(relabel->resulttype))
+					return NULL;
+				return ExecInitBatchExpr(relabel->arg, varno, attnos);
+			}
+
+		case T_FuncExpr:
+			{
+				FuncExpr   *func = (FuncExpr *) node;
+
+				if (func->funcretset)
+					return NULL;
+				return init_batch_func(node, func->funcid, func->args,
+									   func->inputcollid, func->funcresulttype,
+									   varno, attnos);
+			}
+
+		case T_OpExpr:
+			{
+				OpExpr	   *op = (OpExpr *) node;
+
+				if (op->opretset)
+					return NULL;
+				set_opfuncid(op);
+				return init_batch_func(node, op->opfuncid, op->args,
+									   op->inputcollid, op->opresulttype,
+									   varno, attnos);
+			}
+
+		case T_BoolExpr:
+			{
+				BoolExpr   *boolexpr = (BoolExpr *) node;
+
+				/* AND and OR need conditional evaluation; not supported */
+				if (boolexpr->boolop != NOT_EXPR)
+					return NULL;
+
+				expr = make_batch_expr(BEEOP_NOT, true);
+				expr->nargs = 1;
+				expr->args = palloc(sizeof(BatchExpr *));
+				expr->args[0] = ExecInitBatchExpr(linitial(boolexpr->args),
+												  varno, attnos);
+				if (expr->args[0] == NULL)
+					return NULL;
+				return expr;
+			}
+
+		case T_NullTest:
+			{
+				NullTest   *ntest = (NullTest *) node;
+
+				if (ntest->argisrow)
+					return NULL;
+
+				expr = make_batch_expr(ntest->nulltesttype == IS_NULL ?
+									   BEEOP_NULLTEST_ISNULL :
+									   BEEOP_NULLTEST_ISNOTNULL, true);
+				expr->nargs = 1;
+				expr->args = palloc(sizeof(BatchExpr *));
+				expr->args[0] = ExecInitBatchExpr(ntest->arg, varno, attnos);
+				if (expr->args[0] == NULL)
+					return NULL;
+				return expr;
+			}
+
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * Compile a function or operator call.
+ */
+static BatchExpr *
+init_batch_func(Expr *node, Oid funcid, List *args, Oid inputcollid,
+				Oid resulttype, Index varno, Bitmapset **attnos)
+{
+	BatchExpr  *expr;
+	ListCell   *lc;
+	int			argno;
+
+	if (func_volatile(funcid) != PROVOLATILE_IMMUTABLE ||
+		!get_typbyval(resulttype))
+		return NULL;
+
+	expr = make_batch_expr(BEEOP_FUNCEXPR, true);
+	expr->nargs = list_length(args);
+	expr->args = palloc(sizeof(BatchExpr *) * Max(expr->nargs, 1));
+
+	argno = 0;
+	foreach(lc, args)
+	{
+		expr->args[argno] = ExecInitBatchExpr(lfirst(lc), varno, attnos);
+		if (expr->args[argno] == NULL)
+			return NULL;
+		argno++;
+	}
+
+	expr->finfo = palloc0(sizeof(FmgrInfo));
+	fmgr_info(funcid, expr->finfo);
+	fmgr_info_set_expr((Node *) node, expr->finfo);
+
+	expr->fcinfo = palloc0(SizeForFunctionCallInfo(expr->nargs));
+	InitFunctionCallInfoData(*expr->fcinfo, expr->finfo, expr->nargs,
+							 inputcollid, NULL, NULL);
+
+	/* use a specialized loop, if there is one */
+	expr->op = batch_func_op(funcid);
+
+	return expr;
+}
+
+/*
+ * Map the functions behind the common comparison and arithmetic operators
+ * to their specialized batch operations.
+ */
+static BatchExprOp
+batch_func_op(Oid funcid)
+{
+	switch (funcid)
+	{
+		case F_INT4EQ:
+			return BEEOP_INT4_EQ;
+		case F_INT4NE:
+			return BEEOP_INT4_NE;
+		case F_INT4LT:
+			return BEEOP_INT4_LT;
+		case F_INT4LE:
+			return BEEOP_INT4_LE;
+		case F_INT4GT:
+			return BEEOP_INT4_GT;
+		case F_INT4GE:
+			return BEEOP_INT4_GE;
+		case F_INT8EQ:
+			return BEEOP_INT8_EQ;
+		case F_INT8NE:
+			return BEEOP_INT8_NE;
+		case F_INT8LT:
+			return BEEOP_INT8_LT;
+		case F_INT8LE:
+			return BEEOP_INT8_LE;
+		case F_INT8GT:
+			return BEEOP_INT8_GT;
+		case F_INT8GE:
+			return BEEOP_INT8_GE;
+		case F_FLOAT8EQ:
+			return BEEOP_FLOAT8_EQ;
+		case F_FLOAT8NE:
+			return BEEOP_FLOAT8_NE;
+		case F_FLOAT8LT:
+			return BEEOP_FLOAT8_LT;
+		case F_FLOAT8LE:
+			return BEEOP_FLOAT8_LE;
+		case F_FLOAT8GT:
+			return BEEOP_FLOAT8_GT;
+		case F_FLOAT8GE:
+			return BEEOP_FLOAT8_GE;
+		case F_INT4PL:
+			return BEEOP_INT4_PL;
+		case F_INT4MI:
+			return BEEOP_INT4_MI;
+		case F_INT4MUL:
+			return BEEOP_INT4_MUL;
+		case F_INT8PL:
+			return BEEOP_INT8_PL;
+		case F_INT8MI:
+			return BEEOP_INT8_MI;
+		case F_INT8MUL:
+			return BEEOP_INT8_MUL;
+		case F_FLOAT8PL:
+			return BEEOP_FLOAT8_PL;
+		case F_FLOAT8MI:
+			return BEEOP_FLOAT8_MI;
+		case F_FLOAT8MUL:
+			return BEEOP_FLOAT8_MUL;
+		default:
+			return BEEOP_FUNCEXPR;
+	}
+}
+
+/*
+ * Compile a qual (an implicitly-ANDed list of boolean expressions) for
+ * batch evaluation.  Explicit ANDs are flattened into the list.
+ *
+ * Returns false if some clause can't be evaluated in batch mode.
+ */
+bool
+ExecInitBatchQual(List *qual, Index varno, Bitmapset **attnos, List **result)
+{
+	ListCell   *lc;
+
+	foreach(lc, qual)
+	{
+		Expr	   *clause = (Expr *) lfirst(lc);
+		BatchExpr  *expr;
+
+		if (is_andclause(clause))
+		{
+			if (!ExecInitBatchQual(((BoolExpr *) clause)->args, varno, attnos,
+								   result))
+				return false;
+			continue;
+		}
+
+		expr = ExecInitBatchExpr(clause, varno, attnos);
+		if (expr == NULL)
+			return false;
+		*result = lappend(*result, expr);
+	}
+
+	return true;
+}
+
+/*
+ * Call a BEEOP_FUNCEXPR's function for one row.
+ */
+static Datum
+batch_call_function(BatchExpr *expr, int row, bool *isnull)
+{
+	FunctionCallInfo fcinfo = expr->fcinfo;
+	int			argno;
+	Datum		result;
+
+	for (argno = 0; argno < expr->nargs; argno++)
+	{
+		BatchExpr  *arg = expr->args[argno];
+
+		fcinfo->args[argno].value = arg->values[row];
+		fcinfo->args[argno].isnull = arg->isnull[row];
+	}
+
+	fcinfo->isnull = false;
+	result = FunctionCallInvoke(fcinfo);
+	*isnull = fcinfo->isnull;
+
+	return result;
+}
+
+/*
+ * Generic function call, once per row.
+ */
+static void
+batch_eval_funcexpr(BatchExpr *expr, const int *sel, int nsel)
+{
+	bool		strict = expr->finfo->fn_strict;
+	int			i;
+
+	for (i = 0; i < nsel; i++)
+	{
+		int			row = sel[i];
+
+		if (strict)
+		{
+			int			argno;
+
+			for (argno = 0; argno < expr->nargs; argno++)
+			{
+				if (expr->args[argno]->isnull[row])
+					break;
+			}
+			if (argno < expr->nargs)
+			{
+				expr->isnull[row] = true;
+				continue;
+			}
+		}
+
+		expr->values[row] = batch_call_function(expr, row, &expr->isnull[row]);
+	}
+}
+
+/*
+ * Loop bodies for the specialized operations.  All of them are strict.
+ */
+#define BATCH_COMPARE(getarg, cmp) \
+	for (i = 0; i < nsel; i++) \
+	{ \
+		int			row = sel[i]; \
+ \
+		if ((expr->isnull[row] = (lnull[row] || rnull[row]))) \
+			continue; \
+		expr->values[row] = BoolGetDatum(cmp(getarg(lvals[row]), \
+											 getarg(rvals[row]))); \
+	}
+
+#define BATCH_CMP_EQ(a, b)	((a) == (b))
+#define BATCH_CMP_NE(a, b)	((a) != (b))
+#define BATCH_CMP_LT(a, b)	((a) < (b))
+#define BATCH_CMP_LE(a, b)	((a) <= (b))
+#define BATCH_CMP_GT(a, b)	((a) > (b))
+#define BATCH_CMP_GE(a, b)	((a) >= (b))
+
+/*
+ * Integer arithmetic.  On overflow, we call the real function for the row,
+ * which raises the same error row-at-a-time execution would.
+ */
+#define BATCH_INT_ARITH(type, getarg, makedatum, overflowfn) \
+	for (i = 0; i < nsel; i++) \
+	{ \
+		int			row = sel[i]; \
+		type		result; \
+ \
+		if ((expr->isnull[row] = (lnull[row] || rnull[row]))) \
+			continue; \
+		if (unlikely(overflowfn(getarg(lvals[row]), getarg(rvals[row]), \
+								&result))) \
+			expr->values[row] = batch_call_function(expr, row, \
+													&expr->isnull[row]); \
+		else \
+			expr->values[row] = makedatum(result); \
+	}
+
+/* Float arithmetic; the inline functions from float.h do the error checks */
+#define BATCH_FLOAT_ARITH(fn) \
+	for (i = 0; i < nsel; i++) \
+	{ \
+		int			row = sel[i]; \
+ \
+		if ((expr->isnull[row] = (lnull[row] || rnull[row]))) \
+			continue; \
+		expr->values[row] = Float8GetDatum(fn(DatumGetFloat8(lvals[row]), \
+											  DatumGetFloat8(rvals[row]))); \
+	}
+
+/*
+ * Evaluate a compiled expression for the rows sel[0 .. nsel - 1] of the
+ * batch.
+ *
+ * This is expected to be called in a short-lived memory context, which the
+ * caller resets between batches.
+ */
+void
+ExecEvalBatchExpr(BatchExpr *expr, TupleBatch *batch, const int *sel, int nsel)
+{
+	Datum	   *lvals;
+	bool	   *lnull;
+	Datum	   *rvals;
+	bool	   *rnull;
+	int			argno;
+	int			i;
+
+	switch (expr->op)
+	{
+		case BEEOP_VAR:
+			/* just point at the input column */
+			expr->values = batch->values[expr->column];
+			expr->isnull = batch->isnull[expr->column];
+			Assert(expr->values != NULL);
+			return;
+
+		case BEEOP_CONST:
+			/* filled in at compile time */
+			return;
+
+		default:
+			break;
+	}
+
+	/* Evaluate the arguments first */
+	for (argno = 0; argno < expr->nargs; argno++)
+		ExecEvalBatchExpr(expr->args[argno], batch, sel, nsel);
+
+	if (expr->op == BEEOP_FUNCEXPR)
+	{
+		batch_eval_funcexpr(expr, sel, nsel);
+		return;
+	}
+
+	lvals = expr->args[0]->values;
+	lnull = expr->args[0]->isnull;
+	if (expr->nargs > 1)
+	{
+		rvals = expr->args[1]->values;
+		rnull = expr->args[1]->isnull;
+	}
+	else
+	{
+		rvals = NULL;
+		rnull = NULL;
+	}
+
+	switch (expr->op)
+	{
+		case BEEOP_NOT:
+			for (i = 0; i < nsel; i++)
+			{
+				int			row = sel[i];
+
+				if (!(expr->isnull[row] = lnull[row]))
+					expr->values[row] = BoolGetDatum(!DatumGetBool(lvals[row]));
+			}
+			break;
+
+		case BEEOP_NULLTEST_ISNULL:
+			for (i = 0; i < nsel; i++)
+			{
+				int			row = sel[i];
+
+				expr->values[row] = BoolGetDatum(lnull[row]);
+				expr->isnull[row] = false;
+			}
+			break;
+
+		case BEEOP_NULLTEST_ISNOTNULL:
+			for (i = 0; i < nsel; i++)
+			{
+				int			row = sel[i];
+
+				expr->values[row] = BoolGetDatum(!lnull[row]);
+				expr->isnull[row] = false;
+			}
+			break;
+
+		case BEEOP_INT4_EQ:
+			BATCH_COMPARE(DatumGetInt32, BATCH_CMP_EQ);
+			break;
+		case BEEOP_INT4_NE:
+			BATCH_COMPARE(DatumGetInt32, BATCH_CMP_NE);
+			break;
+		case BEEOP_INT4_LT:
+			BATCH_COMPARE(DatumGetInt32, BATCH_CMP_LT);
+			break;
+		case BEEOP_INT4_LE:
+			BATCH_COMPARE(DatumGetInt32, BATCH_CMP_LE);
+			break;
+		case BEEOP_INT4_GT:
+			BATCH_COMPARE(DatumGetInt32, BATCH_CMP_GT);
+			break;
+		case BEEOP_INT4_GE:
+			BATCH_COMPARE(DatumGetInt32, BATCH_CMP_GE);
+			break;
+		case BEEOP_INT8_EQ:
+			BATCH_COMPARE(DatumGetInt64, BATCH_CMP_EQ);
+			break;
+		case BEEOP_INT8_NE:
+			BATCH_COMPARE(DatumGetInt64, BATCH_CMP_NE);
+			break;
+		case BEEOP_INT8_LT:
+			BATCH_COMPARE(DatumGetInt64, BATCH_CMP_LT);
+			break;
+		case BEEOP_INT8_LE:
+			BATCH_COMPARE(DatumGetInt64, BATCH_CMP_LE);
+			break;
+		case BEEOP_INT8_GT:
+			BATCH_COMPARE(DatumGetInt64, BATCH_CMP_GT);
+			break;
+		case BEEOP_INT8_GE:
+			BATCH_COMPARE(DatumGetInt64, BATCH_CMP_GE);
+			break;
+
+			/* float8 comparisons must follow the NaN rules of float.h */
+		case BEEOP_FLOAT8_EQ:
+			BATCH_COMPARE(DatumGetFloat8, float8_eq);
+			break;
+		case BEEOP_FLOAT8_NE:
+			BATCH_COMPARE(DatumGetFloat8, float8_ne);
+			break;
+		case BEEOP_FLOAT8_LT:
+			BATCH_COMPARE(DatumGetFloat8, float8_lt);
+			break;
+		case BEEOP_FLOAT8_LE:
+			BATCH_COMPARE(DatumGetFloat8, float8_le);
+			break;
+		case BEEOP_FLOAT8_GT:
+			BATCH_COMPARE(DatumGetFloat8, float8_gt);
+			break;
+		case BEEOP_FLOAT8_GE:
+			BATCH_COMPARE(DatumGetFloat8, float8_ge);
+			break;
+
+		case BEEOP_INT4_PL:
+			BATCH_INT_ARITH(int32, DatumGetInt32, Int32GetDatum,
+							pg_add_s32_overflow);
+			break;
+		case BEEOP_INT4_MI:
+			BATCH_INT_ARITH(int32, DatumGetInt32, Int32GetDatum,
+							pg_sub_s32_overflow);
+			break;
+		case BEEOP_INT4_MUL:
+			BATCH_INT_ARITH(int32, DatumGetInt32, Int32GetDatum,
+							pg_mul_s32_overflow);
+			break;
+		case BEEOP_INT8_PL:
+			BATCH_INT_ARITH(int64, DatumGetInt64, Int64GetDatum,
+							pg_add_s64_overflow);
+			break;
+		case BEEOP_INT8_MI:
+			BATCH_INT_ARITH(int64, DatumGetInt64, Int64GetDatum,
+							pg_sub_s64_overflow);
+			break;
+		case BEEOP_INT8_MUL:
+			BATCH_INT_ARITH(int64, DatumGetInt64, Int64GetDatum,
+							pg_mul_s64_overflow);
+			break;
+		case BEEOP_FLOAT8_PL:
+			BATCH_FLOAT_ARITH(float8_pl);
+			break;
+		case BEEOP_FLOAT8_MI:
+			BATCH_FLOAT_ARITH(float8_mi);
+			break;
+		case BEEOP_FLOAT8_MUL:
+			BATCH_FLOAT_ARITH(float8_mul);
+			break;
+
+		default:
+			elog(ERROR, "unrecognized batch expression op: %d",
+				 (int) expr->op);
+	}
+}
+
+/*
+ * Apply a compiled qual to the rows sel[0 .. nsel - 1] of the batch,
+ * removing the rows that fail it from sel.  Returns the number of rows
+ * left.
+ *
+ * Like ExecQual(), a NULL result counts as false.
+ */
+int
+ExecBatchQual(List *qual, TupleBatch *batch, int *sel, int nsel)
+{
+	ListCell   *lc;
+
+	foreach(lc, qual)
+	{
+		BatchExpr  *expr = (BatchExpr *) lfirst(lc);
+		int			nkeep = 0;
+		int			i;
+
+		if (nsel == 0)
+			break;
+
+		ExecEvalBatchExpr(expr, batch, sel, nsel);
+
+		for (i = 0; i < nsel; i++)
+		{
+			int			row = sel[i];
+
+			if (!expr->isnull[row] && DatumGetBool(expr->values[row]))
+				sel[nkeep++] = row;
+		}
+		nsel = nkeep;
+	}
+
+	return nsel;
+}
@@ -24,6 +24,7 @@
 #include "postgres.h"
 
 #include "executor/execParallel.h"
+#include "executor/execRuntimeFilter.h"
 #include "executor/executor.h"
 #include "executor/nodeAgg.h"
 #include "executor/nodeAppend.h"
@@ -54,7 +55,8 @@
 /*
  * Magic numbers for parallel executor communication.  We use constants
  * greater than any 32-bit integer here so that values < 2^32 can be used
- * by individual parallel nodes to store their own state.
+ * by individual parallel nodes to store their own state.  Nodes needing
+ * more than one entry use PARALLEL_NODE_KEY, which stays below these.
  */
 #define PARALLEL_KEY_EXECUTOR_FIXED		UINT64CONST(0xE000000000000001)
 #define PARALLEL_KEY_PLANNEDSTMT		UINT64CONST(0xE000000000000002)
@@ -242,6 +244,10 @@ ExecParallelEstimate(PlanState *planstate, ExecParallelEstimateContext *e)
 			if (planstate->plan->parallel_aware)
 				ExecSeqScanEstimate((SeqScanState *) planstate,
 									e->pcxt);
+			/* even when not parallel-aware, for Bloom filters */
+			ExecBloomFilterEstimate(planstate,
+									((SeqScanState *) planstate)->bloom_filters,
+									e->pcxt);
 			break;
 		case T_IndexScanState:
 			if (planstate->plan->parallel_aware)
@@ -291,7 +297,7 @@ ExecParallelEstimate(PlanState *planstate, ExecParallelEstimateContext *e)
 			ExecIncrementalSortEstimate((IncrementalSortState *) planstate, e->pcxt);
 			break;
 		case T_AggState:
-			/* even when not parallel-aware, for EXPLAIN ANALYZE */
+			/* even when not parallel-aware, for EXPLAIN ANALYZE and spilling */
 			ExecAggEstimate((AggState *) planstate, e->pcxt);
 			break;
 		case T_MemoizeState:
@@ -466,6 +472,10 @@ ExecParallelInitializeDSM(PlanState *planstate,
 			if (planstate->plan->parallel_aware)
 				ExecSeqScanInitializeDSM((SeqScanState *) planstate,
 										 d->pcxt);
+			/* even when not parallel-aware, for Bloom filters */
+			ExecBloomFilterInitializeDSM(planstate,
+										 ((SeqScanState *) planstate)->bloom_filters,
+										 d->pcxt);
 			break;
 		case T_IndexScanState:
 			if (planstate->plan->parallel_aware)
@@ -515,7 +525,7 @@ ExecParallelInitializeDSM(PlanState *planstate,
 			ExecIncrementalSortInitializeDSM((IncrementalSortState *) planstate, d->pcxt);
 			break;
 		case T_AggState:
-			/* even when not parallel-aware, for EXPLAIN ANALYZE */
+			/* even when not parallel-aware, for EXPLAIN ANALYZE and spilling */
 			ExecAggInitializeDSM((AggState *) planstate, d->pcxt);
 			break;
 		case T_MemoizeState:
@@ -960,6 +970,10 @@ ExecParallelReInitializeDSM(PlanState *planstate,
 			if (planstate->plan->parallel_aware)
 				ExecSeqScanReInitializeDSM((SeqScanState *) planstate,
 										   pcxt);
+			/* even when not parallel-aware, for Bloom filters */
+			ExecBloomFilterReInitializeDSM(planstate,
+										   ((SeqScanState *) planstate)->bloom_filters,
+										   pcxt);
 			break;
 		case T_IndexScanState:
 			if (planstate->plan->parallel_aware)
@@ -995,8 +1009,15 @@ ExecParallelReInitializeDSM(PlanState *planstate,
 				ExecHashJoinReInitializeDSM((HashJoinState *) planstate,
 											pcxt);
 			break;
-		case T_HashState:
+		case T_AggState:
+			/* even when not parallel-aware, for shared spilling */
+			ExecAggReInitializeDSM((AggState *) planstate, pcxt);
+			break;
 		case T_SortState:
+			if (planstate->plan->parallel_aware)
+				ExecSortReInitializeDSM((SortState *) planstate, pcxt);
+			break;
+		case T_HashState:
 		case T_IncrementalSortState:
 		case T_MemoizeState:
 			/* these nodes have DSM state, but no reinitialization is required */
@@ -1311,6 +1332,11 @@ ExecParallelInitializeWorker(PlanState *planstate, ParallelWorkerContext *pwcxt)
 		case T_SeqScanState:
 			if (planstate->plan->parallel_aware)
 				ExecSeqScanInitializeWorker((SeqScanState *) planstate, pwcxt);
+			/* even when not parallel-aware, for Bloom filters */
+			((SeqScanState *) planstate)->bloom_filters =
+				ExecBloomFilterInitializeWorker(planstate,
+												((SeqScanState *) planstate)->bloom_filters,
+												pwcxt);
 			break;
 		case T_IndexScanState:
 			if (planstate->plan->parallel_aware)
@@ -1360,7 +1386,7 @@ ExecParallelInitializeWorker(PlanState *planstate, ParallelWorkerContext *pwcxt)
 												pwcxt);
 			break;
 		case T_AggState:
-			/* even when not parallel-aware, for EXPLAIN ANALYZE */
+			/* even when not parallel-aware, for EXPLAIN ANALYZE and spilling */
 			ExecAggInitializeWorker((AggState *) planstate, pwcxt);
 			break;
 		case T_MemoizeState:
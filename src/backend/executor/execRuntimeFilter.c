@@ -0,0 +1,644 @@
+/*-------------------------------------------------------------------------
+ *
+ * execRuntimeFilter.c
+ *	  Bloom filters pushed down from hash joins to scans
+ *
+ * When a hash join discards every outer row that has no join partner,
+ * which is the case for inner, semi, right and right anti joins, rows that
+ * cannot have one may just as well be discarded by the scan producing them.
+ * At executor startup, we follow the outer join keys down through the outer
+ * plan, as long as they are plain Vars passed up unchanged, to the
+ * sequential scans of the relations they come from.  Those scans get a
+ * ScanBloomFilter, which the Hash node fills in with the hash values of the
+ * inner side's join keys while building the hash table.  Since the hash
+ * table is complete before the first outer row is joined, false negatives
+ * are impossible; a scan simply doesn't filter anything until the filter is
+ * ready.
+ *
+ * Filters from a hash join above a Gather or Gather Merge are copied into
+ * the parallel query's DSM segment, so that the workers' scans can use them
+ * too.  The hash join makes sure to build its hash table before starting
+ * the workers in that case.  Parallel Hash joins don't push down filters, as
+ * each participant only sees part of the inner side.
+ *
+ * Portions Copyright (c) 1996-2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/execRuntimeFilter.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "executor/execParallel.h"
+#include "executor/execRuntimeFilter.h"
+#include "miscadmin.h"
+#include "nodes/primnodes.h"
+#include "port/pg_bitutils.h"
+#include "utils/lsyscache.h"
+
+/* GUC parameter */
+bool		enable_bloom_filter_pushdown = true;
+
+/*
+ * Don't use filters with more than this fraction of bits set, their false
+ * positive rate would be too high to be worth checking.  This happens when
+ * the planner grossly underestimated the inner side, or the filter size was
+ * capped by work_mem.
+ */
+#define BLOOM_FILTER_MAX_FILL	0.75
+
+/*
+ * Filters shipped to parallel workers, in the DSM segment.  The header is
+ * followed by nfilters SharedBloomFilter entries.
+ */
+typedef struct SharedBloomFilters
+{
+	int			nfilters;
+} SharedBloomFilters;
+
+/*
+ * A filter shipped to parallel workers.  The header is followed by the
+ * hashfuncoids, collations, attnos and strict arrays, and then the Bloom
+ * filter itself.
+ */
+typedef struct SharedBloomFilter
+{
+	Size		size;			/* size of the entry, including trailing data */
+	Size		filter_size;	/* size of the Bloom filter */
+	int			index;			/* position in the leader's list of filters */
+	int			nkeys;			/* number of join keys */
+	bool		active;			/* should workers use the filter? */
+} SharedBloomFilter;
+
+#define SHARED_BLOOM_FILTERS_HEADER_SIZE MAXALIGN(sizeof(SharedBloomFilters))
+#define SHARED_BLOOM_FILTER_HEADER_SIZE	MAXALIGN(sizeof(SharedBloomFilter))
+#define SHARED_BLOOM_FILTER_ARRAYS_SIZE(nkeys) \
+	MAXALIGN((sizeof(Oid) * 2 + sizeof(AttrNumber) + sizeof(bool)) * (nkeys))
+
+#define SharedBloomFilterHashFuncs(sf) \
+	((Oid *) ((char *) (sf) + SHARED_BLOOM_FILTER_HEADER_SIZE))
+#define SharedBloomFilterCollations(sf) \
+	(SharedBloomFilterHashFuncs(sf) + (sf)->nkeys)
+#define SharedBloomFilterAttnos(sf) \
+	((AttrNumber *) (SharedBloomFilterCollations(sf) + (sf)->nkeys))
+#define SharedBloomFilterStrict(sf) \
+	((bool *) (SharedBloomFilterAttnos(sf) + (sf)->nkeys))
+#define SharedBloomFilterFilter(sf) \
+	((bloom_filter *) ((char *) (sf) + SHARED_BLOOM_FILTER_HEADER_SIZE + \
+					   SHARED_BLOOM_FILTER_ARRAYS_SIZE((sf)->nkeys)))
+
+static bool bloom_filter_push_down(HashBloomFilter *hbf,
+								   PlanState *planstate,
+								   AttrNumber *attnos, bool across_gather);
+static bool bloom_filter_map_attnos(HashBloomFilter *hbf, List *tlist,
+									AttrNumber *attnos, int varno,
+									AttrNumber *result);
+static bool bloom_filter_shipped(ScanBloomFilter *sbf);
+
+
+/* ----------------------------------------------------------------
+ *		ExecInitHashBloomFilter
+ *
+ *		Set up a Bloom filter for the hash join, and push it down to the
+ *		scans below the outer side that can use it.  If there are any, the
+ *		filter is attached to the Hash node, which builds it.
+ * ----------------------------------------------------------------
+ */
+void
+ExecInitHashBloomFilter(HashJoinState *hjstate)
+{
+	HashJoin   *node = (HashJoin *) hjstate->js.ps.plan;
+	HashState  *hashstate = (HashState *) innerPlanState(hjstate);
+	HashBloomFilter *hbf;
+	AttrNumber *attnos;
+	int			nkeys = list_length(node->hashkeys);
+	int			i;
+	ListCell   *lc;
+	ListCell   *lc2;
+
+	if (!enable_bloom_filter_pushdown)
+		return;
+
+	/* We must never need outer rows that have no join partner */
+	if (node->join.jointype != JOIN_INNER &&
+		node->join.jointype != JOIN_SEMI &&
+		node->join.jointype != JOIN_RIGHT &&
+		node->join.jointype != JOIN_RIGHT_ANTI)
+		return;
+
+	/* With Parallel Hash, each participant only sees part of the inner side */
+	if (node->join.plan.parallel_aware)
+		return;
+
+	/* The outer join keys must be plain columns of the outer plan */
+	attnos = (AttrNumber *) palloc(sizeof(AttrNumber) * nkeys);
+	i = 0;
+	foreach(lc, node->hashkeys)
+	{
+		Var		   *var = (Var *) lfirst(lc);
+
+		if (!IsA(var, Var) || var->varno != OUTER_VAR)
+		{
+			pfree(attnos);
+			return;
+		}
+		attnos[i++] = var->varattno;
+	}
+
+	hbf = (HashBloomFilter *) palloc0(sizeof(HashBloomFilter));
+	hbf->total_elems = (int64) Min(Max(innerPlan(node)->plan_rows, 1.0),
+								   (double) PG_INT32_MAX);
+	hbf->nkeys = nkeys;
+	hbf->hashfuncoids = (Oid *) palloc(sizeof(Oid) * nkeys);
+	hbf->hashfunctions = (FmgrInfo *) palloc(sizeof(FmgrInfo) * nkeys);
+	hbf->collations = (Oid *) palloc(sizeof(Oid) * nkeys);
+	hbf->strict = (bool *) palloc(sizeof(bool) * nkeys);
+
+	i = 0;
+	forboth(lc, node->hashoperators, lc2, node->hashcollations)
+	{
+		Oid			hashop = lfirst_oid(lc);
+		Oid			left_hashfn;
+		Oid			right_hashfn;
+
+		if (!get_op_hash_functions(hashop, &left_hashfn, &right_hashfn))
+			elog(ERROR, "could not find hash function for hash operator %u",
+				 hashop);
+		hbf->hashfuncoids[i] = left_hashfn;
+		fmgr_info(left_hashfn, &hbf->hashfunctions[i]);
+		hbf->collations[i] = lfirst_oid(lc2);
+		hbf->strict[i] = op_strict(hashop);
+		i++;
+	}
+
+	if (bloom_filter_push_down(hbf, outerPlanState(hjstate), attnos, false))
+		hashstate->bloom_filter = hbf;
+
+	pfree(attnos);
+}
+
+/*
+ * bloom_filter_push_down
+ *		Attach 'hbf' to the scans below 'planstate' that produce the join
+ *		keys, which are in columns 'attnos' of planstate's output.  Returns
+ *		true if any scan got the filter.
+ */
+static bool
+bloom_filter_push_down(HashBloomFilter *hbf, PlanState *planstate,
+					   AttrNumber *attnos, bool across_gather)
+{
+	Plan	   *plan = planstate->plan;
+	AttrNumber *childattnos;
+	bool		pushed = false;
+
+	check_stack_depth();
+
+	childattnos = (AttrNumber *) palloc(sizeof(AttrNumber) * hbf->nkeys);
+
+	switch (nodeTag(planstate))
+	{
+		case T_SeqScanState:
+			{
+				SeqScanState *sstate = (SeqScanState *) planstate;
+				ScanBloomFilter *sbf;
+
+				if (!bloom_filter_map_attnos(hbf, plan->targetlist, attnos,
+											 ((Scan *) plan)->scanrelid,
+											 childattnos))
+					break;
+
+				sbf = (ScanBloomFilter *) palloc(sizeof(ScanBloomFilter));
+				sbf->hbf = hbf;
+				sbf->attnos = childattnos;
+				sbf->maxattno = 0;
+				for (int i = 0; i < hbf->nkeys; i++)
+					sbf->maxattno = Max(sbf->maxattno, childattnos[i]);
+				sbf->across_gather = across_gather;
+				if (across_gather)
+					hbf->across_gather = true;
+
+				sstate->bloom_filters = lappend(sstate->bloom_filters, sbf);
+				return true;
+			}
+
+		case T_GatherState:
+		case T_GatherMergeState:
+			if (bloom_filter_map_attnos(hbf, plan->targetlist, attnos,
+										OUTER_VAR, childattnos))
+				pushed = bloom_filter_push_down(hbf,
+												outerPlanState(planstate),
+												childattnos, true);
+			break;
+
+		case T_SortState:
+		case T_HashJoinState:
+		case T_MergeJoinState:
+		case T_NestLoopState:
+
+			/*
+			 * Dropping a row from a join's outer side only drops join rows
+			 * carrying its key values, which we would discard anyway.
+			 */
+			if (bloom_filter_map_attnos(hbf, plan->targetlist, attnos,
+										OUTER_VAR, childattnos))
+				pushed = bloom_filter_push_down(hbf,
+												outerPlanState(planstate),
+												childattnos, across_gather);
+			break;
+
+		case T_AppendState:
+			{
+				AppendState *astate = (AppendState *) planstate;
+
+				if (!bloom_filter_map_attnos(hbf, plan->targetlist, attnos,
+											 OUTER_VAR, childattnos))
+					break;
+
+				for (int i = 0; i < astate->as_nplans; i++)
+				{
+					if (bloom_filter_push_down(hbf, astate->appendplans[i],
+											   childattnos, across_gather))
+						pushed = true;
+				}
+				break;
+			}
+
+		case T_MergeAppendState:
+			{
+				MergeAppendState *mstate = (MergeAppendState *) planstate;
+
+				if (!bloom_filter_map_attnos(hbf, plan->targetlist, attnos,
+											 OUTER_VAR, childattnos))
+					break;
+
+				for (int i = 0; i < mstate->ms_nplans; i++)
+				{
+					if (bloom_filter_push_down(hbf, mstate->mergeplans[i],
+											   childattnos, across_gather))
+						pushed = true;
+				}
+				break;
+			}
+
+		default:
+			break;
+	}
+
+	pfree(childattnos);
+	return pushed;
+}
+
+/*
+ * bloom_filter_map_attnos
+ *		Find the columns of a node's input that columns 'attnos' of its
+ *		output 'tlist' are copied from.  'varno' is the rangetable index or
+ *		special varno the Vars in 'tlist' must have.  Returns false if some
+ *		column is not copied from the input unchanged.
+ */
+static bool
+bloom_filter_map_attnos(HashBloomFilter *hbf, List *tlist,
+						AttrNumber *attnos, int varno, AttrNumber *result)
+{
+	for (int i = 0; i < hbf->nkeys; i++)
+	{
+		TargetEntry *tle;
+		Var		   *var;
+
+		if (attnos[i] < 1 || attnos[i] > list_length(tlist))
+			return false;
+
+		tle = list_nth_node(TargetEntry, tlist, attnos[i] - 1);
+		var = (Var *) tle->expr;
+		if (!IsA(var, Var) || var->varno != varno || var->varattno < 1)
+			return false;
+
+		result[i] = var->varattno;
+	}
+
+	return true;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecHashBloomFilterBegin
+ *
+ *		Start building the filter anew.  Called by the Hash node before
+ *		reading its input.
+ * ----------------------------------------------------------------
+ */
+void
+ExecHashBloomFilterBegin(HashBloomFilter *hbf)
+{
+	if (hbf->filter != NULL)
+		bloom_free(hbf->filter);
+
+	/*
+	 * The seed is constant, so that the filter keeps its size when rebuilt;
+	 * copies shipped to parallel workers rely on that.
+	 */
+	hbf->active = false;
+	hbf->filter = bloom_create(hbf->total_elems, work_mem, 0);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecHashBloomFilterEnd
+ *
+ *		Finish building the filter, and decide whether it's worth using.
+ * ----------------------------------------------------------------
+ */
+void
+ExecHashBloomFilterEnd(HashBloomFilter *hbf)
+{
+	hbf->active = bloom_prop_bits_set(hbf->filter) <= BLOOM_FILTER_MAX_FILL;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecScanBloomFilterRejects
+ *
+ *		Check if the scan tuple in 'slot' can be discarded according to the
+ *		scan's 'filters'.  Only the join key columns are deformed.
+ * ----------------------------------------------------------------
+ */
+bool
+ExecScanBloomFilterRejects(ScanState *node, List *filters,
+						   TupleTableSlot *slot)
+{
+	ExprContext *econtext = node->ps.ps_ExprContext;
+	MemoryContext oldcontext;
+	ListCell   *lc;
+	bool		reject = false;
+
+	oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	foreach(lc, filters)
+	{
+		ScanBloomFilter *sbf = (ScanBloomFilter *) lfirst(lc);
+		HashBloomFilter *hbf = sbf->hbf;
+		uint32		hashkey = 0;
+
+		/* the filter isn't built yet, or not worth checking */
+		if (!hbf->active)
+			continue;
+
+		slot_getsomeattrs(slot, sbf->maxattno);
+
+		for (int i = 0; i < hbf->nkeys; i++)
+		{
+			int			attnum = sbf->attnos[i] - 1;
+
+			/* see ExecHashGetHashValue() */
+			hashkey = pg_rotate_left32(hashkey, 1);
+
+			if (slot->tts_isnull[attnum])
+			{
+				if (hbf->strict[i])
+				{
+					reject = true;
+					break;
+				}
+			}
+			else
+				hashkey ^= DatumGetUInt32(FunctionCall1Coll(&hbf->hashfunctions[i],
+															hbf->collations[i],
+															slot->tts_values[attnum]));
+		}
+
+		if (reject ||
+			bloom_lacks_element(hbf->filter, (unsigned char *) &hashkey,
+								sizeof(hashkey)))
+		{
+			reject = true;
+			break;
+		}
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return reject;
+}
+
+/* ----------------------------------------------------------------
+ *						Parallel Query Support
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * bloom_filter_shipped
+ *		Must the filter be copied to the workers?  Filters from a hash join
+ *		below the Gather are set up by the workers themselves.
+ */
+static bool
+bloom_filter_shipped(ScanBloomFilter *sbf)
+{
+	return sbf->across_gather && sbf->hbf->filter != NULL;
+}
+
+/*
+ * shared_bloom_filter_size
+ *		Size of the SharedBloomFilter entry for 'sbf'.
+ */
+static Size
+shared_bloom_filter_size(ScanBloomFilter *sbf)
+{
+	return add_size(SHARED_BLOOM_FILTER_HEADER_SIZE +
+					SHARED_BLOOM_FILTER_ARRAYS_SIZE(sbf->hbf->nkeys),
+					MAXALIGN(bloom_total_size(sbf->hbf->filter)));
+}
+
+/* ----------------------------------------------------------------
+ *		ExecBloomFilterEstimate
+ *
+ *		Estimate the space needed to ship a scan's filters to workers.
+ * ----------------------------------------------------------------
+ */
+void
+ExecBloomFilterEstimate(PlanState *planstate, List *filters,
+						ParallelContext *pcxt)
+{
+	Size		size = SHARED_BLOOM_FILTERS_HEADER_SIZE;
+	bool		any = false;
+	ListCell   *lc;
+
+	foreach(lc, filters)
+	{
+		ScanBloomFilter *sbf = (ScanBloomFilter *) lfirst(lc);
+
+		if (!bloom_filter_shipped(sbf))
+			continue;
+
+		size = add_size(size, shared_bloom_filter_size(sbf));
+		any = true;
+	}
+
+	if (!any)
+		return;
+
+	shm_toc_estimate_chunk(&pcxt->estimator, size);
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecBloomFilterInitializeDSM
+ *
+ *		Copy a scan's filters into the DSM segment.
+ * ----------------------------------------------------------------
+ */
+void
+ExecBloomFilterInitializeDSM(PlanState *planstate, List *filters,
+							 ParallelContext *pcxt)
+{
+	SharedBloomFilters *shared;
+	Size		size = SHARED_BLOOM_FILTERS_HEADER_SIZE;
+	int			nfilters = 0;
+	char	   *ptr;
+	ListCell   *lc;
+
+	foreach(lc, filters)
+	{
+		ScanBloomFilter *sbf = (ScanBloomFilter *) lfirst(lc);
+
+		if (!bloom_filter_shipped(sbf))
+			continue;
+
+		size = add_size(size, shared_bloom_filter_size(sbf));
+		nfilters++;
+	}
+
+	if (nfilters == 0)
+		return;
+
+	shared = shm_toc_allocate(pcxt->toc, size);
+	shared->nfilters = nfilters;
+
+	ptr = (char *) shared + SHARED_BLOOM_FILTERS_HEADER_SIZE;
+	foreach(lc, filters)
+	{
+		ScanBloomFilter *sbf = (ScanBloomFilter *) lfirst(lc);
+		HashBloomFilter *hbf = sbf->hbf;
+		SharedBloomFilter *sf = (SharedBloomFilter *) ptr;
+
+		if (!bloom_filter_shipped(sbf))
+			continue;
+
+		sf->size = shared_bloom_filter_size(sbf);
+		sf->filter_size = bloom_total_size(hbf->filter);
+		sf->index = foreach_current_index(lc);
+		sf->nkeys = hbf->nkeys;
+		sf->active = hbf->active;
+		memcpy(SharedBloomFilterHashFuncs(sf), hbf->hashfuncoids,
+			   sizeof(Oid) * hbf->nkeys);
+		memcpy(SharedBloomFilterCollations(sf), hbf->collations,
+			   sizeof(Oid) * hbf->nkeys);
+		memcpy(SharedBloomFilterAttnos(sf), sbf->attnos,
+			   sizeof(AttrNumber) * hbf->nkeys);
+		memcpy(SharedBloomFilterStrict(sf), hbf->strict,
+			   sizeof(bool) * hbf->nkeys);
+		memcpy(SharedBloomFilterFilter(sf), hbf->filter, sf->filter_size);
+
+		ptr += sf->size;
+	}
+
+	shm_toc_insert(pcxt->toc,
+				   PARALLEL_NODE_KEY(planstate->plan->plan_node_id,
+									 PARALLEL_NODE_KEY_BLOOM_FILTERS),
+				   shared);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecBloomFilterReInitializeDSM
+ *
+ *		Refresh the copies of a scan's filters, which may have been rebuilt
+ *		since the workers last ran.
+ * ----------------------------------------------------------------
+ */
+void
+ExecBloomFilterReInitializeDSM(PlanState *planstate, List *filters,
+							   ParallelContext *pcxt)
+{
+	SharedBloomFilters *shared;
+	char	   *ptr;
+
+	shared = shm_toc_lookup(pcxt->toc,
+							PARALLEL_NODE_KEY(planstate->plan->plan_node_id,
+											  PARALLEL_NODE_KEY_BLOOM_FILTERS),
+							true);
+	if (shared == NULL)
+		return;
+
+	ptr = (char *) shared + SHARED_BLOOM_FILTERS_HEADER_SIZE;
+	for (int i = 0; i < shared->nfilters; i++)
+	{
+		SharedBloomFilter *sf = (SharedBloomFilter *) ptr;
+		ScanBloomFilter *sbf = list_nth(filters, sf->index);
+		HashBloomFilter *hbf = sbf->hbf;
+
+		/* a filter rebuilt with the same parameters has the same size */
+		if (bloom_total_size(hbf->filter) == sf->filter_size)
+		{
+			sf->active = hbf->active;
+			memcpy(SharedBloomFilterFilter(sf), hbf->filter, sf->filter_size);
+		}
+		else
+			sf->active = false;
+
+		ptr += sf->size;
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecBloomFilterInitializeWorker
+ *
+ *		Add the filters shipped by the leader to a scan's 'filters', and
+ *		return the new list.
+ * ----------------------------------------------------------------
+ */
+List *
+ExecBloomFilterInitializeWorker(PlanState *planstate, List *filters,
+								ParallelWorkerContext *pwcxt)
+{
+	SharedBloomFilters *shared;
+	char	   *ptr;
+
+	shared = shm_toc_lookup(pwcxt->toc,
+							PARALLEL_NODE_KEY(planstate->plan->plan_node_id,
+											  PARALLEL_NODE_KEY_BLOOM_FILTERS),
+							true);
+	if (shared == NULL)
+		return filters;
+
+	ptr = (char *) shared + SHARED_BLOOM_FILTERS_HEADER_SIZE;
+	for (int i = 0; i < shared->nfilters; i++)
+	{
+		SharedBloomFilter *sf = (SharedBloomFilter *) ptr;
+		HashBloomFilter *hbf;
+		ScanBloomFilter *sbf;
+		int			nkeys = sf->nkeys;
+
+		hbf = (HashBloomFilter *) palloc0(sizeof(HashBloomFilter));
+		hbf->filter = SharedBloomFilterFilter(sf);
+		hbf->active = sf->active;
+		hbf->nkeys = nkeys;
+		hbf->hashfuncoids = SharedBloomFilterHashFuncs(sf);
+		hbf->collations = SharedBloomFilterCollations(sf);
+		hbf->strict = SharedBloomFilterStrict(sf);
+		hbf->hashfunctions = (FmgrInfo *) palloc(sizeof(FmgrInfo) * nkeys);
+		for (int k = 0; k < nkeys; k++)
+			fmgr_info(hbf->hashfuncoids[k], &hbf->hashfunctions[k]);
+
+		sbf = (ScanBloomFilter *) palloc(sizeof(ScanBloomFilter));
+		sbf->hbf = hbf;
+		sbf->attnos = SharedBloomFilterAttnos(sf);
+		sbf->maxattno = 0;
+		for (int k = 0; k < nkeys; k++)
+			sbf->maxattno = Max(sbf->maxattno, sbf->attnos[k]);
+		sbf->across_gather = false;
+
+		filters = lappend(filters, sbf);
+
+		ptr += sf->size;
+	}
+
+	return filters;
+}
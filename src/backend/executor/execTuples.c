@@ -69,6 +69,50 @@
 #include "utils/lsyscache.h"
 #include "utils/typcache.h"
 
+/*
+ * Precomputed information for deforming heap tuples of a given descriptor.
+ *
+ * The leading attributes of a descriptor that are all fixed-width are at
+ * fixed offsets whenever none of them is null.  For those, steps[] holds the
+ * offset, length and by-value flag, so that they can be fetched without
+ * looking at the null bitmap, alignment or attcacheoff of each attribute.
+ */
+typedef struct TupleDeformStep
+{
+	uint32		off;			/* offset of the attribute in the tuple data */
+	int16		attlen;			/* attribute length, always > 0 */
+	bool		attbyval;		/* passed by value? */
+} TupleDeformStep;
+
+typedef struct TupleDeformProgram
+{
+	int			nfixed;			/* number of leading fixed-width attributes */
+	TupleDeformStep steps[FLEXIBLE_ARRAY_MEMBER];
+} TupleDeformProgram;
+
+/*
+ * Null flags for each value of four bits of a null bitmap; a bit that is
+ * not set means the attribute is null.
+ */
+static const bool null_bitmap_nibble[16][4] = {
+	{true, true, true, true},
+	{false, true, true, true},
+	{true, false, true, true},
+	{false, false, true, true},
+	{true, true, false, true},
+	{false, true, false, true},
+	{true, false, false, true},
+	{false, false, false, true},
+	{true, true, true, false},
+	{false, true, true, false},
+	{true, false, true, false},
+	{false, false, true, false},
+	{true, true, false, false},
+	{false, true, false, false},
+	{true, false, false, false},
+	{false, false, false, false}
+};
+
 static TupleDesc ExecTypeFromTLInternal(List *targetList,
 										bool skipjunk);
 static pg_attribute_always_inline void slot_deform_heap_tuple(TupleTableSlot *slot, HeapTuple tuple, uint32 *offp,
@@ -908,6 +952,100 @@ tts_buffer_heap_store_tuple(TupleTableSlot *slot, HeapTuple tuple,
 	}
 }
 
+/*
+ * slot_build_deform_program
+ *		Compute the TupleDeformProgram for a tuple descriptor.
+ */
+static TupleDeformProgram *
+slot_build_deform_program(TupleDesc tupleDesc, MemoryContext mcxt)
+{
+	TupleDeformProgram *prog;
+	int			nfixed = 0;
+	uint32		off = 0;
+	int			attnum;
+
+	while (nfixed < tupleDesc->natts &&
+		   TupleDescAttr(tupleDesc, nfixed)->attlen > 0)
+		nfixed++;
+
+	prog = MemoryContextAlloc(mcxt,
+							  offsetof(TupleDeformProgram, steps) +
+							  nfixed * sizeof(TupleDeformStep));
+	prog->nfixed = nfixed;
+
+	for (attnum = 0; attnum < nfixed; attnum++)
+	{
+		Form_pg_attribute thisatt = TupleDescAttr(tupleDesc, attnum);
+		TupleDeformStep *step = &prog->steps[attnum];
+
+		off = att_align_nominal(off, thisatt->attalign);
+		step->off = off;
+		step->attlen = thisatt->attlen;
+		step->attbyval = thisatt->attbyval;
+		off += thisatt->attlen;
+	}
+
+	return prog;
+}
+
+/*
+ * slot_prefix_not_null
+ *		Are the first natts attributes of a tuple with a null bitmap all
+ *		non-null?
+ */
+static inline bool
+slot_prefix_not_null(bits8 *bp, int natts)
+{
+	int			nbytes = natts >> 3;
+	int			i;
+
+	for (i = 0; i < nbytes; i++)
+	{
+		if (bp[i] != 0xFF)
+			return false;
+	}
+	if ((natts & 0x07) != 0)
+	{
+		bits8		mask = (1 << (natts & 0x07)) - 1;
+
+		if ((bp[nbytes] & mask) != mask)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * slot_expand_null_bitmap
+ *		Set isnull[] for attributes start .. natts - 1 from a null bitmap.
+ *
+ * Whole bytes of the bitmap are expanded with a table lookup per four
+ * attributes, instead of testing each attribute's bit separately.
+ */
+static inline void
+slot_expand_null_bitmap(bits8 *bp, bool *isnull, int start, int natts)
+{
+	int			attnum = start;
+
+	while (attnum < natts && (attnum & 0x07) != 0)
+	{
+		isnull[attnum] = att_isnull(attnum, bp);
+		attnum++;
+	}
+	while (attnum + 8 <= natts)
+	{
+		bits8		b = bp[attnum >> 3];
+
+		memcpy(&isnull[attnum], null_bitmap_nibble[b & 0x0F], 4);
+		memcpy(&isnull[attnum + 4], null_bitmap_nibble[b >> 4], 4);
+		attnum += 8;
+	}
+	while (attnum < natts)
+	{
+		isnull[attnum] = att_isnull(attnum, bp);
+		attnum++;
+	}
+}
+
 /*
  * slot_deform_heap_tuple
  *		Given a TupleTableSlot, extract data from the slot's physical tuple
@@ -919,6 +1057,11 @@ tts_buffer_heap_store_tuple(TupleTableSlot *slot, HeapTuple tuple,
  *		re-computing information about previously extracted attributes.
  *		slot->tts_nvalid is the number of attributes already extracted.
  *
+ *		When starting from the first attribute, the leading fixed-width
+ *		attributes are fetched using the slot's TupleDeformProgram if none of
+ *		them is null.  The null bitmap for the remaining attributes is
+ *		expanded into isnull[] up front.
+ *
  * This is marked as always inline, so the different offp for different types
  * of slots gets optimized away.
  */
@@ -960,11 +1103,41 @@ slot_deform_heap_tuple(TupleTableSlot *slot, HeapTuple tuple, uint32 *offp,
 
 	tp = (char *) tup + tup->t_hoff;
 
+	if (attnum == 0)
+	{
+		TupleDeformProgram *prog = slot->tts_deform;
+		int			nprefix;
+
+		if (unlikely(prog == NULL))
+		{
+			prog = slot_build_deform_program(tupleDesc, slot->tts_mcxt);
+			slot->tts_deform = prog;
+		}
+
+		nprefix = Min(natts, prog->nfixed);
+		if (nprefix > 0 && (!hasnulls || slot_prefix_not_null(bp, nprefix)))
+		{
+			TupleDeformStep *step = prog->steps;
+
+			for (; attnum < nprefix; attnum++)
+			{
+				step = &prog->steps[attnum];
+				values[attnum] = fetch_att(tp + step->off, step->attbyval,
+										   step->attlen);
+				isnull[attnum] = false;
+			}
+			off = step->off + step->attlen;
+		}
+	}
+
+	if (hasnulls)
+		slot_expand_null_bitmap(bp, isnull, attnum, natts);
+
 	for (; attnum < natts; attnum++)
 	{
 		Form_pg_attribute thisatt = TupleDescAttr(tupleDesc, attnum);
 
-		if (hasnulls && att_isnull(attnum, bp))
+		if (hasnulls && isnull[attnum])
 		{
 			values[attnum] = (Datum) 0;
 			isnull[attnum] = true;
@@ -1206,6 +1379,11 @@ ExecResetTupleTable(List *tupleTable,	/* tuple table */
 			ReleaseTupleDesc(slot->tts_tupleDescriptor);
 			slot->tts_tupleDescriptor = NULL;
 		}
+		if (slot->tts_deform)
+		{
+			pfree(slot->tts_deform);
+			slot->tts_deform = NULL;
+		}
 
 		/* If shouldFree, release memory occupied by the slot itself */
 		if (shouldFree)
@@ -1260,6 +1438,8 @@ ExecDropSingleTupleTableSlot(TupleTableSlot *slot)
 	slot->tts_ops->release(slot);
 	if (slot->tts_tupleDescriptor)
 		ReleaseTupleDesc(slot->tts_tupleDescriptor);
+	if (slot->tts_deform)
+		pfree(slot->tts_deform);
 	if (!TTS_FIXED(slot))
 	{
 		if (slot->tts_values)
@@ -1306,6 +1486,11 @@ ExecSetSlotDescriptor(TupleTableSlot *slot, /* slot to change */
 		pfree(slot->tts_values);
 	if (slot->tts_isnull)
 		pfree(slot->tts_isnull);
+	if (slot->tts_deform)
+	{
+		pfree(slot->tts_deform);
+		slot->tts_deform = NULL;
+	}
 
 	/*
 	 * Install the new descriptor; if it's refcounted, bump its refcount.
@@ -226,6 +226,25 @@
  *	  imposing a limit on the number of groups separately from the amount of
  *	  memory consumed.
  *
+ *	  Shared Spilling In Parallel Query
+ *
+ *	  A partial hash aggregate running in a parallel query spills its input
+ *	  tuples into partitions shared by all participants instead (see
+ *	  ParallelHashAggState), using a SharedTuplestore per partition.  All
+ *	  participants use the same partitioning, chosen by the leader, and the
+ *	  leader's hash IV, so that a group's tuples end up in the same partition
+ *	  with the same hash value no matter which participant spilled them.
+ *	  (Otherwise, each participant's hash table uses its own IV; see
+ *	  BuildTupleHashTableExt().)  When a participant has read all its input,
+ *	  it waits for the others to do the same, then emits its in-memory
+ *	  groups.  After that, participants claim the shared partitions one at a
+ *	  time and aggregate them, so that spilled work is spread over all
+ *	  processes regardless of which ones spilled.  A group may thus be
+ *	  emitted by more than one participant, which is fine because the
+ *	  Finalize Aggregate combines the partial states anyway.  Partitions that
+ *	  overflow again while being re-aggregated are spilled to the
+ *	  participant's own tapes as usual.
+ *
  *    Transition / Combine function invocation:
  *
  *    For performance reasons transition functions, including combine
@@ -255,9 +274,13 @@
 #include "catalog/pg_proc.h"
 #include "catalog/pg_type.h"
 #include "common/hashfn.h"
+#include "common/int.h"
+#include "executor/execBatch.h"
 #include "executor/execExpr.h"
+#include "executor/execParallel.h"
 #include "executor/executor.h"
 #include "executor/nodeAgg.h"
+#include "executor/nodeSeqscan.h"
 #include "lib/hyperloglog.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
@@ -265,16 +288,22 @@
 #include "optimizer/optimizer.h"
 #include "parser/parse_agg.h"
 #include "parser/parse_coerce.h"
+#include "port/atomics.h"
+#include "storage/barrier.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
 #include "utils/dynahash.h"
 #include "utils/expandeddatum.h"
+#include "utils/float.h"
+#include "utils/fmgroids.h"
 #include "utils/logtape.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/sharedtuplestore.h"
 #include "utils/syscache.h"
 #include "utils/tuplesort.h"
+#include "utils/wait_event.h"
 
 /*
  * Control how many partitions are created when spilling HashAgg to
@@ -306,6 +335,12 @@
 #define HASHAGG_READ_BUFFER_SIZE BLCKSZ
 #define HASHAGG_WRITE_BUFFER_SIZE BLCKSZ
 
+/*
+ * sharedtuplestore.c buffers writes in chunks of four blocks, which bounds
+ * how many shared partitions we can afford to have open.
+ */
+#define HASHAGG_SHARED_WRITE_BUFFER_SIZE (4 * BLCKSZ)
+
 /*
  * HyperLogLog is used for estimating the cardinality of the spilled tuples in
  * a given partition. 5 bits corresponds to a size of about 32 bytes and a
@@ -333,6 +368,7 @@ typedef struct HashAggSpill
 {
 	int			npartitions;	/* number of partitions */
 	LogicalTape **partitions;	/* spill partition tapes */
+	SharedTuplestoreAccessor **shared_partitions;	/* or shared partitions */
 	int64	   *ntuples;		/* number of tuples in each partition */
 	uint32		mask;			/* mask to find partition from hash value */
 	int			shift;			/* after masking, shift by this amount */
@@ -353,10 +389,65 @@ typedef struct HashAggBatch
 	int			setno;			/* grouping set */
 	int			used_bits;		/* number of bits of hash already used */
 	LogicalTape *input_tape;	/* input partition tape */
+	SharedTuplestoreAccessor *shared_input; /* or shared input partition */
 	int64		input_tuples;	/* number of tuples in this batch */
 	double		input_card;		/* estimated group cardinality */
 } HashAggBatch;
 
+/*
+ * Shared state for spilling a partial hash aggregate in a parallel query,
+ * stored in the DSM segment.
+ *
+ * The barrier has two phases: PHA_PHASE_SPILL while participants read their
+ * input, spilling into the shared partitions, and PHA_PHASE_REAGGREGATE once
+ * all of them are done, when the partitions can be claimed.  A participant
+ * that attaches only in the second phase spills into its own tapes.
+ *
+ * The struct is followed by the number of tuples in each partition, and
+ * then by a SharedTuplestore for each partition.
+ */
+typedef struct ParallelHashAggState
+{
+	Barrier		barrier;		/* synchronizes spilling and reading */
+	pg_atomic_uint32 next_partition;	/* next partition to claim */
+	int			nparticipants;	/* leader plus workers */
+	int			npartitions;	/* number of shared partitions */
+	int			partition_bits; /* log2(npartitions) */
+	uint32		hash_iv;		/* hash IV used by all participants */
+	SharedFileSet fileset;		/* space for the partitions' files */
+} ParallelHashAggState;
+
+#define PHA_PHASE_SPILL			0
+#define PHA_PHASE_REAGGREGATE	1
+
+#define ParallelHashAggNTuples(pstate) \
+	((pg_atomic_uint64 *) ((char *) (pstate) + \
+						   BUFFERALIGN(sizeof(ParallelHashAggState))))
+#define ParallelHashAggPartition(pstate, i) \
+	((SharedTuplestore *) ((char *) (pstate) + \
+						   BUFFERALIGN(sizeof(ParallelHashAggState)) + \
+						   MAXALIGN(sizeof(pg_atomic_uint64) * (pstate)->npartitions) + \
+						   MAXALIGN(sts_estimate((pstate)->nparticipants)) * (i)))
+
+/*
+ * Batch mode state for one transition state: its inputs and FILTER clause,
+ * compiled for evaluation over the outer plan's batches.
+ */
+typedef struct AggBatchTrans
+{
+	BatchExpr **args;			/* one per transition input */
+	List	   *filter;			/* batch-compiled FILTER clause, or NIL */
+} AggBatchTrans;
+
+/*
+ * Batch mode state, see agg_init_batch().
+ */
+typedef struct AggBatchState
+{
+	AggBatchTrans *trans;		/* one per pertrans entry */
+	int		   *filtersel;		/* selection vector for FILTER clauses */
+} AggBatchState;
+
 /* used to find referenced colnos */
 typedef struct FindColsContext
 {
@@ -417,6 +508,14 @@ static void initialize_hash_entry(AggState *aggstate,
 								  TupleHashEntry entry);
 static void lookup_hash_entries(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
+static void agg_init_batch(AggState *aggstate);
+static TupleTableSlot *agg_retrieve_batch(AggState *aggstate);
+static void advance_aggregates_batch(AggState *aggstate, TupleBatch *batch);
+static void advance_transition_batch(AggState *aggstate,
+									 AggStatePerTrans pertrans,
+									 AggBatchTrans *btrans,
+									 AggStatePerGroup pergroup,
+									 const int *sel, int nsel);
 static void agg_fill_hash_table(AggState *aggstate);
 static bool agg_refill_hash_table(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
@@ -438,6 +537,17 @@ static Size hashagg_spill_tuple(AggState *aggstate, HashAggSpill *spill,
 								TupleTableSlot *inputslot, uint32 hash);
 static void hashagg_spill_finish(AggState *aggstate, HashAggSpill *spill,
 								 int setno);
+static bool hashagg_use_shared_spill(AggState *aggstate);
+static int	hashagg_shared_num_partitions(AggState *aggstate,
+										  int *partition_bits);
+static Size hashagg_shared_size(int nparticipants, int npartitions);
+static void hashagg_shared_init_partitions(AggState *aggstate,
+										   bool initialize);
+static void hashagg_shared_begin(AggState *aggstate);
+static void hashagg_shared_spill_init(AggState *aggstate,
+									  HashAggSpill *spill);
+static void hashagg_shared_end_spill(AggState *aggstate);
+static bool hashagg_shared_claim_batch(AggState *aggstate);
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
 static void build_pertrans_for_aggref(AggStatePerTrans pertrans,
 									  AggState *aggstate, EState *estate,
@@ -1901,9 +2011,12 @@ hash_agg_enter_spill_mode(AggState *aggstate)
 			AggStatePerHash perhash = &aggstate->perhash[setno];
 			HashAggSpill *spill = &aggstate->hash_spills[setno];
 
-			hashagg_spill_init(spill, aggstate->hash_tapeset, 0,
-							   perhash->aggnode->numGroups,
-							   aggstate->hashentrysize);
+			if (aggstate->hash_shared_writing)
+				hashagg_shared_spill_init(aggstate, spill);
+			else
+				hashagg_spill_init(spill, aggstate->hash_tapeset, 0,
+								   perhash->aggnode->numGroups,
+								   aggstate->hashentrysize);
 		}
 	}
 }
@@ -2176,6 +2289,12 @@ ExecAgg(PlanState *pstate)
 				result = agg_retrieve_hash_table(node);
 				break;
 			case AGG_PLAIN:
+				if (node->batch != NULL)
+				{
+					result = agg_retrieve_batch(node);
+					break;
+				}
+				/* FALLTHROUGH */
 			case AGG_SORTED:
 				result = agg_retrieve_direct(node);
 				break;
@@ -2534,6 +2653,354 @@ agg_retrieve_direct(AggState *aggstate)
 	return NULL;
 }
 
+/*
+ * Set up batch mode, if this node can use it.
+ *
+ * Batch mode is only used for plain aggregation directly on top of a
+ * sequential scan, with aggregates whose transition state is passed by value
+ * and whose inputs and FILTER clauses, as well as the scan's qual and
+ * targetlist, can be evaluated by execBatch.c.  Otherwise aggstate->batch is
+ * left NULL and the node runs row-at-a-time as usual.
+ */
+static void
+agg_init_batch(AggState *aggstate)
+{
+	Agg		   *node = (Agg *) aggstate->ss.ps.plan;
+	PlanState  *outerstate = outerPlanState(aggstate);
+	AggBatchState *batch;
+	Bitmapset  *attnos = NULL;
+	int			transno;
+
+	if (node->aggstrategy != AGG_PLAIN || node->groupingSets != NIL ||
+		DO_AGGSPLIT_COMBINE(aggstate->aggsplit) ||
+		!IsA(outerstate, SeqScanState))
+		return;
+
+	batch = palloc0(sizeof(AggBatchState));
+	batch->trans = palloc0(sizeof(AggBatchTrans) * Max(aggstate->numtrans, 1));
+	batch->filtersel = palloc(sizeof(int) * EXEC_BATCH_SIZE);
+
+	for (transno = 0; transno < aggstate->numtrans; transno++)
+	{
+		AggStatePerTrans pertrans = &aggstate->pertrans[transno];
+		AggBatchTrans *btrans = &batch->trans[transno];
+		Aggref	   *aggref = pertrans->aggref;
+		ListCell   *lc;
+		int			argno;
+
+		if (aggref->aggkind != AGGKIND_NORMAL ||
+			aggref->aggdistinct != NIL || aggref->aggorder != NIL ||
+			pertrans->numSortCols > 0 || !pertrans->transtypeByVal)
+			return;
+
+		if (aggref->aggfilter != NULL &&
+			!ExecInitBatchQual(list_make1(aggref->aggfilter), OUTER_VAR,
+							   &attnos, &btrans->filter))
+			return;
+
+		btrans->args = palloc(sizeof(BatchExpr *) *
+							  Max(pertrans->numTransInputs, 1));
+		argno = 0;
+		foreach(lc, aggref->args)
+		{
+			TargetEntry *tle = lfirst_node(TargetEntry, lc);
+
+			if (argno >= pertrans->numTransInputs)
+				break;
+			btrans->args[argno] = ExecInitBatchExpr(tle->expr, OUTER_VAR,
+													&attnos);
+			if (btrans->args[argno] == NULL)
+				return;
+			argno++;
+		}
+	}
+
+	if (!ExecSeqScanInitBatch((SeqScanState *) outerstate, attnos))
+		return;
+
+	aggstate->batch = batch;
+}
+
+/*
+ * ExecAgg for plain aggregation in batch mode
+ *
+ * This is agg_retrieve_direct() boiled down to the single group, single
+ * grouping set case, consuming the input a batch at a time.
+ */
+static TupleTableSlot *
+agg_retrieve_batch(AggState *aggstate)
+{
+	ExprContext *econtext = aggstate->ss.ps.ps_ExprContext;
+	AggStatePerGroup *pergroups = aggstate->pergroups;
+	TupleTableSlot *firstSlot = aggstate->ss.ss_ScanTupleSlot;
+	SeqScanState *outerstate = (SeqScanState *) outerPlanState(aggstate);
+	TupleBatch *batch;
+
+	ReScanExprContext(econtext);
+	ReScanExprContext(aggstate->aggcontexts[0]);
+
+	initialize_aggregates(aggstate, pergroups, 1);
+
+	while ((batch = ExecSeqScanBatch(outerstate)) != NULL)
+	{
+		advance_aggregates_batch(aggstate, batch);
+
+		/* Reset per-input-tuple context after each batch */
+		ResetExprContext(aggstate->tmpcontext);
+	}
+
+	aggstate->agg_done = true;
+
+	/*
+	 * Without grouping there can't be any references to non-aggregated input
+	 * columns, so there's no need for a representative input tuple; leave
+	 * the slot empty, as agg_retrieve_direct() does for empty input.
+	 */
+	ExecClearTuple(firstSlot);
+	econtext->ecxt_outertuple = firstSlot;
+	aggstate->projected_set = 0;
+
+	prepare_projection_slot(aggstate, firstSlot, 0);
+
+	select_current_set(aggstate, 0, false);
+
+	finalize_aggregates(aggstate, aggstate->peragg, pergroups[0]);
+
+	return project_aggregates(aggstate);
+}
+
+/*
+ * Advance each aggregate transition state for the live rows of a batch.
+ */
+static void
+advance_aggregates_batch(AggState *aggstate, TupleBatch *batch)
+{
+	AggBatchState *bstate = aggstate->batch;
+	AggStatePerGroup pergroup = aggstate->pergroups[0];
+	MemoryContext oldContext;
+	int			transno;
+
+	oldContext = MemoryContextSwitchTo(aggstate->tmpcontext->ecxt_per_tuple_memory);
+
+	for (transno = 0; transno < aggstate->numtrans; transno++)
+	{
+		AggStatePerTrans pertrans = &aggstate->pertrans[transno];
+		AggBatchTrans *btrans = &bstate->trans[transno];
+		int		   *sel = batch->sel;
+		int			nsel = batch->nsel;
+		int			argno;
+
+		if (btrans->filter != NIL)
+		{
+			memcpy(bstate->filtersel, sel, sizeof(int) * nsel);
+			sel = bstate->filtersel;
+			nsel = ExecBatchQual(btrans->filter, batch, sel, nsel);
+			if (nsel == 0)
+				continue;
+		}
+
+		for (argno = 0; argno < pertrans->numTransInputs; argno++)
+			ExecEvalBatchExpr(btrans->args[argno], batch, sel, nsel);
+
+		advance_transition_batch(aggstate, pertrans, btrans,
+								 &pergroup[transno], sel, nsel);
+	}
+
+	MemoryContextSwitchTo(oldContext);
+}
+
+/*
+ * Loop for a strict transition function without initial value: the first
+ * non-null input becomes the state, later ones are combined into it, and a
+ * NULL state stays NULL.  This is what the EEOP_AGG_STRICT_INPUT_CHECK and
+ * EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYVAL steps do row by row.
+ */
+#define BATCH_TRANS_STRICT(statetype, getstate, makestate, getinput, combine) \
+	do { \
+		statetype	state = 0; \
+		bool		havestate; \
+ \
+		if (!pergroup->noTransValue && pergroup->transValueIsNull) \
+			break; \
+		havestate = !pergroup->noTransValue; \
+		if (havestate) \
+			state = getstate(pergroup->transValue); \
+		for (i = 0; i < nsel; i++) \
+		{ \
+			int			row = sel[i]; \
+			statetype	value; \
+ \
+			if (arg->isnull[row]) \
+				continue; \
+			value = getinput(arg->values[row]); \
+			if (!havestate) \
+			{ \
+				state = value; \
+				havestate = true; \
+			} \
+			else \
+				state = combine(state, value); \
+		} \
+		if (havestate) \
+		{ \
+			pergroup->transValue = makestate(state); \
+			pergroup->transValueIsNull = false; \
+			pergroup->noTransValue = false; \
+		} \
+	} while (0)
+
+#define BATCH_TRANS_ADD(a, b)		((a) + (b))
+#define BATCH_TRANS_LARGER(a, b)	((a) > (b) ? (a) : (b))
+#define BATCH_TRANS_SMALLER(a, b)	((a) < (b) ? (a) : (b))
+#define BATCH_TRANS_FLOAT8_LARGER(a, b)		(float8_gt(a, b) ? (a) : (b))
+#define BATCH_TRANS_FLOAT8_SMALLER(a, b)	(float8_lt(a, b) ? (a) : (b))
+
+/*
+ * Advance one transition state for the rows sel[0 .. nsel - 1], whose
+ * inputs have been evaluated already.
+ *
+ * The transition functions of count, sum, min and max over the common
+ * numeric types are open-coded; any other (pass-by-value) transition
+ * function is called once per row, the same way ExecAggPlainTransByVal()
+ * does.
+ */
+static void
+advance_transition_batch(AggState *aggstate, AggStatePerTrans pertrans,
+						 AggBatchTrans *btrans, AggStatePerGroup pergroup,
+						 const int *sel, int nsel)
+{
+	BatchExpr  *arg = pertrans->numTransInputs > 0 ? btrans->args[0] : NULL;
+	FunctionCallInfo fcinfo;
+	int64		count;
+	int			i;
+
+	switch (pertrans->transfn_oid)
+	{
+		case F_INT8INC:
+			/* count(*) */
+			count = nsel;
+			goto add_count;
+
+		case F_INT8INC_ANY:
+			/* count(expr) */
+			count = 0;
+			for (i = 0; i < nsel; i++)
+			{
+				if (!arg->isnull[sel[i]])
+					count++;
+			}
+			goto add_count;
+
+		case F_INT4_SUM:
+			/* not strict, but handles NULLs the same way */
+			BATCH_TRANS_STRICT(int64, DatumGetInt64, Int64GetDatum,
+							   DatumGetInt32, BATCH_TRANS_ADD);
+			return;
+		case F_INT2_SUM:
+			BATCH_TRANS_STRICT(int64, DatumGetInt64, Int64GetDatum,
+							   DatumGetInt16, BATCH_TRANS_ADD);
+			return;
+		case F_FLOAT8PL:
+			BATCH_TRANS_STRICT(float8, DatumGetFloat8, Float8GetDatum,
+							   DatumGetFloat8, float8_pl);
+			return;
+		case F_INT4LARGER:
+			BATCH_TRANS_STRICT(int32, DatumGetInt32, Int32GetDatum,
+							   DatumGetInt32, BATCH_TRANS_LARGER);
+			return;
+		case F_INT4SMALLER:
+			BATCH_TRANS_STRICT(int32, DatumGetInt32, Int32GetDatum,
+							   DatumGetInt32, BATCH_TRANS_SMALLER);
+			return;
+		case F_INT8LARGER:
+			BATCH_TRANS_STRICT(int64, DatumGetInt64, Int64GetDatum,
+							   DatumGetInt64, BATCH_TRANS_LARGER);
+			return;
+		case F_INT8SMALLER:
+			BATCH_TRANS_STRICT(int64, DatumGetInt64, Int64GetDatum,
+							   DatumGetInt64, BATCH_TRANS_SMALLER);
+			return;
+		case F_FLOAT8LARGER:
+			BATCH_TRANS_STRICT(float8, DatumGetFloat8, Float8GetDatum,
+							   DatumGetFloat8, BATCH_TRANS_FLOAT8_LARGER);
+			return;
+		case F_FLOAT8SMALLER:
+			BATCH_TRANS_STRICT(float8, DatumGetFloat8, Float8GetDatum,
+							   DatumGetFloat8, BATCH_TRANS_FLOAT8_SMALLER);
+			return;
+
+		default:
+			break;
+	}
+
+	/* Generic case: call the transition function for each row */
+	fcinfo = pertrans->transfn_fcinfo;
+
+	/* cf. select_current_set() */
+	aggstate->curaggcontext = aggstate->aggcontexts[0];
+	aggstate->current_set = 0;
+
+	/* set up aggstate->curpertrans for AggGetAggref() */
+	aggstate->curpertrans = pertrans;
+
+	for (i = 0; i < nsel; i++)
+	{
+		int			row = sel[i];
+		bool		anynull = false;
+		int			argno;
+		Datum		newVal;
+
+		for (argno = 0; argno < pertrans->numTransInputs; argno++)
+		{
+			BatchExpr  *input = btrans->args[argno];
+
+			fcinfo->args[argno + 1].value = input->values[row];
+			fcinfo->args[argno + 1].isnull = input->isnull[row];
+			anynull |= input->isnull[row];
+		}
+
+		if (pertrans->transfn.fn_strict)
+		{
+			if (anynull)
+				continue;
+			if (pergroup->noTransValue)
+			{
+				/* cf. ExecAggInitGroup(); the input is pass-by-value */
+				pergroup->transValue = fcinfo->args[1].value;
+				pergroup->transValueIsNull = false;
+				pergroup->noTransValue = false;
+				continue;
+			}
+			if (pergroup->transValueIsNull)
+				continue;
+		}
+
+		fcinfo->args[0].value = pergroup->transValue;
+		fcinfo->args[0].isnull = pergroup->transValueIsNull;
+		fcinfo->isnull = false; /* just in case transfn doesn't set it */
+
+		newVal = FunctionCallInvoke(fcinfo);
+
+		pergroup->transValue = newVal;
+		pergroup->transValueIsNull = fcinfo->isnull;
+	}
+	return;
+
+add_count:
+	/* count's transition functions are strict, with initial value 0 */
+	if (!pergroup->transValueIsNull)
+	{
+		int64		result;
+
+		if (unlikely(pg_add_s64_overflow(DatumGetInt64(pergroup->transValue),
+										 count, &result)))
+			ereport(ERROR,
+					(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+					 errmsg("bigint out of range")));
+		pergroup->transValue = Int64GetDatum(result);
+	}
+}
+
 /*
  * ExecAgg for hashed case: read input and build hash table
  */
@@ -2543,6 +3010,10 @@ agg_fill_hash_table(AggState *aggstate)
 	TupleTableSlot *outerslot;
 	ExprContext *tmpcontext = aggstate->tmpcontext;
 
+	/* join the other participants, if spilling to shared partitions */
+	if (aggstate->hash_shared != NULL)
+		hashagg_shared_begin(aggstate);
+
 	/*
 	 * Process each outer-plan tuple, and then fetch the next one, until we
 	 * exhaust the outer plan.
@@ -2597,12 +3068,16 @@ agg_refill_hash_table(AggState *aggstate)
 	HashAggBatch *batch;
 	AggStatePerHash perhash;
 	HashAggSpill spill;
-	LogicalTapeSet *tapeset = aggstate->hash_tapeset;
+	LogicalTapeSet *tapeset;
 	bool		spill_initialized = false;
 
-	if (aggstate->hash_batches == NIL)
+	/* when out of local batches, try to take over a shared partition */
+	if (aggstate->hash_batches == NIL &&
+		!hashagg_shared_claim_batch(aggstate))
 		return false;
 
+	tapeset = aggstate->hash_tapeset;
+
 	/* hash_batches is a stack, with the top item at the end of the list */
 	batch = llast(aggstate->hash_batches);
 	aggstate->hash_batches = list_delete_last(aggstate->hash_batches);
@@ -2669,7 +3144,8 @@ agg_refill_hash_table(AggState *aggstate)
 		if (tuple == NULL)
 			break;
 
-		ExecStoreMinimalTuple(tuple, spillslot, true);
+		/* tuples read from a shared partition live in the reader's buffer */
+		ExecStoreMinimalTuple(tuple, spillslot, batch->shared_input == NULL);
 		aggstate->tmpcontext->ecxt_outertuple = spillslot;
 
 		prepare_hash_slot(perhash,
@@ -2710,7 +3186,10 @@ agg_refill_hash_table(AggState *aggstate)
 		ResetExprContext(aggstate->tmpcontext);
 	}
 
-	LogicalTapeClose(batch->input_tape);
+	if (batch->shared_input != NULL)
+		sts_end_parallel_scan(batch->shared_input);
+	else
+		LogicalTapeClose(batch->input_tape);
 
 	/* change back to phase 0 */
 	aggstate->current_phase = 0;
@@ -2961,6 +3440,17 @@ hashagg_spill_tuple(AggState *aggstate, HashAggSpill *spill,
 	partition = (hash & spill->mask) >> spill->shift;
 	spill->ntuples[partition]++;
 
+	if (spill->shared_partitions != NULL)
+	{
+		sts_puttuple(spill->shared_partitions[partition], &hash, tuple);
+		total_written = sizeof(uint32) + tuple->t_len;
+
+		if (shouldFree)
+			pfree(tuple);
+
+		return total_written;
+	}
+
 	/*
 	 * All hash values destined for a given partition have some bits in
 	 * common, which causes bad HLL cardinality estimates. Hash the hash to
@@ -3006,6 +3496,8 @@ hashagg_batch_new(LogicalTape *input_tape, int setno,
 /*
  * hashagg_batch_read
  * 		read the next tuple from a batch's tape.  Return NULL if no more.
+ *
+ * For a shared batch, the tuple is only valid until the next call.
  */
 static MinimalTuple
 hashagg_batch_read(HashAggBatch *batch, uint32 *hashp)
@@ -3016,6 +3508,10 @@ hashagg_batch_read(HashAggBatch *batch, uint32 *hashp)
 	size_t		nread;
 	uint32		hash;
 
+	/* the hash value is stored as the tuple's meta-data in shared batches */
+	if (batch->shared_input != NULL)
+		return sts_parallel_scan_next(batch->shared_input, hashp);
+
 	nread = LogicalTapeRead(tape, &hash, sizeof(uint32));
 	if (nread == 0)
 		return NULL;
@@ -3081,6 +3577,10 @@ hashagg_finish_initial_spills(AggState *aggstate)
 		aggstate->hash_spills = NULL;
 	}
 
+	/* wait for the other participants to finish spilling */
+	if (aggstate->hash_shared_writing)
+		hashagg_shared_end_spill(aggstate);
+
 	hash_agg_update_metrics(aggstate, false, total_npartitions);
 	aggstate->hash_spill_mode = false;
 }
@@ -3099,6 +3599,23 @@ hashagg_spill_finish(AggState *aggstate, HashAggSpill *spill, int setno)
 	if (spill->npartitions == 0)
 		return;					/* didn't spill */
 
+	if (spill->shared_partitions != NULL)
+	{
+		pg_atomic_uint64 *ntuples = ParallelHashAggNTuples(aggstate->hash_shared);
+
+		/*
+		 * Shared partitions become batches only once every participant is
+		 * done writing them; see hashagg_shared_claim_batch().
+		 */
+		for (i = 0; i < spill->npartitions; i++)
+		{
+			if (spill->ntuples[i] > 0)
+				pg_atomic_fetch_add_u64(&ntuples[i], spill->ntuples[i]);
+		}
+		pfree(spill->ntuples);
+		return;
+	}
+
 	for (i = 0; i < spill->npartitions; i++)
 	{
 		LogicalTape *tape = spill->partitions[i];
@@ -3133,6 +3650,8 @@ hashagg_spill_finish(AggState *aggstate, HashAggSpill *spill, int setno)
 static void
 hashagg_reset_spill_state(AggState *aggstate)
 {
+	ListCell   *lc;
+
 	/* free spills from initial pass */
 	if (aggstate->hash_spills != NULL)
 	{
@@ -3143,13 +3662,21 @@ hashagg_reset_spill_state(AggState *aggstate)
 			HashAggSpill *spill = &aggstate->hash_spills[setno];
 
 			pfree(spill->ntuples);
-			pfree(spill->partitions);
+			if (spill->partitions != NULL)
+				pfree(spill->partitions);
 		}
 		pfree(aggstate->hash_spills);
 		aggstate->hash_spills = NULL;
 	}
 
-	/* free batches */
+	/* free batches, closing any shared partition being read */
+	foreach(lc, aggstate->hash_batches)
+	{
+		HashAggBatch *batch = (HashAggBatch *) lfirst(lc);
+
+		if (batch->shared_input != NULL)
+			sts_end_parallel_scan(batch->shared_input);
+	}
 	list_free_deep(aggstate->hash_batches);
 	aggstate->hash_batches = NIL;
 
@@ -3161,6 +3688,230 @@ hashagg_reset_spill_state(AggState *aggstate)
 	}
 }
 
+/*
+ * Should this node spill into partitions shared by all participants of a
+ * parallel query?
+ *
+ * Only partial aggregation qualifies, since groups may be emitted by several
+ * participants, and only with a single hash table, to keep the partitioning
+ * simple.
+ */
+static bool
+hashagg_use_shared_spill(AggState *aggstate)
+{
+	return aggstate->aggstrategy == AGG_HASHED &&
+		aggstate->num_hashes == 1 &&
+		DO_AGGSPLIT_SKIPFINAL(aggstate->aggsplit);
+}
+
+/*
+ * Choose the number of shared spill partitions.  Each participant may have
+ * all of them open for writing, so limit their buffers to 1/4 of hash_mem
+ * like hash_choose_num_partitions() does for tapes.
+ */
+static int
+hashagg_shared_num_partitions(AggState *aggstate, int *partition_bits)
+{
+	Size		hash_mem_limit = get_hash_memory_limit();
+	int			npartitions;
+	int			bits;
+
+	npartitions = hash_choose_num_partitions(aggstate->perhash[0].aggnode->numGroups,
+											 aggstate->hashentrysize, 0,
+											 &bits);
+	while (npartitions > HASHAGG_MIN_PARTITIONS &&
+		   (double) npartitions * HASHAGG_SHARED_WRITE_BUFFER_SIZE >
+		   hash_mem_limit * 0.25)
+	{
+		npartitions >>= 1;
+		bits--;
+	}
+
+	*partition_bits = bits;
+	return npartitions;
+}
+
+/*
+ * Size of the ParallelHashAggState, including the trailing arrays.
+ */
+static Size
+hashagg_shared_size(int nparticipants, int npartitions)
+{
+	Size		size;
+
+	size = BUFFERALIGN(sizeof(ParallelHashAggState));
+	size = add_size(size, MAXALIGN(mul_size(sizeof(pg_atomic_uint64),
+											npartitions)));
+	size = add_size(size, mul_size(MAXALIGN(sts_estimate(nparticipants)),
+								   npartitions));
+	return size;
+}
+
+/*
+ * Set up this participant's accessors for the shared partitions.  The
+ * leader initializes the SharedTuplestores, workers attach to them.
+ */
+static void
+hashagg_shared_init_partitions(AggState *aggstate, bool initialize)
+{
+	ParallelHashAggState *pstate = aggstate->hash_shared;
+	MemoryContext oldcxt;
+
+	oldcxt = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+
+	aggstate->hash_shared_partitions =
+		palloc(sizeof(SharedTuplestoreAccessor *) * pstate->npartitions);
+
+	for (int i = 0; i < pstate->npartitions; i++)
+	{
+		SharedTuplestore *sts = ParallelHashAggPartition(pstate, i);
+
+		if (initialize)
+		{
+			char		name[MAXPGPATH];
+
+			snprintf(name, sizeof(name), "hashagg%d", i);
+			pg_atomic_init_u64(&ParallelHashAggNTuples(pstate)[i], 0);
+			aggstate->hash_shared_partitions[i] =
+				sts_initialize(sts, pstate->nparticipants, 0,
+							   sizeof(uint32),
+							   SHARED_TUPLESTORE_SINGLE_PASS,
+							   &pstate->fileset, name);
+		}
+		else
+			aggstate->hash_shared_partitions[i] =
+				sts_attach(sts, ParallelWorkerNumber + 1, &pstate->fileset);
+	}
+
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * Called before reading the input.  If the other participants haven't
+ * finished reading theirs yet, join them in spilling to the shared
+ * partitions; otherwise we're too late for that and spill to our own tapes.
+ * Either way, we help re-aggregating the shared partitions afterwards.
+ *
+ * The tuples in the shared partitions carry the hash values computed by
+ * whichever participant spilled them, so everybody must hash with the same
+ * IV.  The hash table is still empty here, so it's safe to switch.
+ */
+static void
+hashagg_shared_begin(AggState *aggstate)
+{
+	ParallelHashAggState *pstate = aggstate->hash_shared;
+
+	aggstate->perhash[0].hashtable->hash_iv = pstate->hash_iv;
+
+	if (BarrierAttach(&pstate->barrier) == PHA_PHASE_SPILL)
+		aggstate->hash_shared_writing = true;
+	else
+		BarrierDetach(&pstate->barrier);
+
+	aggstate->hash_shared_reading = true;
+}
+
+/*
+ * Set up the first-level spill of this participant to write into the shared
+ * partitions.
+ */
+static void
+hashagg_shared_spill_init(AggState *aggstate, HashAggSpill *spill)
+{
+	ParallelHashAggState *pstate = aggstate->hash_shared;
+
+	spill->partitions = NULL;
+	spill->shared_partitions = aggstate->hash_shared_partitions;
+	spill->ntuples = palloc0(sizeof(int64) * pstate->npartitions);
+	spill->hll_card = NULL;
+	spill->shift = 32 - pstate->partition_bits;
+	spill->mask = (pstate->npartitions - 1) << spill->shift;
+	spill->npartitions = pstate->npartitions;
+}
+
+/*
+ * Called when we have read all our input.  Finish writing to the shared
+ * partitions and wait until everyone else has, too, so that the partitions
+ * are complete before anyone starts reading them.
+ *
+ * We get here before emitting any groups, so nobody can be blocked waiting
+ * for us to consume its output while we wait.
+ */
+static void
+hashagg_shared_end_spill(AggState *aggstate)
+{
+	ParallelHashAggState *pstate = aggstate->hash_shared;
+
+	for (int i = 0; i < pstate->npartitions; i++)
+		sts_end_write(aggstate->hash_shared_partitions[i]);
+
+	BarrierArriveAndWait(&pstate->barrier, WAIT_EVENT_HASH_AGG_SPILL);
+	Assert(BarrierPhase(&pstate->barrier) == PHA_PHASE_REAGGREGATE);
+	BarrierDetach(&pstate->barrier);
+
+	aggstate->hash_shared_writing = false;
+}
+
+/*
+ * Claim the next non-empty shared partition and push it as a batch.  Return
+ * false if none are left.
+ */
+static bool
+hashagg_shared_claim_batch(AggState *aggstate)
+{
+	ParallelHashAggState *pstate = aggstate->hash_shared;
+
+	if (!aggstate->hash_shared_reading)
+		return false;
+
+	for (;;)
+	{
+		uint32		partition;
+		uint64		ntuples;
+		double		cardinality;
+		HashAggBatch *batch;
+
+		partition = pg_atomic_fetch_add_u32(&pstate->next_partition, 1);
+		if (partition >= pstate->npartitions)
+			break;
+
+		ntuples = pg_atomic_read_u64(&ParallelHashAggNTuples(pstate)[partition]);
+		if (ntuples == 0)
+			continue;
+
+		/*
+		 * There's no cardinality estimate for the shared partitions, so
+		 * assume they hold an equal share of the planned groups, but no
+		 * more groups than tuples.
+		 */
+		cardinality = Min((double) ntuples,
+						  Max(aggstate->perhash[0].aggnode->numGroups /
+							  pstate->npartitions, 1));
+
+		/*
+		 * Re-aggregating the partition may spill again, and that must go to
+		 * our own tapes, not to the first-level spill structures.
+		 */
+		aggstate->hash_ever_spilled = true;
+		if (aggstate->hash_tapeset == NULL)
+			aggstate->hash_tapeset = LogicalTapeSetCreate(true, NULL, -1);
+
+		sts_begin_parallel_scan(aggstate->hash_shared_partitions[partition]);
+
+		batch = hashagg_batch_new(NULL, 0, ntuples, cardinality,
+								  pstate->partition_bits);
+		batch->shared_input = aggstate->hash_shared_partitions[partition];
+		aggstate->hash_batches = lappend(aggstate->hash_batches, batch);
+		aggstate->hash_batches_used++;
+		aggstate->hash_shared_batches++;
+
+		return true;
+	}
+
+	aggstate->hash_shared_reading = false;
+	return false;
+}
+
 
 /* -----------------
  * ExecInitAgg
@@ -4022,6 +4773,12 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		phase->evaltrans_cache[0][0] = phase->evaltrans;
 	}
 
+	/*
+	 * Switch to batch mode, if enabled and possible.
+	 */
+	if (enable_batch_execution)
+		agg_init_batch(aggstate);
+
 	return aggstate;
 }
 
@@ -4323,6 +5080,7 @@ ExecEndAgg(AggState *node)
 		si->hash_batches_used = node->hash_batches_used;
 		si->hash_disk_used = node->hash_disk_used;
 		si->hash_mem_peak = node->hash_mem_peak;
+		si->hash_shared_batches = node->hash_shared_batches;
 	}
 
 	/* Make sure we have closed any open tuplesorts */
@@ -4402,6 +5160,7 @@ ExecReScanAgg(AggState *node)
 		 * again.
 		 */
 		if (outerPlan->chgParam == NULL && !node->hash_ever_spilled &&
+			node->hash_shared == NULL &&
 			!bms_overlap(node->ss.ps.chgParam, aggnode->aggParams))
 		{
 			ResetTupleHashIterator(node->perhash[0].hashtable,
@@ -4464,6 +5223,16 @@ ExecReScanAgg(AggState *node)
 		node->hash_spill_mode = false;
 		node->hash_ngroups_current = 0;
 
+		/*
+		 * The leader gets to use the shared partitions again after
+		 * ExecAggReInitializeDSM(), but a worker can't coordinate a rescan
+		 * with the other participants, so it goes on alone.
+		 */
+		node->hash_shared_writing = false;
+		node->hash_shared_reading = false;
+		if (IsParallelWorker())
+			node->hash_shared = NULL;
+
 		ReScanExprContext(node->hashcontext);
 		/* Rebuild an empty hash table */
 		build_hash_tables(node);
@@ -4695,8 +5464,24 @@ ExecAggEstimate(AggState *node, ParallelContext *pcxt)
 {
 	Size		size;
 
-	/* don't need this if not instrumenting or no workers */
-	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
+	/* don't need any of this if no workers */
+	if (pcxt->nworkers == 0)
+		return;
+
+	if (hashagg_use_shared_spill(node))
+	{
+		int			npartitions;
+		int			partition_bits;
+
+		npartitions = hashagg_shared_num_partitions(node, &partition_bits);
+		shm_toc_estimate_chunk(&pcxt->estimator,
+							   hashagg_shared_size(pcxt->nworkers + 1,
+												   npartitions));
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+
+	/* don't need this if not instrumenting */
+	if (!node->ss.ps.instrument)
 		return;
 
 	size = mul_size(pcxt->nworkers, sizeof(AggregateInstrumentation));
@@ -4708,7 +5493,8 @@ ExecAggEstimate(AggState *node, ParallelContext *pcxt)
 /* ----------------------------------------------------------------
  *		ExecAggInitializeDSM
  *
- *		Initialize DSM space for aggregate statistics.
+ *		Initialize DSM space for aggregate statistics and shared spill
+ *		partitions.
  * ----------------------------------------------------------------
  */
 void
@@ -4716,8 +5502,42 @@ ExecAggInitializeDSM(AggState *node, ParallelContext *pcxt)
 {
 	Size		size;
 
-	/* don't need this if not instrumenting or no workers */
-	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
+	/* don't need any of this if no workers */
+	if (pcxt->nworkers == 0)
+		return;
+
+	/*
+	 * Shared spilling needs a real DSM segment to hold the SharedFileSet's
+	 * reference count.
+	 */
+	if (hashagg_use_shared_spill(node) && pcxt->seg != NULL)
+	{
+		ParallelHashAggState *pstate;
+		int			npartitions;
+		int			partition_bits;
+
+		npartitions = hashagg_shared_num_partitions(node, &partition_bits);
+		pstate = shm_toc_allocate(pcxt->toc,
+								  hashagg_shared_size(pcxt->nworkers + 1,
+													  npartitions));
+		BarrierInit(&pstate->barrier, 0);
+		pg_atomic_init_u32(&pstate->next_partition, 0);
+		pstate->nparticipants = pcxt->nworkers + 1;
+		pstate->npartitions = npartitions;
+		pstate->partition_bits = partition_bits;
+		pstate->hash_iv = node->perhash[0].hashtable->hash_iv;
+		SharedFileSetInit(&pstate->fileset, pcxt->seg);
+		shm_toc_insert(pcxt->toc,
+					   PARALLEL_NODE_KEY(node->ss.ps.plan->plan_node_id,
+										 PARALLEL_NODE_KEY_HASHAGG_SPILL),
+					   pstate);
+
+		node->hash_shared = pstate;
+		hashagg_shared_init_partitions(node, true);
+	}
+
+	/* don't need this if not instrumenting */
+	if (!node->ss.ps.instrument)
 		return;
 
 	size = offsetof(SharedAggInfo, sinstrument)
@@ -4733,14 +5553,50 @@ ExecAggInitializeDSM(AggState *node, ParallelContext *pcxt)
 /* ----------------------------------------------------------------
  *		ExecAggInitializeWorker
  *
- *		Attach worker to DSM space for aggregate statistics.
+ *		Attach worker to DSM space for aggregate statistics and shared
+ *		spill partitions.
  * ----------------------------------------------------------------
  */
 void
 ExecAggInitializeWorker(AggState *node, ParallelWorkerContext *pwcxt)
 {
+	ParallelHashAggState *pstate;
+
 	node->shared_info =
 		shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, true);
+
+	pstate = shm_toc_lookup(pwcxt->toc,
+							PARALLEL_NODE_KEY(node->ss.ps.plan->plan_node_id,
+											  PARALLEL_NODE_KEY_HASHAGG_SPILL),
+							true);
+	if (pstate != NULL)
+	{
+		SharedFileSetAttach(&pstate->fileset, pwcxt->seg);
+		node->hash_shared = pstate;
+		hashagg_shared_init_partitions(node, false);
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAggReInitializeDSM
+ *
+ *		Reset the shared spill partitions before workers are relaunched.
+ * ----------------------------------------------------------------
+ */
+void
+ExecAggReInitializeDSM(AggState *node, ParallelContext *pcxt)
+{
+	ParallelHashAggState *pstate = node->hash_shared;
+
+	if (pstate == NULL)
+		return;
+
+	/* Clear any partition files left over from the last scan */
+	SharedFileSetDeleteAll(&pstate->fileset);
+
+	BarrierInit(&pstate->barrier, 0);
+	pg_atomic_write_u32(&pstate->next_partition, 0);
+	hashagg_shared_init_partitions(node, true);
 }
 
 /* ----------------------------------------------------------------
@@ -253,6 +253,7 @@ ExecInitAppend(Append *node, EState *estate, int eflags)
 			areq->requestee = appendplanstates[i];
 			areq->request_index = i;
 			areq->callback_pending = false;
+			areq->wait_latch = false;
 			areq->request_complete = false;
 			areq->result = NULL;
 
@@ -452,6 +453,7 @@ ExecReScanAppend(AppendState *node)
 			AsyncRequest *areq = node->as_asyncrequests[i];
 
 			areq->callback_pending = false;
+			areq->wait_latch = false;
 			areq->request_complete = false;
 			areq->result = NULL;
 		}
@@ -1011,15 +1013,22 @@ ExecAppendAsyncRequest(AppendState *node, TupleTableSlot **result)
  *		ExecAppendAsyncEventWait
  *
  *		Wait or poll for file descriptor events and fire callbacks.
+ *
+ *		Subplans without a file descriptor to wait on either ask to be
+ *		notified when our latch is set, or register nothing at all; the
+ *		latter are notified right after we have polled for the others.
  * ----------------------------------------------------------------
  */
 static void
 ExecAppendAsyncEventWait(AppendState *node)
 {
-	int			nevents = node->as_nasyncplans + 1;
+	int			nevents = node->as_nasyncplans + 2;
 	long		timeout = node->as_syncdone ? -1 : 0;
 	WaitEvent	occurred_event[EVENT_BUFFER_SIZE];
 	int			noccurred;
+	Bitmapset  *pollplans = NULL;
+	bool		wait_latch = false;
+	bool		latch_set = false;
 	int			i;
 
 	/* We should never be called when there are no valid async subplans. */
@@ -1034,36 +1043,52 @@ ExecAppendAsyncEventWait(AppendState *node)
 	while ((i = bms_next_member(node->as_asyncplans, i)) >= 0)
 	{
 		AsyncRequest *areq = node->as_asyncrequests[i];
+		int			nregistered;
 
-		if (areq->callback_pending)
-			ExecAsyncConfigureWait(areq);
+		if (!areq->callback_pending)
+			continue;
+
+		nregistered = GetNumRegisteredWaitEvents(node->as_eventset);
+		areq->wait_latch = false;
+		ExecAsyncConfigureWait(areq);
+
+		if (areq->wait_latch)
+			wait_latch = true;
+		else if (GetNumRegisteredWaitEvents(node->as_eventset) == nregistered)
+			pollplans = bms_add_member(pollplans, i);
 	}
 
+	/* All latch waiters share a single event. */
+	if (wait_latch)
+		AddWaitEventToSet(node->as_eventset, WL_LATCH_SET, PGINVALID_SOCKET,
+						  MyLatch, NULL);
+
+	/* Don't sleep if there are subplans to notify after polling. */
+	if (pollplans != NULL)
+		timeout = 0;
+
 	/*
-	 * No need for further processing if there are no configured events other
-	 * than the postmaster death event.
+	 * No need to wait if there are no configured events other than the
+	 * postmaster death event.
 	 */
 	if (GetNumRegisteredWaitEvents(node->as_eventset) == 1)
+		noccurred = 0;
+	else
 	{
-		FreeWaitEventSet(node->as_eventset);
-		node->as_eventset = NULL;
-		return;
-	}
+		/* We wait on at most EVENT_BUFFER_SIZE events. */
+		if (nevents > EVENT_BUFFER_SIZE)
+			nevents = EVENT_BUFFER_SIZE;
 
-	/* We wait on at most EVENT_BUFFER_SIZE events. */
-	if (nevents > EVENT_BUFFER_SIZE)
-		nevents = EVENT_BUFFER_SIZE;
-
-	/*
-	 * If the timeout is -1, wait until at least one event occurs.  If the
-	 * timeout is 0, poll for events, but do not wait at all.
-	 */
-	noccurred = WaitEventSetWait(node->as_eventset, timeout, occurred_event,
-								 nevents, WAIT_EVENT_APPEND_READY);
+		/*
+		 * If the timeout is -1, wait until at least one event occurs.  If
+		 * the timeout is 0, poll for events, but do not wait at all.
+		 */
+		noccurred = WaitEventSetWait(node->as_eventset, timeout,
+									 occurred_event, nevents,
+									 WAIT_EVENT_APPEND_READY);
+	}
 	FreeWaitEventSet(node->as_eventset);
 	node->as_eventset = NULL;
-	if (noccurred == 0)
-		return;
 
 	/* Deliver notifications. */
 	for (i = 0; i < noccurred; i++)
@@ -1091,7 +1116,43 @@ ExecAppendAsyncEventWait(AppendState *node)
 				ExecAsyncNotify(areq);
 			}
 		}
+		else if ((w->events & WL_LATCH_SET) != 0)
+		{
+			ResetLatch(MyLatch);
+			latch_set = true;
+		}
+	}
+
+	/* Notify the subplans that were waiting for the latch, if it was set. */
+	if (latch_set)
+	{
+		i = -1;
+		while ((i = bms_next_member(node->as_asyncplans, i)) >= 0)
+		{
+			AsyncRequest *areq = node->as_asyncrequests[i];
+
+			if (areq->callback_pending && areq->wait_latch)
+			{
+				areq->callback_pending = false;
+				areq->wait_latch = false;
+				ExecAsyncNotify(areq);
+			}
+		}
+	}
+
+	/* And the ones that only wanted us to poll the others first. */
+	i = -1;
+	while ((i = bms_next_member(pollplans, i)) >= 0)
+	{
+		AsyncRequest *areq = node->as_asyncrequests[i];
+
+		if (areq->callback_pending)
+		{
+			areq->callback_pending = false;
+			ExecAsyncNotify(areq);
+		}
 	}
+	bms_free(pollplans);
 }
 
 /* ----------------------------------------------------------------
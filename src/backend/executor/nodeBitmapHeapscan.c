@@ -32,6 +32,9 @@
  *		ExecInitBitmapHeapScan		creates and initializes state info.
  *		ExecReScanBitmapHeapScan	prepares to rescan the plan.
  *		ExecEndBitmapHeapScan		releases all storage.
+ *		ExecAsyncBitmapHeapScanRequest	asynchronously requests a tuple.
+ *		ExecAsyncBitmapHeapScanConfigureWait	configures the wait for it.
+ *		ExecAsyncBitmapHeapScanNotify	delivers it.
  */
 #include "postgres.h"
 
@@ -41,6 +44,7 @@
 #include "access/tableam.h"
 #include "access/transam.h"
 #include "access/visibilitymap.h"
+#include "executor/execAsync.h"
 #include "executor/execdebug.h"
 #include "executor/nodeBitmapHeapscan.h"
 #include "miscadmin.h"
@@ -193,9 +197,15 @@ BitmapHeapNext(BitmapHeapScanState *node)
 		/*
 		 * Get next page of results if needed
 		 */
-		if (tbmres == NULL)
+		if (tbmres == NULL || node->tbmres_unread)
 		{
-			if (!pstate)
+			/*
+			 * ExecAsyncBitmapHeapScanRequest() may already have taken the
+			 * next page from the iterator.
+			 */
+			if (node->tbmres_unread)
+				node->tbmres_unread = false;
+			else if (!pstate)
 				node->tbmres = tbmres = tbm_iterate(tbmiterator);
 			else
 				node->tbmres = tbmres = tbm_shared_iterate(shared_tbmiterator);
@@ -624,6 +634,7 @@ ExecReScanBitmapHeapScan(BitmapHeapScanState *node)
 	node->tbm = NULL;
 	node->tbmiterator = NULL;
 	node->tbmres = NULL;
+	node->tbmres_unread = false;
 	node->prefetch_iterator = NULL;
 	node->initialized = false;
 	node->shared_tbmiterator = NULL;
@@ -728,6 +739,7 @@ ExecInitBitmapHeapScan(BitmapHeapScan *node, EState *estate, int eflags)
 	scanstate->tbm = NULL;
 	scanstate->tbmiterator = NULL;
 	scanstate->tbmres = NULL;
+	scanstate->tbmres_unread = false;
 	scanstate->return_empty_tuples = 0;
 	scanstate->vmbuffer = InvalidBuffer;
 	scanstate->pvmbuffer = InvalidBuffer;
@@ -804,12 +816,90 @@ ExecInitBitmapHeapScan(BitmapHeapScan *node, EState *estate, int eflags)
 														  0,
 														  NULL);
 
+	/*
+	 * Determine whether to scan the relation asynchronously or not; this has
+	 * to be kept in sync with the code in ExecInitAppend().
+	 */
+	scanstate->ss.ps.async_capable = (((Plan *) node)->async_capable &&
+									  estate->es_epq_active == NULL);
+
 	/*
 	 * all done.
 	 */
 	return scanstate;
 }
 
+/* ----------------------------------------------------------------
+ *		ExecAsyncBitmapHeapScanRequest
+ *
+ *		Asynchronously request a tuple from a designed async-capable node
+ *
+ *		When the current page is used up, we take the next one from the
+ *		iterator right away and start reading it.  If it isn't in shared
+ *		buffers yet, the request stays pending so that the requestor can
+ *		go on with its other subplans meanwhile.  The bitmap itself is
+ *		still built synchronously, by the first request.
+ * ----------------------------------------------------------------
+ */
+void
+ExecAsyncBitmapHeapScanRequest(AsyncRequest *areq)
+{
+	BitmapHeapScanState *node = (BitmapHeapScanState *) areq->requestee;
+
+	if (node->initialized && node->pstate == NULL &&
+		node->tbmres == NULL && node->return_empty_tuples == 0)
+	{
+		TBMIterateResult *tbmres;
+
+		node->tbmres = tbmres = tbm_iterate(node->tbmiterator);
+		if (tbmres != NULL)
+		{
+			node->tbmres_unread = true;
+
+			/* pages we may skip fetching needn't be read at all */
+			if (!(node->can_skip_fetch && !tbmres->recheck &&
+				  VM_ALL_VISIBLE(node->ss.ss_currentRelation,
+								 tbmres->blockno,
+								 &node->vmbuffer)) &&
+				PrefetchBuffer(node->ss.ss_currentRelation, MAIN_FORKNUM,
+							   tbmres->blockno).initiated_io)
+			{
+				ExecAsyncRequestPending(areq);
+				return;
+			}
+		}
+	}
+
+	ExecAsyncRequestDone(areq, areq->requestee->ExecProcNodeReal(areq->requestee));
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAsyncBitmapHeapScanConfigureWait
+ *
+ *		In async mode, configure for a wait
+ * ----------------------------------------------------------------
+ */
+void
+ExecAsyncBitmapHeapScanConfigureWait(AsyncRequest *areq)
+{
+	/*
+	 * Like a sequential scan, we only wait for the read we have started;
+	 * registering no event gets us notified after the requestor's next poll.
+	 */
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAsyncBitmapHeapScanNotify
+ *
+ *		Callback invoked when a relevant event has occurred
+ * ----------------------------------------------------------------
+ */
+void
+ExecAsyncBitmapHeapScanNotify(AsyncRequest *areq)
+{
+	ExecAsyncRequestDone(areq, areq->requestee->ExecProcNodeReal(areq->requestee));
+}
+
 /*----------------
  *		BitmapShouldInitializeSharedState
  *
@@ -32,6 +32,7 @@
 
 #include "access/relscan.h"
 #include "access/xact.h"
+#include "executor/execAsync.h"
 #include "executor/execdebug.h"
 #include "executor/execParallel.h"
 #include "executor/nodeGather.h"
@@ -45,8 +46,11 @@
 
 
 static TupleTableSlot *ExecGather(PlanState *pstate);
-static TupleTableSlot *gather_getnext(GatherState *gatherstate);
-static MinimalTuple gather_readnext(GatherState *gatherstate);
+static void ExecGatherStart(GatherState *node);
+static TupleTableSlot *gather_project(GatherState *node,
+									  TupleTableSlot *slot);
+static TupleTableSlot *gather_getnext(GatherState *gatherstate, bool nowait);
+static MinimalTuple gather_readnext(GatherState *gatherstate, bool nowait);
 static void ExecShutdownGatherWorkers(GatherState *node);
 
 
@@ -72,9 +76,18 @@ ExecInitGather(Gather *node, EState *estate, int eflags)
 	gatherstate->ps.state = estate;
 	gatherstate->ps.ExecProcNode = ExecGather;
 
+	/*
+	 * Determine whether to run asynchronously or not; this has to be kept in
+	 * sync with the code in ExecInitAppend().
+	 */
+	gatherstate->ps.async_capable = (((Plan *) node)->async_capable &&
+									 estate->es_epq_active == NULL);
+
 	gatherstate->initialized = false;
 	gatherstate->need_to_scan_locally =
-		!node->single_copy && parallel_leader_participation;
+		(!node->single_copy && parallel_leader_participation &&
+		 !gatherstate->ps.async_capable) ||
+		node->parallel_sort;
 	gatherstate->tuples_needed = -1;
 
 	/*
@@ -143,7 +156,6 @@ ExecGather(PlanState *pstate)
 {
 	GatherState *node = castNode(GatherState, pstate);
 	TupleTableSlot *slot;
-	ExprContext *econtext;
 
 	CHECK_FOR_INTERRUPTS();
 
@@ -154,80 +166,104 @@ ExecGather(PlanState *pstate)
 	 * only if it is really needed.
 	 */
 	if (!node->initialized)
-	{
-		EState	   *estate = node->ps.state;
-		Gather	   *gather = (Gather *) node->ps.plan;
-
-		/*
-		 * Sometimes we might have to run without parallelism; but if parallel
-		 * mode is active then we can try to fire up some workers.
-		 */
-		if (gather->num_workers > 0 && estate->es_use_parallel_mode)
-		{
-			ParallelContext *pcxt;
-
-			/* Initialize, or re-initialize, shared state needed by workers. */
-			if (!node->pei)
-				node->pei = ExecInitParallelPlan(outerPlanState(node),
-												 estate,
-												 gather->initParam,
-												 gather->num_workers,
-												 node->tuples_needed);
-			else
-				ExecParallelReinitialize(outerPlanState(node),
-										 node->pei,
-										 gather->initParam);
-
-			/*
-			 * Register backend workers. We might not get as many as we
-			 * requested, or indeed any at all.
-			 */
-			pcxt = node->pei->pcxt;
-			LaunchParallelWorkers(pcxt);
-			/* We save # workers launched for the benefit of EXPLAIN */
-			node->nworkers_launched = pcxt->nworkers_launched;
-
-			/* Set up tuple queue readers to read the results. */
-			if (pcxt->nworkers_launched > 0)
-			{
-				ExecParallelCreateReaders(node->pei);
-				/* Make a working array showing the active readers */
-				node->nreaders = pcxt->nworkers_launched;
-				node->reader = (TupleQueueReader **)
-					palloc(node->nreaders * sizeof(TupleQueueReader *));
-				memcpy(node->reader, node->pei->reader,
-					   node->nreaders * sizeof(TupleQueueReader *));
-			}
-			else
-			{
-				/* No workers?	Then never mind. */
-				node->nreaders = 0;
-				node->reader = NULL;
-			}
-			node->nextreader = 0;
-		}
-
-		/* Run plan locally if no workers or enabled and not single-copy. */
-		node->need_to_scan_locally = (node->nreaders == 0)
-			|| (!gather->single_copy && parallel_leader_participation);
-		node->initialized = true;
-	}
+		ExecGatherStart(node);
 
 	/*
 	 * Reset per-tuple memory context to free any expression evaluation
 	 * storage allocated in the previous tuple cycle.
 	 */
-	econtext = node->ps.ps_ExprContext;
-	ResetExprContext(econtext);
+	ResetExprContext(node->ps.ps_ExprContext);
 
 	/*
 	 * Get next tuple, either from one of our workers, or by running the plan
 	 * ourselves.
 	 */
-	slot = gather_getnext(node);
+	slot = gather_getnext(node, false);
 	if (TupIsNull(slot))
 		return NULL;
 
+	return gather_project(node, slot);
+}
+
+/*
+ * Set up the parallel context and launch the workers, if we can get any.
+ */
+static void
+ExecGatherStart(GatherState *node)
+{
+	EState	   *estate = node->ps.state;
+	Gather	   *gather = (Gather *) node->ps.plan;
+
+	/*
+	 * Sometimes we might have to run without parallelism; but if parallel
+	 * mode is active then we can try to fire up some workers.
+	 */
+	if (gather->num_workers > 0 && estate->es_use_parallel_mode)
+	{
+		ParallelContext *pcxt;
+
+		/* Initialize, or re-initialize, shared state needed by workers. */
+		if (!node->pei)
+			node->pei = ExecInitParallelPlan(outerPlanState(node),
+											 estate,
+											 gather->initParam,
+											 gather->num_workers,
+											 node->tuples_needed);
+		else
+			ExecParallelReinitialize(outerPlanState(node),
+									 node->pei,
+									 gather->initParam);
+
+		/*
+		 * Register backend workers. We might not get as many as we requested,
+		 * or indeed any at all.
+		 */
+		pcxt = node->pei->pcxt;
+		LaunchParallelWorkers(pcxt);
+		/* We save # workers launched for the benefit of EXPLAIN */
+		node->nworkers_launched = pcxt->nworkers_launched;
+
+		/* Set up tuple queue readers to read the results. */
+		if (pcxt->nworkers_launched > 0)
+		{
+			ExecParallelCreateReaders(node->pei);
+			/* Make a working array showing the active readers */
+			node->nreaders = pcxt->nworkers_launched;
+			node->reader = (TupleQueueReader **)
+				palloc(node->nreaders * sizeof(TupleQueueReader *));
+			memcpy(node->reader, node->pei->reader,
+				   node->nreaders * sizeof(TupleQueueReader *));
+		}
+		else
+		{
+			/* No workers?	Then never mind. */
+			node->nreaders = 0;
+			node->reader = NULL;
+		}
+		node->nextreader = 0;
+	}
+
+	/*
+	 * Run plan locally if no workers or enabled and not single-copy.  Below a
+	 * parallel-aware Sort, the workers produce no output, and the leader must
+	 * always return the sorted result.  In async mode, the leader has the
+	 * other subplans of the Append to run while the workers are busy.
+	 */
+	node->need_to_scan_locally = (node->nreaders == 0)
+		|| (!gather->single_copy && parallel_leader_participation &&
+			!node->ps.async_capable)
+		|| gather->parallel_sort;
+	node->initialized = true;
+}
+
+/*
+ * Project a tuple returned by gather_getnext(), if needed.
+ */
+static TupleTableSlot *
+gather_project(GatherState *node, TupleTableSlot *slot)
+{
+	ExprContext *econtext = node->ps.ps_ExprContext;
+
 	/* If no projection is required, we're done. */
 	if (node->ps.ps_ProjInfo == NULL)
 		return slot;
@@ -259,9 +295,12 @@ ExecEndGather(GatherState *node)
  * Read the next tuple.  We might fetch a tuple from one of the tuple queues
  * using gather_readnext, or if no tuple queue contains a tuple and the
  * single_copy flag is not set, we might generate one locally instead.
+ *
+ * If nowait is true and we aren't running the plan locally, return NULL
+ * rather than waiting when no worker has a tuple ready.
  */
 static TupleTableSlot *
-gather_getnext(GatherState *gatherstate)
+gather_getnext(GatherState *gatherstate, bool nowait)
 {
 	PlanState  *outerPlan = outerPlanState(gatherstate);
 	TupleTableSlot *outerTupleSlot;
@@ -274,7 +313,7 @@ gather_getnext(GatherState *gatherstate)
 
 		if (gatherstate->nreaders > 0)
 		{
-			tup = gather_readnext(gatherstate);
+			tup = gather_readnext(gatherstate, nowait);
 
 			if (HeapTupleIsValid(tup))
 			{
@@ -283,6 +322,10 @@ gather_getnext(GatherState *gatherstate)
 									  false);	/* don't pfree tuple  */
 				return fslot;
 			}
+
+			if (nowait && gatherstate->nreaders > 0 &&
+				!gatherstate->need_to_scan_locally)
+				return NULL;
 		}
 
 		if (gatherstate->need_to_scan_locally)
@@ -306,10 +349,11 @@ gather_getnext(GatherState *gatherstate)
 }
 
 /*
- * Attempt to read a tuple from one of our parallel workers.
+ * Attempt to read a tuple from one of our parallel workers.  If nowait is
+ * true, return NULL instead of waiting when none of them has a tuple ready.
  */
 static MinimalTuple
-gather_readnext(GatherState *gatherstate)
+gather_readnext(GatherState *gatherstate, bool nowait)
 {
 	int			nvisited = 0;
 
@@ -379,7 +423,7 @@ gather_readnext(GatherState *gatherstate)
 			 * If (still) running plan locally, return NULL so caller can
 			 * generate another tuple from the local copy of the plan.
 			 */
-			if (gatherstate->need_to_scan_locally)
+			if (gatherstate->need_to_scan_locally || nowait)
 				return NULL;
 
 			/* Nothing to do except wait for developments. */
@@ -475,3 +519,64 @@ ExecReScanGather(GatherState *node)
 	if (outerPlan->chgParam == NULL)
 		ExecReScan(outerPlan);
 }
+
+/* ----------------------------------------------------------------
+ *		ExecAsyncGatherRequest
+ *
+ *		Asynchronously request a tuple from a designed async-capable node
+ *
+ *		If none of the workers has a tuple ready, the request stays
+ *		pending until our latch is set, which is what a worker does when
+ *		it puts a tuple into its queue.  In async mode the leader doesn't
+ *		run the plan itself unless no workers could be launched.
+ * ----------------------------------------------------------------
+ */
+void
+ExecAsyncGatherRequest(AsyncRequest *areq)
+{
+	GatherState *node = (GatherState *) areq->requestee;
+	TupleTableSlot *slot;
+
+	if (!node->initialized)
+		ExecGatherStart(node);
+
+	ResetExprContext(node->ps.ps_ExprContext);
+
+	slot = gather_getnext(node, true);
+	if (slot == NULL)
+	{
+		ExecAsyncRequestPending(areq);
+		return;
+	}
+
+	if (TupIsNull(slot))
+		ExecAsyncRequestDone(areq, NULL);
+	else
+		ExecAsyncRequestDone(areq, gather_project(node, slot));
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAsyncGatherConfigureWait
+ *
+ *		In async mode, configure for a wait
+ * ----------------------------------------------------------------
+ */
+void
+ExecAsyncGatherConfigureWait(AsyncRequest *areq)
+{
+	/* The tuple queues have no file descriptor; wait for our latch */
+	areq->wait_latch = true;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAsyncGatherNotify
+ *
+ *		Callback invoked when a relevant event has occurred
+ * ----------------------------------------------------------------
+ */
+void
+ExecAsyncGatherNotify(AsyncRequest *areq)
+{
+	/* The latch may have been set for some other reason; just try again */
+	ExecAsyncGatherRequest(areq);
+}
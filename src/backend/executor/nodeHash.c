@@ -31,6 +31,7 @@
 #include "catalog/pg_statistic.h"
 #include "commands/tablespace.h"
 #include "executor/execdebug.h"
+#include "executor/execRuntimeFilter.h"
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
@@ -44,6 +45,27 @@
 #include "utils/memutils.h"
 #include "utils/syscache.h"
 
+/*
+ * The radix bucket index is built in two passes over the batch's tuples.
+ * The first scatters them into at most 2^HJ_RADIX_MAX_BITS partitions by the
+ * high bits of their bucket number, so that each output stream is written
+ * sequentially.  The second sorts each partition by bucket; partitions cover
+ * 2^hashjoin_radix_partition_log2 buckets, so that its working set stays in
+ * the CPU cache.  See src/test/modules/test_hash_join_layout for the
+ * benchmark used to choose that and hashjoin_radix_threshold.
+ */
+#define HJ_RADIX_MAX_BITS		8
+
+#if defined(__GNUC__)
+#define hj_prefetch(addr)	__builtin_prefetch(addr)
+#else
+#define hj_prefetch(addr)	((void) (addr))
+#endif
+
+/* GUC parameters */
+int			hashjoin_radix_threshold = 4096;
+int			hashjoin_radix_partition_log2 = 14;
+
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
 static void ExecHashIncreaseNumBuckets(HashJoinTable hashtable);
 static void ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable);
@@ -55,6 +77,8 @@ static void ExecHashSkewTableInsert(HashJoinTable hashtable,
 									uint32 hashvalue,
 									int bucketNumber);
 static void ExecHashRemoveNextSkewBucket(HashJoinTable hashtable);
+static bool ExecScanHashBucketRadix(HashJoinState *hjstate,
+									ExprContext *econtext);
 
 static void *dense_alloc(HashJoinTable hashtable, Size size);
 static HashJoinTuple ExecParallelHashTupleAlloc(HashJoinTable hashtable,
@@ -157,6 +181,9 @@ MultiExecPrivateHash(HashState *node)
 	hashkeys = node->hashkeys;
 	econtext = node->ps.ps_ExprContext;
 
+	if (node->bloom_filter)
+		ExecHashBloomFilterBegin(node->bloom_filter);
+
 	/*
 	 * Get all tuples from the node below the Hash node and insert into the
 	 * hash table (or temp files).
@@ -174,6 +201,9 @@ MultiExecPrivateHash(HashState *node)
 		{
 			int			bucketNumber;
 
+			if (node->bloom_filter)
+				ExecHashBloomFilterAdd(node->bloom_filter, hashvalue);
+
 			bucketNumber = ExecHashGetSkewBucket(hashtable, hashvalue);
 			if (bucketNumber != INVALID_SKEW_BUCKET_NO)
 			{
@@ -201,6 +231,12 @@ MultiExecPrivateHash(HashState *node)
 		hashtable->spacePeak = hashtable->spaceUsed;
 
 	hashtable->partialTuples = hashtable->totalTuples;
+
+	if (hashtable->radixEnabled)
+		ExecHashBuildRadixIndex(hashtable);
+
+	if (node->bloom_filter)
+		ExecHashBloomFilterEnd(node->bloom_filter);
 }
 
 /* ----------------------------------------------------------------
@@ -516,11 +552,31 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 	hashtable->spaceAllowedSkew =
 		hashtable->spaceAllowed * SKEW_HASH_MEM_PERCENT / 100;
 	hashtable->chunks = NULL;
+	hashtable->radixUsed = false;
+	hashtable->radixBucketStart = NULL;
+	hashtable->radixHashValues = NULL;
+	hashtable->radixTuples = NULL;
 	hashtable->current_chunk = NULL;
 	hashtable->parallel_state = state->parallel_state;
 	hashtable->area = state->ps.state->es_query_dsa;
 	hashtable->batches = NULL;
 
+	/*
+	 * Large private hash tables are probed through a radix bucket index, see
+	 * ExecHashBuildRadixIndex().  Smaller ones fit in the CPU cache anyway.
+	 */
+	hashtable->radixEnabled = false;
+	if (state->parallel_state == NULL && hashjoin_radix_threshold >= 0)
+	{
+		double		inner_rel_bytes;
+
+		inner_rel_bytes = rows * (HJTUPLE_OVERHEAD +
+								  MAXALIGN(SizeofMinimalTupleHeader) +
+								  MAXALIGN(outerNode->plan_width));
+		if (inner_rel_bytes >= hashjoin_radix_threshold * 1024.0)
+			hashtable->radixEnabled = true;
+	}
+
 #ifdef HJDEBUG
 	printf("Hashjoin %p: initial nbatch = %d, nbuckets = %d\n",
 		   hashtable, nbatch, nbuckets);
@@ -1627,6 +1683,9 @@ ExecHashTableInsert(HashJoinTable hashtable,
 	int			bucketno;
 	int			batchno;
 
+	/* the radix index can't be maintained incrementally */
+	Assert(hashtable->radixTuples == NULL);
+
 	ExecHashGetBucketAndBatch(hashtable, hashvalue,
 							  &bucketno, &batchno);
 
@@ -1947,6 +2006,181 @@ ExecHashGetBucketAndBatch(HashJoinTable hashtable,
 	}
 }
 
+/*
+ * ExecHashBuildRadixIndex
+ *		build the radix bucket index for the current batch
+ *
+ * This is called once all of a batch's tuples have been loaded into a
+ * private hash table.  The index lists each bucket's tuples contiguously,
+ * next to an array of their hash values, so that ExecScanHashBucket() can
+ * skip non-matching tuples without chasing the bucket chain through them.
+ * The chains are left intact, since they're still used for the skew table,
+ * for finding unmatched inner tuples and for resetting match flags.
+ *
+ * If the index doesn't fit within the memory budget, the batch is simply
+ * probed through the chains.
+ */
+void
+ExecHashBuildRadixIndex(HashJoinTable hashtable)
+{
+	uint32		bucketmask = hashtable->nbuckets - 1;
+	int			nbits;
+	int			shift;
+	int			npartitions;
+	uint32		partbuckets;
+	uint32	   *partstart;
+	uint32	   *cursor;
+	uint32	   *bucketstart;
+	uint32	   *hashvalues;
+	HashJoinTuple *tuples;
+	uint32	   *scratchvalues;
+	HashJoinTuple *scratchtuples;
+	HashMemoryChunk chunk;
+	size_t		ntuples;
+	size_t		maxpart;
+	Size		indexsize;
+	Size		scratchsize;
+	MemoryContext oldcxt;
+	int			p;
+
+	Assert(hashtable->parallel_state == NULL);
+	Assert(hashtable->radixTuples == NULL);
+
+	nbits = Min(Max(hashtable->log2_nbuckets - hashjoin_radix_partition_log2, 0),
+				HJ_RADIX_MAX_BITS);
+	shift = hashtable->log2_nbuckets - nbits;
+	npartitions = 1 << nbits;
+	partbuckets = (uint32) 1 << shift;
+
+	oldcxt = MemoryContextSwitchTo(hashtable->batchCxt);
+
+	/* Count the tuples falling into each partition */
+	partstart = palloc0_array(uint32, npartitions + 1);
+	ntuples = 0;
+	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
+	{
+		size_t		idx = 0;
+
+		while (idx < chunk->used)
+		{
+			HashJoinTuple hashTuple = (HashJoinTuple) (HASH_CHUNK_DATA(chunk) + idx);
+
+			partstart[((hashTuple->hashvalue & bucketmask) >> shift) + 1]++;
+			ntuples++;
+			idx += MAXALIGN(HJTUPLE_OVERHEAD +
+							HJTUPLE_MINTUPLE(hashTuple)->t_len);
+		}
+	}
+
+	maxpart = 0;
+	for (p = 0; p < npartitions; p++)
+	{
+		maxpart = Max(maxpart, partstart[p + 1]);
+		partstart[p + 1] += partstart[p];
+	}
+
+	indexsize = (hashtable->nbuckets + 1) * sizeof(uint32) +
+		ntuples * (sizeof(uint32) + sizeof(HashJoinTuple));
+	scratchsize = maxpart * (sizeof(uint32) + sizeof(HashJoinTuple)) +
+		Max(npartitions, partbuckets) * sizeof(uint32);
+	if (ntuples == 0 || ntuples >= PG_UINT32_MAX ||
+		hashtable->spaceUsed + indexsize + scratchsize > hashtable->spaceAllowed)
+	{
+		pfree(partstart);
+		MemoryContextSwitchTo(oldcxt);
+		return;
+	}
+
+	bucketstart = (uint32 *)
+		palloc_extended((hashtable->nbuckets + 1) * sizeof(uint32),
+						MCXT_ALLOC_HUGE);
+	hashvalues = (uint32 *)
+		palloc_extended(ntuples * sizeof(uint32), MCXT_ALLOC_HUGE);
+	tuples = (HashJoinTuple *)
+		palloc_extended(ntuples * sizeof(HashJoinTuple), MCXT_ALLOC_HUGE);
+	scratchvalues = (uint32 *)
+		palloc_extended(maxpart * sizeof(uint32), MCXT_ALLOC_HUGE);
+	scratchtuples = (HashJoinTuple *)
+		palloc_extended(maxpart * sizeof(HashJoinTuple), MCXT_ALLOC_HUGE);
+	cursor = palloc_array(uint32, Max(npartitions, partbuckets));
+
+	/* First pass: scatter the tuples into their partitions */
+	memcpy(cursor, partstart, npartitions * sizeof(uint32));
+	for (chunk = hashtable->chunks; chunk != NULL; chunk = chunk->next.unshared)
+	{
+		size_t		idx = 0;
+
+		while (idx < chunk->used)
+		{
+			HashJoinTuple hashTuple = (HashJoinTuple) (HASH_CHUNK_DATA(chunk) + idx);
+			uint32		pos;
+
+			pos = cursor[(hashTuple->hashvalue & bucketmask) >> shift]++;
+			hashvalues[pos] = hashTuple->hashvalue;
+			tuples[pos] = hashTuple;
+			idx += MAXALIGN(HJTUPLE_OVERHEAD +
+							HJTUPLE_MINTUPLE(hashTuple)->t_len);
+		}
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	/* Second pass: sort each partition by bucket */
+	for (p = 0; p < npartitions; p++)
+	{
+		uint32		start = partstart[p];
+		uint32		end = partstart[p + 1];
+		uint32		firstbucket = (uint32) p << shift;
+		uint32		pos;
+		uint32		i;
+
+		memset(cursor, 0, partbuckets * sizeof(uint32));
+		for (i = start; i < end; i++)
+			cursor[(hashvalues[i] & bucketmask) - firstbucket]++;
+
+		pos = start;
+		for (i = 0; i < partbuckets; i++)
+		{
+			uint32		count = cursor[i];
+
+			bucketstart[firstbucket + i] = pos;
+			cursor[i] = pos - start;
+			pos += count;
+		}
+		Assert(pos == end);
+
+		for (i = start; i < end; i++)
+		{
+			uint32		j = cursor[(hashvalues[i] & bucketmask) - firstbucket]++;
+
+			scratchvalues[j] = hashvalues[i];
+			scratchtuples[j] = tuples[i];
+		}
+		memcpy(&hashvalues[start], scratchvalues,
+			   (end - start) * sizeof(uint32));
+		memcpy(&tuples[start], scratchtuples,
+			   (end - start) * sizeof(HashJoinTuple));
+
+		CHECK_FOR_INTERRUPTS();
+	}
+	bucketstart[hashtable->nbuckets] = ntuples;
+
+	pfree(cursor);
+	pfree(scratchtuples);
+	pfree(scratchvalues);
+	pfree(partstart);
+	MemoryContextSwitchTo(oldcxt);
+
+	hashtable->radixBucketStart = bucketstart;
+	hashtable->radixHashValues = hashvalues;
+	hashtable->radixTuples = tuples;
+	hashtable->radixUsed = true;
+
+	hashtable->spaceUsed += indexsize;
+	if (hashtable->spaceUsed + scratchsize > hashtable->spacePeak)
+		hashtable->spacePeak = hashtable->spaceUsed + scratchsize;
+}
+
 /*
  * ExecScanHashBucket
  *		scan a hash bucket for matches to the current outer tuple
@@ -1966,6 +2200,10 @@ ExecScanHashBucket(HashJoinState *hjstate,
 	HashJoinTuple hashTuple = hjstate->hj_CurTuple;
 	uint32		hashvalue = hjstate->hj_CurHashValue;
 
+	if (hashtable->radixTuples != NULL &&
+		hjstate->hj_CurSkewBucketNo == INVALID_SKEW_BUCKET_NO)
+		return ExecScanHashBucketRadix(hjstate, econtext);
+
 	/*
 	 * hj_CurTuple is the address of the tuple last returned from the current
 	 * bucket, or NULL if it's time to start scanning a new bucket.
@@ -2008,6 +2246,69 @@ ExecScanHashBucket(HashJoinState *hjstate,
 	return false;
 }
 
+/*
+ * ExecScanHashBucketRadix
+ *		ExecScanHashBucket() for batches with a radix bucket index
+ *
+ * Only tuples whose stored hash value matches are fetched.  While the join
+ * quals are evaluated for one of them, the next candidate in the bucket is
+ * prefetched.
+ */
+static bool
+ExecScanHashBucketRadix(HashJoinState *hjstate,
+						ExprContext *econtext)
+{
+	ExprState  *hjclauses = hjstate->hashclauses;
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	uint32		hashvalue = hjstate->hj_CurHashValue;
+	uint32	   *hashvalues = hashtable->radixHashValues;
+	uint32		pos;
+	uint32		end;
+
+	/*
+	 * If we returned a tuple from this bucket already, hj_CurRadixPos is
+	 * where the search continues.
+	 */
+	if (hjstate->hj_CurTuple != NULL)
+		pos = hjstate->hj_CurRadixPos;
+	else
+		pos = hashtable->radixBucketStart[hjstate->hj_CurBucketNo];
+	end = hashtable->radixBucketStart[hjstate->hj_CurBucketNo + 1];
+
+	while (pos < end && hashvalues[pos] != hashvalue)
+		pos++;
+
+	while (pos < end)
+	{
+		HashJoinTuple hashTuple = hashtable->radixTuples[pos];
+		TupleTableSlot *inntuple;
+
+		/* find the next candidate, and start fetching it */
+		for (pos++; pos < end && hashvalues[pos] != hashvalue; pos++)
+			;
+		if (pos < end)
+			hj_prefetch(hashtable->radixTuples[pos]);
+
+		/* insert hashtable's tuple into exec slot so ExecQual sees it */
+		inntuple = ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(hashTuple),
+										 hjstate->hj_HashTupleSlot,
+										 false);	/* do not pfree */
+		econtext->ecxt_innertuple = inntuple;
+
+		if (ExecQualAndReset(hjclauses, econtext))
+		{
+			hjstate->hj_CurTuple = hashTuple;
+			hjstate->hj_CurRadixPos = pos;
+			return true;
+		}
+	}
+
+	/*
+	 * no match
+	 */
+	return false;
+}
+
 /*
  * ExecParallelScanHashBucket
  *		scan a hash bucket for matches to the current outer tuple
@@ -2314,6 +2615,11 @@ ExecHashTableReset(HashJoinTable hashtable)
 
 	/* Forget the chunks (the memory was freed by the context reset above). */
 	hashtable->chunks = NULL;
+
+	/* Likewise the radix index, if any */
+	hashtable->radixBucketStart = NULL;
+	hashtable->radixHashValues = NULL;
+	hashtable->radixTuples = NULL;
 }
 
 /*
@@ -2857,6 +3163,7 @@ ExecHashAccumInstrumentation(HashInstrumentation *instrument,
 									  hashtable->nbatch_original);
 	instrument->space_peak = Max(instrument->space_peak,
 								 hashtable->spacePeak);
+	instrument->radix_index |= hashtable->radixUsed;
 }
 
 /*
@@ -164,6 +164,7 @@
 
 #include "access/htup_details.h"
 #include "access/parallel.h"
+#include "executor/execRuntimeFilter.h"
 #include "executor/executor.h"
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
@@ -311,6 +312,16 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 					 */
 					node->hj_FirstOuterTupleSlot = NULL;
 				}
+				else if (hashNode->bloom_filter &&
+						 hashNode->bloom_filter->across_gather)
+				{
+					/*
+					 * Fetching an outer tuple would start the parallel
+					 * workers below, before the Bloom filter they are to use
+					 * has been built.
+					 */
+					node->hj_FirstOuterTupleSlot = NULL;
+				}
 				else if (HJ_FILL_OUTER(node) ||
 						 (outerNode->plan->startup_cost < hashNode->ps.plan->total_cost &&
 						  !node->hj_OuterNotEmpty))
@@ -836,6 +847,7 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	hjstate->hj_CurBucketNo = 0;
 	hjstate->hj_CurSkewBucketNo = INVALID_SKEW_BUCKET_NO;
 	hjstate->hj_CurTuple = NULL;
+	hjstate->hj_CurRadixPos = 0;
 
 	hjstate->hj_OuterHashKeys = ExecInitExprList(node->hashkeys,
 												 (PlanState *) hjstate);
@@ -846,6 +858,9 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	hjstate->hj_MatchedOuter = false;
 	hjstate->hj_OuterNotEmpty = false;
 
+	/* Filter the outer side's scans by the inner side's join keys */
+	ExecInitHashBloomFilter(hjstate);
+
 	return hjstate;
 }
 
@@ -1160,6 +1175,9 @@ ExecHashJoinNewBatch(HashJoinState *hjstate)
 		 */
 		BufFileClose(innerFile);
 		hashtable->innerBatchFile[curbatch] = NULL;
+
+		if (hashtable->radixEnabled)
+			ExecHashBuildRadixIndex(hashtable);
 	}
 
 	/*
@@ -1461,6 +1479,14 @@ ExecReScanHashJoin(HashJoinState *node)
 			/* for safety, be sure to clear child plan node's pointer too */
 			hashNode->hashtable = NULL;
 
+			/*
+			 * The Bloom filter describes the old hash table, so the outer
+			 * side mustn't use it until it's rebuilt along with the new one.
+			 * ExecHashJoin may well read an outer tuple before that.
+			 */
+			if (hashNode->bloom_filter)
+				hashNode->bloom_filter->active = false;
+
 			ExecHashTableDestroy(node->hj_HashTable);
 			node->hj_HashTable = NULL;
 			node->hj_JoinState = HJ_BUILD_HASHTABLE;
@@ -1479,6 +1505,7 @@ ExecReScanHashJoin(HashJoinState *node)
 	node->hj_CurBucketNo = 0;
 	node->hj_CurSkewBucketNo = INVALID_SKEW_BUCKET_NO;
 	node->hj_CurTuple = NULL;
+	node->hj_CurRadixPos = 0;
 
 	node->hj_MatchedOuter = false;
 	node->hj_FirstOuterTupleSlot = NULL;
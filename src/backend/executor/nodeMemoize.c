@@ -50,12 +50,25 @@
  * demanding, then that may allow us to start putting useful entries back into
  * the cache again.
  *
+ * When the node runs below a Gather or Gather Merge, the cache is shared by
+ * all participants of the parallel query, so that an inner scan done by one
+ * process benefits the others too.  The shared cache is a dshash table in the
+ * query's DSA area.  Each participant fills cache entries privately, and
+ * only adds them to the table once complete; from then on an entry is never
+ * modified, so reading its tuples requires no lock, just a pin that stops
+ * other participants from evicting the entry.  The LRU list and the memory
+ * accounting of the shared cache are protected by an LWLock.  As we can't
+ * purge the cache of the other participants, we only share it when the
+ * parameters of the cache key are the only parameters our subplan depends
+ * on.
+ *
  *
  * INTERFACE ROUTINES
  *		ExecMemoize			- lookup cache, exec subplan when not found
  *		ExecInitMemoize		- initialize node and subnodes
  *		ExecEndMemoize		- shutdown node and subnodes
  *		ExecReScanMemoize	- rescan the memoize node
+ *		ExecShutdownMemoize	- release resources held by the node
  *
  *		ExecMemoizeEstimate		estimates DSM space needed for parallel plan
  *		ExecMemoizeInitializeDSM initialize DSM for parallel plan
@@ -67,10 +80,14 @@
 #include "postgres.h"
 
 #include "common/hashfn.h"
+#include "executor/execParallel.h"
 #include "executor/executor.h"
 #include "executor/nodeMemoize.h"
+#include "lib/dshash.h"
 #include "lib/ilist.h"
 #include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/lwlock.h"
 #include "utils/datum.h"
 #include "utils/lsyscache.h"
 
@@ -149,15 +166,105 @@ static bool MemoizeHash_equal(struct memoize_hash *tb,
 #include "lib/simplehash.h"
 
 /*
- * MemoizeHash_hash
- *		Hash function for simplehash hashtable.  'key' is unused here as we
- *		require that all table lookups first populate the MemoizeState's
- *		probeslot with the key values to be looked up.
+ * MemoizeSharedCache
+ *		Control data of a cache shared by the participants of a parallel
+ *		query, stored in the DSM segment
+ *
+ * lru_lock protects the LRU list and the memory accounting.  A backend may
+ * lock a partition of the dshash table while holding lru_lock, but must not
+ * acquire lru_lock while holding a partition lock.
+ */
+typedef struct MemoizeSharedCache
+{
+	dshash_table_handle table;	/* handle of the cache's dshash table */
+	LWLock		lru_lock;		/* protects the fields below */
+	dsa_pointer lru_head;		/* least recently used item */
+	dsa_pointer lru_tail;		/* most recently used item */
+	uint64		mem_used;		/* bytes of memory used by the cache */
+	uint64		mem_limit;		/* memory limit in bytes for the cache */
+	uint64		mem_peak;		/* peak memory usage in bytes */
+} MemoizeSharedCache;
+
+/*
+ * MemoizeSharedItem
+ *		A complete set of cached tuples for one set of parameters, stored in
+ *		DSA memory.  Only the LRU links change once the item is in the table.
+ */
+typedef struct MemoizeSharedItem
+{
+	dsa_pointer prev;			/* previous item in the LRU list */
+	dsa_pointer next;			/* next item in the LRU list */
+	pg_atomic_uint32 refcount;	/* number of scans reading the item */
+	uint32		hash;			/* hash value of the parameters */
+	uint64		mem;			/* bytes of memory used by the item */
+	dsa_pointer params;			/* MinimalTuple holding the parameters */
+	dsa_pointer tuplehead;		/* first MemoizeSharedTuple or
+								 * InvalidDsaPointer if no tuples */
+} MemoizeSharedItem;
+
+/*
+ * MemoizeSharedTuple
+ *		An individually cached tuple in DSA memory.  The MinimalTuple follows
+ *		the header.
+ */
+typedef struct MemoizeSharedTuple
+{
+	dsa_pointer next;			/* next tuple for the same parameters */
+} MemoizeSharedTuple;
+
+#define SHARED_TUPLE_HEADER_SIZE	MAXALIGN(sizeof(MemoizeSharedTuple))
+#define SharedTupleGetMinimalTuple(t) \
+	((MinimalTuple) ((char *) (t) + SHARED_TUPLE_HEADER_SIZE))
+
+/*
+ * MemoizeSharedKey
+ *		The key, and the whole entry, of the shared dshash table.  Lookups by
+ *		parameter values leave 'item' invalid and populate the MemoizeState's
+ *		probeslot instead, lookups for a known item compare 'item' directly.
+ */
+typedef struct MemoizeSharedKey
+{
+	uint32		hash;			/* hash value of the parameters */
+	dsa_pointer item;			/* the MemoizeSharedItem */
+} MemoizeSharedKey;
+
+/*
+ * MemoizeSharedState
+ *		Backend-local state for using a shared cache
+ */
+typedef struct MemoizeSharedState
+{
+	MemoizeSharedCache *cache;	/* control data in the DSM segment */
+	dsa_area   *area;			/* DSA area holding the table and items */
+	dshash_table *table;		/* our handle on the dshash table */
+	dsa_pointer item;			/* item read or filled by the current scan */
+	dsa_pointer last_tuple;		/* tuple last returned or stored */
+	bool		pinned;			/* do we hold a pin on 'item'? */
+	bool		published;		/* has the current scan's item been added to
+								 * the table already? */
+} MemoizeSharedState;
+
+static dshash_hash memoize_shared_hash(const void *key, size_t size,
+									   void *arg);
+static int	memoize_shared_compare(const void *a, const void *b, size_t size,
+								   void *arg);
+
+static const dshash_parameters memoize_shared_params = {
+	sizeof(MemoizeSharedKey),
+	sizeof(MemoizeSharedKey),
+	memoize_shared_compare,
+	memoize_shared_hash,
+	LWTRANCHE_MEMOIZE_CACHE
+};
+
+/*
+ * memoize_probe_hash
+ *		Compute the hash value of the key values in the MemoizeState's
+ *		probeslot.
  */
 static uint32
-MemoizeHash_hash(struct memoize_hash *tb, const MemoizeKey *key)
+memoize_probe_hash(MemoizeState *mstate)
 {
-	MemoizeState *mstate = (MemoizeState *) tb->private_data;
 	ExprContext *econtext = mstate->ss.ps.ps_ExprContext;
 	MemoryContext oldcontext;
 	TupleTableSlot *pslot = mstate->probeslot;
@@ -213,22 +320,31 @@ MemoizeHash_hash(struct memoize_hash *tb, const MemoizeKey *key)
 }
 
 /*
- * MemoizeHash_equal
- *		Equality function for confirming hash value matches during a hash
- *		table lookup.  'key2' is never used.  Instead the MemoizeState's
- *		probeslot is always populated with details of what's being looked up.
+ * MemoizeHash_hash
+ *		Hash function for simplehash hashtable.  'key' is unused here as we
+ *		require that all table lookups first populate the MemoizeState's
+ *		probeslot with the key values to be looked up.
+ */
+static uint32
+MemoizeHash_hash(struct memoize_hash *tb, const MemoizeKey *key)
+{
+	return memoize_probe_hash((MemoizeState *) tb->private_data);
+}
+
+/*
+ * memoize_probe_equal
+ *		Check if the key values in 'params' match those in the MemoizeState's
+ *		probeslot.
  */
 static bool
-MemoizeHash_equal(struct memoize_hash *tb, const MemoizeKey *key1,
-				  const MemoizeKey *key2)
+memoize_probe_equal(MemoizeState *mstate, MinimalTuple params)
 {
-	MemoizeState *mstate = (MemoizeState *) tb->private_data;
 	ExprContext *econtext = mstate->ss.ps.ps_ExprContext;
 	TupleTableSlot *tslot = mstate->tableslot;
 	TupleTableSlot *pslot = mstate->probeslot;
 
 	/* probeslot should have already been prepared by prepare_probe_slot() */
-	ExecStoreMinimalTuple(key1->params, tslot, false);
+	ExecStoreMinimalTuple(params, tslot, false);
 
 	if (mstate->binary_mode)
 	{
@@ -277,6 +393,20 @@ MemoizeHash_equal(struct memoize_hash *tb, const MemoizeKey *key1,
 	}
 }
 
+/*
+ * MemoizeHash_equal
+ *		Equality function for confirming hash value matches during a hash
+ *		table lookup.  'key2' is never used.  Instead the MemoizeState's
+ *		probeslot is always populated with details of what's being looked up.
+ */
+static bool
+MemoizeHash_equal(struct memoize_hash *tb, const MemoizeKey *key1,
+				  const MemoizeKey *key2)
+{
+	return memoize_probe_equal((MemoizeState *) tb->private_data,
+							   key1->params);
+}
+
 /*
  * Initialize the hash table to empty.
  */
@@ -293,12 +423,12 @@ build_hash_table(MemoizeState *mstate, uint32 size)
 
 /*
  * prepare_probe_slot
- *		Populate mstate's probeslot with the values from the tuple stored
- *		in 'key'.  If 'key' is NULL, then perform the population by evaluating
+ *		Populate mstate's probeslot with the values from the 'params' tuple.
+ *		If 'params' is NULL, then perform the population by evaluating
  *		mstate's param_exprs.
  */
 static inline void
-prepare_probe_slot(MemoizeState *mstate, MemoizeKey *key)
+prepare_probe_slot(MemoizeState *mstate, MinimalTuple params)
 {
 	TupleTableSlot *pslot = mstate->probeslot;
 	TupleTableSlot *tslot = mstate->tableslot;
@@ -306,7 +436,7 @@ prepare_probe_slot(MemoizeState *mstate, MemoizeKey *key)
 
 	ExecClearTuple(pslot);
 
-	if (key == NULL)
+	if (params == NULL)
 	{
 		ExprContext *econtext = mstate->ss.ps.ps_ExprContext;
 		MemoryContext oldcontext;
@@ -323,8 +453,8 @@ prepare_probe_slot(MemoizeState *mstate, MemoizeKey *key)
 	}
 	else
 	{
-		/* Process the key's MinimalTuple and store the values in probeslot */
-		ExecStoreMinimalTuple(key->params, tslot, false);
+		/* Process the MinimalTuple and store the values in probeslot */
+		ExecStoreMinimalTuple(params, tslot, false);
 		slot_getallattrs(tslot);
 		memcpy(pslot->tts_values, tslot->tts_values, sizeof(Datum) * numKeys);
 		memcpy(pslot->tts_isnull, tslot->tts_isnull, sizeof(bool) * numKeys);
@@ -457,7 +587,7 @@ cache_reduce_memory(MemoizeState *mstate, MemoizeKey *specialkey)
 		 * Populate the hash probe slot in preparation for looking up this LRU
 		 * entry.
 		 */
-		prepare_probe_slot(mstate, key);
+		prepare_probe_slot(mstate, key->params);
 
 		/*
 		 * Ideally the LRU list pointers would be stored in the entry itself
@@ -600,7 +730,7 @@ cache_lookup(MemoizeState *mstate, bool *found)
 			 * We need to repopulate the probeslot as lookups performed during
 			 * the cache evictions above will have stored some other key.
 			 */
-			prepare_probe_slot(mstate, key);
+			prepare_probe_slot(mstate, key->params);
 
 			/* Re-find the newly added entry */
 			entry = memoize_lookup(mstate->hashtable, NULL);
@@ -679,7 +809,7 @@ cache_store_tuple(MemoizeState *mstate, TupleTableSlot *slot)
 			 * We need to repopulate the probeslot as lookups performed during
 			 * the cache evictions above will have stored some other key.
 			 */
-			prepare_probe_slot(mstate, key);
+			prepare_probe_slot(mstate, key->params);
 
 			/* Re-find the entry */
 			mstate->entry = entry = memoize_lookup(mstate->hashtable, NULL);
@@ -690,6 +820,597 @@ cache_store_tuple(MemoizeState *mstate, TupleTableSlot *slot)
 	return true;
 }
 
+/*
+ * memoize_shared_hash
+ *		Hash function for the shared dshash table.  The hash value was
+ *		already computed by memoize_probe_hash().
+ */
+static dshash_hash
+memoize_shared_hash(const void *key, size_t size, void *arg)
+{
+	return ((const MemoizeSharedKey *) key)->hash;
+}
+
+/*
+ * memoize_shared_compare
+ *		Comparison function for the shared dshash table.  'arg' is the
+ *		MemoizeState doing the lookup.
+ */
+static int
+memoize_shared_compare(const void *a, const void *b, size_t size, void *arg)
+{
+	const MemoizeSharedKey *k1 = (const MemoizeSharedKey *) a;
+	const MemoizeSharedKey *k2 = (const MemoizeSharedKey *) b;
+	MemoizeState *mstate = (MemoizeState *) arg;
+	dsa_area   *area = mstate->shared_state->area;
+	MemoizeSharedItem *item;
+
+	if (k1->hash != k2->hash)
+		return 1;
+
+	/* lookups for a known item only need to compare the pointers */
+	if (DsaPointerIsValid(k1->item) && DsaPointerIsValid(k2->item))
+		return k1->item == k2->item ? 0 : 1;
+
+	/* otherwise the probeslot holds the parameters we're looking for */
+	Assert(DsaPointerIsValid(k1->item) || DsaPointerIsValid(k2->item));
+	item = dsa_get_address(area,
+						   DsaPointerIsValid(k1->item) ? k1->item : k2->item);
+
+	return memoize_probe_equal(mstate,
+							   dsa_get_address(area, item->params)) ? 0 : 1;
+}
+
+/*
+ * shared_lru_delete
+ *		Unlink 'item' from the shared cache's LRU list.  The caller must hold
+ *		lru_lock.
+ */
+static void
+shared_lru_delete(MemoizeSharedState *shared, MemoizeSharedItem *item)
+{
+	MemoizeSharedCache *cache = shared->cache;
+
+	if (DsaPointerIsValid(item->prev))
+		((MemoizeSharedItem *) dsa_get_address(shared->area,
+											   item->prev))->next = item->next;
+	else
+		cache->lru_head = item->next;
+
+	if (DsaPointerIsValid(item->next))
+		((MemoizeSharedItem *) dsa_get_address(shared->area,
+											   item->next))->prev = item->prev;
+	else
+		cache->lru_tail = item->prev;
+
+	item->prev = InvalidDsaPointer;
+	item->next = InvalidDsaPointer;
+}
+
+/*
+ * shared_lru_push_tail
+ *		Add 'item', which 'dp' points to, to the end of the shared cache's LRU
+ *		list.  The caller must hold lru_lock.
+ */
+static void
+shared_lru_push_tail(MemoizeSharedState *shared, dsa_pointer dp,
+					 MemoizeSharedItem *item)
+{
+	MemoizeSharedCache *cache = shared->cache;
+
+	item->prev = cache->lru_tail;
+	item->next = InvalidDsaPointer;
+
+	if (DsaPointerIsValid(cache->lru_tail))
+		((MemoizeSharedItem *) dsa_get_address(shared->area,
+											   cache->lru_tail))->next = dp;
+	else
+		cache->lru_head = dp;
+
+	cache->lru_tail = dp;
+}
+
+/*
+ * shared_item_free
+ *		Free the item 'dp' points to along with all of its tuples.
+ */
+static void
+shared_item_free(MemoizeSharedState *shared, dsa_pointer dp)
+{
+	MemoizeSharedItem *item = dsa_get_address(shared->area, dp);
+	dsa_pointer tuple = item->tuplehead;
+
+	while (DsaPointerIsValid(tuple))
+	{
+		dsa_pointer next;
+
+		next = ((MemoizeSharedTuple *) dsa_get_address(shared->area,
+													   tuple))->next;
+		dsa_free(shared->area, tuple);
+		tuple = next;
+	}
+
+	dsa_free(shared->area, item->params);
+	dsa_free(shared->area, dp);
+}
+
+/*
+ * shared_cache_reduce_memory
+ *		Evict the least recently used items from the shared cache until its
+ *		memory consumption is back within the limit.  Items pinned by some
+ *		scan are skipped.  The caller must hold lru_lock.
+ */
+static void
+shared_cache_reduce_memory(MemoizeState *mstate)
+{
+	MemoizeSharedState *shared = mstate->shared_state;
+	MemoizeSharedCache *cache = shared->cache;
+	dsa_pointer dp = cache->lru_head;
+	uint64		evictions = 0;
+
+	while (DsaPointerIsValid(dp) && cache->mem_used > cache->mem_limit)
+	{
+		MemoizeSharedItem *item = dsa_get_address(shared->area, dp);
+		dsa_pointer next = item->next;
+		MemoizeSharedKey key;
+		MemoizeSharedKey *entry;
+
+		if (pg_atomic_read_u32(&item->refcount) != 0)
+		{
+			dp = next;
+			continue;
+		}
+
+		key.hash = item->hash;
+		key.item = dp;
+		entry = dshash_find(shared->table, &key, true);
+		if (unlikely(entry == NULL))
+			elog(ERROR, "could not find memoization table entry");
+
+		/*
+		 * Pins are only taken while holding the partition lock, so with it
+		 * locked exclusively we can be sure nobody will start reading the
+		 * item.
+		 */
+		if (pg_atomic_read_u32(&item->refcount) != 0)
+		{
+			dshash_release_lock(shared->table, entry);
+			dp = next;
+			continue;
+		}
+
+		/* this releases the partition lock */
+		dshash_delete_entry(shared->table, entry);
+
+		shared_lru_delete(shared, item);
+		cache->mem_used -= item->mem;
+		shared_item_free(shared, dp);
+
+		evictions++;
+		dp = next;
+	}
+
+	mstate->stats.cache_evictions += evictions; /* Update Stats */
+}
+
+/*
+ * shared_cache_lookup
+ *		Look for cached tuples for the scan parameters in the probeslot,
+ *		whose hash value is 'hash'.  If found, pin the item, move it to the
+ *		end of the LRU list and return true.
+ */
+static bool
+shared_cache_lookup(MemoizeState *mstate, uint32 hash)
+{
+	MemoizeSharedState *shared = mstate->shared_state;
+	MemoizeSharedKey key;
+	MemoizeSharedKey *entry;
+	MemoizeSharedItem *item;
+	dsa_pointer dp;
+
+	key.hash = hash;
+	key.item = InvalidDsaPointer;
+	entry = dshash_find(shared->table, &key, false);
+	if (entry == NULL)
+		return false;
+
+	dp = entry->item;
+	item = dsa_get_address(shared->area, dp);
+	pg_atomic_fetch_add_u32(&item->refcount, 1);
+	dshash_release_lock(shared->table, entry);
+
+	shared->item = dp;
+	shared->pinned = true;
+
+	/*
+	 * Items are added to the LRU list before lru_lock is released by whoever
+	 * added them to the table, and our pin prevents removal, so the item is
+	 * certainly on the list.
+	 */
+	LWLockAcquire(&shared->cache->lru_lock, LW_EXCLUSIVE);
+	if (shared->cache->lru_tail != dp)
+	{
+		shared_lru_delete(shared, item);
+		shared_lru_push_tail(shared, dp, item);
+	}
+	LWLockRelease(&shared->cache->lru_lock);
+
+	return true;
+}
+
+/*
+ * shared_cache_begin_fill
+ *		Start a new private item for the scan parameters in the probeslot,
+ *		whose hash value is 'hash'.
+ */
+static void
+shared_cache_begin_fill(MemoizeState *mstate, uint32 hash)
+{
+	MemoizeSharedState *shared = mstate->shared_state;
+	MemoizeSharedItem *item;
+	MinimalTuple params;
+
+	shared->item = dsa_allocate(shared->area, sizeof(MemoizeSharedItem));
+	item = dsa_get_address(shared->area, shared->item);
+
+	params = ExecCopySlotMinimalTuple(mstate->probeslot);
+	item->params = dsa_allocate(shared->area, params->t_len);
+	memcpy(dsa_get_address(shared->area, item->params), params,
+		   params->t_len);
+
+	item->prev = InvalidDsaPointer;
+	item->next = InvalidDsaPointer;
+	pg_atomic_init_u32(&item->refcount, 0);
+	item->hash = hash;
+	item->mem = sizeof(MemoizeSharedItem) + params->t_len;
+	item->tuplehead = InvalidDsaPointer;
+
+	pfree(params);
+
+	shared->last_tuple = InvalidDsaPointer;
+	shared->pinned = false;
+	shared->published = false;
+}
+
+/*
+ * shared_cache_store_tuple
+ *		Add the tuple stored in 'slot' to the item being filled.  Returns
+ *		false if the item would not fit into the shared cache.
+ */
+static bool
+shared_cache_store_tuple(MemoizeState *mstate, TupleTableSlot *slot)
+{
+	MemoizeSharedState *shared = mstate->shared_state;
+	MemoizeSharedItem *item = dsa_get_address(shared->area, shared->item);
+	MemoizeSharedTuple *tuple;
+	MinimalTuple mintuple;
+	bool		shouldFree;
+	dsa_pointer dp;
+	Size		len;
+
+	mintuple = ExecFetchSlotMinimalTuple(slot, &shouldFree);
+	len = SHARED_TUPLE_HEADER_SIZE + mintuple->t_len;
+
+	/* mem_limit never changes, so no need for the lock here */
+	if (item->mem + len > shared->cache->mem_limit)
+	{
+		if (shouldFree)
+			pfree(mintuple);
+		return false;
+	}
+
+	dp = dsa_allocate(shared->area, len);
+	tuple = dsa_get_address(shared->area, dp);
+	tuple->next = InvalidDsaPointer;
+	memcpy(SharedTupleGetMinimalTuple(tuple), mintuple, mintuple->t_len);
+
+	if (shouldFree)
+		pfree(mintuple);
+
+	item->mem += len;
+
+	if (!DsaPointerIsValid(shared->last_tuple))
+		item->tuplehead = dp;
+	else
+		((MemoizeSharedTuple *) dsa_get_address(shared->area,
+												shared->last_tuple))->next = dp;
+	shared->last_tuple = dp;
+
+	return true;
+}
+
+/*
+ * shared_cache_publish
+ *		Add the completely filled item to the shared cache, where other
+ *		participants can find it.  If some other participant beat us to it,
+ *		just throw ours away.
+ */
+static void
+shared_cache_publish(MemoizeState *mstate)
+{
+	MemoizeSharedState *shared = mstate->shared_state;
+	MemoizeSharedCache *cache = shared->cache;
+	MemoizeSharedItem *item = dsa_get_address(shared->area, shared->item);
+	MemoizeSharedKey key;
+	MemoizeSharedKey *entry;
+	bool		found;
+
+	/*
+	 * The subplan may have clobbered the probeslot's values, so reload them
+	 * from the item for the table lookup.
+	 */
+	prepare_probe_slot(mstate, dsa_get_address(shared->area, item->params));
+
+	LWLockAcquire(&cache->lru_lock, LW_EXCLUSIVE);
+
+	key.hash = item->hash;
+	key.item = InvalidDsaPointer;
+	entry = dshash_find_or_insert(shared->table, &key, &found);
+
+	if (found)
+	{
+		dshash_release_lock(shared->table, entry);
+		LWLockRelease(&cache->lru_lock);
+		shared_item_free(shared, shared->item);
+	}
+	else
+	{
+		entry->item = shared->item;
+		dshash_release_lock(shared->table, entry);
+
+		shared_lru_push_tail(shared, shared->item, item);
+		cache->mem_used += item->mem;
+		if (cache->mem_used > cache->mem_peak)
+			cache->mem_peak = cache->mem_used;
+
+		if (cache->mem_used > cache->mem_limit)
+			shared_cache_reduce_memory(mstate);
+
+		LWLockRelease(&cache->lru_lock);
+	}
+
+	/* the item may be gone already, so forget about it */
+	shared->item = InvalidDsaPointer;
+	shared->last_tuple = InvalidDsaPointer;
+	shared->published = true;
+}
+
+/*
+ * shared_cache_release
+ *		Release the item used by the current scan.  Items we were still
+ *		filling are freed.
+ */
+static void
+shared_cache_release(MemoizeState *mstate)
+{
+	MemoizeSharedState *shared = mstate->shared_state;
+
+	if (DsaPointerIsValid(shared->item))
+	{
+		if (shared->pinned)
+		{
+			MemoizeSharedItem *item;
+
+			item = dsa_get_address(shared->area, shared->item);
+			pg_atomic_fetch_sub_u32(&item->refcount, 1);
+		}
+		else
+			shared_item_free(shared, shared->item);
+	}
+
+	shared->item = InvalidDsaPointer;
+	shared->last_tuple = InvalidDsaPointer;
+	shared->pinned = false;
+	shared->published = false;
+}
+
+/*
+ * shared_cache_attach
+ *		Start using the shared cache 'cache', whose table 'table' lives in
+ *		'area'.
+ */
+static void
+shared_cache_attach(MemoizeState *mstate, MemoizeSharedCache *cache,
+					dsa_area *area, dshash_table *table)
+{
+	MemoizeSharedState *shared;
+
+	shared = (MemoizeSharedState *) palloc(sizeof(MemoizeSharedState));
+	shared->cache = cache;
+	shared->area = area;
+	shared->table = table;
+	shared->item = InvalidDsaPointer;
+	shared->last_tuple = InvalidDsaPointer;
+	shared->pinned = false;
+	shared->published = false;
+
+	mstate->shared_state = shared;
+	mstate->shared_cache = true;
+}
+
+/*
+ * shared_cache_detach
+ *		Stop using the shared cache.  Any further scans use the node's own
+ *		private cache.
+ */
+static void
+shared_cache_detach(MemoizeState *mstate)
+{
+	MemoizeSharedState *shared = mstate->shared_state;
+
+	shared_cache_release(mstate);
+
+	/* remember the peak memory usage for EXPLAIN */
+	LWLockAcquire(&shared->cache->lru_lock, LW_SHARED);
+	mstate->shared_mem_peak = Max(mstate->shared_mem_peak,
+								  shared->cache->mem_peak);
+	LWLockRelease(&shared->cache->lru_lock);
+
+	dshash_detach(shared->table);
+	pfree(shared);
+	mstate->shared_state = NULL;
+
+	/* the result slot may point into shared memory */
+	ExecClearTuple(mstate->ss.ps.ps_ResultTupleSlot);
+	mstate->mstatus = MEMO_END_OF_SCAN;
+}
+
+/*
+ * ExecMemoizeShared
+ *		ExecMemoize's counterpart for when the cache is shared with the other
+ *		participants of a parallel query.
+ */
+static TupleTableSlot *
+ExecMemoizeShared(MemoizeState *node)
+{
+	MemoizeSharedState *shared = node->shared_state;
+	PlanState  *outerNode = outerPlanState(node);
+	TupleTableSlot *outerslot;
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+	MemoizeSharedTuple *tuple;
+
+	switch (node->mstatus)
+	{
+		case MEMO_CACHE_LOOKUP:
+			{
+				uint32		hash;
+
+				Assert(!DsaPointerIsValid(shared->item));
+
+				/* see if anyone has cached the current parameters */
+				prepare_probe_slot(node, NULL);
+				hash = memoize_probe_hash(node);
+
+				if (shared_cache_lookup(node, hash))
+				{
+					MemoizeSharedItem *item;
+
+					node->stats.cache_hits += 1;	/* stats update */
+
+					item = dsa_get_address(shared->area, shared->item);
+					shared->last_tuple = item->tuplehead;
+
+					/* The cache entry is void of any tuples. */
+					if (!DsaPointerIsValid(shared->last_tuple))
+					{
+						node->mstatus = MEMO_END_OF_SCAN;
+						return NULL;
+					}
+
+					node->mstatus = MEMO_CACHE_FETCH_NEXT_TUPLE;
+
+					tuple = dsa_get_address(shared->area, shared->last_tuple);
+					ExecStoreMinimalTuple(SharedTupleGetMinimalTuple(tuple),
+										  slot, false);
+					return slot;
+				}
+
+				/* Handle cache miss */
+				node->stats.cache_misses += 1;	/* stats update */
+
+				shared_cache_begin_fill(node, hash);
+
+				outerslot = ExecProcNode(outerNode);
+				if (TupIsNull(outerslot))
+				{
+					shared_cache_publish(node);
+					node->mstatus = MEMO_END_OF_SCAN;
+					return NULL;
+				}
+
+				if (unlikely(!shared_cache_store_tuple(node, outerslot)))
+				{
+					node->stats.cache_overflows += 1;	/* stats update */
+					shared_cache_release(node);
+					node->mstatus = MEMO_CACHE_BYPASS_MODE;
+				}
+				else
+				{
+					/*
+					 * When expecting a single row, the item is complete
+					 * already.
+					 */
+					if (node->singlerow)
+						shared_cache_publish(node);
+					node->mstatus = MEMO_FILLING_CACHE;
+				}
+
+				ExecCopySlot(slot, outerslot);
+				return slot;
+			}
+
+		case MEMO_CACHE_FETCH_NEXT_TUPLE:
+			{
+				Assert(shared->pinned);
+				Assert(DsaPointerIsValid(shared->last_tuple));
+
+				/* Skip to the next tuple to output */
+				tuple = dsa_get_address(shared->area, shared->last_tuple);
+				shared->last_tuple = tuple->next;
+
+				/* No more tuples in the cache */
+				if (!DsaPointerIsValid(shared->last_tuple))
+				{
+					node->mstatus = MEMO_END_OF_SCAN;
+					return NULL;
+				}
+
+				tuple = dsa_get_address(shared->area, shared->last_tuple);
+				ExecStoreMinimalTuple(SharedTupleGetMinimalTuple(tuple),
+									  slot, false);
+				return slot;
+			}
+
+		case MEMO_FILLING_CACHE:
+			{
+				outerslot = ExecProcNode(outerNode);
+				if (TupIsNull(outerslot))
+				{
+					/* No more tuples.  Let the others see what we found */
+					if (!shared->published)
+						shared_cache_publish(node);
+					node->mstatus = MEMO_END_OF_SCAN;
+					return NULL;
+				}
+
+				/* see the corresponding check in ExecMemoize */
+				if (unlikely(shared->published))
+					elog(ERROR, "cache entry already complete");
+
+				if (unlikely(!shared_cache_store_tuple(node, outerslot)))
+				{
+					node->stats.cache_overflows += 1;	/* stats update */
+					shared_cache_release(node);
+					node->mstatus = MEMO_CACHE_BYPASS_MODE;
+				}
+
+				ExecCopySlot(slot, outerslot);
+				return slot;
+			}
+
+		case MEMO_CACHE_BYPASS_MODE:
+			{
+				outerslot = ExecProcNode(outerNode);
+				if (TupIsNull(outerslot))
+				{
+					node->mstatus = MEMO_END_OF_SCAN;
+					return NULL;
+				}
+
+				ExecCopySlot(slot, outerslot);
+				return slot;
+			}
+
+		case MEMO_END_OF_SCAN:
+			return NULL;
+
+		default:
+			elog(ERROR, "unrecognized memoize state: %d",
+				 (int) node->mstatus);
+			return NULL;
+	}							/* switch */
+}
+
 static TupleTableSlot *
 ExecMemoize(PlanState *pstate)
 {
@@ -697,6 +1418,9 @@ ExecMemoize(PlanState *pstate)
 	PlanState  *outerNode;
 	TupleTableSlot *slot;
 
+	if (node->shared_state != NULL)
+		return ExecMemoizeShared(node);
+
 	switch (node->mstatus)
 	{
 		case MEMO_CACHE_LOOKUP:
@@ -1051,6 +1775,11 @@ ExecInitMemoize(Memoize *node, EState *estate, int eflags)
 	/* Zero the statistics counters */
 	memset(&mstate->stats, 0, sizeof(MemoizeInstrumentation));
 
+	/* ExecMemoizeInitializeDSM may set up a shared cache later */
+	mstate->shared_state = NULL;
+	mstate->shared_cache = false;
+	mstate->shared_mem_peak = 0;
+
 	/* Allocate and set up the actual cache */
 	build_hash_table(mstate, node->est_entries);
 
@@ -1089,6 +1818,9 @@ ExecEndMemoize(MemoizeState *node)
 	}
 #endif
 
+	if (node->shared_state != NULL)
+		shared_cache_detach(node);
+
 	/*
 	 * When ending a parallel worker, copy the statistics gathered by the
 	 * worker back into shared memory so that it can be picked up by the main
@@ -1130,6 +1862,10 @@ ExecReScanMemoize(MemoizeState *node)
 {
 	PlanState  *outerPlan = outerPlanState(node);
 
+	/* Release the shared cache item used by the last scan */
+	if (node->shared_state != NULL)
+		shared_cache_release(node);
+
 	/* Mark that we must lookup the cache for a new set of parameters */
 	node->mstatus = MEMO_CACHE_LOOKUP;
 
@@ -1146,10 +1882,33 @@ ExecReScanMemoize(MemoizeState *node)
 
 	/*
 	 * Purge the entire cache if a parameter changed that is not part of the
-	 * cache key.
+	 * cache key.  We can't do that to a shared cache, so stop using it.  That
+	 * shouldn't happen, as we only share the cache when our subplan depends on
+	 * no other parameters.
 	 */
 	if (bms_nonempty_difference(outerPlan->chgParam, node->keyparamids))
+	{
+		if (node->shared_state != NULL)
+		{
+			shared_cache_detach(node);
+			node->mstatus = MEMO_CACHE_LOOKUP;
+		}
 		cache_purge_all(node);
+	}
+}
+
+/* ----------------------------------------------------------------
+ *		ExecShutdownMemoize
+ *
+ *		Stop using the shared cache before the DSA area holding it goes
+ *		away.
+ * ----------------------------------------------------------------
+ */
+void
+ExecShutdownMemoize(MemoizeState *node)
+{
+	if (node->shared_state != NULL)
+		shared_cache_detach(node);
 }
 
 /*
@@ -1169,10 +1928,28 @@ ExecEstimateCacheEntryOverheadBytes(double ntuples)
  * ----------------------------------------------------------------
  */
 
+/*
+ * memoize_use_shared_cache
+ *		Can the participants of a parallel query share the node's cache?
+ *
+ * Each participant may rescan the node with different values of the
+ * parameters that are not part of the cache key, so we only share the cache
+ * if the subplan depends on no such parameters.
+ */
+static bool
+memoize_use_shared_cache(MemoizeState *node, ParallelContext *pcxt)
+{
+	Plan	   *outerNode = outerPlan(node->ss.ps.plan);
+
+	return pcxt->nworkers > 0 &&
+		bms_is_subset(outerNode->extParam, node->keyparamids);
+}
+
  /* ----------------------------------------------------------------
   *		ExecMemoizeEstimate
   *
-  *		Estimate space required to propagate memoize statistics.
+  *		Estimate space required to propagate memoize statistics and to
+  *		share the cache.
   * ----------------------------------------------------------------
   */
 void
@@ -1180,6 +1957,12 @@ ExecMemoizeEstimate(MemoizeState *node, ParallelContext *pcxt)
 {
 	Size		size;
 
+	if (memoize_use_shared_cache(node, pcxt))
+	{
+		shm_toc_estimate_chunk(&pcxt->estimator, sizeof(MemoizeSharedCache));
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+
 	/* don't need this if not instrumenting or no workers */
 	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
 		return;
@@ -1193,14 +1976,46 @@ ExecMemoizeEstimate(MemoizeState *node, ParallelContext *pcxt)
 /* ----------------------------------------------------------------
  *		ExecMemoizeInitializeDSM
  *
- *		Initialize DSM space for memoize statistics.
+ *		Initialize DSM space for memoize statistics and set up the shared
+ *		cache.
  * ----------------------------------------------------------------
  */
 void
 ExecMemoizeInitializeDSM(MemoizeState *node, ParallelContext *pcxt)
 {
+	dsa_area   *area = node->ss.ps.state->es_query_dsa;
 	Size		size;
 
+	/* the previous parallel context's shared cache must be gone */
+	Assert(node->shared_state == NULL);
+
+	if (memoize_use_shared_cache(node, pcxt) && area != NULL)
+	{
+		MemoizeSharedCache *cache;
+		dshash_table *table;
+		double		mem_limit;
+
+		cache = shm_toc_allocate(pcxt->toc, sizeof(MemoizeSharedCache));
+		LWLockInitialize(&cache->lru_lock, LWTRANCHE_MEMOIZE_CACHE);
+		cache->lru_head = InvalidDsaPointer;
+		cache->lru_tail = InvalidDsaPointer;
+		cache->mem_used = 0;
+		cache->mem_peak = 0;
+
+		/* give the shared cache the memory of all participants' caches */
+		mem_limit = (double) get_hash_memory_limit() * (pcxt->nworkers + 1);
+		cache->mem_limit = (uint64) Min(mem_limit, (double) SIZE_MAX);
+
+		table = dshash_create(area, &memoize_shared_params, node);
+		cache->table = dshash_get_hash_table_handle(table);
+		shm_toc_insert(pcxt->toc,
+					   PARALLEL_NODE_KEY(node->ss.ps.plan->plan_node_id,
+										 PARALLEL_NODE_KEY_MEMOIZE_CACHE),
+					   cache);
+
+		shared_cache_attach(node, cache, area, table);
+	}
+
 	/* don't need this if not instrumenting or no workers */
 	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
 		return;
@@ -1218,14 +2033,31 @@ ExecMemoizeInitializeDSM(MemoizeState *node, ParallelContext *pcxt)
 /* ----------------------------------------------------------------
  *		ExecMemoizeInitializeWorker
  *
- *		Attach worker to DSM space for memoize statistics.
+ *		Attach worker to DSM space for memoize statistics and to the
+ *		shared cache.
  * ----------------------------------------------------------------
  */
 void
 ExecMemoizeInitializeWorker(MemoizeState *node, ParallelWorkerContext *pwcxt)
 {
+	MemoizeSharedCache *cache;
+
 	node->shared_info =
 		shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, true);
+
+	cache = shm_toc_lookup(pwcxt->toc,
+						   PARALLEL_NODE_KEY(node->ss.ps.plan->plan_node_id,
+											 PARALLEL_NODE_KEY_MEMOIZE_CACHE),
+						   true);
+	if (cache != NULL)
+	{
+		dsa_area   *area = node->ss.ps.state->es_query_dsa;
+		dshash_table *table;
+
+		table = dshash_attach(area, &memoize_shared_params, cache->table,
+							  node);
+		shared_cache_attach(node, cache, area, table);
+	}
 }
 
 /* ----------------------------------------------------------------
@@ -20,6 +20,13 @@
  *		ExecEndSeqScan			releases any storage allocated.
  *		ExecReScanSeqScan		rescans the relation
  *
+ *		ExecAsyncSeqScanRequest	asynchronously requests the next tuple
+ *		ExecAsyncSeqScanConfigureWait	configures the wait for it
+ *		ExecAsyncSeqScanNotify	delivers it once its page is being read
+ *
+ *		ExecSeqScanInitBatch	prepares the scan for batch mode
+ *		ExecSeqScanBatch		retrieve the next batch of qualifying rows
+ *
  *		ExecSeqScanEstimate		estimates DSM space needed for parallel scan
  *		ExecSeqScanInitializeDSM initialize DSM for parallel scan
  *		ExecSeqScanReInitializeDSM reinitialize DSM for fresh parallel scan
@@ -29,10 +36,31 @@
 
 #include "access/relscan.h"
 #include "access/tableam.h"
+#include "executor/execAsync.h"
+#include "executor/execBatch.h"
+#include "executor/execRuntimeFilter.h"
 #include "executor/execdebug.h"
 #include "executor/nodeSeqscan.h"
+#include "miscadmin.h"
 #include "utils/rel.h"
 
+/*
+ * Batch mode state, see ExecSeqScanInitBatch().
+ */
+typedef struct SeqScanBatchState
+{
+	TupleBatch *scanbatch;		/* columns of the scan tuples */
+	TupleBatch *outbatch;		/* projected columns, or scanbatch */
+	int			nscancols;		/* number of scan columns to copy */
+	int		   *scancols;		/* zero-based numbers of those columns */
+	AttrNumber	maxattr;		/* highest scan column needed */
+	List	   *qual;			/* batch-compiled scan qual */
+	int			noutcols;		/* number of projected columns needed */
+	int		   *outcols;		/* zero-based numbers of those columns */
+	BatchExpr **tlist;			/* batch-compiled tlist entries, or NULL if
+								 * there is no projection */
+} SeqScanBatchState;
+
 static TupleTableSlot *SeqNext(SeqScanState *node);
 
 /* ----------------------------------------------------------------
@@ -75,10 +103,19 @@ SeqNext(SeqScanState *node)
 	}
 
 	/*
-	 * get the next tuple from the table
+	 * get the next tuple from the table, skipping those that the Bloom
+	 * filters of hash joins above us tell us cannot be joined
 	 */
-	if (table_scan_getnextslot(scandesc, direction, slot))
-		return slot;
+	while (table_scan_getnextslot(scandesc, direction, slot))
+	{
+		if (node->bloom_filters == NIL ||
+			!ExecScanBloomFilterRejects(&node->ss, node->bloom_filters, slot))
+			return slot;
+
+		InstrCountFiltered2(node, 1);
+		ResetExprContext(node->ss.ps.ps_ExprContext);
+		CHECK_FOR_INTERRUPTS();
+	}
 	return NULL;
 }
 
@@ -171,6 +208,13 @@ ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 	scanstate->ss.ps.qual =
 		ExecInitQual(node->scan.plan.qual, (PlanState *) scanstate);
 
+	/*
+	 * Determine whether to scan the relation asynchronously or not; this has
+	 * to be kept in sync with the code in ExecInitAppend().
+	 */
+	scanstate->ss.ps.async_capable = (((Plan *) node)->async_capable &&
+									  estate->es_epq_active == NULL);
+
 	return scanstate;
 }
 
@@ -234,6 +278,283 @@ ExecReScanSeqScan(SeqScanState *node)
 	ExecScanReScan((ScanState *) node);
 }
 
+/* ----------------------------------------------------------------
+ *						Asynchronous Execution Support
+ *
+ * A sequential scan has no file descriptor to wait on.  Instead, when
+ * the page holding its next tuple isn't in shared buffers yet, a request
+ * starts reading it and stays pending, so that the requestor can get
+ * tuples from its other subplans while the read is in progress.  The
+ * requestor notifies us again once it has polled those, and we then
+ * return the tuple synchronously.
+ * ----------------------------------------------------------------
+ */
+
+/* ----------------------------------------------------------------
+ *		ExecAsyncSeqScanRequest
+ *
+ *		Asynchronously request a tuple from a designed async-capable node
+ * ----------------------------------------------------------------
+ */
+void
+ExecAsyncSeqScanRequest(AsyncRequest *areq)
+{
+	SeqScanState *node = (SeqScanState *) areq->requestee;
+	TableScanDesc scandesc = node->ss.ss_currentScanDesc;
+
+	if (scandesc == NULL)
+	{
+		/* same as in SeqNext() */
+		scandesc = table_beginscan(node->ss.ss_currentRelation,
+								   node->ss.ps.state->es_snapshot,
+								   0, NULL);
+		node->ss.ss_currentScanDesc = scandesc;
+	}
+
+	if (!table_scan_prefetch_next(scandesc))
+	{
+		ExecAsyncRequestPending(areq);
+		return;
+	}
+
+	ExecAsyncRequestDone(areq, areq->requestee->ExecProcNodeReal(areq->requestee));
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAsyncSeqScanConfigureWait
+ *
+ *		In async mode, configure for a wait
+ * ----------------------------------------------------------------
+ */
+void
+ExecAsyncSeqScanConfigureWait(AsyncRequest *areq)
+{
+	/*
+	 * Nothing to wait for but the read we have started; we ask to be
+	 * notified right after the requestor's next poll by not registering any
+	 * event.
+	 */
+}
+
+/* ----------------------------------------------------------------
+ *		ExecAsyncSeqScanNotify
+ *
+ *		Callback invoked when a relevant event has occurred
+ * ----------------------------------------------------------------
+ */
+void
+ExecAsyncSeqScanNotify(AsyncRequest *areq)
+{
+	ExecAsyncRequestDone(areq, areq->requestee->ExecProcNodeReal(areq->requestee));
+}
+
+/* ----------------------------------------------------------------
+ *						Batch Mode Support
+ * ----------------------------------------------------------------
+ */
+
+/* ----------------------------------------------------------------
+ *		ExecSeqScanInitBatch
+ *
+ *		Prepare the scan to hand out batches, for a consumer that
+ *		needs the output columns in outattnos.  Returns false, leaving
+ *		the node untouched, if the qual or the needed part of the
+ *		targetlist can't be evaluated in batch mode.
+ * ----------------------------------------------------------------
+ */
+bool
+ExecSeqScanInitBatch(SeqScanState *node, Bitmapset *outattnos)
+{
+	SeqScan    *plan = (SeqScan *) node->ss.ps.plan;
+	Index		scanrelid = plan->scan.scanrelid;
+	TupleDesc	scandesc = RelationGetDescr(node->ss.ss_currentRelation);
+	SeqScanBatchState *bstate;
+	Bitmapset  *scanattnos = NULL;
+	List	   *qual = NIL;
+	int			attno;
+	int			i;
+
+	/* EvalPlanQual rechecks need ExecScan() */
+	if (node->ss.ps.state->es_epq_active != NULL)
+		return false;
+
+	if (!ExecInitBatchQual(plan->scan.plan.qual, scanrelid, &scanattnos,
+						   &qual))
+		return false;
+
+	bstate = palloc0(sizeof(SeqScanBatchState));
+	bstate->qual = qual;
+
+	if (node->ss.ps.ps_ProjInfo == NULL)
+	{
+		/* output columns are scan columns */
+		scanattnos = bms_add_members(scanattnos, outattnos);
+	}
+	else
+	{
+		List	   *tlist = plan->scan.plan.targetlist;
+
+		bstate->noutcols = bms_num_members(outattnos);
+		bstate->outcols = palloc(sizeof(int) * Max(bstate->noutcols, 1));
+		bstate->tlist = palloc(sizeof(BatchExpr *) * Max(bstate->noutcols, 1));
+		i = 0;
+		attno = -1;
+		while ((attno = bms_next_member(outattnos, attno)) >= 0)
+		{
+			TargetEntry *tle;
+
+			if (attno > list_length(tlist))
+				return false;
+			tle = list_nth_node(TargetEntry, tlist, attno - 1);
+			bstate->tlist[i] = ExecInitBatchExpr(tle->expr, scanrelid,
+												 &scanattnos);
+			if (bstate->tlist[i] == NULL)
+				return false;
+			bstate->outcols[i++] = attno - 1;
+		}
+	}
+
+	/* set up the scan batch */
+	bstate->scanbatch = ExecMakeTupleBatch(scandesc->natts);
+	bstate->nscancols = bms_num_members(scanattnos);
+	bstate->scancols = palloc(sizeof(int) * Max(bstate->nscancols, 1));
+	i = 0;
+	attno = -1;
+	while ((attno = bms_next_member(scanattnos, attno)) >= 0)
+	{
+		Form_pg_attribute attr;
+
+		if (attno > scandesc->natts)
+			return false;
+		attr = TupleDescAttr(scandesc, attno - 1);
+		if (attr->attisdropped || !attr->attbyval)
+			return false;
+
+		ExecTupleBatchAddColumn(bstate->scanbatch, attno);
+		bstate->scancols[i++] = attno - 1;
+		bstate->maxattr = attno;
+	}
+
+	/* and the output batch, whose columns point to the tlist results */
+	if (bstate->tlist == NULL)
+		bstate->outbatch = bstate->scanbatch;
+	else
+	{
+		bstate->outbatch = ExecMakeTupleBatch(list_length(plan->scan.plan.targetlist));
+		bstate->outbatch->sel = bstate->scanbatch->sel;
+	}
+
+	node->batch = bstate;
+	return true;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecSeqScanBatch
+ *
+ *		Fetch the next batch of rows passing the qual, or NULL at the
+ *		end of the scan.  This replaces ExecProcNode() calls on the node
+ *		once ExecSeqScanInitBatch() has succeeded, including the
+ *		instrumentation and rescan handling ExecProcNode() would do.
+ *
+ *		The batch stays valid until the next call.
+ * ----------------------------------------------------------------
+ */
+TupleBatch *
+ExecSeqScanBatch(SeqScanState *node)
+{
+	SeqScanBatchState *bstate = node->batch;
+	TupleBatch *scanbatch = bstate->scanbatch;
+	TupleBatch *outbatch = bstate->outbatch;
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	Instrumentation *instr = node->ss.ps.instrument;
+	MemoryContext oldcontext;
+	int			nrows;
+	int			i;
+
+	Assert(bstate != NULL);
+
+	if (node->ss.ps.chgParam != NULL)	/* something changed? */
+		ExecReScan((PlanState *) node); /* let ReScan handle this */
+
+	if (instr)
+		InstrStartNode(instr);
+
+	for (;;)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		/*
+		 * Values are all pass-by-value, so the expression results don't
+		 * need to survive past this batch.
+		 */
+		ResetExprContext(econtext);
+		oldcontext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+		/* fill the scan batch */
+		for (nrows = 0; nrows < EXEC_BATCH_SIZE; nrows++)
+		{
+			TupleTableSlot *slot = SeqNext(node);
+
+			if (slot == NULL)
+				break;
+
+			slot_getsomeattrs(slot, bstate->maxattr);
+			for (i = 0; i < bstate->nscancols; i++)
+			{
+				int			col = bstate->scancols[i];
+
+				scanbatch->values[col][nrows] = slot->tts_values[col];
+				scanbatch->isnull[col][nrows] = slot->tts_isnull[col];
+			}
+			scanbatch->sel[nrows] = nrows;
+		}
+
+		if (nrows == 0)
+		{
+			/* end of scan */
+			MemoryContextSwitchTo(oldcontext);
+			if (instr)
+				InstrStopNode(instr, 0);
+			return NULL;
+		}
+
+		scanbatch->nrows = nrows;
+		scanbatch->nsel = ExecBatchQual(bstate->qual, scanbatch,
+										scanbatch->sel, nrows);
+		if (scanbatch->nsel < nrows)
+			InstrCountFiltered1(node, nrows - scanbatch->nsel);
+
+		if (scanbatch->nsel == 0)
+		{
+			MemoryContextSwitchTo(oldcontext);
+			continue;
+		}
+
+		/* project */
+		if (bstate->tlist != NULL)
+		{
+			for (i = 0; i < bstate->noutcols; i++)
+			{
+				BatchExpr  *expr = bstate->tlist[i];
+				int			col = bstate->outcols[i];
+
+				ExecEvalBatchExpr(expr, scanbatch, scanbatch->sel,
+								  scanbatch->nsel);
+				outbatch->values[col] = expr->values;
+				outbatch->isnull[col] = expr->isnull;
+			}
+			outbatch->nrows = scanbatch->nrows;
+			outbatch->nsel = scanbatch->nsel;
+		}
+
+		MemoryContextSwitchTo(oldcontext);
+
+		if (instr)
+			InstrStopNode(instr, outbatch->nsel);
+		return outbatch;
+	}
+}
+
 /* ----------------------------------------------------------------
  *						Parallel Scan Support
  * ----------------------------------------------------------------
@@ -17,10 +17,40 @@
 
 #include "access/parallel.h"
 #include "executor/execdebug.h"
+#include "executor/execParallel.h"
 #include "executor/nodeSort.h"
 #include "miscadmin.h"
+#include "optimizer/optimizer.h"
+#include "pgstat.h"
+#include "storage/condition_variable.h"
+#include "storage/spin.h"
 #include "utils/tuplesort.h"
 
+/*
+ * Shared state of a parallel-aware Sort.
+ *
+ * Each participant sorts the tuples it gets from the partial plan below into
+ * one run of the shared tuplesort, and reports in nparticipantsdone when it
+ * is done.  The leader then merges all the runs.  The Sharedsort follows
+ * this struct.
+ */
+typedef struct ParallelSortShared
+{
+	slock_t		mutex;
+	int			nparticipantsdone;	/* # participants done with their run */
+	ConditionVariable workersdonecv;	/* signaled when one is done */
+} ParallelSortShared;
+
+#define ParallelSortSharedSort(shared) \
+	((Sharedsort *) ((char *) (shared) + MAXALIGN(sizeof(ParallelSortShared))))
+
+static Tuplesortstate *ExecSortBegin(SortState *node,
+									 SortCoordinate coordinate,
+									 int tuplesortopts);
+static void ExecSortFill(SortState *node, Tuplesortstate *tuplesortstate);
+static Tuplesortstate *ExecSortParallel(SortState *node);
+static void ExecSortParticipate(SortState *node);
+
 
 /* ----------------------------------------------------------------
  *		ExecSort
@@ -74,9 +104,6 @@ ExecSort(PlanState *pstate)
 
 	if (!node->sort_Done)
 	{
-		Sort	   *plannode = (Sort *) node->ss.ps.plan;
-		PlanState  *outerNode;
-		TupleDesc	tupDesc;
 		int			tuplesortopts = TUPLESORT_NONE;
 
 		SO1_printf("ExecSort: %s\n",
@@ -88,76 +115,42 @@ ExecSort(PlanState *pstate)
 		 */
 		estate->es_direction = ForwardScanDirection;
 
-		/*
-		 * Initialize tuplesort module.
-		 */
-		SO1_printf("ExecSort: %s\n",
-				   "calling tuplesort_begin");
-
-		outerNode = outerPlanState(node);
-		tupDesc = ExecGetResultType(outerNode);
-
-		if (node->randomAccess)
-			tuplesortopts |= TUPLESORT_RANDOMACCESS;
-		if (node->bounded)
-			tuplesortopts |= TUPLESORT_ALLOWBOUNDED;
-
-		if (node->datumSort)
-			tuplesortstate = tuplesort_begin_datum(TupleDescAttr(tupDesc, 0)->atttypid,
-												   plannode->sortOperators[0],
-												   plannode->collations[0],
-												   plannode->nullsFirst[0],
-												   work_mem,
-												   NULL,
-												   tuplesortopts);
-		else
-			tuplesortstate = tuplesort_begin_heap(tupDesc,
-												  plannode->numCols,
-												  plannode->sortColIdx,
-												  plannode->sortOperators,
-												  plannode->collations,
-												  plannode->nullsFirst,
-												  work_mem,
-												  NULL,
-												  tuplesortopts);
-		if (node->bounded)
-			tuplesort_set_bound(tuplesortstate, node->bound);
-		node->tuplesortstate = (void *) tuplesortstate;
-
-		/*
-		 * Scan the subplan and feed all the tuples to tuplesort using the
-		 * appropriate method based on the type of sort we're doing.
-		 */
-		if (node->datumSort)
+		if (node->pshared != NULL)
 		{
-			for (;;)
-			{
-				slot = ExecProcNode(outerNode);
-
-				if (TupIsNull(slot))
-					break;
-				slot_getsomeattrs(slot, 1);
-				tuplesort_putdatum(tuplesortstate,
-								   slot->tts_values[0],
-								   slot->tts_isnull[0]);
-			}
+			/*
+			 * Sort in cooperation with the other participants.  Workers only
+			 * contribute runs, and return no tuples themselves.
+			 */
+			tuplesortstate = ExecSortParallel(node);
 		}
 		else
 		{
-			for (;;)
-			{
-				slot = ExecProcNode(outerNode);
-
-				if (TupIsNull(slot))
-					break;
-				tuplesort_puttupleslot(tuplesortstate, slot);
-			}
+			/*
+			 * Initialize tuplesort module.
+			 */
+			SO1_printf("ExecSort: %s\n",
+					   "calling tuplesort_begin");
+
+			if (node->randomAccess)
+				tuplesortopts |= TUPLESORT_RANDOMACCESS;
+			if (node->bounded)
+				tuplesortopts |= TUPLESORT_ALLOWBOUNDED;
+
+			tuplesortstate = ExecSortBegin(node, NULL, tuplesortopts);
+			if (node->bounded)
+				tuplesort_set_bound(tuplesortstate, node->bound);
+
+			/*
+			 * Scan the subplan and feed all the tuples to tuplesort.
+			 */
+			ExecSortFill(node, tuplesortstate);
+
+			/*
+			 * Complete the sort.
+			 */
+			tuplesort_performsort(tuplesortstate);
 		}
-
-		/*
-		 * Complete the sort.
-		 */
-		tuplesort_performsort(tuplesortstate);
+		node->tuplesortstate = (void *) tuplesortstate;
 
 		/*
 		 * restore to user specified direction
@@ -170,7 +163,7 @@ ExecSort(PlanState *pstate)
 		node->sort_Done = true;
 		node->bounded_Done = node->bounded;
 		node->bound_Done = node->bound;
-		if (node->shared_info && node->am_worker)
+		if (node->shared_info && node->am_worker && tuplesortstate != NULL)
 		{
 			TuplesortInstrumentation *si;
 
@@ -187,6 +180,10 @@ ExecSort(PlanState *pstate)
 
 	slot = node->ss.ps.ps_ResultTupleSlot;
 
+	/* A worker of a parallel sort has handed over its tuples already */
+	if (tuplesortstate == NULL)
+		return ExecClearTuple(slot);
+
 	/*
 	 * Fetch the next sorted item from the appropriate tuplesort function. For
 	 * datum sorts we must manage the slot ourselves and leave it clear when
@@ -210,6 +207,177 @@ ExecSort(PlanState *pstate)
 	return slot;
 }
 
+/*
+ * Begin a tuplesort for the node's input, in the given role of a parallel
+ * sort, or a serial sort if coordinate is NULL.
+ */
+static Tuplesortstate *
+ExecSortBegin(SortState *node, SortCoordinate coordinate, int tuplesortopts)
+{
+	Sort	   *plannode = (Sort *) node->ss.ps.plan;
+	TupleDesc	tupDesc = ExecGetResultType(outerPlanState(node));
+
+	if (node->datumSort)
+		return tuplesort_begin_datum(TupleDescAttr(tupDesc, 0)->atttypid,
+									 plannode->sortOperators[0],
+									 plannode->collations[0],
+									 plannode->nullsFirst[0],
+									 work_mem,
+									 coordinate,
+									 tuplesortopts);
+	else
+		return tuplesort_begin_heap(tupDesc,
+									plannode->numCols,
+									plannode->sortColIdx,
+									plannode->sortOperators,
+									plannode->collations,
+									plannode->nullsFirst,
+									work_mem,
+									coordinate,
+									tuplesortopts);
+}
+
+/*
+ * Scan the subplan and feed all the tuples to tuplesort using the
+ * appropriate method based on the type of sort we're doing.
+ */
+static void
+ExecSortFill(SortState *node, Tuplesortstate *tuplesortstate)
+{
+	PlanState  *outerNode = outerPlanState(node);
+	TupleTableSlot *slot;
+
+	if (node->datumSort)
+	{
+		for (;;)
+		{
+			slot = ExecProcNode(outerNode);
+
+			if (TupIsNull(slot))
+				break;
+			slot_getsomeattrs(slot, 1);
+			tuplesort_putdatum(tuplesortstate,
+							   slot->tts_values[0],
+							   slot->tts_isnull[0]);
+		}
+	}
+	else
+	{
+		for (;;)
+		{
+			slot = ExecProcNode(outerNode);
+
+			if (TupIsNull(slot))
+				break;
+			tuplesort_puttupleslot(tuplesortstate, slot);
+		}
+	}
+}
+
+/*
+ * Perform a parallel-aware sort.
+ *
+ * Every participant sorts its share of the input into a run of the shared
+ * tuplesort.  Workers are done at that point, and return NULL.  The leader
+ * waits for all runs to be finished, and merges them into the complete
+ * sorted output, which it alone returns.  The leader also sorts a share of
+ * the input itself, unless parallel_leader_participation is off and some
+ * workers were launched.
+ */
+static Tuplesortstate *
+ExecSortParallel(SortState *node)
+{
+	ParallelSortShared *pshared = node->pshared;
+	SortCoordinate coordinate;
+	Tuplesortstate *tuplesortstate;
+	int			nworkers;
+	int			nparticipants;
+
+	if (node->am_worker)
+	{
+		ExecSortParticipate(node);
+		return NULL;
+	}
+
+	nworkers = node->pcxt->nworkers_launched;
+	nparticipants = nworkers;
+	if (parallel_leader_participation || nworkers == 0)
+	{
+		ExecSortParticipate(node);
+		nparticipants++;
+	}
+
+	/*
+	 * Wait for the workers' runs.  Make sure that they all started, or we
+	 * might wait forever.
+	 */
+	if (nworkers > 0)
+		WaitForParallelWorkersToAttach(node->pcxt);
+	for (;;)
+	{
+		int			ndone;
+
+		SpinLockAcquire(&pshared->mutex);
+		ndone = pshared->nparticipantsdone;
+		SpinLockRelease(&pshared->mutex);
+
+		if (ndone == nparticipants)
+			break;
+
+		ConditionVariableSleep(&pshared->workersdonecv,
+							   WAIT_EVENT_PARALLEL_SORT);
+	}
+	ConditionVariableCancelSleep();
+
+	/* Merge the runs */
+	coordinate = palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = false;
+	coordinate->nParticipants = nparticipants;
+	coordinate->sharedsort = ParallelSortSharedSort(pshared);
+
+	tuplesortstate = ExecSortBegin(node, coordinate, TUPLESORT_NONE);
+	tuplesort_performsort(tuplesortstate);
+
+	return tuplesortstate;
+}
+
+/*
+ * Sort this process's share of the input into a run of a parallel sort.
+ */
+static void
+ExecSortParticipate(SortState *node)
+{
+	ParallelSortShared *pshared = node->pshared;
+	SortCoordinate coordinate;
+	Tuplesortstate *tuplesortstate;
+
+	coordinate = palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = true;
+	coordinate->nParticipants = -1;
+	coordinate->sharedsort = ParallelSortSharedSort(pshared);
+
+	tuplesortstate = ExecSortBegin(node, coordinate, TUPLESORT_NONE);
+	ExecSortFill(node, tuplesortstate);
+	tuplesort_performsort(tuplesortstate);
+
+	if (node->shared_info && node->am_worker)
+	{
+		TuplesortInstrumentation *si;
+
+		Assert(IsParallelWorker());
+		Assert(ParallelWorkerNumber <= node->shared_info->num_workers);
+		si = &node->shared_info->sinstrument[ParallelWorkerNumber];
+		tuplesort_get_stats(tuplesortstate, si);
+	}
+	tuplesort_end(tuplesortstate);
+	pfree(coordinate);
+
+	SpinLockAcquire(&pshared->mutex);
+	pshared->nparticipantsdone++;
+	SpinLockRelease(&pshared->mutex);
+	ConditionVariableSignal(&pshared->workersdonecv);
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitSort
  *
@@ -243,9 +411,22 @@ ExecInitSort(Sort *node, EState *estate, int eflags)
 										 EXEC_FLAG_BACKWARD |
 										 EXEC_FLAG_MARK)) != 0;
 
+	/*
+	 * A parallel-aware sort can't provide random access, but as it's always
+	 * below a Gather, nobody can ask for anything but a rewind, and we can
+	 * just sort again for that.
+	 */
+	if (node->plan.parallel_aware)
+	{
+		Assert(!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)));
+		sortstate->randomAccess = false;
+	}
+
 	sortstate->bounded = false;
 	sortstate->sort_Done = false;
 	sortstate->tuplesortstate = NULL;
+	sortstate->pshared = NULL;
+	sortstate->pcxt = NULL;
 
 	/*
 	 * Miscellaneous initialization
@@ -394,7 +575,8 @@ ExecReScanSort(SortState *node)
 		!node->randomAccess)
 	{
 		node->sort_Done = false;
-		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+		if (node->tuplesortstate != NULL)
+			tuplesort_end((Tuplesortstate *) node->tuplesortstate);
 		node->tuplesortstate = NULL;
 
 		/*
@@ -416,7 +598,8 @@ ExecReScanSort(SortState *node)
 /* ----------------------------------------------------------------
  *		ExecSortEstimate
  *
- *		Estimate space required to propagate sort statistics.
+ *		Estimate space required to propagate sort statistics, and for
+ *		the shared state of a parallel-aware sort.
  * ----------------------------------------------------------------
  */
 void
@@ -424,6 +607,15 @@ ExecSortEstimate(SortState *node, ParallelContext *pcxt)
 {
 	Size		size;
 
+	if (node->ss.ps.plan->parallel_aware && pcxt->nworkers > 0)
+	{
+		/* one run per worker, plus one for the leader */
+		size = MAXALIGN(sizeof(ParallelSortShared));
+		size = add_size(size, tuplesort_estimate_shared(pcxt->nworkers + 1));
+		shm_toc_estimate_chunk(&pcxt->estimator, size);
+		shm_toc_estimate_keys(&pcxt->estimator, 1);
+	}
+
 	/* don't need this if not instrumenting or no workers */
 	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
 		return;
@@ -437,7 +629,8 @@ ExecSortEstimate(SortState *node, ParallelContext *pcxt)
 /* ----------------------------------------------------------------
  *		ExecSortInitializeDSM
  *
- *		Initialize DSM space for sort statistics.
+ *		Initialize DSM space for sort statistics, and for the shared
+ *		state of a parallel-aware sort.
  * ----------------------------------------------------------------
  */
 void
@@ -445,6 +638,26 @@ ExecSortInitializeDSM(SortState *node, ParallelContext *pcxt)
 {
 	Size		size;
 
+	if (node->ss.ps.plan->parallel_aware && pcxt->nworkers > 0)
+	{
+		ParallelSortShared *pshared;
+
+		size = MAXALIGN(sizeof(ParallelSortShared));
+		size = add_size(size, tuplesort_estimate_shared(pcxt->nworkers + 1));
+		pshared = shm_toc_allocate(pcxt->toc, size);
+		SpinLockInit(&pshared->mutex);
+		pshared->nparticipantsdone = 0;
+		ConditionVariableInit(&pshared->workersdonecv);
+		tuplesort_initialize_shared(ParallelSortSharedSort(pshared),
+									pcxt->nworkers + 1, pcxt->seg);
+		shm_toc_insert(pcxt->toc,
+					   PARALLEL_NODE_KEY(node->ss.ps.plan->plan_node_id,
+										 PARALLEL_NODE_KEY_SORT),
+					   pshared);
+		node->pshared = pshared;
+		node->pcxt = pcxt;
+	}
+
 	/* don't need this if not instrumenting or no workers */
 	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
 		return;
@@ -459,10 +672,41 @@ ExecSortInitializeDSM(SortState *node, ParallelContext *pcxt)
 				   node->shared_info);
 }
 
+/* ----------------------------------------------------------------
+ *		ExecSortReInitializeDSM
+ *
+ *		Reset the shared state of a parallel-aware sort for a rescan.
+ * ----------------------------------------------------------------
+ */
+void
+ExecSortReInitializeDSM(SortState *node, ParallelContext *pcxt)
+{
+	ParallelSortShared *pshared = node->pshared;
+
+	if (pshared == NULL)
+		return;
+
+	/*
+	 * This runs before the rescan reaches us, so forget about the previous
+	 * sort here, as its runs are about to go away.
+	 */
+	if (node->tuplesortstate != NULL)
+	{
+		ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+		node->tuplesortstate = NULL;
+	}
+	node->sort_Done = false;
+
+	pshared->nparticipantsdone = 0;
+	tuplesort_reset_shared(ParallelSortSharedSort(pshared));
+}
+
 /* ----------------------------------------------------------------
  *		ExecSortInitializeWorker
  *
- *		Attach worker to DSM space for sort statistics.
+ *		Attach worker to DSM space for sort statistics, and to the
+ *		shared state of a parallel-aware sort.
  * ----------------------------------------------------------------
  */
 void
@@ -471,6 +715,17 @@ ExecSortInitializeWorker(SortState *node, ParallelWorkerContext *pwcxt)
 	node->shared_info =
 		shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, true);
 	node->am_worker = true;
+
+	if (node->ss.ps.plan->parallel_aware)
+	{
+		node->pshared =
+			shm_toc_lookup(pwcxt->toc,
+						   PARALLEL_NODE_KEY(node->ss.ps.plan->plan_node_id,
+											 PARALLEL_NODE_KEY_SORT),
+						   false);
+		tuplesort_attach_shared(ParallelSortSharedSort(node->pshared),
+								pwcxt->seg);
+	}
 }
 
 /* ----------------------------------------------------------------
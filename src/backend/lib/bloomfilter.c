@@ -192,6 +192,19 @@ bloom_prop_bits_set(bloom_filter *filter)
 	return bits_set / (double) filter->m;
 }
 
+/*
+ * Size of the filter in bytes, including bookkeeping space.
+ *
+ * A Bloom filter is a single chunk of memory without any pointers, so
+ * callers may copy that many bytes elsewhere, e.g. into shared memory, and
+ * test the copy for elements.
+ */
+Size
+bloom_total_size(bloom_filter *filter)
+{
+	return offsetof(bloom_filter, bitset) + filter->m / BITS_PER_BYTE;
+}
+
 /*
  * Which element in the sequence of powers of two is less than or equal to
  * target_bitset_bits?
@@ -3300,6 +3300,29 @@ generate_useful_gather_paths(PlannerInfo *root, RelOptInfo *rel, bool override_r
 
 			add_path(rel, &path->path);
 		}
+
+		/*
+		 * Also consider a parallel-aware sort of the cheapest partial path,
+		 * with the runs sorted by the participants merged by the leader
+		 * rather than streamed through Gather Merge.
+		 */
+		if (enable_parallel_sort && rel->consider_parallel &&
+			!pathkeys_contained_in(useful_pathkeys,
+								   cheapest_partial_path->pathkeys))
+		{
+			Path	   *subpath;
+			GatherPath *path;
+
+			subpath = (Path *) create_parallel_sort_path(root,
+														 rel,
+														 cheapest_partial_path,
+														 useful_pathkeys);
+			rows = subpath->rows * subpath->parallel_workers;
+			path = create_gather_path(root, rel, subpath, rel->reltarget,
+									  NULL, rowsp);
+
+			add_path(rel, &path->path);
+		}
 	}
 }
 
@@ -150,9 +150,11 @@ bool		enable_partitionwise_join = false;
 bool		enable_partitionwise_aggregate = false;
 bool		enable_parallel_append = true;
 bool		enable_parallel_hash = true;
+bool		enable_parallel_sort = true;
 bool		enable_partition_pruning = true;
 bool		enable_presorted_aggregate = true;
 bool		enable_async_append = true;
+bool		enable_async_scan = false;
 
 typedef struct
 {
@@ -424,9 +426,14 @@ cost_gather(GatherPath *path, PlannerInfo *root,
 
 	run_cost = path->subpath->total_cost - path->subpath->startup_cost;
 
-	/* Parallel setup and communication cost. */
+	/*
+	 * Parallel setup and communication cost.  Below a parallel-aware Sort,
+	 * the leader produces the output itself, and the workers send nothing
+	 * through the tuple queues.
+	 */
 	startup_cost += parallel_setup_cost;
-	run_cost += parallel_tuple_cost * path->path.rows;
+	if (!path->parallel_sort)
+		run_cost += parallel_tuple_cost * path->path.rows;
 
 	path->path.startup_cost = startup_cost;
 	path->path.total_cost = (startup_cost + run_cost);
@@ -2117,6 +2124,59 @@ cost_sort(Path *path, PlannerInfo *root,
 	path->total_cost = startup_cost + run_cost;
 }
 
+/*
+ * cost_parallel_sort
+ *	  Determines and returns the cost of a parallel-aware sort, including
+ *	  the cost of reading the input data.
+ *
+ * As for any partial path, 'tuples' is the number of input tuples per
+ * participant.  Each participant sorts its share into a run, which is written
+ * to a shared temporary file.  The leader then reads back all the runs and
+ * merges them, producing the entire output by itself.
+ */
+void
+cost_parallel_sort(Path *path, PlannerInfo *root,
+				   List *pathkeys, Cost input_cost, double tuples, int width,
+				   Cost comparison_cost, int sort_mem)
+{
+	Cost		startup_cost;
+	Cost		run_cost;
+	double		total_tuples;
+	double		nruns;
+	double		npages;
+
+	total_tuples = tuples * get_parallel_divisor(path);
+	nruns = path->parallel_workers + (parallel_leader_participation ? 1 : 0);
+	nruns = Max(nruns, 1.0);
+	npages = ceil(relation_byte_size(total_tuples, width) / BLCKSZ);
+
+	/* All participants sort their share, and write it out, concurrently */
+	cost_tuplesort(&startup_cost, &run_cost,
+				   tuples, width,
+				   comparison_cost, sort_mem,
+				   -1.0);
+	startup_cost += run_cost + seq_page_cost * npages / nruns;
+
+	if (!enable_sort)
+		startup_cost += disable_cost;
+
+	startup_cost += input_cost;
+
+	/*
+	 * The leader's merge reads all the runs, and does about log2(nruns)
+	 * comparisons per tuple, like Gather Merge.
+	 */
+	comparison_cost += 2.0 * cpu_operator_cost;
+	startup_cost += comparison_cost * nruns * LOG2(nruns);
+	run_cost = seq_page_cost * npages;
+	run_cost += comparison_cost * total_tuples * LOG2(nruns);
+	run_cost += cpu_operator_cost * total_tuples;
+
+	path->rows = tuples;
+	path->startup_cost = startup_cost;
+	path->total_cost = startup_cost + run_cost;
+}
+
 /*
  * append_nonpartial_cost
  *	  Estimate the cost of the non-partial paths in a Parallel Append.
@@ -81,7 +81,7 @@ static List *get_gating_quals(PlannerInfo *root, List *quals);
 static Plan *create_gating_plan(PlannerInfo *root, Path *path, Plan *plan,
 								List *gating_quals);
 static Plan *create_join_plan(PlannerInfo *root, JoinPath *best_path);
-static bool mark_async_capable_plan(Plan *plan, Path *path);
+static bool mark_async_capable_plan(Plan *plan, Path *path, bool local_only);
 static Plan *create_append_plan(PlannerInfo *root, AppendPath *best_path,
 								int flags);
 static Plan *create_merge_append_plan(PlannerInfo *root, MergeAppendPath *best_path,
@@ -1114,9 +1114,13 @@ create_join_plan(PlannerInfo *root, JoinPath *best_path)
  *		Check whether the Plan node created from a Path node is async-capable,
  *		and if so, mark the Plan node as such and return true, otherwise
  *		return false.
+ *
+ * If local_only is true, the Append might be executed in a parallel worker,
+ * so only nodes that don't depend on a connection of the leader (ie. local
+ * scans) are considered.
  */
 static bool
-mark_async_capable_plan(Plan *plan, Path *path)
+mark_async_capable_plan(Plan *plan, Path *path, bool local_only)
 {
 	switch (nodeTag(path))
 	{
@@ -1137,7 +1141,8 @@ mark_async_capable_plan(Plan *plan, Path *path)
 				 */
 				if (trivial_subqueryscan(scan_plan) &&
 					mark_async_capable_plan(scan_plan->subplan,
-											((SubqueryScanPath *) path)->subpath))
+											((SubqueryScanPath *) path)->subpath,
+											local_only))
 					break;
 				return false;
 			}
@@ -1152,12 +1157,42 @@ mark_async_capable_plan(Plan *plan, Path *path)
 				if (IsA(plan, Result))
 					return false;
 
+				if (local_only)
+					return false;
+
 				Assert(fdwroutine != NULL);
 				if (fdwroutine->IsForeignPathAsyncCapable != NULL &&
 					fdwroutine->IsForeignPathAsyncCapable((ForeignPath *) path))
 					break;
 				return false;
 			}
+		case T_Path:
+		case T_BitmapHeapPath:
+
+			/*
+			 * Plain sequential scans and bitmap heap scans can start reading
+			 * their next page and let the Append go on with other subplans
+			 * meanwhile.  Parallel-aware scans share their block allocation
+			 * with other processes, so they can't look ahead on their own.
+			 */
+			if (!enable_async_scan || path->parallel_aware)
+				return false;
+			if (!(IsA(plan, SeqScan) && path->pathtype == T_SeqScan) &&
+				!IsA(plan, BitmapHeapScan))
+				return false;
+			break;
+		case T_GatherPath:
+
+			/*
+			 * A Gather can let the Append go on with other subplans while
+			 * its workers produce tuples.  Parallel workers can't launch
+			 * workers of their own, so the Append must run in the leader.
+			 */
+			if (!enable_async_scan || local_only)
+				return false;
+			if (!IsA(plan, Gather))
+				return false;
+			break;
 		case T_ProjectionPath:
 
 			/*
@@ -1172,7 +1207,8 @@ mark_async_capable_plan(Plan *plan, Path *path)
 			 * check the capability using the subpath.
 			 */
 			if (mark_async_capable_plan(plan,
-										((ProjectionPath *) path)->subpath))
+										((ProjectionPath *) path)->subpath,
+										local_only))
 				return true;
 			return false;
 		default:
@@ -1273,9 +1309,14 @@ create_append_plan(PlannerInfo *root, AppendPath *best_path, int flags)
 		tlist_was_changed = (orig_tlist_length != list_length(plan->plan.targetlist));
 	}
 
-	/* If appropriate, consider async append */
+	/*
+	 * If appropriate, consider async append.  A parallel-safe Append may run
+	 * in a parallel worker, where only local scans can be executed
+	 * asynchronously.
+	 */
 	consider_async = (enable_async_append && pathkeys == NIL &&
-					  !best_path->path.parallel_safe &&
+					  (!best_path->path.parallel_safe || enable_async_scan) &&
+					  !best_path->path.parallel_aware &&
 					  list_length(best_path->subpaths) > 1);
 
 	/* Build the plan for each child */
@@ -1345,7 +1386,9 @@ create_append_plan(PlannerInfo *root, AppendPath *best_path, int flags)
 		}
 
 		/* If needed, check to see if subplan can be executed asynchronously */
-		if (consider_async && mark_async_capable_plan(subplan, subpath))
+		if (consider_async &&
+			mark_async_capable_plan(subplan, subpath,
+									best_path->path.parallel_safe))
 		{
 			Assert(subplan->async_capable);
 			++nasyncplans;
@@ -1917,6 +1960,7 @@ create_gather_plan(PlannerInfo *root, GatherPath *best_path)
 							  assign_special_exec_param(root),
 							  best_path->single_copy,
 							  subplan);
+	gather_plan->parallel_sort = best_path->parallel_sort;
 
 	copy_generic_path_info(&gather_plan->plan, &best_path->path);
 
@@ -6820,6 +6864,7 @@ make_gather(List *qptlist,
 	node->rescan_param = rescan_param;
 	node->single_copy = single_copy;
 	node->invisible = false;
+	node->parallel_sort = false;
 	node->initParam = NULL;
 
 	return node;
@@ -1981,6 +1981,7 @@ create_gather_path(PlannerInfo *root, RelOptInfo *rel, Path *subpath,
 	pathnode->subpath = subpath;
 	pathnode->num_workers = subpath->parallel_workers;
 	pathnode->single_copy = false;
+	pathnode->parallel_sort = false;
 
 	if (pathnode->num_workers == 0)
 	{
@@ -1989,6 +1990,16 @@ create_gather_path(PlannerInfo *root, RelOptInfo *rel, Path *subpath,
 		pathnode->single_copy = true;
 	}
 
+	/*
+	 * The whole output of a parallel-aware Sort is produced by the leader, so
+	 * it stays in order.
+	 */
+	if (IsA(subpath, SortPath) && subpath->parallel_aware)
+	{
+		pathnode->path.pathkeys = subpath->pathkeys;
+		pathnode->parallel_sort = true;
+	}
+
 	cost_gather(pathnode, root, rel, pathnode->path.param_info, rows);
 
 	return pathnode;
@@ -2982,6 +2993,52 @@ create_sort_path(PlannerInfo *root,
 	return pathnode;
 }
 
+/*
+ * create_parallel_sort_path
+ *	  Creates a pathnode that represents a parallel-aware sort of a partial
+ *	  path.
+ *
+ * All participants sort their share of the input into runs, which the
+ * leader merges.  The result must be gathered by a Gather node, through
+ * which only the leader's output, the complete sorted result, comes.
+ *
+ * 'rel' is the parent relation associated with the result
+ * 'subpath' is the partial path representing the source of data
+ * 'pathkeys' represents the desired sort order
+ */
+SortPath *
+create_parallel_sort_path(PlannerInfo *root,
+						  RelOptInfo *rel,
+						  Path *subpath,
+						  List *pathkeys)
+{
+	SortPath   *pathnode = makeNode(SortPath);
+
+	Assert(subpath->parallel_workers > 0);
+
+	pathnode->path.pathtype = T_Sort;
+	pathnode->path.parent = rel;
+	/* Sort doesn't project, so use source path's pathtarget */
+	pathnode->path.pathtarget = subpath->pathtarget;
+	pathnode->path.param_info = NULL;
+	pathnode->path.parallel_aware = true;
+	pathnode->path.parallel_safe = rel->consider_parallel &&
+		subpath->parallel_safe;
+	pathnode->path.parallel_workers = subpath->parallel_workers;
+	pathnode->path.pathkeys = pathkeys;
+
+	pathnode->subpath = subpath;
+
+	cost_parallel_sort(&pathnode->path, root, pathkeys,
+					   subpath->total_cost,
+					   subpath->rows,
+					   subpath->pathtarget->width,
+					   0.0,
+					   work_mem);
+
+	return pathnode;
+}
+
 /*
  * create_group_path
  *	  Creates a pathnode that represents performing grouping of presorted input
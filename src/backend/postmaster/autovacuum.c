@@ -66,6 +66,7 @@
 #include <sys/time.h>
 #include <unistd.h>
 
+#include "access/gin.h"
 #include "access/heapam.h"
 #include "access/htup_details.h"
 #include "access/multixact.h"
@@ -2743,6 +2744,9 @@ perform_work_item(AutoVacuumWorkItem *workitem)
 									ObjectIdGetDatum(workitem->avw_relation),
 									Int64GetDatum((int64) workitem->avw_blockNumber));
 				break;
+			case AVW_GINCleanPendingList:
+				ginAutoCleanPendingList(workitem->avw_relation);
+				break;
 			default:
 				elog(WARNING, "unrecognized work item found: type %d",
 					 workitem->avw_type);
@@ -3293,6 +3297,10 @@ autovac_report_workitem(AutoVacuumWorkItem *workitem,
 			snprintf(activity, MAX_AUTOVAC_ACTIV_LEN,
 					 "autovacuum: BRIN summarize");
 			break;
+		case AVW_GINCleanPendingList:
+			snprintf(activity, MAX_AUTOVAC_ACTIV_LEN,
+					 "autovacuum: GIN pending list cleanup");
+			break;
 	}
 
 	/*
@@ -3330,36 +3338,56 @@ AutoVacuumingActive(void) // 这由两个参数控制
 /*
  * Request one work item to the next autovacuum run processing our database.
  * Return false if the request can't be recorded.
+ *
+ * An identical request that is still waiting to be processed makes this one
+ * redundant; it is reported as recorded without taking another slot.
  */
 bool
 AutoVacuumRequestWork(AutoVacuumWorkItemType type, Oid relationId,
 					  BlockNumber blkno)
 {
+	AutoVacuumWorkItem *freeitem = NULL;
 	int			i;
 	bool		result = false;
 
 	LWLockAcquire(AutovacuumLock, LW_EXCLUSIVE);
 
 	/*
-	 * Locate an unused work item and fill it with the given data.
+	 * Look for a pending duplicate, and remember the first unused work item.
 	 */
 	for (i = 0; i < NUM_WORKITEMS; i++)
 	{
 		AutoVacuumWorkItem *workitem = &AutoVacuumShmem->av_workItems[i];
 
-		if (workitem->avw_used)
+		if (!workitem->avw_used)
+		{
+			if (freeitem == NULL)
+				freeitem = workitem;
 			continue;
+		}
 
-		workitem->avw_used = true;
-		workitem->avw_active = false;
-		workitem->avw_type = type;
-		workitem->avw_database = MyDatabaseId;
-		workitem->avw_relation = relationId;
-		workitem->avw_blockNumber = blkno;
-		result = true;
+		if (!workitem->avw_active &&
+			workitem->avw_type == type &&
+			workitem->avw_database == MyDatabaseId &&
+			workitem->avw_relation == relationId &&
+			workitem->avw_blockNumber == blkno)
+		{
+			freeitem = NULL;
+			result = true;
+			break;
+		}
+	}
 
-		/* done */
-		break;
+	/* Fill the unused work item with the given data */
+	if (freeitem != NULL)
+	{
+		freeitem->avw_used = true;
+		freeitem->avw_active = false;
+		freeitem->avw_type = type;
+		freeitem->avw_database = MyDatabaseId;
+		freeitem->avw_relation = relationId;
+		freeitem->avw_blockNumber = blkno;
+		result = true;
 	}
 
 	LWLockRelease(AutovacuumLock);
@@ -672,6 +672,21 @@ static bool ImmediateCheckpointRequested(
   return false;
 }
 
+/*
+ * CheckpointWriteDelayPending -- will CheckpointWriteDelay sleep?
+ *
+ * BufferSync() uses this to finish any writes it has batched up before the
+ * checkpointer takes a nap, so that buffers aren't left pinned and marked
+ * I/O-in-progress for the duration of the sleep.
+ */
+bool CheckpointWriteDelayPending(int flags, double progress) {
+  if (!AmCheckpointerProcess())
+    return false;
+
+  return !(flags & CHECKPOINT_IMMEDIATE) && !ShutdownRequestPending &&
+         !ImmediateCheckpointRequested() && IsCheckpointOnSchedule(progress);
+}
+
 /*
  * CheckpointWriteDelay -- control rate of checkpoint
  *
@@ -696,8 +711,7 @@ void CheckpointWriteDelay(int flags, double progress) {
    * Perform the usual duties and take a nap, unless we're behind schedule,
    * in which case we just try to catch up as quickly as possible.
    */
-  if (!(flags & CHECKPOINT_IMMEDIATE) && !ShutdownRequestPending &&
-      !ImmediateCheckpointRequested() && IsCheckpointOnSchedule(progress)) {
+  if (CheckpointWriteDelayPending(flags, progress)) {
     if (ConfigReloadPending) {
       ConfigReloadPending = false;
       ProcessConfigFile(PGC_SIGHUP);
@@ -547,6 +547,7 @@ SnapBuildBuildSnapshot(SnapBuild *builder) // 先分配一块内存，再把已
 	snapshot->suboverflowed = false;
 	snapshot->takenDuringRecovery = false;
 	snapshot->copied = false;
+	snapshot->snapshot_csn = InvalidCommitSeqNo;
 	snapshot->curcid = FirstCommandId;
 	snapshot->active_count = 0;
 	snapshot->regd_count = 0;
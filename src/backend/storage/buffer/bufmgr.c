@@ -47,12 +47,14 @@
 #include "postmaster/bgwriter.h"
 #include "storage/buf_internals.h"
 #include "storage/bufmgr.h"
+#include "storage/fd.h"
 #include "storage/ipc.h"
 #include "storage/lmgr.h"
 #include "storage/proc.h"
 #include "storage/smgr.h"
 #include "storage/standby.h"
 #include "utils/memdebug.h"
+#include "utils/memutils.h"
 #include "utils/ps_status.h"
 #include "utils/rel.h"
 #include "utils/resowner_private.h"
@@ -131,6 +133,36 @@ typedef struct SMgrSortArray
 	SMgrRelation srel;
 } SMgrSortArray;
 
+/*
+ * Buffers collected by the checkpointer or bgwriter to be written out
+ * together with one smgrwritebatch() call, see WriteBatchAdd().  The buffers
+ * are pinned and marked BM_IO_IN_PROGRESS, and their contents have been
+ * copied to WriteBatchPages, so no content locks are held while the batch is
+ * being filled or written.
+ *
+ * Runs of up to combine_limit adjacent blocks of the same relation fork are
+ * written with a single vectored write.  Unless the I/O layer can overlap
+ * writes, there's nothing to gain from holding on to unrelated buffers, so
+ * then the batch is only ever one run.
+ */
+#define MAX_WRITE_BATCH 32
+
+typedef struct BufferWriteBatch
+{
+	WritebackContext *wb_context;	/* where to schedule writeback */
+	bool		checkpoint;		/* count in checkpointer stats? */
+	bool		async;			/* may hold more than one run? */
+	int			combine_limit;	/* max blocks per run */
+	int			nbuffers;
+	int			run_length;		/* length of the last run in bufs[] */
+	XLogRecPtr	max_lsn;		/* WAL to flush before writing */
+	BufferDesc *max_lsn_buf;	/* the buffer with that LSN */
+	BufferDesc *bufs[MAX_WRITE_BATCH];
+} BufferWriteBatch;
+
+/* private, I/O aligned copies of the pages in a BufferWriteBatch */
+static char *WriteBatchPages = NULL;
+
 /* GUC variables */
 bool		zero_damaged_pages = false;
 int			bgwriter_lru_maxpages = 100;
@@ -152,6 +184,18 @@ int			effective_io_concurrency = DEFAULT_EFFECTIVE_IO_CONCURRENCY;
  */
 int			maintenance_io_concurrency = DEFAULT_MAINTENANCE_IO_CONCURRENCY;
 
+/*
+ * Maximum number of consecutive blocks that ReadBufferBatch() callers, such
+ * as streaming reads, should combine into a single vectored read.
+ */
+int			io_combine_limit = DEFAULT_IO_COMBINE_LIMIT;
+
+/*
+ * Maximum number of adjacent dirty blocks that a checkpoint combines into a
+ * single vectored write.
+ */
+int			checkpoint_write_combine_limit = DEFAULT_IO_COMBINE_LIMIT;
+
 /*
  * GUC variables about triggering kernel writeback for buffers written; OS
  * dependent defaults are set via the GUC mechanism.
@@ -473,9 +517,16 @@ static void UnpinBuffer(BufferDesc *buf);
 static void BufferSync(int flags);
 static uint32 WaitBufHdrUnlocked(BufferDesc *buf);
 static int	SyncOneBuffer(int buf_id, bool skip_recently_used,
-						  WritebackContext *wb_context);
+						  WritebackContext *wb_context,
+						  BufferWriteBatch *batch);
+static void WriteBatchInit(BufferWriteBatch *batch,
+						   WritebackContext *wb_context,
+						   bool checkpoint, int combine_limit);
+static bool WriteBatchIsAdjacent(BufferDesc *prev, BufferDesc *buf);
+static void WriteBatchAdd(BufferWriteBatch *batch, BufferDesc *buf);
+static void FlushWriteBatch(BufferWriteBatch *batch);
 static void WaitIO(BufferDesc *buf);
-static bool StartBufferIO(BufferDesc *buf, bool forInput);
+static bool StartBufferIO(BufferDesc *buf, bool forInput, bool nowait);
 static void TerminateBufferIO(BufferDesc *buf, bool clear_dirty,
 							  uint32 set_flag_bits);
 static void shared_buffer_write_error_callback(void *arg);
@@ -781,6 +832,252 @@ ReadBufferExtended(Relation reln, ForkNumber forkNum, BlockNumber blockNum,
 }
 
 
+/*
+ * ReadBufferBatch -- pin a batch of blocks of a relation, reading in the
+ *		ones that aren't cached with as few I/Os as possible.
+ *
+ * This is equivalent to calling ReadBufferExtended() in RBM_NORMAL mode for
+ * each of the nblocks block numbers in blocks[], except that the blocks that
+ * have to be read from disk are grouped into runs of up to io_combine_limit
+ * consecutive blocks, and all the runs are read with one smgrreadbatch()
+ * call.  Each run becomes a single vectored read, and with io_method =
+ * io_uring the runs are in flight concurrently.  The pinned buffers are
+ * returned in buffers[], in the same order as blocks[].
+ *
+ * nblocks must not exceed MAX_READ_BATCH_BUFFERS.  The caller is responsible
+ * for not asking for more pins than it can afford, see
+ * LimitAdditionalPins().
+ */
+void
+ReadBufferBatch(Relation reln, ForkNumber forkNum,
+				BufferAccessStrategy strategy,
+				const BlockNumber *blocks, int nblocks, Buffer *buffers)
+{
+	SMgrRelation smgr = RelationGetSmgr(reln);
+	char		relpersistence = reln->rd_rel->relpersistence;
+	bool		isLocalBuf = SmgrIsTemp(smgr);
+	BufferDesc *bufHdrs[MAX_READ_BATCH_BUFFERS];
+	bool		found[MAX_READ_BATCH_BUFFERS];
+	int			order[MAX_READ_BATCH_BUFFERS];
+	void	   *bufBlocks[MAX_READ_BATCH_BUFFERS];
+	SMgrIO		ios[MAX_READ_BATCH_BUFFERS];
+	int			nios = 0;
+	int			nread = 0;
+	IOContext	io_context;
+	IOObject	io_object;
+
+	Assert(nblocks > 0 && nblocks <= MAX_READ_BATCH_BUFFERS);
+
+	/* see comments in ReadBufferExtended */
+	if (RELATION_IS_OTHER_TEMP(reln))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot access temporary tables of other sessions")));
+
+	if (isLocalBuf)
+	{
+		/* see comments in ReadBuffer_common */
+		io_context = IOCONTEXT_NORMAL;
+		io_object = IOOBJECT_TEMP_RELATION;
+	}
+	else
+	{
+		io_context = IOContextForStrategy(strategy);
+		io_object = IOOBJECT_RELATION;
+	}
+
+	/*
+	 * Sort the requests by block number.  Callers mostly pass blocks in
+	 * ascending order already, so a simple insertion sort will do.
+	 */
+	for (int i = 0; i < nblocks; i++)
+	{
+		int			j = i;
+
+		while (j > 0 && blocks[order[j - 1]] > blocks[i])
+		{
+			order[j] = order[j - 1];
+			j--;
+		}
+		order[j] = i;
+	}
+
+	/*
+	 * First pin all the buffers.  The ones that weren't found are marked
+	 * IO_IN_PROGRESS by BufferAlloc(), which keeps anyone else from trying to
+	 * read them in until we're done.  BufferAlloc() may have to wait for
+	 * another backend's I/O while we hold some of our own; we pin in block
+	 * number order so that two backends can't end up waiting for each other.
+	 */
+	for (int k = 0; k < nblocks; k++)
+	{
+		int			i = order[k];
+		BlockNumber blockNum = blocks[i];
+		BufferDesc *bufHdr;
+
+		/* Make sure we will have room to remember the buffer pin */
+		ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+
+		TRACE_POSTGRESQL_BUFFER_READ_START(forkNum, blockNum,
+										   smgr->smgr_rlocator.locator.spcOid,
+										   smgr->smgr_rlocator.locator.dbOid,
+										   smgr->smgr_rlocator.locator.relNumber,
+										   smgr->smgr_rlocator.backend);
+
+		pgstat_count_buffer_read(reln);
+
+		if (k > 0 && blocks[order[k - 1]] == blockNum)
+		{
+			int			prev = order[k - 1];
+
+			/*
+			 * Same block asked for twice.  Share the buffer; we must not
+			 * wait for the I/O we're about to do ourselves.
+			 */
+			IncrBufferRefCount(buffers[prev]);
+			bufHdr = bufHdrs[prev];
+			found[i] = true;
+			if (isLocalBuf)
+				pgBufferUsage.local_blks_hit++;
+			else
+				pgBufferUsage.shared_blks_hit++;
+		}
+		else if (isLocalBuf)
+		{
+			bufHdr = LocalBufferAlloc(smgr, forkNum, blockNum, &found[i]);
+			if (found[i])
+				pgBufferUsage.local_blks_hit++;
+			else
+				pgBufferUsage.local_blks_read++;
+		}
+		else
+		{
+			bufHdr = BufferAlloc(smgr, relpersistence, forkNum, blockNum,
+								 strategy, &found[i], io_context);
+			if (found[i])
+				pgBufferUsage.shared_blks_hit++;
+			else
+				pgBufferUsage.shared_blks_read++;
+		}
+
+		bufHdrs[i] = bufHdr;
+		buffers[i] = BufferDescriptorGetBuffer(bufHdr);
+
+		if (found[i])
+		{
+			/* Just need to update stats */
+			pgstat_count_buffer_hit(reln);
+			VacuumPageHit++;
+			pgstat_count_io_op(io_object, io_context, IOOP_HIT);
+
+			if (VacuumCostActive)
+				VacuumCostBalance += VacuumCostPageHit;
+
+			TRACE_POSTGRESQL_BUFFER_READ_DONE(forkNum, blockNum,
+											  smgr->smgr_rlocator.locator.spcOid,
+											  smgr->smgr_rlocator.locator.dbOid,
+											  smgr->smgr_rlocator.locator.relNumber,
+											  smgr->smgr_rlocator.backend,
+											  true);
+			continue;
+		}
+
+		Assert(!(pg_atomic_read_u32(&bufHdr->state) & BM_VALID));	/* spinlock not needed */
+
+		/* Add the block to the current run, or start a new one */
+		bufBlocks[nread] = isLocalBuf ? LocalBufHdrGetBlock(bufHdr) :
+			BufHdrGetBlock(bufHdr);
+
+		if (nios > 0 &&
+			ios[nios - 1].blocknum + ios[nios - 1].nblocks == blockNum &&
+			ios[nios - 1].nblocks < io_combine_limit)
+			ios[nios - 1].nblocks++;
+		else
+		{
+			ios[nios].reln = smgr;
+			ios[nios].forknum = forkNum;
+			ios[nios].blocknum = blockNum;
+			ios[nios].nblocks = 1;
+			ios[nios].buffers = &bufBlocks[nread];
+			nios++;
+		}
+		nread++;
+	}
+
+	if (nios == 0)
+		return;
+
+	/* Now read in all the runs */
+	{
+		instr_time	io_start;
+
+		io_start = pgstat_prepare_io_time();
+		smgrreadbatch(ios, nios);
+		pgstat_count_io_op_time(io_object, io_context, IOOP_READ, io_start,
+								nread);
+	}
+
+	for (int k = 0; k < nblocks; k++)
+	{
+		int			i = order[k];
+		BufferDesc *bufHdr = bufHdrs[i];
+		BlockNumber blockNum = blocks[i];
+		Block		bufBlock;
+
+		if (found[i])
+			continue;
+
+		bufBlock = isLocalBuf ? LocalBufHdrGetBlock(bufHdr) :
+			BufHdrGetBlock(bufHdr);
+
+		/* check for garbage data, exactly like ReadBuffer_common */
+		if (!PageIsVerifiedExtended((Page) bufBlock, blockNum,
+									PIV_LOG_WARNING | PIV_REPORT_STAT))
+		{
+			if (zero_damaged_pages)
+			{
+				ereport(WARNING,
+						(errcode(ERRCODE_DATA_CORRUPTED),
+						 errmsg("invalid page in block %u of relation %s; zeroing out page",
+								blockNum,
+								relpath(smgr->smgr_rlocator, forkNum))));
+				MemSet((char *) bufBlock, 0, BLCKSZ);
+			}
+			else
+				ereport(ERROR,
+						(errcode(ERRCODE_DATA_CORRUPTED),
+						 errmsg("invalid page in block %u of relation %s",
+								blockNum,
+								relpath(smgr->smgr_rlocator, forkNum))));
+		}
+
+		if (isLocalBuf)
+		{
+			/* Only need to adjust flags */
+			uint32		buf_state = pg_atomic_read_u32(&bufHdr->state);
+
+			buf_state |= BM_VALID;
+			pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
+		}
+		else
+		{
+			/* Set BM_VALID, terminate IO, and wake up any waiters */
+			TerminateBufferIO(bufHdr, false, BM_VALID);
+		}
+
+		VacuumPageMiss++;
+		if (VacuumCostActive)
+			VacuumCostBalance += VacuumCostPageMiss;
+
+		TRACE_POSTGRESQL_BUFFER_READ_DONE(forkNum, blockNum,
+										  smgr->smgr_rlocator.locator.spcOid,
+										  smgr->smgr_rlocator.locator.dbOid,
+										  smgr->smgr_rlocator.locator.relNumber,
+										  smgr->smgr_rlocator.backend,
+										  false);
+	}
+}
+
 /*
  * ReadBufferWithoutRelcache -- like ReadBufferExtended, but doesn't require
  *		a relcache entry for the relation.
@@ -1268,7 +1565,7 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 			 * own read attempt if the page is still not BM_VALID.
 			 * StartBufferIO does it all.
 			 */
-			if (StartBufferIO(buf, true))
+			if (StartBufferIO(buf, true, false))
 			{
 				/*
 				 * If we get here, previous attempts to read the buffer must
@@ -1346,7 +1643,7 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 			 * own read attempt if the page is still not BM_VALID.
 			 * StartBufferIO does it all.
 			 */
-			if (StartBufferIO(existing_buf_hdr, true))
+			if (StartBufferIO(existing_buf_hdr, true, false))
 			{
 				/*
 				 * If we get here, previous attempts to read the buffer must
@@ -1390,7 +1687,7 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 	 * to read it before we did, so there's nothing left for BufferAlloc() to
 	 * do.
 	 */
-	if (StartBufferIO(victim_buf_hdr, true))
+	if (StartBufferIO(victim_buf_hdr, true, false))
 		*foundPtr = false;
 	else
 		*foundPtr = true;
@@ -1747,7 +2044,7 @@ again:
  * pessimistic, but outside of toy-sized shared_buffers it should allow
  * sufficient pins.
  */
-static void
+void
 LimitAdditionalPins(uint32 *additional_pins)
 {
 	uint32		max_backends;
@@ -2015,7 +2312,7 @@ ExtendBufferedRelShared(BufferManagerRelation bmr,
 
 				buf_state &= ~BM_VALID;
 				UnlockBufHdr(existing_hdr, buf_state);
-			} while (!StartBufferIO(existing_hdr, true));
+			} while (!StartBufferIO(existing_hdr, true, false));
 		}
 		else
 		{
@@ -2038,7 +2335,7 @@ ExtendBufferedRelShared(BufferManagerRelation bmr,
 			LWLockRelease(partition_lock);
 
 			/* XXX: could combine the locked operations in it with the above */
-			StartBufferIO(victim_buf_hdr, true);
+			StartBufferIO(victim_buf_hdr, true, false);
 		}
 	}
 
@@ -2490,6 +2787,8 @@ BufferSync(int flags)
 	int			i;
 	int			mask = BM_DIRTY;
 	WritebackContext wb_context;
+	BufferWriteBatch batch;
+	BufferWriteBatch *batchp = NULL;
 
 	/* Make sure we can handle the pin inside SyncOneBuffer */
 	ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
@@ -2556,6 +2855,18 @@ BufferSync(int flags)
 
 	WritebackContextInit(&wb_context, &checkpoint_flush_after);
 
+	/*
+	 * The buffers are written in sorted order, so adjacent dirty blocks can
+	 * be combined into vectored writes.  If the I/O layer can write several
+	 * buffers concurrently, unrelated writes are batched up as well.
+	 */
+	if (checkpoint_write_combine_limit > 1 || FileIOBatchIsAsync())
+	{
+		WriteBatchInit(&batch, &wb_context, true,
+					   checkpoint_write_combine_limit);
+		batchp = &batch;
+	}
+
 	TRACE_POSTGRESQL_BUFFER_SYNC_START(NBuffers, num_to_scan);
 
 	/*
@@ -2689,7 +3000,7 @@ BufferSync(int flags)
 		 */
 		if (pg_atomic_read_u32(&bufHdr->state) & BM_CHECKPOINT_NEEDED)
 		{
-			if (SyncOneBuffer(buf_id, false, &wb_context) & BUF_WRITTEN)
+			if (SyncOneBuffer(buf_id, false, &wb_context, batchp) & BUF_WRITTEN)
 			{
 				TRACE_POSTGRESQL_BUFFER_SYNC_WRITTEN(buf_id);
 				PendingCheckpointerStats.buf_written_checkpoints++;
@@ -2717,13 +3028,21 @@ BufferSync(int flags)
 		}
 
 		/*
-		 * Sleep to throttle our I/O rate.
+		 * Sleep to throttle our I/O rate.  Write out the current batch first,
+		 * rather than keep its buffers busy while we sleep.
 		 *
 		 * (This will check for barrier events even if it doesn't sleep.)
 		 */
+		if (batchp != NULL &&
+			CheckpointWriteDelayPending(flags,
+										(double) num_processed / num_to_scan))
+			FlushWriteBatch(batchp);
 		CheckpointWriteDelay(flags, (double) num_processed / num_to_scan);
 	}
 
+	if (batchp != NULL)
+		FlushWriteBatch(batchp);
+
 	/*
 	 * Issue all pending flushes. Only checkpointer calls BufferSync(), so
 	 * IOContext will always be IOCONTEXT_NORMAL.
@@ -2793,6 +3112,8 @@ BgBufferSync(WritebackContext *wb_context)
 	int			num_to_scan;
 	int			num_written;
 	int			reusable_buffers;
+	BufferWriteBatch batch;
+	BufferWriteBatch *batchp = NULL;
 
 	/* Variables for final smoothed_density update */
 	long		new_strategy_delta;
@@ -2973,6 +3294,12 @@ BgBufferSync(WritebackContext *wb_context)
 	/* Make sure we can handle the pin inside SyncOneBuffer */
 	ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
 
+	if (FileIOBatchIsAsync())
+	{
+		WriteBatchInit(&batch, wb_context, false, io_combine_limit);
+		batchp = &batch;
+	}
+
 	num_to_scan = bufs_to_lap;
 	num_written = 0;
 	reusable_buffers = reusable_buffers_est;
@@ -2981,7 +3308,7 @@ BgBufferSync(WritebackContext *wb_context)
 	while (num_to_scan > 0 && reusable_buffers < upcoming_alloc_est)
 	{
 		int			sync_state = SyncOneBuffer(next_to_clean, true,
-											   wb_context);
+											   wb_context, batchp);
 
 		if (++next_to_clean >= NBuffers)
 		{
@@ -3003,6 +3330,9 @@ BgBufferSync(WritebackContext *wb_context)
 			reusable_buffers++;
 	}
 
+	if (batchp != NULL)
+		FlushWriteBatch(batchp);
+
 	PendingBgWriterStats.buf_written_clean += num_written;
 
 #ifdef BGW_DEBUG
@@ -3055,16 +3385,24 @@ BgBufferSync(WritebackContext *wb_context)
  * (BUF_WRITTEN could be set in error if FlushBuffer finds the buffer clean
  * after locking it, but we don't care all that much.)
  *
+ * If batch is not NULL, the write is only queued in it; the caller must
+ * eventually call FlushWriteBatch().
+ *
  * Note: caller must have done ResourceOwnerEnlargeBuffers.
  */
 static int
-SyncOneBuffer(int buf_id, bool skip_recently_used, WritebackContext *wb_context)
+SyncOneBuffer(int buf_id, bool skip_recently_used, WritebackContext *wb_context,
+			  BufferWriteBatch *batch)
 {
 	BufferDesc *bufHdr = GetBufferDescriptor(buf_id);
 	int			result = 0;
 	uint32		buf_state;
 	BufferTag	tag;
 
+	/* A batch holds several pins, so make room for one more each time */
+	if (batch != NULL)
+		ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+
 	ReservePrivateRefCountEntry();
 
 	/*
@@ -3102,6 +3440,13 @@ SyncOneBuffer(int buf_id, bool skip_recently_used, WritebackContext *wb_context)
 	 * buffer is clean by the time we've locked it.)
 	 */
 	PinBuffer_Locked(bufHdr);
+
+	if (batch != NULL)
+	{
+		WriteBatchAdd(batch, bufHdr);
+		return result | BUF_WRITTEN;
+	}
+
 	LWLockAcquire(BufferDescriptorGetContentLock(bufHdr), LW_SHARED);
 
 	FlushBuffer(bufHdr, NULL, IOOBJECT_RELATION, IOCONTEXT_NORMAL);
@@ -3121,6 +3466,237 @@ SyncOneBuffer(int buf_id, bool skip_recently_used, WritebackContext *wb_context)
 	return result | BUF_WRITTEN;
 }
 
+/*
+ * WriteBatchInit -- prepare an empty write batch.
+ */
+static void
+WriteBatchInit(BufferWriteBatch *batch, WritebackContext *wb_context,
+			   bool checkpoint, int combine_limit)
+{
+	if (WriteBatchPages == NULL)
+		WriteBatchPages = MemoryContextAllocAligned(TopMemoryContext,
+													MAX_WRITE_BATCH * BLCKSZ,
+													PG_IO_ALIGN_SIZE, 0);
+
+	batch->wb_context = wb_context;
+	batch->checkpoint = checkpoint;
+	batch->async = FileIOBatchIsAsync();
+	batch->combine_limit = Min(Max(combine_limit, 1), MAX_WRITE_BATCH);
+	batch->nbuffers = 0;
+	batch->run_length = 0;
+	batch->max_lsn = InvalidXLogRecPtr;
+	batch->max_lsn_buf = NULL;
+}
+
+/*
+ * WriteBatchIsAdjacent -- does buf hold the block right after prev's?
+ *
+ * Both buffers must be pinned, so that their tags can't change.
+ */
+static bool
+WriteBatchIsAdjacent(BufferDesc *prev, BufferDesc *buf)
+{
+	return prev->tag.spcOid == buf->tag.spcOid &&
+		prev->tag.dbOid == buf->tag.dbOid &&
+		BufTagGetRelNumber(&prev->tag) == BufTagGetRelNumber(&buf->tag) &&
+		BufTagGetForkNum(&prev->tag) == BufTagGetForkNum(&buf->tag) &&
+		prev->tag.blockNum + 1 == buf->tag.blockNum;
+}
+
+/*
+ * WriteBatchAdd -- queue a pinned buffer for writing in a batch.
+ *
+ * This does the first half of FlushBuffer(): mark the buffer I/O busy and
+ * capture its contents.  The page is copied to private memory, so that the
+ * content lock can be released at once, rather than held until the whole
+ * batch is written.  The pin is kept until FlushWriteBatch().
+ *
+ * While the batch holds I/O on other buffers, we must not sleep waiting for
+ * another backend that might in turn be waiting for one of them; so the
+ * content lock and the I/O are only tried conditionally, and if that fails
+ * the batch is written out before we wait.
+ */
+static void
+WriteBatchAdd(BufferWriteBatch *batch, BufferDesc *buf)
+{
+	LWLock	   *content_lock = BufferDescriptorGetContentLock(buf);
+	XLogRecPtr	recptr;
+	uint32		buf_state;
+	char	   *page;
+	bool		adjacent;
+
+	/* Without asynchronous I/O, a batch is a single run of blocks */
+	adjacent = batch->nbuffers > 0 &&
+		batch->run_length < batch->combine_limit &&
+		WriteBatchIsAdjacent(batch->bufs[batch->nbuffers - 1], buf);
+	if (!batch->async && !adjacent)
+		FlushWriteBatch(batch);
+
+	if (batch->nbuffers == 0 ||
+		!LWLockConditionalAcquire(content_lock, LW_SHARED))
+	{
+		FlushWriteBatch(batch);
+		LWLockAcquire(content_lock, LW_SHARED);
+	}
+
+	if (!StartBufferIO(buf, false, batch->nbuffers > 0))
+	{
+		if (batch->nbuffers == 0)
+		{
+			/* someone else flushed the buffer before we could */
+			LWLockRelease(content_lock);
+			UnpinBuffer(buf);
+			return;
+		}
+
+		FlushWriteBatch(batch);
+		if (!StartBufferIO(buf, false, false))
+		{
+			LWLockRelease(content_lock);
+			UnpinBuffer(buf);
+			return;
+		}
+	}
+
+	/* See FlushBuffer() for why we read the LSN under the header lock */
+	buf_state = LockBufHdr(buf);
+	recptr = BufferGetLSN(buf);
+	buf_state &= ~BM_JUST_DIRTIED;
+	UnlockBufHdr(buf, buf_state);
+
+	/* Only permanent buffers obey the WAL-before-data rule, see FlushBuffer */
+	if ((buf_state & BM_PERMANENT) && recptr > batch->max_lsn)
+	{
+		batch->max_lsn = recptr;
+		batch->max_lsn_buf = buf;
+	}
+
+	page = WriteBatchPages + (Size) batch->nbuffers * BLCKSZ;
+	memcpy(page, BufHdrGetBlock(buf), BLCKSZ);
+	LWLockRelease(content_lock);
+
+	PageSetChecksumInplace((Page) page, buf->tag.blockNum);
+
+	/* the batch may have been flushed since we checked */
+	if (adjacent && batch->nbuffers > 0)
+		batch->run_length++;
+	else
+		batch->run_length = 1;
+	batch->bufs[batch->nbuffers++] = buf;
+
+	if (batch->nbuffers == MAX_WRITE_BATCH ||
+		(!batch->async && batch->run_length == batch->combine_limit))
+		FlushWriteBatch(batch);
+}
+
+/*
+ * FlushWriteBatch -- write out all the buffers queued in a batch.
+ *
+ * This is the second half of FlushBuffer() for every buffer in the batch,
+ * except that WAL is flushed only once, each run of adjacent blocks is
+ * written with one vectored write, and all the writes are handed to
+ * smgrwritebatch() at once.  The buffers are unpinned afterwards.
+ *
+ * Errors in flushing WAL are reported in the context of the buffer that
+ * needed the most of it, as FlushBuffer() would.  Errors in the writes
+ * themselves are reported in the context of the failing request by
+ * smgrwritebatch().
+ */
+static void
+FlushWriteBatch(BufferWriteBatch *batch)
+{
+	SMgrIO		ios[MAX_WRITE_BATCH];
+	void	   *pages[MAX_WRITE_BATCH];
+	ErrorContextCallback errcallback;
+	instr_time	io_start;
+	int			n = batch->nbuffers;
+	int			nios = 0;
+
+	if (n == 0)
+		return;
+
+	if (!XLogRecPtrIsInvalid(batch->max_lsn))
+	{
+		/* Setup error traceback support for ereport() */
+		errcallback.callback = shared_buffer_write_error_callback;
+		errcallback.arg = (void *) batch->max_lsn_buf;
+		errcallback.previous = error_context_stack;
+		error_context_stack = &errcallback;
+
+		XLogFlush(batch->max_lsn);
+
+		error_context_stack = errcallback.previous;
+	}
+
+	for (int i = 0; i < n; i++)
+	{
+		BufferDesc *buf = batch->bufs[i];
+
+		TRACE_POSTGRESQL_BUFFER_FLUSH_START(BufTagGetForkNum(&buf->tag),
+											buf->tag.blockNum,
+											buf->tag.spcOid,
+											buf->tag.dbOid,
+											BufTagGetRelNumber(&buf->tag));
+
+		/* the pages of a run are contiguous in both arrays */
+		pages[i] = WriteBatchPages + (Size) i * BLCKSZ;
+
+		if (nios > 0 &&
+			ios[nios - 1].nblocks < batch->combine_limit &&
+			WriteBatchIsAdjacent(batch->bufs[i - 1], buf))
+		{
+			ios[nios - 1].nblocks++;
+			continue;
+		}
+
+		ios[nios].reln = smgropen(BufTagGetRelFileLocator(&buf->tag),
+								  InvalidBackendId);
+		ios[nios].forknum = BufTagGetForkNum(&buf->tag);
+		ios[nios].blocknum = buf->tag.blockNum;
+		ios[nios].nblocks = 1;
+		ios[nios].buffers = &pages[i];
+		nios++;
+	}
+
+	io_start = pgstat_prepare_io_time();
+
+	smgrwritebatch(ios, nios, false);
+
+	/* The batch is only used by checkpointer and bgwriter */
+	pgstat_count_io_op_time(IOOBJECT_RELATION, IOCONTEXT_NORMAL,
+							IOOP_WRITE, io_start, n);
+	pgstat_count_io_write_requests(IOOBJECT_RELATION, IOCONTEXT_NORMAL, nios);
+
+	if (batch->checkpoint)
+		PendingCheckpointerStats.write_requests_checkpoints += nios;
+
+	pgBufferUsage.shared_blks_written += n;
+
+	for (int i = 0; i < n; i++)
+	{
+		BufferDesc *buf = batch->bufs[i];
+		BufferTag	tag = buf->tag;
+
+		TerminateBufferIO(buf, true, 0);
+
+		TRACE_POSTGRESQL_BUFFER_FLUSH_DONE(BufTagGetForkNum(&tag),
+										   tag.blockNum,
+										   tag.spcOid,
+										   tag.dbOid,
+										   BufTagGetRelNumber(&tag));
+
+		UnpinBuffer(buf);
+
+		ScheduleBufferTagForWriteback(batch->wb_context, IOCONTEXT_NORMAL,
+									  &tag);
+	}
+
+	batch->nbuffers = 0;
+	batch->run_length = 0;
+	batch->max_lsn = InvalidXLogRecPtr;
+	batch->max_lsn_buf = NULL;
+}
+
 /*
  *		AtEOXact_Buffers - clean up at end of transaction.
  *
@@ -3362,7 +3938,7 @@ FlushBuffer(BufferDesc *buf, SMgrRelation reln, IOObject io_object,
 	 * someone else flushed the buffer before we could, so we need not do
 	 * anything.
 	 */
-	if (!StartBufferIO(buf, false))
+	if (!StartBufferIO(buf, false, false))
 		return;
 
 	/* Setup error traceback support for ereport() */
@@ -3458,6 +4034,7 @@ FlushBuffer(BufferDesc *buf, SMgrRelation reln, IOObject io_object,
 	 */
 	pgstat_count_io_op_time(IOOBJECT_RELATION, io_context,
 							IOOP_WRITE, io_start, 1);
+	pgstat_count_io_write_requests(IOOBJECT_RELATION, io_context, 1);
 
 	pgBufferUsage.shared_blks_written++;
 
@@ -4096,6 +4673,8 @@ FlushRelationBuffers(Relation rel)
 				pgstat_count_io_op_time(IOOBJECT_TEMP_RELATION,
 										IOCONTEXT_NORMAL, IOOP_WRITE,
 										io_start, 1);
+				pgstat_count_io_write_requests(IOOBJECT_TEMP_RELATION,
+											   IOCONTEXT_NORMAL, 1);
 
 				buf_state &= ~(BM_DIRTY | BM_JUST_DIRTIED);
 				pg_atomic_unlocked_write_u32(&bufHdr->state, buf_state);
@@ -5090,13 +5669,15 @@ WaitIO(BufferDesc *buf)
 /*
  * StartBufferIO: begin I/O on this buffer
  *	(Assumptions)
- *	My process is executing no IO
  *	The buffer is Pinned
  *
  * In some scenarios there are race conditions in which multiple backends
  * could attempt the same I/O operation concurrently.  If someone else
  * has already started I/O on this buffer then we will block on the
- * I/O condition variable until he's done.
+ * I/O condition variable until he's done, unless nowait is true, in which
+ * case we return false at once.  Callers that already have I/O in progress
+ * on other buffers must pass nowait, or otherwise make sure that they can't
+ * end up waiting for a backend that is waiting for them.
  *
  * Input operations are only attempted on buffers that are not BM_VALID,
  * and output operations only on buffers that are BM_VALID and BM_DIRTY,
@@ -5106,7 +5687,7 @@ WaitIO(BufferDesc *buf)
  * false if someone else already did the work.
  */
 static bool
-StartBufferIO(BufferDesc *buf, bool forInput)
+StartBufferIO(BufferDesc *buf, bool forInput, bool nowait)
 {
 	uint32		buf_state;
 
@@ -5119,6 +5700,8 @@ StartBufferIO(BufferDesc *buf, bool forInput)
 		if (!(buf_state & BM_IO_IN_PROGRESS))
 			break;
 		UnlockBufHdr(buf, buf_state);
+		if (nowait)
+			return false;
 		WaitIO(buf);
 	}
 
@@ -23,19 +23,37 @@
 
 #define INT_ACCESS_ONCE(var)	((int)(*((volatile int *)&(var))))
 
+/*
+ * Partitions smaller than this aren't worth having; clock_sweep_partitions
+ * is silently reduced if shared_buffers is too small to honor it.
+ */
+#define MIN_BUFFERS_PER_CLOCK_SWEEP_PARTITION	128
+
+/* GUC variable */
+int			clock_sweep_partitions = 1;
 
 /*
- * The shared freelist control information.
+ * Per-partition replacement state.
+ *
+ * The buffer pool is split into clock_sweep_partitions contiguous ranges of
+ * buffer ids, each with its own clock hand and freelist, so that backends
+ * looking for a victim buffer don't all hammer on the same cache line.  With
+ * the default of a single partition this is the classic global clock sweep.
  */
 typedef struct
 {
-	/* Spinlock: protects the values below */
-	slock_t		buffer_strategy_lock;
+	/* Spinlock: protects freelist links and completePasses */
+	slock_t		lock;
+
+	/* Range of buffers covered by this partition; fixed after startup */
+	int			firstBuffer;
+	int			numBuffers;
 
 	/*
-	 * Clock sweep hand: index of next buffer to consider grabbing. Note that
-	 * this isn't a concrete buffer - we only ever increase the value. So, to
-	 * get an actual buffer, it needs to be used modulo NBuffers.
+	 * Clock sweep hand: index of next buffer to consider grabbing, relative
+	 * to firstBuffer.  Like the global hand of old, this isn't a concrete
+	 * buffer - we only ever increase the value.  So, to get an actual buffer,
+	 * it needs to be used modulo numBuffers.
 	 */
 	pg_atomic_uint32 nextVictimBuffer;
 
@@ -47,11 +65,40 @@ typedef struct
 	 * when the list is empty)
 	 */
 
+	uint32		completePasses; /* Complete cycles of the clock sweep */
+
+	/*
+	 * Cumulative statistics for monitoring, never reset.  numRemoteAllocs
+	 * counts the victims handed to backends whose home partition is a
+	 * different one, which happens when the home partition runs out of
+	 * unpinned buffers.
+	 */
+	pg_atomic_uint64 numAllocs;
+	pg_atomic_uint64 numRemoteAllocs;
+} ClockSweepPartition;
+
+/* Pad each partition to a cache line, so the hands don't share one */
+typedef union ClockSweepPartitionPadded
+{
+	ClockSweepPartition part;
+	char		pad[PG_CACHE_LINE_SIZE];
+} ClockSweepPartitionPadded;
+
+/*
+ * The shared freelist control information.
+ */
+typedef struct
+{
+	/* Spinlock: protects bgwprocno */
+	slock_t		buffer_strategy_lock;
+
+	/* Number of partitions in use, see StrategyNumPartitions() */
+	int			numPartitions;
+
 	/*
 	 * Statistics.  These counters should be wide enough that they can't
 	 * overflow during a single bgwriter cycle.
 	 */
-	uint32		completePasses; /* Complete cycles of the clock sweep */
 	pg_atomic_uint32 numBufferAllocs;	/* Buffers allocated since last reset */
 
 	/*
@@ -63,6 +110,9 @@ typedef struct
 
 /* Pointers to shared state */
 static BufferStrategyControl *StrategyControl = NULL;
+static ClockSweepPartitionPadded *StrategyPartitions = NULL;
+
+#define GetClockSweepPartition(i)	(&StrategyPartitions[(i)].part)
 
 /*
  * Private (non-shared) state for managing a ring of shared buffers to re-use.
@@ -97,15 +147,16 @@ static BufferDesc *GetBufferFromRing(BufferAccessStrategy strategy,
 									 uint32 *buf_state);
 static void AddBufferToRing(BufferAccessStrategy strategy,
 							BufferDesc *buf);
+static int	StrategyComputeNumPartitions(void);
 
 /*
  * ClockSweepTick - Helper routine for StrategyGetBuffer()
  *
- * Move the clock hand one buffer ahead of its current position and return the
- * id of the buffer now under the hand.
+ * Move the clock hand of the given partition one buffer ahead of its current
+ * position and return the id of the buffer now under the hand.
  */
 static inline uint32
-ClockSweepTick(void)
+ClockSweepTick(ClockSweepPartition *part)
 {
 	uint32		victim;
 
@@ -115,14 +166,14 @@ ClockSweepTick(void)
 	 * apparent order.
 	 */
 	victim =
-		pg_atomic_fetch_add_u32(&StrategyControl->nextVictimBuffer, 1);
+		pg_atomic_fetch_add_u32(&part->nextVictimBuffer, 1);
 
-	if (victim >= NBuffers)
+	if (victim >= part->numBuffers)
 	{
 		uint32		originalVictim = victim;
 
 		/* always wrap what we look up in BufferDescriptors */
-		victim = victim % NBuffers;
+		victim = victim % part->numBuffers;
 
 		/*
 		 * If we're the one that just caused a wraparound, force
@@ -148,19 +199,59 @@ ClockSweepTick(void)
 				 * could lead to an overflow of nextVictimBuffers, but that's
 				 * highly unlikely and wouldn't be particularly harmful.
 				 */
-				SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+				SpinLockAcquire(&part->lock);
 
-				wrapped = expected % NBuffers;
+				wrapped = expected % part->numBuffers;
 
-				success = pg_atomic_compare_exchange_u32(&StrategyControl->nextVictimBuffer,
+				success = pg_atomic_compare_exchange_u32(&part->nextVictimBuffer,
 														 &expected, wrapped);
 				if (success)
-					StrategyControl->completePasses++;
-				SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+					part->completePasses++;
+				SpinLockRelease(&part->lock);
 			}
 		}
 	}
-	return victim;
+	return part->firstBuffer + victim;
+}
+
+/*
+ * StrategyHomePartition -- the partition this backend sweeps first
+ *
+ * Backends are spread over the partitions by their PGPROC number, so that
+ * concurrently running backends mostly advance different clock hands.
+ */
+static inline int
+StrategyHomePartition(void)
+{
+	if (StrategyControl->numPartitions == 1 || MyProc == NULL)
+		return 0;
+
+	return MyProc->pgprocno % StrategyControl->numPartitions;
+}
+
+/*
+ * StrategyPartitionForBuffer -- the partition a buffer id belongs to
+ *
+ * Partition i covers buffer ids [ceil(i * NBuffers / n),
+ * ceil((i + 1) * NBuffers / n)), which makes the reverse mapping a simple
+ * division.
+ */
+static inline int
+StrategyPartitionForBuffer(int buf_id)
+{
+	return (int) (((uint64) buf_id * StrategyControl->numPartitions) /
+				  NBuffers);
+}
+
+/*
+ * ClockSweepCountAlloc -- account a victim buffer to its partition
+ */
+static inline void
+ClockSweepCountAlloc(ClockSweepPartition *part, bool remote)
+{
+	pg_atomic_fetch_add_u64(&part->numAllocs, 1);
+	if (remote)
+		pg_atomic_fetch_add_u64(&part->numRemoteAllocs, 1);
 }
 
 /*
@@ -174,10 +265,138 @@ ClockSweepTick(void)
 bool
 have_free_buffer(void)
 {
-	if (StrategyControl->firstFreeBuffer >= 0)
-		return true;
-	else
-		return false;
+	for (int i = 0; i < StrategyControl->numPartitions; i++)
+	{
+		if (GetClockSweepPartition(i)->firstFreeBuffer >= 0)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * GetBufferFromFreelist -- pop a usable buffer off a partition's freelist
+ *
+ * Returns NULL if the freelist is (or becomes) empty.  On success, the buffer
+ * header spinlock is held on the returned buffer.
+ */
+static BufferDesc *
+GetBufferFromFreelist(ClockSweepPartition *part, uint32 *buf_state)
+{
+	BufferDesc *buf;
+	uint32		local_buf_state;	/* to avoid repeated (de-)referencing */
+
+	/*
+	 * First check, without acquiring the lock, whether there's buffers in the
+	 * freelist. Since we otherwise don't require the spinlock in every
+	 * StrategyGetBuffer() invocation, it'd be sad to acquire it here -
+	 * uselessly in most cases. That obviously leaves a race where a buffer is
+	 * put on the freelist but we don't see the store yet - but that's pretty
+	 * harmless, it'll just get used during the next buffer acquisition.
+	 *
+	 * If there's buffers on the freelist, acquire the spinlock to pop one
+	 * buffer of the freelist. Then check whether that buffer is usable and
+	 * repeat if not.
+	 *
+	 * Note that the freeNext fields are considered to be protected by the
+	 * partition's spinlock not the individual buffer spinlocks, so it's OK to
+	 * manipulate them without holding the buffer header spinlock.
+	 */
+	if (part->firstFreeBuffer < 0)
+		return NULL;
+
+	while (true)
+	{
+		/* Acquire the spinlock to remove element from the freelist */
+		SpinLockAcquire(&part->lock);
+
+		if (part->firstFreeBuffer < 0)
+		{
+			SpinLockRelease(&part->lock);
+			return NULL;
+		}
+
+		buf = GetBufferDescriptor(part->firstFreeBuffer);
+		Assert(buf->freeNext != FREENEXT_NOT_IN_LIST);
+
+		/* Unconditionally remove buffer from freelist */
+		part->firstFreeBuffer = buf->freeNext;
+		buf->freeNext = FREENEXT_NOT_IN_LIST;
+
+		/*
+		 * Release the lock so someone else can access the freelist while we
+		 * check out this buffer.
+		 */
+		SpinLockRelease(&part->lock);
+
+		/*
+		 * If the buffer is pinned or has a nonzero usage_count, we cannot use
+		 * it; discard it and retry.  (This can only happen if VACUUM put a
+		 * valid buffer in the freelist and then someone else used it before
+		 * we got to it.  It's probably impossible altogether as of 8.3, but
+		 * we'd better check anyway.)
+		 */
+		local_buf_state = LockBufHdr(buf);
+		if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0
+			&& BUF_STATE_GET_USAGECOUNT(local_buf_state) == 0)
+		{
+			*buf_state = local_buf_state;
+			return buf;
+		}
+		UnlockBufHdr(buf, local_buf_state);
+	}
+}
+
+/*
+ * GetBufferFromClockSweep -- run the clock sweep over one partition
+ *
+ * Returns NULL if a full pass over the partition found only pinned buffers.
+ * On success, the buffer header spinlock is held on the returned buffer.
+ */
+static BufferDesc *
+GetBufferFromClockSweep(ClockSweepPartition *part, uint32 *buf_state)
+{
+	BufferDesc *buf;
+	int			trycounter;
+	uint32		local_buf_state;	/* to avoid repeated (de-)referencing */
+
+	trycounter = part->numBuffers;
+	for (;;)
+	{
+		buf = GetBufferDescriptor(ClockSweepTick(part));
+
+		/*
+		 * If the buffer is pinned or has a nonzero usage_count, we cannot use
+		 * it; decrement the usage_count (unless pinned) and keep scanning.
+		 */
+		local_buf_state = LockBufHdr(buf);
+
+		if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0)
+		{
+			if (BUF_STATE_GET_USAGECOUNT(local_buf_state) != 0)
+			{
+				local_buf_state -= BUF_USAGECOUNT_ONE;
+
+				trycounter = part->numBuffers;
+			}
+			else
+			{
+				/* Found a usable buffer */
+				*buf_state = local_buf_state;
+				return buf;
+			}
+		}
+		else if (--trycounter == 0)
+		{
+			/*
+			 * We've scanned all the buffers of this partition without making
+			 * any state changes, so all of them are pinned (or were when we
+			 * looked at them).  Let the caller try elsewhere.
+			 */
+			UnlockBufHdr(buf, local_buf_state);
+			return NULL;
+		}
+		UnlockBufHdr(buf, local_buf_state);
+	}
 }
 
 /*
@@ -197,8 +416,8 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state, bool *from_r
 {
 	BufferDesc *buf;
 	int			bgwprocno;
-	int			trycounter;
-	uint32		local_buf_state;	/* to avoid repeated (de-)referencing */
+	int			nparts = StrategyControl->numPartitions;
+	int			home;
 
 	*from_ring = false;
 
@@ -250,110 +469,54 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state, bool *from_r
 	pg_atomic_fetch_add_u32(&StrategyControl->numBufferAllocs, 1);
 
 	/*
-	 * First check, without acquiring the lock, whether there's buffers in the
-	 * freelist. Since we otherwise don't require the spinlock in every
-	 * StrategyGetBuffer() invocation, it'd be sad to acquire it here -
-	 * uselessly in most cases. That obviously leaves a race where a buffer is
-	 * put on the freelist but we don't see the store yet - but that's pretty
-	 * harmless, it'll just get used during the next buffer acquisition.
-	 *
-	 * If there's buffers on the freelist, acquire the spinlock to pop one
-	 * buffer of the freelist. Then check whether that buffer is usable and
-	 * repeat if not.
-	 *
-	 * Note that the freeNext fields are considered to be protected by the
-	 * buffer_strategy_lock not the individual buffer spinlocks, so it's OK to
-	 * manipulate them without holding the spinlock.
+	 * Prefer completely unused buffers.  Free buffers only exist in numbers
+	 * shortly after startup or after relations have been dropped, so it's
+	 * fine to look at every partition's freelist, starting with our own.
 	 */
-	if (StrategyControl->firstFreeBuffer >= 0)
+	home = StrategyHomePartition();
+	for (int i = 0; i < nparts; i++)
 	{
-		while (true)
-		{
-			/* Acquire the spinlock to remove element from the freelist */
-			SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
-
-			if (StrategyControl->firstFreeBuffer < 0)
-			{
-				SpinLockRelease(&StrategyControl->buffer_strategy_lock);
-				break;
-			}
+		int			partno = (home + i) % nparts;
+		ClockSweepPartition *part = GetClockSweepPartition(partno);
 
-			buf = GetBufferDescriptor(StrategyControl->firstFreeBuffer);
-			Assert(buf->freeNext != FREENEXT_NOT_IN_LIST);
-
-			/* Unconditionally remove buffer from freelist */
-			StrategyControl->firstFreeBuffer = buf->freeNext;
-			buf->freeNext = FREENEXT_NOT_IN_LIST;
-
-			/*
-			 * Release the lock so someone else can access the freelist while
-			 * we check out this buffer.
-			 */
-			SpinLockRelease(&StrategyControl->buffer_strategy_lock);
-
-			/*
-			 * If the buffer is pinned or has a nonzero usage_count, we cannot
-			 * use it; discard it and retry.  (This can only happen if VACUUM
-			 * put a valid buffer in the freelist and then someone else used
-			 * it before we got to it.  It's probably impossible altogether as
-			 * of 8.3, but we'd better check anyway.)
-			 */
-			local_buf_state = LockBufHdr(buf);
-			if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0
-				&& BUF_STATE_GET_USAGECOUNT(local_buf_state) == 0)
-			{
-				if (strategy != NULL)
-					AddBufferToRing(strategy, buf);
-				*buf_state = local_buf_state;
-				return buf;
-			}
-			UnlockBufHdr(buf, local_buf_state);
+		buf = GetBufferFromFreelist(part, buf_state);
+		if (buf != NULL)
+		{
+			if (strategy != NULL)
+				AddBufferToRing(strategy, buf);
+			ClockSweepCountAlloc(part, partno != home);
+			return buf;
 		}
 	}
 
-	/* Nothing on the freelist, so run the "clock sweep" algorithm */
-	trycounter = NBuffers;
-	for (;;)
+	/*
+	 * Nothing on the freelists, so run the "clock sweep" algorithm over our
+	 * home partition.  Only if every buffer in it is pinned do we move on to
+	 * sweep the other partitions.
+	 */
+	for (int i = 0; i < nparts; i++)
 	{
-		buf = GetBufferDescriptor(ClockSweepTick());
+		int			partno = (home + i) % nparts;
+		ClockSweepPartition *part = GetClockSweepPartition(partno);
 
-		/*
-		 * If the buffer is pinned or has a nonzero usage_count, we cannot use
-		 * it; decrement the usage_count (unless pinned) and keep scanning.
-		 */
-		local_buf_state = LockBufHdr(buf);
-
-		if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0)
-		{
-			if (BUF_STATE_GET_USAGECOUNT(local_buf_state) != 0)
-			{
-				local_buf_state -= BUF_USAGECOUNT_ONE;
-
-				trycounter = NBuffers;
-			}
-			else
-			{
-				/* Found a usable buffer */
-				if (strategy != NULL)
-					AddBufferToRing(strategy, buf);
-				*buf_state = local_buf_state;
-				return buf;
-			}
-		}
-		else if (--trycounter == 0)
+		buf = GetBufferFromClockSweep(part, buf_state);
+		if (buf != NULL)
 		{
-			/*
-			 * We've scanned all the buffers without making any state changes,
-			 * so all the buffers are pinned (or were when we looked at them).
-			 * We could hope that someone will free one eventually, but it's
-			 * probably better to fail than to risk getting stuck in an
-			 * infinite loop.
-			 */
-			UnlockBufHdr(buf, local_buf_state);
-			elog(ERROR, "no unpinned buffers available");
+			if (strategy != NULL)
+				AddBufferToRing(strategy, buf);
+			ClockSweepCountAlloc(part, partno != home);
+			return buf;
 		}
-		UnlockBufHdr(buf, local_buf_state);
 	}
+
+	/*
+	 * We've scanned all the buffers without making any state changes, so all
+	 * the buffers are pinned (or were when we looked at them).  We could hope
+	 * that someone will free one eventually, but it's probably better to fail
+	 * than to risk getting stuck in an infinite loop.
+	 */
+	elog(ERROR, "no unpinned buffers available");
+	return NULL;				/* keep compiler quiet */
 }
 
 /*
@@ -362,7 +525,11 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state, bool *from_r
 void
 StrategyFreeBuffer(BufferDesc *buf)
 {
-	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+	ClockSweepPartition *part;
+
+	part = GetClockSweepPartition(StrategyPartitionForBuffer(buf->buf_id));
+
+	SpinLockAcquire(&part->lock);
 
 	/*
 	 * It is possible that we are told to put something in the freelist that
@@ -370,13 +537,13 @@ StrategyFreeBuffer(BufferDesc *buf)
 	 */
 	if (buf->freeNext == FREENEXT_NOT_IN_LIST)
 	{
-		buf->freeNext = StrategyControl->firstFreeBuffer;
+		buf->freeNext = part->firstFreeBuffer;
 		if (buf->freeNext < 0)
-			StrategyControl->lastFreeBuffer = buf->buf_id;
-		StrategyControl->firstFreeBuffer = buf->buf_id;
+			part->lastFreeBuffer = buf->buf_id;
+		part->firstFreeBuffer = buf->buf_id;
 	}
 
-	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+	SpinLockRelease(&part->lock);
 }
 
 /*
@@ -389,34 +556,92 @@ StrategyFreeBuffer(BufferDesc *buf)
  * the higher-order bits of nextVictimBuffer) and the count of recent buffer
  * allocs if non-NULL pointers are passed.  The alloc count is reset after
  * being read.
+ *
+ * With more than one clock sweep partition there is no single hand, so we
+ * report the average progress of all partitions' hands mapped onto the whole
+ * buffer array.  That's only an approximation of where the next victims will
+ * come from, but all the bgwriter uses it for is to pace its own sweep.
  */
 int
 StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc)
 {
-	uint32		nextVictimBuffer;
-	int			result;
-
-	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
-	nextVictimBuffer = pg_atomic_read_u32(&StrategyControl->nextVictimBuffer);
-	result = nextVictimBuffer % NBuffers;
+	int			nparts = StrategyControl->numPartitions;
+	uint64		sum_passes = 0;
+	uint64		sum_offsets = 0;
+	uint64		position;
 
-	if (complete_passes)
+	for (int i = 0; i < nparts; i++)
 	{
-		*complete_passes = StrategyControl->completePasses;
+		ClockSweepPartition *part = GetClockSweepPartition(i);
+		uint32		nextVictimBuffer;
+		uint32		passes;
+
+		SpinLockAcquire(&part->lock);
+		nextVictimBuffer = pg_atomic_read_u32(&part->nextVictimBuffer);
+		passes = part->completePasses;
+		SpinLockRelease(&part->lock);
 
 		/*
 		 * Additionally add the number of wraparounds that happened before
 		 * completePasses could be incremented. C.f. ClockSweepTick().
 		 */
-		*complete_passes += nextVictimBuffer / NBuffers;
+		passes += nextVictimBuffer / part->numBuffers;
+
+		sum_passes += passes;
+		/* position of this partition's hand, scaled to the whole pool */
+		sum_offsets += (uint64) (nextVictimBuffer % part->numBuffers) *
+			NBuffers / part->numBuffers;
 	}
 
+	/* average position, taking care to carry fractional passes over */
+	position = ((sum_passes % nparts) * NBuffers + sum_offsets) / nparts;
+
+	if (complete_passes)
+		*complete_passes = (uint32) (sum_passes / nparts + position / NBuffers);
+
 	if (num_buf_alloc)
 	{
 		*num_buf_alloc = pg_atomic_exchange_u32(&StrategyControl->numBufferAllocs, 0);
 	}
-	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
-	return result;
+	return (int) (position % NBuffers);
+}
+
+/*
+ * StrategyNumPartitions -- number of clock sweep partitions in use
+ */
+int
+StrategyNumPartitions(void)
+{
+	return StrategyControl->numPartitions;
+}
+
+/*
+ * StrategyGetPartitionStats -- report the state of one clock sweep partition
+ *
+ * This is meant for monitoring only; the values aren't read atomically with
+ * respect to each other.
+ */
+void
+StrategyGetPartitionStats(int partno, ClockSweepPartitionStats *stats)
+{
+	ClockSweepPartition *part;
+	uint32		nextVictimBuffer;
+
+	Assert(partno >= 0 && partno < StrategyControl->numPartitions);
+	part = GetClockSweepPartition(partno);
+
+	SpinLockAcquire(&part->lock);
+	nextVictimBuffer = pg_atomic_read_u32(&part->nextVictimBuffer);
+	stats->complete_passes = part->completePasses +
+		nextVictimBuffer / part->numBuffers;
+	SpinLockRelease(&part->lock);
+
+	stats->first_buffer = part->firstBuffer;
+	stats->num_buffers = part->numBuffers;
+	stats->next_victim_buffer = part->firstBuffer +
+		nextVictimBuffer % part->numBuffers;
+	stats->num_allocs = pg_atomic_read_u64(&part->numAllocs);
+	stats->num_remote_allocs = pg_atomic_read_u64(&part->numRemoteAllocs);
 }
 
 /*
@@ -460,9 +685,30 @@ StrategyShmemSize(void)
 	/* size of the shared replacement strategy control block */
 	size = add_size(size, MAXALIGN(sizeof(BufferStrategyControl)));
 
+	/* size of the clock sweep partitions */
+	size = add_size(size, mul_size(StrategyComputeNumPartitions(),
+								   sizeof(ClockSweepPartitionPadded)));
+
 	return size;
 }
 
+/*
+ * StrategyComputeNumPartitions -- number of clock sweep partitions to use
+ *
+ * This is clock_sweep_partitions, reduced if needed to keep partitions of a
+ * reasonable minimum size.
+ */
+static int
+StrategyComputeNumPartitions(void)
+{
+	int			nparts;
+
+	nparts = Min(clock_sweep_partitions,
+				 NBuffers / MIN_BUFFERS_PER_CLOCK_SWEEP_PARTITION);
+
+	return Max(nparts, 1);
+}
+
 /*
  * StrategyInitialize -- initialize the buffer cache replacement
  *		strategy.
@@ -474,6 +720,8 @@ void
 StrategyInitialize(bool init)
 {
 	bool		found;
+	bool		foundParts;
+	int			nparts = StrategyComputeNumPartitions();
 
 	/*
 	 * Initialize the shared buffer lookup hashtable.
@@ -495,27 +743,58 @@ StrategyInitialize(bool init)
 						sizeof(BufferStrategyControl),
 						&found);
 
+	StrategyPartitions = (ClockSweepPartitionPadded *)
+		ShmemInitStruct("Buffer Strategy Partitions",
+						mul_size(nparts, sizeof(ClockSweepPartitionPadded)),
+						&foundParts);
+
 	if (!found)
 	{
 		/*
 		 * Only done once, usually in postmaster
 		 */
 		Assert(init);
+		Assert(!foundParts);
 
 		SpinLockInit(&StrategyControl->buffer_strategy_lock);
 
-		/*
-		 * Grab the whole linked list of free buffers for our strategy. We
-		 * assume it was previously set up by InitBufferPool().
-		 */
-		StrategyControl->firstFreeBuffer = 0;
-		StrategyControl->lastFreeBuffer = NBuffers - 1;
+		StrategyControl->numPartitions = nparts;
+
+		for (int i = 0; i < nparts; i++)
+		{
+			ClockSweepPartition *part = GetClockSweepPartition(i);
+			int			first;
+			int			last;
+
+			/* see StrategyPartitionForBuffer() for the mapping */
+			first = (int) (((uint64) i * NBuffers + nparts - 1) / nparts);
+			last = (int) (((uint64) (i + 1) * NBuffers + nparts - 1) / nparts) - 1;
 
-		/* Initialize the clock sweep pointer */
-		pg_atomic_init_u32(&StrategyControl->nextVictimBuffer, 0);
+			SpinLockInit(&part->lock);
+
+			part->firstBuffer = first;
+			part->numBuffers = last - first + 1;
+
+			/*
+			 * Grab this partition's share of the linked list of free buffers.
+			 * We assume it was previously set up by InitBufferPool(), with
+			 * all buffers linked in order, so we only need to cut the list at
+			 * the partition boundary.
+			 */
+			part->firstFreeBuffer = first;
+			part->lastFreeBuffer = last;
+			GetBufferDescriptor(last)->freeNext = FREENEXT_END_OF_LIST;
+
+			/* Initialize the clock sweep pointer */
+			pg_atomic_init_u32(&part->nextVictimBuffer, 0);
+
+			/* Clear statistics */
+			part->completePasses = 0;
+			pg_atomic_init_u64(&part->numAllocs, 0);
+			pg_atomic_init_u64(&part->numRemoteAllocs, 0);
+		}
 
 		/* Clear statistics */
-		StrategyControl->completePasses = 0;
 		pg_atomic_init_u32(&StrategyControl->numBufferAllocs, 0);
 
 		/* No pending notification */
@@ -255,6 +255,8 @@ GetLocalVictimBuffer(void)
 		/* Temporary table I/O does not use Buffer Access Strategies */
 		pgstat_count_io_op_time(IOOBJECT_TEMP_RELATION, IOCONTEXT_NORMAL,
 								IOOP_WRITE, io_start, 1);
+		pgstat_count_io_write_requests(IOOBJECT_TEMP_RELATION,
+									   IOCONTEXT_NORMAL, 1);
 
 		/* Mark not-dirty now in case we error out below */
 		buf_state &= ~BM_DIRTY;
@@ -285,7 +287,7 @@ GetLocalVictimBuffer(void)
 }
 
 /* see LimitAdditionalPins() */
-static void
+void
 LimitAdditionalLocalPins(uint32 *additional_pins)
 {
 	uint32		max_pins;
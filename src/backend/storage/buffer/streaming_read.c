@@ -0,0 +1,286 @@
+/*-------------------------------------------------------------------------
+ *
+ * streaming_read.c
+ *	  Look-ahead buffer reads with I/O combining.
+ *
+ * A StreamingRead hands out pinned buffers for a sequence of blocks that is
+ * produced by a caller-supplied callback.  Because the stream asks for block
+ * numbers ahead of the time they are consumed, it can
+ *
+ * 1.  combine runs of consecutive blocks into a single vectored read of up
+ *	   to io_combine_limit blocks (see ReadBufferBatch()), and
+ *
+ * 2.  issue prefetch advice for blocks that are further ahead in the
+ *	   sequence but can't be covered by sequential read-ahead in the kernel,
+ *	   ie. the first block of every non-sequential jump.
+ *
+ * The look-ahead queue holds block numbers only; buffers are pinned just for
+ * the run that is currently being consumed, so a stream never holds more
+ * than io_combine_limit pins (further capped by LimitAdditionalPins() and
+ * by the size of the access strategy's ring, if any).
+ *
+ * When the I/O layer can have several reads in flight at once (io_method =
+ * io_uring), prefetch advice is pointless.  Instead the stream pins up to
+ * effective_io_concurrency runs at a time and reads them all with a single
+ * ReadBufferBatch() call, so the pin budget grows accordingly.
+ *
+ * The callback may have side effects, such as claiming blocks of a parallel
+ * scan or reporting the position of a synchronized scan.  It is never
+ * called again after returning InvalidBlockNumber, until the stream is
+ * reset.
+ *
+ * Portions Copyright (c) 1996-2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/buffer/streaming_read.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "storage/buf_internals.h"
+#include "storage/fd.h"
+#include "storage/streaming_read.h"
+#include "utils/rel.h"
+#include "utils/spccache.h"
+
+struct StreamingRead
+{
+	Relation	rel;
+	ForkNumber	forknum;
+	BufferAccessStrategy strategy;
+	StreamingReadBlockCB callback;
+	void	   *callback_private_data;
+
+	int			max_combine;	/* max blocks per run */
+	int			max_batch;		/* max blocks per ReadBufferBatch() call */
+	int			prefetch_distance;	/* 0 disables prefetch advice */
+	bool		exhausted;		/* callback returned InvalidBlockNumber */
+
+	/*
+	 * Circular queue of block numbers returned by the callback, but not yet
+	 * pinned.  last_queued is the most recently queued block, used to detect
+	 * non-sequential jumps that are worth prefetching.
+	 */
+	BlockNumber *queue;
+	int			queue_size;
+	int			queue_head;
+	int			queue_count;
+	BlockNumber last_queued;
+
+	/* buffers pinned by the last ReadBufferBatch() call, not yet returned */
+	int			nbuffers;
+	int			next_buffer;
+	Buffer		buffers[MAX_READ_BATCH_BUFFERS];
+};
+
+/*
+ * Ask the callback for more block numbers until the look-ahead queue is
+ * full or the callback reports the end of the sequence.
+ */
+static void
+streaming_read_fill_queue(StreamingRead *stream)
+{
+	while (!stream->exhausted && stream->queue_count < stream->queue_size)
+	{
+		BlockNumber blocknum;
+		int			tail;
+
+		blocknum = stream->callback(stream, stream->callback_private_data);
+		if (blocknum == InvalidBlockNumber)
+		{
+			stream->exhausted = true;
+			break;
+		}
+
+		/*
+		 * Sequential runs are read with vectored I/O and benefit from kernel
+		 * read-ahead; only the start of a jump needs an explicit hint.
+		 */
+		if (stream->prefetch_distance > 0 &&
+			stream->max_batch == stream->max_combine &&
+			stream->queue_count >= stream->max_combine &&
+			(stream->last_queued == InvalidBlockNumber ||
+			 blocknum != stream->last_queued + 1))
+			PrefetchBuffer(stream->rel, stream->forknum, blocknum);
+
+		tail = (stream->queue_head + stream->queue_count) % stream->queue_size;
+		stream->queue[tail] = blocknum;
+		stream->queue_count++;
+		stream->last_queued = blocknum;
+	}
+}
+
+/*
+ * Create a new streaming read for the given relation fork.  The strategy
+ * must stay valid until streaming_read_end() is called.
+ */
+StreamingRead *
+streaming_read_begin(Relation rel,
+					 ForkNumber forknum,
+					 BufferAccessStrategy strategy,
+					 StreamingReadBlockCB callback,
+					 void *callback_private_data)
+{
+	StreamingRead *stream;
+	uint32		max_combine = io_combine_limit;
+	uint32		max_batch;
+	int			prefetch_distance;
+	int			io_concurrency;
+
+	io_concurrency = RelationUsesLocalBuffers(rel) ? 0 :
+		get_tablespace_io_concurrency(rel->rd_rel->reltablespace);
+
+	/* With asynchronous I/O, read several runs per batch */
+	if (FileIOBatchIsAsync())
+		max_batch = Min(max_combine * Max(io_concurrency, 1),
+						MAX_READ_BATCH_BUFFERS);
+	else
+		max_batch = max_combine;
+
+	/* Don't let one stream take more than its fair share of pins */
+	if (RelationUsesLocalBuffers(rel))
+		LimitAdditionalLocalPins(&max_batch);
+	else
+		LimitAdditionalPins(&max_batch);
+
+	/*
+	 * Leave room in a strategy ring for the caller's own pin and for buffers
+	 * that are still being written out; reading the whole ring at once would
+	 * just cause us to evict our own pages.
+	 */
+	if (strategy != NULL)
+		max_batch = Min(max_batch,
+						GetAccessStrategyBufferCount(strategy) / 2);
+
+	max_batch = Max(max_batch, 1);
+	max_combine = Min(max_combine, max_batch);
+	Assert(max_batch <= MAX_READ_BATCH_BUFFERS);
+
+#ifdef USE_PREFETCH
+	prefetch_distance = max_batch > max_combine ? 0 : io_concurrency;
+#else
+	prefetch_distance = 0;
+#endif
+
+	stream = palloc0(sizeof(StreamingRead));
+	stream->rel = rel;
+	stream->forknum = forknum;
+	stream->strategy = strategy;
+	stream->callback = callback;
+	stream->callback_private_data = callback_private_data;
+	stream->max_combine = max_combine;
+	stream->max_batch = max_batch;
+	stream->prefetch_distance = prefetch_distance;
+	stream->queue_size = max_batch + prefetch_distance;
+	stream->queue = palloc(sizeof(BlockNumber) * stream->queue_size);
+	stream->last_queued = InvalidBlockNumber;
+
+	return stream;
+}
+
+/*
+ * Return the next buffer of the stream, pinned, or InvalidBuffer if the
+ * callback has reported the end of the sequence.  The caller is responsible
+ * for releasing the pin.
+ */
+Buffer
+streaming_read_next_buffer(StreamingRead *stream)
+{
+	BlockNumber blocks[MAX_READ_BATCH_BUFFERS];
+	int			nblocks;
+
+	if (stream->next_buffer < stream->nbuffers)
+		return stream->buffers[stream->next_buffer++];
+
+	streaming_read_fill_queue(stream);
+
+	if (stream->queue_count == 0)
+		return InvalidBuffer;
+
+	/*
+	 * Without asynchronous I/O, take just the run of consecutive blocks at
+	 * the head of the queue.  Otherwise take as many queued blocks as a batch
+	 * allows; ReadBufferBatch() splits them into runs and has all of them in
+	 * flight at once.
+	 */
+	blocks[0] = stream->queue[stream->queue_head];
+	nblocks = 1;
+	while (nblocks < stream->queue_count && nblocks < stream->max_batch)
+	{
+		BlockNumber next;
+
+		next = stream->queue[(stream->queue_head + nblocks) % stream->queue_size];
+		if (stream->max_batch == stream->max_combine &&
+			next != blocks[0] + nblocks)
+			break;
+		blocks[nblocks++] = next;
+	}
+
+	ReadBufferBatch(stream->rel, stream->forknum, stream->strategy,
+					blocks, nblocks, stream->buffers);
+
+	stream->queue_head = (stream->queue_head + nblocks) % stream->queue_size;
+	stream->queue_count -= nblocks;
+	stream->nbuffers = nblocks;
+	stream->next_buffer = 1;
+
+	return stream->buffers[0];
+}
+
+/*
+ * Start reading the block that the next streaming_read_next_buffer() call
+ * will return, and report whether that call can return without waiting for
+ * I/O.  This lets a caller that has other work to do, such as asynchronous
+ * execution with several scans, come back later instead of blocking now.
+ *
+ * Only the first block of the next run is considered; the rest of the run
+ * is read by the same vectored read, so it costs no additional wait.
+ */
+bool
+streaming_read_prefetch_next(StreamingRead *stream)
+{
+	if (stream->next_buffer < stream->nbuffers)
+		return true;
+
+	streaming_read_fill_queue(stream);
+
+	/* at the end of the stream, there's nothing to wait for */
+	if (stream->queue_count == 0)
+		return true;
+
+	return !PrefetchBuffer(stream->rel, stream->forknum,
+						   stream->queue[stream->queue_head]).initiated_io;
+}
+
+/*
+ * Release all buffers and queued blocks, so that the stream can be reused
+ * from the beginning.  The callback will be invoked again on the next call
+ * to streaming_read_next_buffer().
+ */
+void
+streaming_read_reset(StreamingRead *stream)
+{
+	while (stream->next_buffer < stream->nbuffers)
+		ReleaseBuffer(stream->buffers[stream->next_buffer++]);
+
+	stream->nbuffers = 0;
+	stream->next_buffer = 0;
+	stream->queue_head = 0;
+	stream->queue_count = 0;
+	stream->last_queued = InvalidBlockNumber;
+	stream->exhausted = false;
+}
+
+/*
+ * Release all resources held by the stream.
+ */
+void
+streaming_read_end(StreamingRead *stream)
+{
+	streaming_read_reset(stream);
+	pfree(stream->queue);
+	pfree(stream);
+}
@@ -84,6 +84,9 @@
 #include <limits.h>
 #include <unistd.h>
 #include <fcntl.h>
+#ifdef USE_LIBURING
+#include <liburing.h>
+#endif
 
 #include "access/xact.h"
 #include "access/xlog.h"
@@ -97,8 +100,10 @@
 #include "postmaster/startup.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
+#include "storage/latch.h"
 #include "utils/guc.h"
 #include "utils/guc_hooks.h"
+#include "utils/memutils.h"
 #include "utils/resowner_private.h"
 #include "utils/varlena.h"
 
@@ -167,6 +172,9 @@ int			recovery_init_sync_method = RECOVERY_INIT_SYNC_METHOD_FSYNC;
 /* Which kinds of files should be opened with PG_O_DIRECT. */
 int			io_direct_flags;
 
+/* How FileIOBatch() performs its I/O. */
+int			io_method = IOMETHOD_SYNC;
+
 /* Debugging.... */
 
 #ifdef FDDEBUG
@@ -289,6 +297,25 @@ static Oid *tempTableSpaces = NULL;
 static int	numTempTableSpaces = -1;
 static int	nextTempTableSpace = 0;
 
+#ifdef USE_LIBURING
+/*
+ * io_uring instance used by FileIOBatch() when io_method = io_uring.  It is
+ * set up the first time it's needed in each process.  If that fails, e.g.
+ * because the kernel doesn't support io_uring or it has been disabled, we
+ * complain once and fall back to synchronous I/O for the rest of the
+ * process's life.
+ *
+ * FileIORing waits for completions through a WaitEventSet, so that the time
+ * spent is reported as a wait event and we notice postmaster death.
+ */
+#define FILE_IO_URING_DEPTH 64
+
+static struct io_uring FileIORing;
+static WaitEventSet *FileIORingWaitSet = NULL;
+static bool FileIORingReady = false;
+static bool FileIORingFailed = false;
+#endif
+
 
 /*--------------------
  *
@@ -2142,6 +2169,65 @@ retry:
 	return returnCode;
 }
 
+/*
+ * FileReadV -- vectored version of FileRead
+ *
+ * Reads into the iovcnt buffers described by iov, starting at offset.  Like
+ * FileRead(), this may transfer fewer bytes than requested; it's up to the
+ * caller to deal with short reads.
+ */
+ssize_t
+FileReadV(File file, const struct iovec *iov, int iovcnt, off_t offset,
+		  uint32 wait_event_info)
+{
+	ssize_t		returnCode;
+	Vfd		   *vfdP;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileReadV: %d (%s) " INT64_FORMAT " %d",
+			   file, VfdCache[file].fileName,
+			   (int64) offset,
+			   iovcnt));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+	vfdP = &VfdCache[file];
+
+retry:
+	pgstat_report_wait_start(wait_event_info);
+	returnCode = pg_preadv(vfdP->fd, iov, iovcnt, offset);
+	pgstat_report_wait_end();
+
+	if (returnCode < 0)
+	{
+		/*
+		 * See comments in FileRead()
+		 */
+#ifdef WIN32
+		DWORD		error = GetLastError();
+
+		switch (error)
+		{
+			case ERROR_NO_SYSTEM_RESOURCES:
+				pg_usleep(1000L);
+				errno = EINTR;
+				break;
+			default:
+				_dosmaperr(error);
+				break;
+		}
+#endif
+		/* OK to retry if interrupted */
+		if (errno == EINTR)
+			goto retry;
+	}
+
+	return returnCode;
+}
+
 int
 FileWrite(File file, const void *buffer, size_t amount, off_t offset,
 		  uint32 wait_event_info)
@@ -2240,6 +2326,341 @@ retry:
 	return returnCode;
 }
 
+/*
+ * FileWriteV -- vectored version of FileWrite
+ *
+ * Writes the iovcnt buffers described by iov, starting at offset.  Like
+ * FileWrite(), a short write that doesn't set errno is reported as ENOSPC.
+ * This doesn't support temporary files subject to temp_file_limit.
+ */
+ssize_t
+FileWriteV(File file, const struct iovec *iov, int iovcnt, off_t offset,
+		   uint32 wait_event_info)
+{
+	ssize_t		returnCode;
+	size_t		amount = 0;
+	Vfd		   *vfdP;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileWriteV: %d (%s) " INT64_FORMAT " %d",
+			   file, VfdCache[file].fileName,
+			   (int64) offset,
+			   iovcnt));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+	vfdP = &VfdCache[file];
+
+	Assert(!(vfdP->fdstate & FD_TEMP_FILE_LIMIT));
+
+	for (int i = 0; i < iovcnt; i++)
+		amount += iov[i].iov_len;
+
+retry:
+	errno = 0;
+	pgstat_report_wait_start(wait_event_info);
+	returnCode = pg_pwritev(vfdP->fd, iov, iovcnt, offset);
+	pgstat_report_wait_end();
+
+	/* if write didn't set errno, assume problem is no disk space */
+	if (returnCode != amount && errno == 0)
+		errno = ENOSPC;
+
+	if (returnCode < 0)
+	{
+		/*
+		 * See comments in FileRead()
+		 */
+#ifdef WIN32
+		DWORD		error = GetLastError();
+
+		switch (error)
+		{
+			case ERROR_NO_SYSTEM_RESOURCES:
+				pg_usleep(1000L);
+				errno = EINTR;
+				break;
+			default:
+				_dosmaperr(error);
+				break;
+		}
+#endif
+		/* OK to retry if interrupted */
+		if (errno == EINTR)
+			goto retry;
+	}
+
+	return returnCode;
+}
+
+/*
+ * Perform one request of a batch synchronously.
+ */
+static void
+FileIOPerform(FileIORequest *req, uint32 wait_event_info)
+{
+	if (req->is_write)
+		req->result = FileWriteV(req->file, req->iov, req->iovcnt,
+								 req->offset, wait_event_info);
+	else
+		req->result = FileReadV(req->file, req->iov, req->iovcnt,
+								req->offset, wait_event_info);
+	req->error = req->result < 0 ? errno : 0;
+}
+
+#ifdef USE_LIBURING
+/*
+ * Set up this process's io_uring instance, if not done already.  Returns
+ * false if io_uring can't be used.
+ */
+static bool
+FileIORingSetup(void)
+{
+	int			ret;
+
+	if (FileIORingReady)
+		return true;
+	if (FileIORingFailed)
+		return false;
+
+	/* the ring uses a file descriptor of its own */
+	ReserveExternalFD();
+
+	ret = io_uring_queue_init(FILE_IO_URING_DEPTH, &FileIORing, 0);
+	if (ret < 0)
+	{
+		ReleaseExternalFD();
+		FileIORingFailed = true;
+		errno = -ret;
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not set up io_uring, falling back to synchronous I/O: %m")));
+		return false;
+	}
+
+	/*
+	 * If we fail to build the wait event set, leave FileIORingFailed set so
+	 * that we don't try again.
+	 */
+	FileIORingFailed = true;
+	FileIORingWaitSet = CreateWaitEventSet(TopMemoryContext, 2);
+	AddWaitEventToSet(FileIORingWaitSet, WL_SOCKET_READABLE,
+					  FileIORing.ring_fd, NULL, NULL);
+	if (IsUnderPostmaster)
+		AddWaitEventToSet(FileIORingWaitSet, WL_EXIT_ON_PM_DEATH,
+						  PGINVALID_SOCKET, NULL, NULL);
+	FileIORingFailed = false;
+	FileIORingReady = true;
+
+	return true;
+}
+
+/*
+ * Tear down the io_uring instance after a submission failure.  Any requests
+ * that were queued but not submitted are discarded with it.
+ */
+static void
+FileIORingShutdown(void)
+{
+	io_uring_queue_exit(&FileIORing);
+	ReleaseExternalFD();
+	FreeWaitEventSet(FileIORingWaitSet);
+	FileIORingWaitSet = NULL;
+	FileIORingReady = false;
+	FileIORingFailed = true;
+}
+
+/*
+ * Reap one completion from the ring, and record its outcome.
+ *
+ * If 'wait' is false and nothing has completed yet, returns false without
+ * waiting.
+ */
+static bool
+FileIORingReap(bool wait, uint32 wait_event_info)
+{
+	struct io_uring_cqe *cqe;
+	FileIORequest *req;
+	WaitEvent	event;
+	int			ret;
+
+	for (;;)
+	{
+		ret = io_uring_peek_cqe(&FileIORing, &cqe);
+		if (ret != -EAGAIN)
+			break;
+		if (!wait)
+			return false;
+
+		/* nothing has completed yet, sleep until something does */
+		(void) WaitEventSetWait(FileIORingWaitSet, -1, &event, 1,
+								wait_event_info);
+	}
+
+	/* can't happen, and we couldn't wait out the I/O either */
+	if (ret < 0)
+	{
+		errno = -ret;
+		elog(PANIC, "could not get io_uring completion: %m");
+	}
+
+	req = io_uring_cqe_get_data(cqe);
+	ret = cqe->res;
+	io_uring_cqe_seen(&FileIORing, cqe);
+
+	if (ret == -EINTR || ret == -EAGAIN)
+	{
+		/* like the synchronous path, retry interrupted requests */
+		FileIOPerform(req, wait_event_info);
+	}
+	else if (ret < 0)
+	{
+		req->result = -1;
+		req->error = -ret;
+	}
+	else
+	{
+		req->result = ret;
+		req->error = 0;
+	}
+
+	return true;
+}
+
+/*
+ * FileIOBatch() implementation for io_method = io_uring.
+ *
+ * Keeps up to FILE_IO_URING_DEPTH requests in flight.  No error may be
+ * thrown while the kernel still has I/O in flight into the caller's
+ * buffers, so failures are reported through the request's result, and
+ * anything we can't submit is done synchronously.
+ */
+static void
+FileIOBatchUring(FileIORequest *reqs, int nreqs, uint32 wait_event_info)
+{
+	int			next = 0;
+	int			inflight = 0;
+
+	while (next < nreqs)
+	{
+		FileIORequest *req = &reqs[next];
+		struct io_uring_sqe *sqe;
+		int			ret;
+
+		/* make room in the ring, if needed */
+		if (inflight >= FILE_IO_URING_DEPTH)
+		{
+			FileIORingReap(true, wait_event_info);
+			inflight--;
+		}
+
+		Assert(FileIsValid(req->file));
+		Assert(!(VfdCache[req->file].fdstate & FD_TEMP_FILE_LIMIT));
+
+		/*
+		 * Each request is submitted on its own: FileAccess() may close other
+		 * virtual files to stay under max_safe_fds, and the kernel takes its
+		 * own reference to a file only when a request is submitted.
+		 */
+		if (FileAccess(req->file) < 0)
+		{
+			req->result = -1;
+			req->error = errno;
+			next++;
+			continue;
+		}
+
+		sqe = io_uring_get_sqe(&FileIORing);
+		Assert(sqe != NULL);
+		if (req->is_write)
+			io_uring_prep_writev(sqe, VfdCache[req->file].fd,
+								 req->iov, req->iovcnt, req->offset);
+		else
+			io_uring_prep_readv(sqe, VfdCache[req->file].fd,
+								req->iov, req->iovcnt, req->offset);
+		io_uring_sqe_set_data(sqe, req);
+
+		do
+		{
+			ret = io_uring_submit(&FileIORing);
+		} while (ret == -EINTR || ret == -EAGAIN);
+
+		if (ret < 0)
+		{
+			/*
+			 * Wait out what's in flight and give up on io_uring for this
+			 * process; the rest of the batch is done synchronously.
+			 */
+			errno = -ret;
+			ereport(LOG,
+					(errcode_for_file_access(),
+					 errmsg("could not submit io_uring request, falling back to synchronous I/O: %m")));
+			for (; inflight > 0; inflight--)
+				FileIORingReap(true, wait_event_info);
+			FileIORingShutdown();
+
+			for (; next < nreqs; next++)
+				FileIOPerform(&reqs[next], wait_event_info);
+			return;
+		}
+
+		next++;
+		inflight++;
+
+		/* pick up whatever has completed already, without waiting */
+		while (inflight > 0 && FileIORingReap(false, wait_event_info))
+			inflight--;
+	}
+
+	for (; inflight > 0; inflight--)
+		FileIORingReap(true, wait_event_info);
+}
+#endif							/* USE_LIBURING */
+
+/*
+ * FileIOBatch -- perform a batch of reads and writes
+ *
+ * With io_method = io_uring, the requests are submitted to the kernel
+ * together and may complete in any order; otherwise they are performed one
+ * after another.  Either way, all of them have completed when this returns,
+ * and the outcome of each is reported in its result and error fields.  The
+ * caller must deal with errors and short transfers.
+ *
+ * Temporary files subject to temp_file_limit aren't supported.
+ */
+void
+FileIOBatch(FileIORequest *reqs, int nreqs, uint32 wait_event_info)
+{
+#ifdef USE_LIBURING
+	if (nreqs > 1 && io_method == IOMETHOD_IO_URING && FileIORingSetup())
+	{
+		FileIOBatchUring(reqs, nreqs, wait_event_info);
+		return;
+	}
+#endif
+
+	for (int i = 0; i < nreqs; i++)
+		FileIOPerform(&reqs[i], wait_event_info);
+}
+
+/*
+ * FileIOBatchIsAsync -- will FileIOBatch() overlap the requests of a batch?
+ *
+ * Callers can use this to decide whether it's worth building large batches.
+ */
+bool
+FileIOBatchIsAsync(void)
+{
+#ifdef USE_LIBURING
+	return io_method == IOMETHOD_IO_URING && FileIORingSetup();
+#else
+	return false;
+#endif
+}
+
 int
 FileSync(File file, uint32 wait_event_info)
 {
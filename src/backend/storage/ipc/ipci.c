@@ -16,14 +16,17 @@
 
 #include "access/clog.h"
 #include "access/commit_ts.h"
+#include "access/csnlog.h"
 #include "access/heapam.h"
 #include "access/multixact.h"
 #include "access/nbtree.h"
 #include "access/subtrans.h"
 #include "access/syncscan.h"
 #include "access/twophase.h"
+#include "access/xlogdict.h"
 #include "access/xlogprefetcher.h"
 #include "access/xlogrecovery.h"
+#include "access/xlogredoworker.h"
 #include "commands/async.h"
 #include "miscadmin.h"
 #include "pgstat.h"
@@ -117,9 +120,12 @@ CalculateShmemSize(int *num_semaphores)
 	size = add_size(size, XLogPrefetchShmemSize());
 	size = add_size(size, XLOGShmemSize());
 	size = add_size(size, XLogRecoveryShmemSize());
+	size = add_size(size, XLogDictShmemSize());
+	size = add_size(size, ParallelRedoShmemSize());
 	size = add_size(size, CLOGShmemSize());
 	size = add_size(size, CommitTsShmemSize());
 	size = add_size(size, SUBTRANSShmemSize());
+	size = add_size(size, CSNLogShmemSize());
 	size = add_size(size, TwoPhaseShmemSize());
 	size = add_size(size, BackgroundWorkerShmemSize());
 	size = add_size(size, MultiXactShmemSize());
@@ -241,9 +247,12 @@ CreateSharedMemoryAndSemaphores(void)
 	XLOGShmemInit();  // 里面包括控制文件的信息
 	XLogPrefetchShmemInit();
 	XLogRecoveryShmemInit();
+	XLogDictShmemInit();
+	ParallelRedoShmemInit();
 	CLOGShmemInit();
 	CommitTsShmemInit();
 	SUBTRANSShmemInit();
+	CSNLogShmemInit();
 	MultiXactShmemInit();
 	InitBufferPool(); // 最大个的共享池的创建
 
@@ -48,6 +48,7 @@
 #include <signal.h>
 
 #include "access/clog.h"
+#include "access/csnlog.h"
 #include "access/subtrans.h"
 #include "access/transam.h"
 #include "access/twophase.h"
@@ -2153,6 +2154,115 @@ GetSnapshotDataReuse(Snapshot snapshot)
 	return true;
 }
 
+/*
+ * Helper function for GetSnapshotData() that builds a CSN snapshot, used
+ * when csn_snapshots is enabled.
+ *
+ * A CSN snapshot is the next commit sequence number at the time it was
+ * taken, and XidInMVCCSnapshot() consults the CSN log instead of XID
+ * arrays.  xmin is the oldest XID that might still be in progress and xmax
+ * the next XID to be assigned, which still spares most tuples the lookup.
+ * All of these are read from shared atomics, so unlike a regular snapshot
+ * this needs no ProcArrayLock and takes the same time however many
+ * backends there are.
+ */
+static Snapshot
+GetSnapshotDataCSN(Snapshot snapshot)
+{
+	TransactionId xmin;
+	TransactionId xmax;
+	TransactionId myxid;
+	FullTransactionId next_fxid;
+	FullTransactionId xmin_fxid;
+	FullTransactionId oldestfxid;
+
+	xmin = CSNLogGetOldestActiveXid();
+
+	/*
+	 * Advertise our xmin before reading the CSN.  A concurrent horizon
+	 * computation either sees it, or finished looking at the procarray
+	 * before we read the CSN, in which case every transaction it considered
+	 * completed is visible to us.  (That's also why ProcArrayEndTransaction
+	 * still clears XIDs under ProcArrayLock.)
+	 */
+	if (!TransactionIdIsValid(MyProc->xmin))
+	{
+		MyProc->xmin = TransactionXmin = xmin;
+		pg_memory_barrier();
+	}
+
+	snapshot->snapshot_csn = CSNLogGetNextCommitSeqNo();
+
+	/*
+	 * Read nextXid after the CSN: anything that committed before the
+	 * snapshot had its XID assigned by then.
+	 */
+	pg_read_barrier();
+	next_fxid = CSNLogGetNextFullXid();
+	xmax = XidFromFullTransactionId(next_fxid);
+	Assert(TransactionIdPrecedesOrEquals(xmin, xmax));
+
+	myxid = MyProc->xid;
+
+	/*
+	 * Maintain state for GlobalVis*.  We only have cheap bounds here: XIDs
+	 * at or after our xmin are definitely needed, and ones before oldestXid
+	 * are not; GlobalVisUpdate() computes the accurate horizons if needed.
+	 * Unlike GetSnapshotData() we don't know about replication slots, which
+	 * only means that definitely_needed may be less aggressive.
+	 */
+	xmin_fxid = FullXidRelativeTo(next_fxid, xmin);
+	oldestfxid = FullXidRelativeTo(next_fxid,
+								   UINT32_ACCESS_ONCE(ShmemVariableCache->oldestXid));
+
+	GlobalVisSharedRels.definitely_needed =
+		FullTransactionIdNewer(xmin_fxid,
+							   GlobalVisSharedRels.definitely_needed);
+	GlobalVisCatalogRels.definitely_needed =
+		FullTransactionIdNewer(xmin_fxid,
+							   GlobalVisCatalogRels.definitely_needed);
+	GlobalVisDataRels.definitely_needed =
+		FullTransactionIdNewer(xmin_fxid,
+							   GlobalVisDataRels.definitely_needed);
+	if (TransactionIdIsNormal(myxid))
+		GlobalVisTempRels.definitely_needed =
+			FullXidRelativeTo(next_fxid, myxid);
+	else
+		GlobalVisTempRels.definitely_needed = next_fxid;
+
+	GlobalVisSharedRels.maybe_needed =
+		FullTransactionIdNewer(GlobalVisSharedRels.maybe_needed,
+							   oldestfxid);
+	GlobalVisCatalogRels.maybe_needed =
+		FullTransactionIdNewer(GlobalVisCatalogRels.maybe_needed,
+							   oldestfxid);
+	GlobalVisDataRels.maybe_needed =
+		FullTransactionIdNewer(GlobalVisDataRels.maybe_needed,
+							   oldestfxid);
+	GlobalVisTempRels.maybe_needed = GlobalVisTempRels.definitely_needed;
+
+	RecentXmin = xmin;
+	Assert(TransactionIdPrecedesOrEquals(TransactionXmin, RecentXmin));
+
+	snapshot->xmin = xmin;
+	snapshot->xmax = xmax;
+	snapshot->xcnt = 0;
+	snapshot->subxcnt = 0;
+	snapshot->suboverflowed = false;
+	snapshot->takenDuringRecovery = false;
+	snapshot->snapXactCompletionCount = 0;
+
+	snapshot->curcid = GetCurrentCommandId(false);
+
+	snapshot->active_count = 0;
+	snapshot->regd_count = 0;
+	snapshot->copied = false;
+
+	GetSnapshotDataInitOldSnapshot(snapshot);
+
+	return snapshot;
+}
+
 /*
  * GetSnapshotData -- returns information about running transactions.
  *
@@ -2183,6 +2293,9 @@ GetSnapshotDataReuse(Snapshot snapshot)
  * And try to advance the bounds of GlobalVis{Shared,Catalog,Data,Temp}Rels
  * for the benefit of the GlobalVisTest* family of functions.
  *
+ * With csn_snapshots, snapshots taken outside of recovery are CSN snapshots
+ * instead; see GetSnapshotDataCSN().
+ *
  * Note: this function should probably not be called with an argument that's
  * not statically allocated (see xip allocation below).
  */
@@ -2240,6 +2353,9 @@ GetSnapshotData(Snapshot snapshot) // snapshot是一个指针
 					 errmsg("out of memory")));
 	}
 
+	if (csn_snapshots && !RecoveryInProgress())
+		return GetSnapshotDataCSN(snapshot);
+
 	/*
 	 * It is sufficient to get shared lock on ProcArrayLock, even if we are
 	 * going to set MyProc->xmin.
@@ -2520,6 +2636,7 @@ GetSnapshotData(Snapshot snapshot) // snapshot是一个指针
 	snapshot->subxcnt = subcount;
 	snapshot->suboverflowed = suboverflowed;
 	snapshot->snapXactCompletionCount = curXactCompletionCount;
+	snapshot->snapshot_csn = InvalidCommitSeqNo;
 
 	snapshot->curcid = GetCurrentCommandId(false);
 
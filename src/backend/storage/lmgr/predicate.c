@@ -3918,6 +3918,10 @@ XidIsConcurrent(TransactionId xid)
 	if (TransactionIdFollowsOrEquals(xid, snap->xmax))
 		return true;
 
+	/* CSN snapshots have no XID list to search */
+	if (snap->snapshot_csn != InvalidCommitSeqNo)
+		return XidInMVCCSnapshot(xid, snap);
+
 	return pg_lfind32(xid, snap->xip, snap->xcnt);
 }
 
@@ -153,6 +153,36 @@ _mdfd_open_flags(void)
 	return flags;
 }
 
+/*
+ * Advance an iovec array past the first 'transferred' bytes, after a partial
+ * read or write.  Returns the number of iovecs left.
+ */
+static int
+_mdfd_iovec_advance(struct iovec *iov, int iovcnt, size_t transferred)
+{
+	int			skip = 0;
+
+	while (skip < iovcnt && transferred >= iov[skip].iov_len)
+	{
+		transferred -= iov[skip].iov_len;
+		skip++;
+	}
+
+	if (skip > 0)
+	{
+		iovcnt -= skip;
+		memmove(iov, iov + skip, sizeof(struct iovec) * iovcnt);
+	}
+
+	if (iovcnt > 0)
+	{
+		iov[0].iov_base = (char *) iov[0].iov_base + transferred;
+		iov[0].iov_len -= transferred;
+	}
+
+	return iovcnt;
+}
+
 /*
  * mdinit() -- Initialize private state for magnetic disk storage manager.
  */
@@ -801,6 +831,339 @@ mdread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	}
 }
 
+/*
+ * One segment-sized piece of an SMgrIO, read or written with a single
+ * vectored I/O by mdiobatch().
+ */
+typedef struct MdIOChunk
+{
+	SMgrIO	   *io;
+	BlockNumber blocknum;		/* first block of this chunk */
+	BlockNumber nblocks;
+	File		vfd;			/* segment file */
+	off_t		seekpos;
+	int			iovcnt;
+	struct iovec iov[PG_IOV_MAX];
+} MdIOChunk;
+
+/* maximum number of chunks that mdiobatch() submits at once */
+#define MD_IO_BATCH_SIZE 32
+
+/*
+ * The blocks mdiobatch() is working on, for its error context callback.  A
+ * batch holds blocks of many relations, so errors must say which request
+ * failed, as mdwrite()'s callers do for single blocks.
+ */
+typedef struct MdIOErrorContext
+{
+	bool		is_write;
+	SMgrIO	   *io;				/* NULL if not working on any one request */
+	BlockNumber blocknum;
+	BlockNumber nblocks;
+} MdIOErrorContext;
+
+/*
+ * Error context callback for mdiobatch().
+ */
+static void
+mdiobatch_error_callback(void *arg)
+{
+	MdIOErrorContext *ctx = (MdIOErrorContext *) arg;
+	char	   *path;
+
+	if (ctx->io == NULL)
+		return;
+
+	path = relpath(ctx->io->reln->smgr_rlocator, ctx->io->forknum);
+	if (ctx->is_write)
+		errcontext("writing blocks %u..%u of relation %s",
+				   ctx->blocknum, ctx->blocknum + ctx->nblocks - 1, path);
+	else
+		errcontext("reading blocks %u..%u of relation %s",
+				   ctx->blocknum, ctx->blocknum + ctx->nblocks - 1, path);
+	pfree(path);
+}
+
+/*
+ * Complete one chunk of mdiobatch(), given the outcome of its first I/O
+ * attempt.  A short transfer is finished synchronously; reads past EOF are
+ * dealt with like in mdread().  Returns the number of bytes transferred.
+ */
+static size_t
+mdiochunk_complete(MdIOChunk *chunk, bool is_write, ssize_t nbytes, int error)
+{
+	size_t		size = (size_t) BLCKSZ * chunk->nblocks;
+	size_t		transferred = 0;
+
+	for (;;)
+	{
+		if (nbytes < 0)
+		{
+			errno = error;
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 is_write ?
+					 errmsg("could not write blocks %u..%u in file \"%s\": %m",
+							chunk->blocknum,
+							chunk->blocknum + chunk->nblocks - 1,
+							FilePathName(chunk->vfd)) :
+					 errmsg("could not read blocks %u..%u in file \"%s\": %m",
+							chunk->blocknum,
+							chunk->blocknum + chunk->nblocks - 1,
+							FilePathName(chunk->vfd))));
+		}
+
+		if (nbytes == 0)
+		{
+			if (is_write)
+				ereport(ERROR,
+						(errcode(ERRCODE_DISK_FULL),
+						 errmsg("could not write blocks %u..%u in file \"%s\": wrote only %zu of %zu bytes",
+								chunk->blocknum,
+								chunk->blocknum + chunk->nblocks - 1,
+								FilePathName(chunk->vfd),
+								transferred, size),
+						 errhint("Check free disk space.")));
+
+			/*
+			 * We are at or past EOF.  As in mdread(), that's an error unless
+			 * zero_damaged_pages is ON or we are InRecovery, in which case
+			 * the rest of the range reads as zeroes.
+			 */
+			if (zero_damaged_pages || InRecovery)
+			{
+				for (int i = 0; i < chunk->iovcnt; i++)
+					memset(chunk->iov[i].iov_base, 0, chunk->iov[i].iov_len);
+				break;
+			}
+			else
+				ereport(ERROR,
+						(errcode(ERRCODE_DATA_CORRUPTED),
+						 errmsg("could not read blocks %u..%u in file \"%s\": read only %zu of %zu bytes",
+								chunk->blocknum,
+								chunk->blocknum + chunk->nblocks - 1,
+								FilePathName(chunk->vfd),
+								transferred, size)));
+		}
+
+		transferred += nbytes;
+		if (transferred == size)
+			break;
+
+		/* Short transfer, adjust the iovecs and do the rest */
+		chunk->iovcnt = _mdfd_iovec_advance(chunk->iov, chunk->iovcnt, nbytes);
+		chunk->seekpos += nbytes;
+
+		if (is_write)
+			nbytes = FileWriteV(chunk->vfd, chunk->iov, chunk->iovcnt,
+								chunk->seekpos, WAIT_EVENT_DATA_FILE_WRITE);
+		else
+			nbytes = FileReadV(chunk->vfd, chunk->iov, chunk->iovcnt,
+							   chunk->seekpos, WAIT_EVENT_DATA_FILE_READ);
+		error = errno;
+	}
+
+	return transferred;
+}
+
+/*
+ * Common code for mdreadbatch() and mdwritebatch().
+ *
+ * Each SMgrIO is split into chunks at segment boundaries and at PG_IOV_MAX
+ * blocks, and up to MD_IO_BATCH_SIZE chunks are handed to FileIOBatch() at
+ * a time.  Errors are only reported once all I/O of a round has completed.
+ */
+static void
+mdiobatch(SMgrIO *ios, int nios, bool is_write, bool skipFsync)
+{
+	MdIOChunk  *chunks;
+	FileIORequest reqs[MD_IO_BATCH_SIZE];
+	MdIOErrorContext errctx;
+	ErrorContextCallback errcallback;
+	int			maxchunks = 0;
+	int			i = 0;
+	BlockNumber done = 0;		/* blocks of ios[i] already planned */
+
+	/* Count the chunks we'll need, to size the chunk array */
+	for (int n = 0; n < nios && maxchunks < MD_IO_BATCH_SIZE; n++)
+	{
+		BlockNumber blocknum = ios[n].blocknum;
+		BlockNumber nblocks = ios[n].nblocks;
+
+		while (nblocks > 0)
+		{
+			BlockNumber segoff = blocknum % ((BlockNumber) RELSEG_SIZE);
+			BlockNumber nblocks_this_chunk;
+
+			nblocks_this_chunk = Min(nblocks, RELSEG_SIZE - segoff);
+			nblocks_this_chunk = Min(nblocks_this_chunk, PG_IOV_MAX);
+			blocknum += nblocks_this_chunk;
+			nblocks -= nblocks_this_chunk;
+			maxchunks++;
+		}
+	}
+	maxchunks = Min(maxchunks, MD_IO_BATCH_SIZE);
+
+	chunks = palloc(sizeof(MdIOChunk) * maxchunks);
+
+	/* Set up error traceback support for ereport() */
+	errctx.is_write = is_write;
+	errctx.io = NULL;
+	errcallback.callback = mdiobatch_error_callback;
+	errcallback.arg = (void *) &errctx;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	while (i < nios)
+	{
+		int			nchunks = 0;
+
+		/* Plan the next round of chunks */
+		while (i < nios && nchunks < maxchunks)
+		{
+			SMgrIO	   *io = &ios[i];
+			MdIOChunk  *chunk = &chunks[nchunks];
+			BlockNumber blocknum = io->blocknum + done;
+			BlockNumber segoff = blocknum % ((BlockNumber) RELSEG_SIZE);
+			MdfdVec    *v;
+
+			Assert(io->nblocks > 0);
+
+			errctx.io = io;
+			errctx.blocknum = blocknum;
+			errctx.nblocks = io->nblocks - done;
+
+			/* This assert is too expensive to have on normally ... */
+#ifdef CHECK_WRITE_VS_EXTEND
+			if (is_write)
+				Assert(blocknum < mdnblocks(io->reln, io->forknum));
+#endif
+
+			v = _mdfd_getseg(io->reln, io->forknum, blocknum, skipFsync,
+							 EXTENSION_FAIL | EXTENSION_CREATE_RECOVERY);
+
+			chunk->io = io;
+			chunk->blocknum = blocknum;
+			chunk->vfd = v->mdfd_vfd;
+			chunk->seekpos = (off_t) BLCKSZ * segoff;
+
+			Assert(chunk->seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+
+			/* don't cross a segment boundary, and don't overrun iov[] */
+			chunk->nblocks = Min(io->nblocks - done, RELSEG_SIZE - segoff);
+			chunk->nblocks = Min(chunk->nblocks, PG_IOV_MAX);
+
+			for (int j = 0; j < chunk->nblocks; j++)
+			{
+				void	   *buffer = io->buffers[done + j];
+
+				/* If this build supports direct I/O, buffers must be I/O aligned. */
+				if (PG_O_DIRECT != 0 && PG_IO_ALIGN_SIZE <= BLCKSZ)
+					Assert((uintptr_t) buffer == TYPEALIGN(PG_IO_ALIGN_SIZE, buffer));
+
+				chunk->iov[j].iov_base = buffer;
+				chunk->iov[j].iov_len = BLCKSZ;
+			}
+			chunk->iovcnt = chunk->nblocks;
+
+			reqs[nchunks].file = chunk->vfd;
+			reqs[nchunks].is_write = is_write;
+			reqs[nchunks].iov = chunk->iov;
+			reqs[nchunks].iovcnt = chunk->iovcnt;
+			reqs[nchunks].offset = chunk->seekpos;
+
+			if (is_write)
+				TRACE_POSTGRESQL_SMGR_MD_WRITE_START(io->forknum, blocknum,
+													 io->reln->smgr_rlocator.locator.spcOid,
+													 io->reln->smgr_rlocator.locator.dbOid,
+													 io->reln->smgr_rlocator.locator.relNumber,
+													 io->reln->smgr_rlocator.backend);
+			else
+				TRACE_POSTGRESQL_SMGR_MD_READ_START(io->forknum, blocknum,
+													io->reln->smgr_rlocator.locator.spcOid,
+													io->reln->smgr_rlocator.locator.dbOid,
+													io->reln->smgr_rlocator.locator.relNumber,
+													io->reln->smgr_rlocator.backend);
+
+			nchunks++;
+			done += chunk->nblocks;
+			if (done == io->nblocks)
+			{
+				i++;
+				done = 0;
+			}
+		}
+
+		/* A failure to submit the batch isn't any one request's fault */
+		errctx.io = NULL;
+		FileIOBatch(reqs, nchunks,
+					is_write ? WAIT_EVENT_DATA_FILE_WRITE : WAIT_EVENT_DATA_FILE_READ);
+
+		/* Check the results, finishing any short transfers */
+		for (int c = 0; c < nchunks; c++)
+		{
+			MdIOChunk  *chunk = &chunks[c];
+			SMgrIO	   *io = chunk->io;
+			size_t		transferred pg_attribute_unused();
+
+			errctx.io = io;
+			errctx.blocknum = chunk->blocknum;
+			errctx.nblocks = chunk->nblocks;
+
+			transferred = mdiochunk_complete(chunk, is_write,
+											 reqs[c].result, reqs[c].error);
+
+			if (is_write)
+			{
+				TRACE_POSTGRESQL_SMGR_MD_WRITE_DONE(io->forknum, chunk->blocknum,
+													io->reln->smgr_rlocator.locator.spcOid,
+													io->reln->smgr_rlocator.locator.dbOid,
+													io->reln->smgr_rlocator.locator.relNumber,
+													io->reln->smgr_rlocator.backend,
+													transferred,
+													(size_t) BLCKSZ * chunk->nblocks);
+
+				/*
+				 * Look up the segment again rather than remembering it, as
+				 * opening other segments may have moved it in memory.
+				 */
+				if (!skipFsync && !SmgrIsTemp(io->reln))
+					register_dirty_segment(io->reln, io->forknum,
+										   _mdfd_getseg(io->reln, io->forknum,
+														chunk->blocknum, skipFsync,
+														EXTENSION_FAIL | EXTENSION_CREATE_RECOVERY));
+			}
+			else
+				TRACE_POSTGRESQL_SMGR_MD_READ_DONE(io->forknum, chunk->blocknum,
+												   io->reln->smgr_rlocator.locator.spcOid,
+												   io->reln->smgr_rlocator.locator.dbOid,
+												   io->reln->smgr_rlocator.locator.relNumber,
+												   io->reln->smgr_rlocator.backend,
+												   transferred,
+												   (size_t) BLCKSZ * chunk->nblocks);
+		}
+		errctx.io = NULL;
+	}
+
+	error_context_stack = errcallback.previous;
+
+	pfree(chunks);
+}
+
+/*
+ * mdreadbatch() -- Read the specified ranges of blocks.
+ *
+ * This is equivalent to calling mdread() for each block, except that the
+ * blocks within each segment are read with as few vectored reads as
+ * possible, and that with io_method = io_uring the reads are in flight
+ * concurrently.
+ */
+void
+mdreadbatch(SMgrIO *ios, int nios)
+{
+	mdiobatch(ios, nios, false, false);
+}
+
 /*
  * mdwrite() -- Write the supplied block at the appropriate location.
  *
@@ -869,6 +1232,17 @@ mdwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 		register_dirty_segment(reln, forknum, v);
 }
 
+/*
+ * mdwritebatch() -- Write the specified ranges of blocks.
+ *
+ * This is the batched counterpart of mdwrite(); see mdreadbatch().
+ */
+void
+mdwritebatch(SMgrIO *ios, int nios, bool skipFsync)
+{
+	mdiobatch(ios, nios, true, skipFsync);
+}
+
 /*
  * mdwriteback() -- Tell the kernel to write pages back to storage.
  *
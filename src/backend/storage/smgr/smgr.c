@@ -57,8 +57,10 @@ typedef struct f_smgr
 								  BlockNumber blocknum);
 	void		(*smgr_read) (SMgrRelation reln, ForkNumber forknum,
 							  BlockNumber blocknum, void *buffer);
+	void		(*smgr_readbatch) (SMgrIO *ios, int nios);
 	void		(*smgr_write) (SMgrRelation reln, ForkNumber forknum,
 							   BlockNumber blocknum, const void *buffer, bool skipFsync);
+	void		(*smgr_writebatch) (SMgrIO *ios, int nios, bool skipFsync);
 	void		(*smgr_writeback) (SMgrRelation reln, ForkNumber forknum,
 								   BlockNumber blocknum, BlockNumber nblocks);
 	BlockNumber (*smgr_nblocks) (SMgrRelation reln, ForkNumber forknum);
@@ -81,7 +83,9 @@ static const f_smgr smgrsw[] = {
 		.smgr_zeroextend = mdzeroextend,
 		.smgr_prefetch = mdprefetch,
 		.smgr_read = mdread,
+		.smgr_readbatch = mdreadbatch,
 		.smgr_write = mdwrite,
+		.smgr_writebatch = mdwritebatch,
 		.smgr_writeback = mdwriteback,
 		.smgr_nblocks = mdnblocks,
 		.smgr_truncate = mdtruncate,
@@ -565,6 +569,49 @@ smgrread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	smgrsw[reln->smgr_which].smgr_read(reln, forknum, blocknum, buffer);
 }
 
+/*
+ * smgrreadv() -- read a range of consecutive blocks of a relation into the
+ *				  supplied buffers.
+ *
+ * This is equivalent to nblocks calls to smgrread(), but lets the storage
+ * manager combine them into fewer, larger I/O requests.
+ */
+void
+smgrreadv(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+		  void **buffers, BlockNumber nblocks)
+{
+	SMgrIO		io;
+
+	io.reln = reln;
+	io.forknum = forknum;
+	io.blocknum = blocknum;
+	io.nblocks = nblocks;
+	io.buffers = buffers;
+
+	smgrsw[reln->smgr_which].smgr_readbatch(&io, 1);
+}
+
+/*
+ * smgrreadbatch() -- read several ranges of blocks at once.
+ *
+ * The ranges may belong to different relations, but all of them must use
+ * the same storage manager.  The storage manager may have the reads in
+ * flight concurrently; they have all completed when this returns.
+ */
+void
+smgrreadbatch(SMgrIO *ios, int nios)
+{
+	if (nios <= 0)
+		return;
+
+#ifdef USE_ASSERT_CHECKING
+	for (int i = 1; i < nios; i++)
+		Assert(ios[i].reln->smgr_which == ios[0].reln->smgr_which);
+#endif
+
+	smgrsw[ios[0].reln->smgr_which].smgr_readbatch(ios, nios);
+}
+
 /*
  * smgrwrite() -- Write the supplied buffer out.
  *
@@ -588,6 +635,26 @@ smgrwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 										buffer, skipFsync);
 }
 
+/*
+ * smgrwritebatch() -- write several ranges of blocks at once.
+ *
+ * Like smgrwrite(), this is only for updating already-existing blocks.  The
+ * same rules as for smgrreadbatch() apply.
+ */
+void
+smgrwritebatch(SMgrIO *ios, int nios, bool skipFsync)
+{
+	if (nios <= 0)
+		return;
+
+#ifdef USE_ASSERT_CHECKING
+	for (int i = 1; i < nios; i++)
+		Assert(ios[i].reln->smgr_which == ios[0].reln->smgr_which);
+#endif
+
+	smgrsw[ios[0].reln->smgr_which].smgr_writebatch(ios, nios, skipFsync);
+}
+
 
 /*
  * smgrwriteback() -- Trigger kernel writeback for the supplied range of
@@ -400,6 +400,8 @@ pgstat_bestart(void)
 	lbeentry.st_progress_command = PROGRESS_COMMAND_INVALID;
 	lbeentry.st_progress_command_target = InvalidOid;
 	lbeentry.st_query_id = UINT64CONST(0);
+	lbeentry.st_fastpath_slot_misses = 0;
+	lbeentry.st_fastpath_conflict_misses = 0;
 
 	/*
 	 * we don't zero st_progress_param here to save cycles; nobody should
@@ -661,6 +663,30 @@ pgstat_report_query_id(uint64 query_id, bool force)
 	PGSTAT_END_WRITE_ACTIVITY(beentry);
 }
 
+/* --------
+ * pgstat_report_fastpath_miss() -
+ *
+ * Called when a relation lock eligible for the fast path had to be taken
+ * in the main lock table.  conflict is true if that was because of a strong
+ * lock on the relation, false if the fast-path slots were all in use.
+ * --------
+ */
+void
+pgstat_report_fastpath_miss(bool conflict)
+{
+	volatile PgBackendStatus *beentry = MyBEEntry;
+
+	if (!beentry)
+		return;
+
+	PGSTAT_BEGIN_WRITE_ACTIVITY(beentry);
+	if (conflict)
+		beentry->st_fastpath_conflict_misses++;
+	else
+		beentry->st_fastpath_slot_misses++;
+	PGSTAT_END_WRITE_ACTIVITY(beentry);
+}
+
 
 /* ----------
  * pgstat_report_appname() -
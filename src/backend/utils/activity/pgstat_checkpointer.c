@@ -52,6 +52,7 @@ pgstat_report_checkpointer(void)
 	CHECKPOINTER_ACC(checkpoint_write_time);
 	CHECKPOINTER_ACC(checkpoint_sync_time);
 	CHECKPOINTER_ACC(buf_written_checkpoints);
+	CHECKPOINTER_ACC(write_requests_checkpoints);
 	CHECKPOINTER_ACC(buf_written_backend);
 	CHECKPOINTER_ACC(buf_fsync_backend);
 #undef CHECKPOINTER_ACC
@@ -120,6 +121,7 @@ pgstat_checkpointer_snapshot_cb(void)
 	CHECKPOINTER_COMP(checkpoint_write_time);
 	CHECKPOINTER_COMP(checkpoint_sync_time);
 	CHECKPOINTER_COMP(buf_written_checkpoints);
+	CHECKPOINTER_COMP(write_requests_checkpoints);
 	CHECKPOINTER_COMP(buf_written_backend);
 	CHECKPOINTER_COMP(buf_fsync_backend);
 #undef CHECKPOINTER_COMP
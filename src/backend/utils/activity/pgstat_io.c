@@ -25,6 +25,7 @@ typedef struct PgStat_PendingIO
 {
 	PgStat_Counter counts[IOOBJECT_NUM_TYPES][IOCONTEXT_NUM_TYPES][IOOP_NUM_TYPES];
 	instr_time	pending_times[IOOBJECT_NUM_TYPES][IOCONTEXT_NUM_TYPES][IOOP_NUM_TYPES];
+	PgStat_Counter write_requests[IOOBJECT_NUM_TYPES][IOCONTEXT_NUM_TYPES];
 } PgStat_PendingIO;
 
 
@@ -67,6 +68,11 @@ pgstat_bktype_io_stats_valid(PgStat_BktypeIO *backend_io,
 				if (backend_io->counts[io_object][io_context][io_op] != 0)
 					return false;
 			}
+
+			/* every write request writes at least one block */
+			if (backend_io->write_requests[io_object][io_context] >
+				backend_io->counts[io_object][io_context][IOOP_WRITE])
+				return false;
 		}
 	}
 
@@ -139,6 +145,24 @@ pgstat_count_io_op_time(IOObject io_object, IOContext io_context, IOOp io_op,
 	pgstat_count_io_op_n(io_object, io_context, io_op, cnt);
 }
 
+/*
+ * Count the number of requests that IOOP_WRITE blocks were written with.
+ * Callers count the blocks themselves, with pgstat_count_io_op_time().
+ */
+void
+pgstat_count_io_write_requests(IOObject io_object, IOContext io_context,
+							   uint32 cnt)
+{
+	Assert((unsigned int) io_object < IOOBJECT_NUM_TYPES);
+	Assert((unsigned int) io_context < IOCONTEXT_NUM_TYPES);
+	Assert(pgstat_tracks_io_op(MyBackendType, io_object, io_context,
+							   IOOP_WRITE));
+
+	PendingIOStats.write_requests[io_object][io_context] += cnt;
+
+	have_iostats = true;
+}
+
 PgStat_IO *
 pgstat_fetch_stat_io(void)
 {
@@ -189,6 +213,9 @@ pgstat_flush_io(bool nowait)
 				bktype_shstats->times[io_object][io_context][io_op] +=
 					INSTR_TIME_GET_MICROSEC(time);
 			}
+
+			bktype_shstats->write_requests[io_object][io_context] +=
+				PendingIOStats.write_requests[io_object][io_context];
 		}
 	}
 
@@ -428,6 +428,52 @@ pgstat_count_truncate(Relation rel)
 	}
 }
 
+/*
+ * count an incremental maintenance run of a materialized view
+ *
+ * "rows" is the number of matview rows deleted and inserted by the run, and
+ * "full" says whether the whole view had to be recomputed.  Like the scan
+ * counters these are nontransactional.
+ */
+void
+pgstat_count_matview_maintenance(Relation rel, bool full, PgStat_Counter rows,
+								 instr_time elapsed)
+{
+	if (pgstat_should_count_relation(rel))
+	{
+		PgStat_TableStatus *pgstat_info = rel->pgstat_info;
+
+		pgstat_info->counts.maintenance_count++;
+		if (full)
+			pgstat_info->counts.maintenance_full_count++;
+		pgstat_info->counts.maintenance_rows += rows;
+		pgstat_info->counts.maintenance_time += INSTR_TIME_GET_MICROSEC(elapsed);
+	}
+}
+
+/*
+ * count a cleanup of a GIN index's pending list
+ *
+ * "pages" is the number of pending-list pages merged into the main index
+ * structure, and "inline_merge" says whether an inserting backend had to do
+ * the work itself instead of leaving it to autovacuum.
+ */
+void
+pgstat_count_gin_pending_merge(Relation rel, bool inline_merge,
+							   PgStat_Counter pages, instr_time elapsed)
+{
+	if (pgstat_should_count_relation(rel))
+	{
+		PgStat_TableStatus *pgstat_info = rel->pgstat_info;
+
+		pgstat_info->counts.gin_pending_merges++;
+		if (inline_merge)
+			pgstat_info->counts.gin_pending_inline_merges++;
+		pgstat_info->counts.gin_pending_merged_pages += pages;
+		pgstat_info->counts.gin_pending_merge_time += INSTR_TIME_GET_MICROSEC(elapsed);
+	}
+}
+
 /*
  * update dead-tuples count
  *
@@ -829,6 +875,14 @@ pgstat_relation_flush_cb(PgStat_EntryRef *entry_ref, bool nowait)
 	tabentry->ins_since_vacuum += lstats->counts.tuples_inserted;
 	tabentry->blocks_fetched += lstats->counts.blocks_fetched;
 	tabentry->blocks_hit += lstats->counts.blocks_hit;
+	tabentry->maintenance_count += lstats->counts.maintenance_count;
+	tabentry->maintenance_full_count += lstats->counts.maintenance_full_count;
+	tabentry->maintenance_rows += lstats->counts.maintenance_rows;
+	tabentry->maintenance_time += lstats->counts.maintenance_time;
+	tabentry->gin_pending_merges += lstats->counts.gin_pending_merges;
+	tabentry->gin_pending_inline_merges += lstats->counts.gin_pending_inline_merges;
+	tabentry->gin_pending_merged_pages += lstats->counts.gin_pending_merged_pages;
+	tabentry->gin_pending_merge_time += lstats->counts.gin_pending_merge_time;
 
 	/* Clamp live_tuples in case of negative delta_live_tuples */
 	tabentry->live_tuples = Max(tabentry->live_tuples, 0);
@@ -117,6 +117,8 @@ pgstat_flush_wal(bool nowait)
 	WALSTAT_ACC(wal_buffers_full, PendingWalStats);
 	WALSTAT_ACC(wal_write, PendingWalStats);
 	WALSTAT_ACC(wal_sync, PendingWalStats);
+	WALSTAT_ACC(wal_group_flushes, PendingWalStats);
+	WALSTAT_ACC(wal_group_flush_members, PendingWalStats);
 	WALSTAT_ACC_INSTR_TIME(wal_write_time);
 	WALSTAT_ACC_INSTR_TIME(wal_sync_time);
 #undef WALSTAT_ACC_INSTR_TIME
@@ -151,16 +153,17 @@ pgstat_init_wal(void)
 /*
  * To determine whether any WAL activity has occurred since last time, not
  * only the number of generated WAL records but also the numbers of WAL
- * writes and syncs need to be checked. Because even transaction that
- * generates no WAL records can write or sync WAL data when flushing the
- * data pages.
+ * writes, syncs and group flushes need to be checked. Because even
+ * transaction that generates no WAL records can write or sync WAL data when
+ * flushing the data pages.
  */
 bool
 pgstat_have_pending_wal(void)
 {
 	return pgWalUsage.wal_records != prevWalUsage.wal_records ||
 		PendingWalStats.wal_write != 0 ||
-		PendingWalStats.wal_sync != 0;
+		PendingWalStats.wal_sync != 0 ||
+		PendingWalStats.wal_group_flushes != 0;
 }
 
 void
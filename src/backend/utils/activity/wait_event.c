@@ -233,6 +233,9 @@ pgstat_get_wait_activity(WaitEventActivity w)
 		case WAIT_EVENT_LOGICAL_PARALLEL_APPLY_MAIN:
 			event_name = "LogicalParallelApplyMain";
 			break;
+		case WAIT_EVENT_PARALLEL_REDO_WORKER_MAIN:
+			event_name = "ParallelRedoWorkerMain";
+			break;
 		case WAIT_EVENT_RECOVERY_WAL_STREAM:
 			event_name = "RecoveryWalStream";
 			break;
@@ -346,6 +349,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_EXECUTE_GATHER:
 			event_name = "ExecuteGather";
 			break;
+		case WAIT_EVENT_HASH_AGG_SPILL:
+			event_name = "HashAggSpill";
+			break;
 		case WAIT_EVENT_HASH_BATCH_ALLOCATE:
 			event_name = "HashBatchAllocate";
 			break;
@@ -424,6 +430,15 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_PARALLEL_FINISH:
 			event_name = "ParallelFinish";
 			break;
+		case WAIT_EVENT_PARALLEL_REDO_DISPATCH:
+			event_name = "ParallelRedoDispatch";
+			break;
+		case WAIT_EVENT_PARALLEL_REDO_SYNC:
+			event_name = "ParallelRedoSync";
+			break;
+		case WAIT_EVENT_PARALLEL_SORT:
+			event_name = "ParallelSort";
+			break;
 		case WAIT_EVENT_PROCARRAY_GROUP_UPDATE:
 			event_name = "ProcArrayGroupUpdate";
 			break;
@@ -460,6 +475,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_SYNC_REP:
 			event_name = "SyncRep";
 			break;
+		case WAIT_EVENT_WAL_GROUP_FLUSH:
+			event_name = "WALGroupFlush";
+			break;
 		case WAIT_EVENT_WAL_RECEIVER_EXIT:
 			event_name = "WalReceiverExit";
 			break;
@@ -738,6 +756,12 @@ pgstat_get_wait_io(WaitEventIO w)
 		case WAIT_EVENT_WAL_COPY_WRITE:
 			event_name = "WALCopyWrite";
 			break;
+		case WAIT_EVENT_WAL_DICTIONARY_READ:
+			event_name = "WALDictionaryRead";
+			break;
+		case WAIT_EVENT_WAL_DICTIONARY_WRITE:
+			event_name = "WALDictionaryWrite";
+			break;
 		case WAIT_EVENT_WAL_INIT_SYNC:
 			event_name = "WALInitSync";
 			break;
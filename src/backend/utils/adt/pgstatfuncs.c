@@ -72,12 +72,30 @@ PG_STAT_GET_RELENTRY_INT64(blocks_hit)
 /* pg_stat_get_dead_tuples */
 PG_STAT_GET_RELENTRY_INT64(dead_tuples)
 
+/* pg_stat_get_gin_pending_inline_merges */
+PG_STAT_GET_RELENTRY_INT64(gin_pending_inline_merges)
+
+/* pg_stat_get_gin_pending_merged_pages */
+PG_STAT_GET_RELENTRY_INT64(gin_pending_merged_pages)
+
+/* pg_stat_get_gin_pending_merges */
+PG_STAT_GET_RELENTRY_INT64(gin_pending_merges)
+
 /* pg_stat_get_ins_since_vacuum */
 PG_STAT_GET_RELENTRY_INT64(ins_since_vacuum)
 
 /* pg_stat_get_live_tuples */
 PG_STAT_GET_RELENTRY_INT64(live_tuples)
 
+/* pg_stat_get_maintenance_count */
+PG_STAT_GET_RELENTRY_INT64(maintenance_count)
+
+/* pg_stat_get_maintenance_full_count */
+PG_STAT_GET_RELENTRY_INT64(maintenance_full_count)
+
+/* pg_stat_get_maintenance_rows */
+PG_STAT_GET_RELENTRY_INT64(maintenance_rows)
+
 /* pg_stat_get_mod_since_analyze */
 PG_STAT_GET_RELENTRY_INT64(mod_since_analyze)
 
@@ -142,6 +160,38 @@ PG_STAT_GET_RELENTRY_TIMESTAMPTZ(last_vacuum_time)
 /* pg_stat_get_lastscan */
 PG_STAT_GET_RELENTRY_TIMESTAMPTZ(lastscan)
 
+/* convert counter from microsec to millisec for display */
+Datum
+pg_stat_get_maintenance_time(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	double		result;
+	PgStat_StatTabEntry *tabentry;
+
+	if ((tabentry = pgstat_fetch_stat_tabentry(relid)) == NULL)
+		result = 0;
+	else
+		result = ((double) tabentry->maintenance_time) / 1000.0;
+
+	PG_RETURN_FLOAT8(result);
+}
+
+/* convert counter from microsec to millisec for display */
+Datum
+pg_stat_get_gin_pending_merge_time(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	double		result;
+	PgStat_StatTabEntry *tabentry;
+
+	if ((tabentry = pgstat_fetch_stat_tabentry(relid)) == NULL)
+		result = 0;
+	else
+		result = ((double) tabentry->gin_pending_merge_time) / 1000.0;
+
+	PG_RETURN_FLOAT8(result);
+}
+
 Datum
 pg_stat_get_function_calls(PG_FUNCTION_ARGS)
 {
@@ -811,6 +861,38 @@ pg_stat_get_backend_wait_event(PG_FUNCTION_ARGS)
 }
 
 
+Datum
+pg_stat_get_backend_fastpath_slot_misses(PG_FUNCTION_ARGS)
+{
+	int32		beid = PG_GETARG_INT32(0);
+	PgBackendStatus *beentry;
+
+	if ((beentry = pgstat_get_beentry_by_backend_id(beid)) == NULL)
+		PG_RETURN_NULL();
+
+	if (!HAS_PGSTAT_PERMISSIONS(beentry->st_userid))
+		PG_RETURN_NULL();
+
+	PG_RETURN_INT64(beentry->st_fastpath_slot_misses);
+}
+
+
+Datum
+pg_stat_get_backend_fastpath_conflict_misses(PG_FUNCTION_ARGS)
+{
+	int32		beid = PG_GETARG_INT32(0);
+	PgBackendStatus *beentry;
+
+	if ((beentry = pgstat_get_beentry_by_backend_id(beid)) == NULL)
+		PG_RETURN_NULL();
+
+	if (!HAS_PGSTAT_PERMISSIONS(beentry->st_userid))
+		PG_RETURN_NULL();
+
+	PG_RETURN_INT64(beentry->st_fastpath_conflict_misses);
+}
+
+
 Datum
 pg_stat_get_backend_activity_start(PG_FUNCTION_ARGS)
 {
@@ -1237,6 +1319,12 @@ pg_stat_get_bgwriter_stat_reset_time(PG_FUNCTION_ARGS)
 	PG_RETURN_TIMESTAMPTZ(pgstat_fetch_stat_bgwriter()->stat_reset_timestamp);
 }
 
+Datum
+pg_stat_get_bgwriter_write_requests_checkpoints(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_INT64(pgstat_fetch_stat_checkpointer()->write_requests_checkpoints);
+}
+
 Datum
 pg_stat_get_buf_written_backend(PG_FUNCTION_ARGS)
 {
@@ -1269,6 +1357,7 @@ typedef enum io_stat_col
 	IO_COL_READ_TIME,
 	IO_COL_WRITES,
 	IO_COL_WRITE_TIME,
+	IO_COL_WRITE_REQUESTS,
 	IO_COL_WRITEBACKS,
 	IO_COL_WRITEBACK_TIME,
 	IO_COL_EXTENDS,
@@ -1447,6 +1536,13 @@ pg_stat_get_io(PG_FUNCTION_ARGS)
 						nulls[time_idx] = true;
 				}
 
+				/* write requests are shown whenever writes are */
+				if (!nulls[IO_COL_WRITES])
+					values[IO_COL_WRITE_REQUESTS] =
+						Int64GetDatum(bktype_stats->write_requests[io_obj][io_context]);
+				else
+					nulls[IO_COL_WRITE_REQUESTS] = true;
+
 				tuplestore_putvalues(rsinfo->setResult, rsinfo->setDesc,
 									 values, nulls);
 			}
@@ -1462,7 +1558,7 @@ pg_stat_get_io(PG_FUNCTION_ARGS)
 Datum
 pg_stat_get_wal(PG_FUNCTION_ARGS)
 {
-#define PG_STAT_GET_WAL_COLS	9
+#define PG_STAT_GET_WAL_COLS	11
 	TupleDesc	tupdesc;
 	Datum		values[PG_STAT_GET_WAL_COLS] = {0};
 	bool		nulls[PG_STAT_GET_WAL_COLS] = {0};
@@ -1487,7 +1583,11 @@ pg_stat_get_wal(PG_FUNCTION_ARGS)
 					   FLOAT8OID, -1, 0);
 	TupleDescInitEntry(tupdesc, (AttrNumber) 8, "wal_sync_time",
 					   FLOAT8OID, -1, 0);
-	TupleDescInitEntry(tupdesc, (AttrNumber) 9, "stats_reset",
+	TupleDescInitEntry(tupdesc, (AttrNumber) 9, "wal_group_flushes",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 10, "wal_group_flush_members",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 11, "stats_reset",
 					   TIMESTAMPTZOID, -1, 0);
 
 	BlessTupleDesc(tupdesc);
@@ -1514,7 +1614,10 @@ pg_stat_get_wal(PG_FUNCTION_ARGS)
 	values[6] = Float8GetDatum(((double) wal_stats->wal_write_time) / 1000.0);
 	values[7] = Float8GetDatum(((double) wal_stats->wal_sync_time) / 1000.0);
 
-	values[8] = TimestampTzGetDatum(wal_stats->stat_reset_timestamp);
+	values[8] = Int64GetDatum(wal_stats->wal_group_flushes);
+	values[9] = Int64GetDatum(wal_stats->wal_group_flush_members);
+
+	values[10] = TimestampTzGetDatum(wal_stats->stat_reset_timestamp);
 
 	/* Returns the record as Datum */
 	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
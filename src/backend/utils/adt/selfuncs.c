@@ -6685,8 +6685,102 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	bool		found_saop;
 	bool		found_is_null_op;
 	double		num_sa_scans;
+	double		skip_ndistinct;
 	ListCell   *lc;
 
+	/*
+	 * Look up statistics for the first index column.  We need them for the
+	 * skip scan estimate below, as well as for the correlation estimate.
+	 */
+	if (index->indexkeys[0] != 0)
+	{
+		/* Simple variable --- look to stats for the underlying table */
+		RangeTblEntry *rte = planner_rt_fetch(index->rel->relid, root);
+
+		Assert(rte->rtekind == RTE_RELATION);
+		relid = rte->relid;
+		Assert(relid != InvalidOid);
+		colnum = index->indexkeys[0];
+
+		if (get_relation_stats_hook &&
+			(*get_relation_stats_hook) (root, rte, colnum, &vardata))
+		{
+			/*
+			 * The hook took control of acquiring a stats tuple.  If it did
+			 * supply a tuple, it'd better have supplied a freefunc.
+			 */
+			if (HeapTupleIsValid(vardata.statsTuple) &&
+				!vardata.freefunc)
+				elog(ERROR, "no function provided to release variable stats with");
+		}
+		else
+		{
+			vardata.statsTuple = SearchSysCache3(STATRELATTINH,
+												 ObjectIdGetDatum(relid),
+												 Int16GetDatum(colnum),
+												 BoolGetDatum(rte->inh));
+			vardata.freefunc = ReleaseSysCache;
+		}
+	}
+	else
+	{
+		/* Expression --- maybe there are stats for the index itself */
+		relid = index->indexoid;
+		colnum = 1;
+
+		if (get_index_stats_hook &&
+			(*get_index_stats_hook) (root, relid, colnum, &vardata))
+		{
+			/*
+			 * The hook took control of acquiring a stats tuple.  If it did
+			 * supply a tuple, it'd better have supplied a freefunc.
+			 */
+			if (HeapTupleIsValid(vardata.statsTuple) &&
+				!vardata.freefunc)
+				elog(ERROR, "no function provided to release variable stats with");
+		}
+		else
+		{
+			vardata.statsTuple = SearchSysCache3(STATRELATTINH,
+												 ObjectIdGetDatum(relid),
+												 Int16GetDatum(colnum),
+												 BoolGetDatum(false));
+			vardata.freefunc = ReleaseSysCache;
+		}
+	}
+
+	/*
+	 * If there are no quals on the first index column, but there are some on
+	 * the second, the scan will be done as a skip scan: one primitive scan
+	 * per distinct value of the first column, each of which can use the quals
+	 * on the second column as boundary quals.  Estimate the number of
+	 * distinct values from the first column's statistics.  Without them, we
+	 * have no idea whether skipping pays off, so cost the scan as if it had
+	 * to read the whole index, as before.
+	 */
+	skip_ndistinct = 0;
+	if (index->nkeycolumns > 1 &&
+		!path->path.parallel_aware &&
+		path->indexclauses != NIL &&
+		linitial_node(IndexClause, path->indexclauses)->indexcol == 1 &&
+		HeapTupleIsValid(vardata.statsTuple) &&
+		OidIsValid(get_opfamily_member(index->opfamily[0],
+									   index->opcintype[0],
+									   index->opcintype[0],
+									   BTEqualStrategyNumber)))
+	{
+		Form_pg_statistic stats;
+
+		stats = (Form_pg_statistic) GETSTRUCT(vardata.statsTuple);
+		if (stats->stadistinct > 0.0)
+			skip_ndistinct = stats->stadistinct;
+		else if (stats->stadistinct < 0.0)
+			skip_ndistinct = -stats->stadistinct * index->rel->tuples;
+		if (skip_ndistinct > 0 && stats->stanullfrac > 0.0)
+			skip_ndistinct += 1;	/* NULL is skipped to as well */
+		skip_ndistinct = rint(skip_ndistinct);
+	}
+
 	/*
 	 * For a btree scan, only leading '=' quals plus inequality quals for the
 	 * immediately next attribute contribute to index selectivity (these are
@@ -6703,6 +6797,8 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	 * If there's a ScalarArrayOpExpr in the quals, we'll actually perform N
 	 * index scans not one, but the ScalarArrayOpExpr's operator can be
 	 * considered to act the same as it normally does.
+	 *
+	 * In a skip scan, the first column acts as if it had an '=' qual.
 	 */
 	indexBoundQuals = NIL;
 	indexcol = 0;
@@ -6710,6 +6806,8 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	found_saop = false;
 	found_is_null_op = false;
 	num_sa_scans = 1;
+	if (skip_ndistinct > 0)
+		eqQualHere = true;
 	foreach(lc, path->indexclauses)
 	{
 		IndexClause *iclause = lfirst_node(IndexClause, lc);
@@ -6791,9 +6889,11 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	 * If index is unique and we found an '=' clause for each column, we can
 	 * just assume numIndexTuples = 1 and skip the expensive
 	 * clauselist_selectivity calculations.  However, a ScalarArrayOp or
-	 * NullTest invalidates that theory, even though it sets eqQualHere.
+	 * NullTest invalidates that theory, even though it sets eqQualHere.  So
+	 * does a skip scan.
 	 */
 	if (index->unique &&
+		skip_ndistinct == 0 &&
 		indexcol == index->nkeycolumns - 1 &&
 		eqQualHere &&
 		!found_saop &&
@@ -6865,70 +6965,43 @@ btcostestimate(PlannerInfo *root, IndexPath *path, double loop_count,
 	costs.indexTotalCost += costs.num_sa_scans * descentCost;
 
 	/*
-	 * If we can get an estimate of the first column's ordering correlation C
-	 * from pg_statistic, estimate the index correlation as C for a
-	 * single-column index, or C * 0.75 for multiple columns. (The idea here
-	 * is that multiple columns dilute the importance of the first column's
-	 * ordering, but don't negate it entirely.  Before 8.0 we divided the
-	 * correlation by the number of columns, but that seems too strong.)
+	 * A skip scan descends the tree again for each distinct value of the
+	 * first column, although descents that land on the leaf page the scan
+	 * was already on are cheap.  Likewise it visits at least one leaf page
+	 * per distinct value, but never more than the whole index.  So charge
+	 * for Min(ndistinct, index pages) extra descents, plus random I/O for
+	 * that many leaf pages beyond what genericcostestimate counted.
 	 */
-	if (index->indexkeys[0] != 0)
+	if (skip_ndistinct > 0)
 	{
-		/* Simple variable --- look to stats for the underlying table */
-		RangeTblEntry *rte = planner_rt_fetch(index->rel->relid, root);
-
-		Assert(rte->rtekind == RTE_RELATION);
-		relid = rte->relid;
-		Assert(relid != InvalidOid);
-		colnum = index->indexkeys[0];
+		double		skip_scans = Min(skip_ndistinct, index->pages);
+		double		spc_random_page_cost;
 
-		if (get_relation_stats_hook &&
-			(*get_relation_stats_hook) (root, rte, colnum, &vardata))
-		{
-			/*
-			 * The hook took control of acquiring a stats tuple.  If it did
-			 * supply a tuple, it'd better have supplied a freefunc.
-			 */
-			if (HeapTupleIsValid(vardata.statsTuple) &&
-				!vardata.freefunc)
-				elog(ERROR, "no function provided to release variable stats with");
-		}
+		if (index->tuples > 1)
+			descentCost = ceil(log(index->tuples) / log(2.0)) * cpu_operator_cost;
 		else
-		{
-			vardata.statsTuple = SearchSysCache3(STATRELATTINH,
-												 ObjectIdGetDatum(relid),
-												 Int16GetDatum(colnum),
-												 BoolGetDatum(rte->inh));
-			vardata.freefunc = ReleaseSysCache;
-		}
-	}
-	else
-	{
-		/* Expression --- maybe there are stats for the index itself */
-		relid = index->indexoid;
-		colnum = 1;
+			descentCost = 0;
+		descentCost += (index->tree_height + 1) * DEFAULT_PAGE_CPU_MULTIPLIER * cpu_operator_cost;
+		costs.indexTotalCost += skip_scans * costs.num_sa_scans * descentCost;
 
-		if (get_index_stats_hook &&
-			(*get_index_stats_hook) (root, relid, colnum, &vardata))
-		{
-			/*
-			 * The hook took control of acquiring a stats tuple.  If it did
-			 * supply a tuple, it'd better have supplied a freefunc.
-			 */
-			if (HeapTupleIsValid(vardata.statsTuple) &&
-				!vardata.freefunc)
-				elog(ERROR, "no function provided to release variable stats with");
-		}
-		else
+		if (skip_scans > costs.numIndexPages)
 		{
-			vardata.statsTuple = SearchSysCache3(STATRELATTINH,
-												 ObjectIdGetDatum(relid),
-												 Int16GetDatum(colnum),
-												 BoolGetDatum(false));
-			vardata.freefunc = ReleaseSysCache;
+			get_tablespace_page_costs(index->reltablespace,
+									  &spc_random_page_cost, NULL);
+			costs.indexTotalCost += (skip_scans - costs.numIndexPages) *
+				spc_random_page_cost;
+			costs.numIndexPages = skip_scans;
 		}
 	}
 
+	/*
+	 * If we can get an estimate of the first column's ordering correlation C
+	 * from pg_statistic, estimate the index correlation as C for a
+	 * single-column index, or C * 0.75 for multiple columns. (The idea here
+	 * is that multiple columns dilute the importance of the first column's
+	 * ordering, but don't negate it entirely.  Before 8.0 we divided the
+	 * correlation by the number of columns, but that seems too strong.)
+	 */
 	if (HeapTupleIsValid(vardata.statsTuple))
 	{
 		Oid			sortop;
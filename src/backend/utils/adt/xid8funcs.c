@@ -410,16 +410,59 @@ pg_current_snapshot(PG_FUNCTION_ARGS)
 	if (cur == NULL)
 		elog(ERROR, "no active snapshot set");
 
-	/* allocate */
-	nxip = cur->xcnt;
-	snap = palloc(PG_SNAPSHOT_SIZE(nxip));
+	if (cur->snapshot_csn != InvalidCommitSeqNo)
+	{
+		TransactionId xid;
 
-	/* fill */
-	snap->xmin = widen_snapshot_xid(cur->xmin, next_fxid);
-	snap->xmax = widen_snapshot_xid(cur->xmax, next_fxid);
-	snap->nxip = nxip;
-	for (i = 0; i < nxip; i++)
-		snap->xip[i] = widen_snapshot_xid(cur->xip[i], next_fxid);
+		/*
+		 * A CSN snapshot has no list of running XIDs, so reconstruct it from
+		 * the CSN log.  This lists subtransactions and aborted transactions
+		 * too, which is harmless as neither is visible to the snapshot.
+		 */
+		nxip = 0;
+		xid = cur->xmin;
+		while (TransactionIdPrecedes(xid, cur->xmax))
+		{
+			if (!TransactionIdIsCurrentTransactionId(xid) &&
+				XidInMVCCSnapshot(xid, cur))
+				nxip++;
+			TransactionIdAdvance(xid);
+		}
+		if (nxip > PG_SNAPSHOT_MAX_NXIP)
+			ereport(ERROR,
+					(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+					 errmsg("too many transactions in progress to build a snapshot")));
+
+		snap = palloc(PG_SNAPSHOT_SIZE(nxip));
+		snap->xmin = widen_snapshot_xid(cur->xmin, next_fxid);
+		snap->xmax = widen_snapshot_xid(cur->xmax, next_fxid);
+
+		/* the set can't change, see XidInMVCCSnapshot() */
+		i = 0;
+		xid = cur->xmin;
+		while (TransactionIdPrecedes(xid, cur->xmax))
+		{
+			if (!TransactionIdIsCurrentTransactionId(xid) &&
+				XidInMVCCSnapshot(xid, cur))
+				snap->xip[i++] = widen_snapshot_xid(xid, next_fxid);
+			TransactionIdAdvance(xid);
+		}
+		Assert(i == nxip);
+		snap->nxip = nxip;
+	}
+	else
+	{
+		/* allocate */
+		nxip = cur->xcnt;
+		snap = palloc(PG_SNAPSHOT_SIZE(nxip));
+
+		/* fill */
+		snap->xmin = widen_snapshot_xid(cur->xmin, next_fxid);
+		snap->xmax = widen_snapshot_xid(cur->xmax, next_fxid);
+		snap->nxip = nxip;
+		for (i = 0; i < nxip; i++)
+			snap->xip[i] = widen_snapshot_xid(cur->xip[i], next_fxid);
+	}
 
 	/*
 	 * We want them guaranteed to be in ascending order.  This also removes
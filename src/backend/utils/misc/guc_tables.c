@@ -27,12 +27,14 @@
 #endif
 
 #include "access/commit_ts.h"
+#include "access/csnlog.h"
 #include "access/gin.h"
 #include "access/toast_compression.h"
 #include "access/twophase.h"
 #include "access/xlog_internal.h"
 #include "access/xlogprefetcher.h"
 #include "access/xlogrecovery.h"
+#include "access/xlogredoworker.h"
 #include "archive/archive_module.h"
 #include "catalog/namespace.h"
 #include "catalog/storage.h"
@@ -42,6 +44,9 @@
 #include "commands/user.h"
 #include "commands/vacuum.h"
 #include "common/scram-common.h"
+#include "executor/execBatch.h"
+#include "executor/execRuntimeFilter.h"
+#include "executor/nodeHash.h"
 #include "jit/jit.h"
 #include "libpq/auth.h"
 #include "libpq/libpq.h"
@@ -66,6 +71,7 @@
 #include "replication/slot.h"
 #include "replication/syncrep.h"
 #include "storage/bufmgr.h"
+#include "storage/fd.h"
 #include "storage/large_object.h"
 #include "storage/pg_shmem.h"
 #include "storage/predicate.h"
@@ -81,6 +87,7 @@
 #include "utils/pg_locale.h"
 #include "utils/portal.h"
 #include "utils/ps_status.h"
+#include "utils/tuplesort.h"
 #include "utils/inval.h"
 #include "utils/xml.h"
 
@@ -430,6 +437,14 @@ static const struct config_enum_entry recovery_init_sync_method_options[] = {
 	{NULL, 0, false}
 };
 
+static const struct config_enum_entry io_method_options[] = {
+	{"sync", IOMETHOD_SYNC, false},
+#ifdef USE_LIBURING
+	{"io_uring", IOMETHOD_IO_URING, false},
+#endif
+	{NULL, 0, false}
+};
+
 static const struct config_enum_entry shared_memory_options[] = {
 #ifndef WIN32
 	{"sysv", SHMEM_TYPE_SYSV, false},
@@ -458,6 +473,7 @@ static const struct config_enum_entry wal_compression_options[] = {
 #endif
 #ifdef USE_ZSTD
 	{"zstd", WAL_COMPRESSION_ZSTD, false},
+	{"zstd_dict", WAL_COMPRESSION_ZSTD_DICT, false},
 #endif
 	{"on", WAL_COMPRESSION_PGLZ, false},
 	{"off", WAL_COMPRESSION_NONE, false},
@@ -980,6 +996,16 @@ struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_parallel_sort", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of parallel sort plans."),
+			NULL,
+			GUC_EXPLAIN
+		},
+		&enable_parallel_sort,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_partition_pruning", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables plan-time and execution-time partition pruning."),
@@ -1017,6 +1043,18 @@ struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_async_scan", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables asynchronous execution of local scans and gathers under async append plans."),
+			gettext_noop("Sequential scans, bitmap heap scans and Gather nodes below an "
+						 "Append then start reading their next page, or wait for their "
+						 "workers, while other Append children produce tuples."),
+			GUC_EXPLAIN
+		},
+		&enable_async_scan,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"geqo", PGC_USERSET, QUERY_TUNING_GEQO,
 			gettext_noop("Enables genetic query optimization."),
@@ -1057,6 +1095,16 @@ struct config_bool ConfigureNamesBool[] =
 		false,
 		NULL, NULL, NULL
 	},
+	{
+		{"csn_snapshots", PGC_POSTMASTER, LOCK_MANAGEMENT,
+			gettext_noop("Takes MVCC snapshots from a commit sequence number log."),
+			gettext_noop("Snapshots are built without scanning the process array; "
+						 "visibility is decided by comparing commit sequence numbers.")
+		},
+		&csn_snapshots,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"ssl", PGC_SIGHUP, CONN_AUTH_SSL,
 			gettext_noop("Enables SSL connections."),
@@ -1188,6 +1236,17 @@ struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"wal_group_commit", PGC_SUSET, WAL_SETTINGS,
+			gettext_noop("Flushes WAL for concurrent commits in groups, with an adaptive delay."),
+			gettext_noop("The delay is derived from the observed WAL flush time. "
+						 "When enabled, commit_delay and commit_siblings are ignored.")
+		},
+		&wal_group_commit,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"log_checkpoints", PGC_SIGHUP, LOGGING_WHAT,
 			gettext_noop("Logs each checkpoint."),
@@ -1912,6 +1971,45 @@ struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"enable_batch_execution", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Enables batch-at-a-time execution of simple scans and aggregates."),
+			gettext_noop("Plain aggregates over sequential scans whose expressions "
+						 "only use pass-by-value types exchange rows in batches "
+						 "instead of one at a time."),
+			GUC_EXPLAIN
+		},
+		&enable_batch_execution,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"enable_bloom_filter_pushdown", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Enables pushing Bloom filters down from hash joins to scans."),
+			gettext_noop("Sequential scans below the outer side of a hash join "
+						 "skip rows whose join keys are not in a Bloom filter "
+						 "of the inner side's join keys."),
+			GUC_EXPLAIN
+		},
+		&enable_bloom_filter_pushdown,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"enable_radix_sort", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Enables radix sorting of large in-memory sorts."),
+			gettext_noop("Sorts whose leading key is an integer, timestamp "
+						 "or abbreviated key are sorted by the bytes of the "
+						 "key rather than by comparisons."),
+			GUC_EXPLAIN
+		},
+		&enable_radix_sort,
+		true,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"jit_debugging_support", PGC_SU_BACKEND, DEVELOPER_OPTIONS,
 			gettext_noop("Register JIT-compiled functions with debugger."),
@@ -2051,6 +2149,27 @@ struct config_int ConfigureNamesInt[] =
 		8, 1, INT_MAX,
 		NULL, NULL, NULL
 	},
+	{
+		{"hashjoin_radix_threshold", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets the inner relation size above which hash joins use a radix-partitioned bucket index."),
+			gettext_noop("Hash tables estimated to be smaller than this are probed "
+						 "through their bucket chains only.  -1 disables the index."),
+			GUC_UNIT_KB | GUC_EXPLAIN
+		},
+		&hashjoin_radix_threshold,
+		4096, -1, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+	{
+		{"hashjoin_radix_partition_log2", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Sets the log2 of the number of buckets per partition of a hash join's radix bucket index."),
+			NULL,
+			GUC_NOT_IN_SAMPLE
+		},
+		&hashjoin_radix_partition_log2,
+		14, 4, 24,
+		NULL, NULL, NULL
+	},
 	{
 		{"join_collapse_limit", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Sets the FROM-list size beyond which JOIN "
@@ -2230,6 +2349,17 @@ struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"clock_sweep_partitions", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of partitions the shared buffer replacement clock sweep is split into."),
+			gettext_noop("Each partition has its own clock hand and free list, which reduces "
+						 "contention when many backends are evicting buffers concurrently.")
+		},
+		&clock_sweep_partitions,
+		1, 1, MAX_CLOCK_SWEEP_PARTITIONS,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"vacuum_buffer_usage_limit", PGC_USERSET, RESOURCES_MEM,
 			gettext_noop("Sets the buffer pool size for VACUUM, ANALYZE, and autovacuum."),
@@ -2639,6 +2769,17 @@ struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"max_fast_path_locks", PGC_POSTMASTER, LOCK_MANAGEMENT,
+			gettext_noop("Sets the number of relation locks each backend can record in its fast-path array."),
+			gettext_noop("Locks beyond this number go to the shared lock table. "
+						 "The value is rounded up to a multiple of 16.")
+		},
+		&max_fast_path_locks,
+		16, 16, FP_LOCK_SLOTS_PER_BACKEND_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"authentication_timeout", PGC_SIGHUP, CONN_AUTH_AUTH,
 			gettext_noop("Sets the maximum allowed time to complete client authentication."),
@@ -2674,6 +2815,18 @@ struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"recovery_parallel_workers", PGC_POSTMASTER, WAL_RECOVERY,
+			gettext_noop("Sets the number of background workers used to replay WAL in parallel."),
+			gettext_noop("Workers are taken from the pool established by max_worker_processes, "
+						 "and are only used once recovery has reached a consistent state. "
+						 "0 replays all WAL in the startup process.")
+		},
+		&recovery_parallel_workers,
+		0, 0, MAX_PARALLEL_REDO_WORKERS,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"wal_keep_size", PGC_SIGHUP, REPLICATION_SENDING,
 			gettext_noop("Sets the size of WAL files held for standby servers."),
@@ -2746,6 +2899,17 @@ struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"checkpoint_write_combine_limit", PGC_SIGHUP, WAL_CHECKPOINTS,
+			gettext_noop("Maximum number of adjacent blocks that a checkpoint writes with a single I/O."),
+			NULL,
+			GUC_UNIT_BLOCKS
+		},
+		&checkpoint_write_combine_limit,
+		DEFAULT_IO_COMBINE_LIMIT, 1, MAX_IO_COMBINE_LIMIT,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"wal_buffers", PGC_POSTMASTER, WAL_SETTINGS,
 			gettext_noop("Sets the number of disk-page buffers in shared memory for WAL."),
@@ -2757,6 +2921,16 @@ struct config_int ConfigureNamesInt[] =
 		check_wal_buffers, NULL, NULL
 	},
 
+	{
+		{"wal_insert_locks", PGC_POSTMASTER, WAL_SETTINGS,
+			gettext_noop("Sets the number of locks for concurrent WAL insertion."),
+			gettext_noop("-1 means to choose based on max_connections.")
+		},
+		&wal_insert_locks,
+		-1, -1, MAX_XLOGINSERT_LOCKS,
+		check_wal_insert_locks, NULL, NULL
+	},
+
 	{
 		{"wal_writer_delay", PGC_SIGHUP, WAL_SETTINGS,
 			gettext_noop("Time between WAL flushes performed in the WAL writer."),
@@ -2993,6 +3167,20 @@ struct config_int ConfigureNamesInt[] =
 		NULL
 	},
 
+	{
+		{"io_combine_limit",
+			PGC_USERSET,
+			RESOURCES_ASYNCHRONOUS,
+			gettext_noop("Limit on the size of data reads and writes."),
+			gettext_noop("Consecutive blocks that are read together are combined into a single vectored I/O of at most this many blocks."),
+			GUC_UNIT_BLOCKS | GUC_EXPLAIN
+		},
+		&io_combine_limit,
+		DEFAULT_IO_COMBINE_LIMIT,
+		1, MAX_IO_COMBINE_LIMIT,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"backend_flush_after", PGC_USERSET, RESOURCES_ASYNCHRONOUS,
 			gettext_noop("Number of pages after which previously performed writes are flushed to disk."),
@@ -4946,6 +5134,16 @@ struct config_enum ConfigureNamesEnum[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"io_method", PGC_POSTMASTER, RESOURCES_ASYNCHRONOUS,
+			gettext_noop("Selects the method used for batched reads and writes of relation data."),
+			gettext_noop("With io_uring, the requests of a batch are kept in flight concurrently.")
+		},
+		&io_method,
+		IOMETHOD_SYNC, io_method_options,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"recovery_init_sync_method", PGC_SIGHUP, ERROR_HANDLING_OPTIONS,
 			gettext_noop("Sets the method for synchronizing the data directory before crash recovery."),
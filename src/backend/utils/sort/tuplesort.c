@@ -131,6 +131,8 @@ bool		trace_sort = false;
 bool		optimize_bounded_sort = true;
 #endif
 
+bool		enable_radix_sort = true;
+
 
 /*
  * During merge, we use a pre-allocated set of fixed-size slots to hold
@@ -623,6 +625,246 @@ qsort_tuple_int32_compare(SortTuple *a, SortTuple *b, Tuplesortstate *state)
 #define ST_DEFINE
 #include "lib/sort_template.h"
 
+/*
+ * Radix sort of SortTuples on datum1.
+ *
+ * When the leading key's comparator is one of the specialized ones above,
+ * the order it imposes on non-NULL datum1 values is that of plain integers,
+ * so large arrays can be sorted with an in-place MSD radix sort (American
+ * flag sort) on the bytes of datum1 instead of with comparisons.  Each pass
+ * distributes a range of the array into 256 buckets by one byte of the key,
+ * and then each bucket is sorted by the next byte.  Buckets smaller than
+ * RADIX_SORT_THRESHOLD are handed to the specialized qsort, as are groups of
+ * tuples with equal datum1 that need a tiebreak on the remaining keys or on
+ * the full value behind an abbreviated key.
+ *
+ * Keys are normalized to a uint64 whose unsigned order matches the sort
+ * order: signed values get their sign bit flipped, DESC keys are inverted,
+ * and narrower values are shifted to the most significant bytes.  NULLs are
+ * moved to the front or back of the array before the radix passes.
+ */
+#define RADIX_SORT_THRESHOLD	1024
+
+typedef enum RadixSortKind
+{
+	RADIX_SORT_UNSIGNED,		/* ssup_datum_unsigned_cmp */
+	RADIX_SORT_SIGNED,			/* ssup_datum_signed_cmp */
+	RADIX_SORT_INT32			/* ssup_datum_int32_cmp */
+} RadixSortKind;
+
+static pg_attribute_always_inline uint64
+radix_sort_key(Datum datum, RadixSortKind kind, bool reverse)
+{
+	uint64		key;
+
+	switch (kind)
+	{
+		case RADIX_SORT_UNSIGNED:
+			key = (uint64) datum << ((8 - SIZEOF_DATUM) * BITS_PER_BYTE);
+			break;
+#if SIZEOF_DATUM >= 8
+		case RADIX_SORT_SIGNED:
+			key = (uint64) DatumGetInt64(datum) ^ (UINT64CONST(1) << 63);
+			break;
+#endif
+		case RADIX_SORT_INT32:
+		default:
+			key = (uint64) ((uint32) DatumGetInt32(datum) ^ ((uint32) 1 << 31)) << 32;
+			break;
+	}
+
+	return reverse ? ~key : key;
+}
+
+/* Byte "level" of the normalized key, counting from the most significant */
+#define RADIX_SORT_BYTE(tuple, kind, reverse, level) \
+	((int) ((radix_sort_key((tuple)->datum1, (kind), (reverse)) >> \
+			 (56 - (level) * BITS_PER_BYTE)) & 0xFF))
+
+/*
+ * Sort a small range, or a range of tuples with equal datum1, with the
+ * matching specialized qsort.
+ */
+static void
+radix_sort_fallback(SortTuple *tuples, size_t n, RadixSortKind kind,
+					Tuplesortstate *state)
+{
+	switch (kind)
+	{
+		case RADIX_SORT_UNSIGNED:
+			qsort_tuple_unsigned(tuples, n, state);
+			break;
+#if SIZEOF_DATUM >= 8
+		case RADIX_SORT_SIGNED:
+			qsort_tuple_signed(tuples, n, state);
+			break;
+#endif
+		case RADIX_SORT_INT32:
+			qsort_tuple_int32(tuples, n, state);
+			break;
+		default:
+			elog(ERROR, "unrecognized radix sort kind: %d", (int) kind);
+	}
+}
+
+/*
+ * Sort the non-NULL tuples tuples[0 .. n - 1] by the bytes of their key,
+ * starting at byte "level".
+ */
+static void
+radix_sort_tuple(SortTuple *tuples, size_t n, int level, RadixSortKind kind,
+				 Tuplesortstate *state)
+{
+	bool		reverse = state->base.sortKeys[0].ssup_reverse;
+	int			keybytes;
+	size_t		count[256];
+	size_t		next[256];
+	size_t		end[256];
+	size_t		pos;
+	size_t		i;
+	int			b;
+
+	CHECK_FOR_INTERRUPTS();
+
+	keybytes = (kind == RADIX_SORT_INT32) ? sizeof(int32) :
+		(kind == RADIX_SORT_SIGNED) ? sizeof(int64) : SIZEOF_DATUM;
+
+	/* Skip over leading bytes that are the same in all tuples */
+	for (;;)
+	{
+		if (level >= keybytes)
+		{
+			/* All keys are equal; only a tiebreak can order them */
+			if (state->base.onlyKey == NULL)
+				radix_sort_fallback(tuples, n, kind, state);
+			return;
+		}
+
+		memset(count, 0, sizeof(count));
+		for (i = 0; i < n; i++)
+			count[RADIX_SORT_BYTE(&tuples[i], kind, reverse, level)]++;
+
+		if (count[RADIX_SORT_BYTE(&tuples[0], kind, reverse, level)] < n)
+			break;
+		level++;
+	}
+
+	pos = 0;
+	for (b = 0; b < 256; b++)
+	{
+		next[b] = pos;
+		pos += count[b];
+		end[b] = pos;
+	}
+
+	/*
+	 * Permute the tuples into their buckets.  Each tuple taken from the
+	 * unsorted part of bucket b is swapped into its own bucket, displacing a
+	 * tuple that is handled in turn, until one belonging to bucket b turns up.
+	 */
+	for (b = 0; b < 256; b++)
+	{
+		while (next[b] < end[b])
+		{
+			SortTuple	tuple = tuples[next[b]];
+			int			c = RADIX_SORT_BYTE(&tuple, kind, reverse, level);
+
+			while (c != b)
+			{
+				SortTuple	tmp = tuples[next[c]];
+
+				tuples[next[c]++] = tuple;
+				tuple = tmp;
+				c = RADIX_SORT_BYTE(&tuple, kind, reverse, level);
+			}
+			tuples[next[b]++] = tuple;
+		}
+	}
+
+	/* Sort each bucket by the following bytes */
+	pos = 0;
+	for (b = 0; b < 256; b++)
+	{
+		if (count[b] >= RADIX_SORT_THRESHOLD)
+			radix_sort_tuple(tuples + pos, count[b], level + 1, kind, state);
+		else if (count[b] > 1)
+			radix_sort_fallback(tuples + pos, count[b], kind, state);
+		pos += count[b];
+	}
+}
+
+/*
+ * Sort memtuples with a radix sort, if the leading key allows it.  Returns
+ * false, without doing anything, if it doesn't.
+ */
+static bool
+radix_sort_memtuples(Tuplesortstate *state)
+{
+	SortSupport ssup = &state->base.sortKeys[0];
+	SortTuple  *tuples = state->memtuples;
+	size_t		n = state->memtupcount;
+	size_t		nnulls = 0;
+	SortTuple  *nonnull;
+	RadixSortKind kind;
+	size_t		i;
+
+	if (ssup->comparator == ssup_datum_unsigned_cmp)
+		kind = RADIX_SORT_UNSIGNED;
+#if SIZEOF_DATUM >= 8
+	else if (ssup->comparator == ssup_datum_signed_cmp)
+		kind = RADIX_SORT_SIGNED;
+#endif
+	else if (ssup->comparator == ssup_datum_int32_cmp)
+		kind = RADIX_SORT_INT32;
+	else
+		return false;
+
+	/*
+	 * Move the NULLs to the front if they sort first, or else to the back.
+	 * They compare equal on the leading key, so sort them by the remaining
+	 * keys, if any.
+	 */
+	if (ssup->ssup_nulls_first)
+	{
+		for (i = 0; i < n; i++)
+		{
+			if (tuples[i].isnull1)
+			{
+				SortTuple	tmp = tuples[nnulls];
+
+				tuples[nnulls++] = tuples[i];
+				tuples[i] = tmp;
+			}
+		}
+		nonnull = tuples + nnulls;
+		if (nnulls > 1 && state->base.onlyKey == NULL)
+			radix_sort_fallback(tuples, nnulls, kind, state);
+	}
+	else
+	{
+		for (i = n; i > 0; i--)
+		{
+			if (tuples[i - 1].isnull1)
+			{
+				SortTuple	tmp = tuples[n - nnulls - 1];
+
+				tuples[n - ++nnulls] = tuples[i - 1];
+				tuples[i - 1] = tmp;
+			}
+		}
+		nonnull = tuples;
+		if (nnulls > 1 && state->base.onlyKey == NULL)
+			radix_sort_fallback(tuples + n - nnulls, nnulls, kind, state);
+	}
+
+	if (n - nnulls >= RADIX_SORT_THRESHOLD)
+		radix_sort_tuple(nonnull, n - nnulls, 0, kind, state);
+	else if (n - nnulls > 1)
+		radix_sort_fallback(nonnull, n - nnulls, kind, state);
+
+	return true;
+}
+
 /*
  *		tuplesort_begin_xxx
  *
@@ -2706,9 +2948,11 @@ sort_bounded_heap(Tuplesortstate *state)
 }
 
 /*
- * Sort all memtuples using specialized qsort() routines.
+ * Sort all memtuples using specialized qsort() routines, or a radix sort.
  *
  * Quicksort is used for small in-memory sorts, and external sort runs.
+ * Larger arrays whose leading key has an integer-like comparator are radix
+ * sorted instead.
  */
 static void
 tuplesort_sort_memtuples(Tuplesortstate *state)
@@ -2723,6 +2967,11 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 		 */
 		if (state->base.haveDatum1 && state->base.sortKeys)
 		{
+			if (enable_radix_sort &&
+				state->memtupcount >= RADIX_SORT_THRESHOLD &&
+				radix_sort_memtuples(state))
+				return;
+
 			if (state->base.sortKeys[0].comparator == ssup_datum_unsigned_cmp)
 			{
 				qsort_tuple_unsigned(state->memtuples,
@@ -3002,6 +3251,30 @@ tuplesort_attach_shared(Sharedsort *shared, dsm_segment *seg)
 	SharedFileSetAttach(&shared->fileset, seg);
 }
 
+/*
+ * tuplesort_reset_shared - reset shared tuplesort state for another sort
+ *
+ * Must be called from leader process, after all participants of the previous
+ * sort have called tuplesort_end() and before workers are launched again.
+ * The previous sort's worker runs are deleted.
+ */
+void
+tuplesort_reset_shared(Sharedsort *shared)
+{
+	int			i;
+
+	SharedFileSetDeleteAll(&shared->fileset);
+
+	SpinLockAcquire(&shared->mutex);
+	shared->currentWorker = 0;
+	shared->workersFinished = 0;
+	SpinLockRelease(&shared->mutex);
+	for (i = 0; i < shared->nTapes; i++)
+	{
+		shared->tapes[i].firstblocknumber = 0L;
+	}
+}
+
 /*
  * worker_get_identifier - Assign and return ordinal identifier for worker
  *
@@ -226,7 +226,9 @@ static char *extra_options = "";
 static const char *const subdirs[] = {
 	"global",
 	"pg_wal/archive_status",
+	"pg_waldict",
 	"pg_commit_ts",
+	"pg_csn",
 	"pg_dynshmem",
 	"pg_notify",
 	"pg_serial",
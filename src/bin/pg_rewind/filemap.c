@@ -103,6 +103,9 @@ static const char *excludeDirContents[] =
 	/* Contents removed on startup, see dsm_cleanup_for_mmap(). */
 	"pg_dynshmem",				/* defined as PG_DYNSHMEM_DIR */
 
+	/* Contents zeroed on startup, see StartupCSNLog(). */
+	"pg_csn",
+
 	/* Contents removed on startup, see AsyncShmemInit(). */
 	"pg_notify",
 
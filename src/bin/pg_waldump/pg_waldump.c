@@ -78,6 +78,9 @@ typedef struct XLogDumpConfig
 
 	/* save options */
 	char	   *save_fullpage_path;
+
+	/* directory holding WAL compression dictionaries */
+	char	   *dict_dir;
 } XLogDumpConfig;
 
 
@@ -615,6 +618,61 @@ XLogDumpStatsRow(const char *name,
 }
 
 
+/*
+ * Display the size of full-page images in WAL, compared to their size
+ * without compression, by compression method.
+ */
+static void
+XLogDumpDisplayFPIStats(XLogStats *stats)
+{
+	static const char *const method_names[XLOG_FPI_COMPRESSION_METHODS] = {
+		"none", "pglz", "lz4", "zstd", "zstd_dict"
+	};
+	uint64		total_count = 0;
+	uint64		total_raw_len = 0;
+	uint64		total_fpi_len = 0;
+	int			i;
+
+	for (i = 0; i < XLOG_FPI_COMPRESSION_METHODS; i++)
+	{
+		total_count += stats->fpi_stats[i].count;
+		total_raw_len += stats->fpi_stats[i].raw_len;
+		total_fpi_len += stats->fpi_stats[i].fpi_len;
+	}
+
+	if (total_count == 0)
+		return;
+
+	/* the last column is the FPI size as a percentage of the raw size */
+	printf("\n%-27s %20s %20s %20s %8s\n"
+		   "%-27s %20s %20s %20s %8s\n",
+		   "FPI compression", "N", "Raw size", "FPI size", "(%)",
+		   "---------------", "-", "--------", "--------", "---");
+
+	for (i = 0; i < XLOG_FPI_COMPRESSION_METHODS; i++)
+	{
+		XLogFPIStats *fpi_stats = &stats->fpi_stats[i];
+
+		if (fpi_stats->count == 0)
+			continue;
+
+		printf("%-27s "
+			   "%20" INT64_MODIFIER "u "
+			   "%20" INT64_MODIFIER "u "
+			   "%20" INT64_MODIFIER "u (%6.02f)\n",
+			   method_names[i], fpi_stats->count,
+			   fpi_stats->raw_len, fpi_stats->fpi_len,
+			   100 * (double) fpi_stats->fpi_len / fpi_stats->raw_len);
+	}
+
+	printf("%-27s "
+		   "%20" INT64_MODIFIER "u "
+		   "%20" INT64_MODIFIER "u "
+		   "%20" INT64_MODIFIER "u (%6.02f)\n",
+		   "Total", total_count, total_raw_len, total_fpi_len,
+		   100 * (double) total_fpi_len / total_raw_len);
+}
+
 /*
  * Display summary statistics about the records seen so far.
  */
@@ -746,6 +804,8 @@ XLogDumpDisplayStats(XLogDumpConfig *config, XLogStats *stats)
 		   total_rec_len, psprintf("[%.02f%%]", rec_len_pct),
 		   total_fpi_len, psprintf("[%.02f%%]", fpi_len_pct),
 		   total_len, "[100%]");
+
+	XLogDumpDisplayFPIStats(stats);
 }
 
 static void
@@ -779,6 +839,9 @@ usage(void)
 	printf(_("  -z, --stats[=record]   show statistics instead of records\n"
 			 "                         (optionally, show per-record statistics)\n"));
 	printf(_("  --save-fullpage=DIR    save full page images to DIR\n"));
+	printf(_("  --dictionary-dir=DIR   directory with WAL compression dictionaries, needed\n"
+			 "                         to decompress images with --save-fullpage\n"
+			 "                         (default: ./pg_waldict)\n"));
 	printf(_("  -?, --help             show this help, then exit\n"));
 	printf(_("\nReport bugs to <%s>.\n"), PACKAGE_BUGREPORT);
 	printf(_("%s home page: <%s>\n"), PACKAGE_NAME, PACKAGE_URL);
@@ -817,6 +880,7 @@ main(int argc, char **argv)
 		{"version", no_argument, NULL, 'V'},
 		{"stats", optional_argument, NULL, 'z'},
 		{"save-fullpage", required_argument, NULL, 1},
+		{"dictionary-dir", required_argument, NULL, 2},
 		{NULL, 0, NULL, 0}
 	};
 
@@ -869,6 +933,7 @@ main(int argc, char **argv)
 	config.filter_by_relation_forknum = InvalidForkNumber;
 	config.filter_by_fpw = false;
 	config.save_fullpage_path = NULL;
+	config.dict_dir = NULL;
 	config.stats = false;
 	config.stats_per_record = false;
 
@@ -1072,6 +1137,9 @@ main(int argc, char **argv)
 			case 1:
 				config.save_fullpage_path = pg_strdup(optarg);
 				break;
+			case 2:
+				config.dict_dir = pg_strdup(optarg);
+				break;
 			default:
 				goto bad_argument;
 		}
@@ -1205,6 +1273,7 @@ main(int argc, char **argv)
 						   &private);
 	if (!xlogreader_state)
 		pg_fatal("out of memory while allocating a WAL reading processor");
+	xlogreader_state->dict_dir = config.dict_dir;
 
 	/* first find a valid recptr to start from */
 	first_record = XLogFindNextRecord(xlogreader_state, private.startptr);
@@ -0,0 +1,77 @@
+
+# Copyright (c) 2023, PostgreSQL Global Development Group
+
+# Test full-page images compressed with wal_compression = zstd_dict
+use strict;
+use warnings;
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+if (!check_pg_config("#define USE_ZSTD 1"))
+{
+	plan skip_all => 'zstd not supported by this build';
+}
+
+my $node = PostgreSQL::Test::Cluster->new('main');
+$node->init;
+$node->append_conf(
+	'postgresql.conf', q{
+wal_compression = zstd_dict
+});
+$node->start;
+
+$node->safe_psql(
+	'postgres', q{
+CREATE TABLE test_table (id int PRIMARY KEY, val text);
+INSERT INTO test_table
+  SELECT g, md5(g::text) || repeat('x', g % 50) FROM generate_series(1, 50000) g;
+});
+
+my $dict_id = $node->safe_psql('postgres',
+	'SELECT pg_train_wal_dictionary(16384, 1000)');
+is($dict_id, '32768', 'first dictionary installed');
+ok(-f $node->data_dir . '/pg_waldict/00008000.dict',
+	'dictionary file created');
+
+# Generate full-page images compressed with the dictionary.
+my $start_lsn = $node->safe_psql('postgres',
+	'CHECKPOINT; SELECT pg_current_wal_insert_lsn()');
+$node->safe_psql('postgres', 'UPDATE test_table SET val = val || \'y\'');
+my $end_lsn = $node->safe_psql('postgres', 'SELECT pg_current_wal_insert_lsn()');
+
+my ($stdout, $stderr) = run_command(
+	[
+		'pg_waldump', '--stats',
+		'--path', $node->data_dir . '/pg_wal',
+		'--start', $start_lsn, '--end', $end_lsn
+	]);
+like(
+	$stdout,
+	qr/^zstd_dict\s+[1-9][0-9]*\s+[0-9]+\s+[0-9]+/m,
+	'pg_waldump --stats reports images compressed with the dictionary');
+
+my $tmp_folder = PostgreSQL::Test::Utils::tempdir;
+$node->command_ok(
+	[
+		'pg_waldump', '--quiet',
+		'--path', $node->data_dir . '/pg_wal',
+		'--start', $start_lsn, '--end', $end_lsn,
+		'--dictionary-dir', $node->data_dir . '/pg_waldict',
+		'--save-fullpage', "$tmp_folder/raw"
+	],
+	'pg_waldump decompresses images with the dictionary');
+my @files = glob("$tmp_folder/raw/*");
+ok(@files > 0, 'full-page images saved');
+
+# Crash recovery must be able to restore the images.
+my $expected = $node->safe_psql('postgres',
+	'SELECT count(*), sum(length(val)) FROM test_table');
+$node->stop('immediate');
+$node->start;
+is( $node->safe_psql(
+		'postgres', 'SELECT count(*), sum(length(val)) FROM test_table'),
+	$expected,
+	'data intact after crash recovery');
+
+done_testing();
@@ -0,0 +1,58 @@
+/*
+ * csnlog.h
+ *
+ * Commit-sequence-number log, used by csn_snapshots
+ *
+ * Portions Copyright (c) 1996-2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/access/csnlog.h
+ */
+#ifndef CSNLOG_H
+#define CSNLOG_H
+
+#include "access/transam.h"
+
+/* Number of SLRU buffers to use for the CSN log */
+#define NUM_CSNLOG_BUFFERS	32
+
+/*
+ * Special commit sequence numbers.  A zeroed CSN log entry
+ * (InvalidCommitSeqNo) means the transaction is still in progress.
+ * CommittingCommitSeqNo is set transiently while a transaction whose XIDs
+ * span several CSN log pages is being stamped; readers wait for it to go
+ * away.  FrozenCommitSeqNo marks transactions that committed before the
+ * server started, which are visible to every snapshot.
+ */
+#define AbortedCommitSeqNo		((CommitSeqNo) 1)
+#define CommittingCommitSeqNo	((CommitSeqNo) 2)
+#define FrozenCommitSeqNo		((CommitSeqNo) 3)
+#define FirstNormalCommitSeqNo	((CommitSeqNo) 4)
+
+#define CommitSeqNoIsCommitted(csn)	((csn) >= FrozenCommitSeqNo)
+
+/* GUC variable */
+extern PGDLLIMPORT bool csn_snapshots;
+
+extern void CSNLogSetCommitted(TransactionId xid, int nsubxids,
+							   TransactionId *subxids);
+extern void CSNLogSetAborted(TransactionId xid, int nsubxids,
+							 TransactionId *subxids);
+extern void CSNLogSetInProgress(TransactionId xid, int nsubxids,
+								TransactionId *subxids);
+extern CommitSeqNo CSNLogGetCommitSeqNo(TransactionId xid);
+
+extern CommitSeqNo CSNLogGetNextCommitSeqNo(void);
+extern TransactionId CSNLogGetOldestActiveXid(void);
+extern FullTransactionId CSNLogGetNextFullXid(void);
+extern void CSNLogSetNextFullXid(FullTransactionId nextXid);
+
+extern Size CSNLogShmemSize(void);
+extern void CSNLogShmemInit(void);
+extern void BootStrapCSNLog(void);
+extern void StartupCSNLog(TransactionId oldestActiveXID);
+extern void CheckPointCSNLog(void);
+extern void ExtendCSNLog(TransactionId newestXact);
+extern void TruncateCSNLog(void);
+
+#endif							/* CSNLOG_H */
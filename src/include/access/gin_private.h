@@ -85,6 +85,9 @@ typedef struct GinState
 	bool		canPartialMatch[INDEX_MAX_KEYS];
 	/* Collations to pass to the support functions */
 	Oid			supportCollation[INDEX_MAX_KEYS];
+
+	/* has autovacuum been asked to clean the pending list? (ginfast.c) */
+	bool		cleanupRequested;
 } GinState;
 
 
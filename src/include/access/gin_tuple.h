@@ -0,0 +1,56 @@
+/*--------------------------------------------------------------------------
+ * gin_tuple.h
+ *	  tuple format used to pass data between parallel GIN build workers
+ *
+ *	Copyright (c) 2006-2023, PostgreSQL Global Development Group
+ *
+ *	src/include/access/gin_tuple.h
+ *--------------------------------------------------------------------------
+ */
+#ifndef GIN_TUPLE_H
+#define GIN_TUPLE_H
+
+#include "access/ginblock.h"
+#include "storage/itemptr.h"
+#include "utils/sortsupport.h"
+
+/*
+ * Data for one key in a parallel GIN index build: the key itself, and a
+ * sorted list of heap TIDs it was extracted from.  Workers pass these to
+ * the leader through a tuplesort, sorted by key and then by first TID.
+ *
+ * The key value is stored at the first MAXALIGN'd offset in "data", in its
+ * datum form for pass-by-value types and as the pointed-to bytes otherwise,
+ * so that it can be used in place whatever its type's alignment.  The TID
+ * list follows it, at the next MAXALIGN'd offset.  Use GinTupleGetKey and
+ * GinTupleGetFirst to find them.
+ */
+typedef struct GinTuple
+{
+	int			tuplen;			/* length of the whole tuple */
+	OffsetNumber attrnum;		/* attnum of index key */
+	int			keylen;			/* bytes in data for key value */
+	int16		typlen;			/* typlen for key */
+	bool		typbyval;		/* typbyval for key */
+	signed char category;		/* category: normal or NULL? */
+	int			nitems;			/* number of TIDs in the data */
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+} GinTuple;
+
+static inline char *
+GinTupleGetKey(GinTuple *tup)
+{
+	return (char *) tup + MAXALIGN(offsetof(GinTuple, data));
+}
+
+static inline ItemPointer
+GinTupleGetFirst(GinTuple *tup)
+{
+	return (ItemPointer) ((char *) tup +
+						  MAXALIGN(MAXALIGN(offsetof(GinTuple, data)) +
+								   tup->keylen));
+}
+
+extern int	_gin_compare_tuples(GinTuple *a, GinTuple *b, SortSupport ssup);
+
+#endif							/* GIN_TUPLE_H */
@@ -64,6 +64,15 @@ typedef struct HeapScanDescData
 
 	BufferAccessStrategy rs_strategy;	/* access strategy for reads */
 
+	/*
+	 * Streaming read used by forward sequential scans, NULL if not used.
+	 * rs_prefetch_block is the last block handed to the stream; when it is
+	 * InvalidBlockNumber in an initialized scan, the stream continues after
+	 * rs_cblock.
+	 */
+	struct StreamingRead *rs_read_stream;
+	BlockNumber rs_prefetch_block;
+
 	HeapTupleData rs_ctup;		/* current tuple in scan, if any */
 
 	/*
@@ -219,6 +228,7 @@ extern void heap_endscan(TableScanDesc sscan);
 extern HeapTuple heap_getnext(TableScanDesc sscan, ScanDirection direction);
 extern bool heap_getnextslot(TableScanDesc sscan,
 							 ScanDirection direction, struct TupleTableSlot *slot);
+extern bool heap_prefetch_next(TableScanDesc sscan);
 extern void heap_set_tidrange(TableScanDesc sscan, ItemPointer mintid,
 							  ItemPointer maxtid);
 extern bool heap_getnextslot_tidrange(TableScanDesc sscan,
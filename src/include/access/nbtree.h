@@ -82,6 +82,7 @@ typedef BTPageOpaqueData *BTPageOpaque;
 #define BTP_HAS_GARBAGE (1 << 6)	/* page has LP_DEAD tuples (deprecated) */
 #define BTP_INCOMPLETE_SPLIT (1 << 7)	/* right sibling's downlink is missing */
 #define BTP_HAS_FULLXID	(1 << 8)	/* contains BTDeletedPageData */
+#define BTP_PREFIX		(1 << 9)	/* contains BTPagePrefixData */
 
 /*
  * The max allowed value of a cycle ID is a bit less than 64K.  This is
@@ -92,6 +93,47 @@ typedef BTPageOpaqueData *BTPageOpaque;
  */
 #define MAX_BT_CYCLE_ID		0xFF7F
 
+/*
+ * A leaf page of an index that uses prefix compression may have a key
+ * prefix: leading bytes of the first key attribute that every key in the
+ * page's key space begins with.  The page's non-pivot tuples are stored with
+ * the prefix stripped from their first attribute, while its high key is
+ * stored whole.  Such pages have BTP_PREFIX set, and store the prefix in a
+ * BTPagePrefixData that follows BTPageOpaqueData in the special space.
+ * Pages without a prefix keep the usual special space size, so indexes that
+ * don't use prefix compression are unaffected.  See "Notes about prefix
+ * compression" in the README.
+ *
+ * Prefixes shorter than BT_MIN_PREFIX_LEN aren't worth the trouble, since
+ * alignment padding often eats up what stripping them would save.
+ */
+typedef struct BTPagePrefixData
+{
+	uint16		bpp_len;		/* prefix length in bytes */
+	char		bpp_data[FLEXIBLE_ARRAY_MEMBER];	/* prefix bytes */
+} BTPagePrefixData;
+
+typedef BTPagePrefixData *BTPagePrefix;
+
+#define BTPageGetPrefix(page) \
+	((BTPagePrefix) ((char *) BTPageGetOpaque(page) + sizeof(BTPageOpaqueData)))
+
+#define BT_MIN_PREFIX_LEN	MAXIMUM_ALIGNOF
+#define BT_MAX_PREFIX_LEN	128
+
+/* Special space size of a page with a prefix of "len" bytes */
+#define BTPrefixSpecialSize(len) \
+	MAXALIGN(sizeof(BTPageOpaqueData) + \
+			 offsetof(BTPagePrefixData, bpp_data) + (len))
+
+/*
+ * Upper bound on how much a tuple from a page with a prefix of "len" bytes
+ * grows when the prefix is put back: the prefix itself, a 1-byte varlena
+ * header that becomes a 4-byte one, and alignment padding.
+ */
+#define BTPrefixMaxGrowth(len) \
+	MAXALIGN((len) + VARHDRSZ + MAXIMUM_ALIGNOF)
+
 
 /*
  * The Meta page is always the first page in the btree index.
@@ -160,16 +202,24 @@ typedef struct BTMetaPageData
  * There are rare cases where _bt_truncate() will need to enlarge
  * a heap index tuple to make space for a tiebreaker heap TID
  * attribute, which we account for here.
+ *
+ * A page with a key prefix has less space: its special space is larger,
+ * and the new high key that splitting it creates is built from tuples
+ * with the prefix put back (see BTPageReservedSpace).  Page splits use
+ * BTMaxItemSizeReserved to find the limit for a new page whose prefix
+ * differs from that of the page being split.
  */
-#define BTMaxItemSize(page) \
+#define BTMaxItemSizeReserved(page, reserved) \
 	(MAXALIGN_DOWN((PageGetPageSize(page) - \
 					MAXALIGN(SizeOfPageHeaderData + 3*sizeof(ItemIdData)) - \
-					MAXALIGN(sizeof(BTPageOpaqueData))) / 3) - \
+					(reserved)) / 3) - \
 					MAXALIGN(sizeof(ItemPointerData)))
+#define BTMaxItemSize(page) \
+	BTMaxItemSizeReserved(page, BTPageReservedSpace(page))
 #define BTMaxItemSizeNoHeapTid(page) \
 	MAXALIGN_DOWN((PageGetPageSize(page) - \
 				   MAXALIGN(SizeOfPageHeaderData + 3*sizeof(ItemIdData)) - \
-				   MAXALIGN(sizeof(BTPageOpaqueData))) / 3)
+				   BTPageReservedSpace(page)) / 3)
 
 /*
  * MaxTIDsPerBTreePage is an upper bound on the number of heap TIDs tuples
@@ -226,6 +276,56 @@ typedef struct BTMetaPageData
 #define P_HAS_GARBAGE(opaque)	(((opaque)->btpo_flags & BTP_HAS_GARBAGE) != 0)
 #define P_INCOMPLETE_SPLIT(opaque)	(((opaque)->btpo_flags & BTP_INCOMPLETE_SPLIT) != 0)
 #define P_HAS_FULLXID(opaque)	(((opaque)->btpo_flags & BTP_HAS_FULLXID) != 0)
+#define P_HAS_PREFIX(opaque)	(((opaque)->btpo_flags & BTP_PREFIX) != 0)
+
+/*
+ * Does the size of the page's special space agree with its BTP_PREFIX flag?
+ * Callers must already know that the special space is large enough to hold
+ * a BTPageOpaqueData.
+ */
+static inline bool
+BTPageSpecialSizeIsValid(Page page)
+{
+	BTPageOpaque opaque = BTPageGetOpaque(page);
+	Size		specialsize = PageGetSpecialSize(page);
+	BTPagePrefix prefix;
+
+	if (!P_HAS_PREFIX(opaque))
+		return specialsize == MAXALIGN(sizeof(BTPageOpaqueData));
+
+	if (specialsize < BTPrefixSpecialSize(0) ||
+		specialsize > BTPrefixSpecialSize(BT_MAX_PREFIX_LEN))
+		return false;
+	prefix = BTPageGetPrefix(page);
+	return prefix->bpp_len >= BT_MIN_PREFIX_LEN &&
+		prefix->bpp_len <= BT_MAX_PREFIX_LEN &&
+		specialsize == BTPrefixSpecialSize(prefix->bpp_len);
+}
+
+/*
+ * Space on a leaf page with a prefix of "prefixlen" bytes (or on the page)
+ * that can't be used for the three tuples that every page must be able to
+ * hold; see BTMaxItemSize.  A page with a key prefix needs room for its
+ * larger special space, and for splitting it: the new high key is made from
+ * tuples with the prefix put back.
+ */
+static inline Size
+BTPrefixReservedSpace(int prefixlen)
+{
+	if (prefixlen == 0)
+		return MAXALIGN(sizeof(BTPageOpaqueData));
+
+	return BTPrefixSpecialSize(prefixlen) + BTPrefixMaxGrowth(prefixlen);
+}
+
+static inline Size
+BTPageReservedSpace(Page page)
+{
+	if (!P_HAS_PREFIX(BTPageGetOpaque(page)))
+		return BTPrefixReservedSpace(0);
+
+	return BTPrefixReservedSpace(BTPageGetPrefix(page)->bpp_len);
+}
 
 /*
  * BTDeletedPageData is the page contents of a deleted page
@@ -1052,6 +1152,35 @@ typedef struct BTScanOpaqueData
 	BTArrayKeyInfo *arrayKeys;	/* info about each equality-type array key */
 	MemoryContext arrayContext; /* scan-lifespan context for array data */
 
+	/*
+	 * Skip scan support.  When the scan has no keys on the index's first
+	 * column but does have keys on the second, arrayKeyData[0] is an extra
+	 * equality key on the first column, and the scan is run once for each
+	 * distinct value found there (see _bt_preprocess_array_keys).
+	 */
+	bool		skipScan;		/* skip over first column's values? */
+	bool		skipStarted;	/* skipValue/skipIsNull valid? */
+	bool		skipIsNull;		/* current first column value is NULL */
+	Datum		skipValue;		/* current first column value, if not NULL */
+	bool		skipMarkStarted;	/* skipStarted as of btmarkpos */
+	bool		skipMarkIsNull; /* skipIsNull as of btmarkpos */
+	Datum		skipMarkValue;	/* skipValue as of btmarkpos */
+	StrategyNumber skipStrategy;	/* '=' while skipping; '>=' or '<=' once
+									 * skipping was given up */
+	StrategyNumber skipMarkStrategy;	/* skipStrategy as of btmarkpos */
+	StrategyNumber skipProcStrategy;	/* operator of the key's sk_func */
+	int			skipFutile;		/* consecutive values found on the page the
+								 * previous primitive scan ended on */
+
+	/*
+	 * Leaf page to try before descending from the root at the start of each
+	 * primitive index scan; see _bt_search_lastleaf.  This is kept across
+	 * rescans, so that nestloop inner scans benefit as well as scans with
+	 * array keys or skipping.
+	 */
+	BlockNumber lastLeafPage;	/* last leaf page read, or InvalidBlockNumber */
+	int			lastLeafMisses; /* consecutive times it was the wrong page */
+
 	/* info about killed items if any (killedItems is NULL if never used) */
 	int		   *killedItems;	/* currPos.items indexes of killed items */
 	int			numKilled;		/* number of currently stored items */
@@ -1059,7 +1188,8 @@ typedef struct BTScanOpaqueData
 	/*
 	 * If we are doing an index-only scan, these are the tuple storage
 	 * workspaces for the currPos and markPos respectively.  Each is of size
-	 * BLCKSZ, so it can hold as much as a full page's worth of tuples.
+	 * BTScanTuplesSize, so it can hold as much as a full page's worth of
+	 * tuples.
 	 */
 	char	   *currTuples;		/* tuple storage for currPos */
 	char	   *markTuples;		/* tuple storage for markPos */
@@ -1080,6 +1210,16 @@ typedef struct BTScanOpaqueData
 
 typedef BTScanOpaqueData *BTScanOpaque;
 
+/*
+ * Size of each of an index-only scan's tuple storage workspaces.  Tuples
+ * from leaf pages with a key prefix are saved with the prefix put back, so
+ * a page's worth of them can take up more than a page.
+ */
+#define BTScanTuplesSize(rel) \
+	(_bt_prefix_eligible(rel) ? \
+	 BLCKSZ + MaxIndexTuplesPerPage * BTPrefixMaxGrowth(BT_MAX_PREFIX_LEN) : \
+	 BLCKSZ)
+
 /*
  * We use some private sk_flags bits in preprocessed scan keys.  We're allowed
  * to use bits 16-31 (see skey.h).  The uppermost bits are copied from the
@@ -1097,6 +1237,7 @@ typedef struct BTOptions
 	int			fillfactor;		/* page fill factor in percent (0..100) */
 	float8		vacuum_cleanup_index_scale_factor;	/* deprecated */
 	bool		deduplicate_items;	/* Try to deduplicate items? */
+	bool		prefix_compression; /* Strip key prefixes from leaf tuples? */
 } BTOptions;
 
 #define BTGetFillFactor(relation) \
@@ -1112,6 +1253,11 @@ typedef struct BTOptions
 				 relation->rd_rel->relam == BTREE_AM_OID), \
 	((relation)->rd_options ? \
 	 ((BTOptions *) (relation)->rd_options)->deduplicate_items : true))
+#define BTGetPrefixCompression(relation) \
+	(AssertMacro(relation->rd_rel->relkind == RELKIND_INDEX && \
+				 relation->rd_rel->relam == BTREE_AM_OID), \
+	((relation)->rd_options ? \
+	 ((BTOptions *) (relation)->rd_options)->prefix_compression : false))
 
 /*
  * Constant definition for progress reporting.  Phase numbers must match
@@ -1218,6 +1364,8 @@ extern void _bt_unlockbuf(Relation rel, Buffer buf);
 extern bool _bt_conditionallockbuf(Relation rel, Buffer buf);
 extern void _bt_upgradelockbufcleanup(Relation rel, Buffer buf);
 extern void _bt_pageinit(Page page, Size size);
+extern void _bt_pageinit_prefix(Page page, Size size, const char *prefix,
+								int prefixlen);
 extern void _bt_delitems_vacuum(Relation rel, Buffer buf,
 								OffsetNumber *deletable, int ndeletable,
 								BTVacuumPosting *updatable, int nupdatable);
@@ -1229,6 +1377,23 @@ extern void _bt_pendingfsm_init(Relation rel, BTVacState *vstate,
 								bool cleanuponly);
 extern void _bt_pendingfsm_finalize(Relation rel, BTVacState *vstate);
 
+/*
+ * prototypes for functions in nbtprefix.c
+ */
+extern bool _bt_prefix_eligible(Relation rel);
+extern bool _bt_prefix_enabled(Relation rel);
+extern int	_bt_prefix_match(Relation rel, IndexTuple itup, const char *prefix,
+							 int prefixlen);
+extern int	_bt_prefix_common(Relation rel, IndexTuple lowkey,
+							  IndexTuple highkey, char *prefix);
+extern IndexTuple _bt_prefix_convert(Relation rel, IndexTuple itup,
+									 const char *prefix, int oldlen,
+									 int newlen);
+extern IndexTuple _bt_prefix_expand(Relation rel, Page page, IndexTuple itup);
+extern bool _bt_prefix_alike(Relation rel, IndexTuple a, IndexTuple b);
+extern int32 _bt_prefix_cmp(Relation rel, Page page, Datum datum,
+							ScanKey scankey);
+
 /*
  * prototypes for functions in nbtsearch.c
  */
@@ -1240,6 +1405,7 @@ extern Buffer _bt_moveright(Relation rel, Relation heaprel, BTScanInsert key,
 extern OffsetNumber _bt_binsrch_insert(Relation rel, BTInsertState insertstate);
 extern int32 _bt_compare(Relation rel, BTScanInsert key, Page page, OffsetNumber offnum);
 extern bool _bt_first(IndexScanDesc scan, ScanDirection dir);
+extern bool _bt_skip_probe(IndexScanDesc scan, ScanDirection dir);
 extern bool _bt_next(IndexScanDesc scan, ScanDirection dir);
 extern Buffer _bt_get_endpoint(Relation rel, uint32 level, bool rightmost,
 							   Snapshot snapshot);
@@ -1250,7 +1416,7 @@ extern Buffer _bt_get_endpoint(Relation rel, uint32 level, bool rightmost,
 extern BTScanInsert _bt_mkscankey(Relation rel, IndexTuple itup);
 extern void _bt_freestack(BTStack stack);
 extern void _bt_preprocess_array_keys(IndexScanDesc scan);
-extern void _bt_start_array_keys(IndexScanDesc scan, ScanDirection dir);
+extern bool _bt_start_array_keys(IndexScanDesc scan, ScanDirection dir);
 extern bool _bt_advance_array_keys(IndexScanDesc scan, ScanDirection dir);
 extern void _bt_mark_array_keys(IndexScanDesc scan);
 extern void _bt_restore_array_keys(IndexScanDesc scan);
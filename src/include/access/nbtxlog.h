@@ -138,14 +138,22 @@ typedef struct xl_btree_insert
  * here, the concept and goals are exactly the same.  See _bt_swap_posting()
  * for details on posting list splits.
  *
+ * A leaf page split can give the left page a longer key prefix than the
+ * original page had (see "Notes about prefix compression" in the README).
+ * Its tuples must then be stored with more of their key stripped, which
+ * REDO can't do, so the left page is always logged as a full-page image in
+ * that case.
+ *
  * Backup Blk 1: new right page
  *
- * The right page's data portion contains the right page's tuples in the form
- * used by _bt_restore_page.  This includes the new item, if it's the _R
- * variant.  The right page's tuples also include the right page's high key
- * with either variant (moved from the left/original page during the split),
- * unless the split happened to be of the rightmost page on its level, where
- * there is no high key for new right page.
+ * The right page's data portion starts with its key prefix, which is
+ * rightprefixlen bytes long (0 means that it has no prefix).  The right
+ * page's tuples follow in the form used by _bt_restore_page.  This includes
+ * the new item, if it's the _R variant.  The right page's tuples also
+ * include the right page's high key with either variant (moved from the
+ * left/original page during the split), unless the split happened to be of
+ * the rightmost page on its level, where there is no high key for new right
+ * page.
  *
  * Backup Blk 2: next block (orig page's rightlink), if any
  * Backup Blk 3: child's left sibling, if non-leaf split
@@ -156,9 +164,10 @@ typedef struct xl_btree_split
 	OffsetNumber firstrightoff; /* first origpage item on rightpage */
 	OffsetNumber newitemoff;	/* new item's offset */
 	uint16		postingoff;		/* offset inside orig posting tuple */
+	uint16		rightprefixlen; /* length of right page's key prefix */
 } xl_btree_split;
 
-#define SizeOfBtreeSplit	(offsetof(xl_btree_split, postingoff) + sizeof(uint16))
+#define SizeOfBtreeSplit	(offsetof(xl_btree_split, rightprefixlen) + sizeof(uint16))
 
 /*
  * When page is deduplicated, consecutive groups of tuples with equal keys are
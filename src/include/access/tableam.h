@@ -344,6 +344,15 @@ typedef struct TableAmRoutine
 									 ScanDirection direction,
 									 TupleTableSlot *slot);
 
+	/*
+	 * Optional: start reading whatever the next forward scan_getnextslot()
+	 * call on `scan` will need, and return true if that call can be expected
+	 * to complete without waiting for I/O.  Used by asynchronous execution to
+	 * overlap the I/O of several scans.  AMs that don't provide this are
+	 * treated as always ready.
+	 */
+	bool		(*scan_prefetch_next) (TableScanDesc scan);
+
 	/*-----------
 	 * Optional functions to provide scanning for ranges of ItemPointers.
 	 * Implementations must either provide both of these functions, or neither
@@ -1066,6 +1075,20 @@ table_scan_getnextslot(TableScanDesc sscan, ScanDirection direction, TupleTableS
 	return sscan->rs_rd->rd_tableam->scan_getnextslot(sscan, direction, slot);
 }
 
+/*
+ * Start reading the data the next forward scan step of `scan` will need.
+ * Returns true if no I/O had to be started for it, ie. if the next
+ * table_scan_getnextslot() call is not expected to wait.
+ */
+static inline bool
+table_scan_prefetch_next(TableScanDesc sscan)
+{
+	if (sscan->rs_rd->rd_tableam->scan_prefetch_next == NULL)
+		return true;
+
+	return sscan->rs_rd->rd_tableam->scan_prefetch_next(sscan);
+}
+
 /* ----------------------------------------------------------------------------
  * TID Range scanning related functions.
  * ----------------------------------------------------------------------------
@@ -37,6 +37,7 @@ extern PGDLLIMPORT int max_wal_size_mb;
 extern PGDLLIMPORT int wal_keep_size_mb;
 extern PGDLLIMPORT int max_slot_wal_keep_size_mb;
 extern PGDLLIMPORT int XLOGbuffers;
+extern PGDLLIMPORT int wal_insert_locks;
 extern PGDLLIMPORT int XLogArchiveTimeout;
 extern PGDLLIMPORT int wal_retrieve_retry_interval;
 extern PGDLLIMPORT char *XLogArchiveCommand;
@@ -46,6 +47,7 @@ extern PGDLLIMPORT bool wal_log_hints;
 extern PGDLLIMPORT int wal_compression;
 extern PGDLLIMPORT bool wal_init_zero;
 extern PGDLLIMPORT bool wal_recycle;
+extern PGDLLIMPORT bool wal_group_commit;
 extern PGDLLIMPORT bool *wal_consistency_checking;
 extern PGDLLIMPORT char *wal_consistency_checking_string;
 extern PGDLLIMPORT bool log_checkpoints;
@@ -54,6 +56,9 @@ extern PGDLLIMPORT int wal_decode_buffer_size;
 
 extern PGDLLIMPORT int CheckPointSegments;
 
+/* upper limit for wal_insert_locks */
+#define MAX_XLOGINSERT_LOCKS 256
+
 /* Archive modes */
 typedef enum ArchiveMode
 {
@@ -77,7 +82,8 @@ typedef enum WalCompression
 	WAL_COMPRESSION_NONE = 0,
 	WAL_COMPRESSION_PGLZ,
 	WAL_COMPRESSION_LZ4,
-	WAL_COMPRESSION_ZSTD
+	WAL_COMPRESSION_ZSTD,
+	WAL_COMPRESSION_ZSTD_DICT
 } WalCompression;
 
 /* Recovery states */
@@ -199,6 +205,7 @@ extern XLogRecPtr XLogInsertRecord(struct XLogRecData *rdata,
 								   int num_fpi,
 								   bool topxid_included);
 extern void XLogFlush(XLogRecPtr record);
+extern void XLogFlushCommit(XLogRecPtr record);
 extern bool XLogBackgroundFlush(void);
 extern bool XLogNeedsFlush(XLogRecPtr record);
 extern int	XLogFileInit(XLogSegNo logsegno, TimeLineID logtli);
@@ -31,7 +31,7 @@
 /*
  * Each page of XLOG file has a header like this:
  */
-#define XLOG_PAGE_MAGIC 0xD113	/* can be used as WAL version indicator */
+#define XLOG_PAGE_MAGIC 0xD115	/* can be used as WAL version indicator */
 
 typedef struct XLogPageHeaderData
 {
@@ -150,6 +150,14 @@ typedef XLogLongPageHeaderData *XLogLongPageHeader;
 #define XLOGDIR				"pg_wal"
 #define XLOG_CONTROL_FILE	"global/pg_control"
 
+/*
+ * Directory holding the zstd dictionaries used for wal_compression =
+ * zstd_dict (relative to $PGDATA), and the first dictionary ID assigned.
+ * IDs below 32768 are reserved by the zstd dictionary format.
+ */
+#define XLOG_DICT_DIR		"pg_waldict"
+#define XLOG_DICT_FIRST_ID	32768
+
 /*
  * These macros encapsulate knowledge about the exact layout of XLog file
  * names, timeline history file names, and archive-status file names.
@@ -235,6 +243,20 @@ TLHistoryFilePath(char *path, TimeLineID tli)
 	snprintf(path, MAXPGPATH, XLOGDIR "/%08X.history", tli);
 }
 
+static inline void
+XLogDictFilePath(char *path, const char *dir, uint32 dict_id)
+{
+	snprintf(path, MAXPGPATH, "%s/%08X.dict", dir, dict_id);
+}
+
+static inline bool
+IsXLogDictFileName(const char *fname)
+{
+	return (strlen(fname) == 8 + strlen(".dict") &&
+			strspn(fname, "0123456789ABCDEF") == 8 &&
+			strcmp(fname + 8, ".dict") == 0);
+}
+
 static inline void
 StatusFilePath(char *path, const char *xlog, const char *suffix)
 {
@@ -297,6 +319,14 @@ typedef struct xl_overwrite_contrecord
 	TimestampTz overwrite_time;
 } xl_overwrite_contrecord;
 
+/* WAL compression dictionary, logged when it is installed */
+typedef struct xl_wal_dictionary
+{
+	uint32		dict_id;
+	uint32		dict_size;
+	/* dictionary follows */
+} xl_wal_dictionary;
+
 /* End of recovery mark, when we don't do an END_OF_RECOVERY checkpoint */
 typedef struct xl_end_of_recovery
 {
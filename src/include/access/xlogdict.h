@@ -0,0 +1,31 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogdict.h
+ *		Dictionaries for compressing full-page images in WAL.
+ *
+ * Portions Copyright (c) 2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *		src/include/access/xlogdict.h
+ *-------------------------------------------------------------------------
+ */
+#ifndef XLOGDICT_H
+#define XLOGDICT_H
+
+#include "access/xlogreader.h"
+
+/* limits on the size of a WAL compression dictionary */
+#define XLOG_DICT_MIN_SIZE	(4 * 1024)
+#define XLOG_DICT_MAX_SIZE	(256 * 1024)
+
+extern Size XLogDictShmemSize(void);
+extern void XLogDictShmemInit(void);
+extern void StartupXLogDict(void);
+
+extern int32 XLogDictCompress(const char *source, int32 slen,
+							  char *dest, int32 capacity);
+extern uint32 XLogDictInstall(char *dict, uint32 dict_size);
+extern void XLogDictRedo(XLogReaderState *record);
+
+#endif							/* XLOGDICT_H */
@@ -316,6 +316,17 @@ struct XLogReaderState
 	 * data.
 	 */
 	bool		nonblocking;
+
+	/*
+	 * Directory to load dictionaries for BKPIMAGE_COMPRESS_ZSTD_DICT images
+	 * from.  NULL means XLOG_DICT_DIR, relative to the current directory.
+	 */
+	char	   *dict_dir;
+
+	/* Decompression state for the most recently used dictionary */
+	uint32		zstd_dict_id;
+	void	   *zstd_ddict;
+	void	   *zstd_dctx;
 };
 
 /*
@@ -161,10 +161,13 @@ typedef struct XLogRecordBlockImageHeader
 #define BKPIMAGE_COMPRESS_PGLZ	0x04
 #define BKPIMAGE_COMPRESS_LZ4	0x08
 #define BKPIMAGE_COMPRESS_ZSTD	0x10
+#define BKPIMAGE_COMPRESS_ZSTD_DICT	0x20	/* zstd with a dictionary from
+											 * XLOG_DICT_DIR, identified by
+											 * the frame's dictionary ID */
 
 #define	BKPIMAGE_COMPRESSED(info) \
 	((info & (BKPIMAGE_COMPRESS_PGLZ | BKPIMAGE_COMPRESS_LZ4 | \
-			  BKPIMAGE_COMPRESS_ZSTD)) != 0)
+			  BKPIMAGE_COMPRESS_ZSTD | BKPIMAGE_COMPRESS_ZSTD_DICT)) != 0)
 
 /*
  * Extra header information used when page image has "hole" and
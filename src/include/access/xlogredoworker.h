@@ -0,0 +1,38 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogredoworker.h
+ *		Declarations for parallel WAL replay.
+ *
+ * Portions Copyright (c) 2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *		src/include/access/xlogredoworker.h
+ *-------------------------------------------------------------------------
+ */
+#ifndef XLOGREDOWORKER_H
+#define XLOGREDOWORKER_H
+
+#include "access/xlogreader.h"
+
+/* GUCs */
+extern PGDLLIMPORT int recovery_parallel_workers;
+
+/* upper limit for recovery_parallel_workers */
+#define MAX_PARALLEL_REDO_WORKERS 64
+
+/* true in a parallel redo worker process */
+extern PGDLLIMPORT bool IsParallelRedoWorker;
+
+extern Size ParallelRedoShmemSize(void);
+extern void ParallelRedoShmemInit(void);
+
+/* functions called by the startup process */
+extern bool ParallelRedoDispatch(XLogReaderState *record);
+extern bool ParallelRedoIdle(void);
+extern void ParallelRedoWaitAll(void);
+extern void ParallelRedoShutdown(void);
+
+extern void ParallelRedoWorkerMain(Datum main_arg);
+
+#endif							/* XLOGREDOWORKER_H */
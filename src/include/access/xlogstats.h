@@ -25,6 +25,25 @@ typedef struct XLogRecStats
 	uint64		fpi_len;
 } XLogRecStats;
 
+/* Full-page images, by compression method */
+typedef enum XLogFPICompression
+{
+	XLOG_FPI_UNCOMPRESSED = 0,
+	XLOG_FPI_PGLZ,
+	XLOG_FPI_LZ4,
+	XLOG_FPI_ZSTD,
+	XLOG_FPI_ZSTD_DICT
+} XLogFPICompression;
+
+#define XLOG_FPI_COMPRESSION_METHODS	(XLOG_FPI_ZSTD_DICT + 1)
+
+typedef struct XLogFPIStats
+{
+	uint64		count;
+	uint64		raw_len;		/* length of the images, without hole */
+	uint64		fpi_len;		/* length stored in WAL */
+} XLogFPIStats;
+
 typedef struct XLogStats
 {
 	uint64		count;
@@ -34,6 +53,7 @@ typedef struct XLogStats
 #endif
 	XLogRecStats rmgr_stats[RM_MAX_ID + 1];
 	XLogRecStats record_stats[RM_MAX_ID + 1][MAX_XLINFO_TYPES];
+	XLogFPIStats fpi_stats[XLOG_FPI_COMPRESSION_METHODS];
 } XLogStats;
 
 extern void XLogRecGetLen(XLogReaderState *record, uint32 *rec_len,
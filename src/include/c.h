@@ -621,7 +621,7 @@ typedef double float8;
 
 /*
  * Oid, RegProcedure, TransactionId, SubTransactionId, MultiXactId,
- * CommandId
+ * CommandId, CommitSeqNo
  */
 
 /* typedef Oid is in postgres_ext.h */
@@ -652,6 +652,11 @@ typedef uint32 CommandId;
 #define FirstCommandId	((CommandId) 0)
 #define InvalidCommandId	(~(CommandId)0)
 
+/* commit sequence number, see access/csnlog.h */
+typedef uint64 CommitSeqNo;
+
+#define InvalidCommitSeqNo	((CommitSeqNo) 0)
+
 
 /* ----------------
  *		Variable-length datatypes all share the 'struct varlena' header.
@@ -30,4 +30,12 @@ extern DestReceiver *CreateTransientRelDestReceiver(Oid transientoid);
 
 extern bool MatViewIncrementalMaintenanceIsEnabled(void);
 
+extern void SetMatViewIncrementalMaintenance(Relation matviewRel, bool enable);
+extern void MatViewResetPendingMaintenance(Oid matviewOid);
+extern void PreCommit_MatViewMaintenance(void);
+extern void AtEOXact_MatViewMaintenance(bool isCommit);
+extern void AtEOSubXact_MatViewMaintenance(bool isCommit,
+										   SubTransactionId mySubid,
+										   SubTransactionId parentSubid);
+
 #endif							/* MATVIEW_H */
@@ -0,0 +1,135 @@
+/*-------------------------------------------------------------------------
+ * execBatch.h
+ *		Support for batch (vectorized) execution
+ *
+ * In batch mode a scan hands its consumer up to EXEC_BATCH_SIZE rows at a
+ * time, stored column-wise in a TupleBatch, instead of one TupleTableSlot
+ * per ExecProcNode() call.  Expressions over such batches are compiled into
+ * BatchExpr trees, which evaluate one operator for all rows of the batch
+ * before moving on to the next, rather than running the whole expression
+ * program once per row.
+ *
+ * Only pass-by-value datatypes are supported, so that values can be copied
+ * out of the scan slot without regard for buffer pins or memory contexts.
+ * Anything else makes the plan fall back to row-at-a-time execution.
+ *
+ * Portions Copyright (c) 1996-2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *		src/include/executor/execBatch.h
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef EXECBATCH_H
+#define EXECBATCH_H
+
+#include "fmgr.h"
+#include "nodes/execnodes.h"
+
+/* Maximum number of rows in a batch */
+#define EXEC_BATCH_SIZE		1024
+
+/* GUC parameter */
+extern PGDLLIMPORT bool enable_batch_execution;
+
+/*
+ * A batch of rows in columnar form.
+ *
+ * values[i] and isnull[i] hold column i + 1 (that is, they are indexed by
+ * attribute number - 1) for all rows of the batch; columns nobody asked for
+ * are NULL.  Rows that have been filtered out are not removed, instead
+ * sel[0 .. nsel - 1] lists the row numbers still alive, in ascending order.
+ */
+typedef struct TupleBatch
+{
+	int			natts;			/* number of columns */
+	int			nrows;			/* number of rows in the batch */
+	int			nsel;			/* number of rows in the selection vector */
+	int		   *sel;			/* selection vector */
+	Datum	  **values;			/* per-column value arrays */
+	bool	  **isnull;			/* per-column null flag arrays */
+} TupleBatch;
+
+/*
+ * Operations a BatchExpr node can perform.  Comparisons and arithmetic on
+ * the common numeric types have their own loops; any other immutable
+ * function goes through BEEOP_FUNCEXPR, which calls it through fmgr once per
+ * row but still avoids the per-row expression interpreter dispatch.
+ */
+typedef enum BatchExprOp
+{
+	BEEOP_VAR,					/* fetch a column of the input batch */
+	BEEOP_CONST,				/* a constant */
+	BEEOP_FUNCEXPR,				/* generic function call */
+	BEEOP_NOT,					/* boolean NOT */
+	BEEOP_NULLTEST_ISNULL,		/* IS NULL */
+	BEEOP_NULLTEST_ISNOTNULL,	/* IS NOT NULL */
+
+	/* comparisons */
+	BEEOP_INT4_EQ,
+	BEEOP_INT4_NE,
+	BEEOP_INT4_LT,
+	BEEOP_INT4_LE,
+	BEEOP_INT4_GT,
+	BEEOP_INT4_GE,
+	BEEOP_INT8_EQ,
+	BEEOP_INT8_NE,
+	BEEOP_INT8_LT,
+	BEEOP_INT8_LE,
+	BEEOP_INT8_GT,
+	BEEOP_INT8_GE,
+	BEEOP_FLOAT8_EQ,
+	BEEOP_FLOAT8_NE,
+	BEEOP_FLOAT8_LT,
+	BEEOP_FLOAT8_LE,
+	BEEOP_FLOAT8_GT,
+	BEEOP_FLOAT8_GE,
+
+	/* arithmetic */
+	BEEOP_INT4_PL,
+	BEEOP_INT4_MI,
+	BEEOP_INT4_MUL,
+	BEEOP_INT8_PL,
+	BEEOP_INT8_MI,
+	BEEOP_INT8_MUL,
+	BEEOP_FLOAT8_PL,
+	BEEOP_FLOAT8_MI,
+	BEEOP_FLOAT8_MUL
+} BatchExprOp;
+
+/*
+ * A compiled expression over a TupleBatch.  After ExecEvalBatchExpr(),
+ * values[r] and isnull[r] hold the result for every row r in the selection
+ * the expression was evaluated for; other rows hold garbage.
+ */
+typedef struct BatchExpr
+{
+	BatchExprOp op;
+
+	/* result arrays; for BEEOP_VAR these point into the input batch */
+	Datum	   *values;
+	bool	   *isnull;
+
+	/* BEEOP_VAR: zero-based column of the input batch */
+	int			column;
+
+	/* function call data, for BEEOP_FUNCEXPR and the specialized ops */
+	FmgrInfo   *finfo;
+	FunctionCallInfo fcinfo;
+	int			nargs;
+	struct BatchExpr **args;
+} BatchExpr;
+
+extern TupleBatch *ExecMakeTupleBatch(int natts);
+extern void ExecTupleBatchAddColumn(TupleBatch *batch, AttrNumber attno);
+
+extern BatchExpr *ExecInitBatchExpr(Expr *node, Index varno,
+									Bitmapset **attnos);
+extern bool ExecInitBatchQual(List *qual, Index varno, Bitmapset **attnos,
+							  List **result);
+extern void ExecEvalBatchExpr(BatchExpr *expr, TupleBatch *batch,
+							  const int *sel, int nsel);
+extern int	ExecBatchQual(List *qual, TupleBatch *batch, int *sel, int nsel);
+
+#endif							/* EXECBATCH_H */
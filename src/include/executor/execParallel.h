@@ -21,6 +21,25 @@
 
 typedef struct SharedExecutorInstrumentation SharedExecutorInstrumentation;
 
+/*
+ * DSM TOC keys for the shared state of parallel-aware plan nodes.  A node's
+ * main entry is keyed by its plan node ID alone.  A node that needs more
+ * entries keys them with PARALLEL_NODE_KEY, which puts one of the kinds
+ * below above the plan node ID.  Kinds must stay well below 0xE0000000, as
+ * execParallel.c uses keys from 0xE000000000000000 up for itself.
+ */
+typedef enum ParallelNodeKeyKind
+{
+	PARALLEL_NODE_KEY_MAIN = 0,
+	PARALLEL_NODE_KEY_HASHAGG_SPILL,
+	PARALLEL_NODE_KEY_MEMOIZE_CACHE,
+	PARALLEL_NODE_KEY_BLOOM_FILTERS,
+	PARALLEL_NODE_KEY_SORT
+} ParallelNodeKeyKind;
+
+#define PARALLEL_NODE_KEY(plan_node_id, kind) \
+	(((uint64) (kind) << 32) | (uint64) (uint32) (plan_node_id))
+
 typedef struct ParallelExecutorInfo
 {
 	PlanState  *planstate;		/* plan subtree we're running in parallel */
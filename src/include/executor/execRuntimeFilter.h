@@ -0,0 +1,89 @@
+/*-------------------------------------------------------------------------
+ * execRuntimeFilter.h
+ *	  Bloom filters pushed down from hash joins to scans
+ *
+ * While building its hash table, a Hash node can also build a Bloom filter
+ * of the hash values of the inner side's join keys.  That filter is handed
+ * to the sequential scans below the hash join's outer side that the outer
+ * join keys come from, so that they can discard rows that cannot possibly
+ * find a join partner before evaluating quals, or even deforming the rest
+ * of the tuple.
+ *
+ * Portions Copyright (c) 1996-2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *		src/include/executor/execRuntimeFilter.h
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef EXECRUNTIMEFILTER_H
+#define EXECRUNTIMEFILTER_H
+
+#include "access/parallel.h"
+#include "fmgr.h"
+#include "lib/bloomfilter.h"
+#include "nodes/execnodes.h"
+
+/* GUC parameter */
+extern PGDLLIMPORT bool enable_bloom_filter_pushdown;
+
+/*
+ * A Bloom filter built by a Hash node.  The hash value of a row is computed
+ * the same way ExecHashGetHashValue() does, using the outer side's hash
+ * functions, so that it can be checked by the outer side's scans.
+ */
+typedef struct HashBloomFilter
+{
+	bloom_filter *filter;		/* the filter, or NULL if not built yet */
+	bool		active;			/* is the filter selective enough to use? */
+	bool		across_gather;	/* is the filter used by a scan below a
+								 * Gather or Gather Merge? */
+	int64		total_elems;	/* estimated number of inner rows */
+	int			nkeys;			/* number of join keys */
+	Oid		   *hashfuncoids;	/* outer hash function of each key */
+	FmgrInfo   *hashfunctions;	/* lookup data for hashfuncoids */
+	Oid		   *collations;		/* collation of each key */
+	bool	   *strict;			/* is each key's operator strict? */
+} HashBloomFilter;
+
+/*
+ * A HashBloomFilter as used by one scan.
+ */
+typedef struct ScanBloomFilter
+{
+	HashBloomFilter *hbf;		/* the filter */
+	AttrNumber *attnos;			/* scan tuple attribute of each join key */
+	AttrNumber	maxattno;		/* highest attribute number in attnos */
+	bool		across_gather;	/* does the filter come from above a Gather
+								 * or Gather Merge? */
+} ScanBloomFilter;
+
+extern void ExecInitHashBloomFilter(HashJoinState *hjstate);
+extern void ExecHashBloomFilterBegin(HashBloomFilter *hbf);
+extern void ExecHashBloomFilterEnd(HashBloomFilter *hbf);
+extern bool ExecScanBloomFilterRejects(ScanState *node, List *filters,
+									   TupleTableSlot *slot);
+
+extern void ExecBloomFilterEstimate(PlanState *planstate, List *filters,
+									ParallelContext *pcxt);
+extern void ExecBloomFilterInitializeDSM(PlanState *planstate, List *filters,
+										 ParallelContext *pcxt);
+extern void ExecBloomFilterReInitializeDSM(PlanState *planstate,
+										   List *filters,
+										   ParallelContext *pcxt);
+extern List *ExecBloomFilterInitializeWorker(PlanState *planstate,
+											 List *filters,
+											 ParallelWorkerContext *pwcxt);
+
+/*
+ * Add a hash value, as computed by ExecHashGetHashValue(), to the filter.
+ */
+static inline void
+ExecHashBloomFilterAdd(HashBloomFilter *hbf, uint32 hashvalue)
+{
+	bloom_add_element(hbf->filter, (unsigned char *) &hashvalue,
+					  sizeof(hashvalue));
+}
+
+#endif							/* EXECRUNTIMEFILTER_H */
@@ -366,6 +366,20 @@ typedef struct HashJoinTableData
 	/* used for dense allocation of tuples (into linked chunks) */
 	HashMemoryChunk chunks;		/* one list for the whole batch */
 
+	/*
+	 * Radix-partitioned index of the current batch's buckets, built by
+	 * ExecHashBuildRadixIndex() once the batch is loaded.  The tuples of
+	 * bucket i are radixTuples[radixBucketStart[i] .. radixBucketStart[i +
+	 * 1] - 1], and their hash values are stored at the same positions of
+	 * radixHashValues.  The arrays are NULL if no index was built for the
+	 * batch, in which case the bucket chains are probed as usual.
+	 */
+	bool		radixEnabled;	/* build the index for each batch? */
+	bool		radixUsed;		/* was it built for any batch? */
+	uint32	   *radixBucketStart;	/* nbuckets + 1 offsets */
+	uint32	   *radixHashValues;
+	HashJoinTuple *radixTuples;
+
 	/* Shared and private state for Parallel Hash. */
 	HashMemoryChunk current_chunk;	/* this backend's current chunk */
 	dsa_area   *area;			/* DSA area to allocate memory from */
@@ -336,6 +336,7 @@ extern void hash_agg_set_limits(double hashentrysize, double input_groups,
 extern void ExecAggEstimate(AggState *node, ParallelContext *pcxt);
 extern void ExecAggInitializeDSM(AggState *node, ParallelContext *pcxt);
 extern void ExecAggInitializeWorker(AggState *node, ParallelWorkerContext *pwcxt);
+extern void ExecAggReInitializeDSM(AggState *node, ParallelContext *pcxt);
 extern void ExecAggRetrieveInstrumentation(AggState *node);
 
 #endif							/* NODEAGG_H */
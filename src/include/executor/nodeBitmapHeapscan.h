@@ -20,6 +20,9 @@
 extern BitmapHeapScanState *ExecInitBitmapHeapScan(BitmapHeapScan *node, EState *estate, int eflags);
 extern void ExecEndBitmapHeapScan(BitmapHeapScanState *node);
 extern void ExecReScanBitmapHeapScan(BitmapHeapScanState *node);
+extern void ExecAsyncBitmapHeapScanRequest(AsyncRequest *areq);
+extern void ExecAsyncBitmapHeapScanConfigureWait(AsyncRequest *areq);
+extern void ExecAsyncBitmapHeapScanNotify(AsyncRequest *areq);
 extern void ExecBitmapHeapEstimate(BitmapHeapScanState *node,
 								   ParallelContext *pcxt);
 extern void ExecBitmapHeapInitializeDSM(BitmapHeapScanState *node,
@@ -20,5 +20,8 @@ extern GatherState *ExecInitGather(Gather *node, EState *estate, int eflags);
 extern void ExecEndGather(GatherState *node);
 extern void ExecShutdownGather(GatherState *node);
 extern void ExecReScanGather(GatherState *node);
+extern void ExecAsyncGatherRequest(AsyncRequest *areq);
+extern void ExecAsyncGatherConfigureWait(AsyncRequest *areq);
+extern void ExecAsyncGatherNotify(AsyncRequest *areq);
 
 #endif							/* NODEGATHER_H */
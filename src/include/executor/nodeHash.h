@@ -19,6 +19,10 @@
 
 struct SharedHashJoinBatch;
 
+/* GUC parameter */
+extern PGDLLIMPORT int hashjoin_radix_threshold;
+extern PGDLLIMPORT int hashjoin_radix_partition_log2;
+
 extern HashState *ExecInitHash(Hash *node, EState *estate, int eflags);
 extern Node *MultiExecHash(HashState *node);
 extern void ExecEndHash(HashState *node);
@@ -26,6 +30,7 @@ extern void ExecReScanHash(HashState *node);
 
 extern HashJoinTable ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 										 bool keepNulls);
+extern void ExecHashBuildRadixIndex(HashJoinTable hashtable);
 extern void ExecParallelHashTableAlloc(HashJoinTable hashtable,
 									   int batchno);
 extern void ExecHashTableDestroy(HashJoinTable hashtable);
@@ -20,6 +20,7 @@
 extern MemoizeState *ExecInitMemoize(Memoize *node, EState *estate, int eflags);
 extern void ExecEndMemoize(MemoizeState *node);
 extern void ExecReScanMemoize(MemoizeState *node);
+extern void ExecShutdownMemoize(MemoizeState *node);
 extern double ExecEstimateCacheEntryOverheadBytes(double ntuples);
 extern void ExecMemoizeEstimate(MemoizeState *node,
 								ParallelContext *pcxt);
@@ -15,12 +15,22 @@
 #define NODESEQSCAN_H
 
 #include "access/parallel.h"
+#include "executor/execBatch.h"
 #include "nodes/execnodes.h"
 
 extern SeqScanState *ExecInitSeqScan(SeqScan *node, EState *estate, int eflags);
 extern void ExecEndSeqScan(SeqScanState *node);
 extern void ExecReScanSeqScan(SeqScanState *node);
 
+/* async execution support */
+extern void ExecAsyncSeqScanRequest(AsyncRequest *areq);
+extern void ExecAsyncSeqScanConfigureWait(AsyncRequest *areq);
+extern void ExecAsyncSeqScanNotify(AsyncRequest *areq);
+
+/* batch mode support */
+extern bool ExecSeqScanInitBatch(SeqScanState *node, Bitmapset *outattnos);
+extern TupleBatch *ExecSeqScanBatch(SeqScanState *node);
+
 /* parallel scan support */
 extern void ExecSeqScanEstimate(SeqScanState *node, ParallelContext *pcxt);
 extern void ExecSeqScanInitializeDSM(SeqScanState *node, ParallelContext *pcxt);
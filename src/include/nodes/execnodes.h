@@ -596,6 +596,7 @@ typedef struct AsyncRequest
 	struct PlanState *requestee;	/* Node from which a tuple is wanted */
 	int			request_index;	/* Scratch space for requestor */
 	bool		callback_pending;	/* Callback is needed */
+	bool		wait_latch;		/* Callback is needed once latch is set */
 	bool		request_complete;	/* Request complete, result valid */
 	TupleTableSlot *result;		/* Result (NULL or an empty slot if no more
 								 * tuples) */
@@ -1485,6 +1486,9 @@ typedef struct SeqScanState
 {
 	ScanState	ss;				/* its first field is NodeTag */
 	Size		pscan_len;		/* size of parallel heap scan descriptor */
+	struct SeqScanBatchState *batch;	/* batch mode state, or NULL */
+	List	   *bloom_filters;	/* ScanBloomFilters pushed down from hash
+								 * joins */
 } SeqScanState;
 
 /* ----------------
@@ -1705,6 +1709,7 @@ typedef struct ParallelBitmapHeapState
  *		tbm				   bitmap obtained from child index scan(s)
  *		tbmiterator		   iterator for scanning current pages
  *		tbmres			   current-page data
+ *		tbmres_unread	   tbmres was taken ahead of time, page not read yet
  *		can_skip_fetch	   can we potentially skip tuple fetches in this scan?
  *		return_empty_tuples number of empty tuples to return
  *		vmbuffer		   buffer for visibility-map lookups
@@ -1729,6 +1734,7 @@ typedef struct BitmapHeapScanState
 	TIDBitmap  *tbm;
 	TBMIterator *tbmiterator;
 	TBMIterateResult *tbmres;
+	bool		tbmres_unread;
 	bool		can_skip_fetch;
 	int			return_empty_tuples;
 	Buffer		vmbuffer;
@@ -2082,6 +2088,8 @@ typedef struct MergeJoinState
  *		hj_CurSkewBucketNo		skew bucket# for current outer tuple
  *		hj_CurTuple				last inner tuple matched to current outer
  *								tuple, or NULL if starting search
+ *		hj_CurRadixPos			position in the radix bucket index to resume
+ *								the search at, if hj_CurTuple isn't NULL
  *								(hj_CurXXX variables are undefined if
  *								OuterTupleSlot is empty!)
  *		hj_OuterTupleSlot		tuple slot for outer tuples
@@ -2112,6 +2120,7 @@ typedef struct HashJoinState
 	int			hj_CurBucketNo;
 	int			hj_CurSkewBucketNo;
 	HashJoinTuple hj_CurTuple;
+	uint32		hj_CurRadixPos;
 	TupleTableSlot *hj_OuterTupleSlot;
 	TupleTableSlot *hj_HashTupleSlot;
 	TupleTableSlot *hj_NullOuterTupleSlot;
@@ -2148,6 +2157,7 @@ typedef struct MaterialState
 struct MemoizeEntry;
 struct MemoizeTuple;
 struct MemoizeKey;
+struct MemoizeSharedState;
 
 typedef struct MemoizeInstrumentation
 {
@@ -2213,6 +2223,12 @@ typedef struct MemoizeState
 	SharedMemoizeInfo *shared_info; /* statistics for parallel workers */
 	Bitmapset  *keyparamids;	/* Param->paramids of expressions belonging to
 								 * param_exprs */
+	struct MemoizeSharedState *shared_state;	/* state for using a cache
+												 * shared by parallel
+												 * participants, or NULL */
+	bool		shared_cache;	/* has a shared cache been used? */
+	uint64		shared_mem_peak;	/* peak memory usage of the shared cache
+									 * in bytes */
 } MemoizeState;
 
 /* ----------------
@@ -2256,6 +2272,9 @@ typedef struct SortState
 	bool		am_worker;		/* are we a worker? */
 	bool		datumSort;		/* Datum sort instead of tuple sort? */
 	SharedSortInfo *shared_info;	/* one entry per worker */
+	/* shared state of a parallel-aware sort, see nodeSort.c */
+	struct ParallelSortShared *pshared;
+	struct ParallelContext *pcxt;	/* leader's parallel context */
 } SortState;
 
 /* ----------------
@@ -2343,6 +2362,7 @@ typedef struct AggregateInstrumentation
 	Size		hash_mem_peak;	/* peak hash table memory usage */
 	uint64		hash_disk_used; /* kB of disk space used */
 	int			hash_batches_used;	/* batches used during entire execution */
+	int			hash_shared_batches;	/* shared partitions re-aggregated */
 } AggregateInstrumentation;
 
 /* ----------------
@@ -2438,6 +2458,7 @@ typedef struct AggState
 										 * memory in all hash tables */
 	uint64		hash_disk_used; /* kB of disk space used */
 	int			hash_batches_used;	/* batches used during entire execution */
+	int			hash_shared_batches;	/* shared partitions re-aggregated */
 
 	AggStatePerHash perhash;	/* array of per-hashtable data */
 	AggStatePerGroup *hash_pergroup;	/* grouping set indexed array of
@@ -2449,6 +2470,13 @@ typedef struct AggState
 										 * ->hash_pergroup */
 	ProjectionInfo *combinedproj;	/* projection machinery */
 	SharedAggInfo *shared_info; /* one entry per worker */
+	struct AggBatchState *batch;	/* batch mode state, or NULL */
+
+	/* these fields are used for spilling to partitions shared by workers: */
+	struct ParallelHashAggState *hash_shared;	/* shared state, or NULL */
+	struct SharedTuplestoreAccessor **hash_shared_partitions;	/* accessors */
+	bool		hash_shared_writing;	/* spilling to shared partitions? */
+	bool		hash_shared_reading;	/* may claim shared partitions? */
 } AggState;
 
 /* ----------------
@@ -2640,6 +2668,7 @@ typedef struct HashInstrumentation
 	int			nbatch;			/* number of batches at end of execution */
 	int			nbatch_original;	/* planned number of batches */
 	Size		space_peak;		/* peak memory usage in bytes */
+	bool		radix_index;	/* was a radix bucket index used? */
 } HashInstrumentation;
 
 /* ----------------
@@ -2679,6 +2708,9 @@ typedef struct HashState
 
 	/* Parallel hash state. */
 	struct ParallelHashJoinState *parallel_state;
+
+	/* Bloom filter pushed down to the outer side's scans, or NULL */
+	struct HashBloomFilter *bloom_filter;
 } HashState;
 
 /* ----------------
@@ -1999,6 +1999,7 @@ typedef struct GatherPath
 	Path		path;
 	Path	   *subpath;		/* path for each worker */
 	bool		single_copy;	/* don't execute path more than once */
+	bool		parallel_sort;	/* subpath is a parallel-aware Sort */
 	int			num_workers;	/* number of workers sought to help */
 } GatherPath;
 
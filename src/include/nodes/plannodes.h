@@ -1143,6 +1143,8 @@ typedef struct Gather
 	int			rescan_param;	/* ID of Param that signals a rescan, or -1 */
 	bool		single_copy;	/* don't execute plan more than once */
 	bool		invisible;		/* suppress EXPLAIN display (for testing)? */
+	bool		parallel_sort;	/* leader returns the sorted output of a
+								 * parallel-aware Sort below */
 	Bitmapset  *initParam;		/* param id's of initplans which are referred
 								 * at gather or one of it's child node */
 } Gather;
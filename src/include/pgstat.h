@@ -177,6 +177,16 @@ typedef struct PgStat_TableCounts
 
 	PgStat_Counter blocks_fetched;
 	PgStat_Counter blocks_hit;
+
+	PgStat_Counter maintenance_count;
+	PgStat_Counter maintenance_full_count;
+	PgStat_Counter maintenance_rows;
+	PgStat_Counter maintenance_time;	/* times in microseconds */
+
+	PgStat_Counter gin_pending_merges;
+	PgStat_Counter gin_pending_inline_merges;
+	PgStat_Counter gin_pending_merged_pages;
+	PgStat_Counter gin_pending_merge_time;	/* times in microseconds */
 } PgStat_TableCounts;
 
 /* ----------
@@ -235,7 +245,7 @@ typedef struct PgStat_TableXactStatus
  * ------------------------------------------------------------
  */
 
-#define PGSTAT_FILE_FORMAT_ID	0x01A5BCAC
+#define PGSTAT_FILE_FORMAT_ID	0x01A5BCB1
 
 typedef struct PgStat_ArchiverStats
 {
@@ -265,6 +275,7 @@ typedef struct PgStat_CheckpointerStats
 	PgStat_Counter checkpoint_write_time;	/* times in milliseconds */
 	PgStat_Counter checkpoint_sync_time;
 	PgStat_Counter buf_written_checkpoints;
+	PgStat_Counter write_requests_checkpoints;	/* I/Os for the above */
 	PgStat_Counter buf_written_backend;
 	PgStat_Counter buf_fsync_backend;
 } PgStat_CheckpointerStats;
@@ -309,6 +320,12 @@ typedef struct PgStat_BktypeIO
 {
 	PgStat_Counter counts[IOOBJECT_NUM_TYPES][IOCONTEXT_NUM_TYPES][IOOP_NUM_TYPES];
 	PgStat_Counter times[IOOBJECT_NUM_TYPES][IOCONTEXT_NUM_TYPES][IOOP_NUM_TYPES];
+
+	/*
+	 * Number of write requests that the IOOP_WRITE blocks were written with.
+	 * Adjacent blocks may be combined into one vectored write.
+	 */
+	PgStat_Counter write_requests[IOOBJECT_NUM_TYPES][IOCONTEXT_NUM_TYPES];
 } PgStat_BktypeIO;
 
 typedef struct PgStat_IO
@@ -424,6 +441,18 @@ typedef struct PgStat_StatTabEntry
 	PgStat_Counter analyze_count;
 	TimestampTz last_autoanalyze_time;	/* autovacuum initiated */
 	PgStat_Counter autoanalyze_count;
+
+	/* incremental maintenance of materialized views */
+	PgStat_Counter maintenance_count;
+	PgStat_Counter maintenance_full_count;
+	PgStat_Counter maintenance_rows;
+	PgStat_Counter maintenance_time;	/* times in microseconds */
+
+	/* GIN pending list cleanup */
+	PgStat_Counter gin_pending_merges;
+	PgStat_Counter gin_pending_inline_merges;
+	PgStat_Counter gin_pending_merged_pages;
+	PgStat_Counter gin_pending_merge_time;	/* times in microseconds */
 } PgStat_StatTabEntry;
 
 typedef struct PgStat_WalStats
@@ -436,6 +465,8 @@ typedef struct PgStat_WalStats
 	PgStat_Counter wal_sync;
 	PgStat_Counter wal_write_time;
 	PgStat_Counter wal_sync_time;
+	PgStat_Counter wal_group_flushes;
+	PgStat_Counter wal_group_flush_members;
 	TimestampTz stat_reset_timestamp;
 } PgStat_WalStats;
 
@@ -452,6 +483,8 @@ typedef struct PgStat_PendingWalStats
 	PgStat_Counter wal_sync;
 	instr_time	wal_write_time;
 	instr_time	wal_sync_time;
+	PgStat_Counter wal_group_flushes;
+	PgStat_Counter wal_group_flush_members;
 } PgStat_PendingWalStats;
 
 
@@ -523,6 +556,8 @@ extern void pgstat_count_io_op_n(IOObject io_object, IOContext io_context, IOOp
 extern instr_time pgstat_prepare_io_time(void);
 extern void pgstat_count_io_op_time(IOObject io_object, IOContext io_context,
 									IOOp io_op, instr_time start_time, uint32 cnt);
+extern void pgstat_count_io_write_requests(IOObject io_object,
+										   IOContext io_context, uint32 cnt);
 
 extern PgStat_IO *pgstat_fetch_stat_io(void);
 extern const char *pgstat_get_io_context_name(IOContext io_context);
@@ -646,6 +681,12 @@ extern void pgstat_count_heap_update(Relation rel, bool hot, bool newpage);
 extern void pgstat_count_heap_delete(Relation rel);
 extern void pgstat_count_truncate(Relation rel);
 extern void pgstat_update_heap_dead_tuples(Relation rel, int delta);
+extern void pgstat_count_matview_maintenance(Relation rel, bool full,
+											 PgStat_Counter rows,
+											 instr_time elapsed);
+extern void pgstat_count_gin_pending_merge(Relation rel, bool inline_merge,
+										   PgStat_Counter pages,
+										   instr_time elapsed);
 
 extern void pgstat_twophase_postcommit(TransactionId xid, uint16 info,
 									   void *recdata, uint32 len);
@@ -383,6 +383,19 @@ typedef struct CkptSortItem
 
 extern PGDLLIMPORT CkptSortItem *CkptBufferIds;
 
+/*
+ * Snapshot of the state of one clock sweep partition, for monitoring.
+ */
+typedef struct ClockSweepPartitionStats
+{
+	int			first_buffer;	/* first buffer id in the partition */
+	int			num_buffers;	/* number of buffers in the partition */
+	int			next_victim_buffer; /* buffer id under the clock hand */
+	uint32		complete_passes;	/* complete cycles of the clock hand */
+	uint64		num_allocs;		/* victims taken from this partition */
+	uint64		num_remote_allocs;	/* ... by backends homed elsewhere */
+} ClockSweepPartitionStats;
+
 /*
  * Internal buffer management routines
  */
@@ -406,6 +419,9 @@ extern void StrategyNotifyBgWriter(int bgwprocno);
 extern Size StrategyShmemSize(void);
 extern void StrategyInitialize(bool init);
 extern bool have_free_buffer(void);
+extern int	StrategyNumPartitions(void);
+extern void StrategyGetPartitionStats(int partno,
+									  ClockSweepPartitionStats *stats);
 
 /* buf_table.c */
 extern Size BufTableShmemSize(int size);
@@ -418,6 +434,7 @@ extern void BufTableDelete(BufferTag *tagPtr, uint32 hashcode);
 /* localbuf.c */
 extern bool PinLocalBuffer(BufferDesc *buf_hdr, bool adjust_usagecount);
 extern void UnpinLocalBuffer(Buffer buffer);
+extern void LimitAdditionalLocalPins(uint32 *additional_pins);
 extern PrefetchBufferResult PrefetchLocalBuffer(SMgrRelation smgr,
 												ForkNumber forkNum,
 												BlockNumber blockNum);
@@ -46,14 +46,41 @@
 #include <dirent.h>
 #include <fcntl.h>
 
+#include "port/pg_iovec.h"
+
 typedef enum RecoveryInitSyncMethod
 {
 	RECOVERY_INIT_SYNC_METHOD_FSYNC,
 	RECOVERY_INIT_SYNC_METHOD_SYNCFS
 }			RecoveryInitSyncMethod;
 
+/* Possible values for io_method GUC */
+typedef enum IOMethod
+{
+	IOMETHOD_SYNC,
+	IOMETHOD_IO_URING
+}			IOMethod;
+
 typedef int File;
 
+/*
+ * One read or write in a batch submitted with FileIOBatch().  The caller
+ * fills in the fields up to offset; FileIOBatch() sets result to the number
+ * of bytes transferred, or to -1 with the errno value in error.  As with
+ * FileReadV() and FileWriteV(), fewer bytes than requested may be
+ * transferred.
+ */
+typedef struct FileIORequest
+{
+	File		file;
+	bool		is_write;
+	const struct iovec *iov;
+	int			iovcnt;
+	off_t		offset;
+	ssize_t		result;
+	int			error;
+} FileIORequest;
+
 
 #define IO_DIRECT_DATA			0x01
 #define IO_DIRECT_WAL			0x02
@@ -65,6 +92,7 @@ extern PGDLLIMPORT int max_files_per_process;
 extern PGDLLIMPORT bool data_sync_retry;
 extern PGDLLIMPORT int recovery_init_sync_method;
 extern PGDLLIMPORT int io_direct_flags;
+extern PGDLLIMPORT int io_method;
 
 /*
  * This is private to fd.c, but exported for save/restore_backend_variables()
@@ -112,7 +140,11 @@ extern File OpenTemporaryFile(bool interXact);
 extern void FileClose(File file);
 extern int	FilePrefetch(File file, off_t offset, off_t amount, uint32 wait_event_info);
 extern int	FileRead(File file, void *buffer, size_t amount, off_t offset, uint32 wait_event_info);
+extern ssize_t FileReadV(File file, const struct iovec *iov, int iovcnt, off_t offset, uint32 wait_event_info);
 extern int	FileWrite(File file, const void *buffer, size_t amount, off_t offset, uint32 wait_event_info);
+extern ssize_t FileWriteV(File file, const struct iovec *iov, int iovcnt, off_t offset, uint32 wait_event_info);
+extern void FileIOBatch(FileIORequest *reqs, int nreqs, uint32 wait_event_info);
+extern bool FileIOBatchIsAsync(void);
 extern int	FileSync(File file, uint32 wait_event_info);
 extern int	FileZero(File file, off_t offset, off_t amount, uint32 wait_event_info);
 extern int	FileFallocate(File file, off_t offset, off_t amount, uint32 wait_event_info);
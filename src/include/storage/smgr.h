@@ -77,6 +77,20 @@ typedef SMgrRelationData *SMgrRelation;
 #define SmgrIsTemp(smgr) \
 	RelFileLocatorBackendIsTemp((smgr)->smgr_rlocator)
 
+/*
+ * A read or write of a range of consecutive blocks, as passed to
+ * smgrreadbatch() and smgrwritebatch().  buffers holds one page image per
+ * block; writes don't modify them.
+ */
+typedef struct SMgrIO
+{
+	SMgrRelation reln;
+	ForkNumber	forknum;
+	BlockNumber blocknum;
+	BlockNumber nblocks;
+	void	  **buffers;
+} SMgrIO;
+
 extern void smgrinit(void);
 extern SMgrRelation smgropen(RelFileLocator rlocator, BackendId backend);
 extern bool smgrexists(SMgrRelation reln, ForkNumber forknum);
@@ -98,8 +112,13 @@ extern bool smgrprefetch(SMgrRelation reln, ForkNumber forknum,
 						 BlockNumber blocknum);
 extern void smgrread(SMgrRelation reln, ForkNumber forknum,
 					 BlockNumber blocknum, void *buffer);
+extern void smgrreadv(SMgrRelation reln, ForkNumber forknum,
+					  BlockNumber blocknum, void **buffers,
+					  BlockNumber nblocks);
+extern void smgrreadbatch(SMgrIO *ios, int nios);
 extern void smgrwrite(SMgrRelation reln, ForkNumber forknum,
 					  BlockNumber blocknum, const void *buffer, bool skipFsync);
+extern void smgrwritebatch(SMgrIO *ios, int nios, bool skipFsync);
 extern void smgrwriteback(SMgrRelation reln, ForkNumber forknum,
 						  BlockNumber blocknum, BlockNumber nblocks);
 extern BlockNumber smgrnblocks(SMgrRelation reln, ForkNumber forknum);
@@ -0,0 +1,41 @@
+/*-------------------------------------------------------------------------
+ *
+ * streaming_read.h
+ *	  Look-ahead buffer reads with I/O combining.
+ *
+ *
+ * Portions Copyright (c) 1996-2023, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/storage/streaming_read.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef STREAMING_READ_H
+#define STREAMING_READ_H
+
+#include "storage/bufmgr.h"
+
+struct StreamingRead;
+typedef struct StreamingRead StreamingRead;
+
+/*
+ * Callback that returns the next block number the stream's user wants to
+ * read, or InvalidBlockNumber when there are no more blocks.  The callback
+ * is invoked ahead of the corresponding streaming_read_next_buffer() call,
+ * so it must not depend on the caller having consumed previous buffers.
+ */
+typedef BlockNumber (*StreamingReadBlockCB) (StreamingRead *stream,
+											 void *callback_private_data);
+
+extern StreamingRead *streaming_read_begin(Relation rel,
+										   ForkNumber forknum,
+										   BufferAccessStrategy strategy,
+										   StreamingReadBlockCB callback,
+										   void *callback_private_data);
+extern Buffer streaming_read_next_buffer(StreamingRead *stream);
+extern bool streaming_read_prefetch_next(StreamingRead *stream);
+extern void streaming_read_reset(StreamingRead *stream);
+extern void streaming_read_end(StreamingRead *stream);
+
+#endif							/* STREAMING_READ_H */
@@ -171,6 +171,14 @@ typedef struct PgBackendStatus
 
 	/* query identifier, optionally computed using post_parse_analyze_hook */
 	uint64		st_query_id;
+
+	/*
+	 * Relation locks that were eligible for the fast path but had to go to
+	 * the main lock table, either because the backend's fast-path slots were
+	 * full or because a conflicting strong lock was held or requested.
+	 */
+	int64		st_fastpath_slot_misses;
+	int64		st_fastpath_conflict_misses;
 } PgBackendStatus;
 
 
@@ -319,6 +327,7 @@ extern void pgstat_clear_backend_activity_snapshot(void);
 /* Activity reporting functions */
 extern void pgstat_report_activity(BackendState state, const char *cmd_str);
 extern void pgstat_report_query_id(uint64 query_id, bool force);
+extern void pgstat_report_fastpath_miss(bool conflict);
 extern void pgstat_report_tempfile(size_t filesize);
 extern void pgstat_report_appname(const char *appname);
 extern void pgstat_report_xact_timestamp(TimestampTz tstamp);
@@ -269,6 +269,7 @@ typedef struct PgStat_KindInfo
  * definitions.
  */
 static const char *const slru_names[] = {
+	"CSNLog",
 	"CommitTs",
 	"MultiXactMember",
 	"MultiXactOffset",
@@ -332,6 +332,14 @@ typedef enum StdRdOptIndexCleanup
 	STDRD_OPTION_VACUUM_INDEX_CLEANUP_ON
 } StdRdOptIndexCleanup;
 
+/* StdRdOptions->incremental_maintenance values */
+typedef enum StdRdOptIncrementalMaintenance
+{
+	STDRD_OPTION_INCREMENTAL_MAINTENANCE_OFF = 0,
+	STDRD_OPTION_INCREMENTAL_MAINTENANCE_IMMEDIATE,
+	STDRD_OPTION_INCREMENTAL_MAINTENANCE_DEFERRED
+} StdRdOptIncrementalMaintenance;
+
 typedef struct StdRdOptions
 {
 	int32		vl_len_;		/* varlena header (do not touch directly!) */
@@ -342,6 +350,7 @@ typedef struct StdRdOptions
 	int			parallel_workers;	/* max number of parallel workers */
 	StdRdOptIndexCleanup vacuum_index_cleanup;	/* controls index vacuuming */
 	bool		vacuum_truncate;	/* enables vacuum to truncate a relation */
+	StdRdOptIncrementalMaintenance incremental_maintenance; /* matviews only */
 } StdRdOptions;
 
 #define HEAP_MIN_FILLFACTOR			10
@@ -397,6 +406,17 @@ typedef struct StdRdOptions
 	((relation)->rd_options ? \
 	 ((StdRdOptions *) (relation)->rd_options)->parallel_workers : (defaultpw))
 
+/*
+ * RelationGetIncrementalMaintenance
+ *		Returns the materialized view's incremental_maintenance setting.
+ *		Note multiple eval of argument!
+ */
+#define RelationGetIncrementalMaintenance(relation) \
+	((relation)->rd_options && \
+	 (relation)->rd_rel->relkind == RELKIND_MATVIEW ? \
+	 ((StdRdOptions *) (relation)->rd_options)->incremental_maintenance : \
+	 STDRD_OPTION_INCREMENTAL_MAINTENANCE_OFF)
+
 /* ViewOptions->check_option values */
 typedef enum ViewOptCheckOption
 {
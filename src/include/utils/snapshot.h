@@ -184,6 +184,14 @@ typedef struct SnapshotData
 	bool		takenDuringRecovery;	/* recovery-shaped snapshot? */
 	bool		copied;			/* false if it's a static snapshot */
 
+	/*
+	 * For CSN snapshots (see csn_snapshots), the commit sequence number at
+	 * the time the snapshot was taken: XIDs between xmin and xmax are
+	 * visible if they committed with a smaller CSN, and xip[] and subxip[]
+	 * are not used.  InvalidCommitSeqNo for all other snapshots.
+	 */
+	CommitSeqNo snapshot_csn;
+
 	CommandId	curcid;			/* in my xact, CID < curcid are visible */
 
 	/*
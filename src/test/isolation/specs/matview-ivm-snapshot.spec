@@ -0,0 +1,54 @@
+# Test incremental maintenance of materialized views under snapshot
+# isolation.
+#
+# A transaction using snapshot isolation computes view changes from its
+# snapshot.  If another transaction maintained the view and committed after
+# that snapshot was taken, those changes would be computed from stale data,
+# so maintenance must fail with a serialization error instead.  READ
+# COMMITTED transactions see the other transaction's changes, and must
+# maintain the view correctly.
+
+setup
+{
+  CREATE TABLE ivm_a (id int NOT NULL, k int NOT NULL);
+  CREATE TABLE ivm_b (k int NOT NULL, label text);
+  CREATE MATERIALIZED VIEW ivm_ab WITH (incremental_maintenance = immediate) AS
+    SELECT a.id, b.label FROM ivm_a a JOIN ivm_b b ON a.k = b.k;
+
+  CREATE TABLE ivm_g (grp int NOT NULL, amt int);
+  CREATE MATERIALIZED VIEW ivm_gavg WITH (incremental_maintenance = immediate) AS
+    SELECT grp, avg(amt) AS mean, count(*) AS n FROM ivm_g GROUP BY grp
+    HAVING count(*) > 0;
+}
+
+teardown
+{
+  DROP MATERIALIZED VIEW ivm_ab;
+  DROP MATERIALIZED VIEW ivm_gavg;
+  DROP TABLE ivm_a, ivm_b, ivm_g;
+}
+
+session s1
+step s1_rr		{ BEGIN ISOLATION LEVEL REPEATABLE READ; SELECT count(*) FROM ivm_b; }
+step s1_ser		{ BEGIN ISOLATION LEVEL SERIALIZABLE; SELECT count(*) FROM ivm_b; }
+step s1_rc		{ BEGIN ISOLATION LEVEL READ COMMITTED; SELECT count(*) FROM ivm_b; }
+step s1_insert_b	{ INSERT INTO ivm_b VALUES (1, 'one'); }
+step s1_insert_g	{ INSERT INTO ivm_g VALUES (1, 10); }
+step s1_commit	{ COMMIT; }
+
+session s2
+step s2_insert_a	{ INSERT INTO ivm_a VALUES (1, 1); }
+step s2_insert_g	{ INSERT INTO ivm_g VALUES (1, 20); }
+step s2_show	{ SELECT * FROM ivm_ab ORDER BY id; SELECT * FROM ivm_gavg ORDER BY grp; }
+
+# maintenance committed after our snapshot: the join would miss a row
+permutation s1_rr s2_insert_a s1_insert_b s1_commit s2_show
+permutation s1_ser s2_insert_a s1_insert_b s1_commit s2_show
+permutation s1_rc s2_insert_a s1_insert_b s1_commit s2_show
+
+# maintenance committed before our snapshot is fine
+permutation s2_insert_a s1_rr s1_insert_b s1_commit s2_show
+
+# the group's recomputation would miss a row, or duplicate a new group
+permutation s1_rr s2_insert_g s1_insert_g s1_commit s2_show
+permutation s1_rc s2_insert_g s1_insert_g s1_commit s2_show
@@ -0,0 +1,31 @@
+CREATE EXTENSION test_hash_join_layout;
+
+CREATE TABLE hjl_inner (k int, v text);
+INSERT INTO hjl_inner SELECT i, 'v' || i FROM generate_series(1, 20000) i;
+INSERT INTO hjl_inner SELECT i, 'dup' FROM generate_series(1, 20000, 7) i;
+CREATE TABLE hjl_outer (k int);
+INSERT INTO hjl_outer SELECT i % 25000 FROM generate_series(1, 50000) i;
+ANALYZE hjl_inner, hjl_outer;
+
+-- See README for explanation of arguments; both layouts must agree
+SELECT r.nrows, c.nrows = r.nrows AS same
+  FROM test_hash_join_layout('SELECT * FROM hjl_outer o JOIN hjl_inner i USING (k)',
+                             radix => true, loops => 2) r,
+       test_hash_join_layout('SELECT * FROM hjl_outer o JOIN hjl_inner i USING (k)',
+                             radix => false, loops => 2) c;
+
+-- many small partitions, and a multi-batch join
+SELECT nrows FROM test_hash_join_layout(
+  'SELECT * FROM hjl_outer o JOIN hjl_inner i USING (k)',
+  loops => 1, partition_log2 => 4);
+SET work_mem = '128kB';
+SELECT nrows FROM test_hash_join_layout(
+  'SELECT * FROM hjl_outer o LEFT JOIN hjl_inner i USING (k)',
+  loops => 1, partition_log2 => 4);
+RESET work_mem;
+
+-- invalid arguments
+SELECT test_hash_join_layout('SELECT 1', loops => 0);
+SELECT test_hash_join_layout('SELECT 1', partition_log2 => 30);
+
+DROP TABLE hjl_inner, hjl_outer;
@@ -0,0 +1,13 @@
+/* src/test/modules/test_hash_join_layout/test_hash_join_layout--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_hash_join_layout" to load this file. \quit
+
+CREATE FUNCTION test_hash_join_layout(query text,
+    radix boolean DEFAULT true,
+    loops integer DEFAULT 3,
+    partition_log2 integer DEFAULT 14,
+    OUT nrows bigint,
+    OUT best_ms float8)
+RETURNS record STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
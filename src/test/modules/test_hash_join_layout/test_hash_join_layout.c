@@ -0,0 +1,128 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_hash_join_layout.c
+ *		Benchmark for the bucket layouts of hash joins in nodeHash.c.
+ *
+ * Copyright (c) 2023, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_hash_join_layout/test_hash_join_layout.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "executor/spi.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "lib/stringinfo.h"
+#include "miscadmin.h"
+#include "portability/instr_time.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(test_hash_join_layout);
+
+/*
+ * Set a GUC for the duration of the call; see test_hash_join_layout().
+ */
+static void
+set_option(const char *name, const char *value)
+{
+	(void) set_config_option(name, value,
+							 PGC_USERSET, PGC_S_SESSION,
+							 GUC_ACTION_SAVE, true, 0, false);
+}
+
+/*
+ * Run "query" "loops" times, and return the number of rows it returned and
+ * the time of the fastest run, in milliseconds.
+ *
+ * Hash joins in the query use the radix bucket index if "radix" is true,
+ * and their bucket chains only otherwise.  "partition_log2" sets
+ * hashjoin_radix_partition_log2.  Merge joins, nested loops and parallel
+ * query are disabled for the duration of the call, as parallel hash tables
+ * have no radix index.
+ *
+ * The rows are only counted, so that the time reflects the join itself
+ * rather than sending the rows anywhere.  Every run must return the same
+ * number of rows.
+ */
+Datum
+test_hash_join_layout(PG_FUNCTION_ARGS)
+{
+	char	   *query = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	bool		radix = PG_GETARG_BOOL(1);
+	int32		loops = PG_GETARG_INT32(2);
+	int32		partition_log2 = PG_GETARG_INT32(3);
+	TupleDesc	tupdesc;
+	StringInfoData buf;
+	char		partbuf[16];
+	int64		nrows = 0;
+	double		best_ms = 0;
+	int			save_nestlevel;
+	int			i;
+	Datum		values[2];
+	bool		nulls[2] = {false, false};
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	if (loops < 1)
+		elog(ERROR, "invalid number of loops: %d", loops);
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "SELECT count(*) FROM (%s) s", query);
+
+	save_nestlevel = NewGUCNestLevel();
+	set_option("hashjoin_radix_threshold", radix ? "0" : "-1");
+	snprintf(partbuf, sizeof(partbuf), "%d", partition_log2);
+	set_option("hashjoin_radix_partition_log2", partbuf);
+	set_option("enable_mergejoin", "off");
+	set_option("enable_nestloop", "off");
+	set_option("max_parallel_workers_per_gather", "0");
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	for (i = 0; i < loops; i++)
+	{
+		instr_time	start_time;
+		instr_time	duration;
+		int64		count;
+		bool		isnull;
+		int			ret;
+
+		CHECK_FOR_INTERRUPTS();
+
+		INSTR_TIME_SET_CURRENT(start_time);
+		ret = SPI_execute(buf.data, true, 0);
+		INSTR_TIME_SET_CURRENT(duration);
+		INSTR_TIME_SUBTRACT(duration, start_time);
+
+		if (ret != SPI_OK_SELECT || SPI_processed != 1)
+			elog(ERROR, "query did not return a row count");
+		count = DatumGetInt64(SPI_getbinval(SPI_tuptable->vals[0],
+											SPI_tuptable->tupdesc,
+											1, &isnull));
+		SPI_freetuptable(SPI_tuptable);
+
+		if (i > 0 && count != nrows)
+			elog(ERROR, "run %d returned " INT64_FORMAT " rows, expected "
+				 INT64_FORMAT, i + 1, count, nrows);
+		nrows = count;
+
+		if (i == 0 || INSTR_TIME_GET_MILLISEC(duration) < best_ms)
+			best_ms = INSTR_TIME_GET_MILLISEC(duration);
+	}
+
+	SPI_finish();
+
+	AtEOXact_GUC(true, save_nestlevel);
+
+	values[0] = Int64GetDatum(nrows);
+	values[1] = Float8GetDatum(best_ms);
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
@@ -0,0 +1,114 @@
+# Exercise the batched writes of checkpointer and bgwriter, with each
+# io_method this build supports.
+
+use strict;
+use warnings;
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my @io_methods = ('sync');
+push @io_methods, 'io_uring' if check_pg_config("#define USE_LIBURING 1");
+
+foreach my $io_method (@io_methods)
+{
+	my $node = PostgreSQL::Test::Cluster->new("io_batch_$io_method");
+
+	# Checksums are set on the private copies of the pages written, so
+	# verify them when reading the pages back.
+	$node->init(extra => ['--data-checksums']);
+	$node->append_conf(
+		'postgresql.conf', qq{
+io_method = $io_method
+shared_buffers = '1MB' # small, so that bgwriter has work to do
+bgwriter_delay = '10ms'
+bgwriter_lru_maxpages = 1000
+bgwriter_lru_multiplier = 10.0
+checkpoint_write_combine_limit = 8
+checkpoint_completion_target = 0
+wal_level = replica
+});
+	$node->start;
+
+	$node->safe_psql(
+		'postgres', qq{
+create table t1 (id int, v text);
+create table t2 (id int, v text);
+insert into t1 select g, md5(g::text) from generate_series(1, 20000) g;
+insert into t2 select g, repeat(md5(g::text), 4) from generate_series(1, 5000) g;
+create index t1_id on t1 (id);
+});
+
+	# Dirty pages all over both tables, checkpointing in between, so that
+	# checkpoints write runs of adjacent blocks from several relations.
+	for my $round (1 .. 5)
+	{
+		$node->safe_psql(
+			'postgres', qq{
+update t1 set v = md5(v || $round) where id % 3 = $round % 3;
+update t2 set v = repeat(md5(v || $round), 4) where id % 2 = $round % 2;
+delete from t1 where id % 97 = $round;
+insert into t1 select g, md5(g::text || $round)
+  from generate_series(20000 + ($round - 1) * 1000 + 1, 20000 + $round * 1000) g;
+checkpoint;
+});
+	}
+
+	# Checkpoints concurrent with updates of the pages being written, so that
+	# the batches find buffers locked or already under I/O
+	$node->pgbench(
+		'--no-vacuum --client=4 --transactions=200',
+		0,
+		[qr{processed: 800/800}],
+		[qr{^$}],
+		"$io_method: concurrent updates and checkpoints",
+		{
+			"005_io_batch_update_$io_method\@9" => q{
+\set id random(1, 20000)
+update t1 set v = md5(v) where id = :id;
+update t2 set v = repeat(md5(v), 4) where id = :id % 5000 + 1;
+},
+			"005_io_batch_checkpoint_$io_method\@1" => 'checkpoint;'
+		});
+
+	# One more round of changes, left for the last checkpoint only
+	$node->safe_psql('postgres',
+		'update t1 set v = md5(v) where id % 5 = 0; checkpoint;');
+
+	my $query = q{
+select count(*), sum(hashtext(v)) from t1
+union all
+select count(*), sum(hashtext(v)) from t2
+};
+	my $expected = $node->safe_psql('postgres', $query);
+
+	my $written = $node->safe_psql('postgres',
+		q{select sum(writes) > 0 from pg_stat_io
+		  where backend_type = 'checkpointer' and object = 'relation'});
+	is($written, 't', "$io_method: checkpointer wrote relation pages");
+
+	# Nothing changed after the last checkpoint, so recovery has nothing to
+	# replay and the data must be what the checkpoints wrote.  Restarting
+	# also makes us read every page back from disk.
+	$node->stop('immediate');
+	$node->start;
+
+	is($node->safe_psql('postgres', $query),
+		$expected, "$io_method: data intact after crash recovery");
+	is( $node->safe_psql(
+			'postgres', q{set enable_seqscan = off;
+			  select count(*) from t1 where id between 100 and 20000}),
+		$node->safe_psql(
+			'postgres', q{set enable_indexscan = off; set enable_bitmapscan = off;
+			  select count(*) from t1 where id between 100 and 20000}),
+		"$io_method: index agrees with heap after crash recovery");
+
+	# A clean shutdown writes everything through the shutdown checkpoint
+	$node->stop;
+	$node->start;
+	is($node->safe_psql('postgres', $query),
+		$expected, "$io_method: data intact after restart");
+	$node->stop;
+}
+
+done_testing();
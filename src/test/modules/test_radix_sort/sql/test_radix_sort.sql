@@ -0,0 +1,28 @@
+CREATE EXTENSION test_radix_sort;
+
+SET work_mem = '64MB';
+
+-- See README for explanation of arguments; each call checks the result
+SELECT test_radix_sort('int4', 100000) >= 0;
+SELECT test_radix_sort('int4', 100000, radix => false) >= 0;
+SELECT test_radix_sort('int8', 100000) >= 0;
+SELECT test_radix_sort('int8', 100000, ndistinct => 10) >= 0;
+SELECT test_radix_sort('date', 100000, ndistinct => 1000) >= 0;
+SELECT test_radix_sort('timestamptz', 100000) >= 0;
+SELECT test_radix_sort('text', 100000) >= 0;
+SELECT test_radix_sort('text', 100000, ndistinct => 100) >= 0;
+SELECT test_radix_sort('uuid', 100000) >= 0;
+SELECT test_radix_sort('uuid', 100000, ndistinct => 5000) >= 0;
+
+-- small and empty sorts
+SELECT test_radix_sort('int4', 10) >= 0;
+SELECT test_radix_sort('int8', 0) >= 0;
+
+-- a sort that spills to disk sorts its runs the same way
+SET work_mem = '1MB';
+SELECT test_radix_sort('int8', 200000) >= 0;
+RESET work_mem;
+
+-- invalid arguments
+SELECT test_radix_sort('int4', -1);
+SELECT test_radix_sort('point', 10);
@@ -0,0 +1,12 @@
+/* src/test/modules/test_radix_sort/test_radix_sort--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_radix_sort" to load this file. \quit
+
+CREATE FUNCTION test_radix_sort(typ regtype,
+    ntuples bigint,
+    ndistinct bigint DEFAULT 0,
+    radix boolean DEFAULT true,
+    seed bigint DEFAULT 0)
+RETURNS pg_catalog.float8 STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
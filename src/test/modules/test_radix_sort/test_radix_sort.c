@@ -0,0 +1,194 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_radix_sort.c
+ *		Microbenchmark for large in-memory sorts in tuplesort.c.
+ *
+ * Copyright (c) 2023, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_radix_sort/test_radix_sort.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "catalog/pg_collation_d.h"
+#include "catalog/pg_type_d.h"
+#include "common/pg_prng.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "portability/instr_time.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/memutils.h"
+#include "utils/sortsupport.h"
+#include "utils/tuplesort.h"
+#include "utils/typcache.h"
+#include "utils/uuid.h"
+
+PG_MODULE_MAGIC;
+
+PG_FUNCTION_INFO_V1(test_radix_sort);
+
+/*
+ * Make a datum of type "typid" from the random value "v".  Values that are
+ * equal produce equal datums, so the number of distinct values can be
+ * controlled by the caller.
+ */
+static Datum
+make_datum(Oid typid, uint64 v)
+{
+	/* scramble v for the types compared byte by byte */
+	uint64		h = v * UINT64CONST(0x9E3779B97F4A7C15);
+
+	switch (typid)
+	{
+		case INT4OID:
+		case DATEOID:
+			return Int32GetDatum((int32) v);
+		case INT8OID:
+			return Int64GetDatum((int64) v);
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			/* stay clear of the infinities */
+			return Int64GetDatum((int64) (v >> 2) - (INT64CONST(1) << 61));
+		case TEXTOID:
+			{
+				char		buf[32];
+
+				snprintf(buf, sizeof(buf), "%016" INT64_MODIFIER "x%04x",
+						 h, (unsigned int) (v & 0xFFFF));
+				return PointerGetDatum(cstring_to_text(buf));
+			}
+		case UUIDOID:
+			{
+				pg_uuid_t  *uuid = palloc(sizeof(pg_uuid_t));
+				int			i;
+
+				for (i = 0; i < 8; i++)
+				{
+					uuid->data[i] = (unsigned char) (h >> (56 - i * 8));
+					uuid->data[i + 8] = (unsigned char) (v >> (56 - i * 8));
+				}
+				return UUIDPGetDatum(uuid);
+			}
+		default:
+			elog(ERROR, "unsupported type: %s", format_type_be(typid));
+			return (Datum) 0;	/* keep compiler quiet */
+	}
+}
+
+/*
+ * Sort "ntuples" random values of type "typ" with a Datum tuplesort, and
+ * return the time spent in tuplesort_performsort(), in milliseconds.
+ *
+ * If "ndistinct" is greater than zero, the values are drawn from that many
+ * distinct ones.  "radix" sets enable_radix_sort for the duration of the
+ * sort.  The result is checked to be in order.
+ *
+ * The sort uses work_mem; set it high enough for the sort to fit in memory
+ * to measure the in-memory sort algorithms alone.
+ */
+Datum
+test_radix_sort(PG_FUNCTION_ARGS)
+{
+	Oid			typid = PG_GETARG_OID(0);
+	int64		ntuples = PG_GETARG_INT64(1);
+	int64		ndistinct = PG_GETARG_INT64(2);
+	bool		radix = PG_GETARG_BOOL(3);
+	int64		seed = PG_GETARG_INT64(4);
+	TypeCacheEntry *typentry;
+	Oid			collation;
+	Tuplesortstate *sortstate;
+	SortSupportData ssup;
+	MemoryContext valcxt;
+	MemoryContext oldcxt;
+	pg_prng_state prng;
+	instr_time	start_time;
+	instr_time	duration;
+	Datum		prev = (Datum) 0;
+	Datum		val;
+	bool		isnull;
+	int			save_nestlevel;
+	int64		i;
+
+	if (ntuples < 0)
+		elog(ERROR, "invalid number of tuples: " INT64_FORMAT, ntuples);
+	if (ndistinct < 0)
+		elog(ERROR, "invalid number of distinct values: " INT64_FORMAT,
+			 ndistinct);
+
+	typentry = lookup_type_cache(typid, TYPECACHE_LT_OPR);
+	if (!OidIsValid(typentry->lt_opr))
+		elog(ERROR, "no ordering operator for type %s", format_type_be(typid));
+
+	/* text is sorted in the C collation, which uses abbreviated keys */
+	collation = (typid == TEXTOID) ? C_COLLATION_OID : InvalidOid;
+
+	save_nestlevel = NewGUCNestLevel();
+	(void) set_config_option("enable_radix_sort", radix ? "on" : "off",
+							 PGC_USERSET, PGC_S_SESSION,
+							 GUC_ACTION_SAVE, true, 0, false);
+
+	sortstate = tuplesort_begin_datum(typid, typentry->lt_opr, collation,
+									  false, work_mem, NULL, TUPLESORT_NONE);
+
+	valcxt = AllocSetContextCreate(CurrentMemoryContext,
+								   "test_radix_sort values",
+								   ALLOCSET_DEFAULT_SIZES);
+
+	pg_prng_seed(&prng, (uint64) seed);
+	for (i = 0; i < ntuples; i++)
+	{
+		uint64		v;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (ndistinct > 0)
+			v = pg_prng_uint64_range(&prng, 0, ndistinct - 1);
+		else
+			v = pg_prng_uint64(&prng);
+
+		oldcxt = MemoryContextSwitchTo(valcxt);
+		val = make_datum(typid, v);
+		MemoryContextSwitchTo(oldcxt);
+
+		tuplesort_putdatum(sortstate, val, false);
+
+		if ((i & 0xFFFF) == 0xFFFF)
+			MemoryContextReset(valcxt);
+	}
+	MemoryContextReset(valcxt);
+
+	INSTR_TIME_SET_CURRENT(start_time);
+	tuplesort_performsort(sortstate);
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start_time);
+
+	/* Check the result with the type's comparison function */
+	memset(&ssup, 0, sizeof(ssup));
+	ssup.ssup_cxt = CurrentMemoryContext;
+	ssup.ssup_collation = collation;
+	PrepareSortSupportFromOrderingOp(typentry->lt_opr, &ssup);
+
+	for (i = 0; i < ntuples; i++)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		if (!tuplesort_getdatum(sortstate, true, true, &val, &isnull, NULL))
+			elog(ERROR, "sort returned " INT64_FORMAT " tuples, expected "
+				 INT64_FORMAT, i, ntuples);
+		if (i > 0 && ApplySortComparator(prev, false, val, false, &ssup) > 0)
+			elog(ERROR, "tuple " INT64_FORMAT " is out of order", i);
+		if (i > 0 && !typentry->typbyval)
+			pfree(DatumGetPointer(prev));
+		prev = val;
+	}
+
+	tuplesort_end(sortstate);
+	MemoryContextDelete(valcxt);
+
+	AtEOXact_GUC(true, save_nestlevel);
+
+	PG_RETURN_FLOAT8(INSTR_TIME_GET_MILLISEC(duration));
+}
@@ -0,0 +1,10 @@
+CREATE EXTENSION test_wal_insert;
+
+-- See README for explanation of arguments:
+SELECT test_wal_insert(nrecords => 1000, record_size => 64) >= 1000 * 64;
+SELECT test_wal_insert(nrecords => 10, record_size => 100000) >= 10 * 100000;
+SELECT test_wal_insert(0) = 0;
+
+-- invalid arguments
+SELECT test_wal_insert(-1);
+SELECT test_wal_insert(1, -1);
@@ -0,0 +1,9 @@
+/* src/test/modules/test_wal_insert/test_wal_insert--1.0.sql */
+
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION test_wal_insert" to load this file. \quit
+
+CREATE FUNCTION test_wal_insert(nrecords bigint,
+    record_size integer DEFAULT 64)
+RETURNS pg_catalog.int8 STRICT
+AS 'MODULE_PATHNAME' LANGUAGE C;
@@ -0,0 +1,64 @@
+/*--------------------------------------------------------------------------
+ *
+ * test_wal_insert.c
+ *		Microbenchmark for concurrent WAL insertion.
+ *
+ * Copyright (c) 2023, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		src/test/modules/test_wal_insert/test_wal_insert.c
+ *
+ * -------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "executor/instrument.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "replication/message.h"
+
+PG_MODULE_MAGIC;
+
+/* Largest payload accepted for a single record (1MB): */
+#define MAX_RECORD_SIZE			(1024 * 1024)
+
+PG_FUNCTION_INFO_V1(test_wal_insert);
+
+/*
+ * Insert "nrecords" WAL records with a payload of "record_size" bytes each,
+ * and return the number of bytes of WAL generated.
+ *
+ * Non-transactional logical decoding messages are used because they go
+ * straight to XLogInsert() without assigning an XID, taking any buffer
+ * locks or flushing WAL, so that running this from many sessions at once
+ * stresses little else than WAL space reservation and copying into the WAL
+ * buffers.
+ */
+Datum
+test_wal_insert(PG_FUNCTION_ARGS)
+{
+	int64		nrecords = PG_GETARG_INT64(0);
+	int32		record_size = PG_GETARG_INT32(1);
+	int64		start_bytes = pgWalUsage.wal_bytes;
+	char	   *payload;
+	int64		i;
+
+	if (nrecords < 0)
+		elog(ERROR, "invalid number of records: " INT64_FORMAT, nrecords);
+	if (record_size < 0 || record_size > MAX_RECORD_SIZE)
+		elog(ERROR, "record size must be between 0 and %d", MAX_RECORD_SIZE);
+
+	payload = palloc0(Max(record_size, 1));
+
+	for (i = 0; i < nrecords; i++)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		(void) LogLogicalMessage("test_wal_insert", payload, record_size,
+								 false);
+	}
+
+	pfree(payload);
+
+	PG_RETURN_INT64(pgWalUsage.wal_bytes - start_bytes);
+}
@@ -0,0 +1,2 @@
+-- pgbench script for test_wal_insert; see README
+SELECT test_wal_insert(100, 64);
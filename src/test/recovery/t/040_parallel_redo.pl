@@ -0,0 +1,108 @@
+
+# Copyright (c) 2023, PostgreSQL Global Development Group
+
+# Test replay of WAL with parallel redo workers (recovery_parallel_workers)
+use strict;
+use warnings;
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $node_primary = PostgreSQL::Test::Cluster->new('primary');
+$node_primary->init(allows_streaming => 1);
+$node_primary->start;
+
+my $backup_name = 'my_backup';
+$node_primary->backup($backup_name);
+
+my $node_standby = PostgreSQL::Test::Cluster->new('standby');
+$node_standby->init_from_backup($node_primary, $backup_name,
+	has_streaming => 1);
+$node_standby->append_conf(
+	'postgresql.conf', qq(
+recovery_parallel_workers = 4
+max_worker_processes = 8
+));
+$node_standby->start;
+
+# Workers are started with the first record replayed after reaching
+# consistency.
+$node_primary->safe_psql('postgres', 'CREATE TABLE warmup (a int)');
+$node_primary->wait_for_replay_catchup($node_standby);
+ok( $node_standby->log_contains(qr/started 4 parallel redo workers/),
+	'parallel redo workers started');
+
+# A mix of records: page-local changes to several relations, multi-relation
+# records, truncation, and relation drops.
+$node_primary->safe_psql(
+	'postgres', q{
+CREATE TABLE t1 (id int PRIMARY KEY, val text);
+CREATE TABLE t2 (id int, val int);
+CREATE INDEX t2_val ON t2 USING hash (val);
+CREATE TABLE t3 (id int, arr int[]);
+CREATE INDEX t3_arr ON t3 USING gin (arr);
+INSERT INTO t1 SELECT g, repeat('x', g % 100) FROM generate_series(1, 20000) g;
+INSERT INTO t2 SELECT g, g % 37 FROM generate_series(1, 20000) g;
+INSERT INTO t3 SELECT g, ARRAY[g % 10, g % 100] FROM generate_series(1, 5000) g;
+UPDATE t1 SET val = val || 'y' WHERE id % 3 = 0;
+DELETE FROM t2 WHERE id % 5 = 0;
+VACUUM t1, t2;
+CREATE TABLE t4 AS SELECT * FROM t1 WHERE id < 1000;
+TRUNCATE t4;
+INSERT INTO t4 SELECT * FROM t1 WHERE id < 500;
+CREATE TABLE t5 AS SELECT g FROM generate_series(1, 1000) g;
+DROP TABLE t5;
+});
+
+# A few concurrent sessions to interleave the WAL of several relations.
+my @sessions;
+for my $i (1 .. 4)
+{
+	my $session = $node_primary->background_psql('postgres');
+	$session->query_safe(
+		"INSERT INTO t2 SELECT g, $i FROM generate_series(1, 5000) g");
+	push @sessions, $session;
+}
+$_->quit foreach @sessions;
+
+$node_primary->wait_for_replay_catchup($node_standby);
+
+my $query = q{
+SELECT (SELECT count(*) || ':' || sum(length(val)) FROM t1),
+	   (SELECT count(*) || ':' || sum(val) FROM t2),
+	   (SELECT count(*) FROM t2 WHERE val = 3),
+	   (SELECT count(*) FROM t3 WHERE arr @> ARRAY[7]),
+	   (SELECT count(*) FROM t4),
+	   (SELECT count(*) FROM pg_class WHERE relname = 't5')
+};
+my $expected = $node_primary->safe_psql('postgres', $query);
+is($node_standby->safe_psql('postgres', $query),
+	$expected, 'standby matches primary after parallel redo');
+
+# Check that the indexes were replayed consistently with the heap.
+my $result = $node_standby->safe_psql(
+	'postgres', q{
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SELECT count(*) FROM t1 WHERE id BETWEEN 100 AND 199;
+});
+is($result, '100', 'btree index scan on standby');
+
+# Promotion waits for the workers to finish and stops them.
+$node_primary->safe_psql('postgres',
+	'INSERT INTO t1 SELECT g, g::text FROM generate_series(20001, 30000) g');
+$node_primary->wait_for_replay_catchup($node_standby);
+$node_standby->promote;
+
+is( $node_standby->safe_psql('postgres', 'SELECT count(*) FROM t1'),
+	'30000', 'all WAL replayed before promotion');
+$node_standby->safe_psql('postgres',
+	'INSERT INTO t1 VALUES (30001, \'after promotion\')');
+is( $node_standby->safe_psql(
+		'postgres',
+		"SELECT count(*) FROM pg_stat_activity WHERE backend_type = 'parallel redo worker'"
+	),
+	'0',
+	'parallel redo workers exited after promotion');
+
+done_testing();
@@ -0,0 +1,112 @@
+
+# Copyright (c) 2023, PostgreSQL Global Development Group
+
+# Test MVCC snapshots taken from the CSN log (csn_snapshots = on)
+use strict;
+use warnings;
+use PostgreSQL::Test::Cluster;
+use PostgreSQL::Test::Utils;
+use Test::More;
+
+my $node = PostgreSQL::Test::Cluster->new('primary');
+$node->init(allows_streaming => 1);
+$node->append_conf(
+	'postgresql.conf', q{
+csn_snapshots = on
+max_prepared_transactions = 5
+});
+$node->start;
+
+$node->safe_psql('postgres', 'CREATE TABLE t (id int, val text)');
+
+# A repeatable read snapshot must not see rows committed after it was taken.
+my $s1 = $node->background_psql('postgres');
+$s1->query_safe('BEGIN ISOLATION LEVEL REPEATABLE READ');
+is($s1->query_safe('SELECT count(*) FROM t'), '0', 'empty at snapshot');
+
+$node->safe_psql('postgres', "INSERT INTO t VALUES (1, 'one')");
+is($s1->query_safe('SELECT count(*) FROM t'),
+	'0', 'concurrent commit invisible to repeatable read snapshot');
+is($node->safe_psql('postgres', 'SELECT count(*) FROM t'),
+	'1', 'commit visible to new snapshot');
+$s1->query_safe('COMMIT');
+
+# In-progress and aborted transactions, including subtransactions.
+$s1->query_safe('BEGIN');
+$s1->query_safe("INSERT INTO t VALUES (2, 'two')");
+$s1->query_safe('SAVEPOINT a');
+$s1->query_safe("INSERT INTO t VALUES (3, 'three')");
+$s1->query_safe('SAVEPOINT b');
+$s1->query_safe("INSERT INTO t VALUES (4, 'four')");
+$s1->query_safe('ROLLBACK TO b');
+is($node->safe_psql('postgres', 'SELECT count(*) FROM t'),
+	'1', 'in-progress transaction invisible');
+
+my $snap = $node->safe_psql('postgres',
+	'SELECT pg_snapshot_xip(pg_current_snapshot())');
+isnt($snap, '', 'pg_current_snapshot lists the running transaction');
+
+$s1->query_safe('COMMIT');
+is($node->safe_psql('postgres', 'SELECT string_agg(id::text, \',\' ORDER BY id) FROM t'),
+	'1,2,3', 'committed subtransactions visible, aborted one not');
+
+# Exported snapshots carry the CSN.
+my $s2 = $node->background_psql('postgres');
+$s2->query_safe('BEGIN ISOLATION LEVEL REPEATABLE READ');
+my $exported = $s2->query_safe('SELECT pg_export_snapshot()');
+$node->safe_psql('postgres', "INSERT INTO t VALUES (5, 'five')");
+is( $node->safe_psql(
+		'postgres', qq{
+BEGIN ISOLATION LEVEL REPEATABLE READ;
+SET TRANSACTION SNAPSHOT '$exported';
+SELECT count(*) FROM t;
+COMMIT;
+}),
+	'3',
+	'imported snapshot does not see later commit');
+$s2->query_safe('COMMIT');
+$s2->quit;
+
+# A prepared transaction survives a restart and stays invisible until it is
+# committed.
+$s1->query_safe('BEGIN');
+$s1->query_safe("INSERT INTO t VALUES (6, 'six')");
+$s1->query_safe("PREPARE TRANSACTION 'p1'");
+$s1->quit;
+
+$node->restart;
+is($node->safe_psql('postgres', 'SELECT count(*) FROM t'),
+	'4', 'prepared transaction invisible after restart');
+$node->safe_psql('postgres', "COMMIT PREPARED 'p1'");
+is($node->safe_psql('postgres', 'SELECT count(*) FROM t'),
+	'5', 'prepared transaction visible once committed');
+
+# Data committed before the restart stays visible after a crash.
+$node->stop('immediate');
+$node->start;
+is($node->safe_psql('postgres', 'SELECT count(*) FROM t'),
+	'5', 'data visible after crash recovery');
+
+# Standbys use regular snapshots, and switch to CSN snapshots on promotion.
+$node->backup('backup');
+my $standby = PostgreSQL::Test::Cluster->new('standby');
+$standby->init_from_backup($node, 'backup', has_streaming => 1);
+$standby->start;
+
+$node->safe_psql('postgres', "INSERT INTO t VALUES (7, 'seven')");
+$node->wait_for_catchup($standby);
+is($standby->safe_psql('postgres', 'SELECT count(*) FROM t'),
+	'6', 'standby sees replicated rows');
+
+$standby->promote;
+$standby->safe_psql('postgres', "INSERT INTO t VALUES (8, 'eight')");
+is($standby->safe_psql('postgres', 'SELECT count(*) FROM t'),
+	'7', 'promoted standby sees its own commits');
+
+# VACUUM must still be able to remove dead rows.
+$standby->safe_psql('postgres', 'DELETE FROM t WHERE id > 6');
+$standby->safe_psql('postgres', 'VACUUM t');
+is($standby->safe_psql('postgres', 'SELECT count(*) FROM t'),
+	'5', 'vacuum after promotion');
+
+done_testing();
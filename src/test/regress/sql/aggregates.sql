@@ -1417,6 +1417,58 @@ create table agg_hash_4 as
 select (g/2)::numeric as c1, array_agg(g::numeric) as c2, count(*) as c3
   from agg_data_2k group by g/2;
 
+-- Produce results with parallel hash aggregation, which spills into
+-- partitions shared by all participants
+
+set parallel_setup_cost = 0;
+set parallel_tuple_cost = 0;
+set min_parallel_table_scan_size = 0;
+set max_parallel_workers_per_gather = 2;
+
+explain (costs off)
+select g%10000 as c1, sum(g::numeric) as c2, count(*) as c3
+  from agg_data_20k group by g%10000;
+
+-- Check that workers took part and that the shared partitions were used
+create function agg_shared_spill(query text,
+  out workers_launched int, out shared_batches int)
+language plpgsql
+as
+$$
+declare
+  whole_plan jsonb;
+begin
+  execute 'explain (analyze, costs off, timing off, summary off, format json) ' || query
+    into whole_plan;
+  select coalesce(sum(v::int), 0) into workers_launched
+    from jsonb_path_query(whole_plan, 'strict $.**."Workers Launched"') v;
+  select coalesce(sum(v::int), 0) into shared_batches
+    from jsonb_path_query(whole_plan, 'strict $.**."Shared Batches"') v;
+end;
+$$;
+
+select workers_launched > 0 as workers_launched,
+       shared_batches > 0 as shared_spill
+  from agg_shared_spill($$
+select g%10000 as c1, sum(g::numeric) as c2, count(*) as c3
+  from agg_data_20k group by g%10000
+$$);
+
+drop function agg_shared_spill(text);
+
+create table agg_hash_5 as
+select g%10000 as c1, sum(g::numeric) as c2, count(*) as c3
+  from agg_data_20k group by g%10000;
+
+create table agg_hash_6 as
+select (g/2)::numeric as c1, sum(7::int4) as c2, count(*) as c3
+  from agg_data_2k group by g/2;
+
+reset max_parallel_workers_per_gather;
+reset min_parallel_table_scan_size;
+reset parallel_tuple_cost;
+reset parallel_setup_cost;
+
 set enable_sort = true;
 set work_mem to default;
 
@@ -1438,6 +1490,14 @@ set work_mem to default;
   union all
 (select * from agg_group_4 except select * from agg_hash_4);
 
+(select * from agg_hash_5 except select * from agg_group_1)
+  union all
+(select * from agg_group_1 except select * from agg_hash_5);
+
+(select * from agg_hash_6 except select * from agg_group_3)
+  union all
+(select * from agg_group_3 except select * from agg_hash_6);
+
 drop table agg_group_1;
 drop table agg_group_2;
 drop table agg_group_3;
@@ -1446,3 +1506,5 @@ drop table agg_hash_1;
 drop table agg_hash_2;
 drop table agg_hash_3;
 drop table agg_hash_4;
+drop table agg_hash_5;
+drop table agg_hash_6;
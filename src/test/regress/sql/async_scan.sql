@@ -0,0 +1,75 @@
+--
+-- Tests for asynchronous local scans under Append (enable_async_scan)
+--
+
+CREATE TABLE async_pt (a int, b int, c text) PARTITION BY RANGE (a);
+CREATE TABLE async_p1 PARTITION OF async_pt FOR VALUES FROM (0) TO (1000);
+CREATE TABLE async_p2 PARTITION OF async_pt FOR VALUES FROM (1000) TO (2000);
+CREATE TABLE async_p3 PARTITION OF async_pt FOR VALUES FROM (2000) TO (3000);
+INSERT INTO async_pt SELECT g, g % 50, 'row ' || g FROM generate_series(0, 2999) g;
+CREATE INDEX ON async_pt (b);
+ANALYZE async_pt;
+
+SET max_parallel_workers_per_gather = 0;
+SET enable_async_scan = on;
+
+-- Sequential scans
+EXPLAIN (COSTS OFF)
+SELECT count(*), sum(a) FROM async_pt WHERE c LIKE 'row 1%';
+SELECT count(*), sum(a) FROM async_pt WHERE c LIKE 'row 1%';
+
+-- Tuples from all partitions must come out, each exactly once
+SELECT count(DISTINCT a), min(a), max(a) FROM async_pt;
+
+-- Bitmap heap scans
+SET enable_seqscan = off;
+SET enable_indexscan = off;
+EXPLAIN (COSTS OFF)
+SELECT count(*), sum(a) FROM async_pt WHERE b IN (3, 7);
+SELECT count(*), sum(a) FROM async_pt WHERE b IN (3, 7);
+RESET enable_seqscan;
+RESET enable_indexscan;
+
+-- With a LIMIT, the scans stop early
+SELECT count(*) FROM (SELECT * FROM async_pt LIMIT 10) s;
+
+-- Rescans, as the inner side of a nested loop
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+SET enable_material = off;
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM (VALUES (1), (2), (3)) v(x)
+  JOIN async_pt ON async_pt.b = v.x AND async_pt.c LIKE '%1';
+SELECT count(*) FROM (VALUES (1), (2), (3)) v(x)
+  JOIN async_pt ON async_pt.b = v.x AND async_pt.c LIKE '%1';
+RESET enable_hashjoin;
+RESET enable_mergejoin;
+RESET enable_material;
+
+-- Gather nodes below an Append
+RESET max_parallel_workers_per_gather;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET parallel_leader_participation = off;
+EXPLAIN (COSTS OFF)
+SELECT count(*), sum(a) FROM
+  (SELECT a FROM async_p1 WHERE b < 10
+   UNION ALL
+   SELECT a FROM async_p2 WHERE b < 20 OFFSET 0) s;
+SELECT count(*), sum(a) FROM
+  (SELECT a FROM async_p1 WHERE b < 10
+   UNION ALL
+   SELECT a FROM async_p2 WHERE b < 20 OFFSET 0) s;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET parallel_leader_participation;
+
+-- Nothing is async with the setting off
+SET enable_async_scan = off;
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM async_pt;
+
+RESET enable_async_scan;
+DROP TABLE async_pt;
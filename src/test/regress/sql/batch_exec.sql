@@ -0,0 +1,71 @@
+--
+-- Tests for batch execution mode (enable_batch_execution)
+--
+
+CREATE TABLE batch_tbl (i4 int4, i8 int8, i2 int2, f8 float8, t text);
+INSERT INTO batch_tbl
+  SELECT g, g * 1000000000::int8, (g % 100)::int2, g / 7.0,
+         CASE WHEN g % 10 = 0 THEN NULL ELSE 'row ' || g END
+  FROM generate_series(1, 5000) g;
+INSERT INTO batch_tbl VALUES (NULL, NULL, NULL, NULL, NULL);
+ANALYZE batch_tbl;
+
+SET max_parallel_workers_per_gather = 0;
+
+-- Queries to run in both modes; results must match.
+CREATE TEMP TABLE batch_queries (id int, q text);
+INSERT INTO batch_queries VALUES
+  (1, 'SELECT count(*) FROM batch_tbl'),
+  (2, 'SELECT count(i4), count(t), sum(i4), sum(i2), sum(f8) FROM batch_tbl'),
+  (3, 'SELECT min(i4), max(i4), min(i8), max(i8), min(f8), max(f8) FROM batch_tbl'),
+  (4, 'SELECT count(*), sum(i8) FROM batch_tbl WHERE i4 > 1000 AND i4 <= 4000'),
+  (5, 'SELECT sum(i4 * 2 + 1), sum(f8 * 3.5), max(i8 - i4) FROM batch_tbl WHERE i2 <> 7'),
+  (6, 'SELECT count(*) FILTER (WHERE i4 % 3 = 0), sum(i4) FILTER (WHERE f8 < 100) FROM batch_tbl'),
+  (7, 'SELECT count(*) FROM batch_tbl WHERE i4 IS NULL'),
+  (8, 'SELECT count(*), sum(i4) FROM batch_tbl WHERE NOT (i4 < 2500)'),
+  (9, 'SELECT count(*), min(i4), sum(i4) FROM batch_tbl WHERE i4 > 100000'),
+  (10, 'SELECT stddev(f8)::numeric(20,6), avg(f8)::numeric(20,6), bool_and(i4 > 0) FROM batch_tbl'),
+  (11, 'SELECT count(*) + 1, sum(abs(i4 - 2500)) FROM batch_tbl WHERE i4 + 0 >= 10');
+
+CREATE FUNCTION batch_run(query text, batch bool) RETURNS text
+LANGUAGE plpgsql AS $$
+DECLARE
+  result text;
+BEGIN
+  PERFORM set_config('enable_batch_execution', batch::text, true);
+  EXECUTE 'SELECT q::text FROM (' || query || ') q' INTO result;
+  RETURN result;
+END;
+$$;
+
+SELECT id, batch_run(q, false) IS NOT DISTINCT FROM batch_run(q, true) AS same
+  FROM batch_queries ORDER BY id;
+
+SET enable_batch_execution = on;
+
+-- Batch mode should be reported by EXPLAIN where it applies
+EXPLAIN (COSTS OFF)
+SELECT count(*), sum(i4) FROM batch_tbl WHERE i8 > 10;
+-- but not for grouped aggregates or non-byval columns in the qual
+EXPLAIN (COSTS OFF)
+SELECT i2, count(*) FROM batch_tbl GROUP BY i2;
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM batch_tbl WHERE t LIKE 'row 1%';
+
+SELECT count(*), sum(i4), max(f8) FROM batch_tbl WHERE i8 > 10;
+SELECT count(*) FROM batch_tbl WHERE t LIKE 'row 1%';
+
+-- Empty input
+SELECT count(*), sum(i4), min(i8) FROM batch_tbl WHERE false;
+
+-- Errors must be the same as in row mode
+SELECT sum(i4 * 1000000) FROM batch_tbl;
+SELECT sum(i8 * i8) FROM batch_tbl;
+
+-- Rescans, e.g. from a correlated subquery
+SELECT g, (SELECT count(*) FROM batch_tbl WHERE i4 < g * 1000) FROM generate_series(1, 3) g;
+
+RESET enable_batch_execution;
+RESET max_parallel_workers_per_gather;
+DROP FUNCTION batch_run(text, bool);
+DROP TABLE batch_tbl;
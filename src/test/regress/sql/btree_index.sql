@@ -242,3 +242,159 @@ CREATE TABLE btree_part (id int4) PARTITION BY RANGE (id);
 CREATE INDEX btree_part_idx ON btree_part(id);
 ALTER INDEX btree_part_idx ALTER COLUMN id SET (n_distinct=100);
 DROP TABLE btree_part;
+
+--
+-- Test skip scan: quals on the second column of an index only
+--
+CREATE TABLE btree_skip (a int, b int, c text);
+INSERT INTO btree_skip
+  SELECT i % 10, i, 'x' || i FROM generate_series(1, 10000) i;
+INSERT INTO btree_skip SELECT NULL, i, 'n' || i FROM generate_series(1, 100) i;
+CREATE INDEX btree_skip_idx ON btree_skip (a, b);
+VACUUM ANALYZE btree_skip;
+
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+
+EXPLAIN (COSTS OFF)
+SELECT a, b FROM btree_skip WHERE b = 57;
+SELECT a, b FROM btree_skip WHERE b = 57;
+SELECT a, b FROM btree_skip WHERE b = 57 ORDER BY a DESC, b DESC;
+SELECT a, b FROM btree_skip WHERE b BETWEEN 5 AND 12 ORDER BY a, b;
+SELECT a, b FROM btree_skip WHERE b BETWEEN 5 AND 12 ORDER BY a DESC, b DESC;
+SELECT a, b, c FROM btree_skip WHERE b IN (3, 44, 9999) ORDER BY a, b;
+SELECT a, b, c FROM btree_skip WHERE b IN (3, 44, 9999) ORDER BY a DESC, b DESC;
+SELECT count(*) FROM btree_skip WHERE b < 0;
+
+-- Non-existent values, and NULLs in the leading column
+SELECT count(*) FROM btree_skip WHERE b = 100000;
+SELECT a, b, c FROM btree_skip WHERE b = 99 ORDER BY a NULLS FIRST;
+
+-- Bitmap scans skip too
+SET enable_indexscan = off;
+SET enable_bitmapscan = on;
+EXPLAIN (COSTS OFF)
+SELECT count(*) FROM btree_skip WHERE b = 57;
+SELECT count(*) FROM btree_skip WHERE b = 57;
+SELECT count(*) FROM btree_skip WHERE b IN (1, 2, 3, 57);
+RESET enable_indexscan;
+SET enable_bitmapscan = off;
+
+-- DESC leading column
+DROP INDEX btree_skip_idx;
+CREATE INDEX btree_skip_desc_idx ON btree_skip (a DESC NULLS LAST, b);
+SELECT a, b FROM btree_skip WHERE b = 57 ORDER BY a DESC NULLS LAST;
+SELECT a, b FROM btree_skip WHERE b = 57 ORDER BY a NULLS FIRST;
+SELECT a, b FROM btree_skip WHERE b = 99 ORDER BY a DESC NULLS LAST;
+
+-- Mark and restore, via a merge join that also joins on the second column
+DROP INDEX btree_skip_desc_idx;
+CREATE INDEX btree_skip_idx ON btree_skip (a, b);
+SET enable_hashjoin = off;
+SET enable_nestloop = off;
+CREATE TABLE btree_skip_outer (a int, b int);
+INSERT INTO btree_skip_outer
+  VALUES (1, 11), (1, 11), (3, 13), (3, 13), (3, 13), (7, 17);
+EXPLAIN (COSTS OFF)
+SELECT o.a, o.b, s.c FROM btree_skip_outer o
+  JOIN btree_skip s ON o.a = s.a AND o.b = s.b
+  WHERE s.b BETWEEN 11 AND 17 ORDER BY o.a, o.b;
+SELECT o.a, o.b, s.c FROM btree_skip_outer o
+  JOIN btree_skip s ON o.a = s.a AND o.b = s.b
+  WHERE s.b BETWEEN 11 AND 17 ORDER BY o.a, o.b;
+RESET enable_hashjoin;
+RESET enable_nestloop;
+
+-- A leading column with many distinct values: the scan stops skipping,
+-- and must still return the rows whose leading column is NULL
+CREATE TABLE btree_skip_wide (a int, b int);
+INSERT INTO btree_skip_wide SELECT i % 10, i FROM generate_series(1, 10000) i;
+INSERT INTO btree_skip_wide SELECT 3, NULL FROM generate_series(1, 5);
+CREATE INDEX btree_skip_wide_idx ON btree_skip_wide (b, a);
+VACUUM ANALYZE btree_skip_wide;
+EXPLAIN (COSTS OFF)
+SELECT count(*), count(b), sum(b) FROM btree_skip_wide WHERE a = 3;
+SELECT count(*), count(b), sum(b) FROM btree_skip_wide WHERE a = 3;
+SELECT b FROM btree_skip_wide WHERE a = 3 ORDER BY b DESC NULLS FIRST LIMIT 8;
+SELECT b FROM btree_skip_wide WHERE a = 3 ORDER BY b NULLS LAST OFFSET 997;
+
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+DROP TABLE btree_skip, btree_skip_outer, btree_skip_wide;
+
+--
+-- Test index scans that start from the previous scan's leaf page: nestloop
+-- rescans with sorted and unsorted outer keys, and IN-lists
+--
+CREATE TABLE btree_lastleaf (a int, b text);
+INSERT INTO btree_lastleaf
+  SELECT i / 3, repeat('y', 100) || i FROM generate_series(1, 20000) i;
+CREATE INDEX btree_lastleaf_idx ON btree_lastleaf (a);
+VACUUM ANALYZE btree_lastleaf;
+CREATE TABLE btree_lastleaf_outer (k int);
+INSERT INTO btree_lastleaf_outer
+  SELECT i * 7 FROM generate_series(1, 900) i;
+INSERT INTO btree_lastleaf_outer VALUES (-1), (100000), (3), (3), (6000), (1);
+
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SET enable_material = off;
+EXPLAIN (COSTS OFF)
+SELECT count(*), sum(t.a) FROM
+  (SELECT k FROM btree_lastleaf_outer ORDER BY k OFFSET 0) o
+  JOIN btree_lastleaf t ON t.a = o.k;
+SELECT count(*), sum(t.a) FROM
+  (SELECT k FROM btree_lastleaf_outer ORDER BY k OFFSET 0) o
+  JOIN btree_lastleaf t ON t.a = o.k;
+SELECT count(*), sum(t.a) FROM
+  (SELECT k FROM btree_lastleaf_outer ORDER BY k DESC OFFSET 0) o
+  JOIN btree_lastleaf t ON t.a = o.k;
+SELECT count(*), sum(t.a) FROM btree_lastleaf_outer o
+  JOIN btree_lastleaf t ON t.a = o.k;
+SELECT count(*), sum(t.a) FROM
+  (SELECT k FROM btree_lastleaf_outer ORDER BY k OFFSET 0) o
+  JOIN btree_lastleaf t ON t.a > o.k AND t.a <= o.k + 1;
+
+SELECT a, count(*) FROM btree_lastleaf
+  WHERE a IN (0, 1, 2, 50, 51, 400, 401, 5000, 6666, 7000) GROUP BY a ORDER BY a;
+SELECT a FROM btree_lastleaf
+  WHERE a IN (0, 1, 2, 50, 51, 400, 401, 5000, 6666, 7000) ORDER BY a DESC LIMIT 8;
+RESET enable_hashjoin;
+RESET enable_mergejoin;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+RESET enable_material;
+DROP TABLE btree_lastleaf, btree_lastleaf_outer;
+
+--
+-- Test in-page binary search over composite keys sharing long prefixes,
+-- including truncated pivot tuples, NULLs and DESC columns
+--
+CREATE TABLE btree_prefix (a text, b int, c text);
+INSERT INTO btree_prefix
+  SELECT repeat('p', 200) || (i / 1000), (i / 10) % 50,
+         CASE WHEN i % 97 = 0 THEN NULL ELSE 'c' || (i % 10) END
+  FROM generate_series(1, 6000) i;
+CREATE INDEX btree_prefix_idx ON btree_prefix (a, b DESC, c NULLS FIRST);
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SELECT count(*) FROM btree_prefix
+  WHERE a = repeat('p', 200) || '3' AND b = 17;
+SELECT count(*) FROM btree_prefix
+  WHERE a = repeat('p', 200) || '3' AND b = 17 AND c = 'c4';
+SELECT count(*) FROM btree_prefix
+  WHERE a = repeat('p', 200) || '3' AND b = 17 AND c IS NULL;
+SELECT count(*) FROM btree_prefix
+  WHERE a = repeat('p', 200) || '5' AND b BETWEEN 10 AND 12 AND c > 'c7';
+SELECT b, c FROM btree_prefix
+  WHERE a = repeat('p', 200) || '2' AND b < 2 ORDER BY b DESC, c NULLS FIRST LIMIT 5;
+-- Insertions must find the same positions
+INSERT INTO btree_prefix
+  SELECT repeat('p', 200) || '3', 17, 'c4' FROM generate_series(1, 500);
+SELECT count(*) FROM btree_prefix
+  WHERE a = repeat('p', 200) || '3' AND b = 17 AND c = 'c4';
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+DROP TABLE btree_prefix;
@@ -181,3 +181,79 @@ values
   ('{}',    null),
   ('{1}',   '{2,3}');
 drop table t_gin_test_tbl;
+
+-- test parallel index builds, comparing against a serial build
+create table t_gin_parallel(i int4[], t text[]) with (parallel_workers = 2);
+insert into t_gin_parallel
+  select array[g % 100, g % 7, g], array[(g % 13)::text, md5((g % 500)::text)]
+  from generate_series(1, 20000) g;
+insert into t_gin_parallel values (null, null), ('{}', '{}'), ('{null}', '{null}');
+
+-- each participant needs 32MB of maintenance_work_mem; the DEBUG messages
+-- show that two workers were requested, and complain if none launched
+set max_parallel_maintenance_workers = 2;
+set maintenance_work_mem = '128MB';
+set client_min_messages = debug1;
+create index t_gin_parallel_idx on t_gin_parallel using gin (i, t);
+reset client_min_messages;
+reset maintenance_work_mem;
+reset max_parallel_maintenance_workers;
+
+set enable_seqscan = off;
+set enable_bitmapscan = on;
+select count(*) from t_gin_parallel where i @> array[5];
+select count(*) from t_gin_parallel where i @> array[5, 3];
+select count(*) from t_gin_parallel where t @> array['7'];
+select count(*) from t_gin_parallel where i && array[1, 19999] and t @> array['1'];
+select count(*) from t_gin_parallel where i @> '{}';
+select count(*) from t_gin_parallel where t @> '{}';
+
+-- rebuild serially; the results must not change
+set max_parallel_maintenance_workers = 0;
+reindex index t_gin_parallel_idx;
+reset max_parallel_maintenance_workers;
+select count(*) from t_gin_parallel where i @> array[5];
+select count(*) from t_gin_parallel where i @> array[5, 3];
+select count(*) from t_gin_parallel where t @> array['7'];
+select count(*) from t_gin_parallel where i && array[1, 19999] and t @> array['1'];
+select count(*) from t_gin_parallel where i @> '{}';
+select count(*) from t_gin_parallel where t @> '{}';
+reset enable_seqscan;
+reset enable_bitmapscan;
+
+drop table t_gin_parallel;
+
+-- pending list size and cleanup statistics
+create table t_gin_pending(a int4[]) with (autovacuum_enabled = off);
+create index t_gin_pending_idx on t_gin_pending using gin (a)
+  with (fastupdate = on, gin_pending_list_limit = 64);
+insert into t_gin_pending select array[g, g % 10] from generate_series(1, 100) g;
+select pending_pages > 0 as has_pending, pending_tuples
+  from pg_stat_gin_pending_list where indexrelid = 't_gin_pending_idx'::regclass;
+select gin_clean_pending_list('t_gin_pending_idx') > 0 as cleaned;
+select pg_stat_force_next_flush();
+select pending_pages, pending_tuples, merges > 0 as merged,
+       merged_pages > 0 as merged_pages, inline_merges
+  from pg_stat_gin_pending_list where indexrelid = 't_gin_pending_idx'::regclass;
+-- past gin_pending_list_limit, inserts ask autovacuum to clean the list
+-- rather than doing it themselves, unless autovacuum is off
+insert into t_gin_pending
+  select array[g, g % 10, g % 100] from generate_series(1, 2000) g;
+select pg_stat_force_next_flush();
+select inline_merges = 0 or not current_setting('autovacuum')::bool as requested
+  from pg_stat_gin_pending_list where indexrelid = 't_gin_pending_idx'::regclass;
+-- at four times the limit, the inserting backend cleans the list itself
+insert into t_gin_pending
+  select array[g, g % 10, g % 100] from generate_series(1, 10000) g;
+select pg_stat_force_next_flush();
+select inline_merges > 0 as inline_merged, total_merge_time > 0 as timed
+  from pg_stat_gin_pending_list where indexrelid = 't_gin_pending_idx'::regclass;
+set enable_seqscan = off;
+set enable_bitmapscan = on;
+select count(*) from t_gin_pending where a @> array[7, 7];
+reset enable_seqscan;
+reset enable_bitmapscan;
+-- not a GIN index
+create index t_gin_pending_btree on t_gin_pending ((a[1]));
+select * from gin_pending_list_size('t_gin_pending_btree');
+drop table t_gin_pending;
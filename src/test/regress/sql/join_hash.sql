@@ -623,3 +623,109 @@ lateral (select t1.fivethous, i4.f1 from tenk1 t1 join int4_tbl i4
          on t1.fivethous = i4.f1+i8.q2 order by 1,2) ss;
 
 rollback;
+
+-- Bloom filters pushed down from the inner side's hash table to the scans
+-- producing the outer side's join keys
+begin;
+set local enable_mergejoin = off;
+set local enable_nestloop = off;
+
+create temp table bf_dim (id int, dim int);
+insert into bf_dim select g, g % 3 from generate_series(1, 20) g;
+analyze bf_dim;
+create temp table bf_fact (id int, dim int) partition by range (id);
+create temp table bf_fact_1 partition of bf_fact for values from (0) to (5000);
+create temp table bf_fact_2 partition of bf_fact for values from (5000) to (10000);
+insert into bf_fact select g, g % 100 from generate_series(0, 9999) g;
+analyze bf_fact;
+
+explain (analyze, costs off, summary off, timing off)
+select count(*) from tenk1 t join bf_dim d on t.unique1 = d.id;
+select count(*) from tenk1 t join bf_dim d on t.unique1 = d.id;
+select count(*) from bf_fact f join bf_dim d on f.dim = d.id;
+select count(*) from bf_fact f where f.dim in (select id from bf_dim);
+
+-- multiple join keys, and a join type that must not filter the outer side
+select count(*) from bf_fact f join bf_dim d on f.dim = d.id and f.id % 3 = d.dim;
+select count(*) from bf_fact f left join bf_dim d on f.dim = d.id;
+
+-- rescans with a parameterized inner side must not use the filter of the
+-- previous inner side, not even to prefetch an outer tuple
+create temp table bf_rescan (id int, grp int);
+insert into bf_rescan values (1000, 1);
+insert into bf_rescan select g, 2 from generate_series(1, 10) g;
+analyze bf_rescan;
+explain (costs off)
+select x, (select count(*) from bf_fact f join bf_rescan r on f.dim = r.id
+           where r.grp = x)
+  from (values (1), (1), (2)) v(x);
+select x, (select count(*) from bf_fact f join bf_rescan r on f.dim = r.id
+           where r.grp = x)
+  from (values (1), (1), (2)) v(x);
+
+-- the filters must also work in parallel workers
+set local parallel_setup_cost = 0;
+set local parallel_tuple_cost = 0;
+set local min_parallel_table_scan_size = 0;
+set local max_parallel_workers_per_gather = 2;
+set local enable_parallel_hash = off;
+select count(*) from tenk1 t join bf_dim d on t.unique1 = d.id;
+select count(*) from bf_fact f join bf_dim d on f.dim = d.id;
+
+-- and give the same results as without them
+set local enable_bloom_filter_pushdown = off;
+select count(*) from tenk1 t join bf_dim d on t.unique1 = d.id;
+select count(*) from bf_fact f join bf_dim d on f.dim = d.id;
+rollback;
+
+-- Radix-partitioned bucket index, forced on for small tables by a zero
+-- threshold; results must match the plain bucket chains
+begin;
+set local enable_mergejoin = off;
+set local enable_nestloop = off;
+set local max_parallel_workers_per_gather = 0;
+
+create temp table radix_inner (id int, val int);
+insert into radix_inner select g % 5000, g from generate_series(1, 20000) g;
+analyze radix_inner;
+
+-- Extract the bucket layout reported for the Hash node, if any
+create function hash_join_bucket_layout(query text)
+returns text language plpgsql
+as
+$$
+declare
+  whole_plan jsonb;
+begin
+  execute 'explain (analyze, format ''json'') ' || query into whole_plan;
+  return jsonb_path_query_first(whole_plan,
+    'strict $.**?(@."Node Type" == "Hash")."Bucket Layout"') #>> '{}';
+end;
+$$;
+
+set local hashjoin_radix_threshold = 0;
+select hash_join_bucket_layout($$
+  select count(*) from tenk1 t join radix_inner r on t.unique1 = r.id;
+$$);
+select count(*), sum(r.val) from tenk1 t join radix_inner r on t.unique1 = r.id;
+select count(*), sum(r.val) from tenk1 t join radix_inner r
+  on t.unique1 = r.id and t.unique2 < r.val;
+select count(*) from tenk1 t right join radix_inner r on t.unique1 = r.id + 8000;
+select count(*) from tenk1 t full join radix_inner r on t.unique1 = r.id + 8000;
+-- multiple batches, each of which gets its own index
+set local work_mem = '128kB';
+set local hash_mem_multiplier = 1.0;
+select count(*), sum(r.val) from tenk1 t join radix_inner r on t.unique1 = r.id;
+
+set local hashjoin_radix_threshold = -1;
+reset work_mem;
+reset hash_mem_multiplier;
+select hash_join_bucket_layout($$
+  select count(*) from tenk1 t join radix_inner r on t.unique1 = r.id;
+$$) is null as chains_only;
+select count(*), sum(r.val) from tenk1 t join radix_inner r on t.unique1 = r.id;
+select count(*), sum(r.val) from tenk1 t join radix_inner r
+  on t.unique1 = r.id and t.unique2 < r.val;
+select count(*) from tenk1 t right join radix_inner r on t.unique1 = r.id + 8000;
+select count(*) from tenk1 t full join radix_inner r on t.unique1 = r.id + 8000;
+rollback;
@@ -188,6 +188,28 @@ DROP TABLE lock_tbl1a;
 DROP SCHEMA lock_schema1 CASCADE;
 DROP ROLE regress_rol_lock1;
 
+--
+-- Fast-path lock slots.  Locking more relations than there are slots (as
+-- set by max_fast_path_locks) must fall back to the main lock table.
+--
+CREATE TABLE lock_fp_parent (a int) PARTITION BY LIST (a);
+SELECT format('CREATE TABLE lock_fp_%s PARTITION OF lock_fp_parent FOR VALUES IN (%s)', g, g)
+  FROM generate_series(1, current_setting('max_fast_path_locks')::int + 24) g \gexec
+SELECT slot_misses AS slot_misses_before
+  FROM pg_stat_fastpath_locks WHERE pid = pg_backend_pid() \gset
+BEGIN;
+SELECT count(*) FROM lock_fp_parent;
+SELECT count(*) FILTER (WHERE fastpath) <= current_setting('max_fast_path_locks')::int AS fastpath_bounded,
+       count(*) FILTER (WHERE NOT fastpath) > 0 AS some_in_main_table
+  FROM pg_locks
+  WHERE pid = pg_backend_pid() AND locktype = 'relation' AND
+        relation::regclass::text LIKE 'lock_fp_%';
+COMMIT;
+SELECT slot_misses > :slot_misses_before AS slot_misses_counted,
+       conflict_misses >= 0 AS conflict_misses_reported
+  FROM pg_stat_fastpath_locks WHERE pid = pg_backend_pid();
+DROP TABLE lock_fp_parent;
+
 
 -- atomic ops tests
 RESET search_path;
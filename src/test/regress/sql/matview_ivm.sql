@@ -0,0 +1,109 @@
+--
+-- Incremental maintenance of materialized views
+--
+
+CREATE TABLE ivm_t (id int NOT NULL PRIMARY KEY, grp text, amt int);
+CREATE TABLE ivm_u (grp text NOT NULL, label text);
+INSERT INTO ivm_t VALUES (1, 'a', 10), (2, 'a', 20), (3, 'b', 5), (4, NULL, 7);
+INSERT INTO ivm_u VALUES ('a', 'alpha'), ('b', 'beta');
+
+-- a join view without aggregation
+CREATE MATERIALIZED VIEW ivm_spj WITH (incremental_maintenance = immediate) AS
+  SELECT t.id, t.amt, u.label FROM ivm_t t JOIN ivm_u u ON t.grp = u.grp;
+-- a grouped view whose aggregates can be combined
+CREATE MATERIALIZED VIEW ivm_agg WITH (incremental_maintenance = immediate) AS
+  SELECT grp, count(*) AS n, sum(amt) AS total, max(amt) AS top
+  FROM ivm_t GROUP BY grp;
+-- a grouped view that has to recompute its groups
+CREATE MATERIALIZED VIEW ivm_avg WITH (incremental_maintenance = immediate) AS
+  SELECT grp, avg(amt) AS mean FROM ivm_t GROUP BY grp HAVING count(*) > 0;
+
+-- the maintenance triggers are internal
+SELECT count(*) FROM pg_trigger WHERE tgrelid = 'ivm_t'::regclass AND tgisinternal;
+
+INSERT INTO ivm_t VALUES (5, 'b', 1), (6, 'c', 2), (7, NULL, 3);
+UPDATE ivm_t SET amt = amt * 2 WHERE grp = 'a';
+DELETE FROM ivm_t WHERE id = 3;
+UPDATE ivm_u SET label = 'ALPHA' WHERE grp = 'a';
+INSERT INTO ivm_u VALUES ('c', 'gamma'), ('c', 'gamma');
+
+SELECT * FROM ivm_spj ORDER BY id, label;
+SELECT * FROM ivm_agg ORDER BY grp;
+SELECT * FROM ivm_avg ORDER BY grp;
+
+-- compare with the views' queries
+(SELECT t.id, t.amt, u.label FROM ivm_t t JOIN ivm_u u ON t.grp = u.grp
+ EXCEPT ALL SELECT * FROM ivm_spj)
+UNION ALL
+(SELECT * FROM ivm_spj
+ EXCEPT ALL SELECT t.id, t.amt, u.label FROM ivm_t t JOIN ivm_u u ON t.grp = u.grp);
+
+-- duplicate rows are removed one at a time
+DELETE FROM ivm_u WHERE ctid = (SELECT min(ctid) FROM ivm_u WHERE grp = 'c');
+SELECT * FROM ivm_spj WHERE label = 'gamma';
+
+-- a statement changing two base tables at once recomputes the view
+WITH d AS (DELETE FROM ivm_u WHERE grp = 'b' RETURNING grp)
+INSERT INTO ivm_t SELECT 8, grp, 100 FROM d;
+SELECT * FROM ivm_spj ORDER BY id, label;
+
+TRUNCATE ivm_t;
+SELECT count(*) FROM ivm_spj;
+SELECT count(*) FROM ivm_agg;
+INSERT INTO ivm_t VALUES (1, 'a', 1);
+SELECT * FROM ivm_agg;
+
+-- deferred maintenance happens at commit
+ALTER MATERIALIZED VIEW ivm_agg SET (incremental_maintenance = deferred);
+BEGIN;
+INSERT INTO ivm_t VALUES (2, 'a', 2);
+SELECT * FROM ivm_agg;
+SAVEPOINT s;
+INSERT INTO ivm_t VALUES (3, 'a', 4);
+ROLLBACK TO s;
+INSERT INTO ivm_t VALUES (4, 'b', 8);
+COMMIT;
+SELECT * FROM ivm_agg ORDER BY grp;
+
+-- REFRESH discards earlier pending work
+BEGIN;
+DELETE FROM ivm_t WHERE id = 4;
+REFRESH MATERIALIZED VIEW ivm_agg;
+INSERT INTO ivm_t VALUES (5, 'b', 16);
+COMMIT;
+SELECT * FROM ivm_agg ORDER BY grp;
+
+-- switching maintenance off drops the triggers
+ALTER MATERIALIZED VIEW ivm_avg RESET (incremental_maintenance);
+SELECT count(*) FROM pg_depend
+  WHERE refobjid = 'ivm_avg'::regclass AND classid = 'pg_trigger'::regclass;
+INSERT INTO ivm_t VALUES (6, 'c', 32);
+SELECT * FROM ivm_avg ORDER BY grp;
+-- and switching it back on brings the view up to date
+ALTER MATERIALIZED VIEW ivm_avg SET (incremental_maintenance = immediate);
+SELECT * FROM ivm_avg ORDER BY grp;
+
+SELECT pg_stat_force_next_flush();
+SELECT matviewname, maintenance_mode, maintenance_count > 0 AS maintained,
+       full_recompute_count > 0 AS recomputed
+  FROM pg_stat_matview_maintenance
+  WHERE matviewname LIKE 'ivm\_%' ORDER BY matviewname;
+
+-- unsupported queries and options
+CREATE MATERIALIZED VIEW ivm_bad WITH (incremental_maintenance = immediate) AS
+  SELECT DISTINCT grp FROM ivm_t;
+CREATE MATERIALIZED VIEW ivm_bad WITH (incremental_maintenance = immediate) AS
+  SELECT t.id FROM ivm_t t LEFT JOIN ivm_u u ON t.grp = u.grp;
+CREATE MATERIALIZED VIEW ivm_bad WITH (incremental_maintenance = immediate) AS
+  SELECT a.id FROM ivm_t a, ivm_t b;
+CREATE MATERIALIZED VIEW ivm_bad WITH (incremental_maintenance = immediate) AS
+  SELECT id, random() FROM ivm_t;
+CREATE MATERIALIZED VIEW ivm_bad WITH (incremental_maintenance = immediate) AS
+  SELECT upper(grp), count(*) FROM ivm_t GROUP BY upper(grp);
+CREATE MATERIALIZED VIEW ivm_bad WITH (incremental_maintenance = sometimes) AS
+  SELECT id FROM ivm_t;
+ALTER TABLE ivm_t SET (incremental_maintenance = immediate);
+
+DROP MATERIALIZED VIEW ivm_spj, ivm_agg, ivm_avg;
+SELECT count(*) FROM pg_trigger WHERE tgrelid = 'ivm_t'::regclass;
+DROP TABLE ivm_t, ivm_u;
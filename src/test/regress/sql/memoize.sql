@@ -177,6 +177,23 @@ SELECT COUNT(*),AVG(t2.unique1) FROM tenk1 t1,
 LATERAL (SELECT t2.unique1 FROM tenk1 t2 WHERE t1.twenty = t2.unique1) t2
 WHERE t1.unique1 < 1000;
 
+-- The workers share the cache.  Ensure the totals are reported.
+SELECT explain_memoize('
+SELECT COUNT(*),AVG(t2.unique1) FROM tenk1 t1,
+LATERAL (SELECT t2.unique1 FROM tenk1 t2 WHERE t1.twenty = t2.unique1) t2
+WHERE t1.unique1 < 1000;', true) AS e
+WHERE e LIKE '%Shared Cache:%';
+
+-- Force evictions from the shared cache and check the results are still
+-- correct.
+SET work_mem TO '64kB';
+SET hash_mem_multiplier TO 1.0;
+SELECT COUNT(*),AVG(t2.unique1) FROM tenk1 t1,
+LATERAL (SELECT t2.unique1 FROM tenk1 t2 WHERE t1.thousand = t2.unique1) t2
+WHERE t1.unique1 < 5000;
+RESET hash_mem_multiplier;
+RESET work_mem;
+
 RESET max_parallel_workers_per_gather;
 RESET parallel_tuple_cost;
 RESET parallel_setup_cost;
@@ -605,3 +605,29 @@ drop table toasted_data;
 fetch all in held_portal;
 
 reset default_toast_compression;
+
+--
+-- Check that changing direction works for sequential scans that read ahead
+-- with streaming reads.
+--
+begin;
+
+create temp table stream_scan (a int, b text) with (fillfactor = 10);
+insert into stream_scan
+  select i, repeat('x', 100) from generate_series(1, 200) i;
+
+set local io_combine_limit = 4;
+
+declare stream_cur scroll cursor for select a from stream_scan;
+fetch forward 50 in stream_cur;
+fetch backward 25 in stream_cur;
+fetch forward 10 in stream_cur;
+move last in stream_cur;
+fetch backward 3 in stream_cur;
+fetch first in stream_cur;
+close stream_cur;
+
+set local io_combine_limit = 1;
+select count(*), sum(a) from stream_scan;
+
+commit;
@@ -260,6 +260,7 @@ reset enable_nestloop;
 
 -- test gather merge
 set enable_hashagg = false;
+set enable_parallel_sort = false;
 
 explain (costs off)
    select count(*) from tenk1 group by twenty;
@@ -342,6 +343,48 @@ select string4 from tenk1 order by string4 limit 5;
 
 reset parallel_leader_participation;
 reset max_parallel_workers;
+reset enable_parallel_sort;
+
+-- test parallel sort, with runs sorted by the workers and merged by the
+-- leader
+set enable_gathermerge = false;
+
+explain (costs off)
+   select ten, unique1 from tenk1 order by ten, unique1;
+select count(*), bool_and(ok) from
+  (select ten, unique1,
+          (ten, unique1) >= lag((ten, unique1)) over () as ok
+   from (select ten, unique1 from tenk1 order by ten, unique1) s) ss;
+
+-- a single sort column makes it a Datum sort
+explain (costs off)
+   select unique1 from tenk1 order by unique1 desc;
+select unique1 from tenk1 order by unique1 desc offset 9995;
+
+-- the leader must merge the workers' runs even when not participating
+set parallel_leader_participation = off;
+select string4, count(*) from
+  (select string4 from tenk1 order by string4 offset 0) ss
+  group by string4;
+reset parallel_leader_participation;
+
+-- and merge its own run alone when no workers can be launched
+set max_parallel_workers = 0;
+select unique1 from tenk1 order by unique1 desc limit 5;
+reset max_parallel_workers;
+
+-- rescans must delete the previous runs and sort again
+set enable_material = false;
+explain (costs off)
+select * from
+  (select two, unique1 from tenk1 order by two, unique1 offset 9998) ss
+  right join (values (1),(2),(3)) v(x) on true;
+select * from
+  (select two, unique1 from tenk1 order by two, unique1 offset 9998) ss
+  right join (values (1),(2),(3)) v(x) on true;
+reset enable_material;
+
+reset enable_gathermerge;
 
 SAVEPOINT settings;
 SET LOCAL debug_parallel_query = 1;
@@ -435,6 +435,29 @@ CHECKPOINT;
 SELECT checkpoints_req > :rqst_ckpts_before FROM pg_stat_bgwriter;
 SELECT wal_bytes > :wal_bytes_before FROM pg_stat_wal;
 
+-- With wal_group_commit, commits are flushed through the group path (only
+-- used with fsync on), and each group flush serves at least its leader.
+SELECT wal_group_flushes AS group_flushes_before,
+       wal_group_flush_members AS group_members_before FROM pg_stat_wal \gset
+SET wal_group_commit = on;
+CREATE TABLE test_stats_group_commit (a int);
+DO $$
+BEGIN
+  FOR i IN 1..5 LOOP
+    INSERT INTO test_stats_group_commit VALUES (i);
+    COMMIT;
+  END LOOP;
+END
+$$;
+RESET wal_group_commit;
+DROP TABLE test_stats_group_commit;
+SELECT pg_stat_force_next_flush();
+SELECT NOT current_setting('fsync')::bool OR
+       (wal_group_flushes > :group_flushes_before AND
+        wal_group_flush_members - :group_members_before >=
+        wal_group_flushes - :group_flushes_before)
+  FROM pg_stat_wal;
+
 -- Test pg_stat_get_backend_idset() and some allied functions.
 -- In particular, verify that their notion of backend ID matches
 -- our temp schema index.
@@ -621,6 +644,12 @@ SELECT sum(writes) AS writes, sum(fsyncs) AS fsyncs
 SELECT :io_sum_shared_after_writes > :io_sum_shared_before_writes;
 SELECT current_setting('fsync') = 'off'
   OR :io_sum_shared_after_fsyncs > :io_sum_shared_before_fsyncs;
+-- Adjacent blocks may be combined into one write request, but every request
+-- writes at least one block.
+SELECT count(*) = 0 AS write_requests_ok
+  FROM pg_stat_io WHERE write_requests > writes;
+SELECT checkpoint_write_requests <= buffers_checkpoint
+  FROM pg_stat_bgwriter;
 
 -- Change the tablespace so that the table is rewritten directly, then SELECT
 -- from it to cause it to be read back into shared buffers.
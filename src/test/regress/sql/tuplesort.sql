@@ -296,3 +296,48 @@ EXPLAIN (COSTS OFF) :qry;
 :qry;
 
 COMMIT;
+
+----
+-- Check that radix sorting large in-memory sorts gives the same results as
+-- quicksort
+----
+
+CREATE TEMP TABLE radix_sort_test AS
+    SELECT g AS id,
+        CASE WHEN g % 97 = 0 THEN NULL ELSE hashint4(g) % 1000 END AS i4,
+        CASE WHEN g % 89 = 0 THEN NULL ELSE hashint8(g) END AS i8,
+        '2000-01-01'::timestamptz + hashint4(g) * interval '1 second' AS ts,
+        md5(g::text) COLLATE "C" AS t,
+        md5((g % 5000)::text)::uuid AS u
+    FROM generate_series(1, 20000) g;
+
+SET enable_radix_sort = off;
+CREATE TEMP TABLE radix_sort_expected AS SELECT
+    (SELECT md5(array_agg(id ORDER BY i4, id)::text) FROM radix_sort_test) AS i4_asc,
+    (SELECT md5(array_agg(id ORDER BY i4 DESC, id)::text) FROM radix_sort_test) AS i4_desc,
+    (SELECT md5(array_agg(id ORDER BY i8 NULLS FIRST, id)::text) FROM radix_sort_test) AS i8_asc,
+    (SELECT md5(array_agg(id ORDER BY i8 DESC NULLS LAST, id)::text) FROM radix_sort_test) AS i8_desc,
+    (SELECT md5(array_agg(id ORDER BY ts, id)::text) FROM radix_sort_test) AS ts_asc,
+    (SELECT md5(array_agg(id ORDER BY t DESC)::text) FROM radix_sort_test) AS t_desc,
+    (SELECT md5(array_agg(id ORDER BY u, id DESC)::text) FROM radix_sort_test) AS u_asc;
+SET enable_radix_sort = on;
+SELECT
+    (SELECT md5(array_agg(id ORDER BY i4, id)::text) FROM radix_sort_test) = i4_asc AS i4_asc,
+    (SELECT md5(array_agg(id ORDER BY i4 DESC, id)::text) FROM radix_sort_test) = i4_desc AS i4_desc,
+    (SELECT md5(array_agg(id ORDER BY i8 NULLS FIRST, id)::text) FROM radix_sort_test) = i8_asc AS i8_asc,
+    (SELECT md5(array_agg(id ORDER BY i8 DESC NULLS LAST, id)::text) FROM radix_sort_test) = i8_desc AS i8_desc,
+    (SELECT md5(array_agg(id ORDER BY ts, id)::text) FROM radix_sort_test) = ts_asc AS ts_asc,
+    (SELECT md5(array_agg(id ORDER BY t DESC)::text) FROM radix_sort_test) = t_desc AS t_desc,
+    (SELECT md5(array_agg(id ORDER BY u, id DESC)::text) FROM radix_sort_test) = u_asc AS u_asc
+FROM radix_sort_expected;
+
+-- single-key sorts, where ties need no further comparisons
+SELECT count(*) FILTER (WHERE prev > i4) AS out_of_order, count(i4)
+FROM (SELECT i4, lag(i4) OVER () AS prev
+      FROM (SELECT i4 FROM radix_sort_test ORDER BY i4 OFFSET 0) s) s;
+SELECT count(*) FILTER (WHERE prev < i8) AS out_of_order, count(i8)
+FROM (SELECT i8, lag(i8) OVER () AS prev
+      FROM (SELECT i8 FROM radix_sort_test ORDER BY i8 DESC OFFSET 0) s) s;
+
+DROP TABLE radix_sort_test, radix_sort_expected;
+RESET enable_radix_sort;